@@ -0,0 +1,357 @@
+package api
+
+import (
+	"context"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"io"
+	"net/http"
+	"runtime"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+
+	"mantisDB/store"
+)
+
+const (
+	// Streamed batches are meant for bulk loads, so they allow far more
+	// operations than /api/v1/kv/batch. They are applied in chunks, so
+	// only an atomic batch is held in memory whole.
+	maxStreamBatchOps   = 100000
+	maxStreamBatchBytes = 256 * 1024 * 1024
+	streamChunkSize     = 4096
+
+	// minShardOps is the fewest operations worth a goroutine of their own.
+	minShardOps = 256
+)
+
+// toKVOp converts a validated batch operation for the key-value store
+func toKVOp(op *BatchOperation) store.KVOp {
+	kvOp := store.KVOp{
+		Type: op.Type,
+		Key:  op.Key,
+		TTL:  time.Duration(op.TTL) * time.Second,
+	}
+	if op.Type == "set" {
+		if str, ok := op.Value.(string); ok {
+			kvOp.Value = []byte(str)
+		} else {
+			kvOp.Value = []byte(fmt.Sprintf("%v", op.Value))
+		}
+	}
+	return kvOp
+}
+
+// shardOf hashes a key (FNV-1a) to one of n shards
+func shardOf(key string, n int) int {
+	h := uint32(2166136261)
+	for i := 0; i < len(key); i++ {
+		h ^= uint32(key[i])
+		h *= 16777619
+	}
+	return int(h % uint32(n))
+}
+
+// processParallel runs operations non-atomically and fills in their
+// results. Operations are split into shards by key hash and the shards run
+// concurrently; within a shard operations keep their order, so each key
+// sees its operations in request order. Results that already carry an
+// error (validation failures) are left alone and their operations skipped.
+func (bp *BatchProcessor) processParallel(ctx context.Context, ops []BatchOperation, results []BatchResult) {
+	shards := runtime.GOMAXPROCS(0)
+	if n := len(ops) / minShardOps; n < shards {
+		shards = n
+	}
+	if shards < 1 {
+		shards = 1
+	}
+
+	members := make([][]int, shards)
+	for i := range ops {
+		if results[i].Error != "" {
+			continue
+		}
+		shard := 0
+		if shards > 1 {
+			shard = shardOf(ops[i].Key, shards)
+		}
+		members[shard] = append(members[shard], i)
+	}
+
+	if shards == 1 {
+		bp.processShard(ctx, ops, results, members[0])
+		return
+	}
+	var wg sync.WaitGroup
+	for _, indices := range members {
+		if len(indices) == 0 {
+			continue
+		}
+		wg.Add(1)
+		go func(indices []int) {
+			defer wg.Done()
+			bp.processShard(ctx, ops, results, indices)
+		}(indices)
+	}
+	wg.Wait()
+}
+
+// processShard runs a shard's operations in order, handing each run of
+// consecutive operations of the same type to the store as one batch call.
+func (bp *BatchProcessor) processShard(ctx context.Context, ops []BatchOperation, results []BatchResult, indices []int) {
+	for start := 0; start < len(indices); {
+		end := start + 1
+		for end < len(indices) && ops[indices[end]].Type == ops[indices[start]].Type {
+			end++
+		}
+		bp.processRun(ctx, ops, results, indices[start:end])
+		start = end
+	}
+}
+
+// processRun applies operations that all have the same type
+func (bp *BatchProcessor) processRun(ctx context.Context, ops []BatchOperation, results []BatchResult, run []int) {
+	kv := bp.store.KV()
+	opType := ops[run[0]].Type
+
+	switch opType {
+	case "get":
+		keys := make([]string, len(run))
+		for j, i := range run {
+			keys[j] = ops[i].Key
+		}
+		values, err := kv.BatchGet(ctx, keys)
+		for j, i := range run {
+			switch {
+			case err != nil:
+				results[i].Error = err.Error()
+			case values[j].Err != nil:
+				results[i].Error = values[j].Err.Error()
+			default:
+				results[i].Value = string(values[j].Value)
+				results[i].Success = true
+			}
+		}
+
+	case "set":
+		kvOps := make([]store.KVOp, len(run))
+		for j, i := range run {
+			kvOps[j] = toKVOp(&ops[i])
+		}
+		err := kv.BatchSet(ctx, kvOps)
+		for _, i := range run {
+			if err != nil {
+				results[i].Error = fmt.Sprintf("failed to set key: %v", err)
+			} else {
+				results[i].Success = true
+			}
+		}
+
+	case "delete":
+		keys := make([]string, len(run))
+		for j, i := range run {
+			keys[j] = ops[i].Key
+		}
+		err := kv.BatchDelete(ctx, keys)
+		for _, i := range run {
+			if err != nil {
+				results[i].Error = fmt.Sprintf("failed to delete key: %v", err)
+			} else {
+				results[i].Success = true
+			}
+		}
+
+	default:
+		for _, i := range run {
+			results[i].Error = fmt.Sprintf("unsupported operation type: %s", opType)
+		}
+	}
+}
+
+// handleKVBatchStream applies a batch sent as newline-delimited JSON, one
+// BatchOperation per line, and streams back one BatchResult line per
+// operation in request order followed by a summary line. Operations are
+// applied in chunks as they are decoded, so a bulk load is never held in
+// memory whole. A malformed line ends the batch; the operations before it
+// stay applied. With ?atomic=true the operations are collected first and
+// applied as one transaction.
+func (s *Server) handleKVBatchStream(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodPost {
+		s.writeStructuredError(w, http.StatusMethodNotAllowed, "Method not allowed", nil, "")
+		return
+	}
+
+	atomic := false
+	if v := r.URL.Query().Get("atomic"); v != "" {
+		var err error
+		if atomic, err = strconv.ParseBool(v); err != nil {
+			s.writeError(w, http.StatusBadRequest, "Invalid atomic parameter")
+			return
+		}
+	}
+
+	r.Body = http.MaxBytesReader(w, r.Body, maxStreamBatchBytes)
+	dec := json.NewDecoder(r.Body)
+	if atomic {
+		s.streamAtomicBatch(w, r, dec)
+		return
+	}
+
+	ctx := r.Context()
+	var (
+		enc      *json.Encoder
+		flusher  http.Flusher
+		ops      = make([]BatchOperation, 0, streamChunkSize)
+		results  = make([]BatchResult, 0, streamChunkSize)
+		total    int
+		failed   int
+		batchErr error
+	)
+
+	// applyChunk applies the pending operations and writes their results.
+	applyChunk := func() bool {
+		s.batchProcessor.processParallel(ctx, ops, results)
+		if enc == nil {
+			w.Header().Set("Content-Type", "application/x-ndjson")
+			w.Header().Set("X-Content-Type-Options", "nosniff")
+			w.WriteHeader(http.StatusOK)
+			flusher, _ = w.(http.Flusher)
+			enc = json.NewEncoder(w)
+		}
+		for _, result := range results {
+			if !result.Success {
+				failed++
+			}
+			if err := enc.Encode(result); err != nil {
+				// The client went away
+				return false
+			}
+		}
+		if flusher != nil {
+			flusher.Flush()
+		}
+		total += len(ops)
+		ops = ops[:0]
+		results = results[:0]
+		return true
+	}
+
+	for {
+		var op BatchOperation
+		if err := dec.Decode(&op); err != nil {
+			if !errors.Is(err, io.EOF) {
+				batchErr = fmt.Errorf("invalid operation %d: %v", total+len(ops), err)
+			}
+			break
+		}
+		if total+len(ops) >= maxStreamBatchOps {
+			batchErr = fmt.Errorf("batch size cannot exceed %d operations", maxStreamBatchOps)
+			break
+		}
+
+		sanitizeBatchOperation(&op)
+		result := BatchResult{Key: op.Key}
+		if opErrors := validateBatchOperation(&op, total+len(ops)); len(opErrors) > 0 {
+			result.Error = strings.Join(opErrors, "; ")
+		}
+		ops = append(ops, op)
+		results = append(results, result)
+
+		if len(ops) == streamChunkSize && !applyChunk() {
+			return
+		}
+	}
+
+	if enc == nil && len(ops) == 0 {
+		message := "operations list cannot be empty"
+		if batchErr != nil {
+			message = batchErr.Error()
+		}
+		s.writeStructuredError(w, http.StatusBadRequest, "Invalid batch", map[string]string{"reason": message}, "")
+		return
+	}
+	if len(ops) > 0 && !applyChunk() {
+		return
+	}
+
+	summary := map[string]interface{}{
+		"success":    batchErr == nil && failed == 0,
+		"operations": total,
+		"failed":     failed,
+	}
+	if batchErr != nil {
+		summary["error"] = batchErr.Error()
+	}
+	enc.Encode(summary)
+}
+
+// streamAtomicBatch collects a whole streamed batch, validates it and
+// applies it as one transaction. Nothing is applied if any line is
+// malformed or invalid.
+func (s *Server) streamAtomicBatch(w http.ResponseWriter, r *http.Request, dec *json.Decoder) {
+	var ops []BatchOperation
+	var validationErrors []string
+	for {
+		var op BatchOperation
+		if err := dec.Decode(&op); err != nil {
+			if errors.Is(err, io.EOF) {
+				break
+			}
+			details := map[string]string{"reason": fmt.Sprintf("invalid operation %d: %v", len(ops), err)}
+			s.writeStructuredError(w, http.StatusBadRequest, "Invalid JSON", details, "")
+			return
+		}
+		if len(ops) >= maxStreamBatchOps {
+			details := map[string]string{"reason": fmt.Sprintf("batch size cannot exceed %d operations", maxStreamBatchOps)}
+			s.writeStructuredError(w, http.StatusBadRequest, "Validation failed", details, "")
+			return
+		}
+		sanitizeBatchOperation(&op)
+		validationErrors = append(validationErrors, validateBatchOperation(&op, len(ops))...)
+		ops = append(ops, op)
+	}
+
+	if len(ops) == 0 {
+		validationErrors = append(validationErrors, "operations list cannot be empty")
+	}
+	if len(validationErrors) > 0 {
+		details := map[string]string{
+			"validation_errors": strings.Join(validationErrors, "; "),
+		}
+		s.writeStructuredError(w, http.StatusBadRequest, "Validation failed", details, "")
+		return
+	}
+
+	response := s.batchProcessor.ProcessBatch(r.Context(), &BatchRequest{Operations: ops, Atomic: true})
+
+	statusCode := http.StatusOK
+	if !response.Success {
+		statusCode = http.StatusConflict
+	}
+	w.Header().Set("Content-Type", "application/x-ndjson")
+	w.Header().Set("X-Content-Type-Options", "nosniff")
+	w.WriteHeader(statusCode)
+
+	enc := json.NewEncoder(w)
+	failed := 0
+	for _, result := range response.Results {
+		if !result.Success {
+			failed++
+		}
+		if err := enc.Encode(result); err != nil {
+			return
+		}
+	}
+	summary := map[string]interface{}{
+		"success":    response.Success,
+		"operations": len(ops),
+		"failed":     failed,
+	}
+	if len(response.Errors) > 0 {
+		summary["error"] = response.Errors[0]
+	}
+	enc.Encode(summary)
+}
@@ -0,0 +1,199 @@
+package api
+
+import (
+	"bufio"
+	"bytes"
+	"context"
+	"encoding/json"
+	"fmt"
+	"net/http"
+	"net/http/httptest"
+	"runtime"
+	"strings"
+	"testing"
+	"time"
+
+	"mantisDB/cache"
+	"mantisDB/storage"
+	"mantisDB/store"
+)
+
+func newKVTestServer(t *testing.T) *Server {
+	t.Helper()
+	engine := storage.NewPureGoStorageEngine(storage.StorageConfig{})
+	cacheManager := cache.NewCacheManager(cache.CacheConfig{
+		MaxSize:         1 << 20,
+		DefaultTTL:      time.Hour,
+		CleanupInterval: time.Minute,
+		EvictionPolicy:  "lru",
+	})
+	return NewServer(store.NewMantisStore(engine, cacheManager), 0)
+}
+
+func TestProcessParallelKeepsPerKeyOrder(t *testing.T) {
+	// Make sure the operations are spread over several shards
+	defer runtime.GOMAXPROCS(runtime.GOMAXPROCS(8))
+	s := newKVTestServer(t)
+
+	// Each key is set, read back, set again and deleted, with the
+	// operations of the keys interleaved in the request.
+	const keys = 512
+	var ops []BatchOperation
+	for round := 0; round < 2; round++ {
+		for k := 0; k < keys; k++ {
+			key := fmt.Sprintf("key-%d", k)
+			ops = append(ops,
+				BatchOperation{Type: "set", Key: key, Value: fmt.Sprintf("%d-%d", k, round)},
+				BatchOperation{Type: "get", Key: key})
+		}
+	}
+	for k := 0; k < keys; k++ {
+		key := fmt.Sprintf("key-%d", k)
+		ops = append(ops, BatchOperation{Type: "delete", Key: key}, BatchOperation{Type: "get", Key: key})
+	}
+	if len(ops)/minShardOps < 2 {
+		t.Fatalf("%d operations fit in one shard", len(ops))
+	}
+
+	results := make([]BatchResult, len(ops))
+	for i := range ops {
+		results[i].Key = ops[i].Key
+	}
+	s.batchProcessor.processParallel(context.Background(), ops, results)
+
+	for i, op := range ops {
+		result := results[i]
+		if op.Type != "get" {
+			if !result.Success {
+				t.Fatalf("op %d (%s %s) failed: %s", i, op.Type, op.Key, result.Error)
+			}
+			continue
+		}
+		switch prev := ops[i-1]; prev.Type {
+		case "set":
+			if !result.Success || result.Value != prev.Value {
+				t.Fatalf("op %d: get %s = %v (%s), want %v", i, op.Key, result.Value, result.Error, prev.Value)
+			}
+		case "delete":
+			if result.Success {
+				t.Fatalf("op %d: get %s after delete returned %v", i, op.Key, result.Value)
+			}
+		}
+	}
+}
+
+// flushCounter counts the flushes of a streamed response.
+type flushCounter struct {
+	*httptest.ResponseRecorder
+	flushes int
+}
+
+func (f *flushCounter) Flush() {
+	f.flushes++
+	f.ResponseRecorder.Flush()
+}
+
+func postBatchStream(s *Server, query string, ops []BatchOperation) (*flushCounter, []json.RawMessage) {
+	var body bytes.Buffer
+	enc := json.NewEncoder(&body)
+	for i := range ops {
+		enc.Encode(&ops[i])
+	}
+	w := &flushCounter{ResponseRecorder: httptest.NewRecorder()}
+	s.handleKVBatchStream(w, httptest.NewRequest(http.MethodPost, "/api/v1/kv/batch/stream"+query, &body))
+
+	var lines []json.RawMessage
+	scanner := bufio.NewScanner(w.Body)
+	for scanner.Scan() {
+		lines = append(lines, json.RawMessage(append([]byte(nil), scanner.Bytes()...)))
+	}
+	return w, lines
+}
+
+type streamSummary struct {
+	Success    bool   `json:"success"`
+	Operations int    `json:"operations"`
+	Failed     int    `json:"failed"`
+	Error      string `json:"error"`
+}
+
+func TestKVBatchStreamAppliesChunks(t *testing.T) {
+	s := newKVTestServer(t)
+
+	// A key set as the last operation of the first chunk and read as the
+	// first of the second
+	n := streamChunkSize + 10
+	ops := make([]BatchOperation, n)
+	for i := range ops {
+		ops[i] = BatchOperation{Type: "set", Key: fmt.Sprintf("key-%d", i), Value: "v"}
+	}
+	ops[streamChunkSize-1] = BatchOperation{Type: "set", Key: "boundary", Value: "first chunk"}
+	ops[streamChunkSize] = BatchOperation{Type: "get", Key: "boundary"}
+
+	w, lines := postBatchStream(s, "", ops)
+	if w.Code != http.StatusOK {
+		t.Fatalf("status %d: %s", w.Code, lines)
+	}
+	if len(lines) != n+1 {
+		t.Fatalf("got %d lines, want %d results and a summary", len(lines), n)
+	}
+	if w.flushes != 2 {
+		t.Errorf("%d flushes, want one per chunk", w.flushes)
+	}
+
+	for i, line := range lines[:n] {
+		var result BatchResult
+		if err := json.Unmarshal(line, &result); err != nil {
+			t.Fatal(err)
+		}
+		if result.Key != ops[i].Key || !result.Success {
+			t.Fatalf("result %d = %+v, want success for %s", i, result, ops[i].Key)
+		}
+		if i == streamChunkSize && result.Value != "first chunk" {
+			t.Errorf("get across the chunk boundary = %v", result.Value)
+		}
+	}
+
+	var summary streamSummary
+	if err := json.Unmarshal(lines[n], &summary); err != nil || !summary.Success || summary.Operations != n {
+		t.Errorf("summary %s: %v", lines[n], err)
+	}
+}
+
+func TestKVBatchStreamLimit(t *testing.T) {
+	if testing.Short() {
+		t.Skip("streams 100k operations")
+	}
+	s := newKVTestServer(t)
+
+	ops := make([]BatchOperation, maxStreamBatchOps+1)
+	for i := range ops {
+		ops[i] = BatchOperation{Type: "set", Key: fmt.Sprintf("key-%d", i), Value: "v"}
+	}
+
+	// The operations up to the limit are applied and reported; the
+	// summary says why the rest were not.
+	_, lines := postBatchStream(s, "", ops)
+	if len(lines) != maxStreamBatchOps+1 {
+		t.Fatalf("got %d lines, want %d results and a summary", len(lines), maxStreamBatchOps)
+	}
+	var summary streamSummary
+	if err := json.Unmarshal(lines[len(lines)-1], &summary); err != nil {
+		t.Fatal(err)
+	}
+	if summary.Success || summary.Operations != maxStreamBatchOps || !strings.Contains(summary.Error, "cannot exceed") {
+		t.Errorf("summary %+v", summary)
+	}
+	if _, err := s.store.KV().Get(context.Background(), fmt.Sprintf("key-%d", maxStreamBatchOps-1)); err != nil {
+		t.Errorf("last operation within the limit not applied: %v", err)
+	}
+	if _, err := s.store.KV().Get(context.Background(), fmt.Sprintf("key-%d", maxStreamBatchOps)); err == nil {
+		t.Error("operation over the limit applied")
+	}
+
+	// An atomic batch over the limit is rejected whole
+	w, _ := postBatchStream(newKVTestServer(t), "?atomic=true", ops)
+	if w.Code != http.StatusBadRequest {
+		t.Errorf("atomic batch over the limit: status %d, want 400", w.Code)
+	}
+}
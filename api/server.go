@@ -4,6 +4,7 @@ package api
 import (
 	"context"
 	"encoding/json"
+	"errors"
 	"fmt"
 	"log"
 	"net"
@@ -14,6 +15,7 @@ import (
 	"time"
 
 	"mantisDB/models"
+	"mantisDB/pkg/sql"
 	"mantisDB/store"
 )
 
@@ -154,20 +156,23 @@ func sanitizeBatchRequest(req *BatchRequest) {
 	}
 
 	for i := range req.Operations {
-		op := &req.Operations[i]
+		sanitizeBatchOperation(&req.Operations[i])
+	}
+}
 
-		// Trim whitespace from key
-		op.Key = strings.TrimSpace(op.Key)
+// sanitizeBatchOperation sanitizes a single batch operation
+func sanitizeBatchOperation(op *BatchOperation) {
+	// Trim whitespace from key
+	op.Key = strings.TrimSpace(op.Key)
 
-		// Normalize operation type to lowercase
-		op.Type = strings.ToLower(strings.TrimSpace(op.Type))
+	// Normalize operation type to lowercase
+	op.Type = strings.ToLower(strings.TrimSpace(op.Type))
 
-		// For set operations, ensure value is properly typed
-		if op.Type == "set" && op.Value != nil {
-			// Convert value to string if it's not already
-			if str, ok := op.Value.(string); ok {
-				op.Value = strings.TrimSpace(str)
-			}
+	// For set operations, ensure value is properly typed
+	if op.Type == "set" && op.Value != nil {
+		// Convert value to string if it's not already
+		if str, ok := op.Value.(string); ok {
+			op.Value = strings.TrimSpace(str)
 		}
 	}
 }
@@ -199,59 +204,49 @@ func (bp *BatchProcessor) ProcessBatch(ctx context.Context, req *BatchRequest) *
 	}
 }
 
-// processAtomicBatch processes operations atomically using transactions
+// processAtomicBatch applies all operations as one storage transaction:
+// either every write lands or none does
 func (bp *BatchProcessor) processAtomicBatch(ctx context.Context, req *BatchRequest, response *BatchResponse) *BatchResponse {
-	// Begin transaction
-	tx, err := bp.store.KV().BeginTransaction(ctx)
-	if err != nil {
-		response.Success = false
-		response.Errors = append(response.Errors, fmt.Sprintf("failed to begin transaction: %v", err))
-		// Mark all operations as failed
-		for i := range response.Results {
-			response.Results[i] = BatchResult{
-				Key:     req.Operations[i].Key,
-				Success: false,
-				Error:   "transaction failed to start",
+	ops := make([]store.KVOp, len(req.Operations))
+	for i := range req.Operations {
+		ops[i] = toKVOp(&req.Operations[i])
+	}
+
+	results, err := bp.store.KV().ApplyAtomic(ctx, ops)
+	if err == nil {
+		for i, op := range req.Operations {
+			response.Results[i] = BatchResult{Key: op.Key, Success: true}
+			if op.Type == "get" {
+				response.Results[i].Value = string(results[i].Value)
 			}
 		}
 		return response
 	}
 
-	// Process all operations within the transaction
-	allSuccessful := true
+	response.Success = false
+	failedOps := 0
 	for i, op := range req.Operations {
-		result := bp.processOperationInTransaction(ctx, tx, &op)
-		response.Results[i] = result
-
-		if !result.Success {
-			allSuccessful = false
+		result := BatchResult{Key: op.Key, Success: false}
+		switch {
+		case results == nil:
+			result.Error = "transaction failed to start"
+		case results[i].Err != nil:
+			result.Error = results[i].Err.Error()
 			response.Errors = append(response.Errors, fmt.Sprintf("operation %d failed: %s", i, result.Error))
+			failedOps++
+		default:
+			result.Error = "transaction rolled back"
 		}
+		response.Results[i] = result
 	}
-
-	// Commit or rollback based on success
-	if allSuccessful {
-		if err := tx.Commit(); err != nil {
-			response.Success = false
-			response.Errors = append(response.Errors, fmt.Sprintf("failed to commit transaction: %v", err))
-			// Mark all operations as failed due to commit failure
+	if failedOps == 0 {
+		// Nothing failed individually, so the transaction itself did
+		response.Errors = append(response.Errors, err.Error())
+		if results != nil {
 			for i := range response.Results {
-				response.Results[i].Success = false
 				response.Results[i].Error = "transaction commit failed"
 			}
 		}
-	} else {
-		response.Success = false
-		if err := tx.Rollback(); err != nil {
-			response.Errors = append(response.Errors, fmt.Sprintf("failed to rollback transaction: %v", err))
-		}
-		// Mark all operations as failed due to rollback
-		for i := range response.Results {
-			response.Results[i].Success = false
-			if response.Results[i].Error == "" {
-				response.Results[i].Error = "transaction rolled back"
-			}
-		}
 	}
 
 	return response
@@ -259,12 +254,13 @@ func (bp *BatchProcessor) processAtomicBatch(ctx context.Context, req *BatchRequ
 
 // processNonAtomicBatch processes operations individually (best effort)
 func (bp *BatchProcessor) processNonAtomicBatch(ctx context.Context, req *BatchRequest, response *BatchResponse) *BatchResponse {
-	successCount := 0
-
 	for i, op := range req.Operations {
-		result := bp.processOperation(ctx, &op)
-		response.Results[i] = result
+		response.Results[i] = BatchResult{Key: op.Key}
+	}
+	bp.processParallel(ctx, req.Operations, response.Results)
 
+	successCount := 0
+	for i, result := range response.Results {
 		if result.Success {
 			successCount++
 		} else {
@@ -278,121 +274,6 @@ func (bp *BatchProcessor) processNonAtomicBatch(ctx context.Context, req *BatchR
 	return response
 }
 
-// processOperationInTransaction processes a single operation within a transaction
-func (bp *BatchProcessor) processOperationInTransaction(ctx context.Context, tx store.TransactionWrapper, op *BatchOperation) BatchResult {
-	result := BatchResult{
-		Key:     op.Key,
-		Success: false,
-	}
-
-	switch op.Type {
-	case "get":
-		value, err := tx.Get(fmt.Sprintf("kv:%s", op.Key))
-		if err != nil {
-			result.Error = fmt.Sprintf("key not found: %s", op.Key)
-			return result
-		}
-
-		// Deserialize to check expiration
-		kv, err := models.KVFromJSON([]byte(value))
-		if err != nil {
-			result.Error = fmt.Sprintf("failed to deserialize value: %v", err)
-			return result
-		}
-
-		if kv.IsExpired() {
-			tx.Delete(fmt.Sprintf("kv:%s", op.Key))
-			result.Error = fmt.Sprintf("key expired: %s", op.Key)
-			return result
-		}
-
-		result.Value = string(kv.Value)
-		result.Success = true
-
-	case "set":
-		// Create key-value model
-		var kv *models.KeyValue
-		valueBytes := []byte(fmt.Sprintf("%v", op.Value))
-
-		if op.TTL > 0 {
-			kv = models.NewKeyValueWithTTL(op.Key, valueBytes, int64(op.TTL))
-		} else {
-			kv = models.NewKeyValue(op.Key, valueBytes)
-		}
-
-		// Serialize and store in transaction
-		data, err := kv.ToJSON()
-		if err != nil {
-			result.Error = fmt.Sprintf("failed to serialize value: %v", err)
-			return result
-		}
-
-		if err := tx.Put(fmt.Sprintf("kv:%s", op.Key), string(data)); err != nil {
-			result.Error = fmt.Sprintf("failed to set key: %v", err)
-			return result
-		}
-
-		result.Success = true
-
-	case "delete":
-		if err := tx.Delete(fmt.Sprintf("kv:%s", op.Key)); err != nil {
-			result.Error = fmt.Sprintf("failed to delete key: %v", err)
-			return result
-		}
-
-		result.Success = true
-
-	default:
-		result.Error = fmt.Sprintf("unsupported operation type: %s", op.Type)
-	}
-
-	return result
-}
-
-// processOperation processes a single operation outside of a transaction
-func (bp *BatchProcessor) processOperation(ctx context.Context, op *BatchOperation) BatchResult {
-	result := BatchResult{
-		Key:     op.Key,
-		Success: false,
-	}
-
-	switch op.Type {
-	case "get":
-		value, err := bp.store.KV().Get(ctx, op.Key)
-		if err != nil {
-			result.Error = fmt.Sprintf("key not found: %s", op.Key)
-			return result
-		}
-
-		result.Value = string(value)
-		result.Success = true
-
-	case "set":
-		valueBytes := []byte(fmt.Sprintf("%v", op.Value))
-		ttl := time.Duration(op.TTL) * time.Second
-
-		if err := bp.store.KV().Set(ctx, op.Key, valueBytes, ttl); err != nil {
-			result.Error = fmt.Sprintf("failed to set key: %v", err)
-			return result
-		}
-
-		result.Success = true
-
-	case "delete":
-		if err := bp.store.KV().Delete(ctx, op.Key); err != nil {
-			result.Error = fmt.Sprintf("failed to delete key: %v", err)
-			return result
-		}
-
-		result.Success = true
-
-	default:
-		result.Error = fmt.Sprintf("unsupported operation type: %s", op.Type)
-	}
-
-	return result
-}
-
 // Server provides HTTP API for MantisDB
 type Server struct {
 	store          *store.MantisStore
@@ -400,6 +281,7 @@ type Server struct {
 	server         *http.Server
 	versionInfo    *VersionInfo
 	batchProcessor *BatchProcessor
+	sqlEngine      *sql.SQLEngine
 }
 
 // NewServer creates a new API server
@@ -420,6 +302,12 @@ func NewServer(store *store.MantisStore, port int) *Server {
 	}
 }
 
+// SetSQLEngine attaches the SQL engine that serves /api/query and prepared
+// statements.
+func (s *Server) SetSQLEngine(engine *sql.SQLEngine) {
+	s.sqlEngine = engine
+}
+
 // Start starts the HTTP server
 func (s *Server) Start(ctx context.Context) error {
 	mux := http.NewServeMux()
@@ -431,6 +319,7 @@ func (s *Server) Start(ctx context.Context) error {
 
 	// Key-Value API endpoints
 	mux.HandleFunc("/api/v1/kv/batch", s.handleKVBatch)
+	mux.HandleFunc("/api/v1/kv/batch/stream", s.handleKVBatchStream)
 	mux.HandleFunc("/api/v1/kv/", s.handleKV)
 
 	// Document API endpoints
@@ -448,6 +337,8 @@ func (s *Server) Start(ctx context.Context) error {
 	mux.HandleFunc("/api/stats", s.handleSystemStats) // Alias for system stats
 	mux.HandleFunc("/api/system/stats", s.handleSystemStats)
 	mux.HandleFunc("/api/query", s.handleSQLQuery)
+	mux.HandleFunc("/api/query/prepare", s.handlePrepare)
+	mux.HandleFunc("/api/query/slow", s.handleSlowPlans)
 	mux.HandleFunc("/api/tables", s.handleAdminTables)
 	mux.HandleFunc("/api/ws/metrics", s.handleMetricsWebSocket)
 
@@ -1208,8 +1099,10 @@ func (s *Server) handleSQLQuery(w http.ResponseWriter, r *http.Request) {
 	}
 
 	var request struct {
-		Query     string `json:"query"`
-		QueryType string `json:"query_type"`
+		Query       string        `json:"query"`
+		QueryType   string        `json:"query_type"`
+		StatementID string        `json:"statement_id"`
+		Params      []interface{} `json:"params"`
 	}
 
 	if err := json.NewDecoder(r.Body).Decode(&request); err != nil {
@@ -1217,15 +1110,208 @@ func (s *Server) handleSQLQuery(w http.ResponseWriter, r *http.Request) {
 		return
 	}
 
-	// For now, return a mock response
-	// In production, integrate with query executor
-	response := map[string]interface{}{
-		"success":     false,
-		"error":       "SQL query execution not yet implemented. Use the Table Editor or API endpoints instead.",
-		"query_id":    fmt.Sprintf("query_%d", time.Now().UnixNano()),
-		"duration_ms": 0,
+	if request.StatementID != "" {
+		s.executePrepared(w, r, request.StatementID, request.Params)
+		return
+	}
+
+	if s.sqlEngine == nil {
+		s.writeError(w, http.StatusServiceUnavailable, "SQL engine not available")
+		return
 	}
+	if request.Query == "" {
+		s.writeError(w, http.StatusBadRequest, "query is required")
+		return
+	}
+	s.streamQuery(w, r, request.Query)
+}
 
+// streamQuery runs a statement and writes its result as NDJSON: a header
+// line with the columns, one JSON array per row, and a trailer with the
+// row count or the error that ended the stream. Rows are flushed a batch
+// at a time, and a client that disconnects cancels the query.
+func (s *Server) streamQuery(w http.ResponseWriter, r *http.Request, query string) {
+	conn, err := s.sqlEngine.CreateConnection("http", "")
+	if err != nil {
+		s.writeError(w, http.StatusServiceUnavailable, err.Error())
+		return
+	}
+	defer s.sqlEngine.CloseConnection(conn.ID)
+
+	stream, err := s.sqlEngine.ExecuteSQLStream(r.Context(), conn.ID, query)
+	if err != nil {
+		s.writeError(w, http.StatusBadRequest, err.Error())
+		return
+	}
+	defer stream.Close()
+
+	columns := stream.Columns()
+	header := make([]map[string]string, len(columns))
+	for i, col := range columns {
+		header[i] = map[string]string{"name": col.Name, "type": col.Type.Name}
+	}
+
+	w.Header().Set("Content-Type", "application/x-ndjson")
+	w.Header().Set("X-Content-Type-Options", "nosniff")
+	w.WriteHeader(http.StatusOK)
+	flusher, _ := w.(http.Flusher)
+	enc := json.NewEncoder(w)
+	if err := enc.Encode(map[string]interface{}{
+		"query_id": fmt.Sprintf("query_%d", time.Now().UnixNano()),
+		"columns":  header,
+	}); err != nil {
+		return
+	}
+
+	var rowCount int64
+	for {
+		batch, err := stream.Next()
+		if err != nil {
+			if r.Context().Err() == nil {
+				enc.Encode(map[string]interface{}{"success": false, "error": err.Error(), "row_count": rowCount})
+			}
+			return
+		}
+		if batch == nil {
+			break
+		}
+		for _, row := range batch.Rows {
+			if err := enc.Encode(row.Values); err != nil {
+				// The client went away; the deferred Close stops the query.
+				return
+			}
+		}
+		rowCount += int64(len(batch.Rows))
+		if flusher != nil {
+			flusher.Flush()
+		}
+	}
+
+	// Closing commits the statement's transaction, which can still fail.
+	if err := stream.Close(); err != nil {
+		enc.Encode(map[string]interface{}{"success": false, "error": err.Error(), "row_count": rowCount})
+		return
+	}
+	enc.Encode(map[string]interface{}{
+		"success":       true,
+		"row_count":     rowCount,
+		"rows_affected": stream.RowsAffected(),
+		"duration_ms":   stream.Elapsed().Milliseconds(),
+	})
+}
+
+// handlePrepare registers a statement with POST and deallocates it with
+// DELETE ?statement_id=.
+func (s *Server) handlePrepare(w http.ResponseWriter, r *http.Request) {
+	if s.sqlEngine == nil {
+		s.writeError(w, http.StatusServiceUnavailable, "SQL engine not available")
+		return
+	}
+
+	switch r.Method {
+	case http.MethodPost:
+		var request struct {
+			SQL   string `json:"sql"`
+			Query string `json:"query"`
+		}
+		if err := json.NewDecoder(r.Body).Decode(&request); err != nil {
+			s.writeError(w, http.StatusBadRequest, "Invalid JSON")
+			return
+		}
+		if request.SQL == "" {
+			request.SQL = request.Query
+		}
+		if request.SQL == "" {
+			s.writeError(w, http.StatusBadRequest, "sql is required")
+			return
+		}
+
+		ps, err := s.sqlEngine.Prepare(request.SQL)
+		if err != nil {
+			s.writeError(w, http.StatusBadRequest, err.Error())
+			return
+		}
+		s.writeJSON(w, map[string]interface{}{
+			"statement_id": ps.ID,
+			"param_count":  ps.ParamCount,
+		})
+	case http.MethodDelete:
+		if err := s.sqlEngine.Deallocate(r.URL.Query().Get("statement_id")); err != nil {
+			s.writeError(w, http.StatusNotFound, err.Error())
+			return
+		}
+		s.writeJSON(w, map[string]interface{}{"success": true})
+	default:
+		s.writeError(w, http.StatusMethodNotAllowed, "Method not allowed")
+	}
+}
+
+// handleSlowPlans lists the profiles of recent slow sampled queries,
+// slowest first. DELETE empties the log.
+func (s *Server) handleSlowPlans(w http.ResponseWriter, r *http.Request) {
+	if s.sqlEngine == nil {
+		s.writeError(w, http.StatusServiceUnavailable, "SQL engine not available")
+		return
+	}
+
+	switch r.Method {
+	case http.MethodGet:
+		s.writeJSON(w, map[string]interface{}{"plans": s.sqlEngine.SlowPlans()})
+	case http.MethodDelete:
+		s.sqlEngine.ResetSlowPlans()
+		s.writeJSON(w, map[string]interface{}{"success": true})
+	default:
+		s.writeError(w, http.StatusMethodNotAllowed, "Method not allowed")
+	}
+}
+
+// executePrepared runs a prepared statement on a connection that lives for
+// the request.
+func (s *Server) executePrepared(w http.ResponseWriter, r *http.Request, id string, params []interface{}) {
+	if s.sqlEngine == nil {
+		s.writeError(w, http.StatusServiceUnavailable, "SQL engine not available")
+		return
+	}
+
+	conn, err := s.sqlEngine.CreateConnection("http", "")
+	if err != nil {
+		s.writeError(w, http.StatusServiceUnavailable, err.Error())
+		return
+	}
+	defer s.sqlEngine.CloseConnection(conn.ID)
+
+	result, err := s.sqlEngine.ExecutePrepared(r.Context(), conn.ID, id, params)
+	if errors.Is(err, sql.ErrPreparedStatementNotFound) {
+		s.writeError(w, http.StatusNotFound, err.Error())
+		return
+	}
+	if err != nil {
+		s.writeError(w, http.StatusBadRequest, err.Error())
+		return
+	}
+
+	response := map[string]interface{}{
+		"rows_affected": result.RowsAffected,
+		"duration_ms":   result.ExecutionTime.Milliseconds(),
+	}
+	if rs := result.ResultSet; rs != nil {
+		columns := make([]string, len(rs.Columns))
+		for i, col := range rs.Columns {
+			columns[i] = col.Name
+		}
+		rows := make([]map[string]interface{}, len(rs.Rows))
+		for i, row := range rs.Rows {
+			rows[i] = make(map[string]interface{}, len(columns))
+			for j, name := range columns {
+				if j < len(row.Values) {
+					rows[i][name] = row.Values[j]
+				}
+			}
+		}
+		response["columns"] = columns
+		response["rows"] = rows
+		response["row_count"] = len(rows)
+	}
 	s.writeJSON(w, response)
 }
 
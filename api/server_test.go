@@ -0,0 +1,227 @@
+package api
+
+import (
+	"bufio"
+	"bytes"
+	"context"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"net/http"
+	"net/http/httptest"
+	"sort"
+	"strings"
+	"testing"
+
+	"mantisDB/pkg/sql"
+	"mantisDB/transaction"
+)
+
+// sqlKV is an in-memory KVStorageEngine whose scans fail after failAfter
+// entries when failAfter is set.
+type sqlKV struct {
+	values    map[string][]byte
+	failAfter int
+}
+
+func (s *sqlKV) Get(ctx context.Context, key []byte) ([]byte, error) {
+	v, ok := s.values[string(key)]
+	if !ok {
+		return nil, fmt.Errorf("key not found")
+	}
+	return v, nil
+}
+
+func (s *sqlKV) Put(ctx context.Context, key, value []byte) error {
+	s.values[string(key)] = value
+	return nil
+}
+
+func (s *sqlKV) Delete(ctx context.Context, key []byte) error {
+	delete(s.values, string(key))
+	return nil
+}
+
+func (s *sqlKV) Scan(ctx context.Context, startKey, endKey []byte) (sql.Iterator, error) {
+	var keys []string
+	for k := range s.values {
+		if bytes.Compare([]byte(k), startKey) >= 0 && bytes.Compare([]byte(k), endKey) < 0 {
+			keys = append(keys, k)
+		}
+	}
+	sort.Strings(keys)
+	return &sqlKVIter{kv: s, keys: keys, pos: -1}, nil
+}
+
+func (s *sqlKV) BatchGet(ctx context.Context, keys [][]byte) ([][]byte, error) {
+	out := make([][]byte, len(keys))
+	for i, k := range keys {
+		out[i] = s.values[string(k)]
+	}
+	return out, nil
+}
+
+func (s *sqlKV) BatchPut(ctx context.Context, kvPairs []sql.KVPair) error {
+	for _, kv := range kvPairs {
+		s.values[string(kv.Key)] = kv.Value
+	}
+	return nil
+}
+
+type sqlKVIter struct {
+	kv   *sqlKV
+	keys []string
+	pos  int
+	err  error
+}
+
+func (it *sqlKVIter) Next() bool {
+	it.pos++
+	if it.kv.failAfter > 0 && it.pos >= it.kv.failAfter {
+		it.err = errors.New("disk read failed")
+		return false
+	}
+	return it.pos < len(it.keys)
+}
+
+func (it *sqlKVIter) Value() ([]byte, []byte, error) {
+	k := it.keys[it.pos]
+	return []byte(k), it.kv.values[k], nil
+}
+
+func (it *sqlKVIter) Error() error { return it.err }
+func (it *sqlKVIter) Close() error { return nil }
+
+func newSQLTestServer(t *testing.T, rows int) (*Server, *sqlKV) {
+	t.Helper()
+	kv := &sqlKV{values: make(map[string][]byte)}
+	for i := 0; i < rows; i++ {
+		kv.values[fmt.Sprintf("kv_events/%05d", i)] = []byte(fmt.Sprintf("e-%d", i))
+	}
+	engine := sql.NewSQLEngine(sql.NewStorageManager(kv, nil, nil), transaction.NewTransactionSystem(nil), nil)
+	t.Cleanup(func() { engine.Shutdown(context.Background()) })
+
+	s := NewServer(nil, 0)
+	s.SetSQLEngine(engine)
+	return s, kv
+}
+
+// queryLines posts query to /api/query and returns the response split into
+// its NDJSON lines.
+func queryLines(t *testing.T, s *Server, query string) (*httptest.ResponseRecorder, []json.RawMessage) {
+	t.Helper()
+	body, _ := json.Marshal(map[string]string{"query": query})
+	rec := httptest.NewRecorder()
+	s.handleSQLQuery(rec, httptest.NewRequest(http.MethodPost, "/api/query", bytes.NewReader(body)))
+
+	var lines []json.RawMessage
+	scanner := bufio.NewScanner(rec.Body)
+	for scanner.Scan() {
+		lines = append(lines, json.RawMessage(append([]byte(nil), scanner.Bytes()...)))
+	}
+	return rec, lines
+}
+
+func TestSQLQueryStreamsNDJSON(t *testing.T) {
+	s, _ := newSQLTestServer(t, 2500)
+
+	rec, lines := queryLines(t, s, "SELECT * FROM kv_events")
+	if rec.Code != http.StatusOK {
+		t.Fatalf("status %d: %s", rec.Code, lines)
+	}
+	if ct := rec.Header().Get("Content-Type"); ct != "application/x-ndjson" {
+		t.Errorf("Content-Type %q", ct)
+	}
+	if len(lines) != 2502 {
+		t.Fatalf("got %d lines, want header, 2500 rows and trailer", len(lines))
+	}
+
+	var header struct {
+		QueryID string              `json:"query_id"`
+		Columns []map[string]string `json:"columns"`
+	}
+	if err := json.Unmarshal(lines[0], &header); err != nil || header.QueryID == "" || len(header.Columns) != 2 || header.Columns[0]["name"] != "id" {
+		t.Fatalf("header %s: %v", lines[0], err)
+	}
+
+	var row []interface{}
+	if err := json.Unmarshal(lines[1], &row); err != nil || len(row) != 2 || row[0] != "kv_events/00000" {
+		t.Fatalf("first row %s: %v", lines[1], err)
+	}
+
+	var trailer struct {
+		Success  bool   `json:"success"`
+		RowCount int64  `json:"row_count"`
+		Error    string `json:"error"`
+	}
+	if err := json.Unmarshal(lines[len(lines)-1], &trailer); err != nil || !trailer.Success || trailer.RowCount != 2500 {
+		t.Fatalf("trailer %s: %v", lines[len(lines)-1], err)
+	}
+}
+
+func TestSQLQueryErrorTrailerAfterPartialStream(t *testing.T) {
+	s, kv := newSQLTestServer(t, 2500)
+	kv.failAfter = 1500
+
+	rec, lines := queryLines(t, s, "SELECT * FROM kv_events")
+	// The header is sent before the first row, so the failure can only be
+	// reported in the trailer.
+	if rec.Code != http.StatusOK {
+		t.Fatalf("status %d: %s", rec.Code, lines)
+	}
+	if len(lines) < 3 {
+		t.Fatalf("got %d lines, want header, rows and trailer", len(lines))
+	}
+
+	var trailer struct {
+		Success  *bool  `json:"success"`
+		RowCount int64  `json:"row_count"`
+		Error    string `json:"error"`
+	}
+	if err := json.Unmarshal(lines[len(lines)-1], &trailer); err != nil || trailer.Success == nil || *trailer.Success {
+		t.Fatalf("trailer %s: %v", lines[len(lines)-1], err)
+	}
+	if !strings.Contains(trailer.Error, "disk read failed") {
+		t.Errorf("trailer error %q", trailer.Error)
+	}
+	// Every row before the failure was streamed, and the count says so.
+	if rows := int64(len(lines) - 2); rows == 0 || rows != trailer.RowCount || rows >= 1500 {
+		t.Errorf("streamed %d rows, trailer counts %d", rows, trailer.RowCount)
+	}
+}
+
+func TestSQLQueryWithoutEngine(t *testing.T) {
+	s := NewServer(nil, 0)
+	rec, _ := queryLines(t, s, "SELECT 1")
+	if rec.Code != http.StatusServiceUnavailable {
+		t.Errorf("status %d, want 503", rec.Code)
+	}
+}
+
+func TestSQLQueryProjectsSelectList(t *testing.T) {
+	s, _ := newSQLTestServer(t, 10)
+
+	rec, lines := queryLines(t, s, "SELECT id FROM kv_events WHERE id < 'kv_events/00003'")
+	if rec.Code != http.StatusOK {
+		t.Fatalf("status %d: %s", rec.Code, lines)
+	}
+	if len(lines) != 5 {
+		t.Fatalf("got %d lines, want header, 3 rows and trailer", len(lines))
+	}
+	var header struct {
+		Columns []map[string]string `json:"columns"`
+	}
+	if err := json.Unmarshal(lines[0], &header); err != nil || len(header.Columns) != 1 || header.Columns[0]["name"] != "id" {
+		t.Fatalf("header %s: %v", lines[0], err)
+	}
+	var row []interface{}
+	if err := json.Unmarshal(lines[1], &row); err != nil || len(row) != 1 || row[0] != "kv_events/00000" {
+		t.Fatalf("first row %s: %v", lines[1], err)
+	}
+
+	// A select list the executor cannot evaluate fails before anything is
+	// streamed
+	if rec, lines := queryLines(t, s, "SELECT nosuch FROM kv_events"); rec.Code != http.StatusBadRequest {
+		t.Errorf("unknown column: status %d: %s", rec.Code, lines)
+	}
+}
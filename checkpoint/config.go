@@ -20,6 +20,9 @@ func DefaultCheckpointConfig() *CheckpointConfig {
 		BufferSize:           64 * 1024, // 64KB
 		ParallelCreation:     false,
 		MaxWorkers:           4,
+		MaxIORate:            64 * 1024 * 1024, // 64MB/s
+		MinIORate:            4 * 1024 * 1024,  // 4MB/s
+		TargetLatency:        10 * time.Millisecond,
 		AutoCleanup:          true,
 		CleanupInterval:      1 * time.Hour,
 		RetentionPeriod:      24 * time.Hour,
@@ -43,6 +46,9 @@ func ProductionCheckpointConfig() *CheckpointConfig {
 		BufferSize:           256 * 1024, // 256KB
 		ParallelCreation:     true,
 		MaxWorkers:           8,
+		MaxIORate:            128 * 1024 * 1024, // 128MB/s
+		MinIORate:            8 * 1024 * 1024,   // 8MB/s
+		TargetLatency:        5 * time.Millisecond,
 		AutoCleanup:          true,
 		CleanupInterval:      30 * time.Minute,
 		RetentionPeriod:      7 * 24 * time.Hour, // 7 days
@@ -66,6 +72,9 @@ func FastCheckpointConfig() *CheckpointConfig {
 		BufferSize:           1024 * 1024, // 1MB
 		ParallelCreation:     true,
 		MaxWorkers:           16,
+		MaxIORate:            0, // Unlimited
+		MinIORate:            0,
+		TargetLatency:        0,
 		AutoCleanup:          true,
 		CleanupInterval:      5 * time.Minute,
 		RetentionPeriod:      1 * time.Hour,
@@ -89,6 +98,9 @@ func SecureCheckpointConfig() *CheckpointConfig {
 		BufferSize:           128 * 1024, // 128KB
 		ParallelCreation:     false,      // Disabled for security
 		MaxWorkers:           4,
+		MaxIORate:            64 * 1024 * 1024, // 64MB/s
+		MinIORate:            4 * 1024 * 1024,  // 4MB/s
+		TargetLatency:        10 * time.Millisecond,
 		AutoCleanup:          true,
 		CleanupInterval:      1 * time.Hour,
 		RetentionPeriod:      30 * 24 * time.Hour, // 30 days
@@ -112,6 +124,9 @@ func TestCheckpointConfig() *CheckpointConfig {
 		BufferSize:           4 * 1024, // 4KB
 		ParallelCreation:     false,
 		MaxWorkers:           2,
+		MaxIORate:            0, // Unlimited
+		MinIORate:            0,
+		TargetLatency:        0,
 		AutoCleanup:          false, // Manual cleanup in tests
 		CleanupInterval:      0,
 		RetentionPeriod:      0,
@@ -150,6 +165,19 @@ func (c *CheckpointConfig) Validate() error {
 		return fmt.Errorf("max workers must be positive when parallel creation is enabled: %d", c.MaxWorkers)
 	}
 
+	if c.MaxIORate < 0 || c.MinIORate < 0 {
+		return fmt.Errorf("I/O rates cannot be negative: max %d, min %d", c.MaxIORate, c.MinIORate)
+	}
+
+	if c.MaxIORate > 0 && c.MinIORate > c.MaxIORate {
+		return fmt.Errorf("min I/O rate (%d) cannot be greater than max I/O rate (%d)",
+			c.MinIORate, c.MaxIORate)
+	}
+
+	if c.TargetLatency < 0 {
+		return fmt.Errorf("target latency cannot be negative: %v", c.TargetLatency)
+	}
+
 	if c.CleanupInterval < 0 {
 		return fmt.Errorf("cleanup interval cannot be negative: %v", c.CleanupInterval)
 	}
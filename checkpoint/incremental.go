@@ -0,0 +1,392 @@
+package checkpoint
+
+import (
+	"bufio"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"hash/crc32"
+	"io"
+	"os"
+	"sort"
+	"sync"
+)
+
+// Incremental checkpoint file layout. All integers are little endian.
+//
+//	magic    [8]byte  "MANTISCP"
+//	version  uint32
+//	baseLSN  uint64   LSN of the checkpoint this one builds on
+//	lsn      uint64
+//	count    uint64   number of key images
+//	images   count × (kind byte, uvarint keyLen, key[, uvarint valueLen, value])
+//	checksum uint32   CRC32 of everything above
+//
+// Each key appears once, with its latest image, so the file grows with the
+// number of distinct keys changed rather than with the number of writes.
+const (
+	incrementalFormatVersion = 1
+	incrementalHeaderSize    = 8 + 4 + 8 + 8 + 8
+
+	imageKindPut    byte = 0
+	imageKindDelete byte = 1
+)
+
+var checkpointMagic = [8]byte{'M', 'A', 'N', 'T', 'I', 'S', 'C', 'P'}
+
+var errIncrementalCorrupt = errors.New("corrupt incremental checkpoint")
+
+// KeyImage is the state of one key as of a checkpoint.
+type KeyImage struct {
+	Key     string
+	Value   []byte
+	Deleted bool
+}
+
+// IncrementalData is the content of an incremental checkpoint.
+type IncrementalData struct {
+	BaseLSN uint64
+	LSN     uint64
+	Images  []KeyImage
+}
+
+// dirtyImage is a tracked key image and the LSN of the write behind it.
+type dirtyImage struct {
+	KeyImage
+	lsn uint64
+}
+
+// dirtySet is the latest image of every key changed since a checkpoint.
+type dirtySet struct {
+	images map[string]dirtyImage
+	since  CheckpointID // empty if the changes since no known checkpoint are tracked
+	// trackedLSN is the LSN every write up to which was tracked when the
+	// set was taken. Later writes up to the checkpoint's LSN are in the WAL
+	// only.
+	trackedLSN uint64
+}
+
+// dirtyTracker records which keys changed since the last checkpoint.
+type dirtyTracker struct {
+	mu         sync.Mutex
+	set        dirtySet
+	trackedLSN uint64 // highest LSN tracked
+}
+
+func newDirtyTracker() *dirtyTracker {
+	return &dirtyTracker{set: dirtySet{images: make(map[string]dirtyImage)}}
+}
+
+func (t *dirtyTracker) record(image KeyImage, lsn uint64) {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	if current, ok := t.set.images[image.Key]; !ok || current.lsn <= lsn {
+		t.set.images[image.Key] = dirtyImage{KeyImage: image, lsn: lsn}
+	}
+	t.trackedLSN = max(t.trackedLSN, lsn)
+}
+
+// take hands over the changes tracked up to lsn to a checkpoint being
+// created at lsn. Later changes stay behind for the next checkpoint; until
+// commit or restore, they cover no known checkpoint.
+func (t *dirtyTracker) take(lsn uint64) dirtySet {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	set := dirtySet{
+		images:     make(map[string]dirtyImage),
+		since:      t.set.since,
+		trackedLSN: min(t.trackedLSN, lsn),
+	}
+	for key, image := range t.set.images {
+		if image.lsn <= lsn {
+			set.images[key] = image
+			delete(t.set.images, key)
+		}
+	}
+	t.set.since = ""
+	return set
+}
+
+// commit marks the changes tracked since take as those made after the
+// checkpoint id.
+func (t *dirtyTracker) commit(id CheckpointID) {
+	t.mu.Lock()
+	t.set.since = id
+	t.mu.Unlock()
+}
+
+// restore puts back a set handed to a checkpoint that failed. Of two
+// images of a key, the one with the higher LSN wins.
+func (t *dirtyTracker) restore(set dirtySet) {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	for key, image := range set.images {
+		if current, ok := t.set.images[key]; !ok || current.lsn < image.lsn {
+			t.set.images[key] = image
+		}
+	}
+	t.set.since = set.since
+}
+
+// TrackWrite records that the write logged at lsn set key to value, for the
+// next incremental checkpoint, which then need not read the WAL. Call it
+// once the write is applied and its transaction has committed, in LSN
+// order as a single apply loop would; value is copied. Tracking is optional: without it, incremental
+// checkpoints are derived from the WAL.
+func (m *Manager) TrackWrite(lsn uint64, key string, value []byte) {
+	m.dirty.record(KeyImage{Key: key, Value: append([]byte(nil), value...)}, lsn)
+}
+
+// TrackDelete records that the write logged at lsn deleted key, like
+// TrackWrite.
+func (m *Manager) TrackDelete(lsn uint64, key string) {
+	m.dirty.record(KeyImage{Key: key, Deleted: true}, lsn)
+}
+
+// sortedImages returns the images ordered by key, so equal states produce
+// equal files.
+func sortedImages(images map[string]KeyImage) []KeyImage {
+	sorted := make([]KeyImage, 0, len(images))
+	for _, image := range images {
+		sorted = append(sorted, image)
+	}
+	sort.Slice(sorted, func(i, j int) bool { return sorted[i].Key < sorted[j].Key })
+	return sorted
+}
+
+// foldWALImages reduces the WAL entries to the latest image of each key
+// changed by startLSN < LSN <= endLSN. A transaction's writes count when
+// its commit falls in that range, even if the writes come before it, and
+// are dropped if it aborts or is still open at endLSN: the images hold
+// committed state only. It also returns the first LSN of the oldest
+// transaction still open at endLSN, or 0 if none is, which is where the
+// next fold has to start reading to see that transaction's writes.
+func foldWALImages(entries []WALEntryData, startLSN, endLSN uint64) ([]KeyImage, uint64) {
+	images := make(map[string]KeyImage)
+	pending := make(map[uint64][]KeyImage)
+	firstLSN := make(map[uint64]uint64)
+
+	for _, entry := range entries {
+		if entry.LSN > endLSN {
+			break
+		}
+		op := entry.Operation
+		switch op.Type {
+		case OpInsertData, OpUpdateData, OpDeleteData:
+			image := KeyImage{Key: op.Key, Value: op.Value, Deleted: op.Type == OpDeleteData}
+			if entry.TxnID == 0 {
+				if entry.LSN > startLSN {
+					images[image.Key] = image
+				}
+			} else {
+				if _, ok := firstLSN[entry.TxnID]; !ok {
+					firstLSN[entry.TxnID] = entry.LSN
+				}
+				pending[entry.TxnID] = append(pending[entry.TxnID], image)
+			}
+		case OpCommitData:
+			if entry.LSN > startLSN {
+				for _, image := range pending[entry.TxnID] {
+					images[image.Key] = image
+				}
+			}
+			delete(pending, entry.TxnID)
+			delete(firstLSN, entry.TxnID)
+		case OpAbortData:
+			delete(pending, entry.TxnID)
+			delete(firstLSN, entry.TxnID)
+		}
+	}
+
+	var oldestOpen uint64
+	for _, lsn := range firstLSN {
+		if oldestOpen == 0 || lsn < oldestOpen {
+			oldestOpen = lsn
+		}
+	}
+	return sortedImages(images), oldestOpen
+}
+
+// writeIncrementalData writes an incremental checkpoint body to w.
+func writeIncrementalData(w io.Writer, data *IncrementalData, bufferSize int) error {
+	hash := crc32.NewIEEE()
+	bw := bufio.NewWriterSize(io.MultiWriter(w, hash), max(bufferSize, 4096))
+
+	header := make([]byte, 0, incrementalHeaderSize)
+	header = append(header, checkpointMagic[:]...)
+	header = binary.LittleEndian.AppendUint32(header, incrementalFormatVersion)
+	header = binary.LittleEndian.AppendUint64(header, data.BaseLSN)
+	header = binary.LittleEndian.AppendUint64(header, data.LSN)
+	header = binary.LittleEndian.AppendUint64(header, uint64(len(data.Images)))
+	if _, err := bw.Write(header); err != nil {
+		return err
+	}
+
+	var record []byte
+	for _, image := range data.Images {
+		record = record[:0]
+		if image.Deleted {
+			record = append(record, imageKindDelete)
+		} else {
+			record = append(record, imageKindPut)
+		}
+		record = binary.AppendUvarint(record, uint64(len(image.Key)))
+		record = append(record, image.Key...)
+		if !image.Deleted {
+			record = binary.AppendUvarint(record, uint64(len(image.Value)))
+			record = append(record, image.Value...)
+		}
+		if _, err := bw.Write(record); err != nil {
+			return err
+		}
+	}
+
+	if err := bw.Flush(); err != nil {
+		return err
+	}
+	return binary.Write(w, binary.LittleEndian, hash.Sum32())
+}
+
+// ReadIncrementalData reads and verifies an incremental checkpoint file.
+func ReadIncrementalData(filePath string) (*IncrementalData, error) {
+	raw, err := os.ReadFile(filePath)
+	if err != nil {
+		return nil, fmt.Errorf("failed to read incremental checkpoint: %w", err)
+	}
+	return decodeIncrementalData(raw)
+}
+
+// decodeIncrementalData parses an incremental checkpoint body. Values
+// alias raw.
+func decodeIncrementalData(raw []byte) (*IncrementalData, error) {
+	if len(raw) < incrementalHeaderSize+4 || [8]byte(raw[:8]) != checkpointMagic {
+		return nil, fmt.Errorf("%w: missing header", errIncrementalCorrupt)
+	}
+	body, trailer := raw[:len(raw)-4], raw[len(raw)-4:]
+	if crc32.ChecksumIEEE(body) != binary.LittleEndian.Uint32(trailer) {
+		return nil, fmt.Errorf("%w: checksum mismatch", errIncrementalCorrupt)
+	}
+	if version := binary.LittleEndian.Uint32(body[8:]); version != incrementalFormatVersion {
+		return nil, fmt.Errorf("unsupported incremental checkpoint version %d", version)
+	}
+
+	data := &IncrementalData{
+		BaseLSN: binary.LittleEndian.Uint64(body[12:]),
+		LSN:     binary.LittleEndian.Uint64(body[20:]),
+	}
+	count := binary.LittleEndian.Uint64(body[28:])
+	// Every image takes at least two bytes, which bounds a corrupt count
+	if count > uint64(len(body)-incrementalHeaderSize)/2 {
+		return nil, fmt.Errorf("%w: image count %d", errIncrementalCorrupt, count)
+	}
+	data.Images = make([]KeyImage, 0, count)
+
+	rest := body[incrementalHeaderSize:]
+	field := func() ([]byte, bool) {
+		n, size := binary.Uvarint(rest)
+		if size <= 0 || n > uint64(len(rest)-size) {
+			return nil, false
+		}
+		value := rest[size : size+int(n) : size+int(n)]
+		rest = rest[size+int(n):]
+		return value, true
+	}
+	for i := uint64(0); i < count; i++ {
+		if len(rest) == 0 {
+			return nil, fmt.Errorf("%w: truncated at image %d", errIncrementalCorrupt, i)
+		}
+		kind := rest[0]
+		rest = rest[1:]
+		key, ok := field()
+		if !ok || kind > imageKindDelete {
+			return nil, fmt.Errorf("%w: bad image %d", errIncrementalCorrupt, i)
+		}
+		image := KeyImage{Key: string(key), Deleted: kind == imageKindDelete}
+		if !image.Deleted {
+			if image.Value, ok = field(); !ok {
+				return nil, fmt.Errorf("%w: bad image %d", errIncrementalCorrupt, i)
+			}
+		}
+		data.Images = append(data.Images, image)
+	}
+	if len(rest) != 0 {
+		return nil, fmt.Errorf("%w: %d trailing bytes", errIncrementalCorrupt, len(rest))
+	}
+	return data, nil
+}
+
+// CheckpointChain returns the checkpoints needed to restore id, oldest
+// first: the full or snapshot checkpoint an incremental chain starts from,
+// then each incremental up to id. A chain whose first incremental has no
+// base starts from an empty database.
+func (m *Manager) CheckpointChain(id CheckpointID) ([]*Checkpoint, error) {
+	m.mutex.RLock()
+	defer m.mutex.RUnlock()
+
+	checkpoint, exists := m.index.Checkpoints[id]
+	if !exists {
+		return nil, fmt.Errorf("checkpoint %s not found", id)
+	}
+
+	chain := []*Checkpoint{checkpoint}
+	for checkpoint.Type == CheckpointTypeIncremental && len(checkpoint.Metadata.Dependencies) > 0 {
+		baseID := checkpoint.Metadata.Dependencies[0]
+		if checkpoint, exists = m.index.Checkpoints[baseID]; !exists {
+			return nil, fmt.Errorf("checkpoint %s depends on missing checkpoint %s", chain[0].ID, baseID)
+		}
+		if len(chain) > len(m.index.Checkpoints) {
+			return nil, fmt.Errorf("checkpoint %s has a cyclic dependency chain", id)
+		}
+		chain = append(chain, checkpoint)
+	}
+
+	for i, j := 0, len(chain)-1; i < j; i, j = i+1, j-1 {
+		chain[i], chain[j] = chain[j], chain[i]
+	}
+	return chain, nil
+}
+
+// mergeIncrementals merges the key images of incremental checkpoints given
+// oldest first; later images of a key replace earlier ones.
+func mergeIncrementals(chain []*Checkpoint) ([]KeyImage, error) {
+	merged := make(map[string]KeyImage)
+	for _, checkpoint := range chain {
+		data, err := ReadIncrementalData(checkpoint.FilePath)
+		if err != nil {
+			return nil, fmt.Errorf("checkpoint %s: %w", checkpoint.ID, err)
+		}
+		for _, image := range data.Images {
+			merged[image.Key] = image
+		}
+	}
+	return sortedImages(merged), nil
+}
+
+// withoutChainBases drops from toDelete the checkpoints that a retained
+// incremental checkpoint still builds on.
+func (m *Manager) withoutChainBases(toDelete []*Checkpoint) []*Checkpoint {
+	deleting := make(map[CheckpointID]bool, len(toDelete))
+	for _, checkpoint := range toDelete {
+		deleting[checkpoint.ID] = true
+	}
+
+	for id, checkpoint := range m.index.Checkpoints {
+		if deleting[id] {
+			continue
+		}
+		for steps := 0; checkpoint != nil && checkpoint.Type == CheckpointTypeIncremental &&
+			len(checkpoint.Metadata.Dependencies) > 0 && steps < len(m.index.Checkpoints); steps++ {
+			baseID := checkpoint.Metadata.Dependencies[0]
+			delete(deleting, baseID)
+			checkpoint = m.index.Checkpoints[baseID]
+		}
+	}
+
+	remaining := toDelete[:0]
+	for _, checkpoint := range toDelete {
+		if deleting[checkpoint.ID] {
+			remaining = append(remaining, checkpoint)
+		}
+	}
+	return remaining
+}
@@ -0,0 +1,444 @@
+package checkpoint
+
+import (
+	"bytes"
+	"errors"
+	"fmt"
+	"io"
+	"os"
+	"strings"
+	"testing"
+)
+
+// memWAL is an in-memory WAL whose entries get consecutive LSNs.
+type memWAL struct {
+	entries []WALEntryData
+}
+
+func (w *memWAL) ReadFromLSN(lsn uint64) ([]WALEntryData, error) {
+	var entries []WALEntryData
+	for _, entry := range w.entries {
+		if entry.LSN >= lsn {
+			entries = append(entries, entry)
+		}
+	}
+	return entries, nil
+}
+
+func (w *memWAL) GetLastLSN() (uint64, error) {
+	return uint64(len(w.entries)), nil
+}
+
+// log appends an operation and returns its LSN.
+func (w *memWAL) log(txnID uint64, opType OperationTypeData, key, value string) uint64 {
+	lsn := uint64(len(w.entries) + 1)
+	op := OperationData{Type: opType, Key: key}
+	if value != "" {
+		op.Value = []byte(value)
+	}
+	w.entries = append(w.entries, WALEntryData{LSN: lsn, TxnID: txnID, Operation: op})
+	return lsn
+}
+
+// memData snapshots a fixed byte string.
+type memData struct {
+	snapshot string
+}
+
+func (d *memData) CreateSnapshot(lsn uint64) (io.Reader, error) {
+	return strings.NewReader(d.snapshot), nil
+}
+
+func (d *memData) GetDataSize() (int64, error)   { return int64(len(d.snapshot)), nil }
+func (d *memData) ValidateData(lsn uint64) error { return nil }
+
+// memRestorer records a restored snapshot and applies entries to a map.
+type memRestorer struct {
+	snapshot string
+	state    map[string]string
+}
+
+func (r *memRestorer) RestoreFromSnapshot(reader io.Reader) error {
+	data, err := io.ReadAll(reader)
+	r.snapshot = string(data)
+	return err
+}
+
+func (r *memRestorer) ApplyWALEntry(entry WALEntryRecovery) error {
+	if entry.Operation.Type == OpDeleteRecovery {
+		delete(r.state, entry.Operation.Key)
+	} else {
+		r.state[entry.Operation.Key] = string(entry.Operation.Value)
+	}
+	return nil
+}
+
+func (r *memRestorer) ValidateDataConsistency() error { return nil }
+func (r *memRestorer) GetCurrentLSN() (uint64, error) { return 0, nil }
+
+func newTestManager(t *testing.T) (*Manager, *memWAL) {
+	t.Helper()
+	config := TestCheckpointConfig()
+	config.CheckpointDir = t.TempDir()
+	config.ValidateOnCreate = true
+	manager, err := NewManager(config)
+	if err != nil {
+		t.Fatalf("Failed to create manager: %v", err)
+	}
+	wal := &memWAL{}
+	manager.SetWALReader(wal)
+	manager.SetDataProvider(&memData{snapshot: "base snapshot"})
+	return manager, wal
+}
+
+func TestIncrementalDataRoundTrip(t *testing.T) {
+	data := &IncrementalData{
+		BaseLSN: 7,
+		LSN:     42,
+		Images: []KeyImage{
+			{Key: "a", Value: []byte("1")},
+			{Key: "b", Deleted: true},
+			{Key: "c", Value: []byte{}},
+			{Key: "d", Value: []byte{0, 1, 2, 0xff}},
+		},
+	}
+
+	var buf bytes.Buffer
+	if err := writeIncrementalData(&buf, data, 16); err != nil {
+		t.Fatalf("Failed to write incremental data: %v", err)
+	}
+	raw := buf.Bytes()
+	if !bytes.Equal(raw[:8], checkpointMagic[:]) {
+		t.Fatalf("File starts with %q, want the MANTISCP magic", raw[:8])
+	}
+
+	decoded, err := decodeIncrementalData(raw)
+	if err != nil {
+		t.Fatalf("Failed to decode incremental data: %v", err)
+	}
+	if decoded.BaseLSN != data.BaseLSN || decoded.LSN != data.LSN || len(decoded.Images) != len(data.Images) {
+		t.Fatalf("Decoded %+v, want %+v", decoded, data)
+	}
+	for i, image := range decoded.Images {
+		want := data.Images[i]
+		if image.Key != want.Key || image.Deleted != want.Deleted || !bytes.Equal(image.Value, want.Value) {
+			t.Errorf("Image %d decoded as %+v, want %+v", i, image, want)
+		}
+	}
+}
+
+func TestIncrementalDataRejectsCorruption(t *testing.T) {
+	var buf bytes.Buffer
+	data := &IncrementalData{LSN: 3, Images: []KeyImage{{Key: "key", Value: []byte("value")}}}
+	if err := writeIncrementalData(&buf, data, 0); err != nil {
+		t.Fatalf("Failed to write incremental data: %v", err)
+	}
+	raw := buf.Bytes()
+
+	corruptions := map[string]func([]byte) []byte{
+		"trailer": func(b []byte) []byte { b[len(b)-1] ^= 0xff; return b },
+		"body":    func(b []byte) []byte { b[incrementalHeaderSize+2] ^= 1; return b },
+		"truncated": func(b []byte) []byte {
+			return b[:len(b)-6]
+		},
+	}
+	for name, corrupt := range corruptions {
+		_, err := decodeIncrementalData(corrupt(append([]byte(nil), raw...)))
+		if !errors.Is(err, errIncrementalCorrupt) {
+			t.Errorf("%s: decode returned %v, want a corruption error", name, err)
+		}
+	}
+}
+
+func TestIncrementalCheckpointFromTrackedWrites(t *testing.T) {
+	manager, wal := newTestManager(t)
+	wal.log(0, OpUpdateData, "a", "0")
+	full, err := manager.CreateCheckpoint(CheckpointTypeFull)
+	if err != nil {
+		t.Fatalf("Failed to create full checkpoint: %v", err)
+	}
+
+	// Many writes to few keys
+	for i := 0; i < 1000; i++ {
+		key, value := fmt.Sprintf("k%d", i%10), fmt.Sprintf("v%d", i)
+		manager.TrackWrite(wal.log(0, OpUpdateData, key, value), key, []byte(value))
+	}
+	manager.TrackDelete(wal.log(0, OpDeleteData, "a", ""), "a")
+
+	incremental, err := manager.CreateCheckpoint(CheckpointTypeIncremental)
+	if err != nil {
+		t.Fatalf("Failed to create incremental checkpoint: %v", err)
+	}
+	if deps := incremental.Metadata.Dependencies; len(deps) != 1 || deps[0] != full.ID {
+		t.Errorf("Incremental depends on %v, want %s", deps, full.ID)
+	}
+	if incremental.Metadata.OperationCount != 11 {
+		t.Errorf("Incremental holds %d images, want one per changed key", incremental.Metadata.OperationCount)
+	}
+	if incremental.Size > 300 {
+		t.Errorf("Incremental is %d bytes for 11 keys", incremental.Size)
+	}
+
+	data, err := ReadIncrementalData(incremental.FilePath)
+	if err != nil {
+		t.Fatalf("Failed to read incremental checkpoint: %v", err)
+	}
+	if data.Images[0].Key != "a" || !data.Images[0].Deleted || string(data.Images[10].Value) != "v999" {
+		t.Errorf("Unexpected images %+v", data.Images)
+	}
+}
+
+func TestIncrementalCheckpointCoversUntrackedWrites(t *testing.T) {
+	manager, wal := newTestManager(t)
+	if _, err := manager.CreateCheckpoint(CheckpointTypeFull); err != nil {
+		t.Fatalf("Failed to create full checkpoint: %v", err)
+	}
+	if _, err := manager.CreateCheckpoint(CheckpointTypeIncremental); err != nil {
+		t.Fatalf("Failed to create incremental checkpoint: %v", err)
+	}
+
+	// A write logged before the checkpoint reads the LSN but applied and
+	// tracked only after the checkpoint is taken
+	manager.TrackWrite(wal.log(0, OpUpdateData, "tracked", "1"), "tracked", []byte("1"))
+	inFlight := wal.log(0, OpUpdateData, "in-flight", "2")
+	first, err := manager.CreateCheckpoint(CheckpointTypeIncremental)
+	if err != nil {
+		t.Fatalf("Failed to create incremental checkpoint: %v", err)
+	}
+	manager.TrackWrite(inFlight, "in-flight", []byte("2"))
+
+	if keys := imageKeys(t, first); keys != "in-flight,tracked" {
+		t.Errorf("Checkpoint at LSN %d holds keys %s, want in-flight and tracked", first.LSN, keys)
+	}
+
+	// A write logged and tracked after the checkpoint reads the LSN but
+	// before it is taken belongs to the next checkpoint
+	manager.TrackWrite(first.LSN+1, "later", []byte("3"))
+	second, err := manager.CreateCheckpoint(CheckpointTypeIncremental)
+	if err != nil {
+		t.Fatalf("Failed to create incremental checkpoint: %v", err)
+	}
+	wal.log(0, OpUpdateData, "later", "3")
+	third, err := manager.CreateCheckpoint(CheckpointTypeIncremental)
+	if err != nil {
+		t.Fatalf("Failed to create incremental checkpoint: %v", err)
+	}
+
+	if keys := imageKeys(t, second); keys != "in-flight" {
+		t.Errorf("Checkpoint at LSN %d holds keys %s, want only the late tracked in-flight write", second.LSN, keys)
+	}
+	if keys := imageKeys(t, third); keys != "later" {
+		t.Errorf("Checkpoint at LSN %d holds keys %s, want later", third.LSN, keys)
+	}
+}
+
+// imageKeys returns the keys of an incremental checkpoint's images.
+func imageKeys(t *testing.T, checkpoint *Checkpoint) string {
+	t.Helper()
+	data, err := ReadIncrementalData(checkpoint.FilePath)
+	if err != nil {
+		t.Fatalf("Failed to read incremental checkpoint: %v", err)
+	}
+	keys := make([]string, len(data.Images))
+	for i, image := range data.Images {
+		keys[i] = image.Key
+	}
+	return strings.Join(keys, ",")
+}
+
+func TestIncrementalCheckpointFromWAL(t *testing.T) {
+	manager, wal := newTestManager(t)
+	wal.log(0, OpUpdateData, "a", "0")
+	if _, err := manager.CreateCheckpoint(CheckpointTypeFull); err != nil {
+		t.Fatalf("Failed to create full checkpoint: %v", err)
+	}
+
+	// Nothing is tracked, so the images come from the WAL: committed
+	// transactions count, aborted and still open ones do not
+	wal.log(7, OpUpdateData, "k1", "committed")
+	wal.log(8, OpUpdateData, "k2", "aborted")
+	wal.log(8, OpAbortData, "", "")
+	wal.log(7, OpCommitData, "", "")
+	wal.log(9, OpUpdateData, "k3", "open")
+	wal.log(0, OpUpdateData, "k1", "latest")
+
+	incremental, err := manager.CreateCheckpoint(CheckpointTypeIncremental)
+	if err != nil {
+		t.Fatalf("Failed to create incremental checkpoint: %v", err)
+	}
+	data, err := ReadIncrementalData(incremental.FilePath)
+	if err != nil {
+		t.Fatalf("Failed to read incremental checkpoint: %v", err)
+	}
+	if len(data.Images) != 1 || string(data.Images[0].Value) != "latest" {
+		t.Errorf("Unexpected images %+v", data.Images)
+	}
+}
+
+func TestIncrementalCheckpointSpanningTransactions(t *testing.T) {
+	manager, wal := newTestManager(t)
+	wal.log(0, OpUpdateData, "a", "0")
+	if _, err := manager.CreateCheckpoint(CheckpointTypeFull); err != nil {
+		t.Fatalf("Failed to create full checkpoint: %v", err)
+	}
+
+	// Two transactions are open when the checkpoint is taken
+	first := wal.log(5, OpUpdateData, "aborts", "x")
+	wal.log(6, OpUpdateData, "commits", "y")
+	wal.log(0, OpUpdateData, "b", "1")
+	before, err := manager.CreateCheckpoint(CheckpointTypeIncremental)
+	if err != nil {
+		t.Fatalf("Failed to create incremental checkpoint: %v", err)
+	}
+	if keys := imageKeys(t, before); keys != "b" {
+		t.Errorf("Checkpoint with open transactions holds keys %s, want b", keys)
+	}
+	if before.Metadata.OpenTxnLSN != first {
+		t.Errorf("Oldest open transaction recorded at LSN %d, want %d", before.Metadata.OpenTxnLSN, first)
+	}
+
+	// One aborts and the other commits after it; the next checkpoint
+	// holds the committed writes made before its base
+	wal.log(5, OpAbortData, "", "")
+	wal.log(6, OpCommitData, "", "")
+	after, err := manager.CreateCheckpoint(CheckpointTypeIncremental)
+	if err != nil {
+		t.Fatalf("Failed to create incremental checkpoint: %v", err)
+	}
+	if keys := imageKeys(t, after); keys != "commits" {
+		t.Errorf("Checkpoint after the transactions ended holds keys %s, want commits", keys)
+	}
+	if after.Metadata.OpenTxnLSN != 0 {
+		t.Errorf("Open transaction recorded at LSN %d with none open", after.Metadata.OpenTxnLSN)
+	}
+
+	// Restoring the chain never sees the aborted write
+	restorer := &memRestorer{state: make(map[string]string)}
+	engine := NewRecoveryEngine(manager, nil, restorer)
+	if err := engine.executeRestoreCheckpoint(&RecoveryStep{Checkpoint: after}); err != nil {
+		t.Fatalf("Failed to restore checkpoint: %v", err)
+	}
+	if _, ok := restorer.state["aborts"]; ok {
+		t.Error("Restored a write of an aborted transaction")
+	}
+	if restorer.state["commits"] != "y" || restorer.state["b"] != "1" {
+		t.Errorf("Restored state %v", restorer.state)
+	}
+}
+
+// createChain creates a full checkpoint and two incrementals on top of it.
+func createChain(t *testing.T, manager *Manager, wal *memWAL) []*Checkpoint {
+	t.Helper()
+	var chain []*Checkpoint
+	create := func(checkpointType CheckpointType) {
+		checkpoint, err := manager.CreateCheckpoint(checkpointType)
+		if err != nil {
+			t.Fatalf("Failed to create checkpoint: %v", err)
+		}
+		chain = append(chain, checkpoint)
+	}
+
+	wal.log(0, OpUpdateData, "gone", "x")
+	create(CheckpointTypeFull)
+	wal.log(0, OpUpdateData, "a", "1")
+	wal.log(0, OpUpdateData, "b", "1")
+	create(CheckpointTypeIncremental)
+	wal.log(0, OpUpdateData, "b", "2")
+	wal.log(0, OpDeleteData, "gone", "")
+	create(CheckpointTypeIncremental)
+	return chain
+}
+
+func TestMergeIncrementalsChain(t *testing.T) {
+	manager, wal := newTestManager(t)
+	created := createChain(t, manager, wal)
+
+	chain, err := manager.CheckpointChain(created[2].ID)
+	if err != nil {
+		t.Fatalf("Failed to resolve chain: %v", err)
+	}
+	if len(chain) != 3 {
+		t.Fatalf("Chain has %d checkpoints, want 3", len(chain))
+	}
+	for i := range chain {
+		if chain[i].ID != created[i].ID {
+			t.Errorf("Chain[%d] = %s, want %s", i, chain[i].ID, created[i].ID)
+		}
+	}
+
+	images, err := mergeIncrementals(chain[1:])
+	if err != nil {
+		t.Fatalf("Failed to merge incrementals: %v", err)
+	}
+	want := []KeyImage{{Key: "a", Value: []byte("1")}, {Key: "b", Value: []byte("2")}, {Key: "gone", Deleted: true}}
+	if len(images) != len(want) {
+		t.Fatalf("Merged %+v, want %+v", images, want)
+	}
+	for i, image := range images {
+		if image.Key != want[i].Key || image.Deleted != want[i].Deleted || string(image.Value) != string(want[i].Value) {
+			t.Errorf("Merged image %d = %+v, want %+v", i, image, want[i])
+		}
+	}
+}
+
+func TestRestoreIncrementalChain(t *testing.T) {
+	manager, wal := newTestManager(t)
+	created := createChain(t, manager, wal)
+
+	restorer := &memRestorer{state: map[string]string{"gone": "x"}}
+	engine := NewRecoveryEngine(manager, nil, restorer)
+	if err := engine.executeRestoreCheckpoint(&RecoveryStep{Checkpoint: created[2]}); err != nil {
+		t.Fatalf("Failed to restore checkpoint: %v", err)
+	}
+	if restorer.snapshot != "base snapshot" {
+		t.Errorf("Restored snapshot %q, want the base's", restorer.snapshot)
+	}
+	if len(restorer.state) != 2 || restorer.state["a"] != "1" || restorer.state["b"] != "2" {
+		t.Errorf("Restored state %v", restorer.state)
+	}
+
+	// A corrupt link fails the restore rather than skipping its images
+	raw, err := os.ReadFile(created[1].FilePath)
+	if err != nil {
+		t.Fatalf("Failed to read checkpoint: %v", err)
+	}
+	raw[len(raw)-1] ^= 0xff
+	if err := os.WriteFile(created[1].FilePath, raw, 0644); err != nil {
+		t.Fatalf("Failed to write checkpoint: %v", err)
+	}
+	if err := engine.executeRestoreCheckpoint(&RecoveryStep{Checkpoint: created[2]}); err == nil {
+		t.Error("Restored through a corrupt incremental checkpoint")
+	}
+}
+
+func TestCleanupKeepsChainBases(t *testing.T) {
+	manager, wal := newTestManager(t)
+	unrelated, err := manager.CreateCheckpoint(CheckpointTypeFull)
+	if err != nil {
+		t.Fatalf("Failed to create checkpoint: %v", err)
+	}
+	created := createChain(t, manager, wal)
+
+	// Only the retained incremental's own chain is protected
+	remaining := manager.withoutChainBases([]*Checkpoint{unrelated, created[0], created[1]})
+	if len(remaining) != 1 || remaining[0].ID != unrelated.ID {
+		t.Errorf("Would delete %v, want only %s", remaining, unrelated.ID)
+	}
+
+	manager.config.MaxCheckpoints = 1
+	manager.config.MinCheckpoints = 0
+	if err := manager.Cleanup(); err != nil {
+		t.Fatalf("Failed to clean up: %v", err)
+	}
+	if _, err := manager.CheckpointChain(created[2].ID); err != nil {
+		t.Errorf("Cleanup broke the chain: %v", err)
+	}
+	for _, checkpoint := range created {
+		if _, err := os.Stat(checkpoint.FilePath); err != nil {
+			t.Errorf("Cleanup removed %s: %v", checkpoint.ID, err)
+		}
+	}
+	if _, err := os.Stat(unrelated.FilePath); !os.IsNotExist(err) {
+		t.Errorf("Cleanup kept %s, which nothing depends on", unrelated.ID)
+	}
+}
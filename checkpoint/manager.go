@@ -24,6 +24,8 @@ type Manager struct {
 	running   bool
 	stopChan  chan struct{}
 	wg        sync.WaitGroup
+	dirty     *dirtyTracker
+	throttle  *ioThrottle
 
 	// Hooks for external integration
 	walReader    WALReaderInterface
@@ -93,6 +95,8 @@ func NewManager(config *CheckpointConfig) (*Manager, error) {
 		config:    config,
 		indexFile: indexFile,
 		stopChan:  make(chan struct{}),
+		dirty:     newDirtyTracker(),
+		throttle:  newIOThrottle(config),
 		stats: &CheckpointStats{
 			LastCheckpointTime: time.Now(),
 		},
@@ -170,7 +174,7 @@ func (m *Manager) Stop() error {
 }
 
 // CreateCheckpoint creates a new checkpoint
-func (m *Manager) CreateCheckpoint(checkpointType CheckpointType) (*Checkpoint, error) {
+func (m *Manager) CreateCheckpoint(checkpointType CheckpointType) (checkpoint *Checkpoint, err error) {
 	m.mutex.Lock()
 	defer m.mutex.Unlock()
 
@@ -184,11 +188,22 @@ func (m *Manager) CreateCheckpoint(checkpointType CheckpointType) (*Checkpoint,
 		return nil, fmt.Errorf("failed to get current LSN: %w", err)
 	}
 
+	// Keys changed by writes logged after currentLSN belong to the next
+	// checkpoint
+	dirty := m.dirty.take(currentLSN)
+	defer func() {
+		if err != nil {
+			m.dirty.restore(dirty)
+		} else {
+			m.dirty.commit(checkpoint.ID)
+		}
+	}()
+
 	// Generate checkpoint ID
 	checkpointID := m.generateCheckpointID(checkpointType, currentLSN)
 
 	// Create checkpoint metadata
-	checkpoint := &Checkpoint{
+	checkpoint = &Checkpoint{
 		ID:        checkpointID,
 		Type:      checkpointType,
 		Status:    CheckpointStatusCreating,
@@ -209,7 +224,7 @@ func (m *Manager) CreateCheckpoint(checkpointType CheckpointType) (*Checkpoint,
 	startTime := time.Now()
 
 	// Create the checkpoint file
-	if err := m.createCheckpointFile(checkpoint); err != nil {
+	if err := m.createCheckpointFile(checkpoint, dirty); err != nil {
 		checkpoint.Status = CheckpointStatusFailed
 		m.stats.FailedCreations++
 		return checkpoint, fmt.Errorf("failed to create checkpoint file: %w", err)
@@ -335,9 +350,9 @@ func (m *Manager) DeleteCheckpoint(id CheckpointID) error {
 		return fmt.Errorf("checkpoint %s not found", id)
 	}
 
-	// Remove file
-	if err := os.Remove(checkpoint.FilePath); err != nil && !os.IsNotExist(err) {
-		return fmt.Errorf("failed to remove checkpoint file: %w", err)
+	// Remove files
+	if err := removeCheckpointFiles(checkpoint); err != nil {
+		return err
 	}
 
 	// Remove from index
@@ -364,6 +379,8 @@ func (m *Manager) GetStats() *CheckpointStats {
 
 	// Create a copy to avoid race conditions
 	stats := *m.stats
+	stats.IORate = m.throttle.currentRate()
+	stats.ThrottleWait = m.throttle.totalWait()
 	return &stats
 }
 
@@ -425,6 +442,9 @@ func (m *Manager) Cleanup() error {
 		}
 	}
 
+	// Never delete the base of a retained incremental chain
+	toDelete = m.withoutChainBases(toDelete)
+
 	// Delete marked checkpoints
 	for _, checkpoint := range toDelete {
 		if err := m.deleteCheckpointInternal(checkpoint.ID); err != nil {
@@ -449,7 +469,7 @@ func (m *Manager) generateCheckpointID(checkpointType CheckpointType, lsn uint64
 }
 
 // createCheckpointFile creates the actual checkpoint file
-func (m *Manager) createCheckpointFile(checkpoint *Checkpoint) error {
+func (m *Manager) createCheckpointFile(checkpoint *Checkpoint, dirty dirtySet) error {
 	file, err := os.Create(checkpoint.FilePath)
 	if err != nil {
 		return fmt.Errorf("failed to create checkpoint file: %w", err)
@@ -467,7 +487,7 @@ func (m *Manager) createCheckpointFile(checkpoint *Checkpoint) error {
 	case CheckpointTypeFull:
 		return m.createFullCheckpoint(file, checkpoint)
 	case CheckpointTypeIncremental:
-		return m.createIncrementalCheckpoint(file, checkpoint)
+		return m.createIncrementalCheckpoint(file, checkpoint, dirty)
 	case CheckpointTypeSnapshot:
 		return m.createSnapshotCheckpoint(file, checkpoint)
 	default:
@@ -475,12 +495,19 @@ func (m *Manager) createCheckpointFile(checkpoint *Checkpoint) error {
 	}
 }
 
-// createFullCheckpoint creates a full checkpoint
+// createFullCheckpoint creates a full checkpoint. With parallel creation
+// enabled and a provider that can snapshot key ranges, the ranges are
+// written concurrently to part files; either way writes go through the I/O
+// throttle.
 func (m *Manager) createFullCheckpoint(file *os.File, checkpoint *Checkpoint) error {
 	if m.dataProvider == nil {
 		return fmt.Errorf("data provider not configured")
 	}
 
+	if provider, ok := m.dataProvider.(RangeSnapshotProvider); ok && m.config.IsParallelCreationEnabled() {
+		return m.createPartedCheckpoint(file, checkpoint, provider)
+	}
+
 	// Get data snapshot
 	dataReader, err := m.dataProvider.CreateSnapshot(checkpoint.LSN)
 	if err != nil {
@@ -488,46 +515,70 @@ func (m *Manager) createFullCheckpoint(file *os.File, checkpoint *Checkpoint) er
 	}
 
 	// Copy data to checkpoint file
-	written, err := io.Copy(file, dataReader)
+	written, err := m.copyThrottled(file, dataReader)
 	if err != nil {
 		return fmt.Errorf("failed to write checkpoint data: %w", err)
 	}
 
-	checkpoint.Metadata.OperationCount = int(written)
+	checkpoint.Metadata.DataSize = written
 	return nil
 }
 
-// createIncrementalCheckpoint creates an incremental checkpoint
-func (m *Manager) createIncrementalCheckpoint(file *os.File, checkpoint *Checkpoint) error {
-	// Find the last checkpoint to determine what's new
-	lastCheckpoint, err := m.getLastCheckpointBefore(checkpoint.LSN)
-	if err != nil {
-		return fmt.Errorf("failed to find previous checkpoint: %w", err)
-	}
-
-	startLSN := uint64(1)
-	if lastCheckpoint != nil {
-		startLSN = lastCheckpoint.LSN + 1
-	}
-
-	// Read WAL entries since last checkpoint
-	entries, err := m.walReader.ReadFromLSN(startLSN)
-	if err != nil {
-		return fmt.Errorf("failed to read WAL entries: %w", err)
+// createIncrementalCheckpoint writes the latest image of every key changed
+// since the previous checkpoint, which it records as its base
+func (m *Manager) createIncrementalCheckpoint(file *os.File, checkpoint *Checkpoint, dirty dirtySet) error {
+	base := m.getLatestCheckpointAt(checkpoint.LSN)
+
+	data := &IncrementalData{LSN: checkpoint.LSN}
+	// The WAL from readFrom on holds every write of the transactions that
+	// commit after the base, including those already open at the base
+	readFrom := uint64(1)
+	if base != nil {
+		data.BaseLSN = base.LSN
+		checkpoint.Metadata.Dependencies = []CheckpointID{base.ID}
+		readFrom = base.LSN + 1
+		if open := base.Metadata.OpenTxnLSN; open != 0 {
+			readFrom = open
+		}
 	}
 
-	// Write WAL entries to checkpoint
-	encoder := json.NewEncoder(file)
-	for _, entry := range entries {
-		if entry.LSN > checkpoint.LSN {
-			break
+	if base != nil && dirty.since == base.ID {
+		images := make(map[string]KeyImage, len(dirty.images))
+		for key, image := range dirty.images {
+			images[key] = image.KeyImage
 		}
-		if err := encoder.Encode(entry); err != nil {
-			return fmt.Errorf("failed to encode WAL entry: %w", err)
+		// Writes logged by the checkpoint's LSN but not yet tracked when
+		// the set was taken are read from the tail of the WAL, along with
+		// the earlier writes of transactions that commit in the tail
+		// With no tail to read, keep the base's bound on open transactions
+		checkpoint.Metadata.OpenTxnLSN = readFrom
+		if start := max(dirty.trackedLSN, base.LSN) + 1; start <= checkpoint.LSN {
+			entries, err := m.walReader.ReadFromLSN(min(start, readFrom))
+			if err != nil {
+				return fmt.Errorf("failed to read WAL entries: %w", err)
+			}
+			var tail []KeyImage
+			tail, checkpoint.Metadata.OpenTxnLSN = foldWALImages(entries, start-1, checkpoint.LSN)
+			for _, image := range tail {
+				images[image.Key] = image
+			}
 		}
+		data.Images = sortedImages(images)
+	} else {
+		// Tracking doesn't cover the changes since the base, say after a
+		// restart, so derive the images from the WAL
+		entries, err := m.walReader.ReadFromLSN(readFrom)
+		if err != nil {
+			return fmt.Errorf("failed to read WAL entries: %w", err)
+		}
+		data.Images, checkpoint.Metadata.OpenTxnLSN = foldWALImages(entries, data.BaseLSN, checkpoint.LSN)
+	}
+
+	if err := writeIncrementalData(file, data, m.config.BufferSize); err != nil {
+		return fmt.Errorf("failed to write incremental checkpoint: %w", err)
 	}
 
-	checkpoint.Metadata.OperationCount = len(entries)
+	checkpoint.Metadata.OperationCount = len(data.Images)
 	return nil
 }
 
@@ -694,9 +745,9 @@ func (m *Manager) deleteCheckpointInternal(id CheckpointID) error {
 		return fmt.Errorf("checkpoint %s not found", id)
 	}
 
-	// Remove file
-	if err := os.Remove(checkpoint.FilePath); err != nil && !os.IsNotExist(err) {
-		return fmt.Errorf("failed to remove checkpoint file: %w", err)
+	// Remove files
+	if err := removeCheckpointFiles(checkpoint); err != nil {
+		return err
 	}
 
 	// Remove from index
@@ -710,32 +761,52 @@ func (m *Manager) deleteCheckpointInternal(id CheckpointID) error {
 	return nil
 }
 
-func (m *Manager) getLastCheckpointBefore(lsn uint64) (*Checkpoint, error) {
-	var lastCheckpoint *Checkpoint
+// getLatestCheckpointAt returns the newest completed checkpoint at or
+// before lsn, or nil if there is none.
+func (m *Manager) getLatestCheckpointAt(lsn uint64) *Checkpoint {
+	var latest *Checkpoint
 	for _, checkpoint := range m.index.Checkpoints {
-		if checkpoint.LSN < lsn && checkpoint.IsCompleted() {
-			if lastCheckpoint == nil || checkpoint.LSN > lastCheckpoint.LSN {
-				lastCheckpoint = checkpoint
-			}
+		if checkpoint.LSN > lsn || !checkpoint.IsCompleted() {
+			continue
+		}
+		if latest == nil || checkpoint.LSN > latest.LSN ||
+			(checkpoint.LSN == latest.LSN && checkpoint.Timestamp.After(latest.Timestamp)) {
+			latest = checkpoint
 		}
 	}
-	return lastCheckpoint, nil
+	return latest
 }
 
 // Background processes
+
+// automaticCheckpointLoop creates a checkpoint every CheckpointInterval.
+// While foreground latency is above TargetLatency, a due checkpoint is
+// postponed a quarter interval at a time, for at most one extra interval,
+// so checkpoints move to quieter moments without being skipped.
 func (m *Manager) automaticCheckpointLoop() {
 	defer m.wg.Done()
 
-	ticker := time.NewTicker(m.config.CheckpointInterval)
-	defer ticker.Stop()
+	interval := m.config.CheckpointInterval
+	timer := time.NewTimer(interval)
+	defer timer.Stop()
 
+	postponed := time.Duration(0)
 	for {
 		select {
-		case <-ticker.C:
+		case <-timer.C:
+			if m.throttle.sample() && postponed < interval {
+				delay := interval / 4
+				postponed += delay
+				timer.Reset(delay)
+				continue
+			}
+			postponed = 0
+
 			if _, err := m.CreateCheckpoint(CheckpointTypeFull); err != nil {
 				// Log error but continue
 				fmt.Printf("Automatic checkpoint creation failed: %v\n", err)
 			}
+			timer.Reset(interval)
 		case <-m.stopChan:
 			return
 		}
@@ -773,7 +844,7 @@ type checkpointHeader struct {
 
 func (m *Manager) createCheckpointHeader(checkpoint *Checkpoint) *checkpointHeader {
 	header := &checkpointHeader{
-		Magic:     [8]byte{'M', 'A', 'N', 'T', 'I', 'S', 'C', 'P'},
+		Magic:     checkpointMagic,
 		Version:   1,
 		Type:      checkpoint.Type,
 		LSN:       checkpoint.LSN,
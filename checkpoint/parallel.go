@@ -0,0 +1,301 @@
+package checkpoint
+
+import (
+	"bytes"
+	"encoding/binary"
+	"fmt"
+	"hash"
+	"hash/crc32"
+	"io"
+	"os"
+	"path/filepath"
+	"sync"
+)
+
+// RangeSnapshotProvider is implemented by data providers that can snapshot
+// ranges of the keyspace independently, letting full checkpoints write the
+// ranges in parallel. The snapshots of the ranges, concatenated in order,
+// must form a snapshot that RestoreFromSnapshot accepts. Implementing it is
+// optional: full checkpoints of other providers are written as one stream.
+type RangeSnapshotProvider interface {
+	// SplitKeyspace divides the keyspace into at most n ordered ranges of
+	// roughly equal size.
+	SplitKeyspace(n int) ([]KeyRange, error)
+	CreateRangeSnapshot(lsn uint64, keyRange KeyRange) (io.Reader, error)
+}
+
+// KeyRange is the keys from Start up to, but excluding, End. An empty End
+// leaves the range unbounded.
+type KeyRange struct {
+	Start string
+	End   string
+}
+
+// A parted checkpoint's file is a manifest of its part files, which sit
+// beside it. All integers are little endian.
+//
+//	magic    [8]byte  "MANTISCP"
+//	version  uint32   partManifestVersion
+//	count    uint32
+//	parts    count × (uint64 size, uint32 crc32, uvarint nameLen, name)
+//	checksum uint32   CRC32 of everything above
+//
+// The version sits where an incremental checkpoint keeps its own, so the two
+// formats cannot be mistaken for one another.
+const partManifestVersion = 0x100 | 1
+
+// checkpointPart is one part file of a parted checkpoint.
+type checkpointPart struct {
+	Name     string // file name, relative to the manifest's directory
+	Size     int64
+	Checksum uint32
+}
+
+// createPartedCheckpoint writes each key range to its own part file, up to
+// MaxWorkers at a time, then writes the manifest to file.
+func (m *Manager) createPartedCheckpoint(file *os.File, checkpoint *Checkpoint, provider RangeSnapshotProvider) error {
+	workers := m.config.GetEffectiveMaxWorkers()
+	ranges, err := provider.SplitKeyspace(workers)
+	if err != nil {
+		return fmt.Errorf("failed to split keyspace: %w", err)
+	}
+
+	parts := make([]checkpointPart, len(ranges))
+	errs := make([]error, len(ranges))
+	next := make(chan int)
+	var wg sync.WaitGroup
+	for w := 0; w < min(workers, len(ranges)); w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for i := range next {
+				parts[i], errs[i] = m.writePart(checkpoint, i, ranges[i], provider)
+			}
+		}()
+	}
+	for i := range ranges {
+		next <- i
+	}
+	close(next)
+	wg.Wait()
+
+	for i, err := range errs {
+		if err != nil {
+			removeParts(filepath.Dir(checkpoint.FilePath), parts)
+			return fmt.Errorf("failed to write checkpoint part %d: %w", i, err)
+		}
+	}
+
+	if err := writePartManifest(file, parts); err != nil {
+		removeParts(filepath.Dir(checkpoint.FilePath), parts)
+		return fmt.Errorf("failed to write checkpoint manifest: %w", err)
+	}
+
+	var written int64
+	for _, part := range parts {
+		written += part.Size
+	}
+	checkpoint.Metadata.DataSize = written
+	return nil
+}
+
+// writePart snapshots one key range into the checkpoint's i-th part file.
+func (m *Manager) writePart(checkpoint *Checkpoint, i int, keyRange KeyRange, provider RangeSnapshotProvider) (checkpointPart, error) {
+	part := checkpointPart{Name: fmt.Sprintf("%s.part%03d", filepath.Base(checkpoint.FilePath), i)}
+
+	reader, err := provider.CreateRangeSnapshot(checkpoint.LSN, keyRange)
+	if err != nil {
+		return part, fmt.Errorf("failed to snapshot range [%q, %q): %w", keyRange.Start, keyRange.End, err)
+	}
+
+	file, err := os.Create(filepath.Join(filepath.Dir(checkpoint.FilePath), part.Name))
+	if err != nil {
+		return part, err
+	}
+	defer file.Close()
+
+	crc := crc32.NewIEEE()
+	part.Size, err = m.copyThrottled(io.MultiWriter(file, crc), reader)
+	if err != nil {
+		return part, err
+	}
+	part.Checksum = crc.Sum32()
+	return part, nil
+}
+
+// copyThrottled copies src to dst in BufferSize writes paced by the I/O
+// throttle.
+func (m *Manager) copyThrottled(dst io.Writer, src io.Reader) (int64, error) {
+	buf := make([]byte, m.config.GetBufferSize())
+	return io.CopyBuffer(&throttledWriter{w: dst, throttle: m.throttle}, onlyReader{src}, buf)
+}
+
+// onlyReader hides a reader's WriterTo, so io.CopyBuffer writes through
+// the caller's buffer size instead of however much the reader holds.
+type onlyReader struct {
+	io.Reader
+}
+
+func writePartManifest(w io.Writer, parts []checkpointPart) error {
+	manifest := make([]byte, 0, 16+len(parts)*32)
+	manifest = append(manifest, checkpointMagic[:]...)
+	manifest = binary.LittleEndian.AppendUint32(manifest, partManifestVersion)
+	manifest = binary.LittleEndian.AppendUint32(manifest, uint32(len(parts)))
+	for _, part := range parts {
+		manifest = binary.LittleEndian.AppendUint64(manifest, uint64(part.Size))
+		manifest = binary.LittleEndian.AppendUint32(manifest, part.Checksum)
+		manifest = binary.AppendUvarint(manifest, uint64(len(part.Name)))
+		manifest = append(manifest, part.Name...)
+	}
+	manifest = binary.LittleEndian.AppendUint32(manifest, crc32.ChecksumIEEE(manifest))
+	_, err := w.Write(manifest)
+	return err
+}
+
+// readPartManifest returns the parts of a parted checkpoint, or nil if
+// filePath holds the snapshot itself.
+func readPartManifest(filePath string) ([]checkpointPart, error) {
+	file, err := os.Open(filePath)
+	if err != nil {
+		return nil, err
+	}
+	defer file.Close()
+
+	head := make([]byte, 12)
+	if n, _ := io.ReadFull(file, head); n < len(head) ||
+		!bytes.Equal(head[:8], checkpointMagic[:]) ||
+		binary.LittleEndian.Uint32(head[8:]) != partManifestVersion {
+		return nil, nil
+	}
+
+	rest, err := io.ReadAll(file)
+	if err != nil {
+		return nil, err
+	}
+	raw := append(head, rest...)
+	if len(raw) < 20 || crc32.ChecksumIEEE(raw[:len(raw)-4]) != binary.LittleEndian.Uint32(raw[len(raw)-4:]) {
+		return nil, fmt.Errorf("corrupt checkpoint manifest %s", filePath)
+	}
+
+	body := raw[16 : len(raw)-4]
+	count := binary.LittleEndian.Uint32(raw[12:])
+	parts := make([]checkpointPart, 0, min(count, 1024))
+	for i := uint32(0); i < count; i++ {
+		if len(body) < 12 {
+			return nil, fmt.Errorf("corrupt checkpoint manifest %s: truncated part %d", filePath, i)
+		}
+		part := checkpointPart{
+			Size:     int64(binary.LittleEndian.Uint64(body)),
+			Checksum: binary.LittleEndian.Uint32(body[8:]),
+		}
+		nameLen, size := binary.Uvarint(body[12:])
+		if size <= 0 || nameLen > uint64(len(body)-12-size) {
+			return nil, fmt.Errorf("corrupt checkpoint manifest %s: bad part %d", filePath, i)
+		}
+		start := 12 + size
+		part.Name = string(body[start : start+int(nameLen)])
+		if part.Name != filepath.Base(part.Name) {
+			return nil, fmt.Errorf("corrupt checkpoint manifest %s: part name %q", filePath, part.Name)
+		}
+		parts = append(parts, part)
+		body = body[start+int(nameLen):]
+	}
+	return parts, nil
+}
+
+// openSnapshot returns a reader over a full or snapshot checkpoint's data,
+// joining the parts of a parted checkpoint and verifying each part's
+// checksum as it is read.
+func openSnapshot(checkpoint *Checkpoint) (io.ReadCloser, error) {
+	parts, err := readPartManifest(checkpoint.FilePath)
+	if err != nil {
+		return nil, fmt.Errorf("failed to read checkpoint manifest: %w", err)
+	}
+	if parts == nil {
+		return os.Open(checkpoint.FilePath)
+	}
+
+	dir := filepath.Dir(checkpoint.FilePath)
+	files := make(multiCloser, 0, len(parts))
+	readers := make([]io.Reader, 0, len(parts))
+	for _, part := range parts {
+		file, err := os.Open(filepath.Join(dir, part.Name))
+		if err != nil {
+			files.Close()
+			return nil, fmt.Errorf("failed to open checkpoint part: %w", err)
+		}
+		files = append(files, file)
+		readers = append(readers, &verifyingReader{r: file, part: part, crc: crc32.NewIEEE()})
+	}
+	return struct {
+		io.Reader
+		io.Closer
+	}{io.MultiReader(readers...), files}, nil
+}
+
+type multiCloser []*os.File
+
+func (files multiCloser) Close() error {
+	var first error
+	for _, file := range files {
+		if err := file.Close(); err != nil && first == nil {
+			first = err
+		}
+	}
+	return first
+}
+
+// verifyingReader fails at the end of a part whose size or checksum is not
+// what the manifest records.
+type verifyingReader struct {
+	r    io.Reader
+	part checkpointPart
+	crc  hash.Hash32
+	read int64
+}
+
+func (v *verifyingReader) Read(p []byte) (int, error) {
+	n, err := v.r.Read(p)
+	v.crc.Write(p[:n])
+	v.read += int64(n)
+	if err == io.EOF && (v.read != v.part.Size || v.crc.Sum32() != v.part.Checksum) {
+		return n, fmt.Errorf("checkpoint part %s is corrupt: %d bytes, checksum %d, want %d bytes, checksum %d",
+			v.part.Name, v.read, v.crc.Sum32(), v.part.Size, v.part.Checksum)
+	}
+	return n, err
+}
+
+// verifyParts checks every part of a parted checkpoint against its
+// manifest. A checkpoint that is not parted passes.
+func verifyParts(checkpoint *Checkpoint) error {
+	if parts, err := readPartManifest(checkpoint.FilePath); err != nil || parts == nil {
+		return err
+	}
+	reader, err := openSnapshot(checkpoint)
+	if err != nil {
+		return err
+	}
+	defer reader.Close()
+	_, err = io.Copy(io.Discard, reader)
+	return err
+}
+
+// removeCheckpointFiles removes a checkpoint's file and any part files.
+func removeCheckpointFiles(checkpoint *Checkpoint) error {
+	// A manifest that cannot be read has no parts worth looking for
+	parts, _ := readPartManifest(checkpoint.FilePath)
+	removeParts(filepath.Dir(checkpoint.FilePath), parts)
+
+	if err := os.Remove(checkpoint.FilePath); err != nil && !os.IsNotExist(err) {
+		return fmt.Errorf("failed to remove checkpoint file: %w", err)
+	}
+	return nil
+}
+
+func removeParts(dir string, parts []checkpointPart) {
+	for _, part := range parts {
+		if part.Name != "" {
+			os.Remove(filepath.Join(dir, part.Name))
+		}
+	}
+}
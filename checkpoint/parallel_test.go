@@ -0,0 +1,234 @@
+package checkpoint
+
+import (
+	"bytes"
+	"errors"
+	"fmt"
+	"io"
+	"os"
+	"path/filepath"
+	"strings"
+	"testing"
+)
+
+// rangeData is a sorted keyspace that snapshots as one key per line, whole
+// or by range.
+type rangeData struct {
+	keys    []string
+	failing string // start of a range whose snapshot fails
+}
+
+func newRangeData(n int) *rangeData {
+	data := &rangeData{}
+	for i := 0; i < n; i++ {
+		data.keys = append(data.keys, fmt.Sprintf("key%08d", i))
+	}
+	return data
+}
+
+func (d *rangeData) CreateSnapshot(lsn uint64) (io.Reader, error) {
+	return d.CreateRangeSnapshot(lsn, KeyRange{})
+}
+
+func (d *rangeData) GetDataSize() (int64, error)   { return 0, nil }
+func (d *rangeData) ValidateData(lsn uint64) error { return nil }
+
+func (d *rangeData) SplitKeyspace(n int) ([]KeyRange, error) {
+	var ranges []KeyRange
+	per := (len(d.keys) + n - 1) / n
+	for i := 0; i < len(d.keys); i += per {
+		keyRange := KeyRange{Start: d.keys[i]}
+		if i+per < len(d.keys) {
+			keyRange.End = d.keys[i+per]
+		}
+		ranges = append(ranges, keyRange)
+	}
+	return ranges, nil
+}
+
+func (d *rangeData) CreateRangeSnapshot(lsn uint64, keyRange KeyRange) (io.Reader, error) {
+	if d.failing != "" && keyRange.Start == d.failing {
+		return nil, errors.New("range unavailable")
+	}
+	var buf bytes.Buffer
+	for _, key := range d.keys {
+		if key >= keyRange.Start && (keyRange.End == "" || key < keyRange.End) {
+			buf.WriteString(key + "\n")
+		}
+	}
+	return &buf, nil
+}
+
+func newPartedManager(t *testing.T, data *rangeData) *Manager {
+	t.Helper()
+	config := TestCheckpointConfig()
+	config.CheckpointDir = t.TempDir()
+	config.ParallelCreation = true
+	config.MaxWorkers = 4
+	config.BufferSize = 16 << 10
+	manager, err := NewManager(config)
+	if err != nil {
+		t.Fatalf("Failed to create manager: %v", err)
+	}
+	wal := &memWAL{}
+	wal.log(0, OpUpdateData, "x", "y")
+	manager.SetWALReader(wal)
+	manager.SetDataProvider(data)
+	return manager
+}
+
+func TestPartManifestRoundTrip(t *testing.T) {
+	parts := []checkpointPart{
+		{Name: "checkpoint_a.dat.part000", Size: 1 << 40, Checksum: 0xdeadbeef},
+		{Name: "checkpoint_a.dat.part001", Size: 0, Checksum: 0},
+	}
+	path := filepath.Join(t.TempDir(), "checkpoint_a.dat")
+	var buf bytes.Buffer
+	if err := writePartManifest(&buf, parts); err != nil {
+		t.Fatalf("Failed to write manifest: %v", err)
+	}
+	if err := os.WriteFile(path, buf.Bytes(), 0644); err != nil {
+		t.Fatalf("Failed to write manifest: %v", err)
+	}
+
+	read, err := readPartManifest(path)
+	if err != nil {
+		t.Fatalf("Failed to read manifest: %v", err)
+	}
+	if len(read) != len(parts) {
+		t.Fatalf("Read %+v, want %+v", read, parts)
+	}
+	for i := range parts {
+		if read[i] != parts[i] {
+			t.Errorf("Part %d read as %+v, want %+v", i, read[i], parts[i])
+		}
+	}
+
+	// An incremental checkpoint shares the magic but not the version
+	var incremental bytes.Buffer
+	writeIncrementalData(&incremental, &IncrementalData{}, 0)
+	os.WriteFile(path, incremental.Bytes(), 0644)
+	if read, err := readPartManifest(path); err != nil || read != nil {
+		t.Errorf("Incremental checkpoint read as manifest %+v, %v", read, err)
+	}
+
+	// A damaged manifest is an error, not a checkpoint without parts
+	raw := buf.Bytes()
+	raw[20] ^= 1
+	os.WriteFile(path, raw, 0644)
+	if _, err := readPartManifest(path); err == nil {
+		t.Error("Corrupt manifest accepted")
+	}
+}
+
+func TestPartedCheckpointRestore(t *testing.T) {
+	data := newRangeData(20000)
+	manager := newPartedManager(t, data)
+
+	checkpoint, err := manager.CreateCheckpoint(CheckpointTypeFull)
+	if err != nil {
+		t.Fatalf("Failed to create checkpoint: %v", err)
+	}
+	parts, _ := filepath.Glob(checkpoint.FilePath + ".part*")
+	if len(parts) != 4 {
+		t.Fatalf("Checkpoint written as %d parts, want one per worker", len(parts))
+	}
+	result, err := NewDefaultValidator(true).DeepValidation(checkpoint)
+	if err != nil || !result.Valid {
+		t.Fatalf("Deep validation failed: %v %+v", err, result)
+	}
+
+	restorer := &memRestorer{}
+	engine := NewRecoveryEngine(manager, nil, restorer)
+	if err := engine.executeRestoreCheckpoint(&RecoveryStep{Checkpoint: checkpoint}); err != nil {
+		t.Fatalf("Failed to restore checkpoint: %v", err)
+	}
+	want := strings.Join(data.keys, "\n") + "\n"
+	if restorer.snapshot != want {
+		t.Errorf("Restored %d bytes, want the %d byte snapshot", len(restorer.snapshot), len(want))
+	}
+	if checkpoint.Metadata.DataSize != int64(len(want)) || checkpoint.Metadata.OperationCount != 0 {
+		t.Errorf("Metadata records %d bytes and %d operations, want the %d byte snapshot",
+			checkpoint.Metadata.DataSize, checkpoint.Metadata.OperationCount, len(want))
+	}
+}
+
+func TestVerifyingReaderRejectsCorruptPart(t *testing.T) {
+	manager := newPartedManager(t, newRangeData(20000))
+	checkpoint, err := manager.CreateCheckpoint(CheckpointTypeFull)
+	if err != nil {
+		t.Fatalf("Failed to create checkpoint: %v", err)
+	}
+	parts, _ := filepath.Glob(checkpoint.FilePath + ".part*")
+
+	raw, err := os.ReadFile(parts[2])
+	if err != nil {
+		t.Fatalf("Failed to read part: %v", err)
+	}
+	raw[10] ^= 1
+	if err := os.WriteFile(parts[2], raw, 0644); err != nil {
+		t.Fatalf("Failed to write part: %v", err)
+	}
+
+	reader, err := openSnapshot(checkpoint)
+	if err != nil {
+		t.Fatalf("Failed to open checkpoint: %v", err)
+	}
+	_, err = io.Copy(io.Discard, reader)
+	reader.Close()
+	if err == nil || !strings.Contains(err.Error(), filepath.Base(parts[2])) {
+		t.Errorf("Reading a corrupt part returned %v", err)
+	}
+
+	if result, _ := NewDefaultValidator(true).DeepValidation(checkpoint); result.Valid {
+		t.Error("Corrupt part passed deep validation")
+	}
+	engine := NewRecoveryEngine(manager, nil, &memRestorer{})
+	if err := engine.executeRestoreCheckpoint(&RecoveryStep{Checkpoint: checkpoint}); err == nil {
+		t.Error("Restored from a corrupt part")
+	}
+
+	// A truncated part fails the same way
+	os.WriteFile(parts[2], raw[:len(raw)/2], 0644)
+	if err := verifyParts(checkpoint); err == nil {
+		t.Error("Truncated part passed verification")
+	}
+}
+
+func TestRemoveCheckpointFiles(t *testing.T) {
+	data := newRangeData(20000)
+	manager := newPartedManager(t, data)
+	dir := manager.config.CheckpointDir
+
+	// A range that fails to snapshot takes the parts already written with it
+	ranges, _ := data.SplitKeyspace(4)
+	data.failing = ranges[2].Start
+	if _, err := manager.CreateCheckpoint(CheckpointTypeFull); err == nil {
+		t.Fatal("Checkpoint succeeded despite a failed range")
+	}
+	if left, _ := filepath.Glob(filepath.Join(dir, "*.part*")); len(left) != 0 {
+		t.Errorf("Failed checkpoint left parts %v", left)
+	}
+
+	data.failing = ""
+	checkpoint, err := manager.CreateCheckpoint(CheckpointTypeFull)
+	if err != nil {
+		t.Fatalf("Failed to create checkpoint: %v", err)
+	}
+	parts, _ := filepath.Glob(checkpoint.FilePath + ".part*")
+
+	// Parts already gone, say from an earlier interrupted delete, do not
+	// stop the rest from being removed
+	os.Remove(parts[1])
+	if err := manager.DeleteCheckpoint(checkpoint.ID); err != nil {
+		t.Fatalf("Failed to delete checkpoint: %v", err)
+	}
+	if left, _ := filepath.Glob(filepath.Join(dir, "checkpoint_full*")); len(left) != 0 {
+		t.Errorf("Delete left %v", left)
+	}
+
+	// Removing a checkpoint whose files are all gone is not an error
+	if err := removeCheckpointFiles(checkpoint); err != nil {
+		t.Errorf("Removing a removed checkpoint failed: %v", err)
+	}
+}
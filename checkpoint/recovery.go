@@ -3,7 +3,6 @@ package checkpoint
 import (
 	"fmt"
 	"io"
-	"os"
 	"sort"
 	"time"
 )
@@ -505,21 +504,60 @@ func (re *RecoveryEngine) executeRecoveryStep(step *RecoveryStep) error {
 	}
 }
 
-// executeRestoreCheckpoint restores data from a checkpoint
+// executeRestoreCheckpoint restores data from a checkpoint. An incremental
+// checkpoint is restored by loading the full checkpoint its chain starts
+// from, then applying the merged key images of the incrementals on top.
 func (re *RecoveryEngine) executeRestoreCheckpoint(step *RecoveryStep) error {
 	if step.Checkpoint == nil {
 		return fmt.Errorf("no checkpoint specified for restore step")
 	}
 
-	// Open checkpoint file
-	file, err := os.Open(step.Checkpoint.FilePath)
+	chain, err := re.checkpointManager.CheckpointChain(step.Checkpoint.ID)
+	if err != nil {
+		return fmt.Errorf("failed to resolve checkpoint chain: %w", err)
+	}
+
+	incrementals := chain
+	if base := chain[0]; base.Type != CheckpointTypeIncremental {
+		if err := re.restoreSnapshot(base); err != nil {
+			return err
+		}
+		incrementals = chain[1:]
+	}
+	if len(incrementals) == 0 {
+		return nil
+	}
+
+	images, err := mergeIncrementals(incrementals)
+	if err != nil {
+		return fmt.Errorf("failed to read incremental checkpoints: %w", err)
+	}
+	for _, image := range images {
+		entry := WALEntryRecovery{
+			LSN:       step.Checkpoint.LSN,
+			Operation: OperationRecovery{Type: OpUpdateRecovery, Key: image.Key, Value: image.Value},
+		}
+		if image.Deleted {
+			entry.Operation = OperationRecovery{Type: OpDeleteRecovery, Key: image.Key}
+		}
+		if err := re.dataRestorer.ApplyWALEntry(entry); err != nil {
+			return fmt.Errorf("failed to apply checkpoint image of key %q: %w", image.Key, err)
+		}
+	}
+
+	return nil
+}
+
+// restoreSnapshot loads a full or snapshot checkpoint, joining the parts of
+// one written in parallel
+func (re *RecoveryEngine) restoreSnapshot(checkpoint *Checkpoint) error {
+	reader, err := openSnapshot(checkpoint)
 	if err != nil {
 		return fmt.Errorf("failed to open checkpoint file: %w", err)
 	}
-	defer file.Close()
+	defer reader.Close()
 
-	// Restore data from checkpoint
-	if err := re.dataRestorer.RestoreFromSnapshot(file); err != nil {
+	if err := re.dataRestorer.RestoreFromSnapshot(reader); err != nil {
 		return fmt.Errorf("failed to restore from checkpoint: %w", err)
 	}
 
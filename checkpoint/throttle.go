@@ -0,0 +1,154 @@
+package checkpoint
+
+import (
+	"io"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+// throttleAdjustInterval is how often the I/O rate follows foreground
+// latency.
+const throttleAdjustInterval = 100 * time.Millisecond
+
+// ioThrottle is a token bucket limiting checkpoint writes to a rate in
+// bytes per second. With a target latency it runs an AIMD controller: the
+// rate halves, down to minRate, while the foreground latency reported to
+// observe is above target, and grows back by a tenth of maxRate per
+// interval otherwise. With no foreground operations at all, the node is
+// idle and the rate jumps straight to maxRate.
+type ioThrottle struct {
+	maxRate float64
+	minRate float64
+	target  time.Duration
+
+	// Foreground latency over the current interval, updated lock-free
+	// since observe is on the foreground path
+	latencySum   atomic.Int64
+	latencyCount atomic.Int64
+
+	mu         sync.Mutex
+	rate       float64
+	tokens     float64
+	lastFill   time.Time
+	lastAdjust time.Time
+	waited     time.Duration
+}
+
+func newIOThrottle(config *CheckpointConfig) *ioThrottle {
+	now := time.Now()
+	return &ioThrottle{
+		maxRate:    float64(config.MaxIORate),
+		minRate:    float64(min(config.MinIORate, config.MaxIORate)),
+		target:     config.TargetLatency,
+		rate:       float64(config.MaxIORate),
+		lastFill:   now,
+		lastAdjust: now,
+	}
+}
+
+// observe records the latency of one foreground operation.
+func (t *ioThrottle) observe(latency time.Duration) {
+	t.latencySum.Add(int64(latency))
+	t.latencyCount.Add(1)
+}
+
+// sample closes the current latency interval, adjusting the rate, and
+// reports whether foreground latency over it was above target.
+func (t *ioThrottle) sample() bool {
+	if t.target <= 0 {
+		return false
+	}
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	return t.adjust(time.Now())
+}
+
+// wait blocks until n bytes may be written. The bucket may go into debt, so
+// a write larger than the burst waits for its own size rather than
+// failing; the debt is paid off before the next write proceeds.
+func (t *ioThrottle) wait(n int) {
+	if t.maxRate <= 0 {
+		return
+	}
+
+	t.mu.Lock()
+	now := time.Now()
+	if t.target > 0 && now.Sub(t.lastAdjust) >= throttleAdjustInterval {
+		t.adjust(now)
+	}
+
+	// Allow a tenth of a second's worth of burst
+	burst := t.rate / 10
+	t.tokens = min(t.tokens+now.Sub(t.lastFill).Seconds()*t.rate, burst)
+	t.lastFill = now
+	t.tokens -= float64(n)
+
+	var delay time.Duration
+	if t.tokens < 0 {
+		delay = time.Duration(-t.tokens / t.rate * float64(time.Second))
+		t.waited += delay
+	}
+	t.mu.Unlock()
+
+	if delay > 0 {
+		time.Sleep(delay)
+	}
+}
+
+// adjust moves the rate toward what foreground latency allows and reports
+// whether latency was above target. Called with mu held.
+func (t *ioThrottle) adjust(now time.Time) bool {
+	count := t.latencyCount.Swap(0)
+	sum := t.latencySum.Swap(0)
+	t.lastAdjust = now
+
+	pressure := count > 0 && time.Duration(sum/count) > t.target
+	switch {
+	case count == 0:
+		t.rate = t.maxRate
+	case pressure:
+		t.rate = max(t.rate/2, t.minRate)
+	default:
+		t.rate = min(t.rate+t.maxRate/10, t.maxRate)
+	}
+	// The rate never reaches zero, or writers would wait forever
+	t.rate = max(t.rate, 1)
+	return pressure
+}
+
+// currentRate returns the rate writes are limited to, 0 if unlimited.
+func (t *ioThrottle) currentRate() int64 {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	if t.maxRate <= 0 {
+		return 0
+	}
+	return int64(t.rate)
+}
+
+// totalWait returns how long writers have been held back in all.
+func (t *ioThrottle) totalWait() time.Duration {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	return t.waited
+}
+
+// throttledWriter passes writes through an ioThrottle.
+type throttledWriter struct {
+	w        io.Writer
+	throttle *ioThrottle
+}
+
+func (tw *throttledWriter) Write(p []byte) (int, error) {
+	tw.throttle.wait(len(p))
+	return tw.w.Write(p)
+}
+
+// ObserveLatency reports the latency of a foreground operation. Checkpoint
+// writes back off while it runs above the configured TargetLatency, and
+// automatic checkpoints are postponed. Reporting is optional: a node that
+// reports nothing looks idle, and checkpoints write at MaxIORate.
+func (m *Manager) ObserveLatency(latency time.Duration) {
+	m.throttle.observe(latency)
+}
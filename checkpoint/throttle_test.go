@@ -0,0 +1,72 @@
+package checkpoint
+
+import (
+	"testing"
+	"time"
+)
+
+func TestIOThrottleFollowsLatency(t *testing.T) {
+	throttle := newIOThrottle(&CheckpointConfig{
+		MaxIORate:     1000,
+		MinIORate:     100,
+		TargetLatency: 10 * time.Millisecond,
+	})
+	if rate := throttle.currentRate(); rate != 1000 {
+		t.Fatalf("Initial rate %d, want MaxIORate", rate)
+	}
+
+	// Above target, the rate halves down to MinIORate
+	for _, want := range []int64{500, 250, 125, 100, 100} {
+		throttle.observe(50 * time.Millisecond)
+		throttle.observe(30 * time.Millisecond)
+		if !throttle.sample() {
+			t.Error("Latency above target not reported")
+		}
+		if rate := throttle.currentRate(); rate != want {
+			t.Errorf("Rate %d under pressure, want %d", rate, want)
+		}
+	}
+
+	// Below target, it grows back a tenth of MaxIORate at a time
+	for _, want := range []int64{200, 300} {
+		throttle.observe(time.Millisecond)
+		if throttle.sample() {
+			t.Error("Latency below target reported as pressure")
+		}
+		if rate := throttle.currentRate(); rate != want {
+			t.Errorf("Rate %d below target, want %d", rate, want)
+		}
+	}
+
+	// With no foreground operations at all, it goes straight to MaxIORate
+	throttle.sample()
+	if rate := throttle.currentRate(); rate != 1000 {
+		t.Errorf("Idle rate %d, want MaxIORate", rate)
+	}
+}
+
+func TestIOThrottleWait(t *testing.T) {
+	// Without a target latency the rate stays fixed
+	throttle := newIOThrottle(&CheckpointConfig{MaxIORate: 10 << 20})
+	throttle.observe(time.Second)
+	if throttle.sample() {
+		t.Error("Pressure reported without a target latency")
+	}
+
+	// The first write only gets the burst allowance of a tenth of a second
+	start := time.Now()
+	throttle.wait(2 << 20)
+	if elapsed := time.Since(start); elapsed < 150*time.Millisecond {
+		t.Errorf("2MB at 10MB/s took %v", elapsed)
+	}
+	if waited := throttle.totalWait(); waited < 150*time.Millisecond {
+		t.Errorf("Recorded %v of waiting", waited)
+	}
+
+	// A zero rate leaves writes unthrottled
+	unlimited := newIOThrottle(&CheckpointConfig{})
+	unlimited.wait(1 << 30)
+	if unlimited.totalWait() != 0 || unlimited.currentRate() != 0 {
+		t.Error("Unlimited throttle held a write back")
+	}
+}
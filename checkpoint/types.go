@@ -48,6 +48,8 @@ type CheckpointMeta struct {
 	DatabaseVersion  string            `json:"database_version"`  // Database version when created
 	TransactionCount int               `json:"transaction_count"` // Number of transactions
 	OperationCount   int               `json:"operation_count"`   // Number of operations
+	DataSize         int64             `json:"data_size"`         // Snapshot bytes, across all parts
+	OpenTxnLSN       uint64            `json:"open_txn_lsn"`      // First LSN of the oldest transaction open at LSN
 	CompressionType  string            `json:"compression_type"`  // Compression used
 	EncryptionType   string            `json:"encryption_type"`   // Encryption used
 	Tags             map[string]string `json:"tags"`              // Custom tags
@@ -98,6 +100,14 @@ type CheckpointConfig struct {
 	ParallelCreation bool `json:"parallel_creation"`
 	MaxWorkers       int  `json:"max_workers"`
 
+	// I/O throttling: checkpoint writes are limited to MaxIORate bytes per
+	// second (0 = unlimited). With TargetLatency set, the rate backs off
+	// toward MinIORate while foreground latency reported through
+	// Manager.ObserveLatency is above target.
+	MaxIORate     int64         `json:"max_io_rate"`
+	MinIORate     int64         `json:"min_io_rate"`
+	TargetLatency time.Duration `json:"target_latency"`
+
 	// Cleanup settings
 	AutoCleanup     bool          `json:"auto_cleanup"`
 	CleanupInterval time.Duration `json:"cleanup_interval"`
@@ -118,6 +128,8 @@ type CheckpointStats struct {
 	ValidationFailures  int           `json:"validation_failures"`
 	CorruptedCount      int           `json:"corrupted_count"`
 	CleanupCount        int           `json:"cleanup_count"`
+	IORate              int64         `json:"io_rate"`       // Current write rate limit, 0 if unlimited
+	ThrottleWait        time.Duration `json:"throttle_wait"` // Total time writes were held back
 }
 
 // CheckpointValidationResult represents the result of checkpoint validation
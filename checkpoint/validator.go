@@ -441,14 +441,43 @@ func (v *DefaultValidator) DeepValidation(checkpoint *Checkpoint) (*CheckpointVa
 
 // validateFullCheckpointData validates full checkpoint data
 func (v *DefaultValidator) validateFullCheckpointData(checkpoint *Checkpoint, result *CheckpointValidationResult) error {
-	// Placeholder for full checkpoint data validation
-	// In a real implementation, this would validate the actual database state
+	// The manifest's checksum is covered by the file checksum; the parts
+	// written in parallel are checked against the manifest here
+	if err := verifyParts(checkpoint); err != nil {
+		result.Errors = append(result.Errors, CheckpointError{
+			Type:        CheckpointErrorCorrupted,
+			Message:     err.Error(),
+			Field:       "parts",
+			Expected:    "parts matching the manifest",
+			Recoverable: false,
+		})
+	}
 	return nil
 }
 
 // validateIncrementalCheckpointData validates incremental checkpoint data
 func (v *DefaultValidator) validateIncrementalCheckpointData(checkpoint *Checkpoint, result *CheckpointValidationResult) error {
-	// Placeholder for incremental checkpoint data validation
-	// In a real implementation, this would validate WAL entries
+	data, err := ReadIncrementalData(checkpoint.FilePath)
+	if err != nil {
+		result.Errors = append(result.Errors, CheckpointError{
+			Type:        CheckpointErrorFormatInvalid,
+			Message:     err.Error(),
+			Field:       "data",
+			Expected:    "valid incremental checkpoint",
+			Recoverable: false,
+		})
+		return nil
+	}
+
+	if data.LSN != checkpoint.LSN {
+		result.Errors = append(result.Errors, CheckpointError{
+			Type:        CheckpointErrorInconsistency,
+			Message:     "incremental checkpoint LSN does not match metadata",
+			Field:       "lsn",
+			Expected:    checkpoint.LSN,
+			Actual:      data.LSN,
+			Recoverable: false,
+		})
+	}
 	return nil
 }
@@ -288,6 +288,7 @@ func (cm *ConnectionManager) createHTTPClient() *http.Client {
 		MaxIdleConnsPerHost: cm.maxConnections,
 		IdleConnTimeout:     cm.config.ConnectionTimeout,
 		DisableKeepAlives:   false,
+		ForceAttemptHTTP2:   true,
 	}
 
 	return &http.Client{
@@ -345,6 +346,13 @@ type ConnectionStats struct {
 	MaxConnections    int `json:"max_connections"`
 	ActiveConnections int `json:"active_connections"`
 	IdleConnections   int `json:"idle_connections"`
+	// Latency holds latency percentiles keyed by operation name, such as
+	// "query" or "get_key"; "batch" covers coalesced batch requests.
+	Latency map[string]LatencyStats `json:"latency,omitempty"`
+	// Batches counts coalesced batch requests sent, and CoalescedOps the
+	// operations that rode along in a batch rather than needing their own.
+	Batches      uint64 `json:"batches"`
+	CoalescedOps uint64 `json:"coalesced_ops"`
 }
 
 // Helper functions
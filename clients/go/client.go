@@ -22,6 +22,8 @@ type Client struct {
 	baseURL    string
 	authMgr    *AuthManager
 	connMgr    *ConnectionManager
+	batcher    *batcher
+	metrics    clientMetrics
 	mu         sync.RWMutex
 }
 
@@ -45,6 +47,13 @@ type Config struct {
 	TLSEnabled        bool
 	EnableFailover    bool
 	FailoverHosts     []string
+	// CoalesceWindow, when positive, holds key operations (GetKey, SetKey,
+	// DeleteKey) for up to this long so concurrent ones share one batch
+	// request. Tens of microseconds is usually enough under load.
+	CoalesceWindow time.Duration
+	// MaxBatchSize sends a coalesced batch as soon as it holds this many
+	// operations. The server accepts at most 100.
+	MaxBatchSize int
 }
 
 // DefaultConfig returns a default configuration
@@ -59,6 +68,7 @@ func DefaultConfig() *Config {
 		RetryDelay:        1 * time.Second,
 		EnableCompression: true,
 		TLSEnabled:        false,
+		MaxBatchSize:      100,
 	}
 }
 
@@ -74,6 +84,9 @@ func NewConnectionPool(config *Config) *ConnectionPool {
 		MaxIdleConns:        config.MaxConnections,
 		MaxIdleConnsPerHost: config.MaxConnections,
 		IdleConnTimeout:     config.ConnectionTimeout,
+		// Over TLS, concurrent requests share connections through HTTP/2
+		// streams instead of each holding a connection.
+		ForceAttemptHTTP2: true,
 	}
 
 	return &ConnectionPool{
@@ -133,6 +146,13 @@ func NewClient(config *Config) (*Client, error) {
 		authMgr:    authMgr,
 		connMgr:    connMgr,
 	}
+	if config.CoalesceWindow > 0 {
+		maxOps := config.MaxBatchSize
+		if maxOps <= 0 {
+			maxOps = 100
+		}
+		client.batcher = newBatcher(client, config.CoalesceWindow, maxOps)
+	}
 
 	// Test connection
 	ctx, cancel := context.WithTimeout(context.Background(), config.ConnectionTimeout)
@@ -167,35 +187,135 @@ func (c *Client) Ping(ctx context.Context) error {
 
 // Query executes a query and returns results
 func (c *Client) Query(ctx context.Context, query string) (*Result, error) {
-	queryReq := QueryRequest{
-		SQL: query,
-	}
+	defer c.metrics.record("query", time.Now())
+	result, _, err := c.query(ctx, QueryRequest{SQL: query})
+	return result, err
+}
 
+// query posts a query request and also returns the response status so
+// callers can react to specific failures.
+func (c *Client) query(ctx context.Context, queryReq QueryRequest) (*Result, int, error) {
 	req, err := c.newRequest(ctx, "POST", "/api/query", queryReq)
 	if err != nil {
-		return nil, err
+		return nil, 0, err
 	}
 
 	resp, err := c.doRequestWithRetry(req)
 	if err != nil {
-		return nil, err
+		return nil, 0, err
 	}
 	defer resp.Body.Close()
 
 	if resp.StatusCode != http.StatusOK {
-		return nil, c.handleErrorResponse(resp)
+		return nil, resp.StatusCode, c.handleErrorResponse(resp)
 	}
 
 	var result Result
 	if err := json.NewDecoder(resp.Body).Decode(&result); err != nil {
-		return nil, fmt.Errorf("failed to decode response: %w", err)
+		return nil, resp.StatusCode, fmt.Errorf("failed to decode response: %w", err)
 	}
 
-	return &result, nil
+	return &result, resp.StatusCode, nil
+}
+
+// PreparedStatement is a statement parsed and planned once on the server
+// and executed with ? or $n parameters.
+type PreparedStatement struct {
+	ID         string
+	SQL        string
+	ParamCount int
+
+	client *Client
+	mu     sync.Mutex
+}
+
+// Prepare registers a statement with the server for repeated execution.
+func (c *Client) Prepare(ctx context.Context, query string) (*PreparedStatement, error) {
+	stmt := &PreparedStatement{SQL: query, client: c}
+	if err := stmt.prepare(ctx); err != nil {
+		return nil, err
+	}
+	return stmt, nil
+}
+
+func (s *PreparedStatement) prepare(ctx context.Context) error {
+	req, err := s.client.newRequest(ctx, "POST", "/api/query/prepare", QueryRequest{SQL: s.SQL})
+	if err != nil {
+		return err
+	}
+
+	resp, err := s.client.doRequestWithRetry(req)
+	if err != nil {
+		return err
+	}
+	defer resp.Body.Close()
+
+	if resp.StatusCode != http.StatusOK {
+		return s.client.handleErrorResponse(resp)
+	}
+
+	var prepared struct {
+		StatementID string `json:"statement_id"`
+		ParamCount  int    `json:"param_count"`
+	}
+	if err := json.NewDecoder(resp.Body).Decode(&prepared); err != nil {
+		return fmt.Errorf("failed to decode response: %w", err)
+	}
+
+	s.mu.Lock()
+	s.ID = prepared.StatementID
+	s.ParamCount = prepared.ParamCount
+	s.mu.Unlock()
+	return nil
+}
+
+// Query executes the statement with the given parameters. A statement the
+// server no longer knows, after a restart for example, is prepared again.
+func (s *PreparedStatement) Query(ctx context.Context, params ...interface{}) (*Result, error) {
+	defer s.client.metrics.record("prepared_query", time.Now())
+	s.mu.Lock()
+	id := s.ID
+	s.mu.Unlock()
+
+	result, status, err := s.client.query(ctx, QueryRequest{StatementID: id, Params: params})
+	if status == http.StatusNotFound {
+		if err := s.prepare(ctx); err != nil {
+			return nil, err
+		}
+		s.mu.Lock()
+		id = s.ID
+		s.mu.Unlock()
+		result, _, err = s.client.query(ctx, QueryRequest{StatementID: id, Params: params})
+	}
+	return result, err
+}
+
+// Close deallocates the statement on the server.
+func (s *PreparedStatement) Close(ctx context.Context) error {
+	s.mu.Lock()
+	id := s.ID
+	s.mu.Unlock()
+
+	req, err := s.client.newRequest(ctx, "DELETE", "/api/query/prepare?statement_id="+url.QueryEscape(id), nil)
+	if err != nil {
+		return err
+	}
+
+	resp, err := s.client.doRequestWithRetry(req)
+	if err != nil {
+		return err
+	}
+	defer resp.Body.Close()
+
+	if resp.StatusCode != http.StatusOK && resp.StatusCode != http.StatusNotFound {
+		return s.client.handleErrorResponse(resp)
+	}
+	return nil
 }
 
 // Insert inserts data into a table
 func (c *Client) Insert(ctx context.Context, table string, data interface{}) error {
+	defer c.metrics.record("insert", time.Now())
 	insertReq := InsertRequest{
 		Table: table,
 		Data:  data,
@@ -221,6 +341,7 @@ func (c *Client) Insert(ctx context.Context, table string, data interface{}) err
 
 // Update updates data in a table
 func (c *Client) Update(ctx context.Context, table string, id string, data interface{}) error {
+	defer c.metrics.record("update", time.Now())
 	updateReq := UpdateRequest{
 		Data: data,
 	}
@@ -245,6 +366,7 @@ func (c *Client) Update(ctx context.Context, table string, id string, data inter
 
 // Delete deletes data from a table
 func (c *Client) Delete(ctx context.Context, table string, id string) error {
+	defer c.metrics.record("delete", time.Now())
 	req, err := c.newRequest(ctx, "DELETE", fmt.Sprintf("/api/tables/%s/data/%s", table, id), nil)
 	if err != nil {
 		return err
@@ -265,6 +387,7 @@ func (c *Client) Delete(ctx context.Context, table string, id string) error {
 
 // Get retrieves data from a table
 func (c *Client) Get(ctx context.Context, table string, filters map[string]interface{}) (*Result, error) {
+	defer c.metrics.record("get", time.Now())
 	u, err := url.Parse(fmt.Sprintf("%s/api/tables/%s/data", c.baseURL, table))
 	if err != nil {
 		return nil, err
@@ -330,8 +453,13 @@ func (c *Client) BeginTransaction(ctx context.Context) (*Transaction, error) {
 	}, nil
 }
 
-// Close closes the client and releases resources
+// Close closes the client and releases resources. Coalesced operations
+// still queued are sent first.
 func (c *Client) Close() error {
+	if c.batcher != nil {
+		c.batcher.flush()
+	}
+
 	c.mu.Lock()
 	defer c.mu.Unlock()
 
@@ -433,7 +561,9 @@ func (c *Client) handleErrorResponse(resp *http.Response) error {
 
 // Request/Response types
 type QueryRequest struct {
-	SQL string `json:"sql"`
+	SQL         string        `json:"sql,omitempty"`
+	StatementID string        `json:"statement_id,omitempty"`
+	Params      []interface{} `json:"params,omitempty"`
 }
 
 type InsertRequest struct {
@@ -481,12 +611,17 @@ func (e *MantisError) Error() string {
 	return fmt.Sprintf("MantisDB error [%s]: %s", e.Code, e.Message)
 }
 
-// GetConnectionStats returns connection pool statistics
+// GetConnectionStats returns connection pool statistics along with
+// per-operation latencies and batching counters
 func (c *Client) GetConnectionStats() ConnectionStats {
+	var stats ConnectionStats
 	if c.connMgr != nil {
-		return c.connMgr.Stats()
+		stats = c.connMgr.Stats()
 	}
-	return ConnectionStats{}
+	stats.Latency = c.metrics.latencies()
+	stats.Batches = c.metrics.batches.Load()
+	stats.CoalescedOps = c.metrics.coalesced.Load()
+	return stats
 }
 
 // SetAuthProvider sets a new authentication provider
@@ -0,0 +1,292 @@
+package mantisdb
+
+import (
+	"context"
+	"encoding/json"
+	"fmt"
+	"net/http"
+	"net/url"
+	"strings"
+	"sync"
+	"time"
+)
+
+// Key operations issued by concurrent callers within Config.CoalesceWindow
+// of each other travel to the server as one batch request instead of one
+// request each. Reads of the same key in an open batch share one
+// operation. The batch is sent non-atomically, so each caller still gets
+// its own result.
+
+// batchOperation is one entry of a /api/v1/kv/batch request.
+type batchOperation struct {
+	Type  string `json:"type"`
+	Key   string `json:"key"`
+	Value string `json:"value,omitempty"`
+	TTL   int    `json:"ttl,omitempty"`
+}
+
+type batchRequest struct {
+	Operations []batchOperation `json:"operations"`
+	Atomic     bool             `json:"atomic"`
+}
+
+type batchResult struct {
+	Key     string      `json:"key"`
+	Value   interface{} `json:"value,omitempty"`
+	Success bool        `json:"success"`
+	Error   string      `json:"error,omitempty"`
+}
+
+type batchResponse struct {
+	Results []batchResult `json:"results"`
+	Success bool          `json:"success"`
+	Errors  []string      `json:"errors,omitempty"`
+}
+
+// pendingOp is a queued operation; done is closed once value and err
+// are set.
+type pendingOp struct {
+	op    batchOperation
+	done  chan struct{}
+	value string
+	err   error
+}
+
+func (p *pendingOp) wait(ctx context.Context) (string, error) {
+	select {
+	case <-p.done:
+		return p.value, p.err
+	case <-ctx.Done():
+		return "", ctx.Err()
+	}
+}
+
+// batcher collects key operations until the window closes or the batch
+// is full, then sends them together.
+type batcher struct {
+	client *Client
+	window time.Duration
+	maxOps int
+
+	mu      sync.Mutex
+	pending []*pendingOp
+	gets    map[string]*pendingOp
+	timer   *time.Timer
+}
+
+func newBatcher(client *Client, window time.Duration, maxOps int) *batcher {
+	return &batcher{
+		client: client,
+		window: window,
+		maxOps: maxOps,
+		gets:   make(map[string]*pendingOp),
+	}
+}
+
+// enqueue adds op to the open batch and returns the operation to wait on,
+// which for a repeated read is the one already queued.
+func (b *batcher) enqueue(op batchOperation) *pendingOp {
+	b.mu.Lock()
+	defer b.mu.Unlock()
+
+	if op.Type == "get" {
+		if p, ok := b.gets[op.Key]; ok {
+			b.client.metrics.coalesced.Add(1)
+			return p
+		}
+	} else {
+		// Reads queued after a write must see it, so they are not shared
+		// with reads queued before it.
+		delete(b.gets, op.Key)
+	}
+
+	p := &pendingOp{op: op, done: make(chan struct{})}
+	b.pending = append(b.pending, p)
+	if op.Type == "get" {
+		b.gets[op.Key] = p
+	}
+	if len(b.pending) > 1 {
+		b.client.metrics.coalesced.Add(1)
+	}
+
+	if len(b.pending) >= b.maxOps {
+		b.flushLocked()
+	} else if b.timer == nil {
+		b.timer = time.AfterFunc(b.window, b.flush)
+	}
+	return p
+}
+
+// flush sends the open batch, if any.
+func (b *batcher) flush() {
+	b.mu.Lock()
+	defer b.mu.Unlock()
+	b.flushLocked()
+}
+
+func (b *batcher) flushLocked() {
+	if b.timer != nil {
+		b.timer.Stop()
+		b.timer = nil
+	}
+	if len(b.pending) == 0 {
+		return
+	}
+	ops := b.pending
+	b.pending = nil
+	b.gets = make(map[string]*pendingOp)
+	go b.send(ops)
+}
+
+// send posts a batch and hands each operation its result. The request is
+// not tied to any one caller's context: callers that give up stop
+// waiting, but the others still get their results.
+func (b *batcher) send(ops []*pendingOp) {
+	b.client.metrics.batches.Add(1)
+	defer b.client.metrics.record("batch", time.Now())
+
+	req := batchRequest{Operations: make([]batchOperation, len(ops))}
+	for i, p := range ops {
+		req.Operations[i] = p.op
+	}
+
+	results, err := b.client.postBatch(context.Background(), &req)
+	for i, p := range ops {
+		switch {
+		case err != nil:
+			p.err = err
+		case i >= len(results):
+			p.err = fmt.Errorf("batch response has no result for operation %d", i)
+		default:
+			p.value, p.err = operationResult(results[i])
+		}
+		close(p.done)
+	}
+}
+
+// postBatch sends a batch request and returns its per-operation results.
+func (c *Client) postBatch(ctx context.Context, batch *batchRequest) ([]batchResult, error) {
+	req, err := c.newRequest(ctx, "POST", "/api/v1/kv/batch", batch)
+	if err != nil {
+		return nil, err
+	}
+
+	resp, err := c.doRequest(req)
+	if err != nil {
+		return nil, err
+	}
+	defer resp.Body.Close()
+
+	// A non-atomic batch in which some operations failed is 207.
+	if resp.StatusCode != http.StatusOK && resp.StatusCode != http.StatusMultiStatus {
+		return nil, c.handleErrorResponse(resp)
+	}
+
+	var batchResp batchResponse
+	if err := json.NewDecoder(resp.Body).Decode(&batchResp); err != nil {
+		return nil, fmt.Errorf("failed to decode batch response: %w", err)
+	}
+	return batchResp.Results, nil
+}
+
+func operationResult(r batchResult) (string, error) {
+	if !r.Success {
+		if strings.HasPrefix(r.Error, "key not found") {
+			return "", keyNotFound(r.Key)
+		}
+		return "", &MantisError{Code: "OPERATION_FAILED", Message: r.Error}
+	}
+	if r.Value == nil {
+		return "", nil
+	}
+	if s, ok := r.Value.(string); ok {
+		return s, nil
+	}
+	return fmt.Sprint(r.Value), nil
+}
+
+func keyNotFound(key string) error {
+	return &MantisError{
+		Code:    "NOT_FOUND",
+		Message: fmt.Sprintf("key not found: %s", key),
+		Details: map[string]interface{}{"key": key},
+	}
+}
+
+// GetKey returns the value stored under key. A missing key is a
+// MantisError with code NOT_FOUND.
+func (c *Client) GetKey(ctx context.Context, key string) (string, error) {
+	defer c.metrics.record("get_key", time.Now())
+
+	if c.batcher != nil {
+		return c.batcher.enqueue(batchOperation{Type: "get", Key: key}).wait(ctx)
+	}
+
+	req, err := c.newRequest(ctx, "GET", "/api/v1/kv/"+url.PathEscape(key), nil)
+	if err != nil {
+		return "", err
+	}
+
+	resp, err := c.doRequestWithRetry(req)
+	if err != nil {
+		return "", err
+	}
+	defer resp.Body.Close()
+
+	if resp.StatusCode == http.StatusNotFound {
+		return "", keyNotFound(key)
+	}
+	if resp.StatusCode != http.StatusOK {
+		return "", c.handleErrorResponse(resp)
+	}
+
+	var kv struct {
+		Value string `json:"value"`
+	}
+	if err := json.NewDecoder(resp.Body).Decode(&kv); err != nil {
+		return "", fmt.Errorf("failed to decode response: %w", err)
+	}
+	return kv.Value, nil
+}
+
+// SetKey stores value under key. A positive ttl expires it after that
+// long, rounded down to whole seconds.
+func (c *Client) SetKey(ctx context.Context, key, value string, ttl time.Duration) error {
+	defer c.metrics.record("set_key", time.Now())
+
+	op := batchOperation{Type: "set", Key: key, Value: value, TTL: int(ttl / time.Second)}
+	if c.batcher != nil {
+		_, err := c.batcher.enqueue(op).wait(ctx)
+		return err
+	}
+	return c.keyRequest(ctx, "PUT", key, map[string]interface{}{"value": value, "ttl": op.TTL})
+}
+
+// DeleteKey removes key.
+func (c *Client) DeleteKey(ctx context.Context, key string) error {
+	defer c.metrics.record("delete_key", time.Now())
+
+	if c.batcher != nil {
+		_, err := c.batcher.enqueue(batchOperation{Type: "delete", Key: key}).wait(ctx)
+		return err
+	}
+	return c.keyRequest(ctx, "DELETE", key, nil)
+}
+
+func (c *Client) keyRequest(ctx context.Context, method, key string, body interface{}) error {
+	req, err := c.newRequest(ctx, method, "/api/v1/kv/"+url.PathEscape(key), body)
+	if err != nil {
+		return err
+	}
+
+	resp, err := c.doRequestWithRetry(req)
+	if err != nil {
+		return err
+	}
+	defer resp.Body.Close()
+
+	if resp.StatusCode != http.StatusOK {
+		return c.handleErrorResponse(resp)
+	}
+	return nil
+}
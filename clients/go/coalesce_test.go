@@ -0,0 +1,179 @@
+package mantisdb_test
+
+import (
+	"context"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"net"
+	"net/http"
+	"net/http/httptest"
+	"strconv"
+	"sync"
+	"sync/atomic"
+	"testing"
+	"time"
+
+	mantisdb "github.com/mantisdb/mantisdb/clients/go"
+)
+
+// kvServer serves the key-value batch endpoint from a map and counts the
+// requests it receives.
+type kvServer struct {
+	mu       sync.Mutex
+	data     map[string]string
+	batches  atomic.Int64
+	maxBatch atomic.Int64
+}
+
+func (s *kvServer) ServeHTTP(w http.ResponseWriter, r *http.Request) {
+	switch r.URL.Path {
+	case "/api/health":
+		w.WriteHeader(http.StatusOK)
+	case "/api/v1/kv/batch":
+		var req struct {
+			Operations []struct {
+				Type  string `json:"type"`
+				Key   string `json:"key"`
+				Value string `json:"value"`
+			} `json:"operations"`
+		}
+		if err := json.NewDecoder(r.Body).Decode(&req); err != nil {
+			w.WriteHeader(http.StatusBadRequest)
+			return
+		}
+		s.batches.Add(1)
+		if n := int64(len(req.Operations)); n > s.maxBatch.Load() {
+			s.maxBatch.Store(n)
+		}
+
+		s.mu.Lock()
+		results := make([]map[string]interface{}, len(req.Operations))
+		status := http.StatusOK
+		for i, op := range req.Operations {
+			result := map[string]interface{}{"key": op.Key, "success": true}
+			switch op.Type {
+			case "get":
+				if v, ok := s.data[op.Key]; ok {
+					result["value"] = v
+				} else {
+					result["success"] = false
+					result["error"] = "key not found: " + op.Key
+					status = http.StatusMultiStatus
+				}
+			case "set":
+				s.data[op.Key] = op.Value
+			case "delete":
+				delete(s.data, op.Key)
+			}
+			results[i] = result
+		}
+		s.mu.Unlock()
+
+		w.WriteHeader(status)
+		json.NewEncoder(w).Encode(map[string]interface{}{"results": results, "success": true})
+	default:
+		w.WriteHeader(http.StatusNotFound)
+	}
+}
+
+func newCoalescingClient(t *testing.T, srv *kvServer) *mantisdb.Client {
+	ts := httptest.NewServer(srv)
+	t.Cleanup(ts.Close)
+
+	host, port, err := net.SplitHostPort(ts.Listener.Addr().String())
+	if err != nil {
+		t.Fatal(err)
+	}
+	config := mantisdb.DefaultConfig()
+	config.Host = host
+	config.Port, _ = strconv.Atoi(port)
+	config.CoalesceWindow = 20 * time.Millisecond
+	config.MaxBatchSize = 32
+
+	client, err := mantisdb.NewClient(config)
+	if err != nil {
+		t.Fatalf("Failed to create client: %v", err)
+	}
+	t.Cleanup(func() { client.Close() })
+	return client
+}
+
+func TestCoalescedKeyOperations(t *testing.T) {
+	srv := &kvServer{data: map[string]string{}}
+	for i := 0; i < 8; i++ {
+		srv.data[fmt.Sprintf("key-%d", i)] = fmt.Sprintf("value-%d", i)
+	}
+	client := newCoalescingClient(t, srv)
+	ctx := context.Background()
+
+	const callers = 64
+	var wg sync.WaitGroup
+	errs := make(chan error, callers)
+	for i := 0; i < callers; i++ {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			key := fmt.Sprintf("key-%d", i%8)
+			value, err := client.GetKey(ctx, key)
+			if err != nil {
+				errs <- err
+				return
+			}
+			if want := fmt.Sprintf("value-%d", i%8); value != want {
+				errs <- fmt.Errorf("GetKey(%s) = %q, want %q", key, value, want)
+			}
+		}(i)
+	}
+	wg.Wait()
+	close(errs)
+	for err := range errs {
+		t.Error(err)
+	}
+
+	if n := srv.batches.Load(); n >= callers/4 {
+		t.Errorf("%d callers sent %d batch requests", callers, n)
+	}
+	if n := srv.maxBatch.Load(); n > 32 {
+		t.Errorf("batch of %d operations exceeds MaxBatchSize", n)
+	}
+
+	// A read queued after a write in the same batch sees the write.
+	var setErr, getErr error
+	var value string
+	wg.Add(2)
+	go func() {
+		defer wg.Done()
+		setErr = client.SetKey(ctx, "key-0", "updated", 0)
+	}()
+	go func() {
+		defer wg.Done()
+		time.Sleep(2 * time.Millisecond)
+		value, getErr = client.GetKey(ctx, "key-0")
+	}()
+	wg.Wait()
+	if setErr != nil || getErr != nil {
+		t.Fatalf("SetKey: %v, GetKey: %v", setErr, getErr)
+	}
+	if value != "updated" {
+		t.Errorf("GetKey after SetKey = %q, want %q", value, "updated")
+	}
+
+	_, err := client.GetKey(ctx, "missing")
+	var merr *mantisdb.MantisError
+	if !errors.As(err, &merr) || merr.Code != "NOT_FOUND" {
+		t.Errorf("GetKey(missing) error = %v, want NOT_FOUND", err)
+	}
+
+	stats := client.GetConnectionStats()
+	latency := stats.Latency["get_key"]
+	if latency.Count != callers+2 {
+		t.Errorf("get_key latency count = %d, want %d", latency.Count, callers+2)
+	}
+	if latency.P50 > latency.P99 || latency.P99 > latency.Max || latency.Max == 0 {
+		t.Errorf("inconsistent percentiles: %+v", latency)
+	}
+	if stats.Batches == 0 || stats.CoalescedOps == 0 {
+		t.Errorf("batch counters not recorded: %+v", stats)
+	}
+}
@@ -0,0 +1,136 @@
+package mantisdb
+
+import (
+	"math"
+	"math/bits"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+// Latencies are kept in log-linear buckets: each power of two of
+// microseconds is split into eight buckets, so a percentile read from the
+// histogram is within 12.5% of the true value. Recording is a handful of
+// atomic adds and never blocks.
+const (
+	subBucketBits = 3
+	subBuckets    = 1 << subBucketBits
+	numBuckets    = (64 - subBucketBits + 1) * subBuckets
+)
+
+// latencyHistogram counts request latencies in microseconds.
+type latencyHistogram struct {
+	buckets [numBuckets]atomic.Uint64
+	count   atomic.Uint64
+	sum     atomic.Uint64
+	max     atomic.Uint64
+}
+
+func bucketIndex(v uint64) int {
+	if v < subBuckets {
+		return int(v)
+	}
+	exp := bits.Len64(v) - 1
+	sub := (v >> (exp - subBucketBits)) & (subBuckets - 1)
+	return (exp-subBucketBits+1)*subBuckets + int(sub)
+}
+
+// bucketUpper returns the largest value that falls in bucket i.
+func bucketUpper(i int) uint64 {
+	if i < subBuckets {
+		return uint64(i)
+	}
+	exp := i/subBuckets + subBucketBits - 1
+	sub := uint64(i % subBuckets)
+	width := uint64(1) << (exp - subBucketBits)
+	return (subBuckets+sub)*width + width - 1
+}
+
+func (h *latencyHistogram) record(d time.Duration) {
+	us := uint64(0)
+	if d > 0 {
+		us = uint64(d / time.Microsecond)
+	}
+	h.buckets[bucketIndex(us)].Add(1)
+	h.count.Add(1)
+	h.sum.Add(us)
+	for {
+		cur := h.max.Load()
+		if us <= cur || h.max.CompareAndSwap(cur, us) {
+			return
+		}
+	}
+}
+
+// LatencyStats summarizes the latencies of one kind of operation.
+type LatencyStats struct {
+	Count uint64        `json:"count"`
+	Mean  time.Duration `json:"mean"`
+	P50   time.Duration `json:"p50"`
+	P90   time.Duration `json:"p90"`
+	P99   time.Duration `json:"p99"`
+	Max   time.Duration `json:"max"`
+}
+
+// snapshot reads the histogram. Operations recorded while it runs may be
+// partly counted, which only skews percentiles by those few samples.
+func (h *latencyHistogram) snapshot() LatencyStats {
+	var counts [numBuckets]uint64
+	var total uint64
+	for i := range h.buckets {
+		counts[i] = h.buckets[i].Load()
+		total += counts[i]
+	}
+	if total == 0 {
+		return LatencyStats{}
+	}
+
+	maxUs := h.max.Load()
+	quantile := func(q float64) time.Duration {
+		rank := uint64(math.Ceil(q * float64(total)))
+		var seen uint64
+		for i, n := range counts {
+			seen += n
+			if seen >= rank {
+				return time.Duration(min(bucketUpper(i), maxUs)) * time.Microsecond
+			}
+		}
+		return time.Duration(maxUs) * time.Microsecond
+	}
+
+	return LatencyStats{
+		Count: total,
+		Mean:  time.Duration(h.sum.Load()/total) * time.Microsecond,
+		P50:   quantile(0.50),
+		P90:   quantile(0.90),
+		P99:   quantile(0.99),
+		Max:   time.Duration(maxUs) * time.Microsecond,
+	}
+}
+
+// clientMetrics holds a latency histogram per operation and the batching
+// counters.
+type clientMetrics struct {
+	latency   sync.Map // operation name -> *latencyHistogram
+	batches   atomic.Uint64
+	coalesced atomic.Uint64
+}
+
+// record adds the time since start to op's histogram. It is meant to be
+// deferred: defer c.metrics.record("query", time.Now()).
+func (m *clientMetrics) record(op string, start time.Time) {
+	h, ok := m.latency.Load(op)
+	if !ok {
+		h, _ = m.latency.LoadOrStore(op, &latencyHistogram{})
+	}
+	h.(*latencyHistogram).record(time.Since(start))
+}
+
+func (m *clientMetrics) latencies() map[string]LatencyStats {
+	stats := make(map[string]LatencyStats)
+	m.latency.Range(func(key, value interface{}) bool {
+		stats[key.(string)] = value.(*latencyHistogram).snapshot()
+		return true
+	})
+	return stats
+}
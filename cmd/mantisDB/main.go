@@ -20,10 +20,12 @@ import (
 	"mantisDB/cache"
 	"mantisDB/config"
 	"mantisDB/health"
+	"mantisDB/pkg/sql"
 	"mantisDB/query"
 	"mantisDB/shutdown"
 	"mantisDB/storage"
 	"mantisDB/store"
+	"mantisDB/transaction"
 )
 
 var (
@@ -94,6 +96,7 @@ type MantisDB struct {
 	queryOptimizer  *query.QueryOptimizer
 	queryExecutor   *query.QueryExecutor
 	store           *store.MantisStore
+	sqlEngine       *sql.SQLEngine
 	apiServer       *api.Server
 	adminServerProc *os.Process // Rust admin-server process
 	healthChecker   *health.HealthChecker
@@ -616,6 +619,12 @@ func (db *MantisDB) registerStartupFunctions() {
 			return fmt.Errorf("failed to initialize storage engine: %v", err)
 		}
 
+		// The SQL engine loads its statistics and indexes from storage, so
+		// it is created once storage is open
+		sqlStorage := sql.NewStorageManager(newSQLKVStore(db.storageEngine), nil, nil)
+		db.sqlEngine = sql.NewSQLEngine(sqlStorage, transaction.NewTransactionSystem(nil), sql.DefaultSQLEngineConfig())
+		db.apiServer.SetSQLEngine(db.sqlEngine)
+
 		return nil
 	})
 
@@ -727,8 +736,16 @@ func (db *MantisDB) registerShutdownFunctions() {
 		return nil
 	})
 
-	// 4. Close storage engine (lowest priority)
-	db.shutdownManager.RegisterShutdownFunc("storage", 4, func(ctx context.Context) error {
+	// 4. Stop SQL engine before the storage it runs on
+	db.shutdownManager.RegisterShutdownFunc("sql", 4, func(ctx context.Context) error {
+		if db.sqlEngine != nil {
+			return db.sqlEngine.Shutdown(ctx)
+		}
+		return nil
+	})
+
+	// 5. Close storage engine (lowest priority)
+	db.shutdownManager.RegisterShutdownFunc("storage", 5, func(ctx context.Context) error {
 		if db.storageEngine != nil {
 			return db.storageEngine.Close()
 		}
@@ -0,0 +1,107 @@
+package main
+
+import (
+	"bytes"
+	"context"
+
+	"mantisDB/pkg/sql"
+	"mantisDB/storage"
+)
+
+// sqlKVStore lets the SQL engine keep its tables in the storage engine
+// that serves the KV API.
+type sqlKVStore struct {
+	engine storage.StorageEngine
+}
+
+func newSQLKVStore(engine storage.StorageEngine) *sqlKVStore {
+	return &sqlKVStore{engine: engine}
+}
+
+func (s *sqlKVStore) Get(ctx context.Context, key []byte) ([]byte, error) {
+	value, err := s.engine.Get(ctx, string(key))
+	if err != nil {
+		return nil, err
+	}
+	return []byte(value), nil
+}
+
+func (s *sqlKVStore) Put(ctx context.Context, key, value []byte) error {
+	return s.engine.Put(ctx, string(key), string(value))
+}
+
+func (s *sqlKVStore) Delete(ctx context.Context, key []byte) error {
+	return s.engine.Delete(ctx, string(key))
+}
+
+// Scan iterates the keys in [startKey, endKey). The storage engine scans by
+// prefix, so it iterates the prefix the two bounds share and filters.
+func (s *sqlKVStore) Scan(ctx context.Context, startKey, endKey []byte) (sql.Iterator, error) {
+	n := 0
+	for n < len(startKey) && n < len(endKey) && startKey[n] == endKey[n] {
+		n++
+	}
+	it, err := s.engine.NewIterator(ctx, string(startKey[:n]))
+	if err != nil {
+		return nil, err
+	}
+	return &sqlKVIterator{it: it, start: startKey, end: endKey}, nil
+}
+
+func (s *sqlKVStore) BatchGet(ctx context.Context, keys [][]byte) ([][]byte, error) {
+	names := make([]string, len(keys))
+	for i, key := range keys {
+		names[i] = string(key)
+	}
+	found, err := s.engine.BatchGet(ctx, names)
+	if err != nil {
+		return nil, err
+	}
+	values := make([][]byte, len(keys))
+	for i, name := range names {
+		if value, ok := found[name]; ok {
+			values[i] = []byte(value)
+		}
+	}
+	return values, nil
+}
+
+func (s *sqlKVStore) BatchPut(ctx context.Context, kvPairs []sql.KVPair) error {
+	pairs := make(map[string]string, len(kvPairs))
+	for _, kv := range kvPairs {
+		pairs[string(kv.Key)] = string(kv.Value)
+	}
+	return s.engine.BatchPut(ctx, pairs)
+}
+
+// sqlKVIterator yields the storage iterator's entries within the scan
+// bounds.
+type sqlKVIterator struct {
+	it         storage.Iterator
+	start, end []byte
+	key, value []byte
+}
+
+func (i *sqlKVIterator) Next() bool {
+	for i.it.Next() {
+		key := []byte(i.it.Key())
+		if bytes.Compare(key, i.start) < 0 || (len(i.end) > 0 && bytes.Compare(key, i.end) >= 0) {
+			continue
+		}
+		i.key, i.value = key, []byte(i.it.Value())
+		return true
+	}
+	return false
+}
+
+func (i *sqlKVIterator) Value() ([]byte, []byte, error) {
+	return i.key, i.value, nil
+}
+
+func (i *sqlKVIterator) Error() error {
+	return i.it.Error()
+}
+
+func (i *sqlKVIterator) Close() error {
+	return i.it.Close()
+}
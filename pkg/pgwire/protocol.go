@@ -0,0 +1,226 @@
+// Package pgwire serves the SQL engine over the PostgreSQL v3 frontend/
+// backend protocol, so existing PostgreSQL drivers can talk to MantisDB
+// over persistent connections instead of HTTP/JSON.
+package pgwire
+
+import (
+	"bufio"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"io"
+)
+
+// Startup codes sent in place of a protocol version.
+const (
+	protocolVersion3   = 196608
+	sslRequestCode     = 80877103
+	gssEncRequestCode  = 80877104
+	cancelRequestCode  = 80877102
+	defaultMaxMessage  = 64 << 20
+	minStartupLength   = 8
+	maxStartupLength   = 10000
+	messageHeaderBytes = 5
+)
+
+// Frontend message types.
+const (
+	msgQuery     = 'Q'
+	msgParse     = 'P'
+	msgBind      = 'B'
+	msgDescribe  = 'D'
+	msgExecute   = 'E'
+	msgSync      = 'S'
+	msgFlush     = 'H'
+	msgClose     = 'C'
+	msgTerminate = 'X'
+	msgPassword  = 'p'
+)
+
+// Backend message types.
+const (
+	msgAuthentication       = 'R'
+	msgParameterStatus      = 'S'
+	msgBackendKeyData       = 'K'
+	msgReadyForQuery        = 'Z'
+	msgRowDescription       = 'T'
+	msgDataRow              = 'D'
+	msgCommandComplete      = 'C'
+	msgEmptyQueryResponse   = 'I'
+	msgErrorResponse        = 'E'
+	msgParseComplete        = '1'
+	msgBindComplete         = '2'
+	msgCloseComplete        = '3'
+	msgNoData               = 'n'
+	msgParameterDescription = 't'
+	msgPortalSuspended      = 's'
+)
+
+var errMalformed = errors.New("malformed message")
+
+// messageReader reads frontend messages into a buffer reused across
+// messages, so bodies are only valid until the next read.
+type messageReader struct {
+	r       *bufio.Reader
+	buf     []byte
+	maxSize int
+}
+
+// readStartup reads a startup-phase message, which has no type byte.
+func (mr *messageReader) readStartup() ([]byte, error) {
+	var header [4]byte
+	if _, err := io.ReadFull(mr.r, header[:]); err != nil {
+		return nil, err
+	}
+	length := int(binary.BigEndian.Uint32(header[:]))
+	if length < minStartupLength || length > maxStartupLength {
+		return nil, fmt.Errorf("invalid startup message length %d", length)
+	}
+	return mr.readBody(length - 4)
+}
+
+// readMessage reads a typed message.
+func (mr *messageReader) readMessage() (byte, []byte, error) {
+	var header [messageHeaderBytes]byte
+	if _, err := io.ReadFull(mr.r, header[:]); err != nil {
+		return 0, nil, err
+	}
+	length := int(binary.BigEndian.Uint32(header[1:]))
+	if length < 4 || length-4 > mr.maxSize {
+		return 0, nil, fmt.Errorf("invalid message length %d", length)
+	}
+	body, err := mr.readBody(length - 4)
+	return header[0], body, err
+}
+
+func (mr *messageReader) readBody(n int) ([]byte, error) {
+	if cap(mr.buf) < n {
+		mr.buf = make([]byte, n)
+	}
+	mr.buf = mr.buf[:n]
+	_, err := io.ReadFull(mr.r, mr.buf)
+	return mr.buf, err
+}
+
+// message decodes the fields of a message body in order. The first
+// decoding error sticks, so callers check err once at the end.
+type message struct {
+	data []byte
+	err  error
+}
+
+func (m *message) byte() byte {
+	if m.err != nil || len(m.data) < 1 {
+		m.err = errMalformed
+		return 0
+	}
+	b := m.data[0]
+	m.data = m.data[1:]
+	return b
+}
+
+func (m *message) int16() int16 {
+	if m.err != nil || len(m.data) < 2 {
+		m.err = errMalformed
+		return 0
+	}
+	v := int16(binary.BigEndian.Uint16(m.data))
+	m.data = m.data[2:]
+	return v
+}
+
+func (m *message) int32() int32 {
+	if m.err != nil || len(m.data) < 4 {
+		m.err = errMalformed
+		return 0
+	}
+	v := int32(binary.BigEndian.Uint32(m.data))
+	m.data = m.data[4:]
+	return v
+}
+
+// string reads a NUL-terminated string.
+func (m *message) string() string {
+	if m.err != nil {
+		return ""
+	}
+	for i, b := range m.data {
+		if b == 0 {
+			s := string(m.data[:i])
+			m.data = m.data[i+1:]
+			return s
+		}
+	}
+	m.err = errMalformed
+	return ""
+}
+
+// bytes returns the next n bytes without copying them.
+func (m *message) bytes(n int) []byte {
+	if m.err != nil || n < 0 || len(m.data) < n {
+		m.err = errMalformed
+		return nil
+	}
+	b := m.data[:n]
+	m.data = m.data[n:]
+	return b
+}
+
+// formatCodes reads a count followed by that many format codes.
+func (m *message) formatCodes() []int16 {
+	n := int(m.int16())
+	if m.err != nil || n < 0 || len(m.data) < 2*n {
+		m.err = errMalformed
+		return nil
+	}
+	codes := make([]int16, n)
+	for i := range codes {
+		codes[i] = m.int16()
+	}
+	return codes
+}
+
+// messageWriter builds backend messages in a scratch buffer and copies
+// them into the connection's write buffer, which is flushed only when the
+// client waits for an answer. Pipelined requests thus share writes.
+type messageWriter struct {
+	w   *bufio.Writer
+	buf []byte
+}
+
+func (mw *messageWriter) start(typ byte) {
+	mw.buf = append(mw.buf[:0], typ, 0, 0, 0, 0)
+}
+
+func (mw *messageWriter) byte(b byte) {
+	mw.buf = append(mw.buf, b)
+}
+
+func (mw *messageWriter) int16(v int16) {
+	mw.buf = binary.BigEndian.AppendUint16(mw.buf, uint16(v))
+}
+
+func (mw *messageWriter) int32(v int32) {
+	mw.buf = binary.BigEndian.AppendUint32(mw.buf, uint32(v))
+}
+
+func (mw *messageWriter) string(s string) {
+	mw.buf = append(mw.buf, s...)
+	mw.buf = append(mw.buf, 0)
+}
+
+func (mw *messageWriter) finish() error {
+	binary.BigEndian.PutUint32(mw.buf[1:], uint32(len(mw.buf)-1))
+	_, err := mw.w.Write(mw.buf)
+	return err
+}
+
+// simple writes a message with an empty body.
+func (mw *messageWriter) simple(typ byte) error {
+	mw.start(typ)
+	return mw.finish()
+}
+
+func (mw *messageWriter) flush() error {
+	return mw.w.Flush()
+}
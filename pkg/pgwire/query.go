@@ -0,0 +1,117 @@
+package pgwire
+
+import (
+	"strconv"
+	"strings"
+
+	"mantisDB/pkg/sql"
+)
+
+// splitStatements splits the text of a simple query at semicolons outside
+// quotes and comments, dropping empty statements.
+func splitStatements(text string) []string {
+	var statements []string
+	start := 0
+	for i := 0; i < len(text); i++ {
+		switch text[i] {
+		case '\'', '"':
+			quote := text[i]
+			for i++; i < len(text); i++ {
+				if text[i] == quote {
+					// A doubled quote is an escaped one.
+					if i+1 < len(text) && text[i+1] == quote {
+						i++
+						continue
+					}
+					break
+				}
+			}
+		case '-':
+			if i+1 < len(text) && text[i+1] == '-' {
+				for i < len(text) && text[i] != '\n' {
+					i++
+				}
+			}
+		case '/':
+			if i+1 < len(text) && text[i+1] == '*' {
+				end := strings.Index(text[i+2:], "*/")
+				if end < 0 {
+					i = len(text)
+				} else {
+					i += end + 3
+				}
+			}
+		case ';':
+			if stmt := strings.TrimSpace(text[start:i]); stmt != "" {
+				statements = append(statements, stmt)
+			}
+			start = i + 1
+		}
+	}
+	if start < len(text) {
+		if stmt := strings.TrimSpace(text[start:]); stmt != "" {
+			statements = append(statements, stmt)
+		}
+	}
+	return statements
+}
+
+// firstKeywords returns the first n words of a statement in upper case.
+func firstKeywords(query string, n int) []string {
+	fields := strings.Fields(strings.TrimLeft(query, "( \t\r\n"))
+	if len(fields) > n {
+		fields = fields[:n]
+	}
+	for i, f := range fields {
+		fields[i] = strings.ToUpper(strings.TrimRight(f, ";("))
+	}
+	return fields
+}
+
+// returnsRows reports whether a statement produces a result set.
+func returnsRows(query string) bool {
+	words := firstKeywords(query, 1)
+	if len(words) == 0 {
+		return false
+	}
+	switch words[0] {
+	case "SELECT", "WITH", "VALUES", "SHOW", "EXPLAIN", "TABLE":
+		return true
+	}
+	return false
+}
+
+// commandTag builds the CommandComplete tag PostgreSQL sends for a
+// statement, such as "SELECT 3" or "INSERT 0 1".
+func commandTag(query string, rows int, stream *sql.SQLStream) string {
+	words := firstKeywords(query, 2)
+	if len(words) == 0 {
+		return ""
+	}
+	var affected int64
+	if stream != nil {
+		affected = stream.RowsAffected()
+	}
+	switch words[0] {
+	case "SELECT", "WITH", "VALUES", "TABLE":
+		return "SELECT " + strconv.Itoa(rows)
+	case "INSERT":
+		return "INSERT 0 " + strconv.FormatInt(affected, 10)
+	case "UPDATE", "DELETE":
+		return words[0] + " " + strconv.FormatInt(affected, 10)
+	case "START":
+		return "BEGIN"
+	case "END":
+		return "COMMIT"
+	case "ABORT":
+		return "ROLLBACK"
+	case "CREATE", "DROP", "ALTER":
+		if len(words) > 1 {
+			if words[1] == "UNIQUE" {
+				return words[0] + " INDEX"
+			}
+			return words[0] + " " + words[1]
+		}
+	}
+	return words[0]
+}
@@ -0,0 +1,216 @@
+package pgwire
+
+import (
+	"bufio"
+	"context"
+	"crypto/rand"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"io"
+	"log"
+	"net"
+	"sync"
+	"time"
+
+	"mantisDB/pkg/sql"
+)
+
+// Config holds settings for the PostgreSQL protocol listener.
+type Config struct {
+	Addr string
+	// Authenticate, when set, asks clients for a password and admits them
+	// only if it returns nil. Without it every client is trusted.
+	Authenticate func(user, password string) error
+	// MaxMessageSize bounds a single frontend message.
+	MaxMessageSize int
+	// BufferSize is the size of each connection's read and write buffers.
+	BufferSize int
+}
+
+// DefaultConfig returns the default listener configuration.
+func DefaultConfig() *Config {
+	return &Config{
+		Addr:           ":5432",
+		MaxMessageSize: defaultMaxMessage,
+		BufferSize:     32 * 1024,
+	}
+}
+
+// Server accepts PostgreSQL protocol connections and runs their
+// statements on a SQL engine. Each client connection keeps one engine
+// connection, so transactions span statements as they do over psql.
+type Server struct {
+	engine   *sql.SQLEngine
+	config   *Config
+	listener net.Listener
+	ctx      context.Context
+	cancel   context.CancelFunc
+
+	mu       sync.Mutex
+	sessions map[uint32]*session
+	nextPID  uint32
+	wg       sync.WaitGroup
+}
+
+// NewServer creates a PostgreSQL protocol server for engine.
+func NewServer(engine *sql.SQLEngine, config *Config) *Server {
+	if config == nil {
+		config = DefaultConfig()
+	}
+	if config.MaxMessageSize <= 0 {
+		config.MaxMessageSize = defaultMaxMessage
+	}
+	if config.BufferSize <= 0 {
+		config.BufferSize = 32 * 1024
+	}
+	ctx, cancel := context.WithCancel(context.Background())
+	return &Server{
+		engine:   engine,
+		config:   config,
+		ctx:      ctx,
+		cancel:   cancel,
+		sessions: make(map[uint32]*session),
+	}
+}
+
+// Start listens on the configured address and serves until Stop.
+func (s *Server) Start() error {
+	listener, err := net.Listen("tcp", s.config.Addr)
+	if err != nil {
+		return fmt.Errorf("failed to listen on %s: %w", s.config.Addr, err)
+	}
+	return s.Serve(listener)
+}
+
+// Serve accepts connections on listener until Stop.
+func (s *Server) Serve(listener net.Listener) error {
+	s.mu.Lock()
+	s.listener = listener
+	s.mu.Unlock()
+
+	for {
+		conn, err := listener.Accept()
+		if err != nil {
+			if s.ctx.Err() != nil {
+				return nil
+			}
+			var ne net.Error
+			if errors.As(err, &ne) && ne.Timeout() {
+				time.Sleep(10 * time.Millisecond)
+				continue
+			}
+			return err
+		}
+		s.wg.Add(1)
+		go func() {
+			defer s.wg.Done()
+			s.ServeConn(conn)
+		}()
+	}
+}
+
+// Addr returns the address the server listens on, once it does.
+func (s *Server) Addr() net.Addr {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.listener == nil {
+		return nil
+	}
+	return s.listener.Addr()
+}
+
+// Stop closes the listener and every client connection, cancelling the
+// statements they run, and waits for the sessions to end.
+func (s *Server) Stop(ctx context.Context) error {
+	s.cancel()
+	s.mu.Lock()
+	if s.listener != nil {
+		s.listener.Close()
+	}
+	for _, sess := range s.sessions {
+		sess.conn.Close()
+	}
+	s.mu.Unlock()
+
+	done := make(chan struct{})
+	go func() {
+		s.wg.Wait()
+		close(done)
+	}()
+	select {
+	case <-done:
+		return nil
+	case <-ctx.Done():
+		return ctx.Err()
+	}
+}
+
+// ServeConn runs the protocol on one client connection until it ends.
+func (s *Server) ServeConn(conn net.Conn) {
+	defer conn.Close()
+
+	sess := &session{
+		server:     s,
+		conn:       conn,
+		reader:     messageReader{r: bufio.NewReaderSize(conn, s.config.BufferSize), maxSize: s.config.MaxMessageSize},
+		writer:     messageWriter{w: bufio.NewWriterSize(conn, s.config.BufferSize)},
+		statements: make(map[string]*statement),
+		portals:    make(map[string]*portal),
+	}
+	if err := sess.startup(); err != nil {
+		if !errors.Is(err, errCancelRequest) {
+			sess.sendError(err)
+			sess.writer.flush()
+		}
+		return
+	}
+	defer s.unregister(sess)
+	defer sess.close()
+
+	if err := sess.serve(); err != nil && s.ctx.Err() == nil && !isDisconnect(err) {
+		log.Printf("pgwire: connection from %s: %v", conn.RemoteAddr(), err)
+	}
+}
+
+// register assigns a session the process ID and secret a client quotes
+// to cancel its queries.
+func (s *Server) register(sess *session) error {
+	var secret [4]byte
+	if _, err := rand.Read(secret[:]); err != nil {
+		return err
+	}
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.ctx.Err() != nil {
+		return errors.New("server is shutting down")
+	}
+	s.nextPID++
+	sess.pid = s.nextPID
+	sess.secret = binary.BigEndian.Uint32(secret[:])
+	s.sessions[sess.pid] = sess
+	return nil
+}
+
+func (s *Server) unregister(sess *session) {
+	s.mu.Lock()
+	delete(s.sessions, sess.pid)
+	s.mu.Unlock()
+}
+
+// cancelQuery handles a CancelRequest, which arrives on its own
+// connection. Requests quoting the wrong secret are ignored, as
+// PostgreSQL does.
+func (s *Server) cancelQuery(pid, secret uint32) {
+	s.mu.Lock()
+	sess := s.sessions[pid]
+	s.mu.Unlock()
+	if sess != nil && sess.secret == secret {
+		sess.cancelRunning()
+	}
+}
+
+func isDisconnect(err error) bool {
+	return errors.Is(err, net.ErrClosed) || errors.Is(err, errTerminated) ||
+		errors.Is(err, io.EOF) || errors.Is(err, io.ErrUnexpectedEOF)
+}
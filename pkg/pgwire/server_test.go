@@ -0,0 +1,496 @@
+package pgwire
+
+import (
+	"bufio"
+	"bytes"
+	"context"
+	"encoding/binary"
+	"fmt"
+	"io"
+	"net"
+	"sort"
+	"strings"
+	"testing"
+	"time"
+
+	"mantisDB/pkg/sql"
+	"mantisDB/transaction"
+)
+
+// kvStore is a read-mostly in-memory KV engine for the tests.
+type kvStore struct {
+	keys   []string
+	values map[string][]byte
+}
+
+func (s *kvStore) Get(ctx context.Context, key []byte) ([]byte, error) {
+	if v, ok := s.values[string(key)]; ok {
+		return v, nil
+	}
+	return nil, fmt.Errorf("key not found")
+}
+
+func (s *kvStore) Put(ctx context.Context, key, value []byte) error {
+	if _, ok := s.values[string(key)]; !ok {
+		s.keys = append(s.keys, string(key))
+		sort.Strings(s.keys)
+	}
+	s.values[string(key)] = value
+	return nil
+}
+
+func (s *kvStore) Delete(ctx context.Context, key []byte) error {
+	delete(s.values, string(key))
+	return nil
+}
+
+func (s *kvStore) Scan(ctx context.Context, startKey, endKey []byte) (sql.Iterator, error) {
+	it := &kvIterator{store: s, pos: -1}
+	for _, k := range s.keys {
+		if k >= string(startKey) && k < string(endKey) {
+			it.keys = append(it.keys, k)
+		}
+	}
+	return it, nil
+}
+
+func (s *kvStore) BatchGet(ctx context.Context, keys [][]byte) ([][]byte, error) {
+	out := make([][]byte, len(keys))
+	for i, k := range keys {
+		out[i] = s.values[string(k)]
+	}
+	return out, nil
+}
+
+func (s *kvStore) BatchPut(ctx context.Context, pairs []sql.KVPair) error {
+	for _, kv := range pairs {
+		s.Put(ctx, kv.Key, kv.Value)
+	}
+	return nil
+}
+
+type kvIterator struct {
+	store *kvStore
+	keys  []string
+	pos   int
+}
+
+func (it *kvIterator) Next() bool { it.pos++; return it.pos < len(it.keys) }
+func (it *kvIterator) Value() ([]byte, []byte, error) {
+	k := it.keys[it.pos]
+	return []byte(k), it.store.values[k], nil
+}
+func (it *kvIterator) Error() error { return nil }
+func (it *kvIterator) Close() error { return nil }
+
+// startServer serves an engine over kv_users (5 rows) and kv_events
+// (2500 rows) on a loopback port.
+func startServer(t *testing.T, config *Config) *Server {
+	t.Helper()
+	kv := &kvStore{values: make(map[string][]byte)}
+	for i, name := range []string{"alice", "bob", "carol", "dave", "erin"} {
+		kv.Put(context.Background(), []byte(fmt.Sprintf("kv_users/%d", i)), []byte(name))
+	}
+	for i := 0; i < 2500; i++ {
+		kv.Put(context.Background(), []byte(fmt.Sprintf("kv_events/%05d", i)), []byte(fmt.Sprint(i%7)))
+	}
+	engine := sql.NewSQLEngine(sql.NewStorageManager(kv, nil, nil), transaction.NewTransactionSystem(nil), nil)
+
+	listener, err := net.Listen("tcp", "127.0.0.1:0")
+	if err != nil {
+		t.Fatal(err)
+	}
+	srv := NewServer(engine, config)
+	go srv.Serve(listener)
+	t.Cleanup(func() {
+		ctx, cancel := context.WithTimeout(context.Background(), 5*time.Second)
+		defer cancel()
+		if err := srv.Stop(ctx); err != nil {
+			t.Errorf("stop: %v", err)
+		}
+	})
+	for srv.Addr() == nil {
+		time.Sleep(time.Millisecond)
+	}
+	return srv
+}
+
+// testClient speaks just enough of the frontend protocol for the tests.
+type testClient struct {
+	t      *testing.T
+	conn   net.Conn
+	r      *bufio.Reader
+	out    []byte
+	pid    uint32
+	secret uint32
+}
+
+func dial(t *testing.T, srv *Server, password string) *testClient {
+	t.Helper()
+	conn, err := net.Dial("tcp", srv.Addr().String())
+	if err != nil {
+		t.Fatal(err)
+	}
+	conn.SetDeadline(time.Now().Add(10 * time.Second))
+	t.Cleanup(func() { conn.Close() })
+	c := &testClient{t: t, conn: conn, r: bufio.NewReader(conn)}
+
+	body := binary.BigEndian.AppendUint32(nil, protocolVersion3)
+	body = append(body, "user\x00tester\x00database\x00mantis\x00\x00"...)
+	conn.Write(append(binary.BigEndian.AppendUint32(nil, uint32(len(body)+4)), body...))
+	for {
+		typ, msg := c.recv()
+		switch typ {
+		case msgAuthentication:
+			if binary.BigEndian.Uint32(msg) == 3 {
+				c.send(msgPassword, []byte(password+"\x00"))
+				c.flush()
+			}
+		case msgBackendKeyData:
+			c.pid, c.secret = binary.BigEndian.Uint32(msg), binary.BigEndian.Uint32(msg[4:])
+		case msgReadyForQuery:
+			return c
+		case msgErrorResponse:
+			t.Fatalf("startup failed: %s", errorCode(msg))
+		}
+	}
+}
+
+// send queues a message; flush writes everything queued at once, so a
+// sequence of sends is one pipelined write.
+func (c *testClient) send(typ byte, body []byte) {
+	c.out = append(c.out, typ)
+	c.out = binary.BigEndian.AppendUint32(c.out, uint32(len(body)+4))
+	c.out = append(c.out, body...)
+}
+
+func (c *testClient) flush() {
+	if _, err := c.conn.Write(c.out); err != nil {
+		c.t.Fatal(err)
+	}
+	c.out = c.out[:0]
+}
+
+func (c *testClient) recv() (byte, []byte) {
+	c.t.Helper()
+	var header [5]byte
+	if _, err := io.ReadFull(c.r, header[:]); err != nil {
+		c.t.Fatalf("read: %v", err)
+	}
+	body := make([]byte, binary.BigEndian.Uint32(header[1:])-4)
+	if _, err := io.ReadFull(c.r, body); err != nil {
+		c.t.Fatalf("read: %v", err)
+	}
+	return header[0], body
+}
+
+// collect reads messages up to and including ReadyForQuery and summarizes
+// them: a DataRow as its text-format values, CommandComplete as its tag,
+// ErrorResponse as its SQLSTATE and ReadyForQuery as its status.
+func (c *testClient) collect() []string {
+	c.t.Helper()
+	var got []string
+	for {
+		typ, body := c.recv()
+		switch typ {
+		case msgDataRow:
+			got = append(got, "D "+strings.Join(dataRow(body), ","))
+		case msgCommandComplete:
+			got = append(got, "C "+strings.TrimRight(string(body), "\x00"))
+		case msgErrorResponse:
+			got = append(got, "E "+errorCode(body))
+		case msgReadyForQuery:
+			return append(got, "Z "+string(body))
+		default:
+			got = append(got, string(typ))
+		}
+	}
+}
+
+// rowDescription returns the field names of a RowDescription.
+func rowDescription(body []byte) []string {
+	m := message{data: body}
+	names := make([]string, m.int16())
+	for i := range names {
+		names[i] = m.string()
+		m.bytes(18) // table, column, type, size, modifier and format
+	}
+	return names
+}
+
+func dataRow(body []byte) []string {
+	m := message{data: body}
+	values := make([]string, m.int16())
+	for i := range values {
+		if n := m.int32(); n >= 0 {
+			values[i] = string(m.bytes(int(n)))
+		} else {
+			values[i] = "NULL"
+		}
+	}
+	return values
+}
+
+func errorCode(body []byte) string {
+	for m := (message{data: body}); m.err == nil; {
+		field := m.byte()
+		if field == 0 {
+			break
+		}
+		value := m.string()
+		if field == 'C' {
+			return value
+		}
+	}
+	return ""
+}
+
+func cstring(parts ...string) []byte {
+	var b []byte
+	for _, p := range parts {
+		b = append(append(b, p...), 0)
+	}
+	return b
+}
+
+func parseMsg(name, query string, oids ...uint32) []byte {
+	b := cstring(name, query)
+	b = binary.BigEndian.AppendUint16(b, uint16(len(oids)))
+	for _, oid := range oids {
+		b = binary.BigEndian.AppendUint32(b, oid)
+	}
+	return b
+}
+
+func bindMsg(portal, stmt string, params ...string) []byte {
+	b := cstring(portal, stmt)
+	b = binary.BigEndian.AppendUint16(b, 0)
+	b = binary.BigEndian.AppendUint16(b, uint16(len(params)))
+	for _, p := range params {
+		b = binary.BigEndian.AppendUint32(b, uint32(len(p)))
+		b = append(b, p...)
+	}
+	return binary.BigEndian.AppendUint16(b, 0)
+}
+
+func executeMsg(portal string, maxRows int) []byte {
+	return binary.BigEndian.AppendUint32(cstring(portal), uint32(maxRows))
+}
+
+func expect(t *testing.T, got []string, want ...string) {
+	t.Helper()
+	if strings.Join(got, "|") != strings.Join(want, "|") {
+		t.Errorf("got  %q\nwant %q", got, want)
+	}
+}
+
+func TestSimpleQueryProtocol(t *testing.T) {
+	srv := startServer(t, nil)
+	c := dial(t, srv, "")
+
+	c.send(msgQuery, cstring("SELECT * FROM kv_users WHERE data = 'bob'; SELECT * FROM kv_users WHERE data > 'c'"))
+	c.flush()
+	expect(t, c.collect(),
+		"T", "D kv_users/1,bob", "C SELECT 1",
+		"T", "D kv_users/2,carol", "D kv_users/3,dave", "D kv_users/4,erin", "C SELECT 3",
+		"Z I")
+
+	c.send(msgQuery, cstring("BEGIN"))
+	c.send(msgQuery, cstring("SELECT * FROM kv_users WHERE data = 'erin'"))
+	c.send(msgQuery, cstring("COMMIT"))
+	c.send(msgQuery, cstring("SELEC oops"))
+	c.send(msgQuery, cstring(" ; "))
+	c.flush()
+	expect(t, c.collect(), "C BEGIN", "Z T")
+	expect(t, c.collect(), "T", "D kv_users/4,erin", "C SELECT 1", "Z T")
+	expect(t, c.collect(), "C COMMIT", "Z I")
+	expect(t, c.collect(), "E "+codeSyntaxError, "Z I")
+	expect(t, c.collect(), "I", "Z I")
+}
+
+func TestRowDescriptionFollowsSelectList(t *testing.T) {
+	srv := startServer(t, nil)
+	c := dial(t, srv, "")
+
+	// fields reads up to ReadyForQuery and returns the field names of each
+	// RowDescription together with the DataRows.
+	fields := func() []string {
+		t.Helper()
+		var got []string
+		for {
+			typ, body := c.recv()
+			switch typ {
+			case msgRowDescription:
+				got = append(got, "T "+strings.Join(rowDescription(body), ","))
+			case msgDataRow:
+				got = append(got, "D "+strings.Join(dataRow(body), ","))
+			case msgErrorResponse:
+				got = append(got, "E "+errorCode(body))
+			case msgReadyForQuery:
+				return got
+			}
+		}
+	}
+
+	c.send(msgQuery, cstring("SELECT id FROM kv_users WHERE data = 'bob'; SELECT data, id FROM kv_users WHERE data = 'erin'"))
+	c.flush()
+	expect(t, fields(), "T id", "D kv_users/1", "T data,id", "D erin,kv_users/4")
+
+	// Describe reports the projected columns before anything runs
+	c.send(msgParse, parseMsg("names", "SELECT data FROM kv_users WHERE id = $1", oidText))
+	c.send(msgDescribe, cstring("Snames"))
+	c.send(msgBind, bindMsg("", "names", "kv_users/2"))
+	c.send(msgExecute, executeMsg("", 0))
+	c.send(msgSync, nil)
+	c.flush()
+	expect(t, fields(), "T data", "D carol")
+}
+
+func TestExtendedQueryPipeline(t *testing.T) {
+	srv := startServer(t, nil)
+	c := dial(t, srv, "")
+
+	c.send(msgParse, parseMsg("by_name", "SELECT * FROM kv_users WHERE data = $1", oidText))
+	c.send(msgDescribe, cstring("Sby_name"))
+	c.send(msgSync, nil)
+	c.flush()
+	expect(t, c.collect(), "1", "t", "T", "Z I")
+
+	// Several executions pipelined in one write, answered in one batch.
+	for _, name := range []string{"alice", "dave", "zed"} {
+		c.send(msgBind, bindMsg("", "by_name", name))
+		c.send(msgExecute, executeMsg("", 0))
+	}
+	c.send(msgSync, nil)
+	c.flush()
+	expect(t, c.collect(),
+		"2", "D kv_users/0,alice", "C SELECT 1",
+		"2", "D kv_users/3,dave", "C SELECT 1",
+		"2", "C SELECT 0",
+		"Z I")
+
+	// A row limit suspends the portal until the next Execute.
+	c.send(msgParse, parseMsg("", "SELECT * FROM kv_users"))
+	c.send(msgBind, bindMsg("p", ""))
+	c.send(msgExecute, executeMsg("p", 2))
+	c.send(msgExecute, executeMsg("p", 0))
+	c.send(msgSync, nil)
+	c.flush()
+	expect(t, c.collect(),
+		"1", "2", "D kv_users/0,alice", "D kv_users/1,bob", "s",
+		"D kv_users/2,carol", "D kv_users/3,dave", "D kv_users/4,erin", "C SELECT 3",
+		"Z I")
+
+	// After an error the rest of the pipeline is skipped until Sync.
+	c.send(msgBind, bindMsg("", "missing"))
+	c.send(msgExecute, executeMsg("", 0))
+	c.send(msgSync, nil)
+	c.send(msgBind, bindMsg("", "by_name", "bob"))
+	c.send(msgExecute, executeMsg("", 0))
+	c.send(msgSync, nil)
+	c.flush()
+	expect(t, c.collect(), "E "+codeUndefinedStatement, "Z I")
+	expect(t, c.collect(), "2", "D kv_users/1,bob", "C SELECT 1", "Z I")
+}
+
+func TestCancelRequest(t *testing.T) {
+	srv := startServer(t, nil)
+	c := dial(t, srv, "")
+
+	c.send(msgParse, parseMsg("", "SELECT * FROM kv_events"))
+	c.send(msgBind, bindMsg("", ""))
+	c.send(msgExecute, executeMsg("", 1))
+	c.send(msgFlush, nil)
+	c.flush()
+	for _, want := range []byte{msgParseComplete, msgBindComplete, msgDataRow, msgPortalSuspended} {
+		if typ, _ := c.recv(); typ != want {
+			t.Fatalf("got %q, want %q", typ, want)
+		}
+	}
+
+	// The cancel request arrives on a connection of its own, which the
+	// server closes once it has acted on it.
+	cancel, err := net.Dial("tcp", srv.Addr().String())
+	if err != nil {
+		t.Fatal(err)
+	}
+	body := binary.BigEndian.AppendUint32(nil, cancelRequestCode)
+	body = binary.BigEndian.AppendUint32(body, c.pid)
+	body = binary.BigEndian.AppendUint32(body, c.secret)
+	cancel.Write(append(binary.BigEndian.AppendUint32(nil, uint32(len(body)+4)), body...))
+	io.Copy(io.Discard, cancel)
+	cancel.Close()
+
+	c.send(msgExecute, executeMsg("", 0))
+	c.send(msgSync, nil)
+	c.flush()
+	got := c.collect()
+	if len(got) < 2 || got[len(got)-2] != "E "+codeQueryCanceled {
+		t.Fatalf("cancelled portal ended with %q", got[max(len(got)-3, 0):])
+	}
+	if len(got) != 2 {
+		t.Errorf("cancelled portal sent %d more rows", len(got)-2)
+	}
+
+	// The session keeps working after the cancel.
+	c.send(msgQuery, cstring("SELECT * FROM kv_users WHERE data = 'alice'"))
+	c.flush()
+	expect(t, c.collect(), "T", "D kv_users/0,alice", "C SELECT 1", "Z I")
+}
+
+func TestPasswordAuthentication(t *testing.T) {
+	srv := startServer(t, &Config{Authenticate: func(user, password string) error {
+		if user == "tester" && password == "secret" {
+			return nil
+		}
+		return fmt.Errorf("bad password")
+	}})
+	dial(t, srv, "secret")
+
+	conn, err := net.Dial("tcp", srv.Addr().String())
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer conn.Close()
+	c := &testClient{t: t, conn: conn, r: bufio.NewReader(conn)}
+	body := binary.BigEndian.AppendUint32(nil, protocolVersion3)
+	body = append(body, "user\x00tester\x00\x00"...)
+	conn.Write(append(binary.BigEndian.AppendUint32(nil, uint32(len(body)+4)), body...))
+	c.recv()
+	c.send(msgPassword, cstring("wrong"))
+	c.flush()
+	if typ, body := c.recv(); typ != msgErrorResponse || errorCode(body) != codeInvalidPassword {
+		t.Errorf("wrong password answered with %q %s", typ, errorCode(body))
+	}
+}
+
+func TestValueEncoding(t *testing.T) {
+	ts := time.Date(2024, 3, 1, 12, 30, 0, 0, time.UTC)
+	for _, v := range []any{int64(-42), 2.5, true, "héllo", []byte{0, 1, 2}, ts} {
+		oid, _ := valueOID(v)
+		bin, err := appendBinary(nil, oid, v)
+		if err != nil {
+			t.Fatalf("%v: %v", v, err)
+		}
+		back, err := decodeParam(oid, formatBinary, bin)
+		if err != nil || fmt.Sprint(back) != fmt.Sprint(v) {
+			t.Errorf("binary %v round-tripped to %v, %v", v, back, err)
+		}
+		back, err = decodeParam(oid, formatText, appendText(nil, v))
+		if err != nil || fmt.Sprint(back) != fmt.Sprint(v) {
+			t.Errorf("text %v round-tripped to %v, %v", v, back, err)
+		}
+	}
+	if _, err := appendBinary(nil, oidInt4, int64(1)<<40); err == nil {
+		t.Error("int4 accepted an out-of-range value")
+	}
+	if got := string(appendText(nil, map[string]any{"a": 1})); got != `{"a":1}` {
+		t.Errorf("document encoded as %s", got)
+	}
+	if !bytes.Equal(appendText(nil, []byte{0xab}), []byte(`\xab`)) {
+		t.Error("bytea text format")
+	}
+	if got := splitStatements("SELECT ';' ; -- x;\nSELECT 2 /* ; */;"); len(got) != 2 {
+		t.Errorf("split into %q", got)
+	}
+}
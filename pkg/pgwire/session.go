@@ -0,0 +1,787 @@
+package pgwire
+
+import (
+	"context"
+	"errors"
+	"fmt"
+	"net"
+	"strings"
+	"sync"
+
+	"mantisDB/pkg/sql"
+)
+
+var (
+	errCancelRequest = errors.New("cancel request")
+	errTerminated    = errors.New("client terminated the session")
+)
+
+// pgError is an error reported to the client with a SQLSTATE code.
+type pgError struct {
+	code    string
+	message string
+}
+
+func (e *pgError) Error() string { return e.message }
+
+func newError(code, format string, args ...any) error {
+	return &pgError{code: code, message: fmt.Sprintf(format, args...)}
+}
+
+// SQLSTATE codes used by the server.
+const (
+	codeProtocolViolation     = "08P01"
+	codeFeatureNotSupported   = "0A000"
+	codeInvalidPassword       = "28P01"
+	codeSyntaxError           = "42601"
+	codeDuplicateStatement    = "42P05"
+	codeUndefinedStatement    = "26000"
+	codeUndefinedCursor       = "34000"
+	codeQueryCanceled         = "57014"
+	codeIdleSessionTimeout    = "25P03"
+	codeInvalidTextValue      = "22P02"
+	codeInternalError         = "XX000"
+	codeAdminShutdown         = "57P01"
+	codeInvalidParameterCount = "08P01"
+)
+
+// statement is a prepared statement of one session. Statements the engine
+// cannot prepare, such as BEGIN, are kept as text and run unprepared.
+type statement struct {
+	query       string
+	id          string // engine statement ID; empty when run as text
+	empty       bool
+	returnsRows bool
+	paramOIDs   []uint32
+	columns     []sql.ColumnInfo
+}
+
+// portal is a statement bound to parameters. Its stream stays open while
+// the portal is suspended by an Execute row limit.
+type portal struct {
+	stmt          *statement
+	params        []any
+	resultFormats []int16
+	oids          []uint32
+	stream        *sql.SQLStream
+	ctx           context.Context
+	pending       []sql.Row
+	done          bool
+}
+
+// session is one client connection.
+type session struct {
+	server *Server
+	conn   net.Conn
+	reader messageReader
+	writer messageWriter
+	pid    uint32
+	secret uint32
+
+	connID     string
+	user       string
+	inTxn      bool
+	statements map[string]*statement
+	portals    map[string]*portal
+	// ignoring is set after an error in an extended-query exchange;
+	// messages are skipped until the next Sync.
+	ignoring bool
+
+	runMu       sync.Mutex
+	queryCtx    context.Context
+	cancelQuery context.CancelFunc
+}
+
+// startup negotiates the protocol, authenticates the client and opens
+// its engine connection.
+func (sess *session) startup() error {
+	for {
+		body, err := sess.reader.readStartup()
+		if err != nil {
+			return err
+		}
+		m := message{data: body}
+		switch code := m.int32(); code {
+		case sslRequestCode, gssEncRequestCode:
+			// Encryption is not offered; the client continues in plain text.
+			if _, err := sess.conn.Write([]byte{'N'}); err != nil {
+				return err
+			}
+		case cancelRequestCode:
+			pid, secret := m.int32(), m.int32()
+			if m.err == nil {
+				sess.server.cancelQuery(uint32(pid), uint32(secret))
+			}
+			return errCancelRequest
+		case protocolVersion3:
+			params := make(map[string]string)
+			for len(m.data) > 1 && m.err == nil {
+				key := m.string()
+				params[key] = m.string()
+			}
+			if m.err != nil {
+				return newError(codeProtocolViolation, "invalid startup packet")
+			}
+			return sess.open(params)
+		default:
+			return newError(codeFeatureNotSupported, "unsupported frontend protocol %d.%d", code>>16, code&0xffff)
+		}
+	}
+}
+
+func (sess *session) open(params map[string]string) error {
+	sess.user = params["user"]
+	if auth := sess.server.config.Authenticate; auth != nil {
+		sess.writer.start(msgAuthentication)
+		sess.writer.int32(3) // cleartext password
+		if err := sess.writer.finish(); err != nil {
+			return err
+		}
+		if err := sess.writer.flush(); err != nil {
+			return err
+		}
+		typ, body, err := sess.reader.readMessage()
+		if err != nil {
+			return err
+		}
+		m := message{data: body}
+		password := m.string()
+		if typ != msgPassword || m.err != nil {
+			return newError(codeProtocolViolation, "expected password message")
+		}
+		if err := auth(sess.user, password); err != nil {
+			return newError(codeInvalidPassword, "password authentication failed for user %q", sess.user)
+		}
+	}
+
+	conn, err := sess.server.engine.CreateConnection(sess.user, params["database"])
+	if err != nil {
+		return err
+	}
+	sess.connID = conn.ID
+	if err := sess.server.register(sess); err != nil {
+		sess.server.engine.CloseConnection(sess.connID)
+		return newError(codeAdminShutdown, "%v", err)
+	}
+
+	w := &sess.writer
+	w.start(msgAuthentication)
+	w.int32(0) // AuthenticationOk
+	w.finish()
+	for _, kv := range [][2]string{
+		{"server_version", "14.0"},
+		{"server_encoding", "UTF8"},
+		{"client_encoding", "UTF8"},
+		{"DateStyle", "ISO, MDY"},
+		{"TimeZone", "UTC"},
+		{"integer_datetimes", "on"},
+		{"standard_conforming_strings", "on"},
+		{"application_name", params["application_name"]},
+	} {
+		w.start(msgParameterStatus)
+		w.string(kv[0])
+		w.string(kv[1])
+		w.finish()
+	}
+	w.start(msgBackendKeyData)
+	w.int32(int32(sess.pid))
+	w.int32(int32(sess.secret))
+	w.finish()
+	return sess.readyForQuery()
+}
+
+func (sess *session) close() {
+	for name := range sess.portals {
+		sess.closePortal(name)
+	}
+	sess.server.engine.CloseConnection(sess.connID)
+	sess.cancelRunning()
+}
+
+// serve reads messages until the client terminates. Responses are
+// buffered until the client waits for them at a Sync, Flush or the end of
+// a simple query, so a pipeline of extended-query messages costs one
+// write.
+func (sess *session) serve() error {
+	for {
+		typ, body, err := sess.reader.readMessage()
+		if err != nil {
+			return err
+		}
+		if sess.ignoring && typ != msgSync && typ != msgTerminate {
+			continue
+		}
+
+		m := &message{data: body}
+		switch typ {
+		case msgQuery:
+			err = sess.simpleQuery(m)
+		case msgParse:
+			err = sess.parse(m)
+		case msgBind:
+			err = sess.bind(m)
+		case msgDescribe:
+			err = sess.describe(m)
+		case msgExecute:
+			err = sess.execute(m)
+		case msgClose:
+			err = sess.closeMessage(m)
+		case msgSync:
+			err = sess.sync()
+		case msgFlush:
+			err = sess.writer.flush()
+		case msgTerminate:
+			return errTerminated
+		default:
+			err = newError(codeProtocolViolation, "unsupported message type %q", typ)
+		}
+		if err == nil {
+			continue
+		}
+
+		var pe *pgError
+		if !errors.As(err, &pe) && isDisconnect(err) {
+			return err
+		}
+		if werr := sess.sendError(err); werr != nil {
+			return werr
+		}
+		if typ == msgQuery {
+			if err := sess.readyForQuery(); err != nil {
+				return err
+			}
+		} else {
+			sess.ignoring = true
+		}
+	}
+}
+
+// simpleQuery runs each statement of a Query message in turn, stopping at
+// the first error.
+func (sess *session) simpleQuery(m *message) error {
+	text := m.string()
+	if m.err != nil {
+		return newError(codeProtocolViolation, "invalid Query message")
+	}
+	// A simple query ends any unnamed portal left by the extended protocol.
+	sess.closePortal("")
+
+	queries := splitStatements(text)
+	if len(queries) == 0 {
+		if err := sess.writer.simple(msgEmptyQueryResponse); err != nil {
+			return err
+		}
+		return sess.readyForQuery()
+	}
+	for _, query := range queries {
+		if err := sess.ensureConnection(); err != nil {
+			return err
+		}
+		ctx := sess.queryContext()
+		stream, err := sess.server.engine.ExecuteSQLStream(ctx, sess.connID, query)
+		if err != nil {
+			return err
+		}
+		p := &portal{stmt: &statement{query: query, returnsRows: returnsRows(query)}, stream: stream, ctx: ctx}
+		if p.stmt.returnsRows {
+			if err := sess.peek(p); err != nil {
+				p.close()
+				return err
+			}
+			if err := sess.sendRowDescription(p.stream.Columns(), p.oids, nil); err != nil {
+				p.close()
+				return err
+			}
+		}
+		err = sess.sendRows(p, 0)
+		p.close()
+		if err != nil {
+			return err
+		}
+	}
+	return sess.readyForQuery()
+}
+
+// parse handles Parse, preparing the statement with the engine.
+func (sess *session) parse(m *message) error {
+	name, query := m.string(), m.string()
+	oids := make([]uint32, m.int16())
+	for i := range oids {
+		oids[i] = uint32(m.int32())
+	}
+	if m.err != nil {
+		return newError(codeProtocolViolation, "invalid Parse message")
+	}
+	if _, exists := sess.statements[name]; exists && name != "" {
+		return newError(codeDuplicateStatement, "prepared statement %q already exists", name)
+	}
+
+	stmt := &statement{query: query}
+	if strings.TrimSpace(strings.TrimRight(strings.TrimSpace(query), ";")) == "" {
+		stmt.empty = true
+	} else if err := sess.prepare(stmt, oids); err != nil {
+		return err
+	}
+	sess.statements[name] = stmt
+	return sess.writer.simple(msgParseComplete)
+}
+
+// prepare registers stmt with the engine and works out its parameter and
+// result types.
+func (sess *session) prepare(stmt *statement, oids []uint32) error {
+	engine := sess.server.engine
+	stmt.returnsRows = returnsRows(stmt.query)
+	ps, err := engine.Prepare(stmt.query)
+	if err != nil {
+		// Transaction control and DDL cannot be prepared; run them as text.
+		if _, perr := sql.ParseSQL(stmt.query); perr == nil && len(oids) == 0 {
+			return nil
+		}
+		return newError(codeSyntaxError, "%v", err)
+	}
+	stmt.id = ps.ID
+	stmt.paramOIDs = make([]uint32, ps.ParamCount)
+	copy(stmt.paramOIDs, oids)
+	if stmt.returnsRows {
+		if stmt.columns, err = engine.DescribePrepared(ps.ID); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// bind handles Bind, creating a portal. The statement runs at the first
+// Describe or Execute of the portal.
+func (sess *session) bind(m *message) error {
+	portalName, stmtName := m.string(), m.string()
+	paramFormats := m.formatCodes()
+	values := make([][]byte, m.int16())
+	for i := range values {
+		if n := m.int32(); n >= 0 {
+			values[i] = m.bytes(int(n))
+		}
+	}
+	resultFormats := m.formatCodes()
+	if m.err != nil {
+		return newError(codeProtocolViolation, "invalid Bind message")
+	}
+
+	stmt, exists := sess.statements[stmtName]
+	if !exists {
+		return newError(codeUndefinedStatement, "prepared statement %q does not exist", stmtName)
+	}
+	if len(values) != len(stmt.paramOIDs) {
+		return newError(codeInvalidParameterCount, "bind message supplies %d parameters, but prepared statement %q requires %d", len(values), stmtName, len(stmt.paramOIDs))
+	}
+	if len(paramFormats) > 1 && len(paramFormats) != len(values) {
+		return newError(codeProtocolViolation, "bind message has %d parameter formats but %d parameters", len(paramFormats), len(values))
+	}
+
+	params := make([]any, len(values))
+	for i, value := range values {
+		format := formatText
+		if len(paramFormats) == 1 {
+			format = paramFormats[0]
+		} else if len(paramFormats) > 1 {
+			format = paramFormats[i]
+		}
+		v, err := decodeParam(stmt.paramOIDs[i], format, value)
+		if err != nil {
+			return newError(codeInvalidTextValue, "parameter $%d: %v", i+1, err)
+		}
+		params[i] = v
+	}
+
+	sess.closePortal(portalName)
+	p := &portal{stmt: stmt, params: params, resultFormats: resultFormats}
+	if stmt.returnsRows {
+		p.oids = declaredOIDs(stmt.columns)
+	}
+	sess.portals[portalName] = p
+	return sess.writer.simple(msgBindComplete)
+}
+
+// describe handles Describe of a statement or a portal.
+func (sess *session) describe(m *message) error {
+	kind, name := m.byte(), m.string()
+	if m.err != nil {
+		return newError(codeProtocolViolation, "invalid Describe message")
+	}
+
+	switch kind {
+	case 'S':
+		stmt, exists := sess.statements[name]
+		if !exists {
+			return newError(codeUndefinedStatement, "prepared statement %q does not exist", name)
+		}
+		w := &sess.writer
+		w.start(msgParameterDescription)
+		w.int16(int16(len(stmt.paramOIDs)))
+		for _, oid := range stmt.paramOIDs {
+			if oid == oidUnspecified {
+				oid = oidText
+			}
+			w.int32(int32(oid))
+		}
+		if err := w.finish(); err != nil {
+			return err
+		}
+		if !stmt.returnsRows {
+			return w.simple(msgNoData)
+		}
+		return sess.sendRowDescription(stmt.columns, declaredOIDs(stmt.columns), nil)
+	case 'P':
+		p, exists := sess.portals[name]
+		if !exists {
+			return newError(codeUndefinedCursor, "portal %q does not exist", name)
+		}
+		if !p.stmt.returnsRows {
+			return sess.writer.simple(msgNoData)
+		}
+		// Column types come from the first rows when there are any, so
+		// the portal starts running here.
+		if err := sess.start(p); err != nil {
+			return err
+		}
+		if err := sess.peek(p); err != nil {
+			return err
+		}
+		return sess.sendRowDescription(p.stream.Columns(), p.oids, p.resultFormats)
+	default:
+		return newError(codeProtocolViolation, "invalid Describe kind %q", kind)
+	}
+}
+
+// execute handles Execute, sending at most maxRows rows when it is
+// positive and suspending the portal if the limit is reached.
+func (sess *session) execute(m *message) error {
+	name, maxRows := m.string(), m.int32()
+	if m.err != nil {
+		return newError(codeProtocolViolation, "invalid Execute message")
+	}
+	p, exists := sess.portals[name]
+	if !exists {
+		return newError(codeUndefinedCursor, "portal %q does not exist", name)
+	}
+	if p.stmt.empty {
+		return sess.writer.simple(msgEmptyQueryResponse)
+	}
+	if err := sess.start(p); err != nil {
+		return err
+	}
+	return sess.sendRows(p, int(maxRows))
+}
+
+// closeMessage handles Close of a statement or a portal. Engine statements
+// are shared by every client preparing the same text, so closing only
+// forgets the session's name for one.
+func (sess *session) closeMessage(m *message) error {
+	kind, name := m.byte(), m.string()
+	if m.err != nil {
+		return newError(codeProtocolViolation, "invalid Close message")
+	}
+	switch kind {
+	case 'S':
+		delete(sess.statements, name)
+	case 'P':
+		sess.closePortal(name)
+	default:
+		return newError(codeProtocolViolation, "invalid Close kind %q", kind)
+	}
+	return sess.writer.simple(msgCloseComplete)
+}
+
+// sync ends an extended-query exchange. Outside an explicit transaction
+// each exchange is its own transaction, so open portals close with it.
+func (sess *session) sync() error {
+	sess.ignoring = false
+	if !sess.server.engine.InTransaction(sess.connID) {
+		for name := range sess.portals {
+			sess.closePortal(name)
+		}
+	}
+	return sess.readyForQuery()
+}
+
+// start runs a portal's statement if it has not run yet.
+func (sess *session) start(p *portal) error {
+	if p.stream != nil || p.done {
+		return nil
+	}
+	if err := sess.ensureConnection(); err != nil {
+		return err
+	}
+	engine := sess.server.engine
+	ctx := sess.queryContext()
+	p.ctx = ctx
+	if p.stmt.id == "" {
+		stream, err := engine.ExecuteSQLStream(ctx, sess.connID, p.stmt.query)
+		p.stream = stream
+		return err
+	}
+	stream, err := engine.ExecutePreparedStream(ctx, sess.connID, p.stmt.id, p.params)
+	if errors.Is(err, sql.ErrPreparedStatementNotFound) {
+		// Another client deallocated the shared statement.
+		if _, err := engine.Prepare(p.stmt.query); err != nil {
+			return err
+		}
+		stream, err = engine.ExecutePreparedStream(ctx, sess.connID, p.stmt.id, p.params)
+	}
+	p.stream = stream
+	return err
+}
+
+// queryContext returns the context statements run under. A cancel request
+// cancels it, stopping whatever the session is running, including
+// suspended portals, and later statements get a fresh one.
+func (sess *session) queryContext() context.Context {
+	sess.runMu.Lock()
+	defer sess.runMu.Unlock()
+	if sess.queryCtx == nil || sess.queryCtx.Err() != nil {
+		sess.queryCtx, sess.cancelQuery = context.WithCancel(sess.server.ctx)
+	}
+	return sess.queryCtx
+}
+
+func (sess *session) cancelRunning() {
+	sess.runMu.Lock()
+	defer sess.runMu.Unlock()
+	if sess.cancelQuery != nil {
+		sess.cancelQuery()
+	}
+}
+
+// peek reads the first batch of a portal so its rows can decide the types
+// of columns.
+func (sess *session) peek(p *portal) error {
+	if p.pending != nil || p.done {
+		return nil
+	}
+	columns := p.stream.Columns()
+	if len(p.oids) != len(columns) {
+		p.oids = declaredOIDs(columns)
+	}
+	batch, err := p.stream.Next()
+	if err != nil {
+		return err
+	}
+	if batch == nil {
+		p.pending = []sql.Row{}
+		return nil
+	}
+	p.pending = batch.Rows
+	for i := range p.oids {
+		for _, row := range p.pending {
+			if i < len(row.Values) {
+				if oid, ok := valueOID(row.Values[i]); ok {
+					p.oids[i] = oid
+					break
+				}
+			}
+		}
+	}
+	return nil
+}
+
+// sendRows sends a portal's rows, at most maxRows when it is positive,
+// then CommandComplete, or PortalSuspended if rows may remain.
+func (sess *session) sendRows(p *portal, maxRows int) error {
+	if p.done {
+		return sess.commandComplete(p, 0)
+	}
+	// Rows already read are not sent once the statement is cancelled.
+	if p.ctx != nil && p.ctx.Err() != nil {
+		return p.ctx.Err()
+	}
+	sent := 0
+	if p.stmt.returnsRows {
+		columns := p.stream.Columns()
+		if len(p.oids) != len(columns) {
+			p.oids = declaredOIDs(columns)
+		}
+		for maxRows <= 0 || sent < maxRows {
+			if len(p.pending) == 0 {
+				batch, err := p.stream.Next()
+				if err != nil {
+					return err
+				}
+				if batch == nil {
+					break
+				}
+				p.pending = batch.Rows
+				continue
+			}
+			if err := sess.sendDataRow(p, p.pending[0]); err != nil {
+				return err
+			}
+			p.pending = p.pending[1:]
+			sent++
+		}
+		if maxRows > 0 && sent == maxRows {
+			return sess.writer.simple(msgPortalSuspended)
+		}
+	}
+	// Closing the stream commits an auto-commit transaction, which can
+	// still fail.
+	p.done = true
+	err := p.stream.Close()
+	if err != nil {
+		return err
+	}
+	return sess.commandComplete(p, sent)
+}
+
+func (sess *session) sendDataRow(p *portal, row sql.Row) error {
+	w := &sess.writer
+	w.start(msgDataRow)
+	w.int16(int16(len(p.oids)))
+	for i, oid := range p.oids {
+		var v any
+		if i < len(row.Values) {
+			v = row.Values[i]
+		}
+		if v == nil {
+			w.int32(-1)
+			continue
+		}
+		lenAt := len(w.buf)
+		w.int32(0)
+		if resultFormat(p.resultFormats, i) == formatBinary {
+			buf, err := appendBinary(w.buf, oid, v)
+			if err != nil {
+				return newError(codeInternalError, "column %d: %v", i+1, err)
+			}
+			w.buf = buf
+		} else {
+			w.buf = appendText(w.buf, v)
+		}
+		n := len(w.buf) - lenAt - 4
+		w.buf[lenAt], w.buf[lenAt+1], w.buf[lenAt+2], w.buf[lenAt+3] = byte(n>>24), byte(n>>16), byte(n>>8), byte(n)
+	}
+	return w.finish()
+}
+
+func (sess *session) sendRowDescription(columns []sql.ColumnInfo, oids []uint32, formats []int16) error {
+	w := &sess.writer
+	w.start(msgRowDescription)
+	w.int16(int16(len(columns)))
+	for i, col := range columns {
+		oid := declaredOID(col.Type)
+		if i < len(oids) {
+			oid = oids[i]
+		}
+		w.string(col.Name)
+		w.int32(0) // table OID
+		w.int16(0) // column number
+		w.int32(int32(oid))
+		w.int16(typeSize(oid))
+		w.int32(-1) // type modifier
+		w.int16(resultFormat(formats, i))
+	}
+	return w.finish()
+}
+
+func (sess *session) commandComplete(p *portal, rows int) error {
+	w := &sess.writer
+	w.start(msgCommandComplete)
+	w.string(commandTag(p.stmt.query, rows, p.stream))
+	return w.finish()
+}
+
+func (sess *session) readyForQuery() error {
+	sess.inTxn = sess.server.engine.InTransaction(sess.connID)
+	status := byte('I')
+	if sess.inTxn {
+		status = 'T'
+	}
+	w := &sess.writer
+	w.start(msgReadyForQuery)
+	w.byte(status)
+	if err := w.finish(); err != nil {
+		return err
+	}
+	return w.flush()
+}
+
+func (sess *session) sendError(err error) error {
+	code := codeInternalError
+	var pe *pgError
+	switch {
+	case errors.As(err, &pe):
+		code = pe.code
+	case errors.Is(err, context.Canceled):
+		code = codeQueryCanceled
+		err = errors.New("canceling statement due to user request")
+	case errors.Is(err, sql.ErrPreparedStatementNotFound):
+		code = codeUndefinedStatement
+	case strings.HasPrefix(err.Error(), "parse error"):
+		code = codeSyntaxError
+	}
+	w := &sess.writer
+	w.start(msgErrorResponse)
+	w.byte('S')
+	w.string("ERROR")
+	w.byte('V')
+	w.string("ERROR")
+	w.byte('C')
+	w.string(code)
+	w.byte('M')
+	w.string(err.Error())
+	w.byte(0)
+	return w.finish()
+}
+
+// ensureConnection replaces an engine connection the engine closed for
+// being idle. A transaction it held was rolled back, which the client
+// must hear about.
+func (sess *session) ensureConnection() error {
+	engine := sess.server.engine
+	if _, err := engine.GetConnectionInfo(sess.connID); err == nil {
+		return nil
+	}
+	conn, err := engine.CreateConnection(sess.user, "")
+	if err != nil {
+		return err
+	}
+	sess.connID = conn.ID
+	if sess.inTxn {
+		sess.inTxn = false
+		return newError(codeIdleSessionTimeout, "terminating transaction due to idle timeout")
+	}
+	return nil
+}
+
+func (sess *session) closePortal(name string) {
+	if p, exists := sess.portals[name]; exists {
+		p.close()
+		delete(sess.portals, name)
+	}
+}
+
+func (p *portal) close() {
+	if p.stream != nil && !p.done {
+		p.stream.Close()
+	}
+	p.done = true
+}
+
+func declaredOIDs(columns []sql.ColumnInfo) []uint32 {
+	oids := make([]uint32, len(columns))
+	for i, col := range columns {
+		oids[i] = declaredOID(col.Type)
+	}
+	return oids
+}
+
+func resultFormat(formats []int16, i int) int16 {
+	switch len(formats) {
+	case 0:
+		return formatText
+	case 1:
+		return formats[0]
+	}
+	if i < len(formats) {
+		return formats[i]
+	}
+	return formatText
+}
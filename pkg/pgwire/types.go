@@ -0,0 +1,360 @@
+package pgwire
+
+import (
+	"encoding/binary"
+	"encoding/hex"
+	"encoding/json"
+	"fmt"
+	"math"
+	"strconv"
+	"strings"
+	"time"
+
+	"mantisDB/pkg/sql"
+)
+
+// Type OIDs from PostgreSQL's pg_type catalog.
+const (
+	oidUnspecified uint32 = 0
+	oidBool        uint32 = 16
+	oidBytea       uint32 = 17
+	oidInt8        uint32 = 20
+	oidInt2        uint32 = 21
+	oidInt4        uint32 = 23
+	oidText        uint32 = 25
+	oidJSON        uint32 = 114
+	oidFloat4      uint32 = 700
+	oidFloat8      uint32 = 701
+	oidVarchar     uint32 = 1043
+	oidTimestamp   uint32 = 1114
+	oidTimestamptz uint32 = 1184
+	oidNumeric     uint32 = 1700
+)
+
+const (
+	formatText   int16 = 0
+	formatBinary int16 = 1
+)
+
+// postgresEpoch is the zero point of binary timestamps.
+var postgresEpoch = time.Date(2000, 1, 1, 0, 0, 0, 0, time.UTC)
+
+// declaredOID maps a column's declared SQL type to a type OID. DECIMAL
+// and NUMERIC values are float64 in the engine, so they go out as float8.
+func declaredOID(t sql.DataType) uint32 {
+	switch strings.ToUpper(t.Name) {
+	case "BOOL", "BOOLEAN":
+		return oidBool
+	case "SMALLINT", "INT2":
+		return oidInt2
+	case "INT", "INTEGER", "INT4":
+		return oidInt4
+	case "BIGINT", "INT8":
+		return oidInt8
+	case "REAL", "FLOAT4":
+		return oidFloat4
+	case "FLOAT", "DOUBLE", "DOUBLE PRECISION", "FLOAT8", "DECIMAL", "NUMERIC":
+		return oidFloat8
+	case "VARCHAR", "CHARACTER VARYING":
+		return oidVarchar
+	case "BYTEA", "BLOB", "BINARY", "VARBINARY":
+		return oidBytea
+	case "TIMESTAMP", "DATETIME":
+		return oidTimestamp
+	case "TIMESTAMPTZ":
+		return oidTimestamptz
+	case "JSON", "JSONB":
+		return oidJSON
+	default:
+		return oidText
+	}
+}
+
+// valueOID returns the type OID that describes v. Column metadata is not
+// always accurate (a KV table's id column holds the string key), so when
+// rows are at hand their values decide the column type.
+func valueOID(v any) (uint32, bool) {
+	switch v.(type) {
+	case nil:
+		return 0, false
+	case bool:
+		return oidBool, true
+	case int8, int16, uint8:
+		return oidInt2, true
+	case int32, uint16:
+		return oidInt4, true
+	case int, int64, uint32, uint, uint64:
+		return oidInt8, true
+	case float32:
+		return oidFloat4, true
+	case float64:
+		return oidFloat8, true
+	case []byte:
+		return oidBytea, true
+	case time.Time:
+		return oidTimestamptz, true
+	case string:
+		return oidText, true
+	case map[string]any, []any:
+		return oidJSON, true
+	default:
+		return oidText, true
+	}
+}
+
+// typeSize is pg_type.typlen: the fixed width of a type, or -1.
+func typeSize(oid uint32) int16 {
+	switch oid {
+	case oidBool:
+		return 1
+	case oidInt2:
+		return 2
+	case oidInt4, oidFloat4:
+		return 4
+	case oidInt8, oidFloat8, oidTimestamp, oidTimestamptz:
+		return 8
+	default:
+		return -1
+	}
+}
+
+// appendText appends the text format of v.
+func appendText(buf []byte, v any) []byte {
+	switch x := v.(type) {
+	case string:
+		return append(buf, x...)
+	case bool:
+		if x {
+			return append(buf, 't')
+		}
+		return append(buf, 'f')
+	case int:
+		return strconv.AppendInt(buf, int64(x), 10)
+	case int64:
+		return strconv.AppendInt(buf, x, 10)
+	case float64:
+		return appendFloat(buf, x, 64)
+	case float32:
+		return appendFloat(buf, float64(x), 32)
+	case []byte:
+		buf = append(buf, `\x`...)
+		return append(buf, hex.EncodeToString(x)...)
+	case time.Time:
+		return x.AppendFormat(buf, "2006-01-02 15:04:05.999999-07:00")
+	case map[string]any, []any:
+		b, err := json.Marshal(x)
+		if err != nil {
+			return fmt.Append(buf, x)
+		}
+		return append(buf, b...)
+	default:
+		if n, ok := toInt64(v); ok {
+			return strconv.AppendInt(buf, n, 10)
+		}
+		return fmt.Append(buf, x)
+	}
+}
+
+func appendFloat(buf []byte, f float64, bits int) []byte {
+	switch {
+	case math.IsNaN(f):
+		return append(buf, "NaN"...)
+	case math.IsInf(f, 1):
+		return append(buf, "Infinity"...)
+	case math.IsInf(f, -1):
+		return append(buf, "-Infinity"...)
+	}
+	return strconv.AppendFloat(buf, f, 'g', -1, bits)
+}
+
+// appendBinary appends the binary format of v as type oid, failing when
+// v cannot be represented as that type.
+func appendBinary(buf []byte, oid uint32, v any) ([]byte, error) {
+	switch oid {
+	case oidBool:
+		if b, ok := v.(bool); ok {
+			if b {
+				return append(buf, 1), nil
+			}
+			return append(buf, 0), nil
+		}
+	case oidInt2, oidInt4, oidInt8:
+		n, ok := toInt64(v)
+		if !ok {
+			break
+		}
+		switch {
+		case oid == oidInt8:
+			return binary.BigEndian.AppendUint64(buf, uint64(n)), nil
+		case oid == oidInt4 && n >= math.MinInt32 && n <= math.MaxInt32:
+			return binary.BigEndian.AppendUint32(buf, uint32(n)), nil
+		case oid == oidInt2 && n >= math.MinInt16 && n <= math.MaxInt16:
+			return binary.BigEndian.AppendUint16(buf, uint16(n)), nil
+		}
+		return nil, fmt.Errorf("value %d out of range for type OID %d", n, oid)
+	case oidFloat4, oidFloat8:
+		f, ok := toFloat64(v)
+		if !ok {
+			break
+		}
+		if oid == oidFloat4 {
+			return binary.BigEndian.AppendUint32(buf, math.Float32bits(float32(f))), nil
+		}
+		return binary.BigEndian.AppendUint64(buf, math.Float64bits(f)), nil
+	case oidTimestamp, oidTimestamptz:
+		if t, ok := v.(time.Time); ok {
+			return binary.BigEndian.AppendUint64(buf, uint64(t.Sub(postgresEpoch).Microseconds())), nil
+		}
+	case oidBytea:
+		if b, ok := v.([]byte); ok {
+			return append(buf, b...), nil
+		}
+		if s, ok := v.(string); ok {
+			return append(buf, s...), nil
+		}
+	default:
+		// Text-like types share their binary and text formats.
+		if b, ok := v.([]byte); ok {
+			return append(buf, b...), nil
+		}
+		return appendText(buf, v), nil
+	}
+	return nil, fmt.Errorf("cannot send %T as binary type OID %d", v, oid)
+}
+
+// decodeParam converts a bound parameter to the value the engine binds.
+// Parameters whose type the client left unspecified arrive as text and
+// are read the way the SQL lexer reads an unquoted literal.
+func decodeParam(oid uint32, format int16, data []byte) (any, error) {
+	if data == nil {
+		return nil, nil
+	}
+	if format == formatBinary {
+		return decodeBinaryParam(oid, data)
+	}
+
+	s := string(data)
+	switch oid {
+	case oidUnspecified:
+		if n, err := strconv.ParseInt(s, 10, 64); err == nil {
+			return n, nil
+		}
+		if f, err := strconv.ParseFloat(s, 64); err == nil {
+			return f, nil
+		}
+		return s, nil
+	case oidBool:
+		switch strings.ToLower(s) {
+		case "t", "true", "yes", "on", "1":
+			return true, nil
+		case "f", "false", "no", "off", "0":
+			return false, nil
+		}
+		return nil, fmt.Errorf("invalid boolean %q", s)
+	case oidInt2, oidInt4, oidInt8:
+		return strconv.ParseInt(s, 10, 64)
+	case oidFloat4, oidFloat8, oidNumeric:
+		return strconv.ParseFloat(s, 64)
+	case oidBytea:
+		if strings.HasPrefix(s, `\x`) {
+			return hex.DecodeString(s[2:])
+		}
+		return []byte(s), nil
+	case oidTimestamp, oidTimestamptz:
+		for _, layout := range []string{"2006-01-02 15:04:05.999999999Z07:00", "2006-01-02 15:04:05.999999999Z07", "2006-01-02 15:04:05.999999999", time.RFC3339Nano, "2006-01-02"} {
+			if t, err := time.Parse(layout, s); err == nil {
+				return t, nil
+			}
+		}
+		return nil, fmt.Errorf("invalid timestamp %q", s)
+	default:
+		return s, nil
+	}
+}
+
+func decodeBinaryParam(oid uint32, data []byte) (any, error) {
+	switch oid {
+	case oidBool:
+		if len(data) == 1 {
+			return data[0] != 0, nil
+		}
+	case oidInt2:
+		if len(data) == 2 {
+			return int64(int16(binary.BigEndian.Uint16(data))), nil
+		}
+	case oidInt4:
+		if len(data) == 4 {
+			return int64(int32(binary.BigEndian.Uint32(data))), nil
+		}
+	case oidInt8:
+		if len(data) == 8 {
+			return int64(binary.BigEndian.Uint64(data)), nil
+		}
+	case oidFloat4:
+		if len(data) == 4 {
+			return float64(math.Float32frombits(binary.BigEndian.Uint32(data))), nil
+		}
+	case oidFloat8:
+		if len(data) == 8 {
+			return math.Float64frombits(binary.BigEndian.Uint64(data)), nil
+		}
+	case oidTimestamp, oidTimestamptz:
+		if len(data) == 8 {
+			return postgresEpoch.Add(time.Duration(int64(binary.BigEndian.Uint64(data))) * time.Microsecond), nil
+		}
+	case oidBytea:
+		return append([]byte(nil), data...), nil
+	case oidText, oidVarchar, oidJSON, oidUnspecified:
+		return string(data), nil
+	default:
+		return nil, fmt.Errorf("binary parameters of type OID %d are not supported", oid)
+	}
+	return nil, fmt.Errorf("invalid binary value for type OID %d", oid)
+}
+
+func toInt64(v any) (int64, bool) {
+	switch n := v.(type) {
+	case int:
+		return int64(n), true
+	case int8:
+		return int64(n), true
+	case int16:
+		return int64(n), true
+	case int32:
+		return int64(n), true
+	case int64:
+		return n, true
+	case uint8:
+		return int64(n), true
+	case uint16:
+		return int64(n), true
+	case uint32:
+		return int64(n), true
+	case uint:
+		if uint64(n) <= math.MaxInt64 {
+			return int64(n), true
+		}
+	case uint64:
+		if n <= math.MaxInt64 {
+			return int64(n), true
+		}
+	case float64:
+		if n == math.Trunc(n) && math.Abs(n) < 1<<63 {
+			return int64(n), true
+		}
+	}
+	return 0, false
+}
+
+func toFloat64(v any) (float64, bool) {
+	if n, ok := toInt64(v); ok {
+		return float64(n), true
+	}
+	switch f := v.(type) {
+	case float32:
+		return float64(f), true
+	case float64:
+		return f, true
+	}
+	return 0, false
+}
@@ -0,0 +1,977 @@
+package sql
+
+import (
+	"encoding/binary"
+	"fmt"
+	"hash/maphash"
+	"math"
+	"strings"
+	"sync"
+	"time"
+)
+
+// aggregateSpec describes one aggregate call found in the target list or
+// HAVING clause.
+type aggregateSpec struct {
+	key      string
+	function string
+	arg      Expression // nil for COUNT(*)
+	distinct bool
+}
+
+// aggregateState folds input values into a fixed-size accumulator. Partial
+// states built by parallel workers, or spilled and read back, are combined
+// with merge, so every state can also be flattened to plain values.
+type aggregateState interface {
+	// add folds v in and returns the bytes of memory it newly retained,
+	// which is zero for everything but DISTINCT.
+	add(v any) int64
+	merge(other aggregateState)
+	result() any
+	appendPartial(vals []any) []any
+	readPartial(vals []any) ([]any, error)
+}
+
+func newAggregateState(spec aggregateSpec) aggregateState {
+	var state aggregateState
+	switch spec.function {
+	case "COUNT":
+		state = &countState{star: spec.arg == nil}
+	case "SUM":
+		state = &sumState{}
+	case "AVG":
+		state = &avgState{}
+	case "MIN":
+		state = &minMaxState{}
+	case "MAX":
+		state = &minMaxState{max: true}
+	case "APPROX_COUNT_DISTINCT":
+		return &hllState{sketch: newHyperLogLog()}
+	}
+	if spec.distinct {
+		state = &distinctState{spec: spec, seen: make(map[string]any)}
+	}
+	return state
+}
+
+// aggregateStateSize is the fixed memory charged per state when a group is
+// created.
+func aggregateStateSize(spec aggregateSpec) int64 {
+	if spec.function == "APPROX_COUNT_DISTINCT" {
+		return hllRegisters + 32
+	}
+	return 48
+}
+
+// partialValues checks that a spilled partial state has at least n values.
+func partialValues(vals []any, n int) error {
+	if len(vals) < n {
+		return fmt.Errorf("truncated partial aggregate state")
+	}
+	return nil
+}
+
+type countState struct {
+	star bool
+	n    int64
+}
+
+func (s *countState) add(v any) int64 {
+	if s.star || v != nil {
+		s.n++
+	}
+	return 0
+}
+
+func (s *countState) merge(other aggregateState) { s.n += other.(*countState).n }
+func (s *countState) result() any                { return s.n }
+
+func (s *countState) appendPartial(vals []any) []any { return append(vals, s.n) }
+
+func (s *countState) readPartial(vals []any) ([]any, error) {
+	if err := partialValues(vals, 1); err != nil {
+		return nil, err
+	}
+	s.n, _ = toInt64(vals[0])
+	return vals[1:], nil
+}
+
+// sumState keeps integer sums exact and only switches to float64 once a
+// non-integer value shows up.
+type sumState struct {
+	intSum   int64
+	floatSum float64
+	isFloat  bool
+	seen     bool
+}
+
+func (s *sumState) add(v any) int64 {
+	if v == nil {
+		return 0
+	}
+	if i, ok := toInt64(v); ok && !s.isFloat {
+		s.intSum += i
+		s.seen = true
+		return 0
+	}
+	if f, ok := toFloat64(v); ok {
+		s.toFloat()
+		s.floatSum += f
+		s.seen = true
+	}
+	return 0
+}
+
+func (s *sumState) toFloat() {
+	if !s.isFloat {
+		s.floatSum = float64(s.intSum)
+		s.isFloat = true
+	}
+}
+
+func (s *sumState) merge(other aggregateState) {
+	o := other.(*sumState)
+	if !o.seen {
+		return
+	}
+	if o.isFloat {
+		s.toFloat()
+		s.floatSum += o.floatSum
+	} else if s.isFloat {
+		s.floatSum += float64(o.intSum)
+	} else {
+		s.intSum += o.intSum
+	}
+	s.seen = true
+}
+
+func (s *sumState) result() any {
+	if !s.seen {
+		return nil
+	}
+	if s.isFloat {
+		return s.floatSum
+	}
+	return s.intSum
+}
+
+func (s *sumState) appendPartial(vals []any) []any {
+	return append(vals, s.intSum, s.floatSum, s.isFloat, s.seen)
+}
+
+func (s *sumState) readPartial(vals []any) ([]any, error) {
+	if err := partialValues(vals, 4); err != nil {
+		return nil, err
+	}
+	s.intSum, _ = toInt64(vals[0])
+	s.floatSum, _ = toFloat64(vals[1])
+	s.isFloat, _ = vals[2].(bool)
+	s.seen, _ = vals[3].(bool)
+	return vals[4:], nil
+}
+
+type avgState struct {
+	sum float64
+	n   int64
+}
+
+func (s *avgState) add(v any) int64 {
+	if f, ok := toFloat64(v); ok {
+		s.sum += f
+		s.n++
+	}
+	return 0
+}
+
+func (s *avgState) merge(other aggregateState) {
+	o := other.(*avgState)
+	s.sum += o.sum
+	s.n += o.n
+}
+
+func (s *avgState) result() any {
+	if s.n == 0 {
+		return nil
+	}
+	return s.sum / float64(s.n)
+}
+
+func (s *avgState) appendPartial(vals []any) []any { return append(vals, s.sum, s.n) }
+
+func (s *avgState) readPartial(vals []any) ([]any, error) {
+	if err := partialValues(vals, 2); err != nil {
+		return nil, err
+	}
+	s.sum, _ = toFloat64(vals[0])
+	s.n, _ = toInt64(vals[1])
+	return vals[2:], nil
+}
+
+type minMaxState struct {
+	max bool
+	val any
+}
+
+func (s *minMaxState) add(v any) int64 {
+	if v == nil {
+		return 0
+	}
+	if s.val == nil {
+		s.val = v
+		return 0
+	}
+	c := compareForSort(v, s.val)
+	if (s.max && c > 0) || (!s.max && c < 0) {
+		s.val = v
+	}
+	return 0
+}
+
+func (s *minMaxState) merge(other aggregateState) { s.add(other.(*minMaxState).val) }
+func (s *minMaxState) result() any                { return s.val }
+
+func (s *minMaxState) appendPartial(vals []any) []any { return append(vals, s.val) }
+
+func (s *minMaxState) readPartial(vals []any) ([]any, error) {
+	if err := partialValues(vals, 1); err != nil {
+		return nil, err
+	}
+	s.val = vals[0]
+	return vals[1:], nil
+}
+
+// distinctState collects the distinct non-NULL values and only feeds them to
+// the underlying aggregate when the result is needed, because partial
+// aggregates over overlapping value sets cannot be merged.
+type distinctState struct {
+	spec aggregateSpec
+	seen map[string]any
+}
+
+func (s *distinctState) add(v any) int64 {
+	if v == nil {
+		return 0
+	}
+	key := string(appendValueKey(nil, v))
+	if _, dup := s.seen[key]; dup {
+		return 0
+	}
+	s.seen[key] = v
+	return int64(len(key)) + 48
+}
+
+func (s *distinctState) merge(other aggregateState) {
+	for key, v := range other.(*distinctState).seen {
+		s.seen[key] = v
+	}
+}
+
+func (s *distinctState) result() any {
+	inner := newAggregateState(aggregateSpec{function: s.spec.function, arg: s.spec.arg})
+	for _, v := range s.seen {
+		inner.add(v)
+	}
+	return inner.result()
+}
+
+func (s *distinctState) appendPartial(vals []any) []any {
+	vals = append(vals, int64(len(s.seen)))
+	for _, v := range s.seen {
+		vals = append(vals, v)
+	}
+	return vals
+}
+
+func (s *distinctState) readPartial(vals []any) ([]any, error) {
+	if err := partialValues(vals, 1); err != nil {
+		return nil, err
+	}
+	n, _ := toInt64(vals[0])
+	if err := partialValues(vals[1:], int(n)); err != nil {
+		return nil, err
+	}
+	for _, v := range vals[1 : 1+n] {
+		s.add(v)
+	}
+	return vals[1+n:], nil
+}
+
+// hllState implements APPROX_COUNT_DISTINCT with a HyperLogLog sketch, so
+// its memory stays fixed however many distinct values a group sees.
+type hllState struct {
+	sketch *hyperLogLog
+	buf    []byte
+}
+
+func (s *hllState) add(v any) int64 {
+	if v == nil {
+		return 0
+	}
+	s.buf = appendValueKey(s.buf[:0], v)
+	s.sketch.addKey(s.buf)
+	return 0
+}
+
+func (s *hllState) merge(other aggregateState) { s.sketch.merge(other.(*hllState).sketch) }
+func (s *hllState) result() any                { return s.sketch.estimate() }
+
+func (s *hllState) appendPartial(vals []any) []any {
+	return append(vals, append([]byte(nil), s.sketch.registers...))
+}
+
+func (s *hllState) readPartial(vals []any) ([]any, error) {
+	if err := partialValues(vals, 1); err != nil {
+		return nil, err
+	}
+	b, _ := vals[0].([]byte)
+	if err := s.sketch.setRegisters(b); err != nil {
+		return nil, err
+	}
+	return vals[1:], nil
+}
+
+// appendValueKey appends a type-tagged binary encoding of v, used to key
+// groups and distinct sets without going through fmt. Integers that fit in
+// int64 share an encoding regardless of their Go type so 1 and int64(1)
+// land in the same group.
+func appendValueKey(buf []byte, v any) []byte {
+	if v == nil {
+		return append(buf, 0)
+	}
+	if i, ok := toInt64(v); ok {
+		buf = append(buf, 1)
+		return binary.BigEndian.AppendUint64(buf, uint64(i))
+	}
+	switch x := v.(type) {
+	case float64:
+		buf = append(buf, 2)
+		return binary.BigEndian.AppendUint64(buf, math.Float64bits(x))
+	case float32:
+		buf = append(buf, 2)
+		return binary.BigEndian.AppendUint64(buf, math.Float64bits(float64(x)))
+	case string:
+		buf = append(buf, 3)
+		buf = binary.AppendUvarint(buf, uint64(len(x)))
+		return append(buf, x...)
+	case []byte:
+		buf = append(buf, 3)
+		buf = binary.AppendUvarint(buf, uint64(len(x)))
+		return append(buf, x...)
+	case bool:
+		if x {
+			return append(buf, 4, 1)
+		}
+		return append(buf, 4, 0)
+	case time.Time:
+		buf = append(buf, 5)
+		return binary.BigEndian.AppendUint64(buf, uint64(x.UnixNano()))
+	default:
+		s := fmt.Sprintf("%T:%v", v, v)
+		buf = append(buf, 6)
+		buf = binary.AppendUvarint(buf, uint64(len(s)))
+		return append(buf, s...)
+	}
+}
+
+// Spilled groups are split into 2^aggregatePartitionBits partitions by key
+// hash; each partition is merged on its own after the input is consumed.
+const aggregatePartitionBits = 4
+
+const aggregatePartitions = 1 << aggregatePartitionBits
+
+// aggregateGroup is the per-group state. Memory grows with the number of
+// groups, never with the number of input rows.
+type aggregateGroup struct {
+	key      string
+	firstRow Row
+	states   []aggregateState
+}
+
+// hashAggregateOperator implements GROUP BY and plain aggregates by folding
+// each input row into its group's accumulators as it arrives.
+//
+// With parallelism enabled, input batches are handed to workers that each
+// build a partial aggregate table; a final phase merges the partial states.
+// A table that outgrows its share of ExecutorConfig.WorkMem writes its
+// partial groups to hash-partitioned spill files and starts over, and the
+// spilled partitions are merged and emitted one at a time at the end.
+type hashAggregateOperator struct {
+	child     Operator
+	groupKeys []Expression
+	targets   []TargetEntry
+	having    []Expression
+	specs     []aggregateSpec
+	batchSize int
+	memLimit  int64
+	workers   int
+	seed      maphash.Seed
+
+	ctx      *ExecutionContext
+	colIndex map[string]int
+	columns  []ColumnInfo
+	pending  [][]*spillFile // spilled partitions not yet emitted
+	output   []Row
+	pos      int
+	built    bool
+	spillStats
+}
+
+func newHashAggregateOperator(child Operator, plan *QueryPlan, config *ExecutorConfig) *hashAggregateOperator {
+	op := &hashAggregateOperator{
+		child:     child,
+		groupKeys: plan.GroupKeys,
+		targets:   plan.TargetList,
+		having:    plan.Qual,
+		batchSize: config.BatchSize,
+		memLimit:  config.WorkMem,
+		workers:   1,
+		seed:      maphash.MakeSeed(),
+	}
+	if config.EnableParallel && config.MaxWorkers > 1 {
+		op.workers = config.MaxWorkers
+	}
+
+	seen := make(map[string]bool)
+	for _, target := range op.targets {
+		op.specs = collectAggregates(target.Expression, op.specs, seen)
+	}
+	for _, qual := range op.having {
+		op.specs = collectAggregates(qual, op.specs, seen)
+	}
+	return op
+}
+
+// collectAggregates appends every aggregate call in expr that has not been
+// seen yet.
+func collectAggregates(expr Expression, specs []aggregateSpec, seen map[string]bool) []aggregateSpec {
+	switch e := expr.(type) {
+	case *FunctionCall:
+		if e.Over == nil && isAggregateFunction(e.Name) {
+			key := expressionKey(e)
+			if !seen[key] {
+				seen[key] = true
+				spec := aggregateSpec{key: key, function: strings.ToUpper(e.Name), distinct: e.Distinct}
+				if len(e.Arguments) > 0 {
+					if ident, ok := e.Arguments[0].(*IdentifierExpression); !ok || ident.Name != "*" {
+						spec.arg = e.Arguments[0]
+					}
+				}
+				specs = append(specs, spec)
+			}
+			return specs
+		}
+		for _, arg := range e.Arguments {
+			specs = collectAggregates(arg, specs, seen)
+		}
+	case *BinaryExpression:
+		specs = collectAggregates(e.Left, specs, seen)
+		specs = collectAggregates(e.Right, specs, seen)
+	case *UnaryExpression:
+		specs = collectAggregates(e.Operand, specs, seen)
+	case *CaseExpression:
+		specs = collectAggregates(e.Expression, specs, seen)
+		for _, when := range e.WhenClauses {
+			specs = collectAggregates(when.Condition, specs, seen)
+			specs = collectAggregates(when.Result, specs, seen)
+		}
+		specs = collectAggregates(e.ElseClause, specs, seen)
+	}
+	return specs
+}
+
+func (a *hashAggregateOperator) Open(ctx *ExecutionContext) error {
+	a.ctx = ctx
+	if err := a.child.Open(ctx); err != nil {
+		return err
+	}
+	childColumns := a.child.Columns()
+	a.colIndex = operatorColumnIndex(a.child)
+	a.columns = a.outputColumns(childColumns)
+	return nil
+}
+
+func (a *hashAggregateOperator) NextBatch() (*RowBatch, error) {
+	if !a.built {
+		if err := a.build(); err != nil {
+			return nil, err
+		}
+	}
+	for a.pos >= len(a.output) {
+		if len(a.pending) == 0 {
+			return nil, nil
+		}
+		if err := a.emitPartition(); err != nil {
+			return nil, err
+		}
+	}
+	end := a.pos + a.batchSize
+	if end > len(a.output) {
+		end = len(a.output)
+	}
+	batch := &RowBatch{Rows: a.output[a.pos:end]}
+	a.pos = end
+	return batch, nil
+}
+
+// build consumes the input into partial tables and merges them. Groups
+// that never spilled are emitted right away; spilled partitions are left in
+// pending for NextBatch.
+func (a *hashAggregateOperator) build() error {
+	tables := make([]*aggregateTable, a.workers)
+	for i := range tables {
+		tables[i] = a.newTable(a.memLimit / int64(a.workers))
+	}
+	var err error
+	if len(tables) == 1 {
+		err = a.consumeSerial(tables[0])
+	} else {
+		err = a.consumeParallel(tables)
+	}
+	if err != nil {
+		closeAggregateSpills(tables)
+		return err
+	}
+
+	final := tables[0]
+	if len(tables) > 1 {
+		final = a.newTable(a.memLimit)
+		for _, t := range tables {
+			for _, g := range t.order {
+				final.merge(g)
+				if final.memUsed > final.memLimit {
+					if err := final.spill(); err != nil {
+						closeAggregateSpills(append(tables, final))
+						return err
+					}
+				}
+			}
+			t.reset()
+		}
+		tables = append(tables, final)
+	}
+
+	spilled := false
+	for _, t := range tables {
+		spilled = spilled || t.spills != nil
+	}
+	if spilled {
+		if err := final.spill(); err != nil {
+			closeAggregateSpills(tables)
+			return err
+		}
+		for p := 0; p < aggregatePartitions; p++ {
+			var files []*spillFile
+			for _, t := range tables {
+				if t.spills != nil && t.spills[p] != nil {
+					files = append(files, t.spills[p])
+				}
+			}
+			if len(files) > 0 {
+				a.pending = append(a.pending, files)
+			}
+		}
+	} else {
+		// Plain aggregates over an empty input still produce one row.
+		if len(a.groupKeys) == 0 && len(final.order) == 0 {
+			final.order = append(final.order, a.newGroup("", Row{}))
+		}
+		if err := a.emit(final.order); err != nil {
+			return err
+		}
+		final.reset()
+	}
+	// Tables are sized independently, so their peaks add up to a bound
+	for _, t := range tables {
+		a.peakMemory += t.stats.peakMemory
+		a.spills += t.stats.spills
+	}
+	a.built = true
+	return nil
+}
+
+func (a *hashAggregateOperator) consumeSerial(t *aggregateTable) error {
+	for {
+		if err := checkCancelled(a.ctx); err != nil {
+			return err
+		}
+		batch, err := a.child.NextBatch()
+		if err != nil || batch == nil {
+			return err
+		}
+		if err := t.consume(batch); err != nil {
+			return err
+		}
+	}
+}
+
+// consumeParallel reads the input on this goroutine, since operators are
+// not safe for concurrent use, and fans batches out to one worker per
+// table.
+func (a *hashAggregateOperator) consumeParallel(tables []*aggregateTable) error {
+	batches := make(chan *RowBatch, len(tables))
+	errs := make(chan error, len(tables))
+	var wg sync.WaitGroup
+	for _, t := range tables {
+		wg.Add(1)
+		go func(t *aggregateTable) {
+			defer wg.Done()
+			for batch := range batches {
+				if err := t.consume(batch); err != nil {
+					errs <- err
+					for range batches {
+					}
+					return
+				}
+			}
+		}(t)
+	}
+
+	var err error
+	for err == nil {
+		if err = checkCancelled(a.ctx); err != nil {
+			break
+		}
+		select {
+		case err = <-errs:
+			continue
+		default:
+		}
+		var batch *RowBatch
+		batch, err = a.child.NextBatch()
+		if err != nil || batch == nil {
+			break
+		}
+		batches <- batch
+	}
+	close(batches)
+	wg.Wait()
+	if err == nil {
+		select {
+		case err = <-errs:
+		default:
+		}
+	}
+	return err
+}
+
+// emitPartition merges one spilled partition back into memory and emits
+// its groups.
+func (a *hashAggregateOperator) emitPartition() error {
+	files := a.pending[0]
+	a.pending = a.pending[1:]
+	defer closeSpillFiles(files)
+
+	t := a.newTable(math.MaxInt64)
+	for _, f := range files {
+		if err := checkCancelled(a.ctx); err != nil {
+			return err
+		}
+		if err := f.rewind(); err != nil {
+			return err
+		}
+		for {
+			row, ok, err := f.readRow()
+			if err != nil {
+				return err
+			}
+			if !ok {
+				break
+			}
+			g, err := a.decodeGroup(row.Values)
+			if err != nil {
+				return err
+			}
+			t.merge(g)
+		}
+	}
+	return a.emit(t.order)
+}
+
+func (a *hashAggregateOperator) newGroup(key string, row Row) *aggregateGroup {
+	group := &aggregateGroup{
+		key:      key,
+		firstRow: Row{Values: append([]any(nil), row.Values...)},
+		states:   make([]aggregateState, len(a.specs)),
+	}
+	for i, spec := range a.specs {
+		group.states[i] = newAggregateState(spec)
+	}
+	return group
+}
+
+// groupSize estimates the memory a new group holds.
+func (a *hashAggregateOperator) groupSize(g *aggregateGroup) int64 {
+	size := int64(64+len(g.key)) + rowFootprint(g.firstRow)
+	for _, spec := range a.specs {
+		size += aggregateStateSize(spec)
+	}
+	return size
+}
+
+// decodeGroup reads back a group written by aggregateTable.spill: the key,
+// the first row's width and values, then each partial state in spec order.
+func (a *hashAggregateOperator) decodeGroup(vals []any) (*aggregateGroup, error) {
+	if len(vals) < 2 {
+		return nil, fmt.Errorf("truncated spilled aggregate group")
+	}
+	key, _ := vals[0].(string)
+	n, _ := toInt64(vals[1])
+	if n < 0 || int64(len(vals)-2) < n {
+		return nil, fmt.Errorf("truncated spilled aggregate group")
+	}
+	g := &aggregateGroup{
+		key:      key,
+		firstRow: Row{Values: vals[2 : 2+n : 2+n]},
+		states:   make([]aggregateState, len(a.specs)),
+	}
+	rest := vals[2+n:]
+	for i, spec := range a.specs {
+		g.states[i] = newAggregateState(spec)
+		var err error
+		if rest, err = g.states[i].readPartial(rest); err != nil {
+			return nil, err
+		}
+	}
+	return g, nil
+}
+
+// emit evaluates the target list and HAVING for every group. Non-aggregate
+// expressions are evaluated against the first row seen for the group, which
+// is well-defined for GROUP BY columns.
+func (a *hashAggregateOperator) emit(groups []*aggregateGroup) error {
+	env := &evalEnv{columns: a.colIndex, params: a.ctx.Parameters}
+	a.output, a.pos = nil, 0
+	for _, group := range groups {
+		results := make(map[string]any, len(a.specs))
+		for i, spec := range a.specs {
+			results[spec.key] = group.states[i].result()
+		}
+		env.row = group.firstRow
+		env.aggregates = results
+
+		ok, err := evaluateQuals(a.having, env)
+		if err != nil {
+			return err
+		}
+		if !ok {
+			continue
+		}
+
+		row := Row{Values: make([]any, 0, len(a.columns))}
+		if len(a.targets) == 0 {
+			for _, expr := range a.groupKeys {
+				v, err := evaluateExpression(expr, env)
+				if err != nil {
+					return err
+				}
+				row.Values = append(row.Values, v)
+			}
+		} else {
+			for _, target := range a.targets {
+				v, err := evaluateExpression(target.Expression, env)
+				if err != nil {
+					return err
+				}
+				row.Values = append(row.Values, v)
+			}
+		}
+		a.output = append(a.output, row)
+	}
+	a.ctx.Stats.RowsProcessed += int64(len(a.output))
+	return nil
+}
+
+// aggregateTable is one hash table of partial groups. Each worker fills its
+// own, so tables need no locking.
+type aggregateTable struct {
+	a        *hashAggregateOperator
+	env      *evalEnv
+	keyBuf   []byte
+	groups   map[string]*aggregateGroup
+	order    []*aggregateGroup
+	memUsed  int64
+	memLimit int64
+	spills   []*spillFile // one per partition once the table has spilled
+	stats    spillStats
+}
+
+func (a *hashAggregateOperator) newTable(memLimit int64) *aggregateTable {
+	return &aggregateTable{
+		a:        a,
+		env:      &evalEnv{columns: a.colIndex, params: a.ctx.Parameters},
+		groups:   make(map[string]*aggregateGroup),
+		memLimit: memLimit,
+	}
+}
+
+// consume folds a batch of input rows into the table.
+func (t *aggregateTable) consume(batch *RowBatch) error {
+	a, env := t.a, t.env
+	for _, row := range batch.Rows {
+		env.row = row
+		t.keyBuf = t.keyBuf[:0]
+		for _, expr := range a.groupKeys {
+			v, err := evaluateExpression(expr, env)
+			if err != nil {
+				return err
+			}
+			t.keyBuf = appendValueKey(t.keyBuf, v)
+		}
+
+		group, exists := t.groups[string(t.keyBuf)]
+		if !exists {
+			group = a.newGroup(string(t.keyBuf), row)
+			t.insert(group)
+		}
+		for i, spec := range a.specs {
+			var v any = true // COUNT(*) counts rows, not values
+			if spec.arg != nil {
+				var err error
+				v, err = evaluateExpression(spec.arg, env)
+				if err != nil {
+					return err
+				}
+			}
+			t.memUsed += group.states[i].add(v)
+		}
+		if t.memUsed > t.memLimit {
+			if err := t.spill(); err != nil {
+				return err
+			}
+		}
+	}
+	return nil
+}
+
+func (t *aggregateTable) insert(g *aggregateGroup) {
+	t.groups[g.key] = g
+	t.order = append(t.order, g)
+	t.memUsed += t.a.groupSize(g)
+}
+
+// merge combines a partial group into the table.
+func (t *aggregateTable) merge(g *aggregateGroup) {
+	existing, ok := t.groups[g.key]
+	if !ok {
+		t.insert(g)
+		return
+	}
+	for i, state := range existing.states {
+		state.merge(g.states[i])
+	}
+}
+
+// spill writes every group to its partition's spill file and empties the
+// table.
+func (t *aggregateTable) spill() error {
+	if len(t.order) == 0 {
+		return nil
+	}
+	if t.spills == nil {
+		t.spills = make([]*spillFile, aggregatePartitions)
+	}
+	t.stats.spills++
+	var vals []any
+	for _, g := range t.order {
+		p := maphash.String(t.a.seed, g.key) >> (64 - aggregatePartitionBits)
+		if t.spills[p] == nil {
+			f, err := newSpillFile()
+			if err != nil {
+				return err
+			}
+			t.spills[p] = f
+		}
+		vals = append(vals[:0], g.key, int64(len(g.firstRow.Values)))
+		vals = append(vals, g.firstRow.Values...)
+		for _, state := range g.states {
+			vals = state.appendPartial(vals)
+		}
+		if err := t.spills[p].writeRow(Row{Values: vals}); err != nil {
+			return err
+		}
+	}
+	t.reset()
+	return nil
+}
+
+func (t *aggregateTable) reset() {
+	t.stats.noteMemory(t.memUsed)
+	t.groups = make(map[string]*aggregateGroup)
+	t.order = nil
+	t.memUsed = 0
+}
+
+func closeAggregateSpills(tables []*aggregateTable) {
+	for _, t := range tables {
+		for _, f := range t.spills {
+			if f != nil {
+				f.close()
+			}
+		}
+		t.spills = nil
+	}
+}
+
+func (a *hashAggregateOperator) outputColumns(childColumns []ColumnInfo) []ColumnInfo {
+	exprs := make([]Expression, 0, len(a.targets))
+	names := make([]string, 0, len(a.targets))
+	if len(a.targets) == 0 {
+		for _, expr := range a.groupKeys {
+			exprs = append(exprs, expr)
+			names = append(names, "")
+		}
+	} else {
+		for _, target := range a.targets {
+			exprs = append(exprs, target.Expression)
+			names = append(names, target.ResName)
+		}
+	}
+
+	columns := make([]ColumnInfo, len(exprs))
+	for i, expr := range exprs {
+		columns[i] = describeExpression(expr, names[i], childColumns, a.colIndex)
+	}
+	return columns
+}
+
+// describeExpression derives a result column for a projected expression.
+func describeExpression(expr Expression, alias string, childColumns []ColumnInfo, colIndex map[string]int) ColumnInfo {
+	info := ColumnInfo{Name: alias, Nullable: true}
+	switch e := expr.(type) {
+	case *IdentifierExpression:
+		if info.Name == "" {
+			info.Name = e.Name
+		}
+		if idx, ok := colIndex[strings.ToLower(e.Name)]; ok {
+			info.Type = childColumns[idx].Type
+			info.Nullable = childColumns[idx].Nullable
+		}
+	case *FunctionCall:
+		if info.Name == "" {
+			info.Name = strings.ToLower(e.Name)
+		}
+		switch strings.ToUpper(e.Name) {
+		case "COUNT", "APPROX_COUNT_DISTINCT":
+			info.Type = DataType{Name: "INTEGER"}
+			info.Nullable = false
+		case "AVG":
+			info.Type = DataType{Name: "FLOAT"}
+		}
+	default:
+		if info.Name == "" && expr != nil {
+			info.Name = expr.String()
+		}
+	}
+	return info
+}
+
+func (a *hashAggregateOperator) Close() error {
+	for _, files := range a.pending {
+		closeSpillFiles(files)
+	}
+	a.pending = nil
+	a.output = nil
+	return a.child.Close()
+}
+
+func (a *hashAggregateOperator) Columns() []ColumnInfo { return a.columns }
@@ -0,0 +1,481 @@
+package sql
+
+import (
+	"bytes"
+	"context"
+	"encoding/json"
+	"fmt"
+	"math"
+	"math/rand"
+	"sort"
+	"time"
+)
+
+// AnalyzeConfig controls how ANALYZE samples tables and when tables are
+// analyzed again automatically.
+type AnalyzeConfig struct {
+	// SampleSize is the number of rows kept by the reservoir.
+	SampleSize int
+	// StatisticsTarget bounds the histogram buckets and most-common
+	// values kept per column.
+	StatisticsTarget int
+	// A table is re-analyzed once it has seen AutoAnalyzeThreshold +
+	// AutoAnalyzeScaleFactor*rows modifications. A zero threshold and
+	// scale factor disable automatic analysis.
+	AutoAnalyzeThreshold   int64
+	AutoAnalyzeScaleFactor float64
+}
+
+// DefaultAnalyzeConfig returns the PostgreSQL defaults: 300 sampled rows
+// per unit of statistics target, and re-analysis after 10% of a table
+// has changed.
+func DefaultAnalyzeConfig() *AnalyzeConfig {
+	return &AnalyzeConfig{
+		SampleSize:             30000,
+		StatisticsTarget:       100,
+		AutoAnalyzeThreshold:   50,
+		AutoAnalyzeScaleFactor: 0.1,
+	}
+}
+
+// AnalyzeTable reads every row of a table once. Row counts, null counts,
+// widths and distinct counts come from the full pass; histograms, most
+// common values and correlation come from a uniform reservoir sample.
+func (qe *QueryExecutor) AnalyzeTable(ctx context.Context, tableName string, config *AnalyzeConfig) (*TableStatistics, error) {
+	if config == nil {
+		config = DefaultAnalyzeConfig()
+	}
+	columns := qe.getTableColumns(tableName)
+	execCtx := &ExecutionContext{Context: ctx, StartTime: time.Now(), Stats: &ExecutionStats{}}
+	source, err := qe.openRowSource(execCtx, tableName, columns)
+	if err != nil {
+		return nil, fmt.Errorf("failed to analyze %s: %w", tableName, err)
+	}
+	defer source.close()
+
+	accs := make([]columnAccumulator, len(columns))
+	for i := range accs {
+		accs[i].distinct = newHyperLogLog()
+	}
+	sample := newReservoir(config.SampleSize, rand.New(rand.NewSource(time.Now().UnixNano())))
+	var key []byte
+	var rows int64
+	for {
+		if rows%4096 == 0 {
+			if err := checkCancelled(execCtx); err != nil {
+				return nil, err
+			}
+		}
+		row, _, ok, err := source.next()
+		if err != nil {
+			return nil, fmt.Errorf("failed to analyze %s: %w", tableName, err)
+		}
+		if !ok {
+			break
+		}
+		for i := range accs {
+			var v any
+			if i < len(row.Values) {
+				v = row.Values[i]
+			}
+			if v == nil {
+				accs[i].nulls++
+				continue
+			}
+			key = appendValueKey(key[:0], v)
+			accs[i].distinct.addKey(key)
+			accs[i].width += int64(len(key))
+		}
+		if slot := sample.slot(); slot >= 0 {
+			entry := sampledRow{pos: rows, values: row.Values}
+			if slot == len(sample.rows) {
+				sample.rows = append(sample.rows, entry)
+			} else {
+				sample.rows[slot] = entry
+			}
+		}
+		rows++
+	}
+
+	stats := &TableStatistics{
+		TableName:    tableName,
+		RowCount:     float64(rows),
+		LastAnalyzed: time.Now().Unix(),
+		Columns:      make(map[string]*ColumnStatistics, len(columns)),
+	}
+	for i, col := range columns {
+		colStats := buildColumnStatistics(tableName, col, i, sample.rows, rows, &accs[i], config.StatisticsTarget)
+		stats.Columns[col.Name] = colStats
+		stats.AvgRowWidth += colStats.AvgWidth
+	}
+	stats.PageCount = math.Ceil(stats.RowCount * stats.AvgRowWidth / statsPageSize)
+	return stats, nil
+}
+
+// statsPageSize converts row widths into the page counts the cost model
+// charges for.
+const statsPageSize = 8192
+
+type columnAccumulator struct {
+	nulls    int64
+	width    int64
+	distinct *hyperLogLog
+}
+
+type sampledRow struct {
+	pos    int64
+	values []any
+}
+
+// reservoir keeps a uniform sample of a stream of unknown length. Once it
+// is full it uses Li's Algorithm L, which draws the gap to the next
+// replacement instead of a random number per row.
+type reservoir struct {
+	size int
+	rows []sampledRow
+	skip int64
+	w    float64
+	rng  *rand.Rand
+}
+
+func newReservoir(size int, rng *rand.Rand) *reservoir {
+	return &reservoir{size: size, rows: make([]sampledRow, 0, size), rng: rng}
+}
+
+// slot returns where the next row of the stream belongs in the sample:
+// len(rows) to append it, an existing index to replace, or -1 to skip it.
+func (r *reservoir) slot() int {
+	if r.size <= 0 {
+		return -1
+	}
+	if n := len(r.rows); n < r.size {
+		if n+1 == r.size {
+			r.w = math.Exp(math.Log(r.uniform()) / float64(r.size))
+			r.drawSkip()
+		}
+		return n
+	}
+	if r.skip > 0 {
+		r.skip--
+		return -1
+	}
+	slot := r.rng.Intn(r.size)
+	r.w *= math.Exp(math.Log(r.uniform()) / float64(r.size))
+	r.drawSkip()
+	return slot
+}
+
+func (r *reservoir) drawSkip() {
+	r.skip = int64(math.Floor(math.Log(r.uniform()) / math.Log(1-r.w)))
+}
+
+// uniform returns a value in (0, 1], so its logarithm is finite.
+func (r *reservoir) uniform() float64 {
+	return 1 - r.rng.Float64()
+}
+
+// buildColumnStatistics derives one column's statistics from the full
+// pass counters and the sample.
+func buildColumnStatistics(tableName string, col ColumnInfo, idx int, sample []sampledRow, rows int64, acc *columnAccumulator, target int) *ColumnStatistics {
+	stats := &ColumnStatistics{
+		TableName:  tableName,
+		ColumnName: col.Name,
+		DataType:   col.Type.Name,
+	}
+	if rows == 0 {
+		return stats
+	}
+	nonNull := rows - acc.nulls
+	stats.NullFraction = float64(acc.nulls) / float64(rows)
+	if nonNull == 0 {
+		return stats
+	}
+	stats.AvgWidth = float64(acc.width) / float64(nonNull)
+	stats.NDistinct = math.Min(float64(acc.distinct.estimate()), float64(nonNull))
+
+	type sampled struct {
+		value any
+		pos   int64
+	}
+	values := make([]sampled, 0, len(sample))
+	for _, row := range sample {
+		if idx < len(row.values) && row.values[idx] != nil {
+			values = append(values, sampled{value: row.values[idx], pos: row.pos})
+		}
+	}
+	if len(values) == 0 {
+		return stats
+	}
+	sort.SliceStable(values, func(i, j int) bool { return statsCompare(values[i].value, values[j].value) < 0 })
+
+	// Group equal values; a group is a candidate most-common value.
+	type group struct {
+		value      any
+		start, end int
+	}
+	var groups []group
+	for i := range values {
+		if n := len(groups); n > 0 && statsCompare(groups[n-1].value, values[i].value) == 0 {
+			groups[n-1].end = i + 1
+			continue
+		}
+		groups = append(groups, group{value: values[i].value, start: i, end: i + 1})
+	}
+
+	// A value is common when it is clearly more frequent than average.
+	// When the sample holds the whole table and every value fits, all
+	// of them are kept and no histogram is needed.
+	sampleRows := float64(len(sample))
+	wholeTable := int64(len(sample)) == rows
+	mcvCount := target
+	if !wholeTable || len(groups) > target {
+		avg := float64(len(values)) / float64(len(groups))
+		candidates := groups[:0:0]
+		for _, g := range groups {
+			if n := g.end - g.start; n >= 2 && float64(n) > 1.25*avg {
+				candidates = append(candidates, g)
+			}
+		}
+		sort.SliceStable(candidates, func(i, j int) bool {
+			return candidates[i].end-candidates[i].start > candidates[j].end-candidates[j].start
+		})
+		if len(candidates) < mcvCount {
+			mcvCount = len(candidates)
+		}
+		common := make(map[int]bool, mcvCount)
+		for _, g := range candidates[:mcvCount] {
+			common[g.start] = true
+			stats.MostCommon = append(stats.MostCommon, ColumnValue{Value: g.value, Frequency: float64(g.end-g.start) / sampleRows})
+		}
+		rest := groups[:0:0]
+		for _, g := range groups {
+			if !common[g.start] {
+				rest = append(rest, g)
+			}
+		}
+		if wholeTable {
+			stats.NDistinct = float64(len(groups))
+		}
+		groups = rest
+	} else {
+		for _, g := range groups {
+			stats.MostCommon = append(stats.MostCommon, ColumnValue{Value: g.value, Frequency: float64(g.end-g.start) / sampleRows})
+		}
+		stats.NDistinct = float64(len(groups))
+		groups = nil
+	}
+
+	// Equi-depth histogram over the values that are not most common.
+	// Groups are already in value order.
+	var rest []any
+	for _, g := range groups {
+		for i := g.start; i < g.end; i++ {
+			rest = append(rest, values[i].value)
+		}
+	}
+	if len(groups) >= 2 {
+		buckets := target
+		if buckets > len(groups)-1 {
+			buckets = len(groups) - 1
+		}
+		restFraction := float64(len(rest)) / sampleRows
+		for i := 0; i <= buckets; i++ {
+			bound := ColumnValue{Value: rest[i*(len(rest)-1)/buckets]}
+			if i > 0 {
+				bound.Frequency = restFraction / float64(buckets)
+			}
+			stats.Histogram = append(stats.Histogram, bound)
+		}
+	}
+
+	stats.Correlation = sampleCorrelation(len(values), func(i int) int64 { return values[i].pos })
+	return stats
+}
+
+// sampleCorrelation is the rank correlation between value order, given
+// by index, and physical row position. Near ±1 a range scan in value
+// order reads the table almost sequentially.
+func sampleCorrelation(n int, pos func(int) int64) float64 {
+	if n < 2 {
+		return 1
+	}
+	order := make([]int, n)
+	for i := range order {
+		order[i] = i
+	}
+	sort.Slice(order, func(a, b int) bool { return pos(order[a]) < pos(order[b]) })
+	var sumXY float64
+	for physRank, valueRank := range order {
+		sumXY += float64(physRank) * float64(valueRank)
+	}
+	// Both rank sequences are 0..n-1, so their mean and variance are known.
+	fn := float64(n)
+	mean := (fn - 1) / 2
+	variance := (fn*fn - 1) / 12
+	return (sumXY/fn - mean*mean) / variance
+}
+
+// statsCompare orders values for histograms. Values compareValues cannot
+// order, such as mixed types, fall back to their key encoding so that
+// sorting stays consistent.
+func statsCompare(a, b any) int {
+	if a == nil || b == nil {
+		switch {
+		case a == nil && b == nil:
+			return 0
+		case a == nil:
+			return -1
+		}
+		return 1
+	}
+	if cmp, ok := compareValues(a, b); ok {
+		return cmp
+	}
+	return bytes.Compare(appendValueKey(nil, a), appendValueKey(nil, b))
+}
+
+// StatisticsStore persists ANALYZE results so a restarted engine does not
+// fall back to default estimates.
+type StatisticsStore interface {
+	SaveTableStats(ctx context.Context, stats *TableStatistics) error
+	LoadTableStats(ctx context.Context) ([]*TableStatistics, error)
+}
+
+// statisticsKeyPrefix keeps persisted statistics out of every table's key
+// range.
+const statisticsKeyPrefix = "__stats__/"
+
+// KVStatisticsStore keeps statistics as JSON records in the KV store.
+type KVStatisticsStore struct {
+	kv KVStorageEngine
+}
+
+// NewKVStatisticsStore creates a statistics store over a KV engine.
+func NewKVStatisticsStore(kv KVStorageEngine) *KVStatisticsStore {
+	return &KVStatisticsStore{kv: kv}
+}
+
+// SaveTableStats writes the statistics of one table.
+func (s *KVStatisticsStore) SaveTableStats(ctx context.Context, stats *TableStatistics) error {
+	data, err := json.Marshal(stats)
+	if err != nil {
+		return fmt.Errorf("failed to encode statistics for %s: %w", stats.TableName, err)
+	}
+	if err := s.kv.Put(ctx, []byte(statisticsKeyPrefix+stats.TableName), data); err != nil {
+		return fmt.Errorf("failed to save statistics for %s: %w", stats.TableName, err)
+	}
+	return nil
+}
+
+// LoadTableStats reads the statistics of every analyzed table.
+func (s *KVStatisticsStore) LoadTableStats(ctx context.Context) ([]*TableStatistics, error) {
+	iter, err := s.kv.Scan(ctx, []byte(statisticsKeyPrefix), []byte(statisticsKeyPrefix+"~"))
+	if err != nil {
+		return nil, fmt.Errorf("failed to load statistics: %w", err)
+	}
+	defer iter.Close()
+
+	var all []*TableStatistics
+	for iter.Next() {
+		key, data, err := iter.Value()
+		if err != nil {
+			return nil, fmt.Errorf("failed to load statistics: %w", err)
+		}
+		stats := &TableStatistics{}
+		if err := json.Unmarshal(data, stats); err != nil {
+			return nil, fmt.Errorf("failed to decode statistics %s: %w", key, err)
+		}
+		all = append(all, stats)
+	}
+	if err := iter.Error(); err != nil {
+		return nil, fmt.Errorf("failed to load statistics: %w", err)
+	}
+	return all, nil
+}
+
+// Analyze gathers statistics for a table, hands them to the optimizer and
+// persists them.
+func (se *SQLEngine) Analyze(ctx context.Context, tableName string) (*TableStatistics, error) {
+	stats, err := se.executor.AnalyzeTable(ctx, tableName, se.config.Analyze)
+	if err != nil {
+		return nil, err
+	}
+	se.optimizer.stats.UpdateTableStats(stats)
+	if se.statsStore != nil {
+		if err := se.statsStore.SaveTableStats(ctx, stats); err != nil {
+			return stats, err
+		}
+	}
+	return stats, nil
+}
+
+// executeAnalyze handles ANALYZE [table, ...]. Without tables it
+// refreshes every table the optimizer has statistics or changes for.
+func (se *SQLEngine) executeAnalyze(ctx context.Context, stmt *AnalyzeStatement, startTime time.Time) (*SQLResult, error) {
+	tables := stmt.Tables
+	if len(tables) == 0 {
+		tables = se.optimizer.stats.Tables()
+	}
+	for _, table := range tables {
+		if _, err := se.Analyze(ctx, table); err != nil {
+			return &SQLResult{Error: err, ExecutionTime: time.Since(startTime)}, err
+		}
+	}
+	return &SQLResult{RowsAffected: int64(len(tables)), ExecutionTime: time.Since(startTime)}, nil
+}
+
+// loadStatistics restores persisted statistics. Failing to read them only
+// costs plan quality, so the engine starts regardless.
+func (se *SQLEngine) loadStatistics(ctx context.Context) {
+	all, err := se.statsStore.LoadTableStats(ctx)
+	if err != nil {
+		return
+	}
+	for _, stats := range all {
+		se.optimizer.stats.UpdateTableStats(stats)
+	}
+}
+
+// noteModifications counts the rows a statement changed and, once a table
+// has changed enough, analyzes it again in the background.
+func (se *SQLEngine) noteModifications(stmt Statement, tables []string, rows int64) {
+	switch stmt.(type) {
+	case *InsertStatement, *UpdateStatement, *DeleteStatement:
+	default:
+		return
+	}
+	for _, table := range tables {
+		if se.optimizer.stats.NoteModifications(table, rows, se.config.Analyze) {
+			se.autoAnalyze(table)
+		}
+	}
+}
+
+func (se *SQLEngine) autoAnalyze(tableName string) {
+	if _, running := se.analyzing.LoadOrStore(tableName, struct{}{}); running {
+		return
+	}
+	select {
+	case <-se.shutdownChan:
+		se.analyzing.Delete(tableName)
+		return
+	default:
+	}
+
+	se.wg.Add(1)
+	go func() {
+		defer se.wg.Done()
+		defer se.analyzing.Delete(tableName)
+
+		ctx, cancel := context.WithCancel(context.Background())
+		defer cancel()
+		go func() {
+			select {
+			case <-se.shutdownChan:
+				cancel()
+			case <-ctx.Done():
+			}
+		}()
+		se.Analyze(ctx, tableName)
+	}()
+}
@@ -0,0 +1,176 @@
+package sql
+
+import (
+	"context"
+	"fmt"
+	"math"
+	"math/rand"
+	"sort"
+	"testing"
+
+	"mantisDB/transaction"
+)
+
+// skewedDocs fills doc_events with unique ids and a skewed data column:
+// half the rows are "hot", a tenth are NULL and the rest spread over 100
+// values.
+func skewedDocs(rows int) *memDocStore {
+	docs := newMemDocStore()
+	for i := 0; i < rows; i++ {
+		doc := Document{"id": int64(i)}
+		switch {
+		case i%10 == 9:
+			doc["data"] = nil
+		case i%2 == 0:
+			doc["data"] = "hot"
+		default:
+			doc["data"] = fmt.Sprintf("v-%03d", i%100)
+		}
+		docs.PutDocument(context.Background(), "doc_events", "", doc)
+	}
+	return docs
+}
+
+func TestAnalyzeTableStatistics(t *testing.T) {
+	qe := newTestExecutor(nil, skewedDocs(5000))
+	config := DefaultAnalyzeConfig()
+	config.SampleSize = 1000
+
+	stats, err := qe.AnalyzeTable(context.Background(), "doc_events", config)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if stats.RowCount != 5000 {
+		t.Fatalf("RowCount = %v, want 5000", stats.RowCount)
+	}
+
+	id := stats.Columns["id"]
+	if math.Abs(id.NDistinct-5000)/5000 > 0.05 {
+		t.Errorf("id NDistinct = %v, want about 5000", id.NDistinct)
+	}
+	if len(id.MostCommon) != 0 {
+		t.Errorf("unique column has most-common values %v", id.MostCommon)
+	}
+	if len(id.Histogram) < 2 || !sort.SliceIsSorted(id.Histogram, func(i, j int) bool {
+		return statsCompare(id.Histogram[i].Value, id.Histogram[j].Value) < 0
+	}) {
+		t.Errorf("id histogram is not a sorted list of bounds: %v", id.Histogram)
+	}
+	if id.Correlation < 0.99 {
+		t.Errorf("id correlation = %v, want about 1 for ids stored in order", id.Correlation)
+	}
+
+	data := stats.Columns["data"]
+	if data.NullFraction != 0.1 {
+		t.Errorf("data NullFraction = %v, want 0.1", data.NullFraction)
+	}
+	if len(data.MostCommon) == 0 || data.MostCommon[0].Value != "hot" {
+		t.Fatalf("data most-common values = %v, want hot first", data.MostCommon)
+	}
+
+	cm := NewCostModel(DefaultOptimizerConfig())
+	checks := []struct {
+		qual string
+		want float64
+	}{
+		{"id < 1250", 0.25},
+		{"id >= 4000", 0.2},
+		{"data = 'hot'", 0.5},
+		{"data = 'v-001'", 0.008},
+		{"data IS NULL", 0.1},
+		{"id < 1250 AND data = 'hot'", 0.125},
+	}
+	for _, c := range checks {
+		stmt, err := ParseSQL("SELECT id FROM doc_events WHERE " + c.qual)
+		if err != nil {
+			t.Fatalf("%s: %v", c.qual, err)
+		}
+		got := cm.Selectivity([]Expression{stmt.(*SelectStatement).Where}, stats)
+		if math.Abs(got-c.want) > 0.05 {
+			t.Errorf("selectivity of %s = %.4f, want about %.4f", c.qual, got, c.want)
+		}
+	}
+}
+
+func TestReservoirIsUniform(t *testing.T) {
+	const streamLen, size, trials = 10000, 100, 200
+	rng := rand.New(rand.NewSource(1))
+	var deciles [10]int
+	for trial := 0; trial < trials; trial++ {
+		r := newReservoir(size, rng)
+		for i := 0; i < streamLen; i++ {
+			if slot := r.slot(); slot == len(r.rows) {
+				r.rows = append(r.rows, sampledRow{pos: int64(i)})
+			} else if slot >= 0 {
+				r.rows[slot] = sampledRow{pos: int64(i)}
+			}
+		}
+		if len(r.rows) != size {
+			t.Fatalf("reservoir holds %d rows, want %d", len(r.rows), size)
+		}
+		for _, row := range r.rows {
+			deciles[row.pos*10/streamLen]++
+		}
+	}
+	want := trials * size / 10
+	for i, n := range deciles {
+		if math.Abs(float64(n-want))/float64(want) > 0.1 {
+			t.Errorf("decile %d sampled %d times, want about %d", i, n, want)
+		}
+	}
+}
+
+func TestNoteModificationsThreshold(t *testing.T) {
+	sc := NewStatisticsCollector()
+	sc.UpdateTableStats(&TableStatistics{TableName: "t", RowCount: 1000})
+	config := DefaultAnalyzeConfig()
+
+	// 50 + 10% of 1000 rows.
+	if sc.NoteModifications("t", 149, config) {
+		t.Fatal("threshold crossed too early")
+	}
+	if !sc.NoteModifications("t", 1, config) {
+		t.Fatal("threshold not crossed at 150 modifications")
+	}
+	if sc.NoteModifications("t", 1000, config) {
+		t.Fatal("threshold reported twice")
+	}
+	sc.UpdateTableStats(&TableStatistics{TableName: "t", RowCount: 1000})
+	if sc.NoteModifications("t", 1, config) {
+		t.Fatal("modifications not reset by new statistics")
+	}
+}
+
+func TestAnalyzePersistsStatistics(t *testing.T) {
+	kv := newMemKVStore()
+	sm := &StorageManager{kvStore: kv, docStore: skewedDocs(500)}
+	engine := NewSQLEngine(sm, transaction.NewTransactionSystem(nil), nil)
+	conn, err := engine.CreateConnection("test", "test")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer engine.CloseConnection(conn.ID)
+
+	if _, err := engine.ExecuteSQL(context.Background(), conn.ID, "ANALYZE doc_events"); err != nil {
+		t.Fatal(err)
+	}
+	if stats := engine.optimizer.stats.GetTableStats("doc_events"); stats == nil || stats.RowCount != 500 {
+		t.Fatalf("ANALYZE did not update the optimizer: %+v", stats)
+	}
+
+	restarted := NewSQLEngine(sm, transaction.NewTransactionSystem(nil), nil)
+	stats := restarted.optimizer.stats.GetTableStats("doc_events")
+	if stats == nil || stats.RowCount != 500 || stats.Columns["data"].MostCommon[0].Value != "hot" {
+		t.Fatalf("statistics were not restored: %+v", stats)
+	}
+
+	// Restored statistics feed the optimizer's row estimates.
+	stmt, _ := ParseSQL("SELECT id FROM doc_events WHERE data = 'hot'")
+	plan, err := restarted.optimizer.OptimizeQuery(stmt)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if math.Abs(plan.PlanRows-250) > 50 {
+		t.Errorf("estimated %v rows, want about 250", plan.PlanRows)
+	}
+}
@@ -41,6 +41,11 @@ type Visitor interface {
 	VisitRollbackTransactionStatement(*RollbackTransactionStatement) interface{}
 	VisitSavepointStatement(*SavepointStatement) interface{}
 	VisitReleaseSavepointStatement(*ReleaseSavepointStatement) interface{}
+	VisitPrepareStatement(*PrepareStatement) interface{}
+	VisitExecuteStatement(*ExecuteStatement) interface{}
+	VisitDeallocateStatement(*DeallocateStatement) interface{}
+	VisitAnalyzeStatement(*AnalyzeStatement) interface{}
+	VisitExplainStatement(*ExplainStatement) interface{}
 	VisitBinaryExpression(*BinaryExpression) interface{}
 	VisitUnaryExpression(*UnaryExpression) interface{}
 	VisitLiteralExpression(*LiteralExpression) interface{}
@@ -48,6 +53,7 @@ type Visitor interface {
 	VisitFunctionCall(*FunctionCall) interface{}
 	VisitSubquery(*Subquery) interface{}
 	VisitCaseExpression(*CaseExpression) interface{}
+	VisitParameterExpression(*ParameterExpression) interface{}
 }
 
 // Statements
@@ -56,6 +62,7 @@ type SelectStatement struct {
 	Distinct   bool
 	Fields     []SelectField
 	From       []TableReference
+	Joins      []*JoinClause
 	Where      Expression
 	GroupBy    []Expression
 	Having     Expression
@@ -232,6 +239,63 @@ func (s *ReleaseSavepointStatement) Accept(visitor Visitor) interface{} {
 	return visitor.VisitReleaseSavepointStatement(s)
 }
 
+// Prepared Statements
+
+type PrepareStatement struct {
+	Name       string
+	Query      Statement
+	ParamCount int
+}
+
+func (s *PrepareStatement) StatementNode() {}
+func (s *PrepareStatement) String() string { return "PREPARE" }
+func (s *PrepareStatement) Accept(visitor Visitor) interface{} {
+	return visitor.VisitPrepareStatement(s)
+}
+
+type ExecuteStatement struct {
+	Name   string
+	Params []Expression
+}
+
+func (s *ExecuteStatement) StatementNode() {}
+func (s *ExecuteStatement) String() string { return "EXECUTE" }
+func (s *ExecuteStatement) Accept(visitor Visitor) interface{} {
+	return visitor.VisitExecuteStatement(s)
+}
+
+type DeallocateStatement struct {
+	Name string // empty for DEALLOCATE ALL
+}
+
+func (s *DeallocateStatement) StatementNode() {}
+func (s *DeallocateStatement) String() string { return "DEALLOCATE" }
+func (s *DeallocateStatement) Accept(visitor Visitor) interface{} {
+	return visitor.VisitDeallocateStatement(s)
+}
+
+type AnalyzeStatement struct {
+	Tables []string // empty for every known table
+}
+
+func (s *AnalyzeStatement) StatementNode() {}
+func (s *AnalyzeStatement) String() string { return "ANALYZE" }
+func (s *AnalyzeStatement) Accept(visitor Visitor) interface{} {
+	return visitor.VisitAnalyzeStatement(s)
+}
+
+type ExplainStatement struct {
+	Analyze   bool // run the statement and report actual figures
+	Verbose   bool
+	Statement Statement
+}
+
+func (s *ExplainStatement) StatementNode() {}
+func (s *ExplainStatement) String() string { return "EXPLAIN" }
+func (s *ExplainStatement) Accept(visitor Visitor) interface{} {
+	return visitor.VisitExplainStatement(s)
+}
+
 // Expressions
 
 type BinaryExpression struct {
@@ -270,6 +334,17 @@ func (e *LiteralExpression) Accept(visitor Visitor) interface{} {
 	return visitor.VisitLiteralExpression(e)
 }
 
+// ParameterExpression is a bind parameter, $1 or ?, numbered from 1.
+type ParameterExpression struct {
+	Index int
+}
+
+func (e *ParameterExpression) ExpressionNode() {}
+func (e *ParameterExpression) String() string  { return fmt.Sprintf("$%d", e.Index) }
+func (e *ParameterExpression) Accept(visitor Visitor) interface{} {
+	return visitor.VisitParameterExpression(e)
+}
+
 type IdentifierExpression struct {
 	Name   string
 	Schema string
@@ -0,0 +1,768 @@
+package sql
+
+import (
+	"bytes"
+	"context"
+	"encoding/binary"
+	"fmt"
+	"math"
+	"slices"
+	"sort"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+// Index keys are the indexed column values in an order-preserving encoding
+// followed by indexKeySeparator and the row ID, so entries with equal
+// column values stay distinct and a byte range of the B-tree is a range of
+// column values. Each value starts with a type tag; NULLs sort last, as
+// they do in ORDER BY.
+const (
+	indexTagNumber = 0x02
+	indexTagString = 0x03
+	indexTagBool   = 0x04
+	indexTagTime   = 0x05
+	indexTagOther  = 0x06
+	indexTagNull   = 0x07
+
+	indexKeySeparator = 0x00
+
+	// indexKeyMax is greater than any byte that can follow an encoded
+	// value, so prefix+indexKeyMax bounds every key with that prefix.
+	indexKeyMax = 0xff
+)
+
+// appendIndexValue appends the order-preserving encoding of v. Numbers are
+// ordered by their float64 value and, for integers, then exactly, so
+// integers beyond 2^53 keep their order. An integral float encodes as the
+// equal integer so 1 and 1.0 are the same key.
+func appendIndexValue(buf []byte, v any) []byte {
+	if v == nil {
+		return append(buf, indexTagNull)
+	}
+	if f, ok := v.(float64); ok && f == math.Trunc(f) && f >= math.MinInt64 && f < math.MaxInt64 {
+		v = int64(f)
+	}
+	if f, ok := toFloat64(v); ok {
+		buf = append(buf, indexTagNumber)
+		buf = binary.BigEndian.AppendUint64(buf, sortableFloatBits(f))
+		if i, ok := toInt64(v); ok {
+			buf = append(buf, 0)
+			return binary.BigEndian.AppendUint64(buf, uint64(i)^(1<<63))
+		}
+		return append(buf, 1)
+	}
+	switch x := v.(type) {
+	case string:
+		return appendIndexString(append(buf, indexTagString), x)
+	case []byte:
+		return appendIndexString(append(buf, indexTagString), string(x))
+	case bool:
+		if x {
+			return append(buf, indexTagBool, 1)
+		}
+		return append(buf, indexTagBool, 0)
+	case time.Time:
+		buf = append(buf, indexTagTime)
+		return binary.BigEndian.AppendUint64(buf, uint64(x.UnixNano())^(1<<63))
+	default:
+		return appendIndexString(append(buf, indexTagOther), fmt.Sprintf("%T:%v", v, v))
+	}
+}
+
+// sortableFloatBits maps a float64 to bits whose unsigned order is the
+// numeric order.
+func sortableFloatBits(f float64) uint64 {
+	bits := math.Float64bits(f)
+	if bits&(1<<63) != 0 {
+		return ^bits
+	}
+	return bits | 1<<63
+}
+
+// appendIndexString escapes 0x00 as 0x00 0xff and terminates the string
+// with 0x00 0x01, which keeps prefixes ordered before their extensions.
+func appendIndexString(buf []byte, s string) []byte {
+	for i := 0; i < len(s); i++ {
+		if s[i] == 0 {
+			buf = append(buf, 0, 0xff)
+		} else {
+			buf = append(buf, s[i])
+		}
+	}
+	return append(buf, 0, 1)
+}
+
+// decodeIndexValue decodes one value from the front of key and returns the
+// remaining bytes.
+func decodeIndexValue(key []byte) (any, []byte, error) {
+	if len(key) == 0 {
+		return nil, nil, fmt.Errorf("truncated index key")
+	}
+	tag, rest := key[0], key[1:]
+	switch tag {
+	case indexTagNull:
+		return nil, rest, nil
+	case indexTagNumber:
+		if len(rest) < 9 {
+			return nil, nil, fmt.Errorf("truncated numeric index key")
+		}
+		bits := binary.BigEndian.Uint64(rest)
+		if rest[8] == 0 {
+			if len(rest) < 17 {
+				return nil, nil, fmt.Errorf("truncated integer index key")
+			}
+			return int64(binary.BigEndian.Uint64(rest[9:]) ^ (1 << 63)), rest[17:], nil
+		}
+		if bits&(1<<63) != 0 {
+			bits &^= 1 << 63
+		} else {
+			bits = ^bits
+		}
+		return math.Float64frombits(bits), rest[9:], nil
+	case indexTagString, indexTagOther:
+		var sb strings.Builder
+		for i := 0; i+1 < len(rest); i++ {
+			if rest[i] != 0 {
+				sb.WriteByte(rest[i])
+				continue
+			}
+			if rest[i+1] == 1 {
+				return sb.String(), rest[i+2:], nil
+			}
+			sb.WriteByte(0)
+			i++
+		}
+		return nil, nil, fmt.Errorf("unterminated string in index key")
+	case indexTagBool:
+		if len(rest) < 1 {
+			return nil, nil, fmt.Errorf("truncated boolean index key")
+		}
+		return rest[0] == 1, rest[1:], nil
+	case indexTagTime:
+		if len(rest) < 8 {
+			return nil, nil, fmt.Errorf("truncated timestamp index key")
+		}
+		return time.Unix(0, int64(binary.BigEndian.Uint64(rest)^(1<<63))), rest[8:], nil
+	default:
+		return nil, nil, fmt.Errorf("unknown index key tag %#x", tag)
+	}
+}
+
+// encodeIndexEntry builds the B-tree key of a row's index entry.
+func encodeIndexEntry(values []any, rowID []byte) []byte {
+	buf := make([]byte, 0, 16*len(values)+1+len(rowID))
+	for _, v := range values {
+		buf = appendIndexValue(buf, v)
+	}
+	buf = append(buf, indexKeySeparator)
+	return append(buf, rowID...)
+}
+
+// decodeIndexEntry returns the n column values at the front of an entry
+// key and the length of their encoding.
+func decodeIndexEntry(key []byte, n int) ([]any, int, error) {
+	values := make([]any, n)
+	rest := key
+	for i := range values {
+		v, r, err := decodeIndexValue(rest)
+		if err != nil {
+			return nil, 0, err
+		}
+		values[i], rest = v, r
+	}
+	return values, len(key) - len(rest), nil
+}
+
+// indexKeyRange turns scan keys into the [lower, upper) byte range of the
+// entries that can satisfy them: equality keys on leading index columns
+// extend a common prefix and comparisons on the next column bound it.
+// Keys the range cannot express are left for the caller to recheck. Key
+// values must already be literals.
+func indexKeyRange(columns []string, keys []ScanKey) (lower, upper []byte, err error) {
+	keyValue := func(key ScanKey) (any, error) {
+		lit, ok := key.Value.(*LiteralExpression)
+		if !ok {
+			return nil, fmt.Errorf("index scan key on %s is not a constant", key.Column)
+		}
+		return lit.Value, nil
+	}
+
+	var prefix []byte
+	for _, col := range columns {
+		var eq *ScanKey
+		var lo, hi *ScanKey
+		for i := range keys {
+			if !strings.EqualFold(keys[i].Column, col) {
+				continue
+			}
+			switch keys[i].Operator {
+			case OpEqual:
+				eq = &keys[i]
+			case OpGreater, OpGreaterEqual:
+				lo = &keys[i]
+			case OpLess, OpLessEqual:
+				hi = &keys[i]
+			}
+		}
+		if eq != nil {
+			v, err := keyValue(*eq)
+			if err != nil {
+				return nil, nil, err
+			}
+			prefix = appendIndexValue(prefix, v)
+			continue
+		}
+		if lo == nil && hi == nil {
+			break
+		}
+
+		// A comparison never matches NULLs or values of another type, so
+		// a missing bound stops at the edge of the other bound's type.
+		var tag byte
+		if lo != nil {
+			v, err := keyValue(*lo)
+			if err != nil {
+				return nil, nil, err
+			}
+			if v == nil {
+				return nil, nil, nil
+			}
+			lower = appendIndexValue(slices.Clip(prefix), v)
+			tag = lower[len(prefix)]
+			if lo.Operator == OpGreater {
+				lower = append(lower, indexKeyMax)
+			}
+		}
+		if hi != nil {
+			v, err := keyValue(*hi)
+			if err != nil {
+				return nil, nil, err
+			}
+			if v == nil {
+				return nil, nil, nil
+			}
+			upper = appendIndexValue(slices.Clip(prefix), v)
+			tag = upper[len(prefix)]
+			if hi.Operator == OpLessEqual {
+				upper = append(upper, indexKeyMax)
+			}
+		}
+		if lower == nil {
+			lower = append(slices.Clip(prefix), tag)
+		}
+		if upper == nil {
+			upper = append(slices.Clip(prefix), tag+1)
+		}
+		return lower, upper, nil
+	}
+	return prefix, append(slices.Clip(prefix), indexKeyMax), nil
+}
+
+// btreeDegree is the minimum degree of index B-trees: every node but the
+// root holds between btreeDegree-1 and 2*btreeDegree-1 items.
+const btreeDegree = 32
+
+type btreeItem struct {
+	key, value []byte
+}
+
+type btreeNode struct {
+	items    []btreeItem
+	children []*btreeNode // nil for leaves
+}
+
+// btree is an in-memory B-tree of byte-string keys. It is not safe for
+// concurrent use; btreeIndex serializes access.
+type btree struct {
+	root *btreeNode
+	size int
+}
+
+// find returns the position of the first item not less than key and
+// whether that item equals key.
+func (n *btreeNode) find(key []byte) (int, bool) {
+	i := sort.Search(len(n.items), func(i int) bool {
+		return bytes.Compare(n.items[i].key, key) >= 0
+	})
+	return i, i < len(n.items) && bytes.Equal(n.items[i].key, key)
+}
+
+// get returns the value stored under key.
+func (t *btree) get(key []byte) ([]byte, bool) {
+	for n := t.root; n != nil; {
+		i, found := n.find(key)
+		if found {
+			return n.items[i].value, true
+		}
+		if n.children == nil {
+			break
+		}
+		n = n.children[i]
+	}
+	return nil, false
+}
+
+// insert stores item, replacing an item with the same key. Full nodes are
+// split on the way down so the insert never has to back up.
+func (t *btree) insert(item btreeItem) (replaced bool) {
+	if t.root == nil {
+		t.root = &btreeNode{items: []btreeItem{item}}
+		t.size++
+		return false
+	}
+	if len(t.root.items) == 2*btreeDegree-1 {
+		t.root = &btreeNode{children: []*btreeNode{t.root}}
+		t.root.splitChild(0)
+	}
+	if replaced = t.root.insert(item); !replaced {
+		t.size++
+	}
+	return replaced
+}
+
+func (n *btreeNode) insert(item btreeItem) bool {
+	for {
+		i, found := n.find(item.key)
+		if found {
+			n.items[i] = item
+			return true
+		}
+		if n.children == nil {
+			n.items = slices.Insert(n.items, i, item)
+			return false
+		}
+		if len(n.children[i].items) == 2*btreeDegree-1 {
+			n.splitChild(i)
+			switch c := bytes.Compare(item.key, n.items[i].key); {
+			case c == 0:
+				n.items[i] = item
+				return true
+			case c > 0:
+				i++
+			}
+		}
+		n = n.children[i]
+	}
+}
+
+// splitChild moves the upper half of the full child i into a new sibling
+// and its median item up into n.
+func (n *btreeNode) splitChild(i int) {
+	child := n.children[i]
+	median := child.items[btreeDegree-1]
+	sibling := &btreeNode{items: slices.Clone(child.items[btreeDegree:])}
+	clear(child.items[btreeDegree-1:])
+	child.items = child.items[:btreeDegree-1]
+	if child.children != nil {
+		sibling.children = slices.Clone(child.children[btreeDegree:])
+		clear(child.children[btreeDegree:])
+		child.children = child.children[:btreeDegree]
+	}
+	n.items = slices.Insert(n.items, i, median)
+	n.children = slices.Insert(n.children, i+1, sibling)
+}
+
+// delete removes key. Nodes on the way down are topped up to btreeDegree
+// items first, so removing from a leaf never leaves it underfull.
+func (t *btree) delete(key []byte) bool {
+	if t.root == nil {
+		return false
+	}
+	removed := t.root.remove(key)
+	if len(t.root.items) == 0 {
+		if t.root.children == nil {
+			t.root = nil
+		} else {
+			t.root = t.root.children[0]
+		}
+	}
+	if removed {
+		t.size--
+	}
+	return removed
+}
+
+func (n *btreeNode) remove(key []byte) bool {
+	i, found := n.find(key)
+	if n.children == nil {
+		if !found {
+			return false
+		}
+		n.items = slices.Delete(n.items, i, i+1)
+		return true
+	}
+	if found {
+		switch {
+		case len(n.children[i].items) >= btreeDegree:
+			pred := n.children[i].max()
+			n.items[i] = pred
+			return n.children[i].remove(pred.key)
+		case len(n.children[i+1].items) >= btreeDegree:
+			succ := n.children[i+1].min()
+			n.items[i] = succ
+			return n.children[i+1].remove(succ.key)
+		default:
+			n.merge(i)
+			return n.children[i].remove(key)
+		}
+	}
+	if len(n.children[i].items) < btreeDegree {
+		i = n.fill(i)
+	}
+	return n.children[i].remove(key)
+}
+
+// fill tops child i up to btreeDegree items by rotating an item from a
+// sibling or merging with one. It returns the index of the child that now
+// covers child i's key range.
+func (n *btreeNode) fill(i int) int {
+	child := n.children[i]
+	switch {
+	case i > 0 && len(n.children[i-1].items) >= btreeDegree:
+		left := n.children[i-1]
+		child.items = slices.Insert(child.items, 0, n.items[i-1])
+		n.items[i-1] = left.items[len(left.items)-1]
+		left.items = slices.Delete(left.items, len(left.items)-1, len(left.items))
+		if left.children != nil {
+			child.children = slices.Insert(child.children, 0, left.children[len(left.children)-1])
+			left.children = slices.Delete(left.children, len(left.children)-1, len(left.children))
+		}
+		return i
+	case i < len(n.items) && len(n.children[i+1].items) >= btreeDegree:
+		right := n.children[i+1]
+		child.items = append(child.items, n.items[i])
+		n.items[i] = right.items[0]
+		right.items = slices.Delete(right.items, 0, 1)
+		if right.children != nil {
+			child.children = append(child.children, right.children[0])
+			right.children = slices.Delete(right.children, 0, 1)
+		}
+		return i
+	case i < len(n.items):
+		n.merge(i)
+		return i
+	default:
+		n.merge(i - 1)
+		return i - 1
+	}
+}
+
+// merge folds item i and child i+1 into child i.
+func (n *btreeNode) merge(i int) {
+	child, right := n.children[i], n.children[i+1]
+	child.items = append(append(child.items, n.items[i]), right.items...)
+	child.children = append(child.children, right.children...)
+	n.items = slices.Delete(n.items, i, i+1)
+	n.children = slices.Delete(n.children, i+1, i+2)
+}
+
+func (n *btreeNode) min() btreeItem {
+	for n.children != nil {
+		n = n.children[0]
+	}
+	return n.items[0]
+}
+
+func (n *btreeNode) max() btreeItem {
+	for n.children != nil {
+		n = n.children[len(n.children)-1]
+	}
+	return n.items[len(n.items)-1]
+}
+
+// ascend calls fn for every item not less than from, in key order, until
+// fn returns false.
+func (t *btree) ascend(from []byte, fn func(btreeItem) bool) {
+	if t.root != nil {
+		t.root.ascend(from, fn)
+	}
+}
+
+func (n *btreeNode) ascend(from []byte, fn func(btreeItem) bool) bool {
+	i, _ := n.find(from)
+	for ; i < len(n.items); i++ {
+		if n.children != nil && !n.children[i].ascend(from, fn) {
+			return false
+		}
+		if !fn(n.items[i]) {
+			return false
+		}
+	}
+	if n.children != nil {
+		return n.children[len(n.items)].ascend(from, fn)
+	}
+	return true
+}
+
+// btreeIndex is a secondary index held in a B-tree. Entry keys come from
+// encodeIndexEntry and entry values are row IDs.
+type btreeIndex struct {
+	def      IndexDefinition
+	mu       sync.RWMutex
+	tree     btree
+	bytes    int64
+	lastUsed atomic.Int64
+}
+
+// Scan returns the entries matching a single scan key.
+func (idx *btreeIndex) Scan(ctx context.Context, key ScanKey) (Iterator, error) {
+	return idx.ScanRange(ctx, []ScanKey{key})
+}
+
+// ScanRange returns, in key order, the entries in the range the scan keys
+// bound. Entries outside the keys' reach on later columns are included and
+// must be rechecked by the caller.
+func (idx *btreeIndex) ScanRange(ctx context.Context, keys []ScanKey) (Iterator, error) {
+	lower, upper, err := indexKeyRange(idx.def.Columns, keys)
+	if err != nil {
+		return nil, err
+	}
+	idx.lastUsed.Store(time.Now().UnixNano())
+	if lower == nil {
+		// A comparison with NULL matches nothing.
+		return &btreeIterator{index: idx, done: true}, nil
+	}
+	return &btreeIterator{index: idx, next: lower, upper: upper}, nil
+}
+
+// Insert adds an entry. A unique index rejects an entry whose column
+// values, none of them NULL, are already indexed for another row.
+func (idx *btreeIndex) Insert(ctx context.Context, key, value []byte) error {
+	idx.mu.Lock()
+	defer idx.mu.Unlock()
+	if idx.def.Unique {
+		values, n, err := decodeIndexEntry(key, len(idx.def.Columns))
+		if err != nil {
+			return err
+		}
+		if !slices.Contains(values, nil) {
+			prefix := key[:n]
+			upper := append(slices.Clip(prefix), indexKeyMax)
+			duplicate := false
+			idx.tree.ascend(prefix, func(item btreeItem) bool {
+				if bytes.Compare(item.key, upper) >= 0 {
+					return false
+				}
+				duplicate = !bytes.Equal(item.value, value)
+				return !duplicate
+			})
+			if duplicate {
+				return fmt.Errorf("duplicate key value violates unique index %q", idx.def.Name)
+			}
+		}
+	}
+	if idx.tree.insert(btreeItem{key: key, value: value}) {
+		return nil
+	}
+	idx.bytes += int64(len(key) + len(value))
+	return nil
+}
+
+// Delete removes an entry.
+func (idx *btreeIndex) Delete(ctx context.Context, key []byte) error {
+	idx.mu.Lock()
+	defer idx.mu.Unlock()
+	if value, ok := idx.tree.get(key); ok {
+		idx.tree.delete(key)
+		idx.bytes -= int64(len(key) + len(value))
+	}
+	return nil
+}
+
+// Stats reports the size of the index in 8KB pages.
+func (idx *btreeIndex) Stats() IndexStats {
+	idx.mu.RLock()
+	defer idx.mu.RUnlock()
+	return IndexStats{
+		Pages:    idx.bytes/8192 + 1,
+		Tuples:   int64(idx.tree.size),
+		Size:     idx.bytes,
+		LastUsed: time.Unix(0, idx.lastUsed.Load()),
+	}
+}
+
+// btreeIteratorBatch is how many entries an iterator copies out per visit
+// to the tree, so concurrent writers wait for a batch rather than a scan.
+const btreeIteratorBatch = 256
+
+// btreeIterator walks a key range in batches. Between batches it holds no
+// lock and resumes after the last key it returned, so it sees entries
+// added ahead of it and skips ones deleted before it reaches them.
+type btreeIterator struct {
+	index *btreeIndex
+	next  []byte // smallest key not yet visited
+	upper []byte // exclusive
+	batch []btreeItem
+	pos   int
+	done  bool
+}
+
+func (it *btreeIterator) Next() bool {
+	it.pos++
+	if it.pos < len(it.batch) {
+		return true
+	}
+	if it.done {
+		return false
+	}
+	it.batch, it.pos = it.batch[:0], 0
+	it.index.mu.RLock()
+	it.index.tree.ascend(it.next, func(item btreeItem) bool {
+		if bytes.Compare(item.key, it.upper) >= 0 {
+			it.done = true
+			return false
+		}
+		it.batch = append(it.batch, item)
+		return len(it.batch) < btreeIteratorBatch
+	})
+	it.index.mu.RUnlock()
+	if len(it.batch) < btreeIteratorBatch {
+		it.done = true
+	}
+	if len(it.batch) == 0 {
+		return false
+	}
+	last := it.batch[len(it.batch)-1].key
+	it.next = append(slices.Clip(last), 0)
+	return true
+}
+
+func (it *btreeIterator) Value() ([]byte, []byte, error) {
+	if it.pos >= len(it.batch) {
+		return nil, nil, fmt.Errorf("iterator is not positioned on an entry")
+	}
+	item := it.batch[it.pos]
+	return item.key, item.value, nil
+}
+
+func (it *btreeIterator) Error() error { return nil }
+
+func (it *btreeIterator) Close() error {
+	it.batch, it.done = nil, true
+	return nil
+}
+
+// BTreeIndexManager keeps B-tree secondary indexes in memory. Indexes
+// start empty; the executor builds them from their table and writers keep
+// them current through InsertRow and DeleteRow.
+type BTreeIndexManager struct {
+	mu      sync.RWMutex
+	indexes map[string]*btreeIndex
+}
+
+// NewBTreeIndexManager creates an empty index manager.
+func NewBTreeIndexManager() *BTreeIndexManager {
+	return &BTreeIndexManager{indexes: make(map[string]*btreeIndex)}
+}
+
+// CreateIndex registers an empty index.
+func (m *BTreeIndexManager) CreateIndex(ctx context.Context, indexDef IndexDefinition) error {
+	if indexDef.Type != IndexTypeBTree {
+		return fmt.Errorf("index %s: only B-tree indexes are supported", indexDef.Name)
+	}
+	if len(indexDef.Columns) == 0 {
+		return fmt.Errorf("index %s has no columns", indexDef.Name)
+	}
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	if _, exists := m.indexes[indexDef.Name]; exists {
+		return fmt.Errorf("index %s already exists", indexDef.Name)
+	}
+	m.indexes[indexDef.Name] = &btreeIndex{def: indexDef}
+	return nil
+}
+
+// DropIndex removes an index.
+func (m *BTreeIndexManager) DropIndex(ctx context.Context, indexName string) error {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	if _, exists := m.indexes[indexName]; !exists {
+		return fmt.Errorf("index %s does not exist", indexName)
+	}
+	delete(m.indexes, indexName)
+	return nil
+}
+
+// GetIndex returns an index by name.
+func (m *BTreeIndexManager) GetIndex(ctx context.Context, indexName string) (Index, error) {
+	m.mu.RLock()
+	defer m.mu.RUnlock()
+	idx, exists := m.indexes[indexName]
+	if !exists {
+		return nil, fmt.Errorf("index %s does not exist", indexName)
+	}
+	return idx, nil
+}
+
+// ListIndexes returns the definitions of a table's indexes, by name.
+func (m *BTreeIndexManager) ListIndexes(ctx context.Context, tableName string) ([]IndexDefinition, error) {
+	m.mu.RLock()
+	defer m.mu.RUnlock()
+	var defs []IndexDefinition
+	for _, idx := range m.indexes {
+		if idx.def.Table == tableName {
+			defs = append(defs, idx.def)
+		}
+	}
+	sort.Slice(defs, func(i, j int) bool { return defs[i].Name < defs[j].Name })
+	return defs, nil
+}
+
+// IndexScan scans an index with a single key.
+func (m *BTreeIndexManager) IndexScan(ctx context.Context, indexName string, scanKey ScanKey) (Iterator, error) {
+	idx, err := m.GetIndex(ctx, indexName)
+	if err != nil {
+		return nil, err
+	}
+	return idx.Scan(ctx, scanKey)
+}
+
+// InsertRow adds a row to every index of its table. row maps lowercase
+// column names to values. If a unique index rejects the row, the entries
+// already added are removed again.
+func (m *BTreeIndexManager) InsertRow(ctx context.Context, tableName string, rowID []byte, row map[string]any) error {
+	indexes := m.tableIndexes(tableName)
+	for i, idx := range indexes {
+		if err := idx.Insert(ctx, idx.entryKey(rowID, row), rowID); err != nil {
+			for _, added := range indexes[:i] {
+				added.Delete(ctx, added.entryKey(rowID, row))
+			}
+			return err
+		}
+	}
+	return nil
+}
+
+// DeleteRow removes a row from every index of its table. row must hold the
+// values the row was indexed with.
+func (m *BTreeIndexManager) DeleteRow(ctx context.Context, tableName string, rowID []byte, row map[string]any) error {
+	for _, idx := range m.tableIndexes(tableName) {
+		if err := idx.Delete(ctx, idx.entryKey(rowID, row)); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+func (m *BTreeIndexManager) tableIndexes(tableName string) []*btreeIndex {
+	m.mu.RLock()
+	defer m.mu.RUnlock()
+	var indexes []*btreeIndex
+	for _, idx := range m.indexes {
+		if idx.def.Table == tableName {
+			indexes = append(indexes, idx)
+		}
+	}
+	return indexes
+}
+
+func (idx *btreeIndex) entryKey(rowID []byte, row map[string]any) []byte {
+	values := make([]any, len(idx.def.Columns))
+	for i, col := range idx.def.Columns {
+		values[i] = row[strings.ToLower(col)]
+	}
+	return encodeIndexEntry(values, rowID)
+}
@@ -438,6 +438,11 @@ func (dtc *DistributedTransactionCoordinator) extractTablesFromStatement(stmt St
 				tables = append(tables, table.Name)
 			}
 		}
+		for _, join := range s.Joins {
+			if join.Table != nil && join.Table.Name != "" {
+				tables = append(tables, join.Table.Name)
+			}
+		}
 		return tables
 	case *InsertStatement:
 		if s.Table != nil && s.Table.Name != "" {
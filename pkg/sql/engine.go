@@ -4,6 +4,7 @@ import (
 	"context"
 	"fmt"
 	"sync"
+	"sync/atomic"
 	"time"
 
 	"mantisDB/transaction"
@@ -20,6 +21,12 @@ type SQLEngine struct {
 	config             *SQLEngineConfig
 	activeConnections  map[string]*SQLConnection
 	connectionMutex    sync.RWMutex
+	prepared           map[string]*PreparedStatement
+	preparedMutex      sync.RWMutex
+	prepareSeq         atomic.Uint64
+	statsStore         StatisticsStore
+	analyzing          sync.Map // table name -> struct{} while auto-analyze runs
+	slowPlans          *SlowPlanLog
 	shutdownChan       chan struct{}
 	wg                 sync.WaitGroup
 }
@@ -33,6 +40,8 @@ type SQLEngineConfig struct {
 	IdleTransactionTimeout time.Duration
 	EnableDistributedTxns  bool
 	DefaultIsolationLevel  transaction.IsolationLevel
+	Analyze                *AnalyzeConfig
+	Profiling              *ProfilingConfig
 }
 
 // SQLConnection represents a SQL connection with transaction context
@@ -47,6 +56,7 @@ type SQLConnection struct {
 	AutoCommit     bool
 	IsolationLevel transaction.IsolationLevel
 	ReadOnly       bool
+	prepared       map[string]*PreparedStatement
 	mutex          sync.RWMutex
 }
 
@@ -71,6 +81,8 @@ func DefaultSQLEngineConfig() *SQLEngineConfig {
 		IdleTransactionTimeout: 5 * time.Minute,
 		EnableDistributedTxns:  true,
 		DefaultIsolationLevel:  transaction.ReadCommitted,
+		Analyze:                DefaultAnalyzeConfig(),
+		Profiling:              DefaultProfilingConfig(),
 	}
 }
 
@@ -97,6 +109,11 @@ func NewSQLEngine(storageManager *StorageManager, txnSystem *transaction.Transac
 	// Create query optimizer
 	optimizer := NewQueryOptimizer()
 
+	slowPlanLogSize := DefaultProfilingConfig().SlowPlanLogSize
+	if config.Profiling != nil {
+		slowPlanLogSize = config.Profiling.SlowPlanLogSize
+	}
+
 	engine := &SQLEngine{
 		optimizer:          optimizer,
 		executor:           executor,
@@ -105,9 +122,19 @@ func NewSQLEngine(storageManager *StorageManager, txnSystem *transaction.Transac
 		storageManager:     storageManager,
 		config:             config,
 		activeConnections:  make(map[string]*SQLConnection),
+		prepared:           make(map[string]*PreparedStatement),
+		slowPlans:          NewSlowPlanLog(slowPlanLogSize),
 		shutdownChan:       make(chan struct{}),
 	}
 
+	// Statistics from earlier ANALYZE runs and index definitions live in
+	// the KV store
+	if storageManager != nil && storageManager.kvStore != nil {
+		engine.statsStore = NewKVStatisticsStore(storageManager.kvStore)
+		engine.loadStatistics(context.Background())
+		engine.loadIndexes(context.Background())
+	}
+
 	// Register storage engine participants for distributed transactions
 	if config.EnableDistributedTxns {
 		engine.registerStorageParticipants()
@@ -137,6 +164,7 @@ func (se *SQLEngine) CreateConnection(userID, database string) (*SQLConnection,
 		AutoCommit:     true,
 		IsolationLevel: se.config.DefaultIsolationLevel,
 		ReadOnly:       false,
+		prepared:       make(map[string]*PreparedStatement),
 	}
 
 	se.activeConnections[conn.ID] = conn
@@ -170,24 +198,17 @@ func (se *SQLEngine) CloseConnection(connectionID string) error {
 
 // ExecuteSQL executes a SQL statement
 func (se *SQLEngine) ExecuteSQL(ctx context.Context, connectionID, sqlText string) (*SQLResult, error) {
-	// Get connection
-	se.connectionMutex.RLock()
-	conn, exists := se.activeConnections[connectionID]
-	se.connectionMutex.RUnlock()
-
-	if !exists {
-		return nil, fmt.Errorf("connection %s not found", connectionID)
+	conn, err := se.touchConnection(connectionID)
+	if err != nil {
+		return nil, err
 	}
 
-	// Update last activity
-	conn.mutex.Lock()
-	conn.LastActivity = time.Now()
-	conn.mutex.Unlock()
-
 	startTime := time.Now()
+	ctx = se.sampleQuery(ctx, sqlText)
 
-	// Parse SQL
-	stmt, err := ParseSQL(sqlText)
+	// Parse SQL, or reuse the statement and plan of an earlier query that
+	// differed only in its literals
+	stmt, plan, params, err := se.compileSQL(sqlText)
 	if err != nil {
 		return &SQLResult{
 			Error:         fmt.Errorf("parse error: %w", err),
@@ -207,9 +228,43 @@ func (se *SQLEngine) ExecuteSQL(ctx context.Context, connectionID, sqlText strin
 		return se.executeSavepoint(ctx, conn, s, startTime)
 	case *ReleaseSavepointStatement:
 		return se.executeReleaseSavepoint(ctx, conn, s, startTime)
+	case *PrepareStatement:
+		return se.executePrepare(conn, s, startTime)
+	case *ExecuteStatement:
+		return se.executeExecute(ctx, conn, s, startTime)
+	case *DeallocateStatement:
+		return se.executeDeallocate(conn, s, startTime)
+	case *AnalyzeStatement:
+		return se.executeAnalyze(ctx, s, startTime)
+	case *ExplainStatement:
+		return se.executeExplain(ctx, conn, s, sqlText, startTime)
+	case *CreateIndexStatement:
+		return se.executeCreateIndex(ctx, s, startTime)
+	case *DropIndexStatement:
+		return se.executeDropIndex(ctx, s, startTime)
+	case *CreateTableStatement, *DropTableStatement, *AlterTableStatement:
+		// Cached plans may reference the old schema
+		se.optimizer.InvalidatePlans()
+		return se.executeDataStatement(ctx, conn, stmt, nil, nil, startTime)
 	default:
-		return se.executeDataStatement(ctx, conn, stmt, startTime)
+		return se.executeDataStatement(ctx, conn, stmt, plan, params, startTime)
+	}
+}
+
+// touchConnection looks up a connection and records activity on it.
+func (se *SQLEngine) touchConnection(connectionID string) (*SQLConnection, error) {
+	se.connectionMutex.RLock()
+	conn, exists := se.activeConnections[connectionID]
+	se.connectionMutex.RUnlock()
+
+	if !exists {
+		return nil, fmt.Errorf("connection %s not found", connectionID)
 	}
+
+	conn.mutex.Lock()
+	conn.LastActivity = time.Now()
+	conn.mutex.Unlock()
+	return conn, nil
 }
 
 // executeBeginTransaction executes BEGIN TRANSACTION
@@ -384,43 +439,16 @@ func (se *SQLEngine) executeReleaseSavepoint(ctx context.Context, conn *SQLConne
 	}, nil
 }
 
-// executeDataStatement executes data manipulation statements (SELECT, INSERT, UPDATE, DELETE)
-func (se *SQLEngine) executeDataStatement(ctx context.Context, conn *SQLConnection, stmt Statement, startTime time.Time) (*SQLResult, error) {
+// executeDataStatement executes data manipulation statements (SELECT, INSERT, UPDATE, DELETE).
+// plan may be nil; params are bound to the statement's parameters.
+func (se *SQLEngine) executeDataStatement(ctx context.Context, conn *SQLConnection, stmt Statement, plan *QueryPlan, params []any, startTime time.Time) (*SQLResult, error) {
 	// Handle auto-commit mode
-	var txn *SQLTransaction
-	var distTxn *DistributedTransaction
-	var autoCommitTxn bool
-
-	conn.mutex.Lock()
-	if conn.AutoCommit && conn.CurrentTxn == nil {
-		// Start auto-commit transaction
-		beginStmt := &BeginTransactionStatement{
-			ReadOnly: conn.ReadOnly,
-		}
-		isolation := SQLIsolationLevel(conn.IsolationLevel)
-		beginStmt.IsolationLevel = &isolation
-
-		var err error
-		txn, err = se.txnManager.BeginTransaction(ctx, beginStmt)
-		if err != nil {
-			conn.mutex.Unlock()
-			return &SQLResult{
-				Error:         fmt.Errorf("failed to begin auto-commit transaction: %w", err),
-				ExecutionTime: time.Since(startTime),
-			}, err
-		}
-		autoCommitTxn = true
-	} else {
-		txn = conn.CurrentTxn
-		distTxn = conn.CurrentDistTxn
-	}
-	conn.mutex.Unlock()
-
-	if txn == nil {
+	txn, distTxn, autoCommitTxn, err := se.statementTransaction(ctx, conn)
+	if err != nil {
 		return &SQLResult{
-			Error:         fmt.Errorf("no active transaction"),
+			Error:         err,
 			ExecutionTime: time.Since(startTime),
-		}, fmt.Errorf("no active transaction")
+		}, err
 	}
 
 	// Determine if this requires distributed transaction coordination
@@ -428,7 +456,6 @@ func (se *SQLEngine) executeDataStatement(ctx context.Context, conn *SQLConnecti
 	requiresDistTxn := se.requiresDistributedTransaction(tables)
 
 	var result *ResultSet
-	var err error
 
 	if requiresDistTxn && se.config.EnableDistributedTxns {
 		// Use distributed transaction
@@ -455,7 +482,7 @@ func (se *SQLEngine) executeDataStatement(ctx context.Context, conn *SQLConnecti
 		result, err = se.distTxnCoordinator.ExecuteInDistributedTransaction(ctx, distTxn.ID, stmt, se.executor)
 	} else {
 		// Use regular transaction
-		result, err = se.txnManager.ExecuteInTransaction(ctx, txn.sqlID, stmt, se.executor)
+		result, err = se.txnManager.ExecutePlanInTransaction(ctx, txn.sqlID, stmt, plan, params, se.executor)
 	}
 
 	if err != nil {
@@ -496,6 +523,7 @@ func (se *SQLEngine) executeDataStatement(ctx context.Context, conn *SQLConnecti
 	if result != nil {
 		rowsAffected = int64(len(result.Rows))
 	}
+	se.noteModifications(stmt, tables, rowsAffected)
 
 	return &SQLResult{
 		ResultSet:     result,
@@ -505,6 +533,32 @@ func (se *SQLEngine) executeDataStatement(ctx context.Context, conn *SQLConnecti
 	}, nil
 }
 
+// statementTransaction returns the transaction a data statement runs in:
+// the connection's open one, or a new auto-commit transaction that the
+// caller must finish.
+func (se *SQLEngine) statementTransaction(ctx context.Context, conn *SQLConnection) (*SQLTransaction, *DistributedTransaction, bool, error) {
+	conn.mutex.Lock()
+	defer conn.mutex.Unlock()
+
+	if conn.AutoCommit && conn.CurrentTxn == nil {
+		beginStmt := &BeginTransactionStatement{
+			ReadOnly: conn.ReadOnly,
+		}
+		isolation := SQLIsolationLevel(conn.IsolationLevel)
+		beginStmt.IsolationLevel = &isolation
+
+		txn, err := se.txnManager.BeginTransaction(ctx, beginStmt)
+		if err != nil {
+			return nil, nil, false, fmt.Errorf("failed to begin auto-commit transaction: %w", err)
+		}
+		return txn, nil, true, nil
+	}
+	if conn.CurrentTxn == nil {
+		return nil, nil, false, fmt.Errorf("no active transaction")
+	}
+	return conn.CurrentTxn, conn.CurrentDistTxn, false, nil
+}
+
 // Helper methods
 
 func (se *SQLEngine) extractTablesFromStatement(stmt Statement) []string {
@@ -516,6 +570,11 @@ func (se *SQLEngine) extractTablesFromStatement(stmt Statement) []string {
 				tables = append(tables, table.Name)
 			}
 		}
+		for _, join := range s.Joins {
+			if join.Table != nil && join.Table.Name != "" {
+				tables = append(tables, join.Table.Name)
+			}
+		}
 		return tables
 	case *InsertStatement:
 		if s.Table != nil && s.Table.Name != "" {
@@ -620,9 +679,7 @@ func (se *SQLEngine) startBackgroundTasks() {
 }
 
 func (se *SQLEngine) cleanupIdleConnections() {
-	se.connectionMutex.Lock()
-	defer se.connectionMutex.Unlock()
-
+	se.connectionMutex.RLock()
 	now := time.Now()
 	var toCleanup []string
 
@@ -635,6 +692,8 @@ func (se *SQLEngine) cleanupIdleConnections() {
 			toCleanup = append(toCleanup, id)
 		}
 	}
+	// CloseConnection takes the lock itself
+	se.connectionMutex.RUnlock()
 
 	for _, id := range toCleanup {
 		se.CloseConnection(id)
@@ -654,6 +713,18 @@ func (se *SQLEngine) GetConnectionInfo(connectionID string) (*SQLConnection, err
 	return conn, nil
 }
 
+// InTransaction reports whether a connection has an explicit transaction
+// open.
+func (se *SQLEngine) InTransaction(connectionID string) bool {
+	conn, err := se.GetConnectionInfo(connectionID)
+	if err != nil {
+		return false
+	}
+	conn.mutex.RLock()
+	defer conn.mutex.RUnlock()
+	return conn.CurrentTxn != nil
+}
+
 // GetActiveConnections returns all active connections
 func (se *SQLEngine) GetActiveConnections() []*SQLConnection {
 	se.connectionMutex.RLock()
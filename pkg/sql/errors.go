@@ -309,7 +309,7 @@ func ParseSQLEnhanced(input string) (Statement, error) {
 
 	// For now, we'll use the standard parser and enhance errors post-parsing
 	// In a full implementation, we'd modify the parser to use enhanced error reporting
-	stmt, parseErr := parser.ParseStatement()
+	stmt, parseErr := parser.parseSingleStatement()
 
 	if parseErr != nil {
 		// Convert standard parse error to enhanced error
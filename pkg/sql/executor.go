@@ -62,6 +62,13 @@ type StorageManager struct {
 	columnarAdapter *ColumnarStorageAdapter
 }
 
+// NewStorageManager routes SQL tables to storage engines: kv_ tables to
+// kv, doc_ tables to docs and the rest to columnar. Any of them may be nil
+// when no table uses it.
+func NewStorageManager(kv KVStorageEngine, docs DocumentStorageEngine, columnar ColumnarStorageEngine) *StorageManager {
+	return &StorageManager{kvStore: kv, docStore: docs, columnarStore: columnar}
+}
+
 // KVStorageEngine interface for key-value storage
 type KVStorageEngine interface {
 	Get(ctx context.Context, key []byte) ([]byte, error)
@@ -137,6 +144,8 @@ type ExecutionContext struct {
 	Stats          *ExecutionStats
 	IsolationLevel IsolationLevel
 	ReadOnly       bool
+
+	profiler *planProfiler // set while the query is being profiled
 }
 
 // ResultSet represents query execution results
@@ -269,6 +278,9 @@ const (
 
 type Index interface {
 	Scan(ctx context.Context, key ScanKey) (Iterator, error)
+	// ScanRange returns the entries in the key range all of keys bound, in
+	// key order. Keys the range cannot express are not applied.
+	ScanRange(ctx context.Context, keys []ScanKey) (Iterator, error)
 	Insert(ctx context.Context, key, value []byte) error
 	Delete(ctx context.Context, key []byte) error
 	Stats() IndexStats
@@ -305,6 +317,9 @@ func NewQueryExecutor(storageManager *StorageManager) *QueryExecutor {
 	storageManager.kvAdapter = NewKVStorageAdapter(storageManager.kvStore)
 	storageManager.docAdapter = NewDocumentStorageAdapter(storageManager.docStore)
 	storageManager.columnarAdapter = NewColumnarStorageAdapter(storageManager.columnarStore)
+	if storageManager.indexManager == nil {
+		storageManager.indexManager = NewBTreeIndexManager()
+	}
 
 	return &QueryExecutor{
 		storageManager: storageManager,
@@ -321,6 +336,7 @@ func (qe *QueryExecutor) Execute(ctx context.Context, plan *QueryPlan, params []
 		StartTime:  time.Now(),
 		WorkMem:    qe.config.WorkMem,
 		Stats:      &ExecutionStats{},
+		profiler:   newPlanProfiler(ctx),
 	}
 
 	// Set timeout
@@ -332,6 +348,7 @@ func (qe *QueryExecutor) Execute(ctx context.Context, plan *QueryPlan, params []
 
 	// Execute the plan
 	result, err := qe.executePlan(execCtx, plan)
+	execCtx.profiler.finish(execCtx.StartTime, err)
 	if err != nil {
 		return &ResultSet{Error: err}, err
 	}
@@ -351,37 +368,22 @@ func (qe *QueryExecutor) Execute(ctx context.Context, plan *QueryPlan, params []
 func (qe *QueryExecutor) executePlan(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
 	switch plan.Type {
 	case PlanTypeSeqScan:
+		if len(plan.Qual) > 0 || ctx.profiler != nil {
+			// The storage adapters cannot see bind parameters; the scan
+			// operator evaluates every qualifier against the row. Profiles
+			// are also taken from operators.
+			return qe.executeOperatorPlan(ctx, plan)
+		}
 		return qe.executeSeqScan(ctx, plan)
-	case PlanTypeIndexScan:
-		return qe.executeIndexScan(ctx, plan)
-	case PlanTypeBitmapIndexScan:
-		return qe.executeBitmapIndexScan(ctx, plan)
-	case PlanTypeBitmapHeapScan:
-		return qe.executeBitmapHeapScan(ctx, plan)
-	case PlanTypeNestLoop:
-		return qe.executeNestLoop(ctx, plan)
-	case PlanTypeHashJoin:
-		return qe.executeHashJoin(ctx, plan)
-	case PlanTypeMergeJoin:
-		return qe.executeMergeJoin(ctx, plan)
-	case PlanTypeSort:
-		return qe.executeSort(ctx, plan)
-	case PlanTypeHash:
-		return qe.executeHash(ctx, plan)
-	case PlanTypeMaterial:
-		return qe.executeMaterial(ctx, plan)
-	case PlanTypeAggregate:
-		return qe.executeAggregateEnhanced(ctx, plan)
-	case PlanTypeGroup:
-		return qe.executeGroup(ctx, plan)
-	case PlanTypeLimit:
-		return qe.executeLimit(ctx, plan)
-	case PlanTypeSubqueryScan:
-		return qe.executeSubqueryScan(ctx, plan)
-	case PlanTypeParallelSeqScan:
-		return qe.executeParallelSeqScan(ctx, plan)
-	case PlanTypeGather:
-		return qe.executeGather(ctx, plan)
+	case PlanTypeSort, PlanTypeHash, PlanTypeMaterial, PlanTypeAggregate,
+		PlanTypeGroup, PlanTypeLimit, PlanTypeSubqueryScan, PlanTypeValuesScan,
+		PlanTypeHashJoin, PlanTypeNestLoop, PlanTypeMergeJoin,
+		PlanTypeParallelSeqScan, PlanTypeGather, PlanTypeIndexScan,
+		PlanTypeIndexOnlyScan, PlanTypeBitmapHeapScan, PlanTypeResult,
+		PlanTypeUnique:
+		// These nodes run as a streaming operator pipeline so that LIMIT
+		// stops the scans beneath it and memory stays bounded per batch.
+		return qe.executeOperatorPlan(ctx, plan)
 	default:
 		return nil, fmt.Errorf("unsupported plan type: %v", plan.Type)
 	}
@@ -601,207 +603,6 @@ func (qe *QueryExecutor) executeColumnarSeqScan(ctx *ExecutionContext, plan *Que
 	}, nil
 }
 
-// executeIndexScan executes an index scan
-func (qe *QueryExecutor) executeIndexScan(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	index, err := qe.storageManager.indexManager.GetIndex(ctx.Context, plan.IndexName)
-	if err != nil {
-		return nil, fmt.Errorf("failed to get index %s: %w", plan.IndexName, err)
-	}
-
-	// Build scan key from qualifiers
-	scanKey := qe.buildScanKey(plan.ScanKeys)
-
-	iter, err := index.Scan(ctx.Context, scanKey)
-	if err != nil {
-		return nil, fmt.Errorf("failed to create index iterator: %w", err)
-	}
-	defer iter.Close()
-
-	var rows []Row
-	columns := qe.getTableColumns(plan.TableName)
-
-	for iter.Next() {
-		key, value, err := iter.Value()
-		if err != nil {
-			return nil, fmt.Errorf("failed to read index entry: %w", err)
-		}
-
-		// Fetch actual row data using the index value (row ID)
-		row, err := qe.fetchRowByID(ctx, plan.TableName, value)
-		if err != nil {
-			return nil, fmt.Errorf("failed to fetch row: %w", err)
-		}
-
-		rows = append(rows, row)
-		ctx.Stats.RowsProcessed++
-		ctx.Stats.BytesProcessed += int64(len(key) + len(value))
-
-		// Check for cancellation
-		select {
-		case <-ctx.Context.Done():
-			return nil, ctx.Context.Err()
-		default:
-		}
-	}
-
-	if err := iter.Error(); err != nil {
-		return nil, fmt.Errorf("iterator error: %w", err)
-	}
-
-	ctx.Stats.IndexScans++
-
-	return &ResultSet{
-		Columns: columns,
-		Rows:    rows,
-		Stats:   *ctx.Stats,
-	}, nil
-}
-
-// executeHashJoin executes a hash join with optional parallelization
-func (qe *QueryExecutor) executeHashJoin(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	// Check if parallel execution should be used
-	if qe.config.EnableParallel && qe.shouldUseParallelJoin(plan) {
-		return qe.executeParallelHashJoin(ctx, plan)
-	}
-
-	// Execute inner (build) side
-	innerResult, err := qe.executePlan(ctx, plan.RightTree)
-	if err != nil {
-		return nil, fmt.Errorf("failed to execute inner side of hash join: %w", err)
-	}
-
-	// Build hash table
-	hashTable := make(map[string][]Row)
-	for _, row := range innerResult.Rows {
-		// Extract join key (simplified - assumes first column)
-		key := fmt.Sprintf("%v", row.Values[0])
-		hashTable[key] = append(hashTable[key], row)
-	}
-
-	// Execute outer (probe) side
-	outerResult, err := qe.executePlan(ctx, plan.LeftTree)
-	if err != nil {
-		return nil, fmt.Errorf("failed to execute outer side of hash join: %w", err)
-	}
-
-	// Probe hash table
-	var joinedRows []Row
-	combinedColumns := append(outerResult.Columns, innerResult.Columns...)
-
-	for _, outerRow := range outerResult.Rows {
-		// Extract join key (simplified - assumes first column)
-		key := fmt.Sprintf("%v", outerRow.Values[0])
-
-		if innerRows, exists := hashTable[key]; exists {
-			for _, innerRow := range innerRows {
-				// Combine rows
-				joinedRow := Row{
-					Values: append(outerRow.Values, innerRow.Values...),
-				}
-				joinedRows = append(joinedRows, joinedRow)
-				ctx.Stats.RowsProcessed++
-			}
-		}
-
-		// Check for cancellation
-		select {
-		case <-ctx.Context.Done():
-			return nil, ctx.Context.Err()
-		default:
-		}
-	}
-
-	ctx.Stats.JoinsExecuted++
-
-	return &ResultSet{
-		Columns: combinedColumns,
-		Rows:    joinedRows,
-		Stats:   *ctx.Stats,
-	}, nil
-}
-
-// executeParallelSeqScan executes a parallel sequential scan
-func (qe *QueryExecutor) executeParallelSeqScan(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	if !qe.config.EnableParallel || plan.Workers <= 1 {
-		// Fall back to regular sequential scan
-		return qe.executeSeqScan(ctx, plan)
-	}
-
-	// Create worker contexts
-	workers := plan.Workers
-	if workers > qe.config.MaxWorkers {
-		workers = qe.config.MaxWorkers
-	}
-
-	// Channel for collecting results
-	resultChan := make(chan *ResultSet, workers)
-	errorChan := make(chan error, workers)
-
-	// Launch workers
-	var wg sync.WaitGroup
-	for i := 0; i < workers; i++ {
-		wg.Add(1)
-		go func(workerID int) {
-			defer wg.Done()
-
-			// Create worker-specific plan (partition the data)
-			workerPlan := *plan
-			workerPlan.Type = PlanTypeSeqScan // Convert to regular seq scan
-
-			// Execute worker scan
-			result, err := qe.executeSeqScan(ctx, &workerPlan)
-			if err != nil {
-				errorChan <- err
-				return
-			}
-
-			resultChan <- result
-		}(i)
-	}
-
-	// Wait for workers to complete
-	go func() {
-		wg.Wait()
-		close(resultChan)
-		close(errorChan)
-	}()
-
-	// Collect results
-	var allRows []Row
-	var columns []ColumnInfo
-	combinedStats := ExecutionStats{}
-
-	for {
-		select {
-		case result, ok := <-resultChan:
-			if !ok {
-				// All workers done
-				return &ResultSet{
-					Columns: columns,
-					Rows:    allRows,
-					Stats:   combinedStats,
-				}, nil
-			}
-
-			if len(columns) == 0 {
-				columns = result.Columns
-			}
-			allRows = append(allRows, result.Rows...)
-
-			// Combine stats
-			combinedStats.RowsProcessed += result.Stats.RowsProcessed
-			combinedStats.BytesProcessed += result.Stats.BytesProcessed
-			combinedStats.SeqScans += result.Stats.SeqScans
-
-		case err := <-errorChan:
-			return nil, fmt.Errorf("parallel scan worker error: %w", err)
-
-		case <-ctx.Context.Done():
-			return nil, ctx.Context.Err()
-		}
-	}
-}
-
 // Helper methods
 
 type StorageType int
@@ -835,76 +636,6 @@ func (qe *QueryExecutor) getTableColumns(tableName string) []ColumnInfo {
 	}
 }
 
-// Placeholder implementations for remaining methods
-func (qe *QueryExecutor) executeBitmapIndexScan(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	return qe.executeIndexScan(ctx, plan)
-}
-
-func (qe *QueryExecutor) executeBitmapHeapScan(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	return qe.executeSeqScan(ctx, plan)
-}
-
-func (qe *QueryExecutor) executeNestLoop(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	return qe.executeHashJoin(ctx, plan) // Simplified
-}
-
-func (qe *QueryExecutor) executeMergeJoin(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	return qe.executeHashJoin(ctx, plan) // Simplified
-}
-
-func (qe *QueryExecutor) executeSort(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	result, err := qe.executePlan(ctx, plan.LeftTree)
-	if err != nil {
-		return nil, err
-	}
-
-	// Sort rows (simplified implementation)
-	ctx.Stats.SortsExecuted++
-	return result, nil
-}
-
-func (qe *QueryExecutor) executeHash(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	return qe.executePlan(ctx, plan.LeftTree)
-}
-
-func (qe *QueryExecutor) executeMaterial(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	return qe.executePlan(ctx, plan.LeftTree)
-}
-
-func (qe *QueryExecutor) executeAggregate(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	return qe.executePlan(ctx, plan.LeftTree)
-}
-
-func (qe *QueryExecutor) executeGroup(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	return qe.executePlan(ctx, plan.LeftTree)
-}
-
-func (qe *QueryExecutor) executeLimit(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	result, err := qe.executePlan(ctx, plan.LeftTree)
-	if err != nil {
-		return nil, err
-	}
-
-	// Apply limit (simplified)
-	if plan.Limit != nil {
-		// Would extract limit value from expression
-		limit := 100 // Placeholder
-		if len(result.Rows) > limit {
-			result.Rows = result.Rows[:limit]
-		}
-	}
-
-	return result, nil
-}
-
-func (qe *QueryExecutor) executeSubqueryScan(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	return qe.executePlan(ctx, plan.LeftTree)
-}
-
-func (qe *QueryExecutor) executeGather(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	return qe.executePlan(ctx, plan.LeftTree)
-}
-
 func (qe *QueryExecutor) matchesQualifiers(key, value []byte, quals []Expression) bool {
 	// Simplified qualifier matching
 	return true
@@ -936,19 +667,6 @@ func (qe *QueryExecutor) qualifiersToDocumentFilter(quals []Expression) map[stri
 	return make(map[string]interface{})
 }
 
-func (qe *QueryExecutor) buildScanKey(scanKeys []ScanKey) ScanKey {
-	// Build scan key from qualifiers
-	if len(scanKeys) > 0 {
-		return scanKeys[0]
-	}
-	return ScanKey{}
-}
-
-func (qe *QueryExecutor) fetchRowByID(ctx *ExecutionContext, tableName string, rowID []byte) (Row, error) {
-	// Fetch row by ID from storage
-	return Row{Values: []interface{}{"dummy", "data"}}, nil
-}
-
 // GetStats returns execution statistics
 func (qe *QueryExecutor) GetStats() ExecutionStats {
 	qe.mu.RLock()
@@ -1237,169 +955,6 @@ func (qe *QueryExecutor) executeVectorizedColumnarScan(ctx *ExecutionContext, pl
 	}, nil
 }
 
-// executeParallelHashJoin performs parallel hash join execution
-func (qe *QueryExecutor) executeParallelHashJoin(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	if !qe.config.EnableParallel || plan.Workers <= 1 {
-		return qe.executeHashJoin(ctx, plan)
-	}
-
-	// Execute inner (build) side
-	innerResult, err := qe.executePlan(ctx, plan.RightTree)
-	if err != nil {
-		return nil, fmt.Errorf("failed to execute inner side of parallel hash join: %w", err)
-	}
-
-	// Build hash table in parallel
-	hashTable := qe.buildParallelHashTable(innerResult.Rows, plan.Workers)
-
-	// Execute outer (probe) side in parallel
-	outerResult, err := qe.executePlan(ctx, plan.LeftTree)
-	if err != nil {
-		return nil, fmt.Errorf("failed to execute outer side of parallel hash join: %w", err)
-	}
-
-	// Probe hash table in parallel
-	joinedRows := qe.probeParallelHashTable(outerResult.Rows, hashTable, plan.Workers)
-
-	combinedColumns := append(outerResult.Columns, innerResult.Columns...)
-	ctx.Stats.JoinsExecuted++
-	ctx.Stats.RowsProcessed += int64(len(joinedRows))
-
-	return &ResultSet{
-		Columns: combinedColumns,
-		Rows:    joinedRows,
-		Stats:   *ctx.Stats,
-	}, nil
-}
-
-// buildParallelHashTable builds a hash table using multiple workers
-func (qe *QueryExecutor) buildParallelHashTable(rows []Row, workers int) map[string][]Row {
-	if workers <= 1 || len(rows) < 1000 {
-		// Use single-threaded approach for small datasets
-		hashTable := make(map[string][]Row)
-		for _, row := range rows {
-			key := fmt.Sprintf("%v", row.Values[0])
-			hashTable[key] = append(hashTable[key], row)
-		}
-		return hashTable
-	}
-
-	// Parallel hash table building
-	hashTable := make(map[string][]Row)
-	chunkSize := len(rows) / workers
-	if chunkSize == 0 {
-		chunkSize = 1
-	}
-
-	type hashChunk struct {
-		table map[string][]Row
-		err   error
-	}
-
-	resultChan := make(chan hashChunk, workers)
-
-	// Launch workers
-	for i := 0; i < workers; i++ {
-		start := i * chunkSize
-		end := start + chunkSize
-		if i == workers-1 {
-			end = len(rows) // Last worker takes remaining rows
-		}
-
-		go func(chunk []Row) {
-			localTable := make(map[string][]Row)
-			for _, row := range chunk {
-				key := fmt.Sprintf("%v", row.Values[0])
-				localTable[key] = append(localTable[key], row)
-			}
-			resultChan <- hashChunk{table: localTable}
-		}(rows[start:end])
-	}
-
-	// Collect results and merge
-	for i := 0; i < workers; i++ {
-		chunk := <-resultChan
-		if chunk.err != nil {
-			continue // Skip errors for now
-		}
-
-		for key, chunkRows := range chunk.table {
-			hashTable[key] = append(hashTable[key], chunkRows...)
-		}
-	}
-
-	return hashTable
-}
-
-// probeParallelHashTable probes the hash table using multiple workers
-func (qe *QueryExecutor) probeParallelHashTable(outerRows []Row, hashTable map[string][]Row, workers int) []Row {
-	if workers <= 1 || len(outerRows) < 1000 {
-		// Use single-threaded approach
-		var joinedRows []Row
-		for _, outerRow := range outerRows {
-			key := fmt.Sprintf("%v", outerRow.Values[0])
-			if innerRows, exists := hashTable[key]; exists {
-				for _, innerRow := range innerRows {
-					joinedRow := Row{
-						Values: append(outerRow.Values, innerRow.Values...),
-					}
-					joinedRows = append(joinedRows, joinedRow)
-				}
-			}
-		}
-		return joinedRows
-	}
-
-	// Parallel probing
-	chunkSize := len(outerRows) / workers
-	if chunkSize == 0 {
-		chunkSize = 1
-	}
-
-	type probeResult struct {
-		rows []Row
-		err  error
-	}
-
-	resultChan := make(chan probeResult, workers)
-
-	// Launch workers
-	for i := 0; i < workers; i++ {
-		start := i * chunkSize
-		end := start + chunkSize
-		if i == workers-1 {
-			end = len(outerRows)
-		}
-
-		go func(chunk []Row) {
-			var localJoinedRows []Row
-			for _, outerRow := range chunk {
-				key := fmt.Sprintf("%v", outerRow.Values[0])
-				if innerRows, exists := hashTable[key]; exists {
-					for _, innerRow := range innerRows {
-						joinedRow := Row{
-							Values: append(outerRow.Values, innerRow.Values...),
-						}
-						localJoinedRows = append(localJoinedRows, joinedRow)
-					}
-				}
-			}
-			resultChan <- probeResult{rows: localJoinedRows}
-		}(outerRows[start:end])
-	}
-
-	// Collect results
-	var allJoinedRows []Row
-	for i := 0; i < workers; i++ {
-		result := <-resultChan
-		if result.err == nil {
-			allJoinedRows = append(allJoinedRows, result.rows...)
-		}
-	}
-
-	return allJoinedRows
-}
-
 // Helper methods for storage adapters
 
 func (adapter *KVStorageAdapter) matchesFilters(row UnifiedRow, filters []Expression) bool {
@@ -1496,27 +1051,6 @@ func (qe *QueryExecutor) shouldUseVectorization(plan *QueryPlan) bool {
 	return plan.PlanRows > 10000 || qe.hasAggregation(plan)
 }
 
-// shouldUseParallelJoin determines if parallel join should be used
-func (qe *QueryExecutor) shouldUseParallelJoin(plan *QueryPlan) bool {
-	if !qe.config.EnableParallel {
-		return false
-	}
-
-	// Use parallel join for large datasets
-	leftRows := float64(1000)  // Default estimate
-	rightRows := float64(1000) // Default estimate
-
-	if plan.LeftTree != nil {
-		leftRows = plan.LeftTree.PlanRows
-	}
-	if plan.RightTree != nil {
-		rightRows = plan.RightTree.PlanRows
-	}
-
-	// Use parallel join if either side has more than 10k rows
-	return leftRows > 10000 || rightRows > 10000
-}
-
 // hasAggregation checks if a plan contains aggregation operations
 func (qe *QueryExecutor) hasAggregation(plan *QueryPlan) bool {
 	if plan == nil {
@@ -1531,170 +1065,3 @@ func (qe *QueryExecutor) hasAggregation(plan *QueryPlan) bool {
 	// Check child nodes
 	return qe.hasAggregation(plan.LeftTree) || qe.hasAggregation(plan.RightTree)
 }
-
-// Enhanced aggregate execution with vectorization support
-func (qe *QueryExecutor) executeAggregateEnhanced(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
-	// Execute child plan
-	childResult, err := qe.executePlan(ctx, plan.LeftTree)
-	if err != nil {
-		return nil, fmt.Errorf("failed to execute child plan for aggregation: %w", err)
-	}
-
-	// Check if we can use vectorized aggregation
-	if qe.config.EnableVectorization && len(childResult.Rows) > 1000 {
-		return qe.executeVectorizedAggregate(ctx, plan, childResult)
-	}
-
-	// Fall back to regular aggregation
-	return qe.executeRegularAggregate(ctx, plan, childResult)
-}
-
-// executeVectorizedAggregate performs vectorized aggregation
-func (qe *QueryExecutor) executeVectorizedAggregate(ctx *ExecutionContext, plan *QueryPlan, input *ResultSet) (*ResultSet, error) {
-	// Group rows by group keys
-	groups := make(map[string][]Row)
-
-	for _, row := range input.Rows {
-		// Create group key (simplified - uses first column)
-		groupKey := fmt.Sprintf("%v", row.Values[0])
-		groups[groupKey] = append(groups[groupKey], row)
-	}
-
-	// Process aggregates for each group in parallel
-	if qe.config.EnableParallel && len(groups) > 100 {
-		return qe.executeParallelAggregate(ctx, plan, groups)
-	}
-
-	// Sequential aggregation
-	var resultRows []Row
-	for _, groupRows := range groups {
-		aggregatedRow := qe.computeAggregates(groupRows, plan.GroupKeys)
-		resultRows = append(resultRows, aggregatedRow)
-	}
-
-	ctx.Stats.RowsProcessed += int64(len(resultRows))
-
-	return &ResultSet{
-		Columns: qe.getAggregateColumns(plan),
-		Rows:    resultRows,
-		Stats:   *ctx.Stats,
-	}, nil
-}
-
-// executeParallelAggregate performs parallel aggregation
-func (qe *QueryExecutor) executeParallelAggregate(ctx *ExecutionContext, plan *QueryPlan, groups map[string][]Row) (*ResultSet, error) {
-	workers := qe.config.MaxWorkers
-	if workers > len(groups) {
-		workers = len(groups)
-	}
-
-	// Distribute groups among workers
-	groupKeys := make([]string, 0, len(groups))
-	for key := range groups {
-		groupKeys = append(groupKeys, key)
-	}
-
-	chunkSize := len(groupKeys) / workers
-	if chunkSize == 0 {
-		chunkSize = 1
-	}
-
-	type aggregateResult struct {
-		rows []Row
-		err  error
-	}
-
-	resultChan := make(chan aggregateResult, workers)
-
-	// Launch workers
-	for i := 0; i < workers; i++ {
-		start := i * chunkSize
-		end := start + chunkSize
-		if i == workers-1 {
-			end = len(groupKeys)
-		}
-
-		go func(keys []string) {
-			var workerRows []Row
-			for _, key := range keys {
-				if groupRows, exists := groups[key]; exists {
-					aggregatedRow := qe.computeAggregates(groupRows, plan.GroupKeys)
-					workerRows = append(workerRows, aggregatedRow)
-				}
-			}
-			resultChan <- aggregateResult{rows: workerRows}
-		}(groupKeys[start:end])
-	}
-
-	// Collect results
-	var allRows []Row
-	for i := 0; i < workers; i++ {
-		result := <-resultChan
-		if result.err == nil {
-			allRows = append(allRows, result.rows...)
-		}
-	}
-
-	ctx.Stats.RowsProcessed += int64(len(allRows))
-
-	return &ResultSet{
-		Columns: qe.getAggregateColumns(plan),
-		Rows:    allRows,
-		Stats:   *ctx.Stats,
-	}, nil
-}
-
-// executeRegularAggregate performs standard aggregation
-func (qe *QueryExecutor) executeRegularAggregate(ctx *ExecutionContext, plan *QueryPlan, input *ResultSet) (*ResultSet, error) {
-	// Simple aggregation implementation
-	var resultRows []Row
-
-	if len(input.Rows) > 0 {
-		// For simplicity, just return the first row with count
-		firstRow := input.Rows[0]
-		aggregatedRow := Row{
-			Values: append(firstRow.Values, len(input.Rows)),
-		}
-		resultRows = append(resultRows, aggregatedRow)
-	}
-
-	ctx.Stats.RowsProcessed += int64(len(resultRows))
-
-	return &ResultSet{
-		Columns: qe.getAggregateColumns(plan),
-		Rows:    resultRows,
-		Stats:   *ctx.Stats,
-	}, nil
-}
-
-// computeAggregates computes aggregate functions for a group of rows
-func (qe *QueryExecutor) computeAggregates(rows []Row, groupKeys []Expression) Row {
-	// Simplified aggregate computation
-	// In a real implementation, this would handle SUM, AVG, COUNT, etc.
-
-	if len(rows) == 0 {
-		return Row{Values: []any{0}}
-	}
-
-	// Return first row with count as additional column
-	firstRow := rows[0]
-	result := Row{
-		Values: append(firstRow.Values, len(rows)),
-	}
-
-	return result
-}
-
-// getAggregateColumns returns column information for aggregate results
-func (qe *QueryExecutor) getAggregateColumns(plan *QueryPlan) []ColumnInfo {
-	// This would normally be derived from the target list
-	// For now, return basic columns
-	baseColumns := qe.getTableColumns(plan.TableName)
-
-	// Add aggregate columns
-	aggregateColumns := []ColumnInfo{
-		{Name: "count", Type: DataType{Name: "INTEGER"}, Nullable: false},
-	}
-
-	return append(baseColumns, aggregateColumns...)
-}
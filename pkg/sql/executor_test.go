@@ -0,0 +1,774 @@
+package sql
+
+import (
+	"bytes"
+	"context"
+	"fmt"
+	"sort"
+	"strings"
+	"sync/atomic"
+	"testing"
+)
+
+// memKVStore is an in-memory KVStorageEngine that counts how many entries
+// its iterators hand out, so tests can assert on early termination.
+type memKVStore struct {
+	keys   []string
+	values map[string][]byte
+	reads  atomic.Int64
+}
+
+func newMemKVStore() *memKVStore {
+	return &memKVStore{values: make(map[string][]byte)}
+}
+
+func (s *memKVStore) Get(ctx context.Context, key []byte) ([]byte, error) {
+	v, ok := s.values[string(key)]
+	if !ok {
+		return nil, fmt.Errorf("key not found")
+	}
+	return v, nil
+}
+
+func (s *memKVStore) Put(ctx context.Context, key, value []byte) error {
+	if _, ok := s.values[string(key)]; !ok {
+		i := sort.SearchStrings(s.keys, string(key))
+		s.keys = append(s.keys, "")
+		copy(s.keys[i+1:], s.keys[i:])
+		s.keys[i] = string(key)
+	}
+	s.values[string(key)] = value
+	return nil
+}
+
+func (s *memKVStore) Delete(ctx context.Context, key []byte) error {
+	delete(s.values, string(key))
+	return nil
+}
+
+func (s *memKVStore) Scan(ctx context.Context, startKey, endKey []byte) (Iterator, error) {
+	var keys []string
+	for _, k := range s.keys {
+		if bytes.Compare([]byte(k), startKey) >= 0 && bytes.Compare([]byte(k), endKey) < 0 {
+			if _, live := s.values[k]; live {
+				keys = append(keys, k)
+			}
+		}
+	}
+	return &memKVIterator{store: s, keys: keys, pos: -1}, nil
+}
+
+func (s *memKVStore) BatchGet(ctx context.Context, keys [][]byte) ([][]byte, error) {
+	out := make([][]byte, len(keys))
+	for i, k := range keys {
+		out[i] = s.values[string(k)]
+	}
+	return out, nil
+}
+
+func (s *memKVStore) BatchPut(ctx context.Context, kvPairs []KVPair) error {
+	for _, kv := range kvPairs {
+		s.Put(ctx, kv.Key, kv.Value)
+	}
+	return nil
+}
+
+type memKVIterator struct {
+	store *memKVStore
+	keys  []string
+	pos   int
+}
+
+func (it *memKVIterator) Next() bool {
+	it.pos++
+	if it.pos >= len(it.keys) {
+		return false
+	}
+	it.store.reads.Add(1)
+	return true
+}
+
+func (it *memKVIterator) Value() ([]byte, []byte, error) {
+	k := it.keys[it.pos]
+	return []byte(k), it.store.values[k], nil
+}
+
+func (it *memKVIterator) Error() error { return nil }
+func (it *memKVIterator) Close() error { return nil }
+
+// memDocStore is an in-memory DocumentStorageEngine.
+type memDocStore struct {
+	collections map[string][]Document
+}
+
+func newMemDocStore() *memDocStore {
+	return &memDocStore{collections: make(map[string][]Document)}
+}
+
+func (s *memDocStore) GetDocument(ctx context.Context, collection, id string) (Document, error) {
+	for _, doc := range s.collections[collection] {
+		if fmt.Sprint(doc["id"]) == id {
+			return doc, nil
+		}
+	}
+	return nil, fmt.Errorf("document not found")
+}
+
+func (s *memDocStore) PutDocument(ctx context.Context, collection, id string, doc Document) error {
+	s.collections[collection] = append(s.collections[collection], doc)
+	return nil
+}
+
+func (s *memDocStore) DeleteDocument(ctx context.Context, collection, id string) error {
+	return nil
+}
+
+func (s *memDocStore) QueryDocuments(ctx context.Context, collection string, query DocumentQuery) (DocumentIterator, error) {
+	docs := s.collections[collection]
+	if query.Offset >= len(docs) {
+		docs = nil
+	} else if query.Offset > 0 {
+		docs = docs[query.Offset:]
+	}
+	if query.Limit > 0 && query.Limit < len(docs) {
+		docs = docs[:query.Limit]
+	}
+	return &memDocIterator{docs: docs, pos: -1}, nil
+}
+
+func (s *memDocStore) CreateIndex(ctx context.Context, collection string, index DocumentIndex) error {
+	return nil
+}
+
+func (s *memDocStore) DropIndex(ctx context.Context, collection, indexName string) error {
+	return nil
+}
+
+type memDocIterator struct {
+	docs []Document
+	pos  int
+}
+
+func (it *memDocIterator) Next() bool {
+	it.pos++
+	return it.pos < len(it.docs)
+}
+
+func (it *memDocIterator) Document() (Document, error) { return it.docs[it.pos], nil }
+func (it *memDocIterator) Error() error                { return nil }
+func (it *memDocIterator) Close() error                { return nil }
+
+func newTestExecutor(kv *memKVStore, docs *memDocStore) *QueryExecutor {
+	sm := &StorageManager{}
+	if kv != nil {
+		sm.kvStore = kv
+	}
+	if docs != nil {
+		sm.docStore = docs
+	}
+	return NewQueryExecutor(sm)
+}
+
+func runQuery(t *testing.T, qe *QueryExecutor, query string) *ResultSet {
+	t.Helper()
+	stmt, err := ParseSQL(query)
+	if err != nil {
+		t.Fatalf("parse %q: %v", query, err)
+	}
+	plan, err := NewQueryOptimizer().OptimizeQuery(stmt)
+	if err != nil {
+		t.Fatalf("optimize %q: %v", query, err)
+	}
+	result, err := qe.Execute(context.Background(), plan, nil)
+	if err != nil {
+		t.Fatalf("execute %q: %v", query, err)
+	}
+	return result
+}
+
+func TestLimitStopsScanEarly(t *testing.T) {
+	kv := newMemKVStore()
+	for i := 0; i < 10000; i++ {
+		kv.Put(context.Background(), []byte(fmt.Sprintf("kv_events/%05d", i)), []byte("payload"))
+	}
+	qe := newTestExecutor(kv, nil)
+	qe.config.BatchSize = 64
+
+	result := runQuery(t, qe, "SELECT * FROM kv_events LIMIT 10")
+
+	if len(result.Rows) != 10 {
+		t.Fatalf("expected 10 rows, got %d", len(result.Rows))
+	}
+	if reads := kv.reads.Load(); reads > int64(qe.config.BatchSize) {
+		t.Errorf("LIMIT 10 read %d entries; expected at most one batch (%d)", reads, qe.config.BatchSize)
+	}
+}
+
+func TestLimitOffset(t *testing.T) {
+	kv := newMemKVStore()
+	for i := 0; i < 50; i++ {
+		kv.Put(context.Background(), []byte(fmt.Sprintf("kv_items/%03d", i)), []byte("v"))
+	}
+	qe := newTestExecutor(kv, nil)
+	qe.config.BatchSize = 8
+
+	result := runQuery(t, qe, "SELECT * FROM kv_items LIMIT 5 OFFSET 20")
+
+	if len(result.Rows) != 5 {
+		t.Fatalf("expected 5 rows, got %d", len(result.Rows))
+	}
+	if got := result.Rows[0].Values[0]; got != "kv_items/020" {
+		t.Errorf("expected first row kv_items/020, got %v", got)
+	}
+}
+
+func TestGroupByAggregatesSortAndFilter(t *testing.T) {
+	docs := newMemDocStore()
+	scores := []struct {
+		id   int64
+		team string
+	}{
+		{10, "red"}, {20, "red"}, {30, "red"},
+		{5, "blue"}, {7, "blue"},
+		{100, "green"},
+	}
+	for _, s := range scores {
+		docs.PutDocument(context.Background(), "doc_scores", "", Document{"id": s.id, "data": s.team})
+	}
+	qe := newTestExecutor(nil, docs)
+	qe.config.BatchSize = 2
+
+	result := runQuery(t, qe, `SELECT data, COUNT(*) AS n, SUM(id) AS total, MAX(id) AS top
+		FROM doc_scores WHERE id > 5 GROUP BY data HAVING COUNT(*) >= 1 ORDER BY total DESC`)
+
+	want := [][]any{
+		{"green", int64(1), int64(100), int64(100)},
+		{"red", int64(3), int64(60), int64(30)},
+		{"blue", int64(1), int64(7), int64(7)},
+	}
+	if len(result.Rows) != len(want) {
+		t.Fatalf("expected %d groups, got %d: %v", len(want), len(result.Rows), result.Rows)
+	}
+	for i, row := range result.Rows {
+		for j, v := range want[i] {
+			if row.Values[j] != v {
+				t.Errorf("row %d col %d: expected %v (%T), got %v (%T)", i, j, v, v, row.Values[j], row.Values[j])
+			}
+		}
+	}
+	if result.Columns[1].Name != "n" || result.Columns[2].Name != "total" {
+		t.Errorf("unexpected result columns: %+v", result.Columns)
+	}
+}
+
+func TestAggregateWithoutGroupBy(t *testing.T) {
+	docs := newMemDocStore()
+	for i := int64(1); i <= 4; i++ {
+		docs.PutDocument(context.Background(), "doc_nums", "", Document{"id": i})
+	}
+	qe := newTestExecutor(nil, docs)
+
+	result := runQuery(t, qe, "SELECT COUNT(*), AVG(id), MIN(id) FROM doc_nums")
+	if len(result.Rows) != 1 {
+		t.Fatalf("expected one row, got %d", len(result.Rows))
+	}
+	row := result.Rows[0].Values
+	if row[0] != int64(4) || row[1] != 2.5 || row[2] != int64(1) {
+		t.Errorf("unexpected aggregate row: %v", row)
+	}
+
+	empty := runQuery(t, newTestExecutor(nil, newMemDocStore()), "SELECT COUNT(*) FROM doc_nums")
+	if len(empty.Rows) != 1 || empty.Rows[0].Values[0] != int64(0) {
+		t.Errorf("COUNT(*) over empty input should return 0, got %v", empty.Rows)
+	}
+}
+
+func TestInLikeBetweenFilters(t *testing.T) {
+	docs := newMemDocStore()
+	for i := int64(1); i <= 30; i++ {
+		docs.PutDocument(context.Background(), "doc_items", "", Document{"id": i, "data": fmt.Sprintf("g%d", i)})
+	}
+	qe := newTestExecutor(nil, docs)
+
+	tests := []struct {
+		where string
+		want  int
+	}{
+		{"id IN (1, 2, 19)", 3},
+		{"id NOT IN (1, 2, 19)", 27},
+		{"id IN (4)", 1},
+		{"data LIKE 'g1%'", 11},
+		{"data NOT LIKE 'g1%'", 19},
+		{"id BETWEEN 5 AND 9", 5},
+		{"id NOT BETWEEN 5 AND 9", 25},
+		{"id IN (1, 2, 19) AND data LIKE 'g1%'", 2},
+	}
+	for _, tt := range tests {
+		result := runQuery(t, qe, "SELECT * FROM doc_items WHERE "+tt.where)
+		if len(result.Rows) != tt.want {
+			t.Errorf("WHERE %s returned %d rows, want %d", tt.where, len(result.Rows), tt.want)
+		}
+	}
+}
+
+func TestExecuteStreamBatches(t *testing.T) {
+	kv := newMemKVStore()
+	for i := 0; i < 25; i++ {
+		kv.Put(context.Background(), []byte(fmt.Sprintf("kv_stream/%02d", i)), []byte("v"))
+	}
+	qe := newTestExecutor(kv, nil)
+	qe.config.BatchSize = 10
+
+	plan := &QueryPlan{Type: PlanTypeSeqScan, TableName: "kv_stream"}
+	stream, err := qe.ExecuteStream(context.Background(), plan, nil)
+	if err != nil {
+		t.Fatalf("ExecuteStream: %v", err)
+	}
+	defer stream.Close()
+
+	var sizes []int
+	for {
+		batch, err := stream.Next()
+		if err != nil {
+			t.Fatalf("Next: %v", err)
+		}
+		if batch == nil {
+			break
+		}
+		sizes = append(sizes, len(batch.Rows))
+	}
+	if fmt.Sprint(sizes) != "[10 10 5]" {
+		t.Errorf("expected batches [10 10 5], got %v", sizes)
+	}
+}
+
+// joinPlan joins two collections on left.id = right.id.
+func joinPlan(joinType JoinType, left, right string, leftRows, rightRows float64) *QueryPlan {
+	return &QueryPlan{
+		Type:      PlanTypeHashJoin,
+		JoinType:  joinType,
+		LeftTree:  &QueryPlan{Type: PlanTypeSeqScan, TableName: left, PlanRows: leftRows},
+		RightTree: &QueryPlan{Type: PlanTypeSeqScan, TableName: right, PlanRows: rightRows},
+		JoinClauses: []Expression{&BinaryExpression{
+			Left:     &IdentifierExpression{Table: left, Name: "id"},
+			Operator: OpEqual,
+			Right:    &IdentifierExpression{Table: right, Name: "id"},
+		}},
+	}
+}
+
+func sortedRows(rows []Row) []string {
+	out := make([]string, len(rows))
+	for i, row := range rows {
+		out[i] = fmt.Sprint(row.Values)
+	}
+	sort.Strings(out)
+	return out
+}
+
+func TestHashJoinSpillsToDisk(t *testing.T) {
+	docs := newMemDocStore()
+	for i := int64(0); i < 500; i++ {
+		docs.PutDocument(context.Background(), "doc_orders", "", Document{"id": i % 100, "data": fmt.Sprintf("order-%d", i)})
+	}
+	for i := int64(0); i < 100; i += 2 {
+		docs.PutDocument(context.Background(), "doc_users", "", Document{"id": i, "data": fmt.Sprintf("user-%d", i)})
+	}
+
+	// Build on either side, in memory and with every partition spilled.
+	var results [][]string
+	for _, buildLeft := range []bool{false, true} {
+		for _, limit := range []int64{64 << 20, 1} {
+			qe := newTestExecutor(nil, docs)
+			qe.config.BatchSize = 16
+			qe.config.HashTableSize = limit
+			plan := joinPlan(InnerJoin, "doc_orders", "doc_users", 500, 50)
+			if buildLeft {
+				plan.LeftTree.PlanRows = 5
+			}
+			result, err := qe.Execute(context.Background(), plan, nil)
+			if err != nil {
+				t.Fatalf("join (buildLeft=%v, limit=%d): %v", buildLeft, limit, err)
+			}
+			if len(result.Rows) != 250 {
+				t.Fatalf("expected 250 joined rows, got %d", len(result.Rows))
+			}
+			for _, row := range result.Rows {
+				if row.Values[0] != row.Values[2] {
+					t.Fatalf("joined row with mismatched keys: %v", row.Values)
+				}
+			}
+			results = append(results, sortedRows(result.Rows))
+		}
+	}
+	for i := 1; i < len(results); i++ {
+		if fmt.Sprint(results[i]) != fmt.Sprint(results[0]) {
+			t.Errorf("join variant %d returned different rows than the in-memory join", i)
+		}
+	}
+}
+
+func TestHashJoinOuterAndMixedKeyTypes(t *testing.T) {
+	docs := newMemDocStore()
+	docs.PutDocument(context.Background(), "doc_a", "", Document{"id": int64(1), "data": "a1"})
+	docs.PutDocument(context.Background(), "doc_a", "", Document{"id": int64(2), "data": "a2"})
+	docs.PutDocument(context.Background(), "doc_a", "", Document{"id": nil, "data": "anull"})
+	docs.PutDocument(context.Background(), "doc_b", "", Document{"id": 1.0, "data": "b1"})
+	docs.PutDocument(context.Background(), "doc_b", "", Document{"id": 3.0, "data": "b3"})
+
+	qe := newTestExecutor(nil, docs)
+	for _, spill := range []bool{false, true} {
+		if spill {
+			qe.config.HashTableSize = 1
+		}
+		result, err := qe.Execute(context.Background(), joinPlan(LeftJoin, "doc_a", "doc_b", 3, 2), nil)
+		if err != nil {
+			t.Fatalf("left join: %v", err)
+		}
+		want := []string{
+			"[1 a1 1 b1]",
+			"[2 a2 <nil> <nil>]",
+			"[<nil> anull <nil> <nil>]",
+		}
+		if got := sortedRows(result.Rows); fmt.Sprint(got) != fmt.Sprint(want) {
+			t.Errorf("left join (spill=%v): expected %v, got %v", spill, want, got)
+		}
+
+		full, err := qe.Execute(context.Background(), joinPlan(FullJoin, "doc_a", "doc_b", 3, 2), nil)
+		if err != nil {
+			t.Fatalf("full join: %v", err)
+		}
+		if len(full.Rows) != 4 {
+			t.Errorf("full join (spill=%v): expected 4 rows, got %v", spill, sortedRows(full.Rows))
+		}
+	}
+}
+
+func TestExternalSortAndTopK(t *testing.T) {
+	docs := newMemDocStore()
+	for i := 0; i < 300; i++ {
+		var id any = int64((i * 37) % 101)
+		switch {
+		case i%50 == 0:
+			id = nil
+		case i%7 == 0:
+			id = float64((i*37)%101) + 0.5
+		}
+		docs.PutDocument(context.Background(), "doc_board", "", Document{"id": id, "data": fmt.Sprintf("row-%03d", i)})
+	}
+
+	sortPlan := func(limit int64) *QueryPlan {
+		plan := &QueryPlan{
+			Type:     PlanTypeSort,
+			LeftTree: &QueryPlan{Type: PlanTypeSeqScan, TableName: "doc_board"},
+			SortKeys: []SortKey{{Column: "id", Direction: Descending, NullsFirst: true}, {Column: "data"}},
+		}
+		if limit < 0 {
+			return plan
+		}
+		return &QueryPlan{
+			Type:     PlanTypeLimit,
+			LeftTree: plan,
+			Limit:    &LimitClause{Count: &LiteralExpression{Value: limit}},
+			Offset:   &OffsetClause{Count: &LiteralExpression{Value: int64(3)}},
+		}
+	}
+	run := func(workMem int64, plan *QueryPlan) []string {
+		qe := newTestExecutor(nil, docs)
+		qe.config.BatchSize = 7
+		qe.config.WorkMem = workMem
+		result, err := qe.Execute(context.Background(), plan, nil)
+		if err != nil {
+			t.Fatalf("sort (workMem=%d): %v", workMem, err)
+		}
+		out := make([]string, len(result.Rows))
+		for i, row := range result.Rows {
+			out[i] = fmt.Sprint(row.Values)
+		}
+		return out
+	}
+
+	inMemory := run(64<<20, sortPlan(-1))
+	if len(inMemory) != 300 {
+		t.Fatalf("expected 300 sorted rows, got %d", len(inMemory))
+	}
+	if inMemory[0] != "[<nil> row-000]" || inMemory[6] != "[100 row-030]" {
+		t.Errorf("unexpected sort prefix: %v", inMemory[:8])
+	}
+
+	// One row per run forces several merge passes.
+	if external := run(1, sortPlan(-1)); fmt.Sprint(external) != fmt.Sprint(inMemory) {
+		t.Errorf("external sort differs from in-memory sort")
+	}
+	if topK := run(64<<20, sortPlan(10)); fmt.Sprint(topK) != fmt.Sprint(inMemory[3:13]) {
+		t.Errorf("top-k returned %v, expected %v", topK, inMemory[3:13])
+	}
+}
+
+func TestOrderByKeys(t *testing.T) {
+	docs := newMemDocStore()
+	for i, team := range []string{"a", "b", "a", "c", "b", "a"} {
+		docs.PutDocument(context.Background(), "doc_rank", "", Document{"id": int64(i + 1), "data": team})
+	}
+	qe := newTestExecutor(nil, docs)
+	column := func(result *ResultSet, col int) string {
+		var out []string
+		for _, row := range result.Rows {
+			out = append(out, fmt.Sprint(row.Values[col]))
+		}
+		return strings.Join(out, ",")
+	}
+
+	tests := []struct {
+		query string
+		col   int
+		want  string
+	}{
+		{"SELECT * FROM doc_rank ORDER BY 1 DESC", 0, "6,5,4,3,2,1"},
+		{"SELECT data, id FROM doc_rank ORDER BY 2 DESC", 1, "6,5,4,3,2,1"},
+		{"SELECT * FROM doc_rank ORDER BY 10 - id", 0, "6,5,4,3,2,1"},
+		{"SELECT id * 2 AS twice FROM doc_rank ORDER BY twice DESC", 0, "12,10,8,6,4,2"},
+		{"SELECT data FROM doc_rank ORDER BY id DESC", 0, "a,b,c,a,b,a"},
+		{"SELECT DISTINCT data FROM doc_rank ORDER BY 1 DESC", 0, "c,b,a"},
+		{"SELECT * FROM doc_rank ORDER BY data DESC, id", 0, "4,2,5,1,3,6"},
+		{"SELECT data, COUNT(*) FROM doc_rank GROUP BY data ORDER BY COUNT(*) ASC", 0, "c,b,a"},
+		{"SELECT data, COUNT(*) AS n FROM doc_rank GROUP BY data ORDER BY COUNT(*) * -1", 0, "a,b,c"},
+		{"SELECT data, SUM(id) FROM doc_rank GROUP BY data ORDER BY 2", 1, "4,7,10"},
+	}
+	for _, tt := range tests {
+		if got := column(runQuery(t, qe, tt.query), tt.col); got != tt.want {
+			t.Errorf("%s returned %s, want %s", tt.query, got, tt.want)
+		}
+	}
+
+	for _, query := range []string{
+		"SELECT * FROM doc_rank ORDER BY nosuch",
+		"SELECT * FROM doc_rank ORDER BY nosuch + 1",
+		"SELECT * FROM doc_rank ORDER BY 3",
+		"SELECT data, id FROM doc_rank ORDER BY 3",
+		"SELECT data, COUNT(*) FROM doc_rank GROUP BY data ORDER BY SUM(id)",
+		"SELECT DISTINCT data FROM doc_rank ORDER BY id",
+	} {
+		stmt, err := ParseSQL(query)
+		if err != nil {
+			t.Fatalf("parse %q: %v", query, err)
+		}
+		plan, err := NewQueryOptimizer().OptimizeQuery(stmt)
+		if err == nil {
+			_, err = qe.Execute(context.Background(), plan, nil)
+		}
+		if err == nil {
+			t.Errorf("%s succeeded with an unresolvable sort key", query)
+		}
+	}
+}
+
+func TestProjectionAndDistinct(t *testing.T) {
+	docs := newMemDocStore()
+	for i, team := range []string{"a", "b", "a", "c", "b", "a"} {
+		docs.PutDocument(context.Background(), "doc_members", "", Document{"id": int64(i + 1), "data": team})
+		docs.PutDocument(context.Background(), "doc_teams", "", Document{"id": int64(i + 1), "data": "t-" + team})
+	}
+	qe := newTestExecutor(nil, docs)
+	columnNames := func(result *ResultSet) string {
+		var names []string
+		for _, col := range result.Columns {
+			names = append(names, col.Name)
+		}
+		return strings.Join(names, ",")
+	}
+
+	result := runQuery(t, qe, "SELECT id FROM doc_members WHERE id <= 2")
+	if columnNames(result) != "id" || fmt.Sprint(sortedRows(result.Rows)) != "[[1] [2]]" {
+		t.Errorf("SELECT id returned %s %v", columnNames(result), result.Rows)
+	}
+
+	result = runQuery(t, qe, "SELECT data AS team, id * 10 FROM doc_members WHERE id = 3")
+	if columnNames(result) != "team,(id * 10)" || fmt.Sprint(result.Rows[0].Values) != "[a 30]" {
+		t.Errorf("expressions returned %s %v", columnNames(result), result.Rows)
+	}
+
+	result = runQuery(t, qe, "SELECT DISTINCT data FROM doc_members")
+	if fmt.Sprint(sortedRows(result.Rows)) != "[[a] [b] [c]]" {
+		t.Errorf("SELECT DISTINCT returned %v", result.Rows)
+	}
+	result = runQuery(t, qe, "SELECT DISTINCT data FROM doc_members ORDER BY data DESC LIMIT 2")
+	if fmt.Sprint(result.Rows) != "[{[c]} {[b]}]" {
+		t.Errorf("SELECT DISTINCT ... LIMIT returned %v", result.Rows)
+	}
+	if result := runQuery(t, qe, "SELECT DISTINCT * FROM doc_members"); len(result.Rows) != 6 {
+		t.Errorf("SELECT DISTINCT * returned %d rows", len(result.Rows))
+	}
+
+	// A join projects the named columns of either side
+	result = runQuery(t, qe, "SELECT t.data, m.id FROM doc_members m JOIN doc_teams t ON m.id = t.id WHERE m.id = 4")
+	if columnNames(result) != "data,id" || fmt.Sprint(result.Rows) != "[{[t-c 4]}]" {
+		t.Errorf("join returned %s %v", columnNames(result), result.Rows)
+	}
+	result = runQuery(t, qe, "SELECT m.* FROM doc_members m JOIN doc_teams t ON m.id = t.id WHERE m.id = 4")
+	if columnNames(result) != "id,data" || fmt.Sprint(result.Rows) != "[{[4 c]}]" {
+		t.Errorf("m.* returned %s %v", columnNames(result), result.Rows)
+	}
+
+	stmt, _ := ParseSQL("SELECT nosuch FROM doc_members")
+	plan, err := NewQueryOptimizer().OptimizeQuery(stmt)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if _, err := qe.Execute(context.Background(), plan, nil); err == nil || !strings.Contains(err.Error(), "nosuch") {
+		t.Errorf("unknown select list column returned %v", err)
+	}
+}
+
+func TestHashAggregateParallelAndSpill(t *testing.T) {
+	docs := newMemDocStore()
+	for i := int64(0); i < 2000; i++ {
+		docs.PutDocument(context.Background(), "doc_events", "", Document{"id": i, "data": fmt.Sprintf("user-%03d", i%300)})
+	}
+	query := `SELECT data, COUNT(*) AS n, SUM(id) AS total, MIN(id) AS lowest, COUNT(DISTINCT id) AS uniq
+		FROM doc_events GROUP BY data ORDER BY data`
+
+	var results []string
+	for _, cfg := range []struct {
+		parallel bool
+		workMem  int64
+	}{{false, 64 << 20}, {true, 64 << 20}, {false, 1}, {true, 1}} {
+		qe := newTestExecutor(nil, docs)
+		qe.config.BatchSize = 50
+		qe.config.EnableParallel = cfg.parallel
+		qe.config.MaxWorkers = 4
+		qe.config.WorkMem = cfg.workMem
+		result := runQuery(t, qe, query)
+		if len(result.Rows) != 300 {
+			t.Fatalf("%+v: expected 300 groups, got %d", cfg, len(result.Rows))
+		}
+		results = append(results, fmt.Sprint(result.Rows))
+	}
+	for i := 1; i < len(results); i++ {
+		if results[i] != results[0] {
+			t.Errorf("aggregate variant %d differs from the serial in-memory result", i)
+		}
+	}
+	if !strings.HasPrefix(results[0], "[{[user-000 7 ") {
+		t.Errorf("unexpected first group: %.60s", results[0])
+	}
+}
+
+func TestApproxCountDistinct(t *testing.T) {
+	docs := newMemDocStore()
+	for i := int64(0); i < 20000; i++ {
+		docs.PutDocument(context.Background(), "doc_visits", "", Document{"id": i % 5000})
+	}
+	qe := newTestExecutor(nil, docs)
+	qe.config.MaxWorkers = 4
+
+	result := runQuery(t, qe, "SELECT APPROX_COUNT_DISTINCT(id) FROM doc_visits")
+	got, ok := result.Rows[0].Values[0].(int64)
+	if !ok || got < 4750 || got > 5250 {
+		t.Errorf("expected an estimate within 5%% of 5000, got %v", result.Rows[0].Values[0])
+	}
+}
+
+func TestParallelScanReturnsEveryRowOnce(t *testing.T) {
+	kv := newMemKVStore()
+	docs := newMemDocStore()
+	var want []Row
+	for i := 0; i < 20000; i++ {
+		key := fmt.Sprintf("kv_events/%05d", i)
+		kv.Put(context.Background(), []byte(key), []byte("payload"))
+		docs.PutDocument(context.Background(), "doc_events", "", Document{"id": key, "data": "payload"})
+		want = append(want, Row{Values: []any{key, "payload"}})
+	}
+	qe := newTestExecutor(kv, docs)
+	qe.config.BatchSize = 100
+	qe.config.MaxWorkers = 4
+
+	for _, table := range []string{"kv_events", "doc_events"} {
+		plan := &QueryPlan{Type: PlanTypeGather, LeftTree: &QueryPlan{Type: PlanTypeParallelSeqScan, TableName: table, Workers: 4}}
+		result, err := qe.Execute(context.Background(), plan, nil)
+		if err != nil {
+			t.Fatalf("parallel scan of %s: %v", table, err)
+		}
+		if len(result.Rows) != len(want) {
+			t.Fatalf("%s: parallel scan returned %d rows, want %d", table, len(result.Rows), len(want))
+		}
+		if fmt.Sprint(sortedRows(result.Rows)) != fmt.Sprint(sortedRows(want)) {
+			t.Errorf("%s: parallel scan did not return every row exactly once", table)
+		}
+	}
+}
+
+func TestSplitKeyRange(t *testing.T) {
+	splits := splitKeyRange([]byte("kv_events/"), []byte("kv_events/~"), 4)
+	if len(splits) != 4 {
+		t.Fatalf("expected 4 splits, got %d", len(splits))
+	}
+	prev := []byte("kv_events/")
+	for _, s := range splits {
+		r := s.(KeyRangeSplit)
+		if !bytes.Equal(r.Start, prev) || bytes.Compare(r.Start, r.End) >= 0 {
+			t.Fatalf("splits are not contiguous and increasing: %v", splits)
+		}
+		prev = r.End
+	}
+	if string(prev) != "kv_events/~" {
+		t.Errorf("last split ends at %q", prev)
+	}
+}
+
+func TestJoinOrderExecution(t *testing.T) {
+	docs := newMemDocStore()
+	for i := int64(0); i < 10; i++ {
+		docs.PutDocument(context.Background(), "doc_a", "", Document{"id": i, "data": fmt.Sprintf("a%d", i)})
+		if i%2 == 0 {
+			docs.PutDocument(context.Background(), "doc_b", "", Document{"id": i, "data": fmt.Sprintf("b%d", i)})
+		}
+		if i%3 == 0 {
+			docs.PutDocument(context.Background(), "doc_c", "", Document{"id": i, "data": fmt.Sprintf("c%d", i)})
+		}
+	}
+	qe := newTestExecutor(nil, docs)
+
+	// Whatever order the joins run in, every row pairs equal ids.
+	result := runQuery(t, qe, `SELECT * FROM doc_a a
+		JOIN doc_b b ON a.id = b.id
+		JOIN doc_c c ON b.id = c.id`)
+	if len(result.Rows) != 2 {
+		t.Fatalf("expected ids 0 and 6, got %v", sortedRows(result.Rows))
+	}
+	for _, row := range result.Rows {
+		if row.Values[0] != row.Values[2] || row.Values[2] != row.Values[4] {
+			t.Errorf("joined row with mismatched ids: %v", row.Values)
+		}
+	}
+
+	result = runQuery(t, qe, "SELECT * FROM doc_a a LEFT JOIN doc_b b ON a.id = b.id WHERE b.id IS NULL")
+	if len(result.Rows) != 5 {
+		t.Errorf("expected the 5 odd ids without a match, got %v", sortedRows(result.Rows))
+	}
+
+	// An index nested loop whose index the executor does not have runs as
+	// a join of whole inputs.
+	opt := NewQueryOptimizer()
+	setJoinStats(opt, "doc_b", 1e5, map[string]float64{"id": 1e5, "data": 1e5})
+	setJoinStats(opt, "doc_a", 1e6, map[string]float64{"id": 1e6},
+		&IndexStatistics{IndexName: "doc_a_id", TableName: "doc_a", Columns: []string{"id"}, PageCount: 3000, RowCount: 1e6})
+	stmt, err := ParseSQL("SELECT * FROM doc_a a, doc_b b WHERE a.id = b.id AND b.data = 'b4'")
+	if err != nil {
+		t.Fatal(err)
+	}
+	plan, err := opt.OptimizeQuery(stmt)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if plan.RightTree == nil || plan.RightTree.Type != PlanTypeIndexScan {
+		t.Fatalf("expected an index nested loop, got %v", plan.Type)
+	}
+	result, err = qe.Execute(context.Background(), plan, nil)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if got := sortedRows(result.Rows); fmt.Sprint(got) != "[[4 b4 4 a4]]" {
+		t.Errorf("expected the one row with id 4, got %v", got)
+	}
+}
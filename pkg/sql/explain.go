@@ -0,0 +1,132 @@
+package sql
+
+import (
+	"context"
+	"fmt"
+	"strings"
+	"time"
+)
+
+// executeExplain plans a statement and reports the plan as rows of a single
+// QUERY PLAN column. EXPLAIN ANALYZE also runs the statement, profiling
+// every operator, and reports what each one actually did.
+func (se *SQLEngine) executeExplain(ctx context.Context, conn *SQLConnection, stmt *ExplainStatement, sqlText string, startTime time.Time) (*SQLResult, error) {
+	plan, err := se.optimizer.OptimizeQuery(stmt.Statement)
+	if err != nil {
+		err = fmt.Errorf("failed to plan statement: %w", err)
+		return &SQLResult{Error: err, ExecutionTime: time.Since(startTime)}, err
+	}
+
+	lines := explainPlan(plan)
+	if stmt.Analyze {
+		if _, ok := stmt.Statement.(*SelectStatement); !ok {
+			err := fmt.Errorf("EXPLAIN ANALYZE supports SELECT only")
+			return &SQLResult{Error: err, ExecutionTime: time.Since(startTime)}, err
+		}
+		req := &profileRequest{query: sqlText, done: se.noteProfile}
+		result, err := se.executeDataStatement(withProfileRequest(ctx, req), conn, stmt.Statement, plan, nil, startTime)
+		if err != nil {
+			return result, err
+		}
+		// Plans the executor runs without operators leave no profile
+		if req.result != nil && req.result.Plan != nil {
+			lines = req.result.Lines()
+		}
+	}
+
+	rs := &ResultSet{
+		Columns: []ColumnInfo{{Name: "QUERY PLAN", Type: DataType{Name: "TEXT"}}},
+		Rows:    make([]Row, len(lines)),
+	}
+	for i, line := range lines {
+		rs.Rows[i] = Row{Values: []interface{}{line}}
+	}
+	return &SQLResult{ResultSet: rs, ExecutionTime: time.Since(startTime)}, nil
+}
+
+// planDetail describes the relation a plan node reads, as EXPLAIN shows it.
+func planDetail(plan *QueryPlan) string {
+	if plan.TableName == "" {
+		return ""
+	}
+	detail := "on " + plan.TableName
+	if plan.Alias != "" && plan.Alias != plan.TableName {
+		detail += " " + plan.Alias
+	}
+	if plan.IndexName != "" {
+		detail = "using " + plan.IndexName + " " + detail
+	}
+	return detail
+}
+
+// explainPlan renders the estimated plan in PostgreSQL's layout.
+func explainPlan(plan *QueryPlan) []string {
+	var lines []string
+	var walk func(p *QueryPlan, depth int)
+	walk = func(p *QueryPlan, depth int) {
+		lines = append(lines, explainLine(depth, p.Type.String(), planDetail(p),
+			fmt.Sprintf("(cost=%.2f..%.2f rows=%.0f)", p.StartupCost, p.TotalCost, p.PlanRows)))
+		for _, child := range []*QueryPlan{p.LeftTree, p.RightTree} {
+			if child != nil {
+				walk(child, depth+1)
+			}
+		}
+	}
+	walk(plan, 0)
+	return lines
+}
+
+// Lines renders the profile as EXPLAIN ANALYZE output.
+func (qp *QueryProfile) Lines() []string {
+	var lines []string
+	var walk func(n *OperatorProfile, depth int)
+	walk = func(n *OperatorProfile, depth int) {
+		lines = append(lines, explainLine(depth, n.Operator, n.Detail,
+			fmt.Sprintf("(cost=%.2f rows=%.0f) (actual time=%.3f ms self=%.3f ms rows in=%d out=%d batches=%d bytes=%d)",
+				n.EstimatedCost, n.EstimatedRows, durationMs(n.Time), durationMs(n.SelfTime),
+				n.RowsIn, n.RowsOut, n.Batches, n.Bytes)))
+		if n.PeakMemory > 0 || n.Spills > 0 {
+			indent := explainIndent(depth)
+			if depth > 0 {
+				indent += "    "
+			}
+			lines = append(lines, indent+fmt.Sprintf("  Memory: peak=%dB spills=%d", n.PeakMemory, n.Spills))
+		}
+		for _, child := range n.Children {
+			walk(child, depth+1)
+		}
+	}
+	if qp.Plan != nil {
+		walk(qp.Plan, 0)
+	}
+	lines = append(lines,
+		fmt.Sprintf("Rows: %d", qp.Rows),
+		fmt.Sprintf("Execution Time: %.3f ms", durationMs(qp.Duration)))
+	return lines
+}
+
+func explainLine(depth int, operator, detail, figures string) string {
+	var b strings.Builder
+	b.WriteString(explainIndent(depth))
+	if depth > 0 {
+		b.WriteString("->  ")
+	}
+	b.WriteString(operator)
+	if detail != "" {
+		b.WriteString(" " + detail)
+	}
+	b.WriteString("  " + figures)
+	return b.String()
+}
+
+// explainIndent is the indentation of a node depth levels down.
+func explainIndent(depth int) string {
+	if depth == 0 {
+		return ""
+	}
+	return strings.Repeat("      ", depth-1) + "  "
+}
+
+func durationMs(d time.Duration) float64 {
+	return float64(d) / float64(time.Millisecond)
+}
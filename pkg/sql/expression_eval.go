@@ -0,0 +1,714 @@
+package sql
+
+import (
+	"fmt"
+	"math"
+	"strings"
+	"time"
+)
+
+// evalEnv carries everything an expression may reference while being
+// evaluated against a single row.
+type evalEnv struct {
+	row     Row
+	columns map[string]int
+	params  []any
+	// aggregates holds already-computed aggregate results keyed by
+	// expressionKey, so HAVING and target lists can reference them.
+	aggregates map[string]any
+}
+
+// columnIndexMap maps lowercase column names to their row position. The
+// first column wins on duplicates, which matches how joins concatenate the
+// outer side before the inner side.
+func columnIndexMap(columns []ColumnInfo) map[string]int {
+	m := make(map[string]int, len(columns))
+	for i, col := range columns {
+		name := strings.ToLower(col.Name)
+		if _, exists := m[name]; !exists {
+			m[name] = i
+		}
+	}
+	return m
+}
+
+// lookupColumn resolves an identifier to a row position, preferring the
+// "table.column" entry that join inputs register over the bare name.
+func lookupColumn(columns map[string]int, id *IdentifierExpression) (int, bool) {
+	if id.Table != "" {
+		if idx, ok := columns[strings.ToLower(id.Table+"."+id.Name)]; ok {
+			return idx, true
+		}
+	}
+	idx, ok := columns[strings.ToLower(id.Name)]
+	return idx, ok
+}
+
+// operatorColumnIndex builds the column index for rows produced by op.
+// Joins also register qualified names so t1.id and t2.id stay distinct,
+// including beneath operators that pass their input's columns through.
+func operatorColumnIndex(op Operator) map[string]int {
+	for {
+		switch o := op.(type) {
+		case *profiledOperator:
+			op = o.Operator
+		case *filterOperator:
+			op = o.child
+		case *limitOperator:
+			op = o.child
+		case *sortOperator:
+			op = o.child
+		case *uniqueOperator:
+			op = o.child
+		case *hashJoinOperator:
+			return qualifiedColumnIndex(o.columns, o.tables)
+		case *indexNestLoopOperator:
+			return qualifiedColumnIndex(o.columns, o.tables)
+		default:
+			return columnIndexMap(op.Columns())
+		}
+	}
+}
+
+// evaluateExpression evaluates expr against the row in env. Unknown columns
+// evaluate to NULL rather than failing because table metadata is not yet
+// authoritative for every storage engine.
+func evaluateExpression(expr Expression, env *evalEnv) (any, error) {
+	switch e := expr.(type) {
+	case nil:
+		return nil, nil
+	case *LiteralExpression:
+		return e.Value, nil
+	case *ParameterExpression:
+		if e.Index < 1 || e.Index > len(env.params) {
+			return nil, fmt.Errorf("no value supplied for parameter $%d", e.Index)
+		}
+		return env.params[e.Index-1], nil
+	case *IdentifierExpression:
+		if idx, ok := lookupColumn(env.columns, e); ok && idx < len(env.row.Values) {
+			return env.row.Values[idx], nil
+		}
+		return nil, nil
+	case *UnaryExpression:
+		return evaluateUnary(e, env)
+	case *BinaryExpression:
+		return evaluateBinary(e, env)
+	case *FunctionCall:
+		if env.aggregates != nil {
+			if v, ok := env.aggregates[expressionKey(e)]; ok {
+				return v, nil
+			}
+		}
+		return evaluateScalarFunction(e, env)
+	case *CaseExpression:
+		return evaluateCase(e, env)
+	default:
+		return nil, fmt.Errorf("unsupported expression in executor: %T", expr)
+	}
+}
+
+// evaluatePredicate evaluates expr as a WHERE/HAVING condition. NULL and
+// non-boolean results reject the row, following SQL three-valued logic.
+func evaluatePredicate(expr Expression, env *evalEnv) (bool, error) {
+	v, err := evaluateExpression(expr, env)
+	if err != nil {
+		return false, err
+	}
+	b, ok := v.(bool)
+	return ok && b, nil
+}
+
+// evaluateQuals returns true when every qualifier accepts the row.
+func evaluateQuals(quals []Expression, env *evalEnv) (bool, error) {
+	for _, qual := range quals {
+		ok, err := evaluatePredicate(qual, env)
+		if err != nil || !ok {
+			return false, err
+		}
+	}
+	return true, nil
+}
+
+func evaluateUnary(e *UnaryExpression, env *evalEnv) (any, error) {
+	v, err := evaluateExpression(e.Operand, env)
+	if err != nil || v == nil {
+		return nil, err
+	}
+	switch e.Operator {
+	case UnaryOpNot:
+		b, ok := v.(bool)
+		if !ok {
+			return nil, fmt.Errorf("NOT requires a boolean operand, got %T", v)
+		}
+		return !b, nil
+	case UnaryOpMinus:
+		if i, ok := toInt64(v); ok {
+			return -i, nil
+		}
+		if f, ok := toFloat64(v); ok {
+			return -f, nil
+		}
+		return nil, fmt.Errorf("cannot negate %T", v)
+	case UnaryOpPlus:
+		return v, nil
+	default:
+		return nil, fmt.Errorf("unsupported unary operator: %s", e.Operator)
+	}
+}
+
+func evaluateBinary(e *BinaryExpression, env *evalEnv) (any, error) {
+	// AND/OR short-circuit and have their own NULL rules.
+	if e.Operator == OpAnd || e.Operator == OpOr {
+		return evaluateLogical(e, env)
+	}
+
+	left, err := evaluateExpression(e.Left, env)
+	if err != nil {
+		return nil, err
+	}
+
+	if e.Operator == OpIn || e.Operator == OpNotIn {
+		return evaluateIn(left, e.Right, e.Operator == OpNotIn, env)
+	}
+	if lit, ok := e.Right.(*LiteralExpression); ok && lit.Type == LiteralNull {
+		// IS NULL and IS NOT NULL parse as comparisons with NULL.
+		switch e.Operator {
+		case OpEqual:
+			return left == nil, nil
+		case OpNotEqual:
+			return left != nil, nil
+		}
+	}
+
+	right, err := evaluateExpression(e.Right, env)
+	if err != nil {
+		return nil, err
+	}
+	if left == nil || right == nil {
+		return nil, nil
+	}
+
+	switch e.Operator {
+	case OpEqual, OpNotEqual, OpLess, OpLessEqual, OpGreater, OpGreaterEqual:
+		cmp, ok := compareValues(left, right)
+		if !ok {
+			// Incomparable types are never equal.
+			return e.Operator == OpNotEqual, nil
+		}
+		switch e.Operator {
+		case OpEqual:
+			return cmp == 0, nil
+		case OpNotEqual:
+			return cmp != 0, nil
+		case OpLess:
+			return cmp < 0, nil
+		case OpLessEqual:
+			return cmp <= 0, nil
+		case OpGreater:
+			return cmp > 0, nil
+		default:
+			return cmp >= 0, nil
+		}
+	case OpLike, OpNotLike, OpILike, OpNotILike:
+		s, p := fmt.Sprint(left), fmt.Sprint(right)
+		if e.Operator == OpILike || e.Operator == OpNotILike {
+			s, p = strings.ToLower(s), strings.ToLower(p)
+		}
+		matched := likeMatch(s, p)
+		if e.Operator == OpNotLike || e.Operator == OpNotILike {
+			return !matched, nil
+		}
+		return matched, nil
+	case OpConcat:
+		return fmt.Sprint(left) + fmt.Sprint(right), nil
+	case OpPlus, OpMinus, OpMultiply, OpDivide, OpModulo:
+		return evaluateArithmetic(e.Operator, left, right)
+	default:
+		return nil, fmt.Errorf("unsupported binary operator in executor: %s", e.Operator)
+	}
+}
+
+func evaluateLogical(e *BinaryExpression, env *evalEnv) (any, error) {
+	left, err := evaluateExpression(e.Left, env)
+	if err != nil {
+		return nil, err
+	}
+	lb, lok := left.(bool)
+	if lok && e.Operator == OpAnd && !lb {
+		return false, nil
+	}
+	if lok && e.Operator == OpOr && lb {
+		return true, nil
+	}
+
+	right, err := evaluateExpression(e.Right, env)
+	if err != nil {
+		return nil, err
+	}
+	rb, rok := right.(bool)
+	if e.Operator == OpAnd {
+		if rok && !rb {
+			return false, nil
+		}
+		if lok && rok {
+			return true, nil
+		}
+		return nil, nil
+	}
+	if rok && rb {
+		return true, nil
+	}
+	if lok && rok {
+		return false, nil
+	}
+	return nil, nil
+}
+
+func evaluateIn(left any, list Expression, negate bool, env *evalEnv) (any, error) {
+	if left == nil {
+		return nil, nil
+	}
+	// A parenthesised single value parses as a plain expression rather
+	// than a list literal.
+	elements := []Expression{list}
+	if lit, ok := list.(*LiteralExpression); ok {
+		if values, ok := lit.Value.([]Expression); ok {
+			elements = values
+		}
+	}
+	for _, elem := range elements {
+		v, err := evaluateExpression(elem, env)
+		if err != nil {
+			return nil, err
+		}
+		if v == nil {
+			continue
+		}
+		if cmp, ok := compareValues(left, v); ok && cmp == 0 {
+			return !negate, nil
+		}
+	}
+	return negate, nil
+}
+
+func evaluateArithmetic(op BinaryOperator, left, right any) (any, error) {
+	li, lInt := toInt64(left)
+	ri, rInt := toInt64(right)
+	if lInt && rInt {
+		switch op {
+		case OpPlus:
+			return li + ri, nil
+		case OpMinus:
+			return li - ri, nil
+		case OpMultiply:
+			return li * ri, nil
+		case OpDivide:
+			if ri == 0 {
+				return nil, fmt.Errorf("division by zero")
+			}
+			return li / ri, nil
+		case OpModulo:
+			if ri == 0 {
+				return nil, fmt.Errorf("division by zero")
+			}
+			return li % ri, nil
+		}
+	}
+
+	lf, lok := toFloat64(left)
+	rf, rok := toFloat64(right)
+	if !lok || !rok {
+		return nil, fmt.Errorf("arithmetic on non-numeric values %T and %T", left, right)
+	}
+	switch op {
+	case OpPlus:
+		return lf + rf, nil
+	case OpMinus:
+		return lf - rf, nil
+	case OpMultiply:
+		return lf * rf, nil
+	case OpDivide:
+		if rf == 0 {
+			return nil, fmt.Errorf("division by zero")
+		}
+		return lf / rf, nil
+	default:
+		return math.Mod(lf, rf), nil
+	}
+}
+
+func evaluateCase(e *CaseExpression, env *evalEnv) (any, error) {
+	var subject any
+	if e.Expression != nil {
+		v, err := evaluateExpression(e.Expression, env)
+		if err != nil {
+			return nil, err
+		}
+		subject = v
+	}
+
+	for _, when := range e.WhenClauses {
+		if e.Expression != nil {
+			v, err := evaluateExpression(when.Condition, env)
+			if err != nil {
+				return nil, err
+			}
+			if cmp, ok := compareValues(subject, v); ok && cmp == 0 {
+				return evaluateExpression(when.Result, env)
+			}
+			continue
+		}
+		ok, err := evaluatePredicate(when.Condition, env)
+		if err != nil {
+			return nil, err
+		}
+		if ok {
+			return evaluateExpression(when.Result, env)
+		}
+	}
+	return evaluateExpression(e.ElseClause, env)
+}
+
+// evaluateScalarFunction handles the small set of row-level functions the
+// executor understands. Aggregates never reach this point when they have
+// been computed by an aggregate operator.
+func evaluateScalarFunction(e *FunctionCall, env *evalEnv) (any, error) {
+	args := make([]any, len(e.Arguments))
+	for i, arg := range e.Arguments {
+		v, err := evaluateExpression(arg, env)
+		if err != nil {
+			return nil, err
+		}
+		args[i] = v
+	}
+
+	switch strings.ToUpper(e.Name) {
+	case "LOWER":
+		if len(args) == 1 && args[0] != nil {
+			return strings.ToLower(fmt.Sprint(args[0])), nil
+		}
+	case "UPPER":
+		if len(args) == 1 && args[0] != nil {
+			return strings.ToUpper(fmt.Sprint(args[0])), nil
+		}
+	case "LENGTH":
+		if len(args) == 1 && args[0] != nil {
+			return int64(len(fmt.Sprint(args[0]))), nil
+		}
+	case "ABS":
+		if len(args) == 1 {
+			if i, ok := toInt64(args[0]); ok {
+				if i < 0 {
+					return -i, nil
+				}
+				return i, nil
+			}
+			if f, ok := toFloat64(args[0]); ok {
+				return math.Abs(f), nil
+			}
+		}
+	case "COALESCE":
+		for _, a := range args {
+			if a != nil {
+				return a, nil
+			}
+		}
+	default:
+		if isAggregateFunction(e.Name) {
+			return nil, fmt.Errorf("aggregate function %s used outside of an aggregate context", e.Name)
+		}
+		return nil, fmt.Errorf("unsupported function in executor: %s", e.Name)
+	}
+	return nil, nil
+}
+
+// likeMatch implements SQL LIKE with % and _ wildcards.
+func likeMatch(s, pattern string) bool {
+	sr, pr := []rune(s), []rune(pattern)
+	si, pi := 0, 0
+	star, match := -1, 0
+	for si < len(sr) {
+		if pi < len(pr) && (pr[pi] == '_' || pr[pi] == sr[si]) {
+			si++
+			pi++
+		} else if pi < len(pr) && pr[pi] == '%' {
+			star = pi
+			match = si
+			pi++
+		} else if star != -1 {
+			pi = star + 1
+			match++
+			si = match
+		} else {
+			return false
+		}
+	}
+	for pi < len(pr) && pr[pi] == '%' {
+		pi++
+	}
+	return pi == len(pr)
+}
+
+// compareValues orders two non-NULL values. ok is false when the values
+// have no meaningful ordering relative to each other.
+func compareValues(a, b any) (int, bool) {
+	if ai, ok := toInt64(a); ok {
+		if bi, ok := toInt64(b); ok {
+			switch {
+			case ai < bi:
+				return -1, true
+			case ai > bi:
+				return 1, true
+			}
+			return 0, true
+		}
+	}
+	if af, ok := toFloat64(a); ok {
+		if bf, ok := toFloat64(b); ok {
+			switch {
+			case af < bf:
+				return -1, true
+			case af > bf:
+				return 1, true
+			}
+			return 0, true
+		}
+	}
+
+	switch av := a.(type) {
+	case string:
+		switch bv := b.(type) {
+		case string:
+			return strings.Compare(av, bv), true
+		case []byte:
+			return strings.Compare(av, string(bv)), true
+		}
+	case []byte:
+		switch bv := b.(type) {
+		case string:
+			return strings.Compare(string(av), bv), true
+		case []byte:
+			return strings.Compare(string(av), string(bv)), true
+		}
+	case bool:
+		if bv, ok := b.(bool); ok {
+			switch {
+			case av == bv:
+				return 0, true
+			case !av:
+				return -1, true
+			}
+			return 1, true
+		}
+	case time.Time:
+		if bv, ok := b.(time.Time); ok {
+			return av.Compare(bv), true
+		}
+	}
+	return 0, false
+}
+
+// compareForSort is a total order used by sort and merge operators: NULLs
+// sort last and incomparable types fall back to their type names so the
+// ordering stays deterministic.
+func compareForSort(a, b any) int {
+	switch {
+	case a == nil && b == nil:
+		return 0
+	case a == nil:
+		return 1
+	case b == nil:
+		return -1
+	}
+	if cmp, ok := compareValues(a, b); ok {
+		return cmp
+	}
+	return strings.Compare(fmt.Sprintf("%T", a), fmt.Sprintf("%T", b))
+}
+
+func toInt64(v any) (int64, bool) {
+	switch n := v.(type) {
+	case int:
+		return int64(n), true
+	case int8:
+		return int64(n), true
+	case int16:
+		return int64(n), true
+	case int32:
+		return int64(n), true
+	case int64:
+		return n, true
+	case uint8:
+		return int64(n), true
+	case uint16:
+		return int64(n), true
+	case uint32:
+		return int64(n), true
+	case uint:
+		if uint64(n) <= math.MaxInt64 {
+			return int64(n), true
+		}
+	case uint64:
+		if n <= math.MaxInt64 {
+			return int64(n), true
+		}
+	}
+	return 0, false
+}
+
+func toFloat64(v any) (float64, bool) {
+	switch n := v.(type) {
+	case float64:
+		return n, true
+	case float32:
+		return float64(n), true
+	}
+	if i, ok := toInt64(v); ok {
+		return float64(i), true
+	}
+	return 0, false
+}
+
+// isAggregateFunction reports whether name is an aggregate the executor
+// computes in an aggregate operator.
+func isAggregateFunction(name string) bool {
+	switch strings.ToUpper(name) {
+	case "COUNT", "SUM", "MIN", "MAX", "AVG", "APPROX_COUNT_DISTINCT":
+		return true
+	}
+	return false
+}
+
+// containsAggregate reports whether expr references an aggregate function.
+func containsAggregate(expr Expression) bool {
+	switch e := expr.(type) {
+	case *FunctionCall:
+		if e.Over == nil && isAggregateFunction(e.Name) {
+			return true
+		}
+		for _, arg := range e.Arguments {
+			if containsAggregate(arg) {
+				return true
+			}
+		}
+	case *BinaryExpression:
+		return containsAggregate(e.Left) || containsAggregate(e.Right)
+	case *UnaryExpression:
+		return containsAggregate(e.Operand)
+	case *CaseExpression:
+		if containsAggregate(e.Expression) || containsAggregate(e.ElseClause) {
+			return true
+		}
+		for _, when := range e.WhenClauses {
+			if containsAggregate(when.Condition) || containsAggregate(when.Result) {
+				return true
+			}
+		}
+	}
+	return false
+}
+
+// checkReferences returns an error for the first column expr references
+// that columns lacks, or for a part of expr the evaluator cannot run.
+// Aggregate calls are passed to aggregate rather than walked; with a nil
+// aggregate they are an error too.
+func checkReferences(expr Expression, columns map[string]int, aggregate func(*FunctionCall) error) error {
+	switch e := expr.(type) {
+	case nil, *ParameterExpression:
+		return nil
+	case *LiteralExpression:
+		if elems, ok := e.Value.([]Expression); ok {
+			for _, elem := range elems {
+				if err := checkReferences(elem, columns, aggregate); err != nil {
+					return err
+				}
+			}
+		}
+		return nil
+	case *IdentifierExpression:
+		if _, ok := lookupColumn(columns, e); !ok {
+			return fmt.Errorf("column %q does not exist", e.String())
+		}
+		return nil
+	case *FunctionCall:
+		if e.Over != nil {
+			return fmt.Errorf("window function %s is not supported by the executor", e.Name)
+		}
+		if isAggregateFunction(e.Name) {
+			if aggregate == nil {
+				return fmt.Errorf("aggregate %s is not allowed here", expressionKey(e))
+			}
+			return aggregate(e)
+		}
+		for _, arg := range e.Arguments {
+			if err := checkReferences(arg, columns, aggregate); err != nil {
+				return err
+			}
+		}
+		return nil
+	case *BinaryExpression:
+		if e.Operator == OpExists {
+			break
+		}
+		if err := checkReferences(e.Left, columns, aggregate); err != nil {
+			return err
+		}
+		return checkReferences(e.Right, columns, aggregate)
+	case *UnaryExpression:
+		return checkReferences(e.Operand, columns, aggregate)
+	case *CaseExpression:
+		if err := checkReferences(e.Expression, columns, aggregate); err != nil {
+			return err
+		}
+		if err := checkReferences(e.ElseClause, columns, aggregate); err != nil {
+			return err
+		}
+		for _, when := range e.WhenClauses {
+			if err := checkReferences(when.Condition, columns, aggregate); err != nil {
+				return err
+			}
+			if err := checkReferences(when.Result, columns, aggregate); err != nil {
+				return err
+			}
+		}
+		return nil
+	}
+	return fmt.Errorf("expression %s is not supported by the executor", expr)
+}
+
+// expressionKey renders expr structurally. Unlike String(), it includes
+// function arguments, so two aggregates over different columns never share
+// a key.
+func expressionKey(expr Expression) string {
+	switch e := expr.(type) {
+	case nil:
+		return ""
+	case *FunctionCall:
+		args := make([]string, len(e.Arguments))
+		for i, arg := range e.Arguments {
+			args[i] = expressionKey(arg)
+		}
+		prefix := ""
+		if e.Distinct {
+			prefix = "DISTINCT "
+		}
+		return fmt.Sprintf("%s(%s%s)", strings.ToUpper(e.Name), prefix, strings.Join(args, ","))
+	case *BinaryExpression:
+		return fmt.Sprintf("(%s %s %s)", expressionKey(e.Left), e.Operator, expressionKey(e.Right))
+	case *UnaryExpression:
+		return fmt.Sprintf("(%s %s)", e.Operator, expressionKey(e.Operand))
+	case *IdentifierExpression:
+		return strings.ToLower(e.String())
+	case *LiteralExpression:
+		if elems, ok := e.Value.([]Expression); ok {
+			parts := make([]string, len(elems))
+			for i, elem := range elems {
+				parts[i] = expressionKey(elem)
+			}
+			return "[" + strings.Join(parts, ",") + "]"
+		}
+		return fmt.Sprintf("%T:%v", e.Value, e.Value)
+	default:
+		return expr.String()
+	}
+}
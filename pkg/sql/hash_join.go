@@ -0,0 +1,773 @@
+package sql
+
+import (
+	"bytes"
+	"fmt"
+	"hash/maphash"
+	"math"
+	"strings"
+	"sync"
+)
+
+// Build rows are split into 2^hashJoinRadixBits partitions by the top bits
+// of their key hash. A partition is the unit of spilling and of parallel
+// hash table construction.
+const hashJoinRadixBits = 5
+
+const hashJoinPartitions = 1 << hashJoinRadixBits
+
+// hashJoinOperator joins its inputs on the equality conjuncts of the join
+// clauses. Keys are hashed from their typed encoding rather than formatted
+// strings, the build side is whichever input the planner estimates to be
+// smaller, and when the build side outgrows ExecutorConfig.HashTableSize the
+// largest partitions move to disk together with the probe rows that hash to
+// them, to be joined one partition at a time once the probe input ends.
+//
+// Non-equality conjuncts are checked on each joined row. With no equality
+// conjuncts at all every row shares one key, which degenerates into a nested
+// loop join.
+type hashJoinOperator struct {
+	left, right         Operator
+	leftPlan, rightPlan *QueryPlan
+	joinType            JoinType
+	clauses             []Expression
+	batchSize           int
+	memLimit            int64
+	workers             int
+	seed                maphash.Seed
+
+	ctx       *ExecutionContext
+	columns   []ColumnInfo
+	tables    []string
+	leftWidth int
+
+	buildLeft     bool
+	build, probe  Operator
+	buildKeys     []Expression
+	probeKeys     []Expression
+	residual      []Expression
+	buildEnv      *evalEnv
+	probeEnv      *evalEnv
+	joinEnv       *evalEnv
+	preserveBuild bool
+	preserveProbe bool
+
+	keyBuf     []byte
+	partitions []*joinPartition
+	nullKeyed  []Row // preserved build rows whose key is NULL; they never match
+	memUsed    int64
+
+	out       []Row
+	probeDone bool
+	spilled   []*joinPartition // spilled partitions still to be joined
+	current   *joinPartition   // spilled partition being joined
+	done      bool
+	spillStats
+}
+
+// joinPartition holds the build rows of one radix partition. Rows with the
+// same hash are chained through next, starting from heads.
+type joinPartition struct {
+	rows    []Row
+	keys    []byte // encoded keys, back to back
+	keyEnds []int
+	hashes  []uint64
+	bytes   int64
+
+	heads   map[uint64]int32
+	next    []int32
+	matched []bool
+
+	buildSpill *spillFile
+	probeSpill *spillFile
+}
+
+func (qe *QueryExecutor) newHashJoinOperator(plan *QueryPlan, prof *planProfiler) (*hashJoinOperator, error) {
+	left, err := qe.buildProfiledOperator(joinInputPlan(plan.LeftTree), prof)
+	if err != nil {
+		return nil, err
+	}
+	right, err := qe.buildProfiledOperator(joinInputPlan(plan.RightTree), prof)
+	if err != nil {
+		return nil, err
+	}
+	workers := 1
+	if qe.config.EnableParallel && qe.config.MaxWorkers > 1 {
+		workers = qe.config.MaxWorkers
+	}
+	return &hashJoinOperator{
+		left:      left,
+		right:     right,
+		leftPlan:  plan.LeftTree,
+		rightPlan: plan.RightTree,
+		joinType:  plan.JoinType,
+		clauses:   plan.JoinClauses,
+		batchSize: qe.config.BatchSize,
+		memLimit:  qe.config.HashTableSize,
+		workers:   workers,
+		seed:      maphash.MakeSeed(),
+	}, nil
+}
+
+func (j *hashJoinOperator) Open(ctx *ExecutionContext) error {
+	j.ctx = ctx
+	if err := j.left.Open(ctx); err != nil {
+		return err
+	}
+	if err := j.right.Open(ctx); err != nil {
+		return err
+	}
+
+	leftCols, rightCols := j.left.Columns(), j.right.Columns()
+	leftTables := joinColumnTables(j.leftPlan, j.left)
+	rightTables := joinColumnTables(j.rightPlan, j.right)
+	j.leftWidth = len(leftCols)
+	j.columns = append(append(make([]ColumnInfo, 0, len(leftCols)+len(rightCols)), leftCols...), rightCols...)
+	j.tables = append(append(make([]string, 0, len(j.columns)), leftTables...), rightTables...)
+
+	leftIdx := qualifiedColumnIndex(leftCols, leftTables)
+	rightIdx := qualifiedColumnIndex(rightCols, rightTables)
+	var leftKeys, rightKeys []Expression
+	for _, clause := range j.clauses {
+		for _, conjunct := range splitConjuncts(clause) {
+			if l, r, ok := equiJoinKey(conjunct, leftIdx, rightIdx); ok {
+				leftKeys = append(leftKeys, l)
+				rightKeys = append(rightKeys, r)
+			} else {
+				j.residual = append(j.residual, conjunct)
+			}
+		}
+	}
+
+	var preserveLeft, preserveRight bool
+	switch j.joinType {
+	case LeftJoin, LeftOuterJoin:
+		preserveLeft = true
+	case RightJoin, RightOuterJoin:
+		preserveRight = true
+	case FullJoin, FullOuterJoin:
+		preserveLeft, preserveRight = true, true
+	}
+
+	// Build on the input the planner expects to be smaller; without an
+	// estimate keep the conventional right-hand build side.
+	j.buildLeft = j.leftPlan.PlanRows > 0 && j.leftPlan.PlanRows < j.rightPlan.PlanRows
+	leftEnv := &evalEnv{columns: leftIdx, params: ctx.Parameters}
+	rightEnv := &evalEnv{columns: rightIdx, params: ctx.Parameters}
+	if j.buildLeft {
+		j.build, j.probe = j.left, j.right
+		j.buildKeys, j.probeKeys = leftKeys, rightKeys
+		j.buildEnv, j.probeEnv = leftEnv, rightEnv
+		j.preserveBuild, j.preserveProbe = preserveLeft, preserveRight
+	} else {
+		j.build, j.probe = j.right, j.left
+		j.buildKeys, j.probeKeys = rightKeys, leftKeys
+		j.buildEnv, j.probeEnv = rightEnv, leftEnv
+		j.preserveBuild, j.preserveProbe = preserveRight, preserveLeft
+	}
+	j.joinEnv = &evalEnv{columns: qualifiedColumnIndex(j.columns, j.tables), params: ctx.Parameters}
+
+	ctx.Stats.JoinsExecuted++
+	return j.consumeBuild()
+}
+
+// consumeBuild drains the build input into partitions, spilling the largest
+// partition whenever the budget is exceeded, and then builds the hash
+// tables of the partitions that stayed in memory.
+func (j *hashJoinOperator) consumeBuild() error {
+	j.partitions = make([]*joinPartition, hashJoinPartitions)
+	for i := range j.partitions {
+		j.partitions[i] = &joinPartition{}
+	}
+
+	for {
+		if err := checkCancelled(j.ctx); err != nil {
+			return err
+		}
+		batch, err := j.build.NextBatch()
+		if err != nil {
+			return err
+		}
+		if batch == nil {
+			break
+		}
+		for _, row := range batch.Rows {
+			key, hash, null, err := j.joinKey(j.buildKeys, j.buildEnv, row)
+			if err != nil {
+				return err
+			}
+			if null {
+				if j.preserveBuild {
+					j.nullKeyed = append(j.nullKeyed, row)
+				}
+				continue
+			}
+			p := j.partitions[hash>>(64-hashJoinRadixBits)]
+			if p.buildSpill != nil {
+				if err := p.buildSpill.writeRow(row); err != nil {
+					return err
+				}
+				continue
+			}
+			j.memUsed += p.add(row, key, hash)
+			j.noteMemory(j.memUsed)
+			for j.memUsed > j.memLimit {
+				spilled, err := j.spillLargest()
+				if err != nil {
+					return err
+				}
+				if !spilled {
+					break
+				}
+			}
+		}
+	}
+
+	j.buildTables()
+	return nil
+}
+
+// joinKey evaluates and encodes the key of row. The returned slice is only
+// valid until the next call.
+func (j *hashJoinOperator) joinKey(exprs []Expression, env *evalEnv, row Row) (key []byte, hash uint64, null bool, err error) {
+	env.row = row
+	buf := j.keyBuf[:0]
+	for _, expr := range exprs {
+		v, err := evaluateExpression(expr, env)
+		if err != nil {
+			return nil, 0, false, fmt.Errorf("failed to evaluate join key: %w", err)
+		}
+		if v == nil {
+			return nil, 0, true, nil
+		}
+		buf = appendJoinKey(buf, v)
+	}
+	j.keyBuf = buf
+	return buf, maphash.Bytes(j.seed, buf), false, nil
+}
+
+// appendJoinKey encodes a key value so that values SQL considers equal
+// encode identically; integral floats take the integer form so 3 = 3.0.
+func appendJoinKey(buf []byte, v any) []byte {
+	var f float64
+	switch x := v.(type) {
+	case float64:
+		f = x
+	case float32:
+		f = float64(x)
+	default:
+		return appendValueKey(buf, v)
+	}
+	if f == math.Trunc(f) && f >= math.MinInt64 && f < math.MaxInt64 {
+		return appendValueKey(buf, int64(f))
+	}
+	return appendValueKey(buf, f)
+}
+
+// spillLargest writes the largest in-memory partition to disk and reports
+// whether there was anything left to spill.
+func (j *hashJoinOperator) spillLargest() (bool, error) {
+	var victim *joinPartition
+	for _, p := range j.partitions {
+		if p.buildSpill == nil && len(p.rows) > 0 && (victim == nil || p.bytes > victim.bytes) {
+			victim = p
+		}
+	}
+	if victim == nil {
+		return false, nil
+	}
+
+	f, err := newSpillFile()
+	if err != nil {
+		return false, err
+	}
+	for _, row := range victim.rows {
+		if err := f.writeRow(row); err != nil {
+			f.close()
+			return false, err
+		}
+	}
+	victim.buildSpill = f
+	j.spills++
+	j.memUsed -= victim.bytes
+	victim.reset()
+	return true, nil
+}
+
+// buildTables indexes every in-memory partition. Partitions share nothing,
+// so with parallelism enabled they are built concurrently.
+func (j *hashJoinOperator) buildTables() {
+	var pending []*joinPartition
+	for _, p := range j.partitions {
+		if p.buildSpill == nil && len(p.rows) > 0 {
+			pending = append(pending, p)
+		}
+	}
+	if j.workers <= 1 || len(pending) <= 1 {
+		for _, p := range pending {
+			p.buildTable(j.preserveBuild)
+		}
+		return
+	}
+
+	sem := make(chan struct{}, j.workers)
+	var wg sync.WaitGroup
+	for _, p := range pending {
+		wg.Add(1)
+		sem <- struct{}{}
+		go func(p *joinPartition) {
+			defer wg.Done()
+			p.buildTable(j.preserveBuild)
+			<-sem
+		}(p)
+	}
+	wg.Wait()
+}
+
+func (j *hashJoinOperator) NextBatch() (*RowBatch, error) {
+	for len(j.out) < j.batchSize && !j.done {
+		if err := checkCancelled(j.ctx); err != nil {
+			return nil, err
+		}
+		if err := j.step(); err != nil {
+			return nil, err
+		}
+	}
+	if len(j.out) == 0 {
+		return nil, nil
+	}
+
+	n := len(j.out)
+	if n > j.batchSize {
+		n = j.batchSize
+	}
+	batch := &RowBatch{Rows: j.out[:n:n]}
+	j.out = j.out[n:]
+	if len(j.out) == 0 {
+		j.out = nil
+	}
+	j.ctx.Stats.RowsProcessed += int64(n)
+	return batch, nil
+}
+
+// step does one unit of work: probe one input batch, or advance the join of
+// a spilled partition.
+func (j *hashJoinOperator) step() error {
+	switch {
+	case !j.probeDone:
+		batch, err := j.probe.NextBatch()
+		if err != nil {
+			return err
+		}
+		if batch == nil {
+			j.probeDone = true
+			j.finishInMemory()
+			return nil
+		}
+		for _, row := range batch.Rows {
+			key, hash, null, err := j.joinKey(j.probeKeys, j.probeEnv, row)
+			if err != nil {
+				return err
+			}
+			if null {
+				if j.preserveProbe {
+					j.out = append(j.out, j.joinRow(nil, row.Values))
+				}
+				continue
+			}
+			p := j.partitions[hash>>(64-hashJoinRadixBits)]
+			if p.buildSpill != nil {
+				if p.probeSpill == nil {
+					if p.probeSpill, err = newSpillFile(); err != nil {
+						return err
+					}
+				}
+				if err := p.probeSpill.writeRow(row); err != nil {
+					return err
+				}
+				continue
+			}
+			if err := j.probeRow(p, row, key, hash); err != nil {
+				return err
+			}
+		}
+		return nil
+	case j.current != nil:
+		return j.stepSpilled()
+	case len(j.spilled) > 0:
+		return j.loadSpilled()
+	default:
+		j.done = true
+		return nil
+	}
+}
+
+// probeRow joins one probe row against an in-memory partition.
+func (j *hashJoinOperator) probeRow(p *joinPartition, row Row, key []byte, hash uint64) error {
+	matched := false
+	i, ok := p.heads[hash]
+	if !ok {
+		i = -1
+	}
+	for ; i >= 0; i = p.next[i] {
+		if !bytes.Equal(p.key(int(i)), key) {
+			continue
+		}
+		joined := j.joinRow(p.rows[i].Values, row.Values)
+		if len(j.residual) > 0 {
+			j.joinEnv.row = joined
+			ok, err := evaluateQuals(j.residual, j.joinEnv)
+			if err != nil {
+				return err
+			}
+			if !ok {
+				continue
+			}
+		}
+		matched = true
+		if p.matched != nil {
+			p.matched[i] = true
+		}
+		j.out = append(j.out, joined)
+	}
+	if !matched && j.preserveProbe {
+		j.out = append(j.out, j.joinRow(nil, row.Values))
+	}
+	return nil
+}
+
+// joinRow lays out a result row as left columns then right columns,
+// whichever input was the build side. A nil side is NULL-padded.
+func (j *hashJoinOperator) joinRow(build, probe []any) Row {
+	left, right := probe, build
+	if j.buildLeft {
+		left, right = build, probe
+	}
+	values := make([]any, len(j.columns))
+	copy(values[:j.leftWidth], left)
+	copy(values[j.leftWidth:], right)
+	return Row{Values: values}
+}
+
+// finishInMemory runs once the probe input is exhausted: in-memory
+// partitions are complete, so their unmatched build rows can be emitted and
+// their memory released before the spilled partitions are loaded.
+func (j *hashJoinOperator) finishInMemory() {
+	for _, p := range j.partitions {
+		if p.buildSpill != nil {
+			j.spilled = append(j.spilled, p)
+			continue
+		}
+		j.emitUnmatched(p)
+		p.reset()
+	}
+	for _, row := range j.nullKeyed {
+		j.out = append(j.out, j.joinRow(row.Values, nil))
+	}
+	j.nullKeyed = nil
+	j.memUsed = 0
+}
+
+// loadSpilled reads the next spilled build partition back into memory.
+func (j *hashJoinOperator) loadSpilled() error {
+	p := j.spilled[0]
+	j.spilled = j.spilled[1:]
+
+	build := p.buildSpill
+	p.buildSpill = nil
+	defer build.close()
+	if err := build.rewind(); err != nil {
+		return err
+	}
+	for {
+		row, ok, err := build.readRow()
+		if err != nil {
+			return err
+		}
+		if !ok {
+			break
+		}
+		key, hash, _, err := j.joinKey(j.buildKeys, j.buildEnv, row)
+		if err != nil {
+			return err
+		}
+		p.add(row, key, hash)
+	}
+	p.buildTable(j.preserveBuild)
+
+	if p.probeSpill != nil {
+		if err := p.probeSpill.rewind(); err != nil {
+			return err
+		}
+	}
+	j.current = p
+	return nil
+}
+
+// stepSpilled probes the current spilled partition with its spilled probe
+// rows, yielding once a batch worth of output is ready.
+func (j *hashJoinOperator) stepSpilled() error {
+	p := j.current
+	for p.probeSpill != nil {
+		row, ok, err := p.probeSpill.readRow()
+		if err != nil {
+			return err
+		}
+		if !ok {
+			err := p.probeSpill.close()
+			p.probeSpill = nil
+			if err != nil {
+				return err
+			}
+			break
+		}
+		key, hash, _, err := j.joinKey(j.probeKeys, j.probeEnv, row)
+		if err != nil {
+			return err
+		}
+		if err := j.probeRow(p, row, key, hash); err != nil {
+			return err
+		}
+		if len(j.out) >= j.batchSize {
+			return nil
+		}
+	}
+	j.emitUnmatched(p)
+	p.reset()
+	j.current = nil
+	return nil
+}
+
+func (j *hashJoinOperator) emitUnmatched(p *joinPartition) {
+	if !j.preserveBuild {
+		return
+	}
+	for i, row := range p.rows {
+		if !p.matched[i] {
+			j.out = append(j.out, j.joinRow(row.Values, nil))
+		}
+	}
+}
+
+func (j *hashJoinOperator) Close() error {
+	var firstErr error
+	for _, p := range j.partitions {
+		for _, f := range []*spillFile{p.buildSpill, p.probeSpill} {
+			if f != nil {
+				if err := f.close(); err != nil && firstErr == nil {
+					firstErr = err
+				}
+			}
+		}
+		p.buildSpill, p.probeSpill = nil, nil
+		p.reset()
+	}
+	j.partitions, j.spilled, j.current, j.out = nil, nil, nil, nil
+
+	if err := j.left.Close(); err != nil && firstErr == nil {
+		firstErr = err
+	}
+	if err := j.right.Close(); err != nil && firstErr == nil {
+		firstErr = err
+	}
+	return firstErr
+}
+
+func (j *hashJoinOperator) Columns() []ColumnInfo { return j.columns }
+
+// add appends a build row and returns the memory it accounts for.
+func (p *joinPartition) add(row Row, key []byte, hash uint64) int64 {
+	p.rows = append(p.rows, row)
+	p.keys = append(p.keys, key...)
+	p.keyEnds = append(p.keyEnds, len(p.keys))
+	p.hashes = append(p.hashes, hash)
+	size := rowFootprint(row) + int64(len(key)) + 24
+	p.bytes += size
+	return size
+}
+
+func (p *joinPartition) key(i int) []byte {
+	start := 0
+	if i > 0 {
+		start = p.keyEnds[i-1]
+	}
+	return p.keys[start:p.keyEnds[i]]
+}
+
+func (p *joinPartition) buildTable(trackMatches bool) {
+	p.heads = make(map[uint64]int32, len(p.rows))
+	p.next = make([]int32, len(p.rows))
+	for i, h := range p.hashes {
+		if head, ok := p.heads[h]; ok {
+			p.next[i] = head
+		} else {
+			p.next[i] = -1
+		}
+		p.heads[h] = int32(i)
+	}
+	if trackMatches {
+		p.matched = make([]bool, len(p.rows))
+	}
+}
+
+func (p *joinPartition) reset() {
+	p.rows, p.keys, p.keyEnds, p.hashes = nil, nil, nil, nil
+	p.heads, p.next, p.matched = nil, nil, nil
+	p.bytes = 0
+}
+
+// splitConjuncts flattens a tree of ANDs into its operands.
+func splitConjuncts(expr Expression) []Expression {
+	if b, ok := expr.(*BinaryExpression); ok && b.Operator == OpAnd {
+		return append(splitConjuncts(b.Left), splitConjuncts(b.Right)...)
+	}
+	return []Expression{expr}
+}
+
+const (
+	sideNone  = 0
+	sideLeft  = 1
+	sideRight = 2
+	sideBoth  = sideLeft | sideRight
+)
+
+// expressionSides reports which join inputs expr reads. A column found on
+// both inputs, or on neither, counts as both so the clause is checked after
+// joining instead of being used as a hash key.
+func expressionSides(expr Expression, left, right map[string]int) int {
+	switch e := expr.(type) {
+	case *IdentifierExpression:
+		var inLeft, inRight bool
+		if e.Table != "" {
+			qualified := strings.ToLower(e.Table + "." + e.Name)
+			_, inLeft = left[qualified]
+			_, inRight = right[qualified]
+		}
+		if !inLeft && !inRight {
+			name := strings.ToLower(e.Name)
+			_, inLeft = left[name]
+			_, inRight = right[name]
+		}
+		switch {
+		case inLeft && !inRight:
+			return sideLeft
+		case inRight && !inLeft:
+			return sideRight
+		default:
+			return sideBoth
+		}
+	case *BinaryExpression:
+		return expressionSides(e.Left, left, right) | expressionSides(e.Right, left, right)
+	case *UnaryExpression:
+		return expressionSides(e.Operand, left, right)
+	case *FunctionCall:
+		sides := sideNone
+		for _, arg := range e.Arguments {
+			sides |= expressionSides(arg, left, right)
+		}
+		return sides
+	case *CaseExpression:
+		sides := expressionSides(e.Expression, left, right) | expressionSides(e.ElseClause, left, right)
+		for _, when := range e.WhenClauses {
+			sides |= expressionSides(when.Condition, left, right) | expressionSides(when.Result, left, right)
+		}
+		return sides
+	case *Subquery:
+		return sideBoth
+	}
+	return sideNone
+}
+
+// equiJoinKey recognises `a = b` where each operand reads exactly one join
+// input, returning the operands as (left input, right input).
+func equiJoinKey(expr Expression, left, right map[string]int) (Expression, Expression, bool) {
+	b, ok := expr.(*BinaryExpression)
+	if !ok || b.Operator != OpEqual {
+		return nil, nil, false
+	}
+	ls, rs := expressionSides(b.Left, left, right), expressionSides(b.Right, left, right)
+	switch {
+	case ls == sideLeft && rs == sideRight:
+		return b.Left, b.Right, true
+	case ls == sideRight && rs == sideLeft:
+		return b.Right, b.Left, true
+	}
+	return nil, nil, false
+}
+
+// qualifiedColumnIndex extends columnIndexMap with "table.column" entries
+// so qualified identifiers bind to the right input of a join.
+func qualifiedColumnIndex(columns []ColumnInfo, tables []string) map[string]int {
+	m := columnIndexMap(columns)
+	for i, col := range columns {
+		if i < len(tables) && tables[i] != "" {
+			name := strings.ToLower(tables[i] + "." + col.Name)
+			if _, exists := m[name]; !exists {
+				m[name] = i
+			}
+		}
+	}
+	return m
+}
+
+// joinInputPlan returns the plan to run for one input of a join. An index
+// nested loop's inner side is an index scan keyed on outer columns; when
+// the join runs as a join of whole inputs instead of index probes, that
+// side runs as a scan of its table and the join clauses do the matching.
+func joinInputPlan(plan *QueryPlan) *QueryPlan {
+	if plan.Type != PlanTypeIndexScan {
+		return plan
+	}
+	for _, key := range plan.ScanKeys {
+		switch key.Value.(type) {
+		case *LiteralExpression, *ParameterExpression:
+		default:
+			scan := *plan
+			scan.Type = PlanTypeSeqScan
+			scan.IndexName = ""
+			scan.ScanKeys = nil
+			return &scan
+		}
+	}
+	return plan
+}
+
+// joinColumnTables names the table each output column of a join input comes
+// from. Nested joins know this per column; any other input is attributed to
+// the single table beneath it, if there is one.
+func joinColumnTables(plan *QueryPlan, op Operator) []string {
+	for {
+		if f, ok := unwrapOperator(op).(*filterOperator); ok {
+			op = f.child
+			continue
+		}
+		op = unwrapOperator(op)
+		break
+	}
+	switch j := op.(type) {
+	case *hashJoinOperator:
+		return j.tables
+	case *indexNestLoopOperator:
+		return j.tables
+	}
+
+	name := ""
+	for p := plan; p != nil; p = p.LeftTree {
+		if p.RightTree != nil {
+			break
+		}
+		if p.Alias != "" {
+			name = p.Alias
+			break
+		}
+		if p.TableName != "" {
+			name = p.TableName
+			break
+		}
+	}
+	tables := make([]string, len(op.Columns()))
+	for i := range tables {
+		tables[i] = name
+	}
+	return tables
+}
@@ -0,0 +1,74 @@
+package sql
+
+import (
+	"fmt"
+	"hash/maphash"
+	"math"
+	"math/bits"
+)
+
+// hllPrecision sets the number of registers to 2^hllPrecision. 4096
+// one-byte registers give a standard error of about 1.6%.
+const hllPrecision = 12
+
+const hllRegisters = 1 << hllPrecision
+
+// hllSeed is shared by every sketch in the process so partial sketches built
+// by different workers, or spilled and read back, can be merged.
+var hllSeed = maphash.MakeSeed()
+
+// hyperLogLog estimates the number of distinct values in fixed memory.
+type hyperLogLog struct {
+	registers []byte
+}
+
+func newHyperLogLog() *hyperLogLog {
+	return &hyperLogLog{registers: make([]byte, hllRegisters)}
+}
+
+// addKey adds a value already encoded with appendValueKey.
+func (h *hyperLogLog) addKey(key []byte) {
+	x := maphash.Bytes(hllSeed, key)
+	idx := x >> (64 - hllPrecision)
+	// Rank of the first set bit in the remaining bits; the sentinel bit
+	// caps it when they are all zero.
+	rank := byte(bits.LeadingZeros64(x<<hllPrecision|1<<(hllPrecision-1)) + 1)
+	if rank > h.registers[idx] {
+		h.registers[idx] = rank
+	}
+}
+
+func (h *hyperLogLog) merge(o *hyperLogLog) {
+	for i, r := range o.registers {
+		if r > h.registers[i] {
+			h.registers[i] = r
+		}
+	}
+}
+
+func (h *hyperLogLog) estimate() int64 {
+	var sum float64
+	zeros := 0
+	for _, r := range h.registers {
+		sum += 1 / float64(uint64(1)<<r)
+		if r == 0 {
+			zeros++
+		}
+	}
+	m := float64(hllRegisters)
+	alpha := 0.7213 / (1 + 1.079/m)
+	est := alpha * m * m / sum
+	// Linear counting is more accurate while many registers are empty.
+	if est <= 2.5*m && zeros > 0 {
+		est = m * math.Log(m/float64(zeros))
+	}
+	return int64(est + 0.5)
+}
+
+func (h *hyperLogLog) setRegisters(b []byte) error {
+	if len(b) != hllRegisters {
+		return fmt.Errorf("invalid HyperLogLog sketch of %d bytes", len(b))
+	}
+	copy(h.registers, b)
+	return nil
+}
@@ -0,0 +1,273 @@
+package sql
+
+import (
+	"math"
+	"sort"
+	"strings"
+)
+
+// indexPaths returns the index-based ways to scan a table with quals: an
+// index scan, or an index-only scan when the index covers the table, for
+// every index whose leading columns the quals constrain; a bitmap heap
+// scan over each such index and over the AND of all of them; and a bitmap
+// heap scan over an OR of indexes for each disjunction whose every arm an
+// index can serve. Every path rechecks all of quals.
+func (opt *QueryOptimizer) indexPaths(tableName string, stats *TableStatistics, quals []Expression) []*QueryPlan {
+	if len(quals) == 0 || len(stats.Indexes) == 0 {
+		return nil
+	}
+	indexes := make([]*IndexStatistics, 0, len(stats.Indexes))
+	for _, index := range stats.Indexes {
+		indexes = append(indexes, index)
+	}
+	sort.Slice(indexes, func(i, j int) bool { return indexes[i].IndexName < indexes[j].IndexName })
+
+	var conjuncts []Expression
+	for _, qual := range quals {
+		conjuncts = append(conjuncts, splitConjuncts(qual)...)
+	}
+	rows := stats.RowCount * opt.estimateSelectivity(quals, stats)
+
+	var plans, bitmaps []*QueryPlan
+	for _, index := range indexes {
+		keys, matched := indexScanKeys(index, conjuncts)
+		if len(keys) == 0 {
+			continue
+		}
+		selectivity := opt.estimateSelectivity(matched, stats)
+		scan := &QueryPlan{
+			Type:      PlanTypeIndexScan,
+			TableName: tableName,
+			IndexName: index.IndexName,
+			ScanKeys:  keys,
+			PlanWidth: int(stats.AvgRowWidth),
+			Qual:      quals,
+		}
+		if index.Covering {
+			scan.Type = PlanTypeIndexOnlyScan
+		}
+		opt.costIndexScan(scan, stats, index, selectivity)
+		scan.PlanRows = rows
+		plans = append(plans, scan)
+		bitmaps = append(bitmaps, opt.bitmapIndexScan(tableName, stats, index, keys, selectivity))
+	}
+
+	for _, bitmap := range bitmaps {
+		plans = append(plans, opt.bitmapHeapScan(tableName, stats, quals, bitmap))
+	}
+	if len(bitmaps) > 1 {
+		and := opt.combineBitmaps(PlanTypeBitmapAnd, stats, bitmaps)
+		plans = append(plans, opt.bitmapHeapScan(tableName, stats, quals, and))
+	}
+	for _, conjunct := range conjuncts {
+		if or := opt.bitmapOr(tableName, stats, indexes, conjunct); or != nil {
+			plans = append(plans, opt.bitmapHeapScan(tableName, stats, quals, or))
+		}
+	}
+
+	for _, plan := range plans {
+		plan.PlanRows = rows
+	}
+	return plans
+}
+
+// indexScanKeys turns conjuncts into scan keys for an index: equalities on
+// its leading columns, then comparisons bounding the next column. It also
+// returns the conjuncts the keys came from.
+func indexScanKeys(index *IndexStatistics, conjuncts []Expression) ([]ScanKey, []Expression) {
+	var keys []ScanKey
+	var matched []Expression
+	for _, col := range index.Columns {
+		eq, lo, hi := -1, -1, -1
+		var colKeys [3]ScanKey
+		for i, conjunct := range conjuncts {
+			key, ok := scanKeyOf(conjunct)
+			if !ok || !strings.EqualFold(key.Column, col) {
+				continue
+			}
+			switch key.Operator {
+			case OpEqual:
+				if eq < 0 {
+					eq, colKeys[0] = i, key
+				}
+			case OpGreater, OpGreaterEqual:
+				if lo < 0 {
+					lo, colKeys[1] = i, key
+				}
+			default:
+				if hi < 0 {
+					hi, colKeys[2] = i, key
+				}
+			}
+		}
+		if eq >= 0 {
+			keys = append(keys, colKeys[0])
+			matched = append(matched, conjuncts[eq])
+			continue
+		}
+		if lo >= 0 {
+			keys = append(keys, colKeys[1])
+			matched = append(matched, conjuncts[lo])
+		}
+		if hi >= 0 {
+			keys = append(keys, colKeys[2])
+			matched = append(matched, conjuncts[hi])
+		}
+		break
+	}
+	return keys, matched
+}
+
+// scanKeyOf recognizes a comparison of a column with a constant, in
+// either order, and IS NULL, which an index answers as equality with NULL.
+func scanKeyOf(expr Expression) (ScanKey, bool) {
+	b, ok := expr.(*BinaryExpression)
+	if !ok {
+		return ScanKey{}, false
+	}
+	op := b.Operator
+	switch op {
+	case OpEqual, OpLess, OpLessEqual, OpGreater, OpGreaterEqual:
+	default:
+		return ScanKey{}, false
+	}
+	col, ok := b.Left.(*IdentifierExpression)
+	value := b.Right
+	if !ok {
+		if col, ok = b.Right.(*IdentifierExpression); !ok {
+			return ScanKey{}, false
+		}
+		value = b.Left
+		switch op {
+		case OpLess:
+			op = OpGreater
+		case OpLessEqual:
+			op = OpGreaterEqual
+		case OpGreater:
+			op = OpLess
+		case OpGreaterEqual:
+			op = OpLessEqual
+		}
+	}
+	switch v := value.(type) {
+	case *LiteralExpression:
+		if v.Type == LiteralNull && op != OpEqual {
+			return ScanKey{}, false
+		}
+	case *ParameterExpression:
+	default:
+		return ScanKey{}, false
+	}
+	return ScanKey{Column: col.Name, Operator: op, Value: value}, true
+}
+
+// indexAccessCost estimates reading the entries of an index that make up
+// a fraction selectivity of its table: a descent to the first one, then
+// the leaf pages holding the range.
+func (opt *QueryOptimizer) indexAccessCost(stats *TableStatistics, indexStats *IndexStatistics, selectivity float64) float64 {
+	selected := stats.RowCount * selectivity
+	descent := opt.config.CPUOperatorCost * math.Ceil(math.Log2(math.Max(stats.RowCount, 2)))
+	leafPages := math.Max(1, math.Ceil(indexStats.PageCount*selectivity))
+	return descent + opt.config.RandomPageCost*leafPages + opt.config.CPUIndexTupleCost*selected
+}
+
+func (opt *QueryOptimizer) bitmapIndexScan(tableName string, stats *TableStatistics, index *IndexStatistics, keys []ScanKey, selectivity float64) *QueryPlan {
+	cost := opt.indexAccessCost(stats, index, selectivity)
+	return &QueryPlan{
+		Type:        PlanTypeBitmapIndexScan,
+		TableName:   tableName,
+		IndexName:   index.IndexName,
+		ScanKeys:    keys,
+		StartupCost: cost,
+		TotalCost:   cost,
+		PlanRows:    stats.RowCount * selectivity,
+	}
+}
+
+// combineBitmaps builds a BitmapAnd or BitmapOr of children, assuming the
+// conditions they answer are independent.
+func (opt *QueryOptimizer) combineBitmaps(planType PlanType, stats *TableStatistics, children []*QueryPlan) *QueryPlan {
+	cost := 0.0
+	selectivity := 1.0
+	if planType == PlanTypeBitmapOr {
+		selectivity = 0
+	}
+	for _, child := range children {
+		cost += child.TotalCost + opt.config.CPUOperatorCost*child.PlanRows
+		s := child.PlanRows / math.Max(stats.RowCount, 1)
+		if planType == PlanTypeBitmapAnd {
+			selectivity *= s
+		} else {
+			selectivity += s - selectivity*s
+		}
+	}
+	return &QueryPlan{
+		Type:        planType,
+		TableName:   stats.TableName,
+		SubPlans:    children,
+		StartupCost: cost,
+		TotalCost:   cost,
+		PlanRows:    stats.RowCount * selectivity,
+	}
+}
+
+// bitmapOr plans a disjunction as the union of index scans, one per arm,
+// or returns nil if some arm has no usable index.
+func (opt *QueryOptimizer) bitmapOr(tableName string, stats *TableStatistics, indexes []*IndexStatistics, expr Expression) *QueryPlan {
+	b, ok := expr.(*BinaryExpression)
+	if !ok || b.Operator != OpOr {
+		return nil
+	}
+	var children []*QueryPlan
+	for _, arm := range splitDisjuncts(b) {
+		armConjuncts := splitConjuncts(arm)
+		var best *QueryPlan
+		for _, index := range indexes {
+			keys, matched := indexScanKeys(index, armConjuncts)
+			if len(keys) == 0 {
+				continue
+			}
+			scan := opt.bitmapIndexScan(tableName, stats, index, keys, opt.estimateSelectivity(matched, stats))
+			if best == nil || scan.TotalCost < best.TotalCost {
+				best = scan
+			}
+		}
+		if best == nil {
+			return nil
+		}
+		children = append(children, best)
+	}
+	return opt.combineBitmaps(PlanTypeBitmapOr, stats, children)
+}
+
+func splitDisjuncts(expr Expression) []Expression {
+	if b, ok := expr.(*BinaryExpression); ok && b.Operator == OpOr {
+		return append(splitDisjuncts(b.Left), splitDisjuncts(b.Right)...)
+	}
+	return []Expression{expr}
+}
+
+// bitmapHeapScan fetches the rows of a bitmap in table order, after
+// sorting their row IDs. Rows close together share page reads, so once
+// more than one page is fetched the cost per page falls from a random read
+// toward a sequential one as the fraction of pages fetched grows.
+func (opt *QueryOptimizer) bitmapHeapScan(tableName string, stats *TableStatistics, quals []Expression, bitmap *QueryPlan) *QueryPlan {
+	pages := math.Max(stats.PageCount, 1)
+	selected := bitmap.PlanRows
+	fetched := math.Ceil(pages * (1 - math.Exp(-selected/pages)))
+	perPage := opt.config.RandomPageCost
+	if fetched >= 2 {
+		perPage -= (opt.config.RandomPageCost - opt.config.SeqPageCost) * math.Sqrt(fetched/pages)
+	}
+	startup := bitmap.TotalCost + opt.config.CPUOperatorCost*selected*math.Max(1, math.Log2(selected))
+	return &QueryPlan{
+		Type:        PlanTypeBitmapHeapScan,
+		TableName:   tableName,
+		LeftTree:    bitmap,
+		Qual:        quals,
+		PlanWidth:   int(stats.AvgRowWidth),
+		StartupCost: startup,
+		TotalCost: startup + perPage*fetched + opt.config.CPUTupleCost*selected +
+			opt.config.CPUOperatorCost*selected*float64(len(quals)),
+	}
+}
@@ -0,0 +1,878 @@
+package sql
+
+import (
+	"bytes"
+	"context"
+	"encoding/binary"
+	"encoding/json"
+	"fmt"
+	"slices"
+	"strings"
+	"time"
+)
+
+// Row IDs name a row within its storage engine: the full key of a KV row,
+// the document ID of a document, and the big-endian ordinal of a columnar
+// row. Their byte order is the order a scan of the table visits rows.
+
+func columnarRowID(ordinal int64) []byte {
+	return binary.BigEndian.AppendUint64(nil, uint64(ordinal))
+}
+
+// scanRowsWithIDs calls fn for every row of a table together with its row
+// ID.
+func (qe *QueryExecutor) scanRowsWithIDs(ctx *ExecutionContext, tableName string, columns []ColumnInfo, fn func(rowID []byte, row Row) error) error {
+	storageType := qe.getStorageType(tableName)
+	if storageType == StorageTypeDocument {
+		if qe.storageManager.docStore == nil {
+			return fmt.Errorf("document storage engine not configured")
+		}
+		iter, err := qe.storageManager.docStore.QueryDocuments(ctx.Context, tableName, DocumentQuery{})
+		if err != nil {
+			return fmt.Errorf("failed to create document iterator: %w", err)
+		}
+		defer iter.Close()
+		for n := 0; iter.Next(); n++ {
+			if n%1024 == 0 {
+				if err := checkCancelled(ctx); err != nil {
+					return err
+				}
+			}
+			doc, err := iter.Document()
+			if err != nil {
+				return fmt.Errorf("failed to read document: %w", err)
+			}
+			if err := fn([]byte(getDocumentID(doc)), qe.documentToRow(doc, columns)); err != nil {
+				return err
+			}
+		}
+		return iter.Error()
+	}
+
+	source, err := qe.openRowSource(ctx, tableName, columns)
+	if err != nil {
+		return err
+	}
+	defer source.close()
+	for ordinal := int64(0); ; ordinal++ {
+		if ordinal%1024 == 0 {
+			if err := checkCancelled(ctx); err != nil {
+				return err
+			}
+		}
+		row, _, ok, err := source.next()
+		if err != nil {
+			return err
+		}
+		if !ok {
+			return nil
+		}
+		rowID := columnarRowID(ordinal)
+		if storageType == StorageTypeKV {
+			rowID = []byte(row.Values[0].(string))
+		}
+		if err := fn(rowID, row); err != nil {
+			return err
+		}
+	}
+}
+
+// fetchRowsByID reads rows of a table by row ID. Rows whose ID no longer
+// exists in a KV table are skipped.
+func (qe *QueryExecutor) fetchRowsByID(ctx *ExecutionContext, tableName string, columns []ColumnInfo, rowIDs [][]byte) ([]Row, error) {
+	if len(rowIDs) == 0 {
+		return nil, nil
+	}
+	sm := qe.storageManager
+	switch qe.getStorageType(tableName) {
+	case StorageTypeKV:
+		if sm.kvStore == nil {
+			return nil, fmt.Errorf("KV storage engine not configured")
+		}
+		values, err := sm.kvStore.BatchGet(ctx.Context, rowIDs)
+		if err != nil {
+			return nil, fmt.Errorf("failed to fetch rows of %s: %w", tableName, err)
+		}
+		rows := make([]Row, 0, len(rowIDs))
+		for i, value := range values {
+			if value == nil {
+				continue
+			}
+			rows = append(rows, qe.kvToRow(rowIDs[i], value, columns))
+			ctx.Stats.BytesProcessed += int64(len(rowIDs[i]) + len(value))
+		}
+		return rows, nil
+	case StorageTypeDocument:
+		if sm.docStore == nil {
+			return nil, fmt.Errorf("document storage engine not configured")
+		}
+		rows := make([]Row, 0, len(rowIDs))
+		for _, id := range rowIDs {
+			doc, err := sm.docStore.GetDocument(ctx.Context, tableName, string(id))
+			if err != nil {
+				return nil, fmt.Errorf("failed to fetch document %s from %s: %w", id, tableName, err)
+			}
+			rows = append(rows, qe.documentToRow(doc, columns))
+		}
+		return rows, nil
+	case StorageTypeColumnar:
+		if sm.columnarStore == nil {
+			return nil, fmt.Errorf("columnar storage engine not configured")
+		}
+		ordinals := make([]int64, len(rowIDs))
+		for i, id := range rowIDs {
+			if len(id) != 8 {
+				return nil, fmt.Errorf("invalid columnar row ID %x", id)
+			}
+			ordinals[i] = int64(binary.BigEndian.Uint64(id))
+		}
+		rows := make([]Row, len(rowIDs))
+		for i := range rows {
+			rows[i].Values = make([]any, len(columns))
+		}
+		for j, col := range columns {
+			data, err := sm.columnarStore.GetColumn(ctx.Context, tableName, col.Name, ordinals)
+			if err != nil {
+				return nil, fmt.Errorf("failed to fetch column %s of %s: %w", col.Name, tableName, err)
+			}
+			for i := range rows {
+				if i < len(data.Values) && !(i < len(data.Nulls) && data.Nulls[i]) {
+					rows[i].Values[j] = data.Values[i]
+				}
+			}
+		}
+		return rows, nil
+	default:
+		return nil, fmt.Errorf("unknown storage type for table %s", tableName)
+	}
+}
+
+// fetchRowByID reads a single row of a table by row ID.
+func (qe *QueryExecutor) fetchRowByID(ctx *ExecutionContext, tableName string, rowID []byte) (Row, error) {
+	rows, err := qe.fetchRowsByID(ctx, tableName, qe.getTableColumns(tableName), [][]byte{rowID})
+	if err != nil {
+		return Row{}, err
+	}
+	if len(rows) == 0 {
+		return Row{}, fmt.Errorf("row %q not found in %s", rowID, tableName)
+	}
+	return rows[0], nil
+}
+
+// CreateIndex creates an index and builds it from the rows already in its
+// table. The returned statistics describe the built index to the
+// optimizer.
+func (qe *QueryExecutor) CreateIndex(ctx context.Context, def IndexDefinition) (*IndexStatistics, error) {
+	manager := qe.storageManager.indexManager
+	if manager == nil {
+		return nil, fmt.Errorf("index manager not configured")
+	}
+	columns := qe.getTableColumns(def.Table)
+	colIndex := columnIndexMap(columns)
+	positions := make([]int, len(def.Columns))
+	for i, col := range def.Columns {
+		pos, ok := colIndex[strings.ToLower(col)]
+		if !ok {
+			return nil, fmt.Errorf("column %s of index %s does not exist in %s", col, def.Name, def.Table)
+		}
+		positions[i] = pos
+	}
+
+	if err := manager.CreateIndex(ctx, def); err != nil {
+		return nil, err
+	}
+	index, err := manager.GetIndex(ctx, def.Name)
+	if err != nil {
+		return nil, err
+	}
+	execCtx := &ExecutionContext{Context: ctx, StartTime: time.Now(), Stats: &ExecutionStats{}}
+	values := make([]any, len(positions))
+	err = qe.scanRowsWithIDs(execCtx, def.Table, columns, func(rowID []byte, row Row) error {
+		for i, pos := range positions {
+			values[i] = row.Values[pos]
+		}
+		return index.Insert(ctx, encodeIndexEntry(values, rowID), rowID)
+	})
+	if err != nil {
+		manager.DropIndex(ctx, def.Name)
+		return nil, fmt.Errorf("failed to build index %s: %w", def.Name, err)
+	}
+	return qe.indexStatistics(def, index), nil
+}
+
+// DropIndex drops an index.
+func (qe *QueryExecutor) DropIndex(ctx context.Context, name string) error {
+	if qe.storageManager.indexManager == nil {
+		return fmt.Errorf("index manager not configured")
+	}
+	return qe.storageManager.indexManager.DropIndex(ctx, name)
+}
+
+// indexStatistics describes an index to the optimizer. An index covers its
+// table when every column a scan returns can be read from its entries: an
+// indexed column, or the id of a KV row, which is its row ID.
+func (qe *QueryExecutor) indexStatistics(def IndexDefinition, index Index) *IndexStatistics {
+	stats := index.Stats()
+	covering := true
+	for _, col := range qe.getTableColumns(def.Table) {
+		if indexColumnPosition(def, col.Name) < 0 &&
+			!(qe.getStorageType(def.Table) == StorageTypeKV && strings.EqualFold(col.Name, "id")) {
+			covering = false
+			break
+		}
+	}
+	indexStats := &IndexStatistics{
+		IndexName: def.Name,
+		TableName: def.Table,
+		Columns:   def.Columns,
+		IsUnique:  def.Unique,
+		Covering:  covering,
+		PageCount: float64(stats.Pages),
+		RowCount:  float64(stats.Tuples),
+	}
+	if def.Unique && stats.Tuples > 0 {
+		indexStats.Selectivity = 1 / float64(stats.Tuples)
+	}
+	return indexStats
+}
+
+func indexColumnPosition(def IndexDefinition, column string) int {
+	for i, col := range def.Columns {
+		if strings.EqualFold(col, column) {
+			return i
+		}
+	}
+	return -1
+}
+
+// indexDefinition looks up the definition of one of a table's indexes.
+func (qe *QueryExecutor) indexDefinition(ctx context.Context, tableName, indexName string) (IndexDefinition, error) {
+	defs, err := qe.storageManager.indexManager.ListIndexes(ctx, tableName)
+	if err != nil {
+		return IndexDefinition{}, err
+	}
+	for _, def := range defs {
+		if def.Name == indexName {
+			return def, nil
+		}
+	}
+	return IndexDefinition{}, fmt.Errorf("index %s does not exist on %s", indexName, tableName)
+}
+
+// openIndex returns the index a plan node scans.
+func (qe *QueryExecutor) openIndex(ctx context.Context, plan *QueryPlan) (Index, error) {
+	if qe.storageManager.indexManager == nil {
+		return nil, fmt.Errorf("index manager not configured")
+	}
+	index, err := qe.storageManager.indexManager.GetIndex(ctx, plan.IndexName)
+	if err != nil {
+		return nil, fmt.Errorf("failed to get index %s: %w", plan.IndexName, err)
+	}
+	return index, nil
+}
+
+// resolveScanKeys evaluates scan key values, which may name parameters or
+// the columns of an outer row, into literals an index can compare.
+func resolveScanKeys(keys []ScanKey, env *evalEnv) ([]ScanKey, error) {
+	resolved := make([]ScanKey, len(keys))
+	for i, key := range keys {
+		v, err := evaluateExpression(key.Value, env)
+		if err != nil {
+			return nil, err
+		}
+		resolved[i] = ScanKey{Column: key.Column, Operator: key.Operator, Value: &LiteralExpression{Value: v}}
+	}
+	return resolved, nil
+}
+
+// indexScanOperator reads a key range of an index. A plain index scan
+// fetches the rows its entries point at, a batch of row IDs at a time; an
+// index-only scan builds rows from the entries themselves. The scan
+// qualifiers are rechecked on every row because the key range may be
+// wider than they are.
+type indexScanOperator struct {
+	executor  *QueryExecutor
+	plan      *QueryPlan
+	columns   []ColumnInfo
+	colIndex  map[string]int
+	batchSize int
+	indexOnly bool
+
+	ctx  *ExecutionContext
+	iter Iterator
+	// For index-only scans, the index column each output column comes
+	// from, or -1 for the id of a KV row.
+	sources    []int
+	keyColumns int
+	done       bool
+}
+
+func (qe *QueryExecutor) newIndexScanOperator(plan *QueryPlan) *indexScanOperator {
+	columns := qe.getTableColumns(plan.TableName)
+	return &indexScanOperator{
+		executor:  qe,
+		plan:      plan,
+		columns:   columns,
+		colIndex:  columnIndexMap(columns),
+		batchSize: qe.config.BatchSize,
+		indexOnly: plan.Type == PlanTypeIndexOnlyScan,
+	}
+}
+
+func (s *indexScanOperator) Open(ctx *ExecutionContext) error {
+	s.ctx = ctx
+	index, err := s.executor.openIndex(ctx.Context, s.plan)
+	if err != nil {
+		return err
+	}
+	if s.indexOnly {
+		def, err := s.executor.indexDefinition(ctx.Context, s.plan.TableName, s.plan.IndexName)
+		if err != nil {
+			return err
+		}
+		s.keyColumns = len(def.Columns)
+		s.sources = make([]int, len(s.columns))
+		for i, col := range s.columns {
+			s.sources[i] = indexColumnPosition(def, col.Name)
+		}
+	}
+	keys, err := resolveScanKeys(s.plan.ScanKeys, &evalEnv{params: ctx.Parameters})
+	if err != nil {
+		return err
+	}
+	if s.iter, err = index.ScanRange(ctx.Context, keys); err != nil {
+		return fmt.Errorf("failed to create index iterator: %w", err)
+	}
+	ctx.Stats.IndexScans++
+	return nil
+}
+
+func (s *indexScanOperator) NextBatch() (*RowBatch, error) {
+	env := &evalEnv{columns: s.colIndex, params: s.ctx.Parameters}
+	for !s.done {
+		if err := checkCancelled(s.ctx); err != nil {
+			return nil, err
+		}
+		rows, err := s.readRows()
+		if err != nil {
+			return nil, err
+		}
+		batch := &RowBatch{Rows: rows[:0]}
+		for _, row := range rows {
+			env.row = row
+			match, err := evaluateQuals(s.plan.Qual, env)
+			if err != nil {
+				return nil, err
+			}
+			if match {
+				batch.Rows = append(batch.Rows, row)
+			}
+		}
+		if len(batch.Rows) > 0 {
+			s.ctx.Stats.RowsProcessed += int64(len(batch.Rows))
+			return batch, nil
+		}
+	}
+	return nil, nil
+}
+
+// readRows reads up to a batch of index entries and turns them into rows.
+func (s *indexScanOperator) readRows() ([]Row, error) {
+	var rowIDs [][]byte
+	var rows []Row
+	for len(rowIDs)+len(rows) < s.batchSize {
+		if !s.iter.Next() {
+			if err := s.iter.Error(); err != nil {
+				return nil, fmt.Errorf("iterator error: %w", err)
+			}
+			s.done = true
+			break
+		}
+		key, rowID, err := s.iter.Value()
+		if err != nil {
+			return nil, fmt.Errorf("failed to read index entry: %w", err)
+		}
+		if !s.indexOnly {
+			rowIDs = append(rowIDs, rowID)
+			continue
+		}
+		values, _, err := decodeIndexEntry(key, s.keyColumns)
+		if err != nil {
+			return nil, fmt.Errorf("failed to decode index entry: %w", err)
+		}
+		row := Row{Values: make([]any, len(s.columns))}
+		for i, src := range s.sources {
+			if src >= 0 {
+				row.Values[i] = values[src]
+			} else {
+				row.Values[i] = string(rowID)
+			}
+		}
+		rows = append(rows, row)
+		s.ctx.Stats.BytesProcessed += int64(len(key) + len(rowID))
+	}
+	if s.indexOnly {
+		return rows, nil
+	}
+	return s.executor.fetchRowsByID(s.ctx, s.plan.TableName, s.columns, rowIDs)
+}
+
+func (s *indexScanOperator) Close() error {
+	if s.iter == nil {
+		return nil
+	}
+	err := s.iter.Close()
+	s.iter = nil
+	return err
+}
+
+func (s *indexScanOperator) Columns() []ColumnInfo {
+	return s.columns
+}
+
+// bitmapHeapOperator fetches the rows named by a set of row IDs gathered
+// from one or more indexes. The IDs are sorted, so rows are read in table
+// order and each at most once however many index conditions matched it.
+// Row IDs are byte strings rather than bit positions because KV row IDs
+// are keys; a sorted slice serves both.
+type bitmapHeapOperator struct {
+	executor  *QueryExecutor
+	plan      *QueryPlan
+	columns   []ColumnInfo
+	colIndex  map[string]int
+	batchSize int
+
+	ctx    *ExecutionContext
+	rowIDs [][]byte
+}
+
+func (qe *QueryExecutor) newBitmapHeapOperator(plan *QueryPlan) *bitmapHeapOperator {
+	columns := qe.getTableColumns(plan.TableName)
+	return &bitmapHeapOperator{
+		executor:  qe,
+		plan:      plan,
+		columns:   columns,
+		colIndex:  columnIndexMap(columns),
+		batchSize: qe.config.BatchSize,
+	}
+}
+
+func (b *bitmapHeapOperator) Open(ctx *ExecutionContext) error {
+	b.ctx = ctx
+	rowIDs, err := b.executor.bitmapRowIDs(ctx, b.plan.LeftTree)
+	if err != nil {
+		return err
+	}
+	b.rowIDs = rowIDs
+	return nil
+}
+
+func (b *bitmapHeapOperator) NextBatch() (*RowBatch, error) {
+	env := &evalEnv{columns: b.colIndex, params: b.ctx.Parameters}
+	for len(b.rowIDs) > 0 {
+		if err := checkCancelled(b.ctx); err != nil {
+			return nil, err
+		}
+		n := min(b.batchSize, len(b.rowIDs), len(b.rowIDs))
+		rows, err := b.executor.fetchRowsByID(b.ctx, b.plan.TableName, b.columns, b.rowIDs[:n])
+		if err != nil {
+			return nil, err
+		}
+		b.rowIDs = b.rowIDs[n:]
+
+		batch := &RowBatch{Rows: rows[:0]}
+		for _, row := range rows {
+			env.row = row
+			match, err := evaluateQuals(b.plan.Qual, env)
+			if err != nil {
+				return nil, err
+			}
+			if match {
+				batch.Rows = append(batch.Rows, row)
+			}
+		}
+		if len(batch.Rows) > 0 {
+			b.ctx.Stats.RowsProcessed += int64(len(batch.Rows))
+			return batch, nil
+		}
+	}
+	return nil, nil
+}
+
+func (b *bitmapHeapOperator) Close() error {
+	b.rowIDs = nil
+	return nil
+}
+
+func (b *bitmapHeapOperator) Columns() []ColumnInfo {
+	return b.columns
+}
+
+// bitmapRowIDs evaluates a tree of bitmap index scans, ANDs and ORs into a
+// sorted set of row IDs.
+func (qe *QueryExecutor) bitmapRowIDs(ctx *ExecutionContext, plan *QueryPlan) ([][]byte, error) {
+	switch plan.Type {
+	case PlanTypeBitmapIndexScan:
+		index, err := qe.openIndex(ctx.Context, plan)
+		if err != nil {
+			return nil, err
+		}
+		keys, err := resolveScanKeys(plan.ScanKeys, &evalEnv{params: ctx.Parameters})
+		if err != nil {
+			return nil, err
+		}
+		iter, err := index.ScanRange(ctx.Context, keys)
+		if err != nil {
+			return nil, fmt.Errorf("failed to create index iterator: %w", err)
+		}
+		defer iter.Close()
+		ctx.Stats.IndexScans++
+
+		var rowIDs [][]byte
+		for iter.Next() {
+			_, rowID, err := iter.Value()
+			if err != nil {
+				return nil, fmt.Errorf("failed to read index entry: %w", err)
+			}
+			rowIDs = append(rowIDs, rowID)
+			if len(rowIDs)%1024 == 0 {
+				if err := checkCancelled(ctx); err != nil {
+					return nil, err
+				}
+			}
+		}
+		if err := iter.Error(); err != nil {
+			return nil, fmt.Errorf("iterator error: %w", err)
+		}
+		slices.SortFunc(rowIDs, bytes.Compare)
+		return slices.CompactFunc(rowIDs, bytes.Equal), nil
+	case PlanTypeBitmapAnd, PlanTypeBitmapOr:
+		var result [][]byte
+		for i, child := range plan.SubPlans {
+			rowIDs, err := qe.bitmapRowIDs(ctx, child)
+			if err != nil {
+				return nil, err
+			}
+			switch {
+			case i == 0:
+				result = rowIDs
+			case plan.Type == PlanTypeBitmapAnd:
+				result = intersectRowIDs(result, rowIDs)
+			default:
+				result = unionRowIDs(result, rowIDs)
+			}
+		}
+		return result, nil
+	default:
+		return nil, fmt.Errorf("unsupported bitmap plan type: %v", plan.Type)
+	}
+}
+
+func intersectRowIDs(a, b [][]byte) [][]byte {
+	out := a[:0]
+	for i, j := 0, 0; i < len(a) && j < len(b); {
+		switch c := bytes.Compare(a[i], b[j]); {
+		case c < 0:
+			i++
+		case c > 0:
+			j++
+		default:
+			out = append(out, a[i])
+			i++
+			j++
+		}
+	}
+	return out
+}
+
+func unionRowIDs(a, b [][]byte) [][]byte {
+	out := make([][]byte, 0, len(a)+len(b))
+	i, j := 0, 0
+	for i < len(a) && j < len(b) {
+		switch c := bytes.Compare(a[i], b[j]); {
+		case c < 0:
+			out = append(out, a[i])
+			i++
+		case c > 0:
+			out = append(out, b[j])
+			j++
+		default:
+			out = append(out, a[i])
+			i++
+			j++
+		}
+	}
+	out = append(out, a[i:]...)
+	return append(out, b[j:]...)
+}
+
+// indexNestLoopOperator joins each outer row to the inner rows an index
+// probe keyed on that row returns, so the inner table is never scanned.
+// The join clauses are checked on every joined row.
+type indexNestLoopOperator struct {
+	executor  *QueryExecutor
+	outer     Operator
+	outerPlan *QueryPlan
+	innerPlan *QueryPlan
+	index     Index
+	joinType  JoinType
+	clauses   []Expression
+	batchSize int
+
+	ctx          *ExecutionContext
+	innerColumns []ColumnInfo
+	columns      []ColumnInfo
+	tables       []string
+	outerEnv     *evalEnv
+	innerEnv     *evalEnv
+	joinEnv      *evalEnv
+	out          []Row
+	done         bool
+}
+
+// newIndexNestLoopOperator returns an index nested loop for plan, or nil
+// when its inner side is not an index probe on an index that exists.
+func (qe *QueryExecutor) newIndexNestLoopOperator(plan *QueryPlan, prof *planProfiler) (*indexNestLoopOperator, error) {
+	inner := plan.RightTree
+	if inner == nil || inner.Type != PlanTypeIndexScan || joinInputPlan(inner) == inner ||
+		qe.storageManager.indexManager == nil {
+		return nil, nil
+	}
+	index, err := qe.storageManager.indexManager.GetIndex(context.Background(), inner.IndexName)
+	if err != nil {
+		return nil, nil
+	}
+	outer, err := qe.buildProfiledOperator(joinInputPlan(plan.LeftTree), prof)
+	if err != nil {
+		return nil, err
+	}
+	return &indexNestLoopOperator{
+		executor:  qe,
+		outer:     outer,
+		outerPlan: plan.LeftTree,
+		innerPlan: inner,
+		index:     index,
+		joinType:  plan.JoinType,
+		clauses:   plan.JoinClauses,
+		batchSize: qe.config.BatchSize,
+	}, nil
+}
+
+func (j *indexNestLoopOperator) Open(ctx *ExecutionContext) error {
+	j.ctx = ctx
+	if err := j.outer.Open(ctx); err != nil {
+		return err
+	}
+	outerCols := j.outer.Columns()
+	outerTables := joinColumnTables(j.outerPlan, j.outer)
+	j.innerColumns = j.executor.getTableColumns(j.innerPlan.TableName)
+	innerName := j.innerPlan.Alias
+	if innerName == "" {
+		innerName = j.innerPlan.TableName
+	}
+	innerTables := make([]string, len(j.innerColumns))
+	for i := range innerTables {
+		innerTables[i] = innerName
+	}
+	j.columns = append(slices.Clip(outerCols), j.innerColumns...)
+	j.tables = append(slices.Clip(outerTables), innerTables...)
+
+	j.outerEnv = &evalEnv{columns: qualifiedColumnIndex(outerCols, outerTables), params: ctx.Parameters}
+	j.innerEnv = &evalEnv{columns: qualifiedColumnIndex(j.innerColumns, innerTables), params: ctx.Parameters}
+	j.joinEnv = &evalEnv{columns: qualifiedColumnIndex(j.columns, j.tables), params: ctx.Parameters}
+	ctx.Stats.JoinsExecuted++
+	ctx.Stats.IndexScans++
+	return nil
+}
+
+func (j *indexNestLoopOperator) NextBatch() (*RowBatch, error) {
+	for len(j.out) < j.batchSize && !j.done {
+		if err := checkCancelled(j.ctx); err != nil {
+			return nil, err
+		}
+		batch, err := j.outer.NextBatch()
+		if err != nil {
+			return nil, err
+		}
+		if batch == nil {
+			j.done = true
+			break
+		}
+		for _, row := range batch.Rows {
+			if err := j.probe(row); err != nil {
+				return nil, err
+			}
+		}
+	}
+	if len(j.out) == 0 {
+		return nil, nil
+	}
+
+	n := min(len(j.out), j.batchSize, j.batchSize)
+	out := &RowBatch{Rows: j.out[:n:n]}
+	j.out = j.out[n:]
+	if len(j.out) == 0 {
+		j.out = nil
+	}
+	j.ctx.Stats.RowsProcessed += int64(n)
+	return out, nil
+}
+
+// probe joins one outer row to the inner rows its index probe finds.
+func (j *indexNestLoopOperator) probe(outerRow Row) error {
+	j.outerEnv.row = outerRow
+	keys, err := resolveScanKeys(j.innerPlan.ScanKeys, j.outerEnv)
+	if err != nil {
+		return err
+	}
+	iter, err := j.index.ScanRange(j.ctx.Context, keys)
+	if err != nil {
+		return fmt.Errorf("failed to probe index %s: %w", j.innerPlan.IndexName, err)
+	}
+	var rowIDs [][]byte
+	for iter.Next() {
+		_, rowID, err := iter.Value()
+		if err != nil {
+			iter.Close()
+			return fmt.Errorf("failed to read index entry: %w", err)
+		}
+		rowIDs = append(rowIDs, rowID)
+	}
+	err = iter.Error()
+	iter.Close()
+	if err != nil {
+		return fmt.Errorf("iterator error: %w", err)
+	}
+	innerRows, err := j.executor.fetchRowsByID(j.ctx, j.innerPlan.TableName, j.innerColumns, rowIDs)
+	if err != nil {
+		return err
+	}
+
+	matched := false
+	for _, inner := range innerRows {
+		j.innerEnv.row = inner
+		ok, err := evaluateQuals(j.innerPlan.Qual, j.innerEnv)
+		if err != nil {
+			return err
+		}
+		if !ok {
+			continue
+		}
+		joined := Row{Values: append(slices.Clip(outerRow.Values), inner.Values...)}
+		j.joinEnv.row = joined
+		if ok, err = evaluateQuals(j.clauses, j.joinEnv); err != nil {
+			return err
+		}
+		if ok {
+			matched = true
+			j.out = append(j.out, joined)
+		}
+	}
+	if !matched && (j.joinType == LeftJoin || j.joinType == LeftOuterJoin) {
+		values := make([]any, len(j.columns))
+		copy(values, outerRow.Values)
+		j.out = append(j.out, Row{Values: values})
+	}
+	return nil
+}
+
+func (j *indexNestLoopOperator) Close() error {
+	j.out = nil
+	return j.outer.Close()
+}
+
+func (j *indexNestLoopOperator) Columns() []ColumnInfo { return j.columns }
+
+// indexCatalogKeyPrefix keeps persisted index definitions out of every
+// table's key range. Only definitions are persisted; the engine rebuilds
+// the indexes from their tables when it starts.
+const indexCatalogKeyPrefix = "__indexes__/"
+
+// executeCreateIndex handles CREATE [UNIQUE] INDEX.
+func (se *SQLEngine) executeCreateIndex(ctx context.Context, stmt *CreateIndexStatement, startTime time.Time) (*SQLResult, error) {
+	fail := func(err error) (*SQLResult, error) {
+		return &SQLResult{Error: err, ExecutionTime: time.Since(startTime)}, err
+	}
+	if stmt.Where != nil {
+		return fail(fmt.Errorf("partial indexes are not supported"))
+	}
+	tableName := stmt.Table.Name
+	if stmt.Table.Schema != "" {
+		tableName = stmt.Table.Schema + "." + stmt.Table.Name
+	}
+	def := IndexDefinition{Name: stmt.Name, Table: tableName, Type: IndexTypeBTree, Unique: stmt.Unique}
+	for _, col := range stmt.Columns {
+		if col.Name == "" {
+			return fail(fmt.Errorf("expression indexes are not supported"))
+		}
+		def.Columns = append(def.Columns, col.Name)
+	}
+	if stmt.IfNotExists && se.storageManager.indexManager != nil {
+		if _, err := se.storageManager.indexManager.GetIndex(ctx, def.Name); err == nil {
+			return &SQLResult{ExecutionTime: time.Since(startTime)}, nil
+		}
+	}
+
+	stats, err := se.executor.CreateIndex(ctx, def)
+	if err != nil {
+		return fail(err)
+	}
+	if kv := se.storageManager.kvStore; kv != nil {
+		data, err := json.Marshal(def)
+		if err == nil {
+			err = kv.Put(ctx, []byte(indexCatalogKeyPrefix+def.Name), data)
+		}
+		if err != nil {
+			se.executor.DropIndex(ctx, def.Name)
+			return fail(fmt.Errorf("failed to save index %s: %w", def.Name, err))
+		}
+	}
+	se.optimizer.stats.UpdateIndexStats(stats)
+	return &SQLResult{ExecutionTime: time.Since(startTime)}, nil
+}
+
+// executeDropIndex handles DROP INDEX.
+func (se *SQLEngine) executeDropIndex(ctx context.Context, stmt *DropIndexStatement, startTime time.Time) (*SQLResult, error) {
+	if err := se.executor.DropIndex(ctx, stmt.Name); err != nil {
+		if stmt.IfExists {
+			return &SQLResult{ExecutionTime: time.Since(startTime)}, nil
+		}
+		return &SQLResult{Error: err, ExecutionTime: time.Since(startTime)}, err
+	}
+	if kv := se.storageManager.kvStore; kv != nil {
+		if err := kv.Delete(ctx, []byte(indexCatalogKeyPrefix+stmt.Name)); err != nil {
+			err = fmt.Errorf("failed to remove index %s: %w", stmt.Name, err)
+			return &SQLResult{Error: err, ExecutionTime: time.Since(startTime)}, err
+		}
+	}
+	se.optimizer.stats.DropIndexStats(stmt.Name)
+	return &SQLResult{ExecutionTime: time.Since(startTime)}, nil
+}
+
+// loadIndexes rebuilds the persisted indexes. An index that fails to build
+// is left out, which only costs plan quality.
+func (se *SQLEngine) loadIndexes(ctx context.Context) {
+	kv := se.storageManager.kvStore
+	iter, err := kv.Scan(ctx, []byte(indexCatalogKeyPrefix), []byte(indexCatalogKeyPrefix+"~"))
+	if err != nil {
+		return
+	}
+	var defs []IndexDefinition
+	for iter.Next() {
+		_, data, err := iter.Value()
+		if err != nil {
+			break
+		}
+		var def IndexDefinition
+		if json.Unmarshal(data, &def) == nil {
+			defs = append(defs, def)
+		}
+	}
+	iter.Close()
+
+	for _, def := range defs {
+		if stats, err := se.executor.CreateIndex(ctx, def); err == nil {
+			se.optimizer.stats.UpdateIndexStats(stats)
+		}
+	}
+}
@@ -0,0 +1,277 @@
+package sql
+
+import (
+	"bytes"
+	"context"
+	"fmt"
+	"math/rand"
+	"slices"
+	"sort"
+	"testing"
+
+	"mantisDB/transaction"
+)
+
+func TestBTreeMatchesSortedSet(t *testing.T) {
+	rng := rand.New(rand.NewSource(1))
+	var tree btree
+	want := make(map[string]string)
+	for i := 0; i < 50000; i++ {
+		key := fmt.Sprintf("k%05d", rng.Intn(20000))
+		if rng.Intn(3) == 0 {
+			_, existed := want[key]
+			if tree.delete([]byte(key)) != existed {
+				t.Fatalf("delete(%s) disagrees with the reference set", key)
+			}
+			delete(want, key)
+		} else {
+			want[key] = fmt.Sprint(i)
+			tree.insert(btreeItem{key: []byte(key), value: []byte(fmt.Sprint(i))})
+		}
+	}
+
+	if tree.size != len(want) {
+		t.Fatalf("tree holds %d items, want %d", tree.size, len(want))
+	}
+	keys := make([]string, 0, len(want))
+	for k := range want {
+		keys = append(keys, k)
+	}
+	sort.Strings(keys)
+	var got []string
+	tree.ascend(nil, func(item btreeItem) bool {
+		if want[string(item.key)] != string(item.value) {
+			t.Fatalf("%s = %s, want %s", item.key, item.value, want[string(item.key)])
+		}
+		got = append(got, string(item.key))
+		return true
+	})
+	if !slices.Equal(got, keys) {
+		t.Fatalf("ascend returned %d keys out of order or incomplete, want %d", len(got), len(keys))
+	}
+	checkBTreeNode(t, tree.root, true)
+
+	from := keys[len(keys)/2]
+	tree.ascend([]byte(from), func(item btreeItem) bool {
+		if string(item.key) != from {
+			t.Fatalf("ascend from %s started at %s", from, item.key)
+		}
+		return false
+	})
+}
+
+// checkBTreeNode verifies node fill and key order beneath n.
+func checkBTreeNode(t *testing.T, n *btreeNode, root bool) {
+	t.Helper()
+	if n == nil {
+		return
+	}
+	if len(n.items) > 2*btreeDegree-1 || (!root && len(n.items) < btreeDegree-1) {
+		t.Fatalf("node holds %d items", len(n.items))
+	}
+	if !slices.IsSortedFunc(n.items, func(a, b btreeItem) int { return bytes.Compare(a.key, b.key) }) {
+		t.Fatal("node items out of order")
+	}
+	if n.children != nil {
+		if len(n.children) != len(n.items)+1 {
+			t.Fatalf("node has %d items and %d children", len(n.items), len(n.children))
+		}
+		for i, child := range n.children {
+			if i > 0 && bytes.Compare(child.min().key, n.items[i-1].key) <= 0 {
+				t.Fatal("child key below its separator")
+			}
+			checkBTreeNode(t, child, false)
+		}
+	}
+}
+
+func TestIndexKeyEncodingOrder(t *testing.T) {
+	values := []any{
+		int64(-1 << 62), -2.5, int64(-1), 0, 0.5, 1.0, int64(2), int64(1<<60 + 1), int64(1<<60 + 2),
+		"", "a", "a\x00", "a\x00b", "ab", "b",
+		false, true,
+	}
+	for i, a := range values {
+		ka := appendIndexValue(nil, a)
+		decoded, rest, err := decodeIndexValue(ka)
+		if err != nil || len(rest) != 0 {
+			t.Fatalf("decode %v: %v, %d bytes left", a, err, len(rest))
+		}
+		if cmp, _ := compareValues(decoded, a); cmp != 0 {
+			t.Errorf("%v decoded as %v", a, decoded)
+		}
+		for _, b := range values[i+1:] {
+			kb := appendIndexValue(nil, b)
+			if cmp, ok := compareValues(a, b); ok && bytes.Compare(ka, kb) != cmp {
+				t.Errorf("encodings of %v and %v compare %d, values compare %d", a, b, bytes.Compare(ka, kb), cmp)
+			}
+		}
+	}
+	if !bytes.Equal(appendIndexValue(nil, 1.0), appendIndexValue(nil, 1)) {
+		t.Error("1.0 and 1 encode differently")
+	}
+}
+
+// newIndexTestEngine fills kv_accounts with 20000 rows whose data cycles
+// through 5000 values and doc_orders with 2000 rows, and analyzes both.
+func newIndexTestEngine(t *testing.T) (*SQLEngine, *memKVStore, *memDocStore) {
+	t.Helper()
+	kv := newMemKVStore()
+	for i := 0; i < 20000; i++ {
+		kv.Put(context.Background(), []byte(fmt.Sprintf("kv_accounts/%05d", i)), []byte(fmt.Sprintf("v-%04d", i%5000)))
+	}
+	docs := newMemDocStore()
+	for i := 0; i < 2000; i++ {
+		docs.PutDocument(context.Background(), "doc_orders", "", Document{"id": int64(i), "data": fmt.Sprintf("x-%d", i%50)})
+	}
+	engine := NewSQLEngine(&StorageManager{kvStore: kv, docStore: docs}, transaction.NewTransactionSystem(nil), nil)
+	for _, stmt := range []string{
+		"CREATE INDEX accounts_data ON kv_accounts (data)",
+		"CREATE UNIQUE INDEX orders_id ON doc_orders (id)",
+		"CREATE INDEX orders_data ON doc_orders (data)",
+		"ANALYZE kv_accounts",
+		"ANALYZE doc_orders",
+	} {
+		execSQL(t, engine, stmt)
+	}
+	return engine, kv, docs
+}
+
+func execSQL(t *testing.T, engine *SQLEngine, query string) {
+	t.Helper()
+	conn, err := engine.CreateConnection("test", "test")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer engine.CloseConnection(conn.ID)
+	if _, err := engine.ExecuteSQL(context.Background(), conn.ID, query); err != nil {
+		t.Fatalf("%s: %v", query, err)
+	}
+}
+
+func planFor(t *testing.T, engine *SQLEngine, query string) *QueryPlan {
+	t.Helper()
+	stmt, err := ParseSQL(query)
+	if err != nil {
+		t.Fatal(err)
+	}
+	plan, err := engine.optimizer.OptimizeQuery(stmt)
+	if err != nil {
+		t.Fatal(err)
+	}
+	return plan
+}
+
+func TestIndexAccessPaths(t *testing.T) {
+	engine, kv, _ := newIndexTestEngine(t)
+	ctx := context.Background()
+
+	checks := []struct {
+		query string
+		plan  PlanType
+		rows  int
+	}{
+		{"SELECT * FROM kv_accounts WHERE data = 'v-0042'", PlanTypeIndexOnlyScan, 4},
+		{"SELECT * FROM doc_orders WHERE id = 7", PlanTypeIndexScan, 1},
+		{"SELECT * FROM doc_orders WHERE id BETWEEN 100 AND 119", PlanTypeIndexScan, 20},
+		{"SELECT * FROM doc_orders WHERE id = 7 OR id = 1500", PlanTypeBitmapHeapScan, 2},
+		{"SELECT * FROM doc_orders WHERE data = 'x-3' AND id < 500", PlanTypeBitmapHeapScan, 10},
+		{"SELECT * FROM doc_orders WHERE data = 'x-3' OR id = 1", PlanTypeBitmapHeapScan, 41},
+	}
+	for _, c := range checks {
+		plan := planFor(t, engine, c.query)
+		if plan.Type != c.plan {
+			t.Errorf("%s: planned %v, want %v", c.query, plan.Type, c.plan)
+		}
+		kv.reads.Store(0)
+		result, err := engine.executor.Execute(ctx, plan, nil)
+		if err != nil {
+			t.Fatalf("%s: %v", c.query, err)
+		}
+		if len(result.Rows) != c.rows {
+			t.Errorf("%s: %d rows, want %d", c.query, len(result.Rows), c.rows)
+		}
+		if reads := kv.reads.Load(); reads != 0 {
+			t.Errorf("%s: scanned %d KV entries", c.query, reads)
+		}
+	}
+
+	// Every index path returns what a sequential scan does.
+	for _, where := range []string{"id >= 1990", "id > 5 AND id <= 9 AND data = 'x-7'", "id < 3 OR data = 'x-49'", "data = 'x-1' AND id = 51"} {
+		stmt, _ := ParseSQL("SELECT * FROM doc_orders WHERE " + where)
+		quals := []Expression{stmt.(*SelectStatement).Where}
+		stats := engine.optimizer.tableStatistics("doc_orders")
+		want := sortedRows(runPlan(t, engine, &QueryPlan{Type: PlanTypeSeqScan, TableName: "doc_orders", Qual: quals}))
+		paths := engine.optimizer.indexPaths("doc_orders", stats, quals)
+		if len(paths) == 0 {
+			t.Fatalf("%s: no index paths", where)
+		}
+		for _, path := range paths {
+			if got := sortedRows(runPlan(t, engine, path)); fmt.Sprint(got) != fmt.Sprint(want) {
+				t.Errorf("%s via %v returned %v, want %v", where, path.Type, got, want)
+			}
+		}
+	}
+
+	execSQL(t, engine, "DROP INDEX orders_id")
+	if plan := planFor(t, engine, "SELECT * FROM doc_orders WHERE id = 7"); plan.Type != PlanTypeSeqScan {
+		t.Errorf("dropped index still planned: %v", plan.Type)
+	}
+}
+
+func runPlan(t *testing.T, engine *SQLEngine, plan *QueryPlan) []Row {
+	t.Helper()
+	result, err := engine.executor.Execute(context.Background(), plan, nil)
+	if err != nil {
+		t.Fatal(err)
+	}
+	return result.Rows
+}
+
+func TestIndexNestLoopProbesIndex(t *testing.T) {
+	engine, kv, docs := newIndexTestEngine(t)
+	for i := 0; i < 5; i++ {
+		docs.PutDocument(context.Background(), "doc_picks", "", Document{"id": int64(i), "data": fmt.Sprintf("v-%04d", i*7)})
+	}
+	execSQL(t, engine, "ANALYZE doc_picks")
+
+	plan := planFor(t, engine, "SELECT * FROM doc_picks p, kv_accounts a WHERE a.data = p.data")
+	if plan.Type != PlanTypeNestLoop || plan.RightTree.Type != PlanTypeIndexScan {
+		t.Fatalf("expected an index nested loop, got %v", plan.Type)
+	}
+	kv.reads.Store(0)
+	rows := runPlan(t, engine, plan)
+	if len(rows) != 5*4 {
+		t.Errorf("joined %d rows, want 20", len(rows))
+	}
+	for _, row := range rows {
+		if row.Values[1] != row.Values[3] {
+			t.Fatalf("joined mismatched rows: %v", row.Values)
+		}
+	}
+	if reads := kv.reads.Load(); reads != 0 {
+		t.Errorf("index nested loop scanned %d KV entries", reads)
+	}
+}
+
+func TestIndexDefinitionsSurviveRestart(t *testing.T) {
+	_, kv, docs := newIndexTestEngine(t)
+
+	restarted := NewSQLEngine(&StorageManager{kvStore: kv, docStore: docs}, transaction.NewTransactionSystem(nil), nil)
+	defs, err := restarted.storageManager.indexManager.ListIndexes(context.Background(), "doc_orders")
+	if err != nil || len(defs) != 2 {
+		t.Fatalf("restored indexes %v, %v", defs, err)
+	}
+	if plan := planFor(t, restarted, "SELECT * FROM doc_orders WHERE id = 7"); plan.Type != PlanTypeIndexScan {
+		t.Errorf("restored index not planned: %v", plan.Type)
+	}
+
+	conn, _ := restarted.CreateConnection("test", "test")
+	defer restarted.CloseConnection(conn.ID)
+	if _, err := restarted.ExecuteSQL(context.Background(), conn.ID, "CREATE UNIQUE INDEX orders_data_unique ON doc_orders (data)"); err == nil {
+		t.Error("unique index built over duplicate values")
+	}
+	if _, err := restarted.storageManager.indexManager.GetIndex(context.Background(), "orders_data_unique"); err == nil {
+		t.Error("failed unique index left behind")
+	}
+}
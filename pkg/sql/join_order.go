@@ -0,0 +1,755 @@
+package sql
+
+import (
+	"fmt"
+	"math"
+	"math/bits"
+	"sort"
+	"strings"
+)
+
+// maxJoinRelations bounds the relations of one join tree, which are
+// tracked as bits of a uint64.
+const maxJoinRelations = 64
+
+// joinRelation is one table or subquery of a FROM clause.
+type joinRelation struct {
+	ref *TableReference
+	// name is the qualifier columns of the relation are written with: its
+	// alias, or its table name when it has none.
+	name string
+}
+
+// joinPredicate is a WHERE or ON conjunct awaiting placement in the join
+// tree. It is applied at the lowest node whose relations cover required.
+type joinPredicate struct {
+	expr Expression
+	// rels are the relations expr reads. required adds the relations of
+	// every outer join that can null one of them, so the predicate is not
+	// evaluated beneath that join.
+	rels     uint64
+	required uint64
+	// equi marks `a = b` with each operand reading a different relation,
+	// which hash, merge and index nested loop joins can key on.
+	equi bool
+}
+
+// joinUnit is an input to join enumeration: a relation's scan, or a subtree
+// that has already been planned, such as an outer join.
+type joinUnit struct {
+	plan *QueryPlan
+	rels uint64
+}
+
+// joinPlanner chooses the join order and join methods of one FROM clause.
+// Relations joined with INNER or CROSS joins or listed with commas are
+// reordered freely; an outer join is planned where it is written, with
+// everything before it as its left input.
+type joinPlanner struct {
+	opt       *QueryOptimizer
+	relations []joinRelation
+	byName    map[string]int
+	preds     []*joinPredicate
+	// topQuals read columns that cannot be credited to a relation and are
+	// applied above the finished join tree.
+	topQuals []Expression
+}
+
+// buildJoinTree plans the FROM items and joins of a SELECT together with
+// its WHERE clause. Each conjunct is pushed to the lowest point of the tree
+// that has the columns it reads.
+func (opt *QueryOptimizer) buildJoinTree(from []TableReference, joins []*JoinClause, where Expression) (*QueryPlan, error) {
+	pl := &joinPlanner{opt: opt, byName: make(map[string]int)}
+	for i := range from {
+		pl.addRelation(&from[i])
+	}
+	for _, join := range joins {
+		if join.Type == NaturalJoin {
+			return nil, fmt.Errorf("NATURAL JOIN is not supported")
+		}
+		pl.addRelation(join.Table)
+	}
+	if len(pl.relations) > maxJoinRelations {
+		return nil, fmt.Errorf("too many relations in join: %d, limit is %d", len(pl.relations), maxJoinRelations)
+	}
+
+	// Outer joins, in the order written, with the relations they can null.
+	type outerJoin struct {
+		rel      int
+		join     *JoinClause
+		nullable uint64
+	}
+	var outers []outerJoin
+	for k, join := range joins {
+		rel := len(from) + k
+		before := uint64(1)<<rel - 1
+		switch join.Type {
+		case LeftJoin, LeftOuterJoin:
+			outers = append(outers, outerJoin{rel, join, 1 << rel})
+		case RightJoin, RightOuterJoin:
+			outers = append(outers, outerJoin{rel, join, before})
+		case FullJoin, FullOuterJoin:
+			outers = append(outers, outerJoin{rel, join, before | 1<<rel})
+		}
+	}
+
+	// A predicate written at position pos may not move beneath an outer
+	// join at or before pos that nulls a relation it reads.
+	addPredicates := func(expr Expression, pos int) {
+		for _, conjunct := range splitConjuncts(expr) {
+			p, ok := pl.newPredicate(conjunct)
+			if !ok {
+				pl.topQuals = append(pl.topQuals, conjunct)
+				continue
+			}
+			for _, oj := range outers {
+				if oj.rel <= pos && p.rels&oj.nullable != 0 {
+					p.required |= uint64(1)<<(oj.rel+1) - 1
+				}
+			}
+			pl.preds = append(pl.preds, p)
+		}
+	}
+	if where != nil {
+		addPredicates(where, len(pl.relations))
+	}
+	onClauses := make(map[int][]Expression)
+	for k, join := range joins {
+		rel := len(from) + k
+		cond := pl.joinCondition(rel, join)
+		switch join.Type {
+		case InnerJoin, CrossJoin:
+			if cond != nil {
+				addPredicates(cond, rel-1)
+			}
+		default:
+			if cond != nil {
+				onClauses[rel] = splitConjuncts(cond)
+			}
+		}
+	}
+
+	// Plan each run of inner joins, closing it at every outer join.
+	var group []*joinUnit
+	next := 0
+	for _, oj := range outers {
+		for ; next < oj.rel; next++ {
+			unit, err := pl.leaf(next, nil)
+			if err != nil {
+				return nil, err
+			}
+			group = append(group, unit)
+		}
+		left, err := pl.enumerate(group)
+		if err != nil {
+			return nil, err
+		}
+		unit, err := pl.outerJoin(left, oj.rel, oj.join.Type, onClauses[oj.rel])
+		if err != nil {
+			return nil, err
+		}
+		group = []*joinUnit{unit}
+		next = oj.rel + 1
+	}
+	for ; next < len(pl.relations); next++ {
+		unit, err := pl.leaf(next, nil)
+		if err != nil {
+			return nil, err
+		}
+		group = append(group, unit)
+	}
+	root, err := pl.enumerate(group)
+	if err != nil {
+		return nil, err
+	}
+
+	plan := root.plan
+	if len(pl.topQuals) > 0 {
+		plan.Qual = append(plan.Qual, pl.topQuals...)
+		plan.PlanRows *= opt.estimateSelectivity(pl.topQuals, nil)
+		plan.TotalCost += opt.config.CPUOperatorCost * plan.PlanRows * float64(len(pl.topQuals))
+	}
+	return plan, nil
+}
+
+func (pl *joinPlanner) addRelation(ref *TableReference) {
+	name := ref.Alias
+	if name == "" {
+		name = ref.Name
+	}
+	idx := len(pl.relations)
+	pl.relations = append(pl.relations, joinRelation{ref: ref, name: name})
+	pl.byName[strings.ToLower(name)] = idx
+	if ref.Alias == "" && ref.Schema != "" {
+		pl.byName[strings.ToLower(ref.Schema+"."+ref.Name)] = idx
+	}
+}
+
+// joinCondition returns the ON condition of a join, with USING columns
+// turned into equalities against the relation written just before it.
+func (pl *joinPlanner) joinCondition(rel int, join *JoinClause) Expression {
+	cond := join.Condition
+	if rel == 0 {
+		return cond
+	}
+	left, right := pl.relations[rel-1].name, pl.relations[rel].name
+	for _, col := range join.Using {
+		eq := &BinaryExpression{
+			Left:     &IdentifierExpression{Table: left, Name: col},
+			Operator: OpEqual,
+			Right:    &IdentifierExpression{Table: right, Name: col},
+		}
+		if cond == nil {
+			cond = eq
+		} else {
+			cond = &BinaryExpression{Left: cond, Operator: OpAnd, Right: eq}
+		}
+	}
+	return cond
+}
+
+// newPredicate attributes a conjunct to the relations it reads. ok is false
+// when that is not possible: an unqualified column among several relations,
+// an unknown qualifier, or a subquery.
+func (pl *joinPlanner) newPredicate(expr Expression) (*joinPredicate, bool) {
+	rels, ok := pl.relationsOf(expr)
+	if !ok || rels == 0 {
+		return nil, false
+	}
+	p := &joinPredicate{expr: expr, rels: rels, required: rels}
+	if b, isBinary := expr.(*BinaryExpression); isBinary && b.Operator == OpEqual {
+		l, lok := pl.relationsOf(b.Left)
+		r, rok := pl.relationsOf(b.Right)
+		p.equi = lok && rok && bits.OnesCount64(l) == 1 && bits.OnesCount64(r) == 1 && l != r
+	}
+	return p, true
+}
+
+func (pl *joinPlanner) relationsOf(expr Expression) (uint64, bool) {
+	switch e := expr.(type) {
+	case nil, *ParameterExpression:
+		return 0, true
+	case *LiteralExpression:
+		if list, ok := e.Value.([]Expression); ok {
+			var rels uint64
+			for _, elem := range list {
+				r, ok := pl.relationsOf(elem)
+				if !ok {
+					return 0, false
+				}
+				rels |= r
+			}
+			return rels, true
+		}
+		return 0, true
+	case *IdentifierExpression:
+		if e.Table == "" {
+			if len(pl.relations) == 1 {
+				return 1, true
+			}
+			return 0, false
+		}
+		name := e.Table
+		if e.Schema != "" {
+			name = e.Schema + "." + e.Table
+		}
+		idx, ok := pl.byName[strings.ToLower(name)]
+		if !ok {
+			return 0, false
+		}
+		return 1 << idx, true
+	case *BinaryExpression:
+		l, lok := pl.relationsOf(e.Left)
+		r, rok := pl.relationsOf(e.Right)
+		return l | r, lok && rok
+	case *UnaryExpression:
+		return pl.relationsOf(e.Operand)
+	case *FunctionCall:
+		var rels uint64
+		for _, arg := range e.Arguments {
+			r, ok := pl.relationsOf(arg)
+			if !ok {
+				return 0, false
+			}
+			rels |= r
+		}
+		return rels, true
+	case *CaseExpression:
+		rels, ok := pl.relationsOf(e.Expression)
+		r, rok := pl.relationsOf(e.ElseClause)
+		rels, ok = rels|r, ok && rok
+		for _, when := range e.WhenClauses {
+			c, cok := pl.relationsOf(when.Condition)
+			v, vok := pl.relationsOf(when.Result)
+			rels, ok = rels|c|v, ok && cok && vok
+		}
+		return rels, ok
+	}
+	return 0, false
+}
+
+// leaf plans the scan of one relation with every predicate that reads only
+// that relation pushed into it, plus extra quals from an outer join's ON
+// clause.
+func (pl *joinPlanner) leaf(idx int, extra []Expression) (*joinUnit, error) {
+	rel := pl.relations[idx]
+	mask := uint64(1) << idx
+	quals := pl.covered(mask, 0)
+	quals = append(quals, extra...)
+
+	var plan *QueryPlan
+	if rel.ref.Subquery != nil {
+		sub, err := pl.opt.buildTablePlan(rel.ref)
+		if err != nil {
+			return nil, err
+		}
+		plan = sub
+		if len(quals) > 0 {
+			plan.Qual = quals
+			plan.PlanRows *= pl.opt.estimateSelectivity(quals, nil)
+		}
+	} else {
+		tableName := rel.ref.Name
+		if rel.ref.Schema != "" {
+			tableName = rel.ref.Schema + "." + rel.ref.Name
+		}
+		scan, err := pl.opt.chooseScanPlan(tableName, pl.opt.tableStatistics(tableName), quals)
+		if err != nil {
+			return nil, err
+		}
+		plan = scan
+	}
+	plan.Alias = rel.ref.Alias
+	return &joinUnit{plan: plan, rels: mask}, nil
+}
+
+// covered returns the predicates whose required relations fall within rels
+// but not within any of the inputs already joined to make it.
+func (pl *joinPlanner) covered(rels uint64, inputs ...uint64) []Expression {
+	var quals []Expression
+	for _, p := range pl.preds {
+		if p.required&^rels != 0 {
+			continue
+		}
+		placed := false
+		for _, in := range inputs {
+			if in != 0 && p.required&^in == 0 {
+				placed = true
+				break
+			}
+		}
+		if !placed {
+			quals = append(quals, p.expr)
+		}
+	}
+	return quals
+}
+
+// outerJoin joins left to relation rel with the join type and ON conjuncts
+// of an outer join. ON conjuncts that only restrict the nullable side of a
+// LEFT join are pushed into its scan; WHERE predicates that had to wait for
+// this join are applied to its output.
+func (pl *joinPlanner) outerJoin(left *joinUnit, rel int, joinType JoinType, on []Expression) (*joinUnit, error) {
+	mask := uint64(1) << rel
+	var pushed, clauses []Expression
+	for _, conjunct := range on {
+		rels, ok := pl.relationsOf(conjunct)
+		if ok && rels == mask && (joinType == LeftJoin || joinType == LeftOuterJoin) {
+			pushed = append(pushed, conjunct)
+		} else {
+			clauses = append(clauses, conjunct)
+		}
+	}
+	// The nullable side of a RIGHT or FULL join must not be filtered by
+	// WHERE predicates before the join; addPredicates already holds them.
+	right, err := pl.leaf(rel, pushed)
+	if err != nil {
+		return nil, err
+	}
+
+	rows := pl.joinRows(left.plan, right.plan, pl.joinSelectivity(clauses))
+	switch joinType {
+	case LeftJoin, LeftOuterJoin:
+		rows = math.Max(rows, left.plan.PlanRows)
+	case RightJoin, RightOuterJoin:
+		rows = math.Max(rows, right.plan.PlanRows)
+	case FullJoin, FullOuterJoin:
+		rows = math.Max(rows, left.plan.PlanRows+right.plan.PlanRows)
+	}
+
+	hasEqui := false
+	for _, c := range clauses {
+		if p, ok := pl.newPredicate(c); ok && p.equi && pl.splitsAcross(p, left.rels, mask) {
+			hasEqui = true
+		}
+	}
+	// The executor preserves rows of an outer join with its hash join
+	// operator whichever method is chosen, so only the inputs' order is
+	// fixed here.
+	candidates := []*QueryPlan{pl.opt.createNestedLoopJoin(left.plan, right.plan, clauses)}
+	if hasEqui && pl.opt.config.EnableHashJoin {
+		candidates = append(candidates, pl.opt.createHashJoin(left.plan, right.plan, clauses))
+	}
+	if hasEqui && pl.opt.config.EnableMergeJoin {
+		candidates = append(candidates, pl.opt.createMergeJoin(left.plan, right.plan, clauses))
+	}
+	for _, c := range candidates {
+		c.JoinType = joinType
+		c.PlanRows = rows
+	}
+	plan := pl.opt.chooseCheapestPlan(candidates)
+
+	unit := &joinUnit{plan: plan, rels: left.rels | mask}
+	if quals := pl.covered(unit.rels, left.rels, mask); len(quals) > 0 {
+		plan.Qual = append(plan.Qual, quals...)
+		plan.PlanRows *= pl.opt.estimateSelectivity(quals, nil)
+	}
+	return unit, nil
+}
+
+// enumerate joins units into one plan: exhaustively with DPccp up to
+// GeqoThreshold units, greedily beyond that.
+func (pl *joinPlanner) enumerate(units []*joinUnit) (*joinUnit, error) {
+	switch {
+	case len(units) == 0:
+		return nil, fmt.Errorf("failed to generate join plan: no relations")
+	case len(units) == 1:
+		return units[0], nil
+	case len(units) <= pl.opt.config.GeqoThreshold:
+		return pl.enumerateDP(units), nil
+	default:
+		return pl.enumerateGreedy(units), nil
+	}
+}
+
+// neighbors returns, for each unit, the units it shares a predicate with.
+func (pl *joinPlanner) neighbors(units []*joinUnit) []uint64 {
+	adj := make([]uint64, len(units))
+	for _, p := range pl.preds {
+		var touched uint64
+		for i, u := range units {
+			if p.required&u.rels != 0 {
+				touched |= 1 << i
+			}
+		}
+		if bits.OnesCount64(touched) < 2 {
+			continue
+		}
+		for i := range units {
+			if touched&(1<<i) != 0 {
+				adj[i] |= touched &^ (1 << i)
+			}
+		}
+	}
+	return adj
+}
+
+// enumerateDP is DPccp (Moerkotte and Neumann, "Analysis of Two Existing
+// and One New Dynamic Programming Algorithm for the Generation of Optimal
+// Bushy Join Trees without Cross Products"). It visits each pair of
+// connected, disjoint unit sets whose union is connected exactly once, so
+// chains and stars cost far less than trying every split of every subset.
+// A join graph with several components is finished with cross products,
+// smallest component first.
+func (pl *joinPlanner) enumerateDP(units []*joinUnit) *joinUnit {
+	n := len(units)
+	adj := pl.neighbors(units)
+	best := make(map[uint64]*joinUnit)
+	for i, u := range units {
+		best[1<<i] = u
+	}
+
+	neighborhood := func(s, exclude uint64) uint64 {
+		var nb uint64
+		for rest := s; rest != 0; rest &= rest - 1 {
+			nb |= adj[bits.TrailingZeros64(rest)]
+		}
+		return nb &^ exclude
+	}
+	// below(i) is {0, ..., i}: units DPccp must not extend a set rooted at
+	// i with, since those sets are enumerated from a smaller root.
+	below := func(i int) uint64 { return uint64(1)<<(i+1) - 1 }
+
+	emitPair := func(s1, s2 uint64) {
+		l, r := best[s1], best[s2]
+		if l == nil || r == nil {
+			return
+		}
+		if joined := pl.join(l, r); joined != nil {
+			if cur := best[s1|s2]; cur == nil || joined.plan.TotalCost < cur.plan.TotalCost {
+				best[s1|s2] = joined
+			}
+		}
+	}
+
+	var enumerateCmpRec func(s1, s2, x uint64)
+	enumerateCmpRec = func(s1, s2, x uint64) {
+		nb := neighborhood(s2, x)
+		if nb == 0 {
+			return
+		}
+		for s := nb & -nb; s != 0; s = (s - nb) & nb {
+			if best[s2|s] != nil {
+				emitPair(s1, s2|s)
+			}
+		}
+		for s := nb & -nb; s != 0; s = (s - nb) & nb {
+			enumerateCmpRec(s1, s2|s, x|nb)
+		}
+	}
+	emitCsg := func(s1 uint64) {
+		x := s1 | below(bits.TrailingZeros64(s1))
+		nb := neighborhood(s1, x)
+		for i := n - 1; i >= 0; i-- {
+			if nb&(1<<i) == 0 {
+				continue
+			}
+			s2 := uint64(1) << i
+			emitPair(s1, s2)
+			enumerateCmpRec(s1, s2, x|(below(i)&nb))
+		}
+	}
+	var enumerateCsgRec func(s1, x uint64)
+	enumerateCsgRec = func(s1, x uint64) {
+		nb := neighborhood(s1, x)
+		if nb == 0 {
+			return
+		}
+		for s := nb & -nb; s != 0; s = (s - nb) & nb {
+			emitCsg(s1 | s)
+		}
+		for s := nb & -nb; s != 0; s = (s - nb) & nb {
+			enumerateCsgRec(s1|s, x|nb)
+		}
+	}
+	for i := n - 1; i >= 0; i-- {
+		s := uint64(1) << i
+		emitCsg(s)
+		enumerateCsgRec(s, below(i))
+	}
+
+	all := uint64(1)<<n - 1
+	if u := best[all]; u != nil {
+		return u
+	}
+
+	// Disconnected join graph: plan each component, then cross them.
+	var parts []*joinUnit
+	for seen := uint64(0); seen != all; {
+		comp := all &^ seen & -(all &^ seen)
+		for {
+			grown := comp | neighborhood(comp, 0)
+			if grown == comp {
+				break
+			}
+			comp = grown
+		}
+		seen |= comp
+		parts = append(parts, best[comp])
+	}
+	sort.Slice(parts, func(i, j int) bool { return parts[i].plan.PlanRows < parts[j].plan.PlanRows })
+	result := parts[0]
+	for _, part := range parts[1:] {
+		result = pl.join(result, part)
+	}
+	return result
+}
+
+// enumerateGreedy is greedy operator ordering: it repeatedly joins the
+// pair of inputs with the smallest result, preferring pairs connected by a
+// predicate over cross products.
+func (pl *joinPlanner) enumerateGreedy(units []*joinUnit) *joinUnit {
+	units = append([]*joinUnit(nil), units...)
+	for len(units) > 1 {
+		var best *joinUnit
+		bestI, bestJ, bestConnected := 0, 0, false
+		for i := 0; i < len(units); i++ {
+			for j := i + 1; j < len(units); j++ {
+				connected := len(pl.covered(units[i].rels|units[j].rels, units[i].rels, units[j].rels)) > 0
+				if bestConnected && !connected {
+					continue
+				}
+				joined := pl.join(units[i], units[j])
+				if best == nil || (connected && !bestConnected) ||
+					joined.plan.PlanRows < best.plan.PlanRows ||
+					(joined.plan.PlanRows == best.plan.PlanRows && joined.plan.TotalCost < best.plan.TotalCost) {
+					best, bestI, bestJ, bestConnected = joined, i, j, connected
+				}
+			}
+		}
+		units[bestI] = best
+		units = append(units[:bestJ], units[bestJ+1:]...)
+	}
+	return units[0]
+}
+
+// join returns the cheapest inner join of two units, applying every
+// predicate that becomes evaluable once both are joined.
+func (pl *joinPlanner) join(a, b *joinUnit) *joinUnit {
+	rels := a.rels | b.rels
+	var clauses []Expression
+	hasEqui := false
+	for _, p := range pl.preds {
+		if p.required&^rels != 0 || p.required&^a.rels == 0 || p.required&^b.rels == 0 {
+			continue
+		}
+		clauses = append(clauses, p.expr)
+		if p.equi && pl.splitsAcross(p, a.rels, b.rels) {
+			hasEqui = true
+		}
+	}
+	rows := pl.joinRows(a.plan, b.plan, pl.joinSelectivity(clauses))
+
+	opt := pl.opt
+	candidates := []*QueryPlan{
+		opt.createNestedLoopJoin(a.plan, b.plan, clauses),
+		opt.createNestedLoopJoin(b.plan, a.plan, clauses),
+	}
+	if hasEqui {
+		if opt.config.EnableHashJoin {
+			candidates = append(candidates,
+				opt.createHashJoin(a.plan, b.plan, clauses),
+				opt.createHashJoin(b.plan, a.plan, clauses))
+		}
+		if opt.config.EnableMergeJoin {
+			candidates = append(candidates, opt.createMergeJoin(a.plan, b.plan, clauses))
+		}
+	}
+	for _, c := range candidates {
+		c.PlanRows = rows
+	}
+	if hasEqui && opt.config.EnableIndexScan {
+		if inl := pl.indexNestLoop(a, b, clauses, rows); inl != nil {
+			candidates = append(candidates, inl)
+		}
+		if inl := pl.indexNestLoop(b, a, clauses, rows); inl != nil {
+			candidates = append(candidates, inl)
+		}
+	}
+	return &joinUnit{plan: opt.chooseCheapestPlan(candidates), rels: rels}
+}
+
+// splitsAcross reports whether an equality predicate has one operand on
+// each of two inputs.
+func (pl *joinPlanner) splitsAcross(p *joinPredicate, a, b uint64) bool {
+	e := p.expr.(*BinaryExpression)
+	l, _ := pl.relationsOf(e.Left)
+	r, _ := pl.relationsOf(e.Right)
+	return (l&^a == 0 && r&^b == 0) || (l&^b == 0 && r&^a == 0)
+}
+
+// indexNestLoop plans outer joined to inner by probing an index of inner
+// once per outer row. inner must be a base relation scan with an index
+// whose leading column is the inner side of an equality clause.
+func (pl *joinPlanner) indexNestLoop(outer, inner *joinUnit, clauses []Expression, rows float64) *QueryPlan {
+	if bits.OnesCount64(inner.rels) != 1 || inner.plan.TableName == "" || inner.plan.RightTree != nil {
+		return nil
+	}
+	rel := pl.relations[bits.TrailingZeros64(inner.rels)]
+	if rel.ref.Subquery != nil {
+		return nil
+	}
+	stats := pl.opt.tableStatistics(inner.plan.TableName)
+	if len(stats.Indexes) == 0 {
+		return nil
+	}
+
+	var best *QueryPlan
+	for _, clause := range clauses {
+		b, ok := clause.(*BinaryExpression)
+		if !ok || b.Operator != OpEqual {
+			continue
+		}
+		innerSide, outerSide := b.Left, b.Right
+		if r, _ := pl.relationsOf(innerSide); r != inner.rels {
+			innerSide, outerSide = b.Right, b.Left
+		}
+		col, ok := innerSide.(*IdentifierExpression)
+		if r, _ := pl.relationsOf(outerSide); !ok || r == 0 || r&^outer.rels != 0 {
+			continue
+		}
+		for _, index := range stats.Indexes {
+			if len(index.Columns) == 0 || !strings.EqualFold(index.Columns[0], col.Name) {
+				continue
+			}
+			probe := &QueryPlan{
+				Type:      PlanTypeIndexScan,
+				TableName: inner.plan.TableName,
+				Alias:     inner.plan.Alias,
+				IndexName: index.IndexName,
+				PlanWidth: inner.plan.PlanWidth,
+				Qual:      inner.plan.Qual,
+				ScanKeys:  []ScanKey{{Column: col.Name, Operator: OpEqual, Value: outerSide}},
+			}
+			plan := &QueryPlan{
+				Type:        PlanTypeNestLoop,
+				LeftTree:    outer.plan,
+				RightTree:   probe,
+				JoinType:    InnerJoin,
+				JoinClauses: clauses,
+				PlanRows:    rows,
+			}
+			pl.opt.costIndexNestLoop(plan, stats, index)
+			if best == nil || plan.TotalCost < best.TotalCost {
+				best = plan
+			}
+		}
+	}
+	return best
+}
+
+// joinSelectivity estimates join clauses with the statistics of the tables
+// their qualifiers name.
+func (pl *joinPlanner) joinSelectivity(clauses []Expression) float64 {
+	if len(clauses) == 0 {
+		return 1
+	}
+	selectivity := 1.0
+	for _, clause := range clauses {
+		selectivity *= pl.clauseSelectivity(clause)
+	}
+	return math.Max(selectivity, minSelectivity)
+}
+
+func (pl *joinPlanner) clauseSelectivity(clause Expression) float64 {
+	b, ok := clause.(*BinaryExpression)
+	if !ok {
+		return defaultSelectivity
+	}
+	switch b.Operator {
+	case OpAnd:
+		return pl.clauseSelectivity(b.Left) * pl.clauseSelectivity(b.Right)
+	case OpEqual:
+		l, lok := b.Left.(*IdentifierExpression)
+		r, rok := b.Right.(*IdentifierExpression)
+		if lok && rok {
+			ls, rs := pl.columnStats(l), pl.columnStats(r)
+			if ls != nil && rs != nil && math.Max(ls.NDistinct, rs.NDistinct) >= 1 {
+				return (1 - ls.NullFraction) * (1 - rs.NullFraction) / math.Max(ls.NDistinct, rs.NDistinct)
+			}
+		}
+	}
+	return pl.opt.estimateJoinClauseSelectivity(clause)
+}
+
+// columnStats resolves a column's qualifier through the FROM clause's
+// aliases to the analyzed statistics of its table.
+func (pl *joinPlanner) columnStats(id *IdentifierExpression) *ColumnStatistics {
+	rels, ok := pl.relationsOf(id)
+	if !ok || bits.OnesCount64(rels) != 1 {
+		return nil
+	}
+	ref := pl.relations[bits.TrailingZeros64(rels)].ref
+	if ref.Subquery != nil {
+		return nil
+	}
+	if stats := pl.opt.stats.GetTableStats(ref.Name); stats != nil && stats.Columns != nil {
+		return stats.Columns[id.Name]
+	}
+	return nil
+}
+
+// joinRows is the estimated output of joining two inputs.
+func (pl *joinPlanner) joinRows(left, right *QueryPlan, selectivity float64) float64 {
+	return math.Max(left.PlanRows*right.PlanRows*selectivity, 1)
+}
@@ -655,93 +655,97 @@ func (l *Lexer) scanOperator(start, startLine, startCol int) Token {
 	}
 }
 
+// sqlKeywords is built once; isKeyword runs for every identifier token.
+var sqlKeywords = map[string]bool{
+	// Basic SQL keywords
+	"SELECT": true, "FROM": true, "WHERE": true, "INSERT": true, "INTO": true,
+	"VALUES": true, "UPDATE": true, "SET": true, "DELETE": true, "CREATE": true,
+	"DROP": true, "ALTER": true, "TABLE": true, "INDEX": true, "VIEW": true,
+	"DATABASE": true, "SCHEMA": true, "COLUMN": true, "CONSTRAINT": true,
+
+	// Data types
+	"INTEGER": true, "INT": true, "BIGINT": true, "SMALLINT": true, "TINYINT": true,
+	"DECIMAL": true, "NUMERIC": true, "FLOAT": true, "REAL": true, "DOUBLE": true,
+	"VARCHAR": true, "CHAR": true, "TEXT": true, "BLOB": true, "CLOB": true,
+	"DATE": true, "TIME": true, "TIMESTAMP": true, "DATETIME": true, "INTERVAL": true,
+	"BOOLEAN": true, "BOOL": true, "JSON": true, "JSONB": true, "XML": true,
+	"UUID": true, "ARRAY": true, "SERIAL": true, "BIGSERIAL": true,
+
+	// Constraints
+	"PRIMARY": true, "KEY": true, "FOREIGN": true, "REFERENCES": true,
+	"UNIQUE": true, "CHECK": true, "DEFAULT": true, "NOT": true, "NULL": true,
+	"AUTO_INCREMENT": true, "IDENTITY": true, "GENERATED": true, "ALWAYS": true,
+
+	// Operators and functions
+	"AND": true, "OR": true, "IN": true, "EXISTS": true, "BETWEEN": true,
+	"LIKE": true, "ILIKE": true, "SIMILAR": true, "REGEXP": true, "RLIKE": true,
+	"IS": true, "DISTINCT": true, "ALL": true, "ANY": true, "SOME": true,
+
+	// Joins
+	"JOIN": true, "INNER": true, "LEFT": true, "RIGHT": true, "FULL": true,
+	"OUTER": true, "CROSS": true, "NATURAL": true, "ON": true, "USING": true,
+
+	// Grouping and ordering
+	"GROUP": true, "BY": true, "HAVING": true, "ORDER": true, "ASC": true,
+	"DESC": true, "LIMIT": true, "OFFSET": true, "FETCH": true, "FIRST": true,
+	"LAST": true, "ROWS": true, "ONLY": true, "NULLS": true,
+
+	// Window functions
+	"OVER": true, "PARTITION": true, "RANGE": true, "UNBOUNDED": true,
+	"PRECEDING": true, "FOLLOWING": true, "CURRENT": true, "ROW": true,
+	"FILTER": true,
+
+	// Set operations
+	"UNION": true, "INTERSECT": true, "EXCEPT": true, "MINUS": true,
+
+	// Common Table Expressions
+	"WITH": true, "RECURSIVE": true, "AS": true,
+
+	// Case expressions
+	"CASE": true, "WHEN": true, "THEN": true, "ELSE": true, "END": true,
+
+	// Transactions
+	"BEGIN": true, "COMMIT": true, "ROLLBACK": true, "TRANSACTION": true,
+	"START": true, "SAVEPOINT": true, "RELEASE": true,
+
+	// Prepared statements
+	"PREPARE": true, "EXECUTE": true, "DEALLOCATE": true,
+
+	// Access control
+	"GRANT": true, "REVOKE": true, "ROLE": true, "USER": true, "PRIVILEGE": true,
+	"PRIVILEGES": true, "PUBLIC": true,
+
+	// Procedural
+	"IF": true, "ELSEIF": true, "WHILE": true, "FOR": true, "LOOP": true,
+	"REPEAT": true, "UNTIL": true, "RETURN": true, "CALL": true, "FUNCTION": true,
+	"PROCEDURE": true, "TRIGGER": true, "DECLARE": true,
+
+	// Literals
+	"TRUE": true, "FALSE": true,
+
+	// Conflict resolution
+	"CONFLICT": true, "DO": true, "NOTHING": true, "REPLACE": true,
+	"IGNORE": true, "UPSERT": true,
+
+	// DDL specific keywords
+	"ADD": true, "MODIFY": true, "CHANGE": true, "RENAME": true, "TO": true,
+	"AFTER": true, "BEFORE": true,
+
+	// Advanced SQL features
+	"MATERIALIZED": true, "REFRESH": true, "CONCURRENTLY": true,
+	"EXPLAIN": true, "ANALYZE": true, "VERBOSE": true,
+	"LATERAL": true, "TABLESAMPLE": true, "BERNOULLI": true, "SYSTEM": true,
+
+	// Misc
+	"TEMPORARY": true, "TEMP": true, "CASCADE": true, "RESTRICT": true,
+	"MATCH": true, "PARTIAL": true, "SIMPLE": true,
+	"ACTION": true, "NO": true, "DEFERRABLE": true, "INITIALLY": true,
+	"DEFERRED": true, "IMMEDIATE": true,
+}
+
 // isKeyword checks if a string is a SQL keyword
 func isKeyword(s string) bool {
-	keywords := map[string]bool{
-		// Basic SQL keywords
-		"SELECT": true, "FROM": true, "WHERE": true, "INSERT": true, "INTO": true,
-		"VALUES": true, "UPDATE": true, "SET": true, "DELETE": true, "CREATE": true,
-		"DROP": true, "ALTER": true, "TABLE": true, "INDEX": true, "VIEW": true,
-		"DATABASE": true, "SCHEMA": true, "COLUMN": true, "CONSTRAINT": true,
-
-		// Data types
-		"INTEGER": true, "INT": true, "BIGINT": true, "SMALLINT": true, "TINYINT": true,
-		"DECIMAL": true, "NUMERIC": true, "FLOAT": true, "REAL": true, "DOUBLE": true,
-		"VARCHAR": true, "CHAR": true, "TEXT": true, "BLOB": true, "CLOB": true,
-		"DATE": true, "TIME": true, "TIMESTAMP": true, "DATETIME": true, "INTERVAL": true,
-		"BOOLEAN": true, "BOOL": true, "JSON": true, "JSONB": true, "XML": true,
-		"UUID": true, "ARRAY": true, "SERIAL": true, "BIGSERIAL": true,
-
-		// Constraints
-		"PRIMARY": true, "KEY": true, "FOREIGN": true, "REFERENCES": true,
-		"UNIQUE": true, "CHECK": true, "DEFAULT": true, "NOT": true, "NULL": true,
-		"AUTO_INCREMENT": true, "IDENTITY": true, "GENERATED": true, "ALWAYS": true,
-
-		// Operators and functions
-		"AND": true, "OR": true, "IN": true, "EXISTS": true, "BETWEEN": true,
-		"LIKE": true, "ILIKE": true, "SIMILAR": true, "REGEXP": true, "RLIKE": true,
-		"IS": true, "DISTINCT": true, "ALL": true, "ANY": true, "SOME": true,
-
-		// Joins
-		"JOIN": true, "INNER": true, "LEFT": true, "RIGHT": true, "FULL": true,
-		"OUTER": true, "CROSS": true, "NATURAL": true, "ON": true, "USING": true,
-
-		// Grouping and ordering
-		"GROUP": true, "BY": true, "HAVING": true, "ORDER": true, "ASC": true,
-		"DESC": true, "LIMIT": true, "OFFSET": true, "FETCH": true, "FIRST": true,
-		"LAST": true, "ROWS": true, "ONLY": true, "NULLS": true,
-
-		// Window functions
-		"OVER": true, "PARTITION": true, "RANGE": true, "UNBOUNDED": true,
-		"PRECEDING": true, "FOLLOWING": true, "CURRENT": true, "ROW": true,
-		"FILTER": true,
-
-		// Set operations
-		"UNION": true, "INTERSECT": true, "EXCEPT": true, "MINUS": true,
-
-		// Common Table Expressions
-		"WITH": true, "RECURSIVE": true, "AS": true,
-
-		// Case expressions
-		"CASE": true, "WHEN": true, "THEN": true, "ELSE": true, "END": true,
-
-		// Transactions
-		"BEGIN": true, "COMMIT": true, "ROLLBACK": true, "TRANSACTION": true,
-		"START": true, "SAVEPOINT": true, "RELEASE": true,
-
-		// Access control
-		"GRANT": true, "REVOKE": true, "ROLE": true, "USER": true, "PRIVILEGE": true,
-		"PRIVILEGES": true, "PUBLIC": true,
-
-		// Procedural
-		"IF": true, "ELSEIF": true, "WHILE": true, "FOR": true, "LOOP": true,
-		"REPEAT": true, "UNTIL": true, "RETURN": true, "CALL": true, "FUNCTION": true,
-		"PROCEDURE": true, "TRIGGER": true, "DECLARE": true,
-
-		// Literals
-		"TRUE": true, "FALSE": true,
-
-		// Conflict resolution
-		"CONFLICT": true, "DO": true, "NOTHING": true, "REPLACE": true,
-		"IGNORE": true, "UPSERT": true,
-
-		// DDL specific keywords
-		"ADD": true, "MODIFY": true, "CHANGE": true, "RENAME": true, "TO": true,
-		"AFTER": true, "BEFORE": true,
-
-		// Advanced SQL features
-		"MATERIALIZED": true, "REFRESH": true, "CONCURRENTLY": true,
-		"EXPLAIN": true, "ANALYZE": true, "VERBOSE": true,
-		"LATERAL": true, "TABLESAMPLE": true, "BERNOULLI": true, "SYSTEM": true,
-
-		// Misc
-		"TEMPORARY": true, "TEMP": true, "CASCADE": true, "RESTRICT": true,
-		"MATCH": true, "PARTIAL": true, "SIMPLE": true,
-		"ACTION": true, "NO": true, "DEFERRABLE": true, "INITIALLY": true,
-		"DEFERRED": true, "IMMEDIATE": true,
-	}
-
-	return keywords[s]
+	return sqlKeywords[s]
 }
 
 // TokenizeSQL tokenizes a SQL string and returns all tokens
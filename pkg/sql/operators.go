@@ -0,0 +1,875 @@
+package sql
+
+import (
+	"context"
+	"fmt"
+	"strings"
+	"time"
+)
+
+// RowBatch is the unit of data exchanged between operators. Batches are
+// capped at ExecutorConfig.BatchSize rows, so a streaming pipeline holds a
+// few batches in memory instead of whole tables.
+type RowBatch struct {
+	Rows []Row
+}
+
+// Operator is a node in a pull-based execution pipeline. Open prepares the
+// operator and its inputs, NextBatch returns the next batch or nil once the
+// input is exhausted, and Close releases resources. Close must be safe after
+// a partial read because LIMIT stops its input early.
+type Operator interface {
+	Open(ctx *ExecutionContext) error
+	NextBatch() (*RowBatch, error)
+	Close() error
+	Columns() []ColumnInfo
+}
+
+// RowStream exposes a running operator pipeline to callers that want to
+// consume results incrementally instead of as one ResultSet.
+type RowStream struct {
+	executor *QueryExecutor
+	root     Operator
+	execCtx  *ExecutionContext
+	cancel   context.CancelFunc
+	closed   bool
+}
+
+// ExecuteStream opens plan as an operator pipeline. The caller must Close the
+// stream; cancelling ctx aborts the pipeline at the next batch boundary.
+func (qe *QueryExecutor) ExecuteStream(ctx context.Context, plan *QueryPlan, params []interface{}) (*RowStream, error) {
+	execCtx := &ExecutionContext{
+		Context:    ctx,
+		Parameters: params,
+		StartTime:  time.Now(),
+		WorkMem:    qe.config.WorkMem,
+		Stats:      &ExecutionStats{},
+		profiler:   newPlanProfiler(ctx),
+	}
+
+	cancel := context.CancelFunc(func() {})
+	if qe.config.StatementTimeout > 0 {
+		execCtx.Context, cancel = context.WithTimeout(ctx, qe.config.StatementTimeout)
+	}
+
+	root, err := qe.buildProfiledOperator(plan, execCtx.profiler)
+	if err != nil {
+		cancel()
+		execCtx.profiler.finish(execCtx.StartTime, err)
+		return nil, err
+	}
+	if err := root.Open(execCtx); err != nil {
+		root.Close()
+		cancel()
+		execCtx.profiler.finish(execCtx.StartTime, err)
+		return nil, err
+	}
+
+	return &RowStream{
+		executor: qe,
+		root:     root,
+		execCtx:  execCtx,
+		cancel:   cancel,
+	}, nil
+}
+
+// Columns describes the rows produced by the stream.
+func (rs *RowStream) Columns() []ColumnInfo {
+	return rs.root.Columns()
+}
+
+// Next returns the next batch, or nil when the stream is exhausted.
+func (rs *RowStream) Next() (*RowBatch, error) {
+	if rs.closed {
+		return nil, nil
+	}
+	return rs.root.NextBatch()
+}
+
+// Stats returns the statistics collected so far.
+func (rs *RowStream) Stats() ExecutionStats {
+	return *rs.execCtx.Stats
+}
+
+// Close stops the pipeline and folds its statistics into the executor.
+func (rs *RowStream) Close() error {
+	if rs.closed {
+		return nil
+	}
+	rs.closed = true
+	err := rs.root.Close()
+	rs.cancel()
+	rs.execCtx.profiler.finish(rs.execCtx.StartTime, err)
+
+	qe := rs.executor
+	qe.mu.Lock()
+	qe.stats.QueriesExecuted++
+	qe.stats.TotalExecutionTime += time.Since(rs.execCtx.StartTime)
+	qe.stats.RowsProcessed += rs.execCtx.Stats.RowsProcessed
+	qe.stats.BytesProcessed += rs.execCtx.Stats.BytesProcessed
+	qe.mu.Unlock()
+
+	return err
+}
+
+// executeOperatorPlan runs plan through the operator pipeline and
+// materializes the output for callers of the ResultSet API.
+func (qe *QueryExecutor) executeOperatorPlan(ctx *ExecutionContext, plan *QueryPlan) (*ResultSet, error) {
+	root, err := qe.buildProfiledOperator(plan, ctx.profiler)
+	if err != nil {
+		return nil, err
+	}
+	if err := root.Open(ctx); err != nil {
+		root.Close()
+		return nil, err
+	}
+	defer root.Close()
+
+	var rows []Row
+	for {
+		batch, err := root.NextBatch()
+		if err != nil {
+			return nil, err
+		}
+		if batch == nil {
+			break
+		}
+		rows = append(rows, batch.Rows...)
+	}
+
+	return &ResultSet{
+		Columns: root.Columns(),
+		Rows:    rows,
+		Stats:   *ctx.Stats,
+	}, nil
+}
+
+// buildOperator translates a plan tree into operators. Plan types without a
+// streaming implementation are wrapped so they can still feed one.
+func (qe *QueryExecutor) buildOperator(plan *QueryPlan) (Operator, error) {
+	return qe.buildProfiledOperator(plan, nil)
+}
+
+// buildProfiledOperator is buildOperator for a query being profiled: with
+// prof set, every operator is wrapped in a timer that records into prof.
+func (qe *QueryExecutor) buildProfiledOperator(plan *QueryPlan, prof *planProfiler) (Operator, error) {
+	if prof == nil {
+		return qe.buildOperatorNode(plan, nil)
+	}
+	if plan == nil {
+		return nil, fmt.Errorf("cannot build operator for nil plan")
+	}
+	node := prof.enter(plan)
+	op, err := qe.buildOperatorNode(plan, prof)
+	prof.leave()
+	if err != nil {
+		return nil, err
+	}
+	return &profiledOperator{Operator: op, profile: node}, nil
+}
+
+func (qe *QueryExecutor) buildOperatorNode(plan *QueryPlan, prof *planProfiler) (Operator, error) {
+	if plan == nil {
+		return nil, fmt.Errorf("cannot build operator for nil plan")
+	}
+
+	switch plan.Type {
+	case PlanTypeSeqScan:
+		return qe.newScanOperator(plan)
+	case PlanTypeParallelSeqScan:
+		return qe.newParallelScanOperator(plan)
+	case PlanTypeIndexScan, PlanTypeIndexOnlyScan:
+		return qe.newIndexScanOperator(plan), nil
+	case PlanTypeBitmapHeapScan:
+		return qe.newBitmapHeapOperator(plan), nil
+	case PlanTypeGather:
+		// The parallel scan beneath already gathers its workers' batches.
+		return qe.buildProfiledOperator(plan.LeftTree, prof)
+	case PlanTypeValuesScan:
+		return &valuesOperator{rows: []Row{{}}}, nil
+	case PlanTypeLimit:
+		child, err := qe.buildProfiledOperator(plan.LeftTree, prof)
+		if err != nil {
+			return nil, err
+		}
+		return newLimitOperator(child, plan), nil
+	case PlanTypeSort:
+		child, err := qe.buildProfiledOperator(plan.LeftTree, prof)
+		if err != nil {
+			return nil, err
+		}
+		return newSortOperator(child, plan.SortKeys, qe.config.BatchSize, qe.config.WorkMem), nil
+	case PlanTypeAggregate, PlanTypeGroup:
+		child, err := qe.buildProfiledOperator(plan.LeftTree, prof)
+		if err != nil {
+			return nil, err
+		}
+		return newHashAggregateOperator(child, plan, qe.config), nil
+	case PlanTypeResult:
+		child, err := qe.buildProfiledOperator(plan.LeftTree, prof)
+		if err != nil {
+			return nil, err
+		}
+		return newProjectOperator(child, plan.TargetList), nil
+	case PlanTypeUnique:
+		child, err := qe.buildProfiledOperator(plan.LeftTree, prof)
+		if err != nil {
+			return nil, err
+		}
+		return &uniqueOperator{child: child}, nil
+	case PlanTypeHashJoin, PlanTypeNestLoop, PlanTypeMergeJoin:
+		if plan.Type == PlanTypeNestLoop {
+			inl, err := qe.newIndexNestLoopOperator(plan, prof)
+			if err != nil {
+				return nil, err
+			}
+			if inl != nil {
+				return withFilter(inl, plan.Qual), nil
+			}
+		}
+		op, err := qe.newHashJoinOperator(plan, prof)
+		if err != nil {
+			return nil, err
+		}
+		return withFilter(op, plan.Qual), nil
+	case PlanTypeSubqueryScan, PlanTypeMaterial, PlanTypeHash:
+		child, err := qe.buildProfiledOperator(plan.LeftTree, prof)
+		if err != nil {
+			return nil, err
+		}
+		return withFilter(child, plan.Qual), nil
+	default:
+		op := &planResultOperator{executor: qe, plan: plan, batchSize: qe.config.BatchSize}
+		return withFilter(op, plan.Qual), nil
+	}
+}
+
+func withFilter(child Operator, quals []Expression) Operator {
+	if len(quals) == 0 {
+		return child
+	}
+	return &filterOperator{child: child, quals: quals}
+}
+
+// checkCancelled is called once per batch so cancellation costs one
+// channel poll per BatchSize rows rather than one per row.
+func checkCancelled(ctx *ExecutionContext) error {
+	select {
+	case <-ctx.Context.Done():
+		return ctx.Context.Err()
+	default:
+		return nil
+	}
+}
+
+// scanOperator streams rows out of a storage engine iterator, applying the
+// scan qualifiers before rows enter the batch.
+type scanOperator struct {
+	executor  *QueryExecutor
+	plan      *QueryPlan
+	columns   []ColumnInfo
+	colIndex  map[string]int
+	batchSize int
+	source    rowSource
+	ctx       *ExecutionContext
+	done      bool
+}
+
+// rowSource is the storage-specific half of a scan.
+type rowSource interface {
+	// next returns the next row and the number of bytes read for it. ok is
+	// false once the source is exhausted.
+	next() (row Row, bytes int64, ok bool, err error)
+	close() error
+}
+
+func (qe *QueryExecutor) newScanOperator(plan *QueryPlan) (*scanOperator, error) {
+	columns := qe.getTableColumns(plan.TableName)
+	return &scanOperator{
+		executor:  qe,
+		plan:      plan,
+		columns:   columns,
+		colIndex:  columnIndexMap(columns),
+		batchSize: qe.config.BatchSize,
+	}, nil
+}
+
+func (s *scanOperator) Open(ctx *ExecutionContext) error {
+	s.ctx = ctx
+	source, err := s.executor.openRowSource(ctx, s.plan.TableName, s.columns)
+	if err != nil {
+		return err
+	}
+	s.source = source
+	ctx.Stats.SeqScans++
+	return nil
+}
+
+func (s *scanOperator) NextBatch() (*RowBatch, error) {
+	if s.done {
+		return nil, nil
+	}
+	if err := checkCancelled(s.ctx); err != nil {
+		return nil, err
+	}
+
+	batch := &RowBatch{Rows: make([]Row, 0, s.batchSize)}
+	env := &evalEnv{columns: s.colIndex, params: s.ctx.Parameters}
+	for len(batch.Rows) < s.batchSize {
+		row, n, ok, err := s.source.next()
+		if err != nil {
+			return nil, err
+		}
+		if !ok {
+			s.done = true
+			break
+		}
+		s.ctx.Stats.BytesProcessed += n
+
+		env.row = row
+		match, err := evaluateQuals(s.plan.Qual, env)
+		if err != nil {
+			return nil, err
+		}
+		if match {
+			batch.Rows = append(batch.Rows, row)
+			s.ctx.Stats.RowsProcessed++
+		}
+	}
+
+	if len(batch.Rows) == 0 && s.done {
+		return nil, nil
+	}
+	return batch, nil
+}
+
+func (s *scanOperator) Close() error {
+	if s.source == nil {
+		return nil
+	}
+	err := s.source.close()
+	s.source = nil
+	return err
+}
+
+func (s *scanOperator) Columns() []ColumnInfo {
+	return s.columns
+}
+
+// openRowSource opens a streaming cursor over a table in whichever storage
+// engine holds it.
+func (qe *QueryExecutor) openRowSource(ctx *ExecutionContext, tableName string, columns []ColumnInfo) (rowSource, error) {
+	sm := qe.storageManager
+	switch qe.getStorageType(tableName) {
+	case StorageTypeKV:
+		if sm.kvStore == nil {
+			return nil, fmt.Errorf("KV storage engine not configured")
+		}
+		iter, err := sm.kvStore.Scan(ctx.Context, []byte(tableName+"/"), []byte(tableName+"/~"))
+		if err != nil {
+			return nil, fmt.Errorf("failed to create KV iterator: %w", err)
+		}
+		return &kvRowSource{executor: qe, iter: iter, columns: columns}, nil
+	case StorageTypeDocument:
+		if sm.docStore == nil {
+			return nil, fmt.Errorf("document storage engine not configured")
+		}
+		iter, err := sm.docStore.QueryDocuments(ctx.Context, tableName, DocumentQuery{})
+		if err != nil {
+			return nil, fmt.Errorf("failed to create document iterator: %w", err)
+		}
+		return &documentRowSource{executor: qe, iter: iter, columns: columns}, nil
+	case StorageTypeColumnar:
+		if sm.columnarStore == nil {
+			return nil, fmt.Errorf("columnar storage engine not configured")
+		}
+		iters := make([]ColumnIterator, 0, len(columns))
+		for _, col := range columns {
+			iter, err := sm.columnarStore.ScanColumn(ctx.Context, tableName, col.Name, Predicate{})
+			if err != nil {
+				for _, open := range iters {
+					open.Close()
+				}
+				return nil, fmt.Errorf("failed to scan column %s: %w", col.Name, err)
+			}
+			iters = append(iters, iter)
+		}
+		return &columnarRowSource{iters: iters}, nil
+	default:
+		return nil, fmt.Errorf("unknown storage type for table %s", tableName)
+	}
+}
+
+type kvRowSource struct {
+	executor *QueryExecutor
+	iter     Iterator
+	columns  []ColumnInfo
+}
+
+func (s *kvRowSource) next() (Row, int64, bool, error) {
+	if !s.iter.Next() {
+		if err := s.iter.Error(); err != nil {
+			return Row{}, 0, false, fmt.Errorf("iterator error: %w", err)
+		}
+		return Row{}, 0, false, nil
+	}
+	key, value, err := s.iter.Value()
+	if err != nil {
+		return Row{}, 0, false, fmt.Errorf("failed to read KV pair: %w", err)
+	}
+	return s.executor.kvToRow(key, value, s.columns), int64(len(key) + len(value)), true, nil
+}
+
+func (s *kvRowSource) close() error {
+	return s.iter.Close()
+}
+
+type documentRowSource struct {
+	executor *QueryExecutor
+	iter     DocumentIterator
+	columns  []ColumnInfo
+}
+
+func (s *documentRowSource) next() (Row, int64, bool, error) {
+	if !s.iter.Next() {
+		if err := s.iter.Error(); err != nil {
+			return Row{}, 0, false, fmt.Errorf("iterator error: %w", err)
+		}
+		return Row{}, 0, false, nil
+	}
+	doc, err := s.iter.Document()
+	if err != nil {
+		return Row{}, 0, false, fmt.Errorf("failed to read document: %w", err)
+	}
+	return s.executor.documentToRow(doc, s.columns), 0, true, nil
+}
+
+func (s *documentRowSource) close() error {
+	return s.iter.Close()
+}
+
+// columnarRowSource advances one iterator per column in lockstep; the first
+// column decides when the table is exhausted.
+type columnarRowSource struct {
+	iters []ColumnIterator
+}
+
+func (s *columnarRowSource) next() (Row, int64, bool, error) {
+	if len(s.iters) == 0 {
+		return Row{}, 0, false, nil
+	}
+	row := Row{Values: make([]interface{}, len(s.iters))}
+	for i, iter := range s.iters {
+		if !iter.Next() {
+			if err := iter.Error(); err != nil {
+				return Row{}, 0, false, fmt.Errorf("column iterator error: %w", err)
+			}
+			if i == 0 {
+				return Row{}, 0, false, nil
+			}
+			continue
+		}
+		v, err := iter.Value()
+		if err != nil {
+			return Row{}, 0, false, fmt.Errorf("failed to read column value: %w", err)
+		}
+		row.Values[i] = v
+	}
+	return row, 0, true, nil
+}
+
+func (s *columnarRowSource) close() error {
+	var firstErr error
+	for _, iter := range s.iters {
+		if err := iter.Close(); err != nil && firstErr == nil {
+			firstErr = err
+		}
+	}
+	return firstErr
+}
+
+// planResultOperator adapts plan nodes that still execute into a ResultSet
+// (joins, index scans) so they can feed streaming parents.
+type planResultOperator struct {
+	executor  *QueryExecutor
+	plan      *QueryPlan
+	batchSize int
+	result    *ResultSet
+	pos       int
+}
+
+func (p *planResultOperator) Open(ctx *ExecutionContext) error {
+	result, err := p.executor.executePlan(ctx, p.plan)
+	if err != nil {
+		return err
+	}
+	p.result = result
+	return nil
+}
+
+func (p *planResultOperator) NextBatch() (*RowBatch, error) {
+	if p.result == nil || p.pos >= len(p.result.Rows) {
+		return nil, nil
+	}
+	end := p.pos + p.batchSize
+	if end > len(p.result.Rows) {
+		end = len(p.result.Rows)
+	}
+	batch := &RowBatch{Rows: p.result.Rows[p.pos:end]}
+	p.pos = end
+	return batch, nil
+}
+
+func (p *planResultOperator) Close() error {
+	p.result = nil
+	return nil
+}
+
+func (p *planResultOperator) Columns() []ColumnInfo {
+	if p.result == nil {
+		return nil
+	}
+	return p.result.Columns
+}
+
+// valuesOperator emits a fixed set of rows, e.g. the single empty row of a
+// SELECT without FROM.
+type valuesOperator struct {
+	rows    []Row
+	emitted bool
+}
+
+func (v *valuesOperator) Open(ctx *ExecutionContext) error { return nil }
+
+func (v *valuesOperator) NextBatch() (*RowBatch, error) {
+	if v.emitted {
+		return nil, nil
+	}
+	v.emitted = true
+	return &RowBatch{Rows: v.rows}, nil
+}
+
+func (v *valuesOperator) Close() error          { return nil }
+func (v *valuesOperator) Columns() []ColumnInfo { return nil }
+
+// filterOperator drops rows that fail its qualifiers.
+type filterOperator struct {
+	child    Operator
+	quals    []Expression
+	ctx      *ExecutionContext
+	colIndex map[string]int
+}
+
+func (f *filterOperator) Open(ctx *ExecutionContext) error {
+	f.ctx = ctx
+	if err := f.child.Open(ctx); err != nil {
+		return err
+	}
+	f.colIndex = operatorColumnIndex(f.child)
+	return nil
+}
+
+func (f *filterOperator) NextBatch() (*RowBatch, error) {
+	env := &evalEnv{columns: f.colIndex, params: f.ctx.Parameters}
+	for {
+		batch, err := f.child.NextBatch()
+		if err != nil || batch == nil {
+			return nil, err
+		}
+		kept := batch.Rows[:0:0]
+		for _, row := range batch.Rows {
+			env.row = row
+			ok, err := evaluateQuals(f.quals, env)
+			if err != nil {
+				return nil, err
+			}
+			if ok {
+				kept = append(kept, row)
+			}
+		}
+		if len(kept) > 0 {
+			return &RowBatch{Rows: kept}, nil
+		}
+	}
+}
+
+func (f *filterOperator) Close() error          { return f.child.Close() }
+func (f *filterOperator) Columns() []ColumnInfo { return f.child.Columns() }
+
+// limitOperator implements LIMIT/OFFSET. Once the limit is reached it closes
+// its input immediately so scans below stop reading.
+type limitOperator struct {
+	child   Operator
+	plan    *QueryPlan
+	limit   int64 // -1 means no limit
+	offset  int64
+	emitted int64
+	skipped int64
+	closed  bool
+}
+
+func newLimitOperator(child Operator, plan *QueryPlan) *limitOperator {
+	return &limitOperator{child: child, plan: plan, limit: -1}
+}
+
+// constantCount evaluates a LIMIT/OFFSET expression, which must not depend
+// on any row but may be a bind parameter.
+func constantCount(expr Expression, clause string, params []any) (int64, error) {
+	v, err := evaluateExpression(expr, &evalEnv{params: params})
+	if err != nil {
+		return 0, fmt.Errorf("invalid %s expression: %w", clause, err)
+	}
+	n, ok := toInt64(v)
+	if !ok {
+		if f, isFloat := toFloat64(v); isFloat {
+			n, ok = int64(f), true
+		}
+	}
+	if !ok || n < 0 {
+		return 0, fmt.Errorf("%s must be a non-negative integer, got %v", clause, v)
+	}
+	return n, nil
+}
+
+func (l *limitOperator) Open(ctx *ExecutionContext) error {
+	// The counts are evaluated here rather than at build time because a
+	// cached plan may take them from bind parameters.
+	if l.plan.Limit != nil && l.plan.Limit.Count != nil {
+		n, err := constantCount(l.plan.Limit.Count, "LIMIT", ctx.Parameters)
+		if err != nil {
+			return err
+		}
+		l.limit = n
+	}
+	if l.plan.Offset != nil && l.plan.Offset.Count != nil {
+		n, err := constantCount(l.plan.Offset.Count, "OFFSET", ctx.Parameters)
+		if err != nil {
+			return err
+		}
+		l.offset = n
+	}
+	if l.limit == 0 {
+		return nil
+	}
+	// ORDER BY ... LIMIT only needs the first offset+limit rows, which a
+	// bounded heap finds without sorting everything.
+	if sorter, ok := unwrapOperator(l.child).(*sortOperator); ok && l.limit > 0 {
+		sorter.setTopK(l.limit + l.offset)
+	}
+	return l.child.Open(ctx)
+}
+
+func (l *limitOperator) NextBatch() (*RowBatch, error) {
+	for {
+		if l.limit >= 0 && l.emitted >= l.limit {
+			return nil, l.closeChild()
+		}
+
+		batch, err := l.child.NextBatch()
+		if err != nil || batch == nil {
+			return nil, err
+		}
+
+		rows := batch.Rows
+		if l.skipped < l.offset {
+			skip := l.offset - l.skipped
+			if skip >= int64(len(rows)) {
+				l.skipped += int64(len(rows))
+				continue
+			}
+			rows = rows[skip:]
+			l.skipped = l.offset
+		}
+		if l.limit >= 0 && l.emitted+int64(len(rows)) > l.limit {
+			rows = rows[:l.limit-l.emitted]
+		}
+		l.emitted += int64(len(rows))
+		if len(rows) > 0 {
+			return &RowBatch{Rows: rows}, nil
+		}
+	}
+}
+
+func (l *limitOperator) closeChild() error {
+	if l.closed {
+		return nil
+	}
+	l.closed = true
+	return l.child.Close()
+}
+
+func (l *limitOperator) Close() error          { return l.closeChild() }
+func (l *limitOperator) Columns() []ColumnInfo { return l.child.Columns() }
+
+// projectOperator evaluates the select list against each input row. A *
+// entry expands to every input column, or with a qualifier to the columns
+// of that relation.
+type projectOperator struct {
+	child   Operator
+	targets []TargetEntry
+	ctx     *ExecutionContext
+	columns []ColumnInfo
+	// exprs holds one expression per output column, nil where the column
+	// is copied from input position source.
+	exprs    []Expression
+	sources  []int
+	colIndex map[string]int
+}
+
+func newProjectOperator(child Operator, targets []TargetEntry) *projectOperator {
+	p := &projectOperator{child: child, targets: targets}
+	p.resolve()
+	return p
+}
+
+// resolve derives the output columns from the child's. It runs again once
+// the child is open, since a join only learns which relation each of its
+// columns came from when it opens.
+func (p *projectOperator) resolve() {
+	childColumns := p.child.Columns()
+	p.colIndex = operatorColumnIndex(p.child)
+	p.columns, p.exprs, p.sources = nil, nil, nil
+	for _, target := range p.targets {
+		if ident, ok := target.Expression.(*IdentifierExpression); ok && ident.Name == "*" {
+			for i, col := range childColumns {
+				if ident.Table != "" {
+					if idx, ok := p.colIndex[strings.ToLower(ident.Table+"."+col.Name)]; !ok || idx != i {
+						continue
+					}
+				}
+				p.columns = append(p.columns, col)
+				p.exprs = append(p.exprs, nil)
+				p.sources = append(p.sources, i)
+			}
+			continue
+		}
+		p.columns = append(p.columns, describeExpression(target.Expression, target.ResName, childColumns, p.colIndex))
+		p.exprs = append(p.exprs, target.Expression)
+		p.sources = append(p.sources, -1)
+	}
+}
+
+func (p *projectOperator) Open(ctx *ExecutionContext) error {
+	p.ctx = ctx
+	if err := p.child.Open(ctx); err != nil {
+		return err
+	}
+	p.resolve()
+	for _, target := range p.targets {
+		if ident, ok := target.Expression.(*IdentifierExpression); ok && ident.Name == "*" {
+			continue
+		}
+		if err := checkReferences(target.Expression, p.colIndex, nil); err != nil {
+			p.child.Close()
+			return fmt.Errorf("select list: %w", err)
+		}
+	}
+	return nil
+}
+
+func (p *projectOperator) NextBatch() (*RowBatch, error) {
+	batch, err := p.child.NextBatch()
+	if err != nil || batch == nil {
+		return nil, err
+	}
+	env := &evalEnv{columns: p.colIndex, params: p.ctx.Parameters}
+	rows := make([]Row, len(batch.Rows))
+	for i, row := range batch.Rows {
+		values := make([]any, len(p.exprs))
+		env.row = row
+		for j, expr := range p.exprs {
+			if expr == nil {
+				if p.sources[j] < len(row.Values) {
+					values[j] = row.Values[p.sources[j]]
+				}
+				continue
+			}
+			if values[j], err = evaluateExpression(expr, env); err != nil {
+				return nil, err
+			}
+		}
+		rows[i] = Row{Values: values}
+	}
+	return &RowBatch{Rows: rows}, nil
+}
+
+func (p *projectOperator) Close() error          { return p.child.Close() }
+func (p *projectOperator) Columns() []ColumnInfo { return p.columns }
+
+// uniqueOperator drops rows equal to one already emitted, for SELECT
+// DISTINCT. It streams, holding the encoded key of every distinct row.
+// Values compare as they sort, so 1 and 1.0 are duplicates; NULLs are
+// equal to each other.
+type uniqueOperator struct {
+	child   Operator
+	seen    map[string]struct{}
+	key     []byte
+	memUsed int64
+	spillStats
+}
+
+func (u *uniqueOperator) Open(ctx *ExecutionContext) error {
+	u.seen = make(map[string]struct{})
+	return u.child.Open(ctx)
+}
+
+func (u *uniqueOperator) NextBatch() (*RowBatch, error) {
+	for {
+		batch, err := u.child.NextBatch()
+		if err != nil || batch == nil {
+			return nil, err
+		}
+		kept := batch.Rows[:0:0]
+		for _, row := range batch.Rows {
+			u.key = u.key[:0]
+			for _, v := range row.Values {
+				if v == nil {
+					u.key = append(u.key, sortNullFirst)
+					continue
+				}
+				u.key = appendSortValue(append(u.key, sortNotNull), v)
+			}
+			if _, dup := u.seen[string(u.key)]; dup {
+				continue
+			}
+			u.seen[string(u.key)] = struct{}{}
+			u.memUsed += int64(len(u.key)) + sortEntryOverhead
+			kept = append(kept, row)
+		}
+		u.noteMemory(u.memUsed)
+		if len(kept) > 0 {
+			return &RowBatch{Rows: kept}, nil
+		}
+	}
+}
+
+func (u *uniqueOperator) Close() error {
+	u.seen = nil
+	return u.child.Close()
+}
+
+func (u *uniqueOperator) Columns() []ColumnInfo { return u.child.Columns() }
+
+// outputTargets returns the select list that produced op's rows when an
+// aggregate or projection beneath op computed them, matched to op's
+// columns by position.
+func outputTargets(op Operator) []TargetEntry {
+	for {
+		switch o := stripFilters(op).(type) {
+		case *hashAggregateOperator:
+			return o.targets
+		case *projectOperator:
+			for _, target := range o.targets {
+				if ident, ok := target.Expression.(*IdentifierExpression); ok && ident.Name == "*" {
+					// Positions no longer line up with the target list
+					return nil
+				}
+			}
+			return o.targets
+		case *uniqueOperator:
+			op = o.child
+		default:
+			return nil
+		}
+	}
+}
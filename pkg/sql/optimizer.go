@@ -3,7 +3,9 @@ package sql
 import (
 	"fmt"
 	"math"
+	"sort"
 	"strings"
+	"sync"
 )
 
 // QueryOptimizer provides cost-based query optimization
@@ -31,7 +33,7 @@ type OptimizerConfig struct {
 	EffectiveCacheSize int64 // Effective cache size in KB
 	JoinCollapseLimit  int
 	FromCollapseLimit  int
-	GeqoThreshold      int
+	GeqoThreshold      int // joins of more relations are ordered greedily
 	GeqoEffort         int
 	GeqoPoolSize       int
 	GeqoGenerations    int
@@ -54,7 +56,7 @@ func DefaultOptimizerConfig() *OptimizerConfig {
 		EffectiveCacheSize: 131072, // 128MB
 		JoinCollapseLimit:  8,
 		FromCollapseLimit:  8,
-		GeqoThreshold:      12,
+		GeqoThreshold:      10,
 		GeqoEffort:         5,
 		GeqoPoolSize:       0,
 		GeqoGenerations:    0,
@@ -73,9 +75,16 @@ func NewCostModel(config *OptimizerConfig) *CostModel {
 
 // StatisticsCollector collects and maintains table statistics
 type StatisticsCollector struct {
+	mu          sync.RWMutex
 	tableStats  map[string]*TableStatistics
 	columnStats map[string]*ColumnStatistics
 	indexStats  map[string]*IndexStatistics
+	// modifications counts rows changed per table since it was last
+	// analyzed.
+	modifications map[string]int64
+	// onUpdate is called whenever statistics change, so plans costed
+	// against the old numbers can be dropped.
+	onUpdate func()
 }
 
 // TableStatistics contains statistics for a table
@@ -114,6 +123,7 @@ type IndexStatistics struct {
 	TableName   string
 	Columns     []string
 	IsUnique    bool
+	Covering    bool // the index holds every column a scan of the table returns
 	PageCount   float64
 	RowCount    float64
 	Selectivity float64
@@ -135,6 +145,7 @@ type QueryPlan struct {
 	Parallel    bool
 	Workers     int
 	TableName   string
+	Alias       string // qualifier of the scanned relation's columns, when aliased
 	IndexName   string
 	ScanKeys    []ScanKey
 	JoinType    JoinType
@@ -143,6 +154,7 @@ type QueryPlan struct {
 	GroupKeys   []Expression
 	HashKeys    []Expression
 	Limit       *LimitClause
+	Offset      *OffsetClause
 }
 
 // PlanType represents the type of plan node
@@ -174,8 +186,54 @@ const (
 	PlanTypeParallelIndexScan
 	PlanTypeGather
 	PlanTypeGatherMerge
+	PlanTypeIndexOnlyScan
+	PlanTypeBitmapAnd
+	PlanTypeBitmapOr
+	PlanTypeResult
+	PlanTypeUnique
 )
 
+var planTypeNames = [...]string{
+	PlanTypeSeqScan:           "Seq Scan",
+	PlanTypeIndexScan:         "Index Scan",
+	PlanTypeBitmapIndexScan:   "Bitmap Index Scan",
+	PlanTypeBitmapHeapScan:    "Bitmap Heap Scan",
+	PlanTypeNestLoop:          "Nested Loop",
+	PlanTypeHashJoin:          "Hash Join",
+	PlanTypeMergeJoin:         "Merge Join",
+	PlanTypeSort:              "Sort",
+	PlanTypeHash:              "Hash",
+	PlanTypeMaterial:          "Materialize",
+	PlanTypeAggregate:         "Aggregate",
+	PlanTypeGroup:             "Group",
+	PlanTypeLimit:             "Limit",
+	PlanTypeSubqueryScan:      "Subquery Scan",
+	PlanTypeFunctionScan:      "Function Scan",
+	PlanTypeValuesScan:        "Values Scan",
+	PlanTypeCteScan:           "CTE Scan",
+	PlanTypeWorkTableScan:     "WorkTable Scan",
+	PlanTypeRecursiveUnion:    "Recursive Union",
+	PlanTypeSetOp:             "SetOp",
+	PlanTypeWindowAgg:         "WindowAgg",
+	PlanTypeParallelSeqScan:   "Parallel Seq Scan",
+	PlanTypeParallelIndexScan: "Parallel Index Scan",
+	PlanTypeGather:            "Gather",
+	PlanTypeGatherMerge:       "Gather Merge",
+	PlanTypeIndexOnlyScan:     "Index Only Scan",
+	PlanTypeBitmapAnd:         "BitmapAnd",
+	PlanTypeBitmapOr:          "BitmapOr",
+	PlanTypeResult:            "Result",
+	PlanTypeUnique:            "Unique",
+}
+
+// String returns the node name EXPLAIN shows, as PostgreSQL spells it.
+func (t PlanType) String() string {
+	if t >= 0 && int(t) < len(planTypeNames) {
+		return planTypeNames[t]
+	}
+	return fmt.Sprintf("PlanType(%d)", int(t))
+}
+
 // TargetEntry represents a target list entry
 type TargetEntry struct {
 	Expression Expression
@@ -191,9 +249,13 @@ type ScanKey struct {
 	Value    Expression
 }
 
-// SortKey represents a sort key
+// SortKey represents a sort key: a position in the sort input when
+// Ordinal is set, otherwise Expression, or the column named Column when
+// Expression is nil
 type SortKey struct {
 	Column     string
+	Expression Expression
+	Ordinal    int
 	Direction  OrderDirection
 	NullsFirst bool
 }
@@ -201,34 +263,31 @@ type SortKey struct {
 // NewQueryOptimizer creates a new query optimizer
 func NewQueryOptimizer() *QueryOptimizer {
 	config := DefaultOptimizerConfig()
-	return &QueryOptimizer{
+	opt := &QueryOptimizer{
 		stats:     NewStatisticsCollector(),
 		costModel: NewCostModel(config),
 		config:    config,
 		planCache: NewPlanCache(1000), // Cache up to 1000 plans
 		rewriter:  NewQueryRewriter(),
 	}
+	opt.stats.onUpdate = opt.InvalidatePlans
+	return opt
 }
 
 // NewStatisticsCollector creates a new statistics collector
 func NewStatisticsCollector() *StatisticsCollector {
 	return &StatisticsCollector{
-		tableStats:  make(map[string]*TableStatistics),
-		columnStats: make(map[string]*ColumnStatistics),
-		indexStats:  make(map[string]*IndexStatistics),
+		tableStats:    make(map[string]*TableStatistics),
+		columnStats:   make(map[string]*ColumnStatistics),
+		indexStats:    make(map[string]*IndexStatistics),
+		modifications: make(map[string]int64),
 	}
 }
 
-// OptimizeQuery optimizes a parsed SQL query
+// OptimizeQuery optimizes a parsed SQL query. Plans are not cached here:
+// an AST carries no stable identity, so callers that can name a query use
+// OptimizeCached instead.
 func (opt *QueryOptimizer) OptimizeQuery(stmt Statement) (*QueryPlan, error) {
-	// Generate query hash for plan caching
-	queryHash := opt.generateQueryHash(stmt)
-
-	// Check plan cache first
-	if cachedPlan, found := opt.planCache.Get(queryHash); found {
-		return cachedPlan, nil
-	}
-
 	// Apply query rewriting optimizations
 	rewrittenStmt := opt.rewriter.Rewrite(stmt)
 
@@ -252,16 +311,36 @@ func (opt *QueryOptimizer) OptimizeQuery(stmt Statement) (*QueryPlan, error) {
 		return nil, err
 	}
 
-	// Cache the optimized plan
-	opt.planCache.Put(queryHash, plan)
+	return plan, nil
+}
 
+// OptimizeCached plans stmt and caches the plan, together with the
+// statement, under key. key must identify the statement text exactly,
+// normally a literal-stripped fingerprint whose literals are bound as
+// parameters at execution.
+func (opt *QueryOptimizer) OptimizeCached(key string, stmt Statement) (*QueryPlan, error) {
+	version := opt.planCache.Version()
+	plan, err := opt.OptimizeQuery(stmt)
+	if err != nil {
+		return nil, err
+	}
+	opt.planCache.PutEntry(&CachedPlan{Plan: plan, Statement: stmt, QueryHash: key}, version)
 	return plan, nil
 }
 
-// generateQueryHash generates a hash for query plan caching
-func (opt *QueryOptimizer) generateQueryHash(stmt Statement) string {
-	// Simplified hash generation - would use proper hashing in practice
-	return fmt.Sprintf("%T_%p", stmt, stmt)
+// CachedStatement returns the statement and plan cached under key.
+func (opt *QueryOptimizer) CachedStatement(key string) (Statement, *QueryPlan, bool) {
+	entry, ok := opt.planCache.Entry(key)
+	if !ok {
+		return nil, nil, false
+	}
+	return entry.Statement, entry.Plan, true
+}
+
+// InvalidatePlans drops every cached plan. It is called when schema or
+// statistics change, since either can make a cached plan wrong or slow.
+func (opt *QueryOptimizer) InvalidatePlans() {
+	opt.planCache.Invalidate()
 }
 
 // optimizeSelect optimizes a SELECT statement
@@ -286,9 +365,17 @@ func (opt *QueryOptimizer) buildSelectPlan(stmt *SelectStatement) (*QueryPlan, e
 	var plan *QueryPlan
 	var err error
 
-	// Handle FROM clause
-	if len(stmt.From) > 0 {
-		plan, err = opt.buildFromPlan(stmt.From)
+	// Handle FROM clause. A join places the WHERE conjuncts itself, each as
+	// low in the join tree as the columns it reads allow.
+	where := stmt.Where
+	if len(stmt.From) > 1 || len(stmt.Joins) > 0 {
+		plan, err = opt.buildJoinTree(stmt.From, stmt.Joins, stmt.Where)
+		if err != nil {
+			return nil, err
+		}
+		where = nil
+	} else if len(stmt.From) == 1 {
+		plan, err = opt.buildTablePlan(&stmt.From[0])
 		if err != nil {
 			return nil, err
 		}
@@ -304,13 +391,24 @@ func (opt *QueryOptimizer) buildSelectPlan(stmt *SelectStatement) (*QueryPlan, e
 	}
 
 	// Apply WHERE clause
-	if stmt.Where != nil {
-		plan = opt.addFilterPlan(plan, stmt.Where)
+	if where != nil {
+		plan = opt.addFilterPlan(plan, where)
 	}
 
-	// Apply GROUP BY
+	// Apply GROUP BY, or a plain aggregate when the select list aggregates
+	// without grouping. The aggregate node needs the target list itself
+	// because that is where the aggregate calls live, and its rows are
+	// already projected.
+	projected := false
 	if len(stmt.GroupBy) > 0 {
 		plan = opt.addGroupPlan(plan, stmt.GroupBy, stmt.Having)
+		plan.TargetList = opt.buildTargetList(stmt.Fields)
+		projected = true
+	} else if opt.hasAggregates(stmt.Fields) {
+		plan = opt.addGroupPlan(plan, nil, stmt.Having)
+		plan.Type = PlanTypeAggregate
+		plan.TargetList = opt.buildTargetList(stmt.Fields)
+		projected = true
 	}
 
 	// Apply window functions
@@ -318,9 +416,22 @@ func (opt *QueryOptimizer) buildSelectPlan(stmt *SelectStatement) (*QueryPlan, e
 		plan = opt.addWindowPlan(plan, stmt.Fields)
 	}
 
+	// Apply DISTINCT to the projected rows, so ORDER BY sorts distinct rows
+	// and can only name what the select list produces
+	if stmt.Distinct {
+		if !projected {
+			plan = opt.addResultPlan(plan, stmt.Fields)
+			projected = true
+		}
+		plan = opt.addUniquePlan(plan)
+	}
+
 	// Apply ORDER BY
 	if len(stmt.OrderBy) > 0 {
-		plan = opt.addSortPlan(plan, stmt.OrderBy)
+		plan, err = opt.addSortPlan(plan, stmt.OrderBy, stmt.Fields)
+		if err != nil {
+			return nil, err
+		}
 	}
 
 	// Apply LIMIT/OFFSET
@@ -328,22 +439,18 @@ func (opt *QueryOptimizer) buildSelectPlan(stmt *SelectStatement) (*QueryPlan, e
 		plan = opt.addLimitPlan(plan, stmt.Limit, stmt.Offset)
 	}
 
+	// Project the select list last, so ORDER BY may also use columns it
+	// leaves out
+	if !projected {
+		plan = opt.addResultPlan(plan, stmt.Fields)
+	}
+
 	// Set target list
 	plan.TargetList = opt.buildTargetList(stmt.Fields)
 
 	return plan, nil
 }
 
-// buildFromPlan builds a plan for the FROM clause
-func (opt *QueryOptimizer) buildFromPlan(from []TableReference) (*QueryPlan, error) {
-	if len(from) == 1 {
-		return opt.buildTablePlan(&from[0])
-	}
-
-	// Multiple tables - build join plan
-	return opt.buildJoinPlan(from)
-}
-
 // buildTablePlan builds a plan for a single table
 func (opt *QueryOptimizer) buildTablePlan(table *TableReference) (*QueryPlan, error) {
 	if table.Subquery != nil {
@@ -369,10 +476,21 @@ func (opt *QueryOptimizer) buildTablePlan(table *TableReference) (*QueryPlan, er
 		tableName = table.Schema + "." + table.Name
 	}
 
-	// Get table statistics
+	// Choose between sequential scan and index scan
+	return opt.chooseScanPlan(tableName, opt.tableStatistics(tableName), nil)
+}
+
+// buildJoinPlanDP plans a join of from with no predicates between its
+// relations.
+func (opt *QueryOptimizer) buildJoinPlanDP(from []TableReference) (*QueryPlan, error) {
+	return opt.buildJoinTree(from, nil, nil)
+}
+
+// tableStatistics returns the analyzed statistics of a table, or defaults
+// for a table that has not been analyzed, together with its indexes.
+func (opt *QueryOptimizer) tableStatistics(tableName string) *TableStatistics {
 	stats := opt.stats.GetTableStats(tableName)
 	if stats == nil {
-		// Use default statistics if not available
 		stats = &TableStatistics{
 			TableName:   tableName,
 			RowCount:    1000,
@@ -380,9 +498,20 @@ func (opt *QueryOptimizer) buildTablePlan(table *TableReference) (*QueryPlan, er
 			AvgRowWidth: 100,
 		}
 	}
-
-	// Choose between sequential scan and index scan
-	return opt.chooseScanPlan(tableName, stats, nil)
+	indexes := opt.stats.TableIndexes(tableName)
+	if len(indexes) == 0 {
+		return stats
+	}
+	// Published statistics are shared; add the indexes to a copy.
+	merged := *stats
+	merged.Indexes = make(map[string]*IndexStatistics, len(stats.Indexes)+len(indexes))
+	for name, index := range stats.Indexes {
+		merged.Indexes[name] = index
+	}
+	for _, index := range indexes {
+		merged.Indexes[index.IndexName] = index
+	}
+	return &merged
 }
 
 // chooseScanPlan chooses the best scan plan for a table
@@ -402,20 +531,7 @@ func (opt *QueryOptimizer) chooseScanPlan(tableName string, stats *TableStatisti
 
 	// Index scans
 	if opt.config.EnableIndexScan {
-		for _, indexStats := range stats.Indexes {
-			if opt.canUseIndex(indexStats, quals) {
-				indexPlan := &QueryPlan{
-					Type:      PlanTypeIndexScan,
-					TableName: tableName,
-					IndexName: indexStats.IndexName,
-					PlanRows:  stats.RowCount * indexStats.Selectivity,
-					PlanWidth: int(stats.AvgRowWidth),
-					Qual:      quals,
-				}
-				opt.costIndexScan(indexPlan, stats, indexStats)
-				plans = append(plans, indexPlan)
-			}
-		}
+		plans = append(plans, opt.indexPaths(tableName, stats, quals)...)
 	}
 
 	// Parallel scans
@@ -437,197 +553,6 @@ func (opt *QueryOptimizer) chooseScanPlan(tableName string, stats *TableStatisti
 	return opt.chooseCheapestPlan(plans), nil
 }
 
-// buildJoinPlan builds a join plan for multiple tables
-func (opt *QueryOptimizer) buildJoinPlan(from []TableReference) (*QueryPlan, error) {
-	if len(from) == 2 {
-		return opt.buildTwoWayJoin(&from[0], &from[1])
-	}
-
-	// Multi-way join - use dynamic programming or genetic algorithm
-	if len(from) <= opt.config.GeqoThreshold {
-		return opt.buildJoinPlanDP(from)
-	} else {
-		return opt.buildJoinPlanGEQO(from)
-	}
-}
-
-// buildTwoWayJoin builds a plan for joining two tables
-func (opt *QueryOptimizer) buildTwoWayJoin(left, right *TableReference) (*QueryPlan, error) {
-	leftPlan, err := opt.buildTablePlan(left)
-	if err != nil {
-		return nil, err
-	}
-
-	rightPlan, err := opt.buildTablePlan(right)
-	if err != nil {
-		return nil, err
-	}
-
-	// Generate different join algorithms
-	plans := []*QueryPlan{}
-
-	// Nested loop join
-	nlPlan := &QueryPlan{
-		Type:      PlanTypeNestLoop,
-		LeftTree:  leftPlan,
-		RightTree: rightPlan,
-		JoinType:  InnerJoin,
-	}
-	opt.costNestLoop(nlPlan)
-	plans = append(plans, nlPlan)
-
-	// Hash join
-	if opt.config.EnableHashJoin {
-		hashPlan := &QueryPlan{
-			Type:      PlanTypeHashJoin,
-			LeftTree:  leftPlan,
-			RightTree: rightPlan,
-			JoinType:  InnerJoin,
-		}
-		opt.costHashJoin(hashPlan)
-		plans = append(plans, hashPlan)
-	}
-
-	// Merge join
-	if opt.config.EnableMergeJoin {
-		mergePlan := &QueryPlan{
-			Type:      PlanTypeMergeJoin,
-			LeftTree:  leftPlan,
-			RightTree: rightPlan,
-			JoinType:  InnerJoin,
-		}
-		opt.costMergeJoin(mergePlan)
-		plans = append(plans, mergePlan)
-	}
-
-	return opt.chooseCheapestPlan(plans), nil
-}
-
-// buildJoinPlanDP builds a join plan using dynamic programming
-func (opt *QueryOptimizer) buildJoinPlanDP(from []TableReference) (*QueryPlan, error) {
-	n := len(from)
-	if n <= 1 {
-		return opt.buildTablePlan(&from[0])
-	}
-
-	// DP table: dp[mask] = best plan for tables in mask
-	dp := make(map[int]*JoinPlanInfo)
-
-	// Initialize single table plans
-	for i := 0; i < n; i++ {
-		plan, err := opt.buildTablePlan(&from[i])
-		if err != nil {
-			return nil, err
-		}
-		dp[1<<i] = &JoinPlanInfo{
-			Plan:        plan,
-			Tables:      []int{i},
-			JoinClauses: []Expression{},
-		}
-	}
-
-	// Build plans for increasing subset sizes
-	for size := 2; size <= n; size++ {
-		for mask := 0; mask < (1 << n); mask++ {
-			if opt.popcount(mask) != size {
-				continue
-			}
-
-			var bestPlan *JoinPlanInfo
-			bestCost := math.Inf(1)
-
-			// Try all possible splits
-			for submask := mask; submask > 0; submask = (submask - 1) & mask {
-				if submask == mask || submask == 0 {
-					continue
-				}
-
-				complement := mask ^ submask
-				leftInfo := dp[submask]
-				rightInfo := dp[complement]
-
-				if leftInfo == nil || rightInfo == nil {
-					continue
-				}
-
-				// Find applicable join clauses
-				joinClauses := opt.findJoinClauses(leftInfo.Tables, rightInfo.Tables)
-				if len(joinClauses) == 0 {
-					// No join condition - this would be a cross join
-					continue
-				}
-
-				// Try different join orders and algorithms
-				joinPlans := opt.generateJoinPlans(leftInfo.Plan, rightInfo.Plan, joinClauses)
-
-				for _, joinPlan := range joinPlans {
-					if joinPlan.TotalCost < bestCost {
-						bestCost = joinPlan.TotalCost
-						bestPlan = &JoinPlanInfo{
-							Plan:        joinPlan,
-							Tables:      append(leftInfo.Tables, rightInfo.Tables...),
-							JoinClauses: append(leftInfo.JoinClauses, rightInfo.JoinClauses...),
-						}
-						bestPlan.JoinClauses = append(bestPlan.JoinClauses, joinClauses...)
-					}
-				}
-			}
-
-			dp[mask] = bestPlan
-		}
-	}
-
-	finalPlan := dp[(1<<n)-1]
-	if finalPlan == nil {
-		return nil, fmt.Errorf("failed to generate join plan")
-	}
-
-	return finalPlan.Plan, nil
-}
-
-// JoinPlanInfo contains information about a join plan
-type JoinPlanInfo struct {
-	Plan        *QueryPlan
-	Tables      []int
-	JoinClauses []Expression
-}
-
-// findJoinClauses finds join clauses between two sets of tables
-func (opt *QueryOptimizer) findJoinClauses(leftTables, rightTables []int) []Expression {
-	// This would analyze the WHERE clause to find join conditions
-	// For now, return empty slice
-	return []Expression{}
-}
-
-// generateJoinPlans generates all possible join plans for two sub-plans
-func (opt *QueryOptimizer) generateJoinPlans(left, right *QueryPlan, joinClauses []Expression) []*QueryPlan {
-	plans := []*QueryPlan{}
-
-	// Nested loop join (both orders)
-	nlPlan1 := opt.createNestedLoopJoin(left, right, joinClauses)
-	nlPlan2 := opt.createNestedLoopJoin(right, left, joinClauses)
-	plans = append(plans, nlPlan1, nlPlan2)
-
-	// Hash join (both orders)
-	if opt.config.EnableHashJoin {
-		hashPlan1 := opt.createHashJoin(left, right, joinClauses)
-		hashPlan2 := opt.createHashJoin(right, left, joinClauses)
-		plans = append(plans, hashPlan1, hashPlan2)
-	}
-
-	// Merge join (if inputs can be sorted)
-	if opt.config.EnableMergeJoin {
-		if mergePlan := opt.createMergeJoin(left, right, joinClauses); mergePlan != nil {
-			plans = append(plans, mergePlan)
-		}
-		if mergePlan := opt.createMergeJoin(right, left, joinClauses); mergePlan != nil {
-			plans = append(plans, mergePlan)
-		}
-	}
-
-	return plans
-}
-
 // createNestedLoopJoin creates a nested loop join plan
 func (opt *QueryOptimizer) createNestedLoopJoin(outer, inner *QueryPlan, joinClauses []Expression) *QueryPlan {
 	plan := &QueryPlan{
@@ -654,13 +579,9 @@ func (opt *QueryOptimizer) createHashJoin(outer, inner *QueryPlan, joinClauses [
 	return plan
 }
 
-// createMergeJoin creates a merge join plan
+// createMergeJoin creates a merge join plan; costMergeJoin charges for
+// sorting inputs that are not already in order.
 func (opt *QueryOptimizer) createMergeJoin(left, right *QueryPlan, joinClauses []Expression) *QueryPlan {
-	// Check if inputs are sorted or can be sorted efficiently
-	if !opt.canSortEfficiently(left, joinClauses) || !opt.canSortEfficiently(right, joinClauses) {
-		return nil
-	}
-
 	plan := &QueryPlan{
 		Type:        PlanTypeMergeJoin,
 		LeftTree:    left,
@@ -672,104 +593,6 @@ func (opt *QueryOptimizer) createMergeJoin(left, right *QueryPlan, joinClauses [
 	return plan
 }
 
-// canSortEfficiently checks if a plan can be sorted efficiently
-func (opt *QueryOptimizer) canSortEfficiently(plan *QueryPlan, joinClauses []Expression) bool {
-	// Check if already sorted or if sorting cost is reasonable
-	if opt.isSorted(plan) {
-		return true
-	}
-
-	// Estimate sort cost
-	sortCost := opt.costSort(plan.PlanRows, float64(plan.PlanWidth))
-	return sortCost < plan.TotalCost*0.5 // Sort cost should be less than 50% of plan cost
-}
-
-// buildJoinPlanGEQO builds a join plan using genetic algorithm
-func (opt *QueryOptimizer) buildJoinPlanGEQO(from []TableReference) (*QueryPlan, error) {
-	// Simplified GEQO implementation
-	// In practice, this would use a full genetic algorithm
-
-	// For now, use a greedy approach
-	plans := make([]*QueryPlan, len(from))
-	for i, table := range from {
-		plan, err := opt.buildTablePlan(&table)
-		if err != nil {
-			return nil, err
-		}
-		plans[i] = plan
-	}
-
-	// Greedily join tables
-	for len(plans) > 1 {
-		bestI, bestJ := 0, 1
-		bestCost := math.Inf(1)
-		var bestPlan *QueryPlan
-
-		for i := 0; i < len(plans); i++ {
-			for j := i + 1; j < len(plans); j++ {
-				joinPlan := opt.createJoinPlan(plans[i], plans[j])
-				if joinPlan.TotalCost < bestCost {
-					bestCost = joinPlan.TotalCost
-					bestPlan = joinPlan
-					bestI, bestJ = i, j
-				}
-			}
-		}
-
-		// Replace the two plans with the join plan
-		newPlans := []*QueryPlan{bestPlan}
-		for i := 0; i < len(plans); i++ {
-			if i != bestI && i != bestJ {
-				newPlans = append(newPlans, plans[i])
-			}
-		}
-		plans = newPlans
-	}
-
-	return plans[0], nil
-}
-
-// createJoinPlan creates a join plan between two sub-plans
-func (opt *QueryOptimizer) createJoinPlan(left, right *QueryPlan) *QueryPlan {
-	plans := []*QueryPlan{}
-
-	// Nested loop join
-	nlPlan := &QueryPlan{
-		Type:      PlanTypeNestLoop,
-		LeftTree:  left,
-		RightTree: right,
-		JoinType:  InnerJoin,
-	}
-	opt.costNestLoop(nlPlan)
-	plans = append(plans, nlPlan)
-
-	// Hash join
-	if opt.config.EnableHashJoin {
-		hashPlan := &QueryPlan{
-			Type:      PlanTypeHashJoin,
-			LeftTree:  left,
-			RightTree: right,
-			JoinType:  InnerJoin,
-		}
-		opt.costHashJoin(hashPlan)
-		plans = append(plans, hashPlan)
-	}
-
-	// Merge join
-	if opt.config.EnableMergeJoin {
-		mergePlan := &QueryPlan{
-			Type:      PlanTypeMergeJoin,
-			LeftTree:  left,
-			RightTree: right,
-			JoinType:  InnerJoin,
-		}
-		opt.costMergeJoin(mergePlan)
-		plans = append(plans, mergePlan)
-	}
-
-	return opt.chooseCheapestPlan(plans)
-}
-
 // Cost estimation methods
 
 // costSeqScan estimates the cost of a sequential scan
@@ -790,23 +613,30 @@ func (opt *QueryOptimizer) costSeqScan(plan *QueryPlan, stats *TableStatistics)
 	}
 }
 
-// costIndexScan estimates the cost of an index scan
-func (opt *QueryOptimizer) costIndexScan(plan *QueryPlan, stats *TableStatistics, indexStats *IndexStatistics) {
-	indexPages := indexStats.PageCount
-	tuples := stats.RowCount
-	selectivity := indexStats.Selectivity
-
-	// Index access cost
-	indexCost := opt.config.RandomPageCost*indexPages + opt.config.CPUIndexTupleCost*tuples
-
-	// Heap access cost
-	selectedTuples := tuples * selectivity
-	heapPages := selectedTuples / 100 // Assume 100 tuples per page
-	heapCost := opt.config.RandomPageCost*heapPages + opt.config.CPUTupleCost*selectedTuples
+// costIndexScan estimates the cost of an index scan returning a fraction
+// selectivity of the table: reading the index range and, unless the scan
+// is index-only, the heap. Heap reads are random per row when the table is
+// in no particular order of the leading index column and sequential when
+// it is in that order; the correlation statistic interpolates between the
+// two.
+func (opt *QueryOptimizer) costIndexScan(plan *QueryPlan, stats *TableStatistics, indexStats *IndexStatistics, selectivity float64) {
+	selected := stats.RowCount * selectivity
+	cost := opt.indexAccessCost(stats, indexStats, selectivity)
+	if plan.Type != PlanTypeIndexOnlyScan {
+		pages := math.Max(stats.PageCount, 1)
+		maxIO := opt.config.RandomPageCost * math.Min(selected, pages)
+		minIO := opt.config.RandomPageCost + opt.config.SeqPageCost*math.Max(math.Ceil(selectivity*pages)-1, 0)
+		correlation := 0.0
+		if col := stats.Columns[indexStats.Columns[0]]; col != nil {
+			correlation = col.Correlation
+		}
+		cost += maxIO + correlation*correlation*(minIO-maxIO) + opt.config.CPUTupleCost*selected
+	}
+	cost += opt.config.CPUOperatorCost * selected * float64(len(plan.Qual))
 
 	plan.StartupCost = 0
-	plan.TotalCost = indexCost + heapCost
-	plan.PlanRows = selectedTuples
+	plan.TotalCost = cost
+	plan.PlanRows = selected
 }
 
 // costParallelSeqScan estimates the cost of a parallel sequential scan
@@ -824,6 +654,10 @@ func (opt *QueryOptimizer) costParallelSeqScan(plan *QueryPlan, stats *TableStat
 	plan.StartupCost = coordinationCost
 	plan.TotalCost = scanCost + coordinationCost
 	plan.PlanRows = tuples
+	if len(plan.Qual) > 0 {
+		plan.PlanRows = tuples * opt.estimateSelectivity(plan.Qual, stats)
+		plan.TotalCost += opt.config.CPUOperatorCost * tuples * float64(len(plan.Qual)) / workers
+	}
 }
 
 // costNestLoop estimates the cost of a nested loop join
@@ -835,10 +669,36 @@ func (opt *QueryOptimizer) costNestLoop(plan *QueryPlan) {
 
 	plan.StartupCost = plan.LeftTree.StartupCost + plan.RightTree.StartupCost
 	plan.TotalCost = outerCost + outerRows*innerCost + opt.config.CPUOperatorCost*outerRows*innerRows
-	plan.PlanRows = outerRows * innerRows * 0.1 // Assume 10% join selectivity
+	plan.PlanRows = outerRows * innerRows * opt.estimateJoinSelectivity(plan.JoinClauses)
 	plan.PlanWidth = plan.LeftTree.PlanWidth + plan.RightTree.PlanWidth
 }
 
+// costIndexNestLoop estimates a nested loop whose inner side probes an
+// index once per outer row. plan.PlanRows must already hold the join's
+// output estimate; each probe descends the index and fetches its share of
+// those rows from the heap.
+func (opt *QueryOptimizer) costIndexNestLoop(plan *QueryPlan, stats *TableStatistics, indexStats *IndexStatistics) {
+	outer := plan.LeftTree
+	probes := math.Max(outer.PlanRows, 1)
+	perProbe := plan.PlanRows / probes
+
+	descent := opt.config.CPUOperatorCost * math.Ceil(math.Log2(math.Max(stats.RowCount, 2)))
+	if indexStats.PageCount > float64(opt.config.EffectiveCacheSize)/8 {
+		// An index larger than the cache costs a random read per probe.
+		descent += opt.config.RandomPageCost
+	}
+	heapPages := math.Min(perProbe, math.Max(stats.PageCount, 1))
+	probeCost := descent + opt.config.RandomPageCost*heapPages +
+		(opt.config.CPUIndexTupleCost+opt.config.CPUTupleCost)*perProbe
+
+	plan.RightTree.PlanRows = perProbe
+	plan.RightTree.StartupCost = 0
+	plan.RightTree.TotalCost = probeCost
+	plan.StartupCost = outer.StartupCost
+	plan.TotalCost = outer.TotalCost + probes*probeCost
+	plan.PlanWidth = outer.PlanWidth + plan.RightTree.PlanWidth
+}
+
 // costHashJoin estimates the cost of a hash join
 func (opt *QueryOptimizer) costHashJoin(plan *QueryPlan) {
 	outerCost := plan.LeftTree.TotalCost
@@ -849,34 +709,33 @@ func (opt *QueryOptimizer) costHashJoin(plan *QueryPlan) {
 	// Choose smaller relation for hash table (build side)
 	var buildRows, probeRows float64
 	var buildCost, probeCost float64
+	var buildWidth, probeWidth float64
 
 	if innerRows < outerRows {
-		buildRows = innerRows
-		probeRows = outerRows
-		buildCost = innerCost
-		probeCost = outerCost
+		buildRows, probeRows = innerRows, outerRows
+		buildCost, probeCost = innerCost, outerCost
+		buildWidth, probeWidth = float64(plan.RightTree.PlanWidth), float64(plan.LeftTree.PlanWidth)
 	} else {
-		buildRows = outerRows
-		probeRows = innerRows
-		buildCost = outerCost
-		probeCost = innerCost
+		buildRows, probeRows = outerRows, innerRows
+		buildCost, probeCost = outerCost, innerCost
+		buildWidth, probeWidth = float64(plan.LeftTree.PlanWidth), float64(plan.RightTree.PlanWidth)
 	}
 
 	// Hash table build cost
 	hashBuildCost := buildCost + opt.config.CPUOperatorCost*buildRows
 
 	// Hash table memory requirements
-	hashTableSize := buildRows * float64(plan.RightTree.PlanWidth)
+	hashTableSize := buildRows * buildWidth
 	workMemBytes := float64(opt.config.WorkMem * 1024)
 
 	var memCost float64
-	if hashTableSize <= workMemBytes {
-		// Hash table fits in memory
-		memCost = 0
-	} else {
-		// Hash table doesn't fit - need to spill to disk
-		spillRatio := hashTableSize / workMemBytes
-		memCost = spillRatio * opt.config.SeqPageCost * (buildRows + probeRows)
+	if hashTableSize > workMemBytes {
+		// The partitions that do not fit are written out with their share
+		// of the probe rows and read back once: two page I/Os per spilled
+		// page.
+		spilled := 1 - workMemBytes/hashTableSize
+		spillPages := spilled * (buildRows*buildWidth + probeRows*probeWidth) / 8192
+		memCost = 2 * opt.config.SeqPageCost * spillPages
 	}
 
 	// Hash probe cost
@@ -936,9 +795,13 @@ func (opt *QueryOptimizer) estimateEqualityJoinSelectivity(left, right Expressio
 	rightStats := opt.getColumnStatistics(right)
 
 	if leftStats != nil && rightStats != nil {
-		// Use the larger NDV as the basis for selectivity
+		// Use the larger NDV as the basis for selectivity; NULLs never
+		// join.
 		maxNDV := math.Max(leftStats.NDistinct, rightStats.NDistinct)
-		return 1.0 / maxNDV
+		if maxNDV < 1 {
+			return 0.01
+		}
+		return (1 - leftStats.NullFraction) * (1 - rightStats.NullFraction) / maxNDV
 	}
 
 	// Default equality join selectivity
@@ -948,9 +811,7 @@ func (opt *QueryOptimizer) estimateEqualityJoinSelectivity(left, right Expressio
 // getColumnStatistics retrieves column statistics for an expression
 func (opt *QueryOptimizer) getColumnStatistics(expr Expression) *ColumnStatistics {
 	if ident, ok := expr.(*IdentifierExpression); ok {
-		// Look up column statistics
-		key := ident.Name // Simplified - would need table qualification
-		return opt.stats.columnStats[key]
+		return opt.stats.ColumnStats(ident.Table, ident.Name)
 	}
 	return nil
 }
@@ -976,22 +837,12 @@ func (opt *QueryOptimizer) costMergeJoin(plan *QueryPlan) {
 
 	plan.StartupCost = plan.LeftTree.StartupCost + plan.RightTree.StartupCost + sortCost
 	plan.TotalCost = outerCost + innerCost + sortCost + mergeCost
-	plan.PlanRows = outerRows * innerRows * 0.1 // Assume 10% join selectivity
+	plan.PlanRows = outerRows * innerRows * opt.estimateJoinSelectivity(plan.JoinClauses)
 	plan.PlanWidth = plan.LeftTree.PlanWidth + plan.RightTree.PlanWidth
 }
 
 // Helper methods
 
-// popcount counts the number of set bits
-func (opt *QueryOptimizer) popcount(x int) int {
-	count := 0
-	for x != 0 {
-		count++
-		x &= x - 1
-	}
-	return count
-}
-
 // chooseCheapestPlan chooses the plan with the lowest total cost
 func (opt *QueryOptimizer) chooseCheapestPlan(plans []*QueryPlan) *QueryPlan {
 	if len(plans) == 0 {
@@ -1020,44 +871,17 @@ func (opt *QueryOptimizer) calculateWorkers(rows float64) int {
 	}
 }
 
-// canUseIndex checks if an index can be used for the given qualifiers
-func (opt *QueryOptimizer) canUseIndex(indexStats *IndexStatistics, quals []Expression) bool {
-	if len(quals) == 0 {
-		return false
-	}
-
-	// Simplified check - in practice, this would be much more sophisticated
-	for _, qual := range quals {
-		if binExpr, ok := qual.(*BinaryExpression); ok {
-			if ident, ok := binExpr.Left.(*IdentifierExpression); ok {
-				for _, col := range indexStats.Columns {
-					if strings.EqualFold(ident.Name, col) {
-						return true
-					}
-				}
-			}
-		}
-	}
-	return false
-}
-
 // estimateSelectivity estimates the selectivity of WHERE clauses
 func (opt *QueryOptimizer) estimateSelectivity(quals []Expression, stats *TableStatistics) float64 {
 	if len(quals) == 0 {
 		return 1.0
 	}
-
-	// Simplified selectivity estimation
-	selectivity := 1.0
-	for range quals {
-		selectivity *= 0.1 // Assume each condition filters 90% of rows
-	}
-	return math.Max(selectivity, 0.001) // Minimum selectivity
+	return opt.costModel.Selectivity(quals, stats)
 }
 
 // isSorted checks if a plan produces sorted output
 func (opt *QueryOptimizer) isSorted(plan *QueryPlan) bool {
-	return plan.Type == PlanTypeIndexScan || plan.Type == PlanTypeSort
+	return plan.Type == PlanTypeIndexScan || plan.Type == PlanTypeIndexOnlyScan || plan.Type == PlanTypeSort
 }
 
 // costSort estimates the cost of sorting
@@ -1095,6 +919,15 @@ func (opt *QueryOptimizer) costPlan(plan *QueryPlan) {
 }
 
 func (opt *QueryOptimizer) addFilterPlan(plan *QueryPlan, where Expression) *QueryPlan {
+	switch plan.Type {
+	case PlanTypeSeqScan, PlanTypeIndexScan, PlanTypeIndexOnlyScan,
+		PlanTypeBitmapHeapScan, PlanTypeParallelSeqScan:
+		// Choose the scan again now that its selectivity is known.
+		scan, err := opt.chooseScanPlan(plan.TableName, opt.tableStatistics(plan.TableName), append(plan.Qual, where))
+		if err == nil && scan != nil {
+			return scan
+		}
+	}
 	plan.Qual = append(plan.Qual, where)
 	return plan
 }
@@ -1111,6 +944,45 @@ func (opt *QueryOptimizer) addGroupPlan(plan *QueryPlan, groupBy []Expression, h
 	return groupPlan
 }
 
+// addResultPlan projects the select list. A bare * needs no projection.
+func (opt *QueryOptimizer) addResultPlan(plan *QueryPlan, fields []SelectField) *QueryPlan {
+	if len(fields) == 1 {
+		if ident, ok := fields[0].Expression.(*IdentifierExpression); ok && ident.Name == "*" && ident.Table == "" {
+			return plan
+		}
+	}
+	return &QueryPlan{
+		Type:        PlanTypeResult,
+		LeftTree:    plan,
+		TargetList:  opt.buildTargetList(fields),
+		StartupCost: plan.StartupCost,
+		TotalCost:   plan.TotalCost + plan.PlanRows*opt.config.CPUTupleCost,
+		PlanRows:    plan.PlanRows,
+		PlanWidth:   plan.PlanWidth,
+	}
+}
+
+// addUniquePlan removes duplicate rows for SELECT DISTINCT.
+func (opt *QueryOptimizer) addUniquePlan(plan *QueryPlan) *QueryPlan {
+	return &QueryPlan{
+		Type:        PlanTypeUnique,
+		LeftTree:    plan,
+		StartupCost: plan.StartupCost,
+		TotalCost:   plan.TotalCost + plan.PlanRows*opt.config.CPUOperatorCost,
+		PlanRows:    plan.PlanRows,
+		PlanWidth:   plan.PlanWidth,
+	}
+}
+
+func (opt *QueryOptimizer) hasAggregates(fields []SelectField) bool {
+	for _, field := range fields {
+		if containsAggregate(field.Expression) {
+			return true
+		}
+	}
+	return false
+}
+
 func (opt *QueryOptimizer) hasWindowFunctions(fields []SelectField) bool {
 	return false // Simplified
 }
@@ -1119,21 +991,61 @@ func (opt *QueryOptimizer) addWindowPlan(plan *QueryPlan, fields []SelectField)
 	return plan // Simplified
 }
 
-func (opt *QueryOptimizer) addSortPlan(plan *QueryPlan, orderBy []OrderByClause) *QueryPlan {
+// addSortPlan resolves ORDER BY positions and output column aliases to the
+// select list expressions they name. Everything else is resolved against
+// the sort input when the sort operator opens.
+func (opt *QueryOptimizer) addSortPlan(plan *QueryPlan, orderBy []OrderByClause, fields []SelectField) (*QueryPlan, error) {
 	sortPlan := &QueryPlan{
 		Type:     PlanTypeSort,
 		LeftTree: plan,
 	}
+	star := false
+	for _, field := range fields {
+		if ident, ok := field.Expression.(*IdentifierExpression); ok && ident.Name == "*" {
+			star = true
+		}
+	}
 	for _, clause := range orderBy {
-		if ident, ok := clause.Expression.(*IdentifierExpression); ok {
-			sortPlan.SortKeys = append(sortPlan.SortKeys, SortKey{
-				Column:     ident.Name,
-				Direction:  clause.Direction,
-				NullsFirst: clause.NullsFirst,
-			})
+		key := SortKey{
+			Expression: clause.Expression,
+			Direction:  clause.Direction,
+			NullsFirst: clause.NullsFirst,
+		}
+		switch e := clause.Expression.(type) {
+		case *LiteralExpression:
+			if e.Type != LiteralInteger {
+				break
+			}
+			pos, _ := e.Value.(int64)
+			switch {
+			case star:
+				// The select list expands to the input columns
+				if pos < 1 {
+					return nil, fmt.Errorf("ORDER BY position %d is not in select list", pos)
+				}
+				key.Ordinal, key.Expression = int(pos), nil
+			case pos >= 1 && pos <= int64(len(fields)):
+				key.Expression = fields[pos-1].Expression
+			default:
+				return nil, fmt.Errorf("ORDER BY position %d is not in select list", pos)
+			}
+		case *IdentifierExpression:
+			if e.Table != "" {
+				break
+			}
+			for _, field := range fields {
+				if field.Alias != "" && strings.EqualFold(field.Alias, e.Name) {
+					key.Expression = field.Expression
+					break
+				}
+			}
+		}
+		if ident, ok := key.Expression.(*IdentifierExpression); ok {
+			key.Column = ident.Name
 		}
+		sortPlan.SortKeys = append(sortPlan.SortKeys, key)
 	}
-	return sortPlan
+	return sortPlan, nil
 }
 
 func (opt *QueryOptimizer) addLimitPlan(plan *QueryPlan, limit *LimitClause, offset *OffsetClause) *QueryPlan {
@@ -1144,13 +1056,8 @@ func (opt *QueryOptimizer) addLimitPlan(plan *QueryPlan, limit *LimitClause, off
 	if limit != nil {
 		limitPlan.Limit = &LimitClause{Count: limit.Count}
 	}
-	// Handle offset - convert to limit structure for internal representation
 	if offset != nil {
-		if limitPlan.Limit == nil {
-			limitPlan.Limit = &LimitClause{}
-		}
-		// Store offset information in plan metadata or extend LimitClause
-		// For now, we'll add offset handling to the plan structure
+		limitPlan.Offset = &OffsetClause{Count: offset.Count}
 	}
 	return limitPlan
 }
@@ -1170,12 +1077,125 @@ func (opt *QueryOptimizer) buildTargetList(fields []SelectField) []TargetEntry {
 
 // GetTableStats returns statistics for a table
 func (sc *StatisticsCollector) GetTableStats(tableName string) *TableStatistics {
+	sc.mu.RLock()
+	defer sc.mu.RUnlock()
 	return sc.tableStats[tableName]
 }
 
-// UpdateTableStats updates statistics for a table
+// UpdateTableStats updates statistics for a table. The statistics are
+// published as they are and must not be modified afterwards.
 func (sc *StatisticsCollector) UpdateTableStats(stats *TableStatistics) {
+	sc.mu.Lock()
+	for key, col := range sc.columnStats {
+		if col.TableName == stats.TableName {
+			delete(sc.columnStats, key)
+		}
+	}
+	for name, col := range stats.Columns {
+		sc.columnStats[stats.TableName+"."+name] = col
+	}
 	sc.tableStats[stats.TableName] = stats
+	delete(sc.modifications, stats.TableName)
+	sc.mu.Unlock()
+
+	if sc.onUpdate != nil {
+		sc.onUpdate()
+	}
+}
+
+// UpdateIndexStats records the statistics of an index, replacing any
+// earlier ones under the same name.
+func (sc *StatisticsCollector) UpdateIndexStats(stats *IndexStatistics) {
+	sc.mu.Lock()
+	sc.indexStats[stats.IndexName] = stats
+	sc.mu.Unlock()
+
+	if sc.onUpdate != nil {
+		sc.onUpdate()
+	}
+}
+
+// DropIndexStats forgets the statistics of a dropped index.
+func (sc *StatisticsCollector) DropIndexStats(indexName string) {
+	sc.mu.Lock()
+	delete(sc.indexStats, indexName)
+	sc.mu.Unlock()
+
+	if sc.onUpdate != nil {
+		sc.onUpdate()
+	}
+}
+
+// TableIndexes returns the statistics of a table's indexes.
+func (sc *StatisticsCollector) TableIndexes(tableName string) []*IndexStatistics {
+	sc.mu.RLock()
+	defer sc.mu.RUnlock()
+	var indexes []*IndexStatistics
+	for _, index := range sc.indexStats {
+		if index.TableName == tableName {
+			indexes = append(indexes, index)
+		}
+	}
+	return indexes
+}
+
+// ColumnStats returns the statistics of a column. An empty table name
+// matches the column in any analyzed table, as long as only one has it.
+func (sc *StatisticsCollector) ColumnStats(tableName, columnName string) *ColumnStatistics {
+	sc.mu.RLock()
+	defer sc.mu.RUnlock()
+	if tableName != "" {
+		return sc.columnStats[tableName+"."+columnName]
+	}
+	var found *ColumnStatistics
+	for _, stats := range sc.tableStats {
+		if col := stats.Columns[columnName]; col != nil {
+			if found != nil {
+				return nil
+			}
+			found = col
+		}
+	}
+	return found
+}
+
+// Tables returns the tables that have statistics or recorded changes.
+func (sc *StatisticsCollector) Tables() []string {
+	sc.mu.RLock()
+	defer sc.mu.RUnlock()
+	seen := make(map[string]bool, len(sc.tableStats)+len(sc.modifications))
+	var tables []string
+	for name := range sc.tableStats {
+		seen[name] = true
+		tables = append(tables, name)
+	}
+	for name := range sc.modifications {
+		if !seen[name] {
+			tables = append(tables, name)
+		}
+	}
+	sort.Strings(tables)
+	return tables
+}
+
+// NoteModifications records rows changed in a table and reports whether
+// the table has now changed enough since it was last analyzed to be
+// analyzed again. It reports true once per crossing.
+func (sc *StatisticsCollector) NoteModifications(tableName string, rows int64, config *AnalyzeConfig) bool {
+	if config == nil || (config.AutoAnalyzeThreshold == 0 && config.AutoAnalyzeScaleFactor == 0) {
+		return false
+	}
+	sc.mu.Lock()
+	defer sc.mu.Unlock()
+
+	var tableRows float64
+	if stats := sc.tableStats[tableName]; stats != nil {
+		tableRows = stats.RowCount
+	}
+	threshold := float64(config.AutoAnalyzeThreshold) + config.AutoAnalyzeScaleFactor*tableRows
+	before := sc.modifications[tableName]
+	sc.modifications[tableName] = before + rows
+	return float64(before) < threshold && float64(before+rows) >= threshold
 }
 
 // CollectStats collects statistics for all tables
@@ -1184,10 +1204,15 @@ func (sc *StatisticsCollector) CollectStats() error {
 	return nil
 }
 
-// PlanCache caches optimized query plans
+// PlanCache caches optimized query plans. Invalidate bumps a version
+// instead of walking the map; stale entries are dropped when next looked
+// up, and a plan that was being built across an invalidation is never
+// stored.
 type PlanCache struct {
+	mu      sync.Mutex
 	cache   map[string]*CachedPlan
 	maxSize int
+	version uint64
 	hits    int64
 	misses  int64
 }
@@ -1195,10 +1220,12 @@ type PlanCache struct {
 // CachedPlan represents a cached query plan
 type CachedPlan struct {
 	Plan      *QueryPlan
+	Statement Statement
 	QueryHash string
 	CreatedAt int64
 	HitCount  int64
 	LastUsed  int64
+	version   uint64
 }
 
 // NewPlanCache creates a new plan cache
@@ -1211,29 +1238,66 @@ func NewPlanCache(maxSize int) *PlanCache {
 
 // Get retrieves a cached plan
 func (pc *PlanCache) Get(queryHash string) (*QueryPlan, bool) {
-	if cached, exists := pc.cache[queryHash]; exists {
-		cached.HitCount++
-		cached.LastUsed = getCurrentTimestamp()
-		pc.hits++
+	if cached, ok := pc.Entry(queryHash); ok {
 		return cached.Plan, true
 	}
+	return nil, false
+}
+
+// Entry retrieves a cached plan and the statement it was built from.
+func (pc *PlanCache) Entry(queryHash string) (*CachedPlan, bool) {
+	pc.mu.Lock()
+	defer pc.mu.Unlock()
+
+	if cached, exists := pc.cache[queryHash]; exists {
+		if cached.version == pc.version {
+			cached.HitCount++
+			cached.LastUsed = getCurrentTimestamp()
+			pc.hits++
+			return cached, true
+		}
+		delete(pc.cache, queryHash)
+	}
 	pc.misses++
 	return nil, false
 }
 
 // Put stores a plan in the cache
 func (pc *PlanCache) Put(queryHash string, plan *QueryPlan) {
-	if len(pc.cache) >= pc.maxSize {
+	pc.PutEntry(&CachedPlan{Plan: plan, QueryHash: queryHash}, pc.Version())
+}
+
+// PutEntry stores entry if the cache is still at version, the value of
+// Version read before the plan was built.
+func (pc *PlanCache) PutEntry(entry *CachedPlan, version uint64) {
+	pc.mu.Lock()
+	defer pc.mu.Unlock()
+
+	if version != pc.version {
+		return
+	}
+	if _, exists := pc.cache[entry.QueryHash]; !exists && len(pc.cache) >= pc.maxSize {
 		pc.evictLRU()
 	}
 
-	pc.cache[queryHash] = &CachedPlan{
-		Plan:      plan,
-		QueryHash: queryHash,
-		CreatedAt: getCurrentTimestamp(),
-		HitCount:  0,
-		LastUsed:  getCurrentTimestamp(),
-	}
+	entry.CreatedAt = getCurrentTimestamp()
+	entry.LastUsed = entry.CreatedAt
+	entry.version = version
+	pc.cache[entry.QueryHash] = entry
+}
+
+// Version returns the current invalidation epoch.
+func (pc *PlanCache) Version() uint64 {
+	pc.mu.Lock()
+	defer pc.mu.Unlock()
+	return pc.version
+}
+
+// Invalidate marks every cached plan stale.
+func (pc *PlanCache) Invalidate() {
+	pc.mu.Lock()
+	pc.version++
+	pc.mu.Unlock()
 }
 
 // evictLRU evicts the least recently used plan
@@ -1242,6 +1306,10 @@ func (pc *PlanCache) evictLRU() {
 	var oldestTime int64 = math.MaxInt64
 
 	for key, cached := range pc.cache {
+		if cached.version != pc.version {
+			delete(pc.cache, key)
+			return
+		}
 		if cached.LastUsed < oldestTime {
 			oldestTime = cached.LastUsed
 			oldestKey = key
@@ -1255,6 +1323,8 @@ func (pc *PlanCache) evictLRU() {
 
 // GetStats returns cache statistics
 func (pc *PlanCache) GetStats() (hits, misses int64, hitRatio float64) {
+	pc.mu.Lock()
+	defer pc.mu.Unlock()
 	total := pc.hits + pc.misses
 	if total == 0 {
 		return pc.hits, pc.misses, 0.0
@@ -2,6 +2,8 @@ package sql
 
 import (
 	"fmt"
+	"math"
+	"sort"
 	"testing"
 )
 
@@ -29,6 +31,7 @@ func TestQueryOptimizer(t *testing.T) {
 			t.Fatal("Expected non-nil plan")
 		}
 
+		plan = projectedInput(t, plan, 2)
 		if plan.Type != PlanTypeSeqScan {
 			t.Errorf("Expected sequential scan, got %v", plan.Type)
 		}
@@ -55,6 +58,7 @@ func TestQueryOptimizer(t *testing.T) {
 			t.Fatalf("Failed to optimize query: %v", err)
 		}
 
+		plan = projectedInput(t, plan, 1)
 		if len(plan.Qual) == 0 {
 			t.Error("Expected WHERE clause in plan qualifiers")
 		}
@@ -84,6 +88,7 @@ func TestQueryOptimizer(t *testing.T) {
 		}
 
 		// Should generate a join plan
+		plan = projectedInput(t, plan, 2)
 		if plan.Type != PlanTypeNestLoop && plan.Type != PlanTypeHashJoin && plan.Type != PlanTypeMergeJoin {
 			t.Errorf("Expected join plan, got %v", plan.Type)
 		}
@@ -405,6 +410,16 @@ func TestMemoryConstrainedHashJoin(t *testing.T) {
 
 // Helper functions for tests
 
+// projectedInput checks that plan projects a select list of n entries and
+// returns the plan beneath the projection.
+func projectedInput(t *testing.T, plan *QueryPlan, n int) *QueryPlan {
+	t.Helper()
+	if plan.Type != PlanTypeResult || len(plan.TargetList) != n || plan.LeftTree == nil {
+		t.Fatalf("Expected a Result node projecting %d columns, got %v with %d", n, plan.Type, len(plan.TargetList))
+	}
+	return plan.LeftTree
+}
+
 func hasSortNode(plan *QueryPlan) bool {
 	if plan == nil {
 		return false
@@ -477,3 +492,157 @@ func BenchmarkPlanCache(b *testing.B) {
 		cache.Get(key)
 	}
 }
+
+// setJoinStats records analyzed statistics for a table whose columns have
+// the given distinct counts.
+func setJoinStats(opt *QueryOptimizer, table string, rows float64, ndistinct map[string]float64, indexes ...*IndexStatistics) {
+	stats := &TableStatistics{
+		TableName:   table,
+		RowCount:    rows,
+		PageCount:   math.Ceil(rows / 100),
+		AvgRowWidth: 50,
+		Columns:     make(map[string]*ColumnStatistics),
+		Indexes:     make(map[string]*IndexStatistics),
+	}
+	for col, n := range ndistinct {
+		stats.Columns[col] = &ColumnStatistics{TableName: table, ColumnName: col, NDistinct: n}
+	}
+	for _, index := range indexes {
+		stats.Indexes[index.IndexName] = index
+	}
+	opt.stats.UpdateTableStats(stats)
+}
+
+// planTables lists the tables scanned beneath plan.
+func planTables(plan *QueryPlan) []string {
+	if plan == nil {
+		return nil
+	}
+	if plan.LeftTree == nil && plan.RightTree == nil {
+		return []string{plan.TableName}
+	}
+	tables := append(planTables(plan.LeftTree), planTables(plan.RightTree)...)
+	sort.Strings(tables)
+	return tables
+}
+
+// findScan returns the scan of table beneath plan.
+func findScan(plan *QueryPlan, table string) *QueryPlan {
+	if plan == nil {
+		return nil
+	}
+	if plan.LeftTree == nil && plan.RightTree == nil && plan.TableName == table {
+		return plan
+	}
+	if scan := findScan(plan.LeftTree, table); scan != nil {
+		return scan
+	}
+	return findScan(plan.RightTree, table)
+}
+
+func optimizeSQL(t *testing.T, opt *QueryOptimizer, query string) *QueryPlan {
+	t.Helper()
+	stmt, err := ParseSQL(query)
+	if err != nil {
+		t.Fatalf("parse %q: %v", query, err)
+	}
+	plan, err := opt.OptimizeQuery(stmt)
+	if err != nil {
+		t.Fatalf("optimize %q: %v", query, err)
+	}
+	return plan
+}
+
+func chainStats(opt *QueryOptimizer) {
+	setJoinStats(opt, "fact", 1e6, map[string]float64{"mid_id": 1e5})
+	setJoinStats(opt, "mid", 1e5, map[string]float64{"id": 1e5, "dim_id": 100})
+	setJoinStats(opt, "dim", 100, map[string]float64{"id": 100, "name": 100})
+}
+
+func TestJoinOrderIgnoresTextualOrder(t *testing.T) {
+	opt := NewQueryOptimizer()
+	chainStats(opt)
+
+	// Written fact-first, the selective dimension filter should still be
+	// joined before the fact table is touched.
+	plan := optimizeSQL(t, opt, `SELECT * FROM fact f
+		JOIN mid m ON f.mid_id = m.id
+		JOIN dim d ON m.dim_id = d.id
+		WHERE d.name = 'x'`)
+	if !isJoinPlan(plan) {
+		t.Fatalf("expected a join at the root, got %v", plan.Type)
+	}
+	left, right := planTables(plan.LeftTree), planTables(plan.RightTree)
+	if fmt.Sprint(left) != "[fact]" && fmt.Sprint(right) != "[fact]" {
+		t.Errorf("expected fact to be joined last, got %v and %v", left, right)
+	}
+	if dim := findScan(plan, "dim"); dim == nil || len(dim.Qual) != 1 {
+		t.Errorf("expected the filter on dim to be pushed into its scan, got %+v", dim)
+	}
+	if len(plan.Qual) != 0 {
+		t.Errorf("expected no filter above the joins, got %v", plan.Qual)
+	}
+	if plan.PlanRows > 2e4 {
+		t.Errorf("estimated %v rows, want about 1e4", plan.PlanRows)
+	}
+
+	// The greedy fallback finds the same shape.
+	opt.config.GeqoThreshold = 2
+	greedy := optimizeSQL(t, opt, `SELECT * FROM fact f, mid m, dim d
+		WHERE f.mid_id = m.id AND m.dim_id = d.id AND d.name = 'x'`)
+	if fmt.Sprint(planTables(greedy)) != "[dim fact mid]" {
+		t.Fatalf("greedy plan scans %v", planTables(greedy))
+	}
+	if greedy.TotalCost > plan.TotalCost*1.01 {
+		t.Errorf("greedy plan costs %.0f, exhaustive plan %.0f", greedy.TotalCost, plan.TotalCost)
+	}
+}
+
+func TestJoinChoosesIndexNestedLoop(t *testing.T) {
+	opt := NewQueryOptimizer()
+	setJoinStats(opt, "dim", 1e5, map[string]float64{"id": 1e5, "name": 1e5})
+	setJoinStats(opt, "orders", 1e6, map[string]float64{"dim_id": 1e5},
+		&IndexStatistics{IndexName: "orders_dim_id", TableName: "orders", Columns: []string{"dim_id"}, PageCount: 3000, RowCount: 1e6})
+
+	plan := optimizeSQL(t, opt, "SELECT * FROM orders o, dim d WHERE o.dim_id = d.id AND d.name = 'x'")
+	if plan.Type != PlanTypeNestLoop || plan.RightTree.Type != PlanTypeIndexScan {
+		t.Fatalf("expected an index nested loop, got %v over %v", plan.Type, plan.RightTree.Type)
+	}
+	key := plan.RightTree.ScanKeys
+	if len(key) != 1 || key[0].Column != "dim_id" || key[0].Value.String() != "d.id" {
+		t.Errorf("unexpected probe key %+v", key)
+	}
+
+	// Without the filter every order joins, and one pass over each table
+	// beats a million probes.
+	plan = optimizeSQL(t, opt, "SELECT * FROM orders o, dim d WHERE o.dim_id = d.id")
+	if plan.Type != PlanTypeHashJoin {
+		t.Errorf("expected a hash join for the unfiltered join, got %v", plan.Type)
+	}
+}
+
+func TestOuterJoinKeepsNullablePredicatesAbove(t *testing.T) {
+	opt := NewQueryOptimizer()
+	chainStats(opt)
+
+	plan := optimizeSQL(t, opt, `SELECT * FROM mid m
+		LEFT JOIN dim d ON m.dim_id = d.id AND d.name = 'x'
+		WHERE d.id IS NULL AND m.id > 5`)
+	if plan.JoinType != LeftJoin {
+		t.Fatalf("expected the left join at the root, got %v", plan.JoinType)
+	}
+	if fmt.Sprint(planTables(plan.LeftTree)) != "[mid]" {
+		t.Errorf("left join inputs were reordered: %v", planTables(plan.LeftTree))
+	}
+	// ON restricts the nullable side, WHERE m.id restricts the preserved
+	// side; both go into scans. WHERE d.id must wait for the join.
+	if dim := findScan(plan, "dim"); dim == nil || len(dim.Qual) != 1 || dim.Qual[0].String() == "" {
+		t.Errorf("expected d.name in the dim scan, got %+v", dim)
+	}
+	if mid := findScan(plan, "mid"); mid == nil || len(mid.Qual) != 1 {
+		t.Errorf("expected m.id in the mid scan, got %+v", mid)
+	}
+	if len(plan.Qual) != 1 {
+		t.Errorf("expected d.id IS NULL above the join, got %v", plan.Qual)
+	}
+}
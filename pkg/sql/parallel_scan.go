@@ -0,0 +1,578 @@
+package sql
+
+import (
+	"bytes"
+	"context"
+	"encoding/binary"
+	"fmt"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+const (
+	// morselRows is how many rows a worker reads from a key range before it
+	// splits the rest of the range so idle workers can steal part of it.
+	morselRows = 4096
+	// documentPageRows is the page size of document morsels.
+	documentPageRows = 4096
+)
+
+// ScanSplit is a morsel: a piece of a table that one worker can scan
+// independently of every other piece.
+type ScanSplit interface {
+	String() string
+}
+
+// KeyRangeSplit covers the keys in [Start, End).
+type KeyRangeSplit struct {
+	Start, End []byte
+}
+
+func (s KeyRangeSplit) String() string { return fmt.Sprintf("keys [%q, %q)", s.Start, s.End) }
+
+// DocumentPageSplit covers one page of a collection, read with the Offset
+// and Limit of DocumentQuery.
+type DocumentPageSplit struct {
+	Offset, Limit int
+}
+
+func (s DocumentPageSplit) String() string {
+	return fmt.Sprintf("documents [%d, %d)", s.Offset, s.Offset+s.Limit)
+}
+
+// RowGroupSplit covers one row group of a columnar table.
+type RowGroupSplit struct {
+	ID int64
+}
+
+func (s RowGroupSplit) String() string { return fmt.Sprintf("row group %d", s.ID) }
+
+// RowGroupLister is implemented by columnar engines that can report how many
+// row groups a table has. Tables in other engines are scanned by a single
+// worker.
+type RowGroupLister interface {
+	RowGroupCount(ctx context.Context, table string) (int64, error)
+}
+
+// Splits divides the table's key range into up to n ranges of equal key
+// space. Key space is rarely uniform, so scans split ranges further as they
+// discover how dense they are.
+func (adapter *KVStorageAdapter) Splits(tableName string, n int) []ScanSplit {
+	return splitKeyRange([]byte(tableName+"/"), []byte(tableName+"/~"), n)
+}
+
+// PageSplit returns the i-th page of a collection.
+func (adapter *DocumentStorageAdapter) PageSplit(i int64) DocumentPageSplit {
+	return DocumentPageSplit{Offset: int(i) * documentPageRows, Limit: documentPageRows}
+}
+
+// Splits returns one split per row group, or nil when the engine cannot
+// list its row groups.
+func (adapter *ColumnarStorageAdapter) Splits(ctx context.Context, tableName string) ([]ScanSplit, error) {
+	lister, ok := adapter.store.(RowGroupLister)
+	if !ok {
+		return nil, nil
+	}
+	count, err := lister.RowGroupCount(ctx, tableName)
+	if err != nil {
+		return nil, fmt.Errorf("failed to list row groups of %s: %w", tableName, err)
+	}
+	splits := make([]ScanSplit, count)
+	for i := range splits {
+		splits[i] = RowGroupSplit{ID: int64(i)}
+	}
+	return splits, nil
+}
+
+// splitKeyRange cuts [start, end) into up to n ranges by interpolating the
+// eight bytes that follow the common prefix of start and end.
+func splitKeyRange(start, end []byte, n int) []ScanSplit {
+	whole := []ScanSplit{KeyRangeSplit{Start: start, End: end}}
+	if n <= 1 {
+		return whole
+	}
+	p := commonPrefixLen(start, end)
+	a, b := keyTail(start, p), keyTail(end, p)
+	if b <= a || b-a < uint64(n) {
+		return whole
+	}
+
+	step := (b - a) / uint64(n)
+	splits := make([]ScanSplit, 0, n)
+	lo := start
+	for i := 1; i < n; i++ {
+		hi := keyAt(start[:p], a+step*uint64(i))
+		splits = append(splits, KeyRangeSplit{Start: lo, End: hi})
+		lo = hi
+	}
+	return append(splits, KeyRangeSplit{Start: lo, End: end})
+}
+
+// strideBounds returns up to n increasing keys below end, spaced by the key
+// distance from first to last. A scan that read a morsel's worth of rows
+// between first and last expects about as many rows between each bound.
+func strideBounds(first, last, end []byte, n int) [][]byte {
+	p := commonPrefixLen(first, end)
+	f, l, e := keyTail(first, p), keyTail(last, p), keyTail(end, p)
+	if l < f || l >= e {
+		return nil
+	}
+	stride := l - f
+	if stride == 0 {
+		stride = 1
+	}
+	var bounds [][]byte
+	for k := uint64(1); k <= uint64(n); k++ {
+		if stride > (e-l)/k {
+			break
+		}
+		b := l + stride*k
+		if b >= e {
+			break
+		}
+		bounds = append(bounds, keyAt(first[:p], b))
+	}
+	return bounds
+}
+
+func commonPrefixLen(a, b []byte) int {
+	p := 0
+	for p < len(a) && p < len(b) && a[p] == b[p] {
+		p++
+	}
+	return p
+}
+
+// keyTail reads the eight bytes of key after its first p bytes as a
+// big-endian number, padding short keys with zeros.
+func keyTail(key []byte, p int) uint64 {
+	var tail [8]byte
+	copy(tail[:], key[p:])
+	return binary.BigEndian.Uint64(tail[:])
+}
+
+// keyAt is the inverse of keyTail. Trailing zero bytes are dropped, which
+// keeps the key strictly between the same neighbours.
+func keyAt(prefix []byte, v uint64) []byte {
+	var tail [8]byte
+	binary.BigEndian.PutUint64(tail[:], v)
+	key := append(make([]byte, 0, len(prefix)+8), prefix...)
+	return append(key, bytes.TrimRight(tail[:], "\x00")...)
+}
+
+// morselQueue hands morsels to workers. Each worker has its own deque and
+// takes from its tail; a worker whose deque is empty steals from the head
+// of another's, and only then asks refill for a freshly generated morsel.
+// While any worker is still scanning it may split its morsel and push the
+// pieces, so idle workers wait for that rather than exit.
+type morselQueue struct {
+	deques []morselDeque
+	refill func() (ScanSplit, bool)
+	busy   atomic.Int32
+}
+
+type morselDeque struct {
+	mu    sync.Mutex
+	items []ScanSplit
+}
+
+func newMorselQueue(workers int, splits []ScanSplit, refill func() (ScanSplit, bool)) *morselQueue {
+	q := &morselQueue{deques: make([]morselDeque, workers), refill: refill}
+	for i, s := range splits {
+		d := &q.deques[i%workers]
+		d.items = append(d.items, s)
+	}
+	return q
+}
+
+func (q *morselQueue) push(worker int, s ScanSplit) {
+	d := &q.deques[worker]
+	d.mu.Lock()
+	d.items = append(d.items, s)
+	d.mu.Unlock()
+}
+
+// next returns the worker's next morsel, or false once every deque is empty
+// and no other worker is scanning. Every morsel returned must be released
+// with done.
+func (q *morselQueue) next(ctx context.Context, worker int) (ScanSplit, bool) {
+	for ctx.Err() == nil {
+		if s, ok := q.take(worker); ok {
+			q.busy.Add(1)
+			return s, true
+		}
+		if q.busy.Load() == 0 {
+			return nil, false
+		}
+		time.Sleep(50 * time.Microsecond)
+	}
+	return nil, false
+}
+
+func (q *morselQueue) done() { q.busy.Add(-1) }
+
+func (q *morselQueue) take(worker int) (ScanSplit, bool) {
+	d := &q.deques[worker]
+	d.mu.Lock()
+	if n := len(d.items); n > 0 {
+		s := d.items[n-1]
+		d.items = d.items[:n-1]
+		d.mu.Unlock()
+		return s, true
+	}
+	d.mu.Unlock()
+
+	for i := 1; i < len(q.deques); i++ {
+		victim := &q.deques[(worker+i)%len(q.deques)]
+		victim.mu.Lock()
+		if len(victim.items) > 0 {
+			s := victim.items[0]
+			victim.items = victim.items[1:]
+			victim.mu.Unlock()
+			return s, true
+		}
+		victim.mu.Unlock()
+	}
+
+	if q.refill != nil {
+		return q.refill()
+	}
+	return nil, false
+}
+
+// documentPager generates page morsels until a page comes back short.
+type documentPager struct {
+	adapter   *DocumentStorageAdapter
+	next      atomic.Int64
+	exhausted atomic.Bool
+}
+
+func (p *documentPager) nextSplit() (ScanSplit, bool) {
+	if p.exhausted.Load() {
+		return nil, false
+	}
+	return p.adapter.PageSplit(p.next.Add(1) - 1), true
+}
+
+// gatherOperator runs a table scan on a pool of workers and streams their
+// batches to a single consumer, in no particular order. Workers pull morsels
+// from a morselQueue, so a fast worker keeps stealing work instead of idling
+// while a slow one finishes a fixed share.
+type gatherOperator struct {
+	executor  *QueryExecutor
+	plan      *QueryPlan
+	columns   []ColumnInfo
+	colIndex  map[string]int
+	workers   int
+	batchSize int
+
+	ctx     *ExecutionContext
+	queue   *morselQueue
+	pager   *documentPager
+	results chan scanResult
+	cancel  context.CancelFunc
+	wg      sync.WaitGroup
+}
+
+// scanResult carries a batch and the scan statistics behind it; workers
+// never touch the shared ExecutionStats.
+type scanResult struct {
+	batch *RowBatch
+	rows  int64
+	bytes int64
+	err   error
+}
+
+// newParallelScanOperator returns a gather over plan's table, or a plain
+// scan when parallelism is disabled or the table cannot be split.
+func (qe *QueryExecutor) newParallelScanOperator(plan *QueryPlan) (Operator, error) {
+	workers := plan.Workers
+	if workers <= 0 || workers > qe.config.MaxWorkers {
+		workers = qe.config.MaxWorkers
+	}
+	if !qe.config.EnableParallel || workers <= 1 {
+		return qe.newScanOperator(plan)
+	}
+	columns := qe.getTableColumns(plan.TableName)
+	return &gatherOperator{
+		executor:  qe,
+		plan:      plan,
+		columns:   columns,
+		colIndex:  columnIndexMap(columns),
+		workers:   workers,
+		batchSize: qe.config.BatchSize,
+	}, nil
+}
+
+func (g *gatherOperator) Open(ctx *ExecutionContext) error {
+	g.ctx = ctx
+	sm := g.executor.storageManager
+	var splits []ScanSplit
+	var refill func() (ScanSplit, bool)
+	switch g.executor.getStorageType(g.plan.TableName) {
+	case StorageTypeKV:
+		if sm.kvStore == nil {
+			return fmt.Errorf("KV storage engine not configured")
+		}
+		splits = sm.kvAdapter.Splits(g.plan.TableName, g.workers)
+	case StorageTypeDocument:
+		if sm.docStore == nil {
+			return fmt.Errorf("document storage engine not configured")
+		}
+		g.pager = &documentPager{adapter: sm.docAdapter}
+		refill = g.pager.nextSplit
+	case StorageTypeColumnar:
+		if sm.columnarStore == nil {
+			return fmt.Errorf("columnar storage engine not configured")
+		}
+		var err error
+		if splits, err = sm.columnarAdapter.Splits(ctx.Context, g.plan.TableName); err != nil {
+			return err
+		}
+		if splits == nil {
+			// The whole table as one morsel.
+			splits = []ScanSplit{nil}
+		}
+	}
+	g.queue = newMorselQueue(g.workers, splits, refill)
+	ctx.Stats.SeqScans++
+
+	workerCtx, cancel := context.WithCancel(ctx.Context)
+	g.cancel = cancel
+	g.results = make(chan scanResult, g.workers)
+	for w := 0; w < g.workers; w++ {
+		g.wg.Add(1)
+		go g.work(workerCtx, w)
+	}
+	go func() {
+		g.wg.Wait()
+		close(g.results)
+	}()
+	return nil
+}
+
+func (g *gatherOperator) NextBatch() (*RowBatch, error) {
+	for {
+		if err := checkCancelled(g.ctx); err != nil {
+			return nil, err
+		}
+		res, ok := <-g.results
+		if !ok {
+			return nil, nil
+		}
+		if res.err != nil {
+			return nil, res.err
+		}
+		g.ctx.Stats.RowsProcessed += res.rows
+		g.ctx.Stats.BytesProcessed += res.bytes
+		if res.batch != nil && len(res.batch.Rows) > 0 {
+			return res.batch, nil
+		}
+	}
+}
+
+func (g *gatherOperator) Close() error {
+	if g.cancel == nil {
+		return nil
+	}
+	g.cancel()
+	for range g.results {
+	}
+	g.cancel = nil
+	return nil
+}
+
+func (g *gatherOperator) Columns() []ColumnInfo { return g.columns }
+
+// scanWorker is one worker's view of the scan: its partial batch and the
+// statistics not yet reported.
+type scanWorker struct {
+	g     *gatherOperator
+	ctx   context.Context
+	id    int
+	env   *evalEnv
+	batch []Row
+	rows  int64
+	bytes int64
+}
+
+func (g *gatherOperator) work(ctx context.Context, id int) {
+	defer g.wg.Done()
+	w := &scanWorker{
+		g:   g,
+		ctx: ctx,
+		id:  id,
+		env: &evalEnv{columns: g.colIndex, params: g.ctx.Parameters},
+	}
+	for {
+		split, ok := g.queue.next(ctx, id)
+		if !ok {
+			break
+		}
+		err := w.scan(split)
+		g.queue.done()
+		if err != nil {
+			w.send(scanResult{err: err})
+			return
+		}
+	}
+	if len(w.batch) > 0 || w.rows > 0 || w.bytes > 0 {
+		w.flush()
+	}
+}
+
+func (w *scanWorker) scan(split ScanSplit) error {
+	switch s := split.(type) {
+	case KeyRangeSplit:
+		return w.scanKeyRange(s)
+	case DocumentPageSplit:
+		return w.scanDocumentPage(s)
+	case RowGroupSplit:
+		return w.scanRowGroup(s)
+	default:
+		g := w.g
+		source, err := g.executor.openRowSource(&ExecutionContext{Context: w.ctx}, g.plan.TableName, g.columns)
+		if err != nil {
+			return err
+		}
+		defer source.close()
+		for {
+			row, n, ok, err := source.next()
+			if err != nil || !ok {
+				return err
+			}
+			if err := w.add(row, n); err != nil {
+				return err
+			}
+		}
+	}
+}
+
+// scanKeyRange reads a key range. Every morselRows rows it cuts what is
+// left of the range into pieces that should hold about as many rows and
+// pushes them on its deque, where idle workers can steal them.
+func (w *scanWorker) scanKeyRange(s KeyRangeSplit) error {
+	g := w.g
+	iter, err := g.executor.storageManager.kvStore.Scan(w.ctx, s.Start, s.End)
+	if err != nil {
+		return fmt.Errorf("failed to create KV iterator: %w", err)
+	}
+	defer iter.Close()
+
+	end := s.End
+	var first []byte
+	read := 0
+	for iter.Next() {
+		key, value, err := iter.Value()
+		if err != nil {
+			return fmt.Errorf("failed to read KV pair: %w", err)
+		}
+		if bytes.Compare(key, end) >= 0 {
+			return nil
+		}
+		if err := w.add(g.executor.kvToRow(key, value, g.columns), int64(len(key)+len(value))); err != nil {
+			return err
+		}
+
+		switch read++; read {
+		case 1:
+			first = append(first[:0], key...)
+		case morselRows:
+			read = 0
+			bounds := strideBounds(first, key, end, g.workers)
+			for i := len(bounds) - 1; i >= 0; i-- {
+				g.queue.push(w.id, KeyRangeSplit{Start: bounds[i], End: end})
+				end = bounds[i]
+			}
+		}
+	}
+	if err := iter.Error(); err != nil {
+		return fmt.Errorf("iterator error: %w", err)
+	}
+	return nil
+}
+
+func (w *scanWorker) scanDocumentPage(s DocumentPageSplit) error {
+	g := w.g
+	iter, err := g.executor.storageManager.docStore.QueryDocuments(w.ctx, g.plan.TableName, DocumentQuery{Offset: s.Offset, Limit: s.Limit})
+	if err != nil {
+		return fmt.Errorf("failed to create document iterator: %w", err)
+	}
+	defer iter.Close()
+
+	read := 0
+	for iter.Next() {
+		doc, err := iter.Document()
+		if err != nil {
+			return fmt.Errorf("failed to read document: %w", err)
+		}
+		read++
+		if err := w.add(g.executor.documentToRow(doc, g.columns), 0); err != nil {
+			return err
+		}
+	}
+	if err := iter.Error(); err != nil {
+		return fmt.Errorf("iterator error: %w", err)
+	}
+	if read < s.Limit {
+		g.pager.exhausted.Store(true)
+	}
+	return nil
+}
+
+func (w *scanWorker) scanRowGroup(s RowGroupSplit) error {
+	g := w.g
+	group, err := g.executor.storageManager.columnarStore.GetRowGroup(w.ctx, g.plan.TableName, s.ID)
+	if err != nil {
+		return fmt.Errorf("failed to read row group %d: %w", s.ID, err)
+	}
+	for i := int64(0); i < group.RowCount; i++ {
+		row := Row{Values: make([]any, len(g.columns))}
+		for c, col := range g.columns {
+			data, ok := group.Columns[col.Name]
+			if !ok || i >= int64(len(data.Values)) || (i < int64(len(data.Nulls)) && data.Nulls[i]) {
+				continue
+			}
+			row.Values[c] = data.Values[i]
+		}
+		if err := w.add(row, 0); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// add applies the scan qualifiers and ships the batch once it is full.
+func (w *scanWorker) add(row Row, n int64) error {
+	w.bytes += n
+	w.env.row = row
+	match, err := evaluateQuals(w.g.plan.Qual, w.env)
+	if err != nil || !match {
+		return err
+	}
+	w.batch = append(w.batch, row)
+	w.rows++
+	if len(w.batch) >= w.g.batchSize {
+		if !w.flush() {
+			return w.ctx.Err()
+		}
+	}
+	return nil
+}
+
+func (w *scanWorker) flush() bool {
+	ok := w.send(scanResult{batch: &RowBatch{Rows: w.batch}, rows: w.rows, bytes: w.bytes})
+	w.batch = make([]Row, 0, w.g.batchSize)
+	w.rows, w.bytes = 0, 0
+	return ok
+}
+
+func (w *scanWorker) send(res scanResult) bool {
+	select {
+	case w.g.results <- res:
+		return true
+	case <-w.ctx.Done():
+		return false
+	}
+}
@@ -11,6 +11,11 @@ type Parser struct {
 	tokens   []Token
 	position int
 	current  Token
+	// params is the highest bind parameter number seen; positional is
+	// set once a ? placeholder has been numbered, since the two styles
+	// cannot be mixed.
+	params     int
+	positional bool
 }
 
 // NewParser creates a new SQL parser
@@ -30,7 +35,23 @@ func ParseSQL(input string) (Statement, error) {
 	}
 
 	parser := NewParser(tokens)
-	return parser.ParseStatement()
+	return parser.parseSingleStatement()
+}
+
+// parseSQLWithParams parses a statement that may contain bind parameters
+// and also returns how many parameters it takes.
+func parseSQLWithParams(input string) (Statement, int, error) {
+	tokens, err := TokenizeSQL(input)
+	if err != nil {
+		return nil, 0, err
+	}
+
+	parser := NewParser(tokens)
+	stmt, err := parser.parseSingleStatement()
+	if err != nil {
+		return nil, 0, err
+	}
+	return stmt, parser.params, nil
 }
 
 // advance moves to the next token
@@ -147,11 +168,37 @@ func (p *Parser) ParseStatement() (Statement, error) {
 		return p.parseSavepointStatement()
 	case "RELEASE":
 		return p.parseReleaseSavepointStatement()
+	case "PREPARE":
+		return p.parsePrepareStatement()
+	case "EXECUTE":
+		return p.parseExecuteStatement()
+	case "DEALLOCATE":
+		return p.parseDeallocateStatement()
+	case "ANALYZE":
+		return p.parseAnalyzeStatement()
+	case "EXPLAIN":
+		return p.parseExplainStatement()
 	default:
 		return nil, p.error(fmt.Sprintf("unsupported statement type: %s", p.current.Value))
 	}
 }
 
+// parseSingleStatement parses one statement, with an optional trailing
+// semicolon, and rejects anything left after it
+func (p *Parser) parseSingleStatement() (Statement, error) {
+	stmt, err := p.ParseStatement()
+	if err != nil {
+		return nil, err
+	}
+	if p.match(TokenSemicolon) {
+		p.advance()
+	}
+	if !p.match(TokenEOF) {
+		return nil, p.error(fmt.Sprintf("unexpected %q after end of statement", p.current.Value))
+	}
+	return stmt, nil
+}
+
 // parseSelectStatement parses a SELECT statement
 func (p *Parser) parseSelectStatement() (*SelectStatement, error) {
 	stmt := &SelectStatement{}
@@ -186,11 +233,12 @@ func (p *Parser) parseSelectStatement() (*SelectStatement, error) {
 	// Parse FROM clause
 	if p.matchKeyword("FROM") {
 		p.advance()
-		from, err := p.parseFromClause()
+		from, joins, err := p.parseFromClause()
 		if err != nil {
 			return nil, err
 		}
 		stmt.From = from
+		stmt.Joins = joins
 	}
 
 	// Parse WHERE clause
@@ -393,14 +441,16 @@ func (p *Parser) parseSelectFields() ([]SelectField, error) {
 	return fields, nil
 }
 
-// parseFromClause parses the FROM clause
-func (p *Parser) parseFromClause() ([]TableReference, error) {
+// parseFromClause parses the FROM clause. Comma-separated items are
+// returned as tables and JOINs, in the order written, as joins.
+func (p *Parser) parseFromClause() ([]TableReference, []*JoinClause, error) {
 	var tables []TableReference
+	var joins []*JoinClause
 
 	for {
 		table, err := p.parseTableReference()
 		if err != nil {
-			return nil, err
+			return nil, nil, err
 		}
 		tables = append(tables, *table)
 
@@ -408,12 +458,12 @@ func (p *Parser) parseFromClause() ([]TableReference, error) {
 		for p.matchKeyword("JOIN", "INNER", "LEFT", "RIGHT", "FULL", "CROSS", "NATURAL") {
 			joinType, err := p.parseJoinType()
 			if err != nil {
-				return nil, err
+				return nil, nil, err
 			}
 
 			joinTable, err := p.parseTableReference()
 			if err != nil {
-				return nil, err
+				return nil, nil, err
 			}
 
 			join := &JoinClause{
@@ -426,18 +476,18 @@ func (p *Parser) parseFromClause() ([]TableReference, error) {
 				p.advance()
 				condition, err := p.parseExpression()
 				if err != nil {
-					return nil, err
+					return nil, nil, err
 				}
 				join.Condition = condition
 			} else if p.matchKeyword("USING") {
 				p.advance()
 				if err := p.consume(TokenLeftParen, "expected '('"); err != nil {
-					return nil, err
+					return nil, nil, err
 				}
 
 				for {
 					if !p.match(TokenIdentifier) {
-						return nil, p.error("expected column name")
+						return nil, nil, p.error("expected column name")
 					}
 					join.Using = append(join.Using, p.current.Value)
 					p.advance()
@@ -450,15 +500,11 @@ func (p *Parser) parseFromClause() ([]TableReference, error) {
 				}
 
 				if err := p.consume(TokenRightParen, "expected ')'"); err != nil {
-					return nil, err
+					return nil, nil, err
 				}
 			}
 
-			// Add join to the last table
-			if len(tables) > 0 {
-				// In a real implementation, you'd properly handle the join structure
-				// For now, we'll just note that there was a join
-			}
+			joins = append(joins, join)
 		}
 
 		if p.match(TokenComma) {
@@ -468,7 +514,7 @@ func (p *Parser) parseFromClause() ([]TableReference, error) {
 		}
 	}
 
-	return tables, nil
+	return tables, joins, nil
 }
 
 // parseTableReference parses a table reference
@@ -621,7 +667,7 @@ func (p *Parser) parseOrExpression() (Expression, error) {
 		return nil, err
 	}
 
-	for p.matchKeyword("OR") {
+	for p.match(TokenOr) || p.matchKeyword("OR") {
 		p.advance()
 		right, err := p.parseAndExpression()
 		if err != nil {
@@ -644,7 +690,7 @@ func (p *Parser) parseAndExpression() (Expression, error) {
 		return nil, err
 	}
 
-	for p.matchKeyword("AND") {
+	for p.match(TokenAnd) || p.matchKeyword("AND") {
 		p.advance()
 		right, err := p.parseNotExpression()
 		if err != nil {
@@ -662,7 +708,7 @@ func (p *Parser) parseAndExpression() (Expression, error) {
 
 // parseNotExpression parses NOT and EXISTS expressions
 func (p *Parser) parseNotExpression() (Expression, error) {
-	if p.matchKeyword("NOT") {
+	if p.match(TokenNot) || p.matchKeyword("NOT") {
 		p.advance()
 		expr, err := p.parseNotExpression()
 		if err != nil {
@@ -674,7 +720,7 @@ func (p *Parser) parseNotExpression() (Expression, error) {
 		}, nil
 	}
 
-	if p.matchKeyword("EXISTS") {
+	if p.match(TokenExists) || p.matchKeyword("EXISTS") {
 		p.advance()
 		expr, err := p.parseNotExpression()
 		if err != nil {
@@ -716,12 +762,22 @@ func (p *Parser) parseComparisonExpression() (Expression, error) {
 			op, found = OpGreaterEqual, true
 		case p.match(TokenBitwiseNot):
 			op, found = OpRegexMatch, true
-		case p.matchKeyword("LIKE"):
+		case p.match(TokenLike) || p.matchKeyword("LIKE"):
 			op, found = OpLike, true
-		case p.matchKeyword("ILIKE"):
+		case p.match(TokenILike) || p.matchKeyword("ILIKE"):
 			op, found = OpILike, true
-		case p.matchKeyword("IN"):
-			op, found = OpIn, true
+		case p.match(TokenIn) || p.matchKeyword("IN"):
+			p.advance() // consume IN
+			list, err := p.parseInList()
+			if err != nil {
+				return nil, err
+			}
+			left = &BinaryExpression{
+				Left:     left,
+				Operator: OpIn,
+				Right:    list,
+			}
+			continue
 		case p.matchKeyword("BETWEEN"):
 			// Handle BETWEEN specially
 			p.advance() // consume BETWEEN
@@ -784,23 +840,30 @@ func (p *Parser) parseComparisonExpression() (Expression, error) {
 			} else {
 				return nil, p.error("expected NULL or NOT NULL after IS")
 			}
-		case p.matchKeyword("NOT"):
+		case p.match(TokenNot) || p.matchKeyword("NOT"):
 			// Handle NOT LIKE, NOT IN, NOT BETWEEN, etc.
 			next := p.peek()
-			if next.Type == TokenKeyword {
+			if next.Type == TokenKeyword || next.Type == TokenLike || next.Type == TokenILike || next.Type == TokenIn {
 				switch strings.ToUpper(next.Value) {
 				case "LIKE":
-					p.advance() // consume NOT
-					p.advance() // consume LIKE
+					p.advance() // consume NOT; LIKE is consumed below
 					op, found = OpNotLike, true
 				case "ILIKE":
-					p.advance() // consume NOT
-					p.advance() // consume ILIKE
+					p.advance() // consume NOT; ILIKE is consumed below
 					op, found = OpNotILike, true
 				case "IN":
 					p.advance() // consume NOT
 					p.advance() // consume IN
-					op, found = OpNotIn, true
+					list, err := p.parseInList()
+					if err != nil {
+						return nil, err
+					}
+					left = &BinaryExpression{
+						Left:     left,
+						Operator: OpNotIn,
+						Right:    list,
+					}
+					continue
 				case "BETWEEN":
 					p.advance() // consume NOT
 					p.advance() // consume BETWEEN
@@ -865,6 +928,39 @@ func (p *Parser) parseComparisonExpression() (Expression, error) {
 	return left, nil
 }
 
+// parseInList parses the right side of IN: a subquery or a parenthesized
+// list of expressions, which becomes an array literal
+func (p *Parser) parseInList() (Expression, error) {
+	if !p.match(TokenLeftParen) {
+		return nil, p.error("expected '(' after IN")
+	}
+	if next := p.peek(); next.Type == TokenKeyword && (strings.ToUpper(next.Value) == "SELECT" || strings.ToUpper(next.Value) == "WITH") {
+		return p.parsePrimaryExpression()
+	}
+	p.advance() // consume (
+
+	var elements []Expression
+	for {
+		element, err := p.parseExpression()
+		if err != nil {
+			return nil, err
+		}
+		elements = append(elements, element)
+		if !p.match(TokenComma) {
+			break
+		}
+		p.advance()
+	}
+	if err := p.consume(TokenRightParen, "expected ')' after IN list"); err != nil {
+		return nil, err
+	}
+
+	return &LiteralExpression{
+		Value: elements,
+		Type:  LiteralArray,
+	}, nil
+}
+
 // parseArithmeticExpression parses arithmetic expressions
 func (p *Parser) parseArithmeticExpression() (Expression, error) {
 	left, err := p.parseTermExpression()
@@ -997,6 +1093,9 @@ func (p *Parser) parsePrimaryExpression() (Expression, error) {
 	case TokenIdentifier, TokenQuotedIdentifier:
 		return p.parseIdentifierOrFunction()
 
+	case TokenDollar, TokenQuestion:
+		return p.parseParameter()
+
 	case TokenMultiply:
 		// Handle * as a special identifier (for SELECT *)
 		p.advance()
@@ -1096,6 +1195,11 @@ func (p *Parser) parseIdentifierOrFunction() (Expression, error) {
 	var schema, table string
 	if p.match(TokenDot) {
 		p.advance()
+		if p.match(TokenMultiply) {
+			// table.* in a select list
+			p.advance()
+			return &IdentifierExpression{Table: name, Name: "*"}, nil
+		}
 		if !p.match(TokenIdentifier, TokenQuotedIdentifier) {
 			return nil, p.error("expected identifier after '.'")
 		}
@@ -1453,9 +1557,10 @@ func (p *Parser) parseWindowFrame() (*WindowFrame, error) {
 		}
 		frame.Start = start
 
-		if err := p.consumeKeyword("AND", "expected AND in frame specification"); err != nil {
-			return nil, err
+		if !p.match(TokenAnd) && !p.matchKeyword("AND") {
+			return nil, p.error("expected AND in frame specification")
 		}
+		p.advance()
 
 		end, err := p.parseFrameBound()
 		if err != nil {
@@ -1864,11 +1969,12 @@ func (p *Parser) parseUpdateStatement() (*UpdateStatement, error) {
 	// Parse optional FROM clause
 	if p.matchKeyword("FROM") {
 		p.advance()
-		from, err := p.parseFromClause()
+		from, joins, err := p.parseFromClause()
 		if err != nil {
 			return nil, err
 		}
 		stmt.From = from
+		stmt.Joins = joins
 	}
 
 	// Parse optional WHERE clause
@@ -1947,13 +2053,13 @@ func (p *Parser) parseCreateStatement() (Statement, error) {
 	} else if p.matchKeyword("UNIQUE") {
 		p.advance() // consume UNIQUE
 		if p.matchKeyword("INDEX") {
-			return p.parseCreateIndexStatement()
+			return p.parseCreateIndexStatement(true)
 		}
 		return nil, p.error("expected INDEX after UNIQUE")
 	} else if p.matchKeyword("TABLE") {
 		return p.parseCreateTableStatement()
 	} else if p.matchKeyword("INDEX") {
-		return p.parseCreateIndexStatement()
+		return p.parseCreateIndexStatement(false)
 	}
 
 	return nil, p.error("unsupported CREATE statement")
@@ -2142,7 +2248,7 @@ func (p *Parser) parseColumnConstraint() (*ColumnConstraint, error) {
 		}
 		constraint.Type = NotNullConstraint
 		constraint.NotNull = true
-	} else if p.matchKeyword("NULL") {
+	} else if p.match(TokenNull) || p.matchKeyword("NULL") {
 		p.advance()
 		// NULL constraint (explicitly nullable) - return nil to skip adding this constraint
 		return nil, nil
@@ -2289,7 +2395,7 @@ func (p *Parser) parseReferentialAction() (ReferentialAction, error) {
 		return Cascade, nil
 	} else if p.matchKeyword("SET") {
 		p.advance()
-		if p.matchKeyword("NULL") {
+		if p.match(TokenNull) || p.matchKeyword("NULL") {
 			p.advance()
 			return SetNull, nil
 		} else if p.matchKeyword("DEFAULT") {
@@ -2482,14 +2588,10 @@ func (p *Parser) parseTableConstraint() (*TableConstraint, error) {
 	return constraint, nil
 }
 
-func (p *Parser) parseCreateIndexStatement() (*CreateIndexStatement, error) {
-	stmt := &CreateIndexStatement{}
-
-	// Check if UNIQUE was already consumed in parseCreateStatement
-	if !p.matchKeyword("INDEX") {
-		// UNIQUE was already consumed, so this is a unique index
-		stmt.Unique = true
-	}
+// parseCreateIndexStatement parses CREATE [UNIQUE] INDEX; unique reports
+// whether parseCreateStatement consumed UNIQUE.
+func (p *Parser) parseCreateIndexStatement(unique bool) (*CreateIndexStatement, error) {
+	stmt := &CreateIndexStatement{Unique: unique}
 
 	if p.matchKeyword("INDEX") {
 		p.advance() // consume INDEX
@@ -2925,7 +3027,7 @@ func (p *Parser) parseBeginTransactionStatement() (*BeginTransactionStatement, e
 			p.advance()
 			stmt.Deferrable = true
 
-		} else if p.matchKeyword("NOT") {
+		} else if p.match(TokenNot) || p.matchKeyword("NOT") {
 			p.advance()
 			if err := p.consumeKeyword("DEFERRABLE", "expected DEFERRABLE after NOT"); err != nil {
 				return nil, err
@@ -2958,7 +3060,7 @@ func (p *Parser) parseCommitTransactionStatement() (*CommitTransactionStatement,
 	}
 
 	// Optional AND CHAIN
-	if p.matchKeyword("AND") {
+	if p.match(TokenAnd) || p.matchKeyword("AND") {
 		p.advance()
 		if err := p.consumeKeyword("CHAIN", "expected CHAIN after AND"); err != nil {
 			return nil, err
@@ -2996,7 +3098,7 @@ func (p *Parser) parseRollbackTransactionStatement() (*RollbackTransactionStatem
 	}
 
 	// Optional AND CHAIN
-	if p.matchKeyword("AND") {
+	if p.match(TokenAnd) || p.matchKeyword("AND") {
 		p.advance()
 		if err := p.consumeKeyword("CHAIN", "expected CHAIN after AND"); err != nil {
 			return nil, err
@@ -3072,3 +3174,165 @@ func (p *Parser) parseIsolationLevel() (SQLIsolationLevel, error) {
 		return 0, p.error("expected isolation level (READ UNCOMMITTED, READ COMMITTED, REPEATABLE READ, or SERIALIZABLE)")
 	}
 }
+
+// parseParameter parses a $n or ? bind parameter. ? placeholders are
+// numbered left to right.
+func (p *Parser) parseParameter() (Expression, error) {
+	if p.match(TokenQuestion) {
+		if p.params > 0 && !p.positional {
+			return nil, p.error("cannot mix ? and $n parameters")
+		}
+		p.positional = true
+		p.advance()
+		p.params++
+		return &ParameterExpression{Index: p.params}, nil
+	}
+
+	p.advance()
+	if !p.match(TokenInteger) || p.positional {
+		return nil, p.error("expected parameter number after $")
+	}
+	index, err := strconv.Atoi(p.current.Value)
+	if err != nil || index < 1 {
+		return nil, p.error("invalid parameter number")
+	}
+	p.advance()
+	if index > p.params {
+		p.params = index
+	}
+	return &ParameterExpression{Index: index}, nil
+}
+
+// parsePrepareStatement parses PREPARE name [(type, ...)] AS statement
+func (p *Parser) parsePrepareStatement() (*PrepareStatement, error) {
+	// Consume PREPARE
+	p.advance()
+
+	if !p.match(TokenIdentifier) {
+		return nil, p.error("expected prepared statement name")
+	}
+	stmt := &PrepareStatement{Name: p.current.Value}
+	p.advance()
+
+	// Parameter types are accepted for compatibility; values are typed
+	// when they are bound.
+	if p.match(TokenLeftParen) {
+		for !p.match(TokenRightParen) {
+			if p.match(TokenEOF) {
+				return nil, p.error("expected ')' after parameter types")
+			}
+			p.advance()
+		}
+		p.advance()
+	}
+
+	if err := p.consumeKeyword("AS", "expected AS after prepared statement name"); err != nil {
+		return nil, err
+	}
+	if !p.matchKeyword("SELECT", "WITH", "INSERT", "UPDATE", "DELETE") {
+		return nil, p.error("only SELECT, INSERT, UPDATE and DELETE can be prepared")
+	}
+	query, err := p.ParseStatement()
+	if err != nil {
+		return nil, err
+	}
+	stmt.Query = query
+	stmt.ParamCount = p.params
+	return stmt, nil
+}
+
+// parseExecuteStatement parses EXECUTE name [(value, ...)]
+func (p *Parser) parseExecuteStatement() (*ExecuteStatement, error) {
+	// Consume EXECUTE
+	p.advance()
+
+	if !p.match(TokenIdentifier) {
+		return nil, p.error("expected prepared statement name")
+	}
+	stmt := &ExecuteStatement{Name: p.current.Value}
+	p.advance()
+
+	if p.match(TokenLeftParen) {
+		p.advance()
+		for !p.match(TokenRightParen) {
+			param, err := p.parseExpression()
+			if err != nil {
+				return nil, err
+			}
+			stmt.Params = append(stmt.Params, param)
+			if !p.match(TokenComma) {
+				break
+			}
+			p.advance()
+		}
+		if err := p.consume(TokenRightParen, "expected ')' after EXECUTE parameters"); err != nil {
+			return nil, err
+		}
+	}
+	return stmt, nil
+}
+
+// parseDeallocateStatement parses DEALLOCATE [PREPARE] {name | ALL}
+func (p *Parser) parseDeallocateStatement() (*DeallocateStatement, error) {
+	// Consume DEALLOCATE
+	p.advance()
+
+	if p.matchKeyword("PREPARE") {
+		p.advance()
+	}
+	if p.matchKeyword("ALL") {
+		p.advance()
+		return &DeallocateStatement{}, nil
+	}
+	if !p.match(TokenIdentifier) {
+		return nil, p.error("expected prepared statement name")
+	}
+	stmt := &DeallocateStatement{Name: p.current.Value}
+	p.advance()
+	return stmt, nil
+}
+
+// parseExplainStatement parses EXPLAIN [ANALYZE] [VERBOSE] statement
+func (p *Parser) parseExplainStatement() (*ExplainStatement, error) {
+	// Consume EXPLAIN
+	p.advance()
+
+	stmt := &ExplainStatement{}
+	if p.matchKeyword("ANALYZE") {
+		stmt.Analyze = true
+		p.advance()
+	}
+	if p.matchKeyword("VERBOSE") {
+		stmt.Verbose = true
+		p.advance()
+	}
+
+	inner, err := p.ParseStatement()
+	if err != nil {
+		return nil, err
+	}
+	switch inner.(type) {
+	case *SelectStatement, *InsertStatement, *UpdateStatement, *DeleteStatement:
+	default:
+		return nil, p.error(fmt.Sprintf("cannot EXPLAIN %s", inner.String()))
+	}
+	stmt.Statement = inner
+	return stmt, nil
+}
+
+// parseAnalyzeStatement parses ANALYZE [table [, ...]]
+func (p *Parser) parseAnalyzeStatement() (*AnalyzeStatement, error) {
+	// Consume ANALYZE
+	p.advance()
+
+	stmt := &AnalyzeStatement{}
+	for p.match(TokenIdentifier) {
+		stmt.Tables = append(stmt.Tables, p.current.Value)
+		p.advance()
+		if !p.match(TokenComma) {
+			break
+		}
+		p.advance()
+	}
+	return stmt, nil
+}
@@ -237,6 +237,16 @@ func TestParseExpressions(t *testing.T) {
 			input: "SELECT * FROM table1 WHERE id IN (1, 2, 3)",
 			valid: true,
 		},
+		{
+			name:  "not in expression",
+			input: "SELECT * FROM table1 WHERE id NOT IN (1, 2, 3) AND name NOT LIKE 'a%'",
+			valid: true,
+		},
+		{
+			name:  "between expression",
+			input: "SELECT * FROM table1 WHERE id BETWEEN 1 AND 3 OR id NOT BETWEEN 5 AND 7",
+			valid: true,
+		},
 		{
 			name:  "exists expression",
 			input: "SELECT * FROM table1 WHERE EXISTS (SELECT 1 FROM table2 WHERE table2.id = table1.id)",
@@ -277,6 +287,26 @@ func TestParseExpressions(t *testing.T) {
 	}
 }
 
+func TestParseInLikeBetween(t *testing.T) {
+	stmt, err := ParseSQL("SELECT * FROM t WHERE id IN (1, 2, 19) AND name LIKE 'g1%' AND id NOT IN (2);")
+	if err != nil {
+		t.Fatalf("parse: %v", err)
+	}
+	where := stmt.(*SelectStatement).Where
+	want := "(((id IN [1 2 19]) AND (name LIKE g1%)) AND (id NOT IN [2]))"
+	if where == nil || where.String() != want {
+		t.Fatalf("WHERE parsed as %v, want %s", where, want)
+	}
+
+	stmt, err = ParseSQL("SELECT * FROM t WHERE id NOT BETWEEN 1 AND 3")
+	if err != nil {
+		t.Fatalf("parse: %v", err)
+	}
+	if got := stmt.(*SelectStatement).Where.String(); got != "((id < 1) OR (id > 3))" {
+		t.Errorf("NOT BETWEEN parsed as %s", got)
+	}
+}
+
 func TestParseJoins(t *testing.T) {
 	tests := []struct {
 		name  string
@@ -490,6 +520,10 @@ func TestParseErrors(t *testing.T) {
 			name:  "invalid join syntax",
 			input: "SELECT * FROM a JOIN ON a.id = b.id",
 		},
+		{
+			name:  "trailing tokens",
+			input: "SELECT * FROM table1 WHERE id = 1 2",
+		},
 	}
 
 	for _, tt := range tests {
@@ -0,0 +1,357 @@
+package sql
+
+import (
+	"context"
+	"errors"
+	"fmt"
+	"hash/fnv"
+	"strconv"
+	"strings"
+	"time"
+)
+
+// QueryFingerprint is a statement with its literals replaced by bind
+// parameters, so that queries differing only in constants share one parsed
+// statement and one plan.
+type QueryFingerprint struct {
+	// Text is the normalized statement with $n in place of each literal.
+	Text string
+	// Literals holds the stripped values in parameter order.
+	Literals []any
+}
+
+// fingerprintClauses are the clauses whose literals are stripped. Literals
+// elsewhere stay in the text: in the select list they name result
+// columns, and in ORDER BY and GROUP BY an integer is a column ordinal.
+var fingerprintClauses = map[string]bool{
+	"WHERE": true, "HAVING": true, "ON": true, "SET": true,
+	"VALUES": true, "LIMIT": true, "OFFSET": true,
+}
+
+// fingerprintClauseKeywords start a new clause for the purpose of
+// fingerprintClauses.
+var fingerprintClauseKeywords = map[string]bool{
+	"SELECT": true, "FROM": true, "WHERE": true, "GROUP": true, "HAVING": true,
+	"ORDER": true, "LIMIT": true, "OFFSET": true, "SET": true, "VALUES": true,
+	"ON": true, "RETURNING": true, "UNION": true, "INTERSECT": true,
+	"EXCEPT": true, "WINDOW": true, "INTO": true, "USING": true, "JOIN": true,
+}
+
+// FingerprintQuery normalizes a SELECT, INSERT, UPDATE or DELETE statement
+// by stripping its literals. Other statements, and statements that already
+// use bind parameters, are returned with no literals stripped.
+func FingerprintQuery(sqlText string) (*QueryFingerprint, error) {
+	tokens, err := TokenizeSQL(sqlText)
+	if err != nil {
+		return nil, err
+	}
+
+	strip := len(tokens) > 0 && tokens[0].Type == TokenKeyword
+	if strip {
+		switch strings.ToUpper(tokens[0].Value) {
+		case "SELECT", "WITH", "INSERT", "UPDATE", "DELETE":
+		default:
+			strip = false
+		}
+	}
+	for _, tok := range tokens {
+		if tok.Type == TokenDollar || tok.Type == TokenQuestion {
+			strip = false
+		}
+	}
+
+	fp := &QueryFingerprint{}
+	var sb strings.Builder
+	clause := ""
+	var outer []string
+	for _, tok := range tokens {
+		if tok.Type == TokenEOF {
+			break
+		}
+		if sb.Len() > 0 {
+			sb.WriteByte(' ')
+		}
+
+		switch tok.Type {
+		case TokenLeftParen:
+			outer = append(outer, clause)
+		case TokenRightParen:
+			if n := len(outer); n > 0 {
+				clause, outer = outer[n-1], outer[:n-1]
+			}
+		case TokenKeyword:
+			if upper := strings.ToUpper(tok.Value); fingerprintClauseKeywords[upper] {
+				clause = upper
+			}
+		}
+
+		if strip && fingerprintClauses[clause] {
+			if v, ok := fingerprintLiteral(tok); ok {
+				fp.Literals = append(fp.Literals, v)
+				sb.WriteByte('$')
+				sb.WriteString(strconv.Itoa(len(fp.Literals)))
+				continue
+			}
+		}
+
+		switch tok.Type {
+		case TokenString:
+			sb.WriteByte('\'')
+			sb.WriteString(tok.Value)
+			sb.WriteByte('\'')
+		case TokenQuotedIdentifier:
+			quote := sqlText[tok.Position]
+			sb.WriteByte(quote)
+			sb.WriteString(tok.Value)
+			sb.WriteByte(quote)
+		case TokenIdentifier:
+			sb.WriteString(tok.Value)
+		default:
+			// AND, NULL, LIKE and friends have their own token types.
+			if upper := strings.ToUpper(tok.Value); sqlKeywords[upper] {
+				sb.WriteString(upper)
+			} else {
+				sb.WriteString(tok.Value)
+			}
+		}
+	}
+	fp.Text = sb.String()
+	return fp, nil
+}
+
+// fingerprintLiteral returns the value the parser would give a literal
+// token.
+func fingerprintLiteral(tok Token) (any, bool) {
+	switch tok.Type {
+	case TokenString:
+		return tok.Value, true
+	case TokenInteger:
+		if i, err := strconv.ParseInt(tok.Value, 10, 64); err == nil {
+			return i, true
+		}
+	case TokenFloat:
+		if f, err := strconv.ParseFloat(tok.Value, 64); err == nil {
+			return f, true
+		}
+	}
+	return nil, false
+}
+
+// PreparedStatement is a parsed statement with bind parameters. Its plan
+// lives in the optimizer's plan cache under key, so it is rebuilt after
+// schema or statistics changes.
+type PreparedStatement struct {
+	ID         string
+	Name       string
+	SQL        string
+	Statement  Statement
+	ParamCount int
+	key        string
+}
+
+// preparedStatementID derives a statement ID from its text, so clients
+// preparing the same query share one statement.
+func preparedStatementID(sqlText string) string {
+	h := fnv.New64a()
+	h.Write([]byte(sqlText))
+	return fmt.Sprintf("stmt_%016x", h.Sum64())
+}
+
+func newPreparedStatement(name, sqlText string, stmt Statement, paramCount int) (*PreparedStatement, error) {
+	switch stmt.(type) {
+	case *SelectStatement, *InsertStatement, *UpdateStatement, *DeleteStatement:
+	default:
+		return nil, fmt.Errorf("cannot prepare %s statement", stmt)
+	}
+	return &PreparedStatement{
+		ID:         preparedStatementID(sqlText),
+		Name:       name,
+		SQL:        sqlText,
+		Statement:  stmt,
+		ParamCount: paramCount,
+		key:        "prepared:" + sqlText,
+	}, nil
+}
+
+// ErrPreparedStatementNotFound is returned for an unknown statement ID,
+// for example one deallocated by another client.
+var ErrPreparedStatementNotFound = errors.New("prepared statement not found")
+
+// Prepare parses a statement with $n or ? parameters for repeated
+// execution with ExecutePrepared. Preparing the same text twice returns
+// the same statement.
+func (se *SQLEngine) Prepare(sqlText string) (*PreparedStatement, error) {
+	id := preparedStatementID(sqlText)
+	se.preparedMutex.RLock()
+	ps, exists := se.prepared[id]
+	se.preparedMutex.RUnlock()
+	if exists && ps.SQL == sqlText {
+		return ps, nil
+	}
+
+	stmt, paramCount, err := parseSQLWithParams(sqlText)
+	if err != nil {
+		return nil, fmt.Errorf("parse error: %w", err)
+	}
+	ps, err = newPreparedStatement("", sqlText, stmt, paramCount)
+	if err != nil {
+		return nil, err
+	}
+
+	se.preparedMutex.Lock()
+	se.prepared[id] = ps
+	se.preparedMutex.Unlock()
+	return ps, nil
+}
+
+// GetPrepared returns the statement Prepare registered under id.
+func (se *SQLEngine) GetPrepared(id string) (*PreparedStatement, bool) {
+	se.preparedMutex.RLock()
+	defer se.preparedMutex.RUnlock()
+	ps, exists := se.prepared[id]
+	return ps, exists
+}
+
+// Deallocate forgets a statement registered by Prepare.
+func (se *SQLEngine) Deallocate(id string) error {
+	se.preparedMutex.Lock()
+	defer se.preparedMutex.Unlock()
+	if _, exists := se.prepared[id]; !exists {
+		return fmt.Errorf("%w: %s", ErrPreparedStatementNotFound, id)
+	}
+	delete(se.prepared, id)
+	return nil
+}
+
+// ExecutePrepared runs a statement registered by Prepare on a connection.
+func (se *SQLEngine) ExecutePrepared(ctx context.Context, connectionID, id string, params []any) (*SQLResult, error) {
+	ps, exists := se.GetPrepared(id)
+	if !exists {
+		err := fmt.Errorf("%w: %s", ErrPreparedStatementNotFound, id)
+		return &SQLResult{Error: err}, err
+	}
+	conn, err := se.touchConnection(connectionID)
+	if err != nil {
+		return nil, err
+	}
+	ctx = se.sampleQuery(ctx, ps.SQL)
+	return se.executePrepared(ctx, conn, ps, params, time.Now())
+}
+
+// InvalidatePlans drops cached plans after a schema change made outside
+// of SQL, such as a table created through the storage APIs.
+func (se *SQLEngine) InvalidatePlans() {
+	se.optimizer.InvalidatePlans()
+}
+
+func (se *SQLEngine) executePrepared(ctx context.Context, conn *SQLConnection, ps *PreparedStatement, params []any, startTime time.Time) (*SQLResult, error) {
+	if len(params) != ps.ParamCount {
+		err := fmt.Errorf("prepared statement takes %d parameters, got %d", ps.ParamCount, len(params))
+		return &SQLResult{Error: err, ExecutionTime: time.Since(startTime)}, err
+	}
+	return se.executeDataStatement(ctx, conn, ps.Statement, se.preparedPlan(ps), params, startTime)
+}
+
+// preparedPlan returns the cached plan of a prepared statement, planning
+// it again if the cache dropped it.
+func (se *SQLEngine) preparedPlan(ps *PreparedStatement) *QueryPlan {
+	if _, plan, ok := se.optimizer.CachedStatement(ps.key); ok {
+		return plan
+	}
+	return se.planStatement(ps.key, ps.Statement)
+}
+
+// compileSQL turns statement text into a statement, its plan and the
+// parameters to bind. Literals are stripped first, so a repeated query
+// with new constants skips parsing and planning entirely.
+func (se *SQLEngine) compileSQL(sqlText string) (Statement, *QueryPlan, []any, error) {
+	fp, err := FingerprintQuery(sqlText)
+	if err != nil {
+		return nil, nil, nil, err
+	}
+	if stmt, plan, ok := se.optimizer.CachedStatement(fp.Text); ok {
+		return stmt, plan, fp.Literals, nil
+	}
+	if stmt, paramCount, err := parseSQLWithParams(fp.Text); err == nil && paramCount == len(fp.Literals) {
+		switch stmt.(type) {
+		case *SelectStatement, *InsertStatement, *UpdateStatement, *DeleteStatement:
+			return stmt, se.planStatement(fp.Text, stmt), fp.Literals, nil
+		}
+	}
+
+	// Some literals cannot be parameters (type lengths, INTERVAL '1 day'),
+	// and other statements are not planned; parse the original text.
+	stmt, err := ParseSQL(sqlText)
+	if err != nil {
+		return nil, nil, nil, err
+	}
+	return stmt, nil, nil, nil
+}
+
+// planStatement plans and caches stmt. Planning failures are not fatal:
+// the statement then runs without a plan as it did before caching.
+func (se *SQLEngine) planStatement(key string, stmt Statement) *QueryPlan {
+	plan, err := se.optimizer.OptimizeCached(key, stmt)
+	if err != nil {
+		return nil
+	}
+	return plan
+}
+
+// executePrepare handles PREPARE name AS statement.
+func (se *SQLEngine) executePrepare(conn *SQLConnection, stmt *PrepareStatement, startTime time.Time) (*SQLResult, error) {
+	ps, err := newPreparedStatement(stmt.Name, "", stmt.Query, stmt.ParamCount)
+	if err != nil {
+		return &SQLResult{Error: err, ExecutionTime: time.Since(startTime)}, err
+	}
+	// SQL-level statements have no text of their own; a sequence number
+	// keeps a re-prepared name from finding the old plan.
+	ps.key = fmt.Sprintf("prepared:%s:%s:%d", conn.ID, stmt.Name, se.prepareSeq.Add(1))
+
+	conn.mutex.Lock()
+	defer conn.mutex.Unlock()
+	if _, exists := conn.prepared[stmt.Name]; exists {
+		err := fmt.Errorf("prepared statement %s already exists", stmt.Name)
+		return &SQLResult{Error: err, ExecutionTime: time.Since(startTime)}, err
+	}
+	conn.prepared[stmt.Name] = ps
+	return &SQLResult{ExecutionTime: time.Since(startTime)}, nil
+}
+
+// executeExecute handles EXECUTE name (params).
+func (se *SQLEngine) executeExecute(ctx context.Context, conn *SQLConnection, stmt *ExecuteStatement, startTime time.Time) (*SQLResult, error) {
+	conn.mutex.RLock()
+	ps, exists := conn.prepared[stmt.Name]
+	conn.mutex.RUnlock()
+	if !exists {
+		err := fmt.Errorf("prepared statement %s does not exist", stmt.Name)
+		return &SQLResult{Error: err, ExecutionTime: time.Since(startTime)}, err
+	}
+
+	params := make([]any, len(stmt.Params))
+	for i, expr := range stmt.Params {
+		v, err := evaluateExpression(expr, &evalEnv{})
+		if err != nil {
+			err = fmt.Errorf("invalid EXECUTE parameter %d: %w", i+1, err)
+			return &SQLResult{Error: err, ExecutionTime: time.Since(startTime)}, err
+		}
+		params[i] = v
+	}
+	return se.executePrepared(ctx, conn, ps, params, startTime)
+}
+
+// executeDeallocate handles DEALLOCATE name and DEALLOCATE ALL.
+func (se *SQLEngine) executeDeallocate(conn *SQLConnection, stmt *DeallocateStatement, startTime time.Time) (*SQLResult, error) {
+	conn.mutex.Lock()
+	defer conn.mutex.Unlock()
+	if stmt.Name == "" {
+		conn.prepared = make(map[string]*PreparedStatement)
+		return &SQLResult{ExecutionTime: time.Since(startTime)}, nil
+	}
+	if _, exists := conn.prepared[stmt.Name]; !exists {
+		err := fmt.Errorf("prepared statement %s does not exist", stmt.Name)
+		return &SQLResult{Error: err, ExecutionTime: time.Since(startTime)}, err
+	}
+	delete(conn.prepared, stmt.Name)
+	return &SQLResult{ExecutionTime: time.Since(startTime)}, nil
+}
@@ -0,0 +1,155 @@
+package sql
+
+import (
+	"context"
+	"fmt"
+	"testing"
+
+	"mantisDB/transaction"
+)
+
+func TestFingerprintQuery(t *testing.T) {
+	a, err := FingerprintQuery("SELECT data, 1 FROM doc_t WHERE id = 42 AND name = 'x' ORDER BY 1 LIMIT 10")
+	if err != nil {
+		t.Fatal(err)
+	}
+	b, err := FingerprintQuery("select data, 1 from doc_t where id = 7 and name = 'yy' order by 1 limit 5")
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	want := "SELECT data , 1 FROM doc_t WHERE id = $1 AND name = $2 ORDER BY 1 LIMIT $3"
+	if a.Text != want {
+		t.Errorf("fingerprint = %q, want %q", a.Text, want)
+	}
+	if b.Text != a.Text {
+		t.Errorf("queries differing only in literals have different fingerprints: %q vs %q", a.Text, b.Text)
+	}
+	if fmt.Sprint(a.Literals) != "[42 x 10]" {
+		t.Errorf("unexpected literals %v", a.Literals)
+	}
+
+	ddl, err := FingerprintQuery("CREATE TABLE t (name VARCHAR(10))")
+	if err != nil {
+		t.Fatal(err)
+	}
+	if len(ddl.Literals) != 0 {
+		t.Errorf("DDL literals should not be stripped: %v", ddl.Literals)
+	}
+}
+
+func TestParsePrepareExecute(t *testing.T) {
+	stmt, err := ParseSQL("PREPARE by_id (INTEGER) AS SELECT data, $2 FROM doc_t WHERE id = $1")
+	if err != nil {
+		t.Fatal(err)
+	}
+	prep, ok := stmt.(*PrepareStatement)
+	if !ok || prep.Name != "by_id" || prep.ParamCount != 2 {
+		t.Fatalf("unexpected PREPARE parse: %#v", stmt)
+	}
+
+	stmt, err = ParseSQL("EXECUTE by_id (5, 'x')")
+	if err != nil {
+		t.Fatal(err)
+	}
+	if exec, ok := stmt.(*ExecuteStatement); !ok || len(exec.Params) != 2 {
+		t.Fatalf("unexpected EXECUTE parse: %#v", stmt)
+	}
+
+	_, n, err := parseSQLWithParams("SELECT ?, a FROM t WHERE a = ?")
+	if err != nil || n != 2 {
+		t.Fatalf("expected 2 positional parameters, got %d (%v)", n, err)
+	}
+	if _, err := ParseSQL("SELECT ?, a FROM t WHERE a = $1"); err == nil {
+		t.Error("expected an error mixing ? and $n parameters")
+	}
+}
+
+func newTestEngine(t *testing.T) (*SQLEngine, string) {
+	t.Helper()
+	docs := newMemDocStore()
+	for i := int64(0); i < 10; i++ {
+		docs.PutDocument(context.Background(), "doc_items", "", Document{"id": i, "data": fmt.Sprintf("item-%d", i)})
+	}
+	engine := NewSQLEngine(&StorageManager{docStore: docs}, transaction.NewTransactionSystem(nil), nil)
+	conn, err := engine.CreateConnection("test", "test")
+	if err != nil {
+		t.Fatal(err)
+	}
+	t.Cleanup(func() { engine.CloseConnection(conn.ID) })
+	return engine, conn.ID
+}
+
+// singleValue returns the data column of a single-row result.
+func singleValue(t *testing.T, result *SQLResult, err error) any {
+	t.Helper()
+	if err != nil {
+		t.Fatal(err)
+	}
+	if result.ResultSet == nil || len(result.ResultSet.Rows) != 1 {
+		t.Fatalf("expected one row, got %+v", result.ResultSet)
+	}
+	for i, col := range result.ResultSet.Columns {
+		if col.Name == "data" {
+			return result.ResultSet.Rows[0].Values[i]
+		}
+	}
+	t.Fatalf("no data column in %+v", result.ResultSet.Columns)
+	return nil
+}
+
+func TestSQLEngineReusesPlansAcrossLiterals(t *testing.T) {
+	engine, conn := newTestEngine(t)
+	ctx := context.Background()
+
+	for _, id := range []int{3, 7, 3} {
+		result, err := engine.ExecuteSQL(ctx, conn, fmt.Sprintf("SELECT data FROM doc_items WHERE id = %d", id))
+		if got := singleValue(t, result, err); got != fmt.Sprintf("item-%d", id) {
+			t.Errorf("id %d: got %v", id, got)
+		}
+	}
+	if hits, _, _ := engine.optimizer.planCache.GetStats(); hits != 2 {
+		t.Errorf("expected 2 plan cache hits, got %d", hits)
+	}
+
+	// New statistics must not be served stale plans.
+	engine.optimizer.stats.UpdateTableStats(&TableStatistics{TableName: "doc_items", RowCount: 10})
+	fp, _ := FingerprintQuery("SELECT data FROM doc_items WHERE id = 1")
+	if _, _, ok := engine.optimizer.CachedStatement(fp.Text); ok {
+		t.Error("plan survived a statistics update")
+	}
+}
+
+func TestSQLEnginePreparedStatements(t *testing.T) {
+	engine, conn := newTestEngine(t)
+	ctx := context.Background()
+
+	if _, err := engine.ExecuteSQL(ctx, conn, "PREPARE by_id AS SELECT data FROM doc_items WHERE id = $1"); err != nil {
+		t.Fatal(err)
+	}
+	result, err := engine.ExecuteSQL(ctx, conn, "EXECUTE by_id (4)")
+	if got := singleValue(t, result, err); got != "item-4" {
+		t.Errorf("EXECUTE returned %v", got)
+	}
+	if _, err := engine.ExecuteSQL(ctx, conn, "EXECUTE by_id"); err == nil {
+		t.Error("expected an error for a missing parameter")
+	}
+	if _, err := engine.ExecuteSQL(ctx, conn, "DEALLOCATE by_id"); err != nil {
+		t.Fatal(err)
+	}
+	if _, err := engine.ExecuteSQL(ctx, conn, "EXECUTE by_id (4)"); err == nil {
+		t.Error("expected an error executing a deallocated statement")
+	}
+
+	ps, err := engine.Prepare("SELECT data FROM doc_items WHERE id = ? LIMIT ?")
+	if err != nil {
+		t.Fatal(err)
+	}
+	if again, _ := engine.Prepare(ps.SQL); again != ps {
+		t.Error("preparing the same text twice should return the same statement")
+	}
+	result, err = engine.ExecutePrepared(ctx, conn, ps.ID, []any{int64(8), int64(1)})
+	if got := singleValue(t, result, err); got != "item-8" {
+		t.Errorf("ExecutePrepared returned %v", got)
+	}
+}
@@ -0,0 +1,321 @@
+package sql
+
+import (
+	"context"
+	"math/rand"
+	"sort"
+	"sync"
+	"time"
+)
+
+// ProfilingConfig controls sampled query profiling. A profiled query runs
+// with a timer around every operator; profiles of slow queries are kept in
+// the engine's slow plan log.
+type ProfilingConfig struct {
+	// SampleRate is the fraction of queries profiled, from 0 (never) to 1.
+	SampleRate float64
+	// Sampled queries that take at least SlowPlanThreshold are logged.
+	SlowPlanThreshold time.Duration
+	// SlowPlanLogSize is how many slow plans the log holds; older ones
+	// are overwritten.
+	SlowPlanLogSize int
+}
+
+// DefaultProfilingConfig profiles one query in a hundred and keeps the
+// last 64 that took 100ms or more.
+func DefaultProfilingConfig() *ProfilingConfig {
+	return &ProfilingConfig{
+		SampleRate:        0.01,
+		SlowPlanThreshold: 100 * time.Millisecond,
+		SlowPlanLogSize:   64,
+	}
+}
+
+// OperatorProfile is what EXPLAIN ANALYZE reports for one plan node. Time
+// includes the node's inputs, as in PostgreSQL; SelfTime and Bytes do not.
+type OperatorProfile struct {
+	Operator      string             `json:"operator"`
+	Detail        string             `json:"detail,omitempty"`
+	EstimatedRows float64            `json:"estimated_rows"`
+	EstimatedCost float64            `json:"estimated_cost"`
+	Time          time.Duration      `json:"time_ns"`
+	SelfTime      time.Duration      `json:"self_time_ns"`
+	Batches       int64              `json:"batches"`
+	RowsIn        int64              `json:"rows_in"`
+	RowsOut       int64              `json:"rows_out"`
+	Bytes         int64              `json:"bytes"`
+	PeakMemory    int64              `json:"peak_memory_bytes"`
+	Spills        int64              `json:"spills"`
+	Children      []*OperatorProfile `json:"children,omitempty"`
+
+	totalBytes int64 // bytes read by this node and its inputs
+}
+
+// QueryProfile is the profile of one query execution.
+type QueryProfile struct {
+	Query     string           `json:"query,omitempty"`
+	StartedAt time.Time        `json:"started_at"`
+	Duration  time.Duration    `json:"duration_ns"`
+	Rows      int64            `json:"rows"`
+	Error     string           `json:"error,omitempty"`
+	Plan      *OperatorProfile `json:"plan,omitempty"`
+}
+
+// profileRequest asks the executor to profile the queries run under the
+// context that carries it. done, if set, receives each finished profile.
+type profileRequest struct {
+	query  string
+	result *QueryProfile
+	done   func(*QueryProfile)
+}
+
+type profileRequestKey struct{}
+
+func withProfileRequest(ctx context.Context, req *profileRequest) context.Context {
+	return context.WithValue(ctx, profileRequestKey{}, req)
+}
+
+func profileRequestFrom(ctx context.Context) *profileRequest {
+	req, _ := ctx.Value(profileRequestKey{}).(*profileRequest)
+	return req
+}
+
+// planProfiler collects the operator profiles of one query. Operators are
+// registered while the pipeline is built, so the profile tree mirrors the
+// operator tree.
+type planProfiler struct {
+	request *profileRequest
+	root    *OperatorProfile
+	stack   []*OperatorProfile
+}
+
+// newPlanProfiler returns a profiler if ctx asks for a profile, else nil.
+func newPlanProfiler(ctx context.Context) *planProfiler {
+	req := profileRequestFrom(ctx)
+	if req == nil {
+		return nil
+	}
+	return &planProfiler{request: req}
+}
+
+// enter registers the operator for plan beneath the one being built.
+func (p *planProfiler) enter(plan *QueryPlan) *OperatorProfile {
+	node := &OperatorProfile{
+		Operator:      plan.Type.String(),
+		Detail:        planDetail(plan),
+		EstimatedRows: plan.PlanRows,
+		EstimatedCost: plan.TotalCost,
+	}
+	switch {
+	case len(p.stack) > 0:
+		parent := p.stack[len(p.stack)-1]
+		parent.Children = append(parent.Children, node)
+	case p.root == nil:
+		p.root = node
+	default:
+		p.root.Children = append(p.root.Children, node)
+	}
+	p.stack = append(p.stack, node)
+	return node
+}
+
+func (p *planProfiler) leave() {
+	p.stack = p.stack[:len(p.stack)-1]
+}
+
+// finish completes the profile and hands it to the request. It is a no-op
+// on a nil profiler, so callers need not check whether they profile.
+func (p *planProfiler) finish(start time.Time, err error) {
+	if p == nil {
+		return
+	}
+	profile := &QueryProfile{
+		Query:     p.request.query,
+		StartedAt: start,
+		Duration:  time.Since(start),
+		Plan:      p.root,
+	}
+	if p.root != nil {
+		p.root.finish()
+		profile.Rows = p.root.RowsOut
+	}
+	if err != nil {
+		profile.Error = err.Error()
+	}
+	p.request.result = profile
+	if p.request.done != nil {
+		p.request.done(profile)
+	}
+}
+
+// finish derives the per-node figures from the inclusive ones recorded.
+func (n *OperatorProfile) finish() {
+	childTime := time.Duration(0)
+	childBytes := int64(0)
+	n.RowsIn = 0
+	for _, c := range n.Children {
+		c.finish()
+		childTime += c.Time
+		childBytes += c.totalBytes
+		n.RowsIn += c.RowsOut
+	}
+	n.SelfTime = max(n.Time-childTime, 0)
+	n.Bytes = max(n.totalBytes-childBytes, 0)
+}
+
+// profiledOperator times an operator. It reads the clock once per call,
+// that is once per batch, so profiling costs a few clock reads per
+// BatchSize rows rather than per row.
+type profiledOperator struct {
+	Operator
+	profile *OperatorProfile
+	stats   *ExecutionStats
+}
+
+func (p *profiledOperator) Open(ctx *ExecutionContext) error {
+	p.stats = ctx.Stats
+	start, bytes := time.Now(), p.stats.BytesProcessed
+	err := p.Operator.Open(ctx)
+	p.record(start, bytes)
+	return err
+}
+
+func (p *profiledOperator) NextBatch() (*RowBatch, error) {
+	start, bytes := time.Now(), p.stats.BytesProcessed
+	batch, err := p.Operator.NextBatch()
+	p.record(start, bytes)
+	if batch != nil {
+		p.profile.Batches++
+		p.profile.RowsOut += int64(len(batch.Rows))
+	}
+	return batch, err
+}
+
+func (p *profiledOperator) Close() error {
+	if p.stats == nil {
+		return p.Operator.Close()
+	}
+	start, bytes := time.Now(), p.stats.BytesProcessed
+	err := p.Operator.Close()
+	p.record(start, bytes)
+	if op, ok := stripFilters(p.Operator).(interface{ memoryStats() spillStats }); ok {
+		stats := op.memoryStats()
+		p.profile.PeakMemory, p.profile.Spills = stats.peakMemory, stats.spills
+	}
+	return err
+}
+
+func (p *profiledOperator) record(start time.Time, bytes int64) {
+	p.profile.Time += time.Since(start)
+	p.profile.totalBytes += p.stats.BytesProcessed - bytes
+}
+
+// unwrapOperator returns the operator a profiling wrapper times, so type
+// checks on operators see through profiling.
+func unwrapOperator(op Operator) Operator {
+	for {
+		p, ok := op.(*profiledOperator)
+		if !ok {
+			return op
+		}
+		op = p.Operator
+	}
+}
+
+// stripFilters returns the operator beneath any filters and profiling.
+func stripFilters(op Operator) Operator {
+	for {
+		switch o := op.(type) {
+		case *profiledOperator:
+			op = o.Operator
+		case *filterOperator:
+			op = o.child
+		default:
+			return op
+		}
+	}
+}
+
+// SlowPlanLog is a fixed-size ring of the most recent slow query profiles.
+type SlowPlanLog struct {
+	mu      sync.Mutex
+	entries []*QueryProfile
+	next    int
+	full    bool
+}
+
+// NewSlowPlanLog returns a log that holds size profiles.
+func NewSlowPlanLog(size int) *SlowPlanLog {
+	if size < 1 {
+		size = 1
+	}
+	return &SlowPlanLog{entries: make([]*QueryProfile, size)}
+}
+
+// Add records a profile, overwriting the oldest once the log is full.
+func (l *SlowPlanLog) Add(profile *QueryProfile) {
+	l.mu.Lock()
+	l.entries[l.next] = profile
+	l.next++
+	if l.next == len(l.entries) {
+		l.next = 0
+		l.full = true
+	}
+	l.mu.Unlock()
+}
+
+// Entries returns the logged profiles, slowest first.
+func (l *SlowPlanLog) Entries() []*QueryProfile {
+	l.mu.Lock()
+	n := l.next
+	if l.full {
+		n = len(l.entries)
+	}
+	entries := make([]*QueryProfile, n)
+	copy(entries, l.entries[:n])
+	l.mu.Unlock()
+
+	sort.Slice(entries, func(i, j int) bool {
+		return entries[i].Duration > entries[j].Duration
+	})
+	return entries
+}
+
+// Reset empties the log.
+func (l *SlowPlanLog) Reset() {
+	l.mu.Lock()
+	clear(l.entries)
+	l.next, l.full = 0, false
+	l.mu.Unlock()
+}
+
+// sampleQuery marks a SampleRate fraction of queries for profiling. A
+// context that already asks for a profile is left alone.
+func (se *SQLEngine) sampleQuery(ctx context.Context, sqlText string) context.Context {
+	config := se.config.Profiling
+	if config == nil || config.SampleRate <= 0 || profileRequestFrom(ctx) != nil {
+		return ctx
+	}
+	if config.SampleRate < 1 && rand.Float64() >= config.SampleRate {
+		return ctx
+	}
+	return withProfileRequest(ctx, &profileRequest{query: sqlText, done: se.noteProfile})
+}
+
+// noteProfile logs the profile of a slow query.
+func (se *SQLEngine) noteProfile(profile *QueryProfile) {
+	if config := se.config.Profiling; config != nil && profile.Duration >= config.SlowPlanThreshold {
+		se.slowPlans.Add(profile)
+	}
+}
+
+// SlowPlans returns the profiles of recent slow sampled queries, slowest
+// first.
+func (se *SQLEngine) SlowPlans() []*QueryProfile {
+	return se.slowPlans.Entries()
+}
+
+// ResetSlowPlans empties the slow plan log.
+func (se *SQLEngine) ResetSlowPlans() {
+	se.slowPlans.Reset()
+}
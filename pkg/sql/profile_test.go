@@ -0,0 +1,108 @@
+package sql
+
+import (
+	"context"
+	"fmt"
+	"strings"
+	"testing"
+	"time"
+
+	"mantisDB/transaction"
+)
+
+func newProfilingEngine(t *testing.T, profiling *ProfilingConfig) (*SQLEngine, string) {
+	t.Helper()
+	kv := newMemKVStore()
+	for i := 0; i < 3000; i++ {
+		kv.Put(context.Background(), []byte(fmt.Sprintf("kv_events/%05d", i)), []byte(fmt.Sprintf("e-%d", i%10)))
+	}
+	config := DefaultSQLEngineConfig()
+	config.Profiling = profiling
+	engine := NewSQLEngine(&StorageManager{kvStore: kv}, transaction.NewTransactionSystem(nil), config)
+	conn, err := engine.CreateConnection("test", "test")
+	if err != nil {
+		t.Fatal(err)
+	}
+	t.Cleanup(func() { engine.CloseConnection(conn.ID) })
+	return engine, conn.ID
+}
+
+func TestExplainAnalyzeReportsOperators(t *testing.T) {
+	engine, connID := newProfilingEngine(t, &ProfilingConfig{})
+
+	result, err := engine.ExecuteSQL(context.Background(), connID, "EXPLAIN ANALYZE SELECT * FROM kv_events WHERE data <> 'e-3'")
+	if err != nil {
+		t.Fatal(err)
+	}
+	rs := result.ResultSet
+	if rs == nil || len(rs.Columns) != 1 || rs.Columns[0].Name != "QUERY PLAN" {
+		t.Fatalf("unexpected result %+v", rs)
+	}
+	var lines []string
+	for _, row := range rs.Rows {
+		lines = append(lines, row.Values[0].(string))
+	}
+	output := strings.Join(lines, "\n")
+	if !strings.HasPrefix(lines[0], "Seq Scan on kv_events") {
+		t.Errorf("first line %q, want the scan", lines[0])
+	}
+	for _, want := range []string{"actual time=", "out=2700", "Rows: 2700", "Execution Time:"} {
+		if !strings.Contains(output, want) {
+			t.Errorf("EXPLAIN ANALYZE output lacks %q:\n%s", want, output)
+		}
+	}
+
+	// Plain EXPLAIN shows estimates without running the query.
+	result, err = engine.ExecuteSQL(context.Background(), connID, "EXPLAIN SELECT * FROM kv_events")
+	if err != nil {
+		t.Fatal(err)
+	}
+	if line := result.ResultSet.Rows[0].Values[0].(string); !strings.Contains(line, "cost=") || strings.Contains(line, "actual") {
+		t.Errorf("EXPLAIN line %q", line)
+	}
+
+	if _, err := engine.ExecuteSQL(context.Background(), connID, "EXPLAIN ANALYZE DELETE FROM kv_events"); err == nil {
+		t.Error("EXPLAIN ANALYZE DELETE succeeded")
+	}
+}
+
+func TestSampledProfilesFillSlowPlanLog(t *testing.T) {
+	engine, connID := newProfilingEngine(t, &ProfilingConfig{SampleRate: 1, SlowPlanLogSize: 4})
+
+	for i := 0; i < 6; i++ {
+		if _, err := engine.ExecuteSQL(context.Background(), connID, "SELECT * FROM kv_events"); err != nil {
+			t.Fatal(err)
+		}
+	}
+	plans := engine.SlowPlans()
+	if len(plans) != 4 {
+		t.Fatalf("slow plan log holds %d plans, want 4", len(plans))
+	}
+	for i, p := range plans {
+		if p.Plan == nil || p.Rows != 3000 || p.Query != "SELECT * FROM kv_events" {
+			t.Fatalf("unexpected profile %+v", p)
+		}
+		if i > 0 && p.Duration > plans[i-1].Duration {
+			t.Error("slow plans not sorted slowest first")
+		}
+	}
+
+	engine.ResetSlowPlans()
+	if n := len(engine.SlowPlans()); n != 0 {
+		t.Errorf("%d plans left after reset", n)
+	}
+}
+
+func TestSlowPlanLogKeepsNewest(t *testing.T) {
+	log := NewSlowPlanLog(3)
+	for i := 1; i <= 5; i++ {
+		log.Add(&QueryProfile{Query: fmt.Sprint(i), Duration: time.Duration(i)})
+	}
+	var got []string
+	for _, p := range log.Entries() {
+		got = append(got, p.Query)
+	}
+	if strings.Join(got, ",") != "5,4,3" {
+		t.Errorf("entries %v, want 5,4,3", got)
+	}
+}
@@ -0,0 +1,221 @@
+package sql
+
+import "math"
+
+// defaultSelectivity is assumed for a qualifier the statistics cannot
+// answer; it is the estimate the optimizer used before ANALYZE existed.
+const defaultSelectivity = 0.1
+
+// defaultRangeSelectivity is assumed for a range over an analyzed column
+// when the bound is not known at plan time.
+const defaultRangeSelectivity = 1.0 / 3
+
+// minSelectivity keeps estimates away from zero rows, which would make
+// every plan above them look free.
+const minSelectivity = 1e-6
+
+// Selectivity estimates the fraction of a table's rows that satisfy all
+// of quals, assuming the qualifiers are independent.
+func (cm *CostModel) Selectivity(quals []Expression, stats *TableStatistics) float64 {
+	selectivity := 1.0
+	for _, qual := range quals {
+		selectivity *= cm.clauseSelectivity(qual, stats)
+	}
+	return clampSelectivity(selectivity)
+}
+
+func (cm *CostModel) clauseSelectivity(expr Expression, stats *TableStatistics) float64 {
+	switch e := expr.(type) {
+	case *UnaryExpression:
+		if e.Operator == UnaryOpNot {
+			return 1 - cm.clauseSelectivity(e.Operand, stats)
+		}
+	case *BinaryExpression:
+		switch e.Operator {
+		case OpAnd:
+			return cm.clauseSelectivity(e.Left, stats) * cm.clauseSelectivity(e.Right, stats)
+		case OpOr:
+			l, r := cm.clauseSelectivity(e.Left, stats), cm.clauseSelectivity(e.Right, stats)
+			return l + r - l*r
+		}
+		return cm.comparisonSelectivity(e, stats)
+	}
+	return defaultSelectivity
+}
+
+// comparisonSelectivity handles column-versus-constant comparisons, the
+// only shape column statistics describe.
+func (cm *CostModel) comparisonSelectivity(e *BinaryExpression, stats *TableStatistics) float64 {
+	op := e.Operator
+	column, other := e.Left, e.Right
+	if _, ok := column.(*IdentifierExpression); !ok {
+		column, other = e.Right, e.Left
+		op = commuteOperator(op)
+	}
+	ident, ok := column.(*IdentifierExpression)
+	if !ok || stats == nil {
+		return defaultSelectivity
+	}
+	col := stats.Columns[ident.Name]
+	if col == nil {
+		return defaultSelectivity
+	}
+
+	if op == OpIn || op == OpNotIn {
+		elements := []Expression{other}
+		if lit, ok := other.(*LiteralExpression); ok {
+			if list, ok := lit.Value.([]Expression); ok {
+				elements = list
+			}
+		}
+		selectivity := 0.0
+		for _, elem := range elements {
+			value, known := constantValue(elem)
+			selectivity += equalitySelectivity(col, value, known)
+		}
+		selectivity = math.Min(selectivity, 1-col.NullFraction)
+		if op == OpNotIn {
+			return 1 - col.NullFraction - selectivity
+		}
+		return selectivity
+	}
+
+	value, known := constantValue(other)
+	if known && value == nil {
+		// IS NULL and IS NOT NULL parse as comparisons with NULL.
+		switch op {
+		case OpEqual:
+			return col.NullFraction
+		case OpNotEqual:
+			return 1 - col.NullFraction
+		}
+		return defaultSelectivity
+	}
+
+	switch op {
+	case OpEqual:
+		return equalitySelectivity(col, value, known)
+	case OpNotEqual:
+		return 1 - col.NullFraction - equalitySelectivity(col, value, known)
+	case OpLess, OpLessEqual, OpGreater, OpGreaterEqual:
+		if !known {
+			return defaultRangeSelectivity
+		}
+		return rangeSelectivity(col, op, value)
+	}
+	return defaultSelectivity
+}
+
+// equalitySelectivity is the frequency of a most-common value, or an even
+// share of the remaining rows among the remaining distinct values.
+func equalitySelectivity(col *ColumnStatistics, value any, known bool) float64 {
+	if known {
+		for _, mcv := range col.MostCommon {
+			if statsCompare(mcv.Value, value) == 0 {
+				return mcv.Frequency
+			}
+		}
+	}
+	others := col.NDistinct - float64(len(col.MostCommon))
+	if others < 1 {
+		if !known || col.NDistinct == 0 {
+			return defaultSelectivity
+		}
+		// Every value is a most-common value and this is not one.
+		return minSelectivity
+	}
+	return remainingFraction(col) / others
+}
+
+// rangeSelectivity adds the most-common values that satisfy the range to
+// the histogram's share of the rest.
+func rangeSelectivity(col *ColumnStatistics, op BinaryOperator, value any) float64 {
+	selectivity := 0.0
+	for _, mcv := range col.MostCommon {
+		cmp := statsCompare(mcv.Value, value)
+		if (op == OpLess && cmp < 0) || (op == OpLessEqual && cmp <= 0) ||
+			(op == OpGreater && cmp > 0) || (op == OpGreaterEqual && cmp >= 0) {
+			selectivity += mcv.Frequency
+		}
+	}
+	if len(col.Histogram) >= 2 {
+		below := histogramFraction(col.Histogram, value)
+		if op == OpGreater || op == OpGreaterEqual {
+			below = 1 - below
+		}
+		selectivity += below * remainingFraction(col)
+	} else if len(col.MostCommon) == 0 {
+		return defaultRangeSelectivity
+	}
+	return selectivity
+}
+
+// remainingFraction is the fraction of rows that are neither NULL nor a
+// most-common value, which is what the histogram describes.
+func remainingFraction(col *ColumnStatistics) float64 {
+	fraction := 1 - col.NullFraction
+	for _, mcv := range col.MostCommon {
+		fraction -= mcv.Frequency
+	}
+	return math.Max(fraction, 0)
+}
+
+// histogramFraction returns the fraction of an equi-depth histogram's
+// population below value, interpolating linearly inside a numeric bucket.
+func histogramFraction(bounds []ColumnValue, value any) float64 {
+	last := len(bounds) - 1
+	if statsCompare(value, bounds[0].Value) <= 0 {
+		return 0
+	}
+	if statsCompare(value, bounds[last].Value) >= 0 {
+		return 1
+	}
+	// Bounds are sorted; find the bucket whose upper bound exceeds value.
+	lo, hi := 0, last
+	for hi-lo > 1 {
+		mid := (lo + hi) / 2
+		if statsCompare(value, bounds[mid].Value) < 0 {
+			hi = mid
+		} else {
+			lo = mid
+		}
+	}
+	within := 0.5
+	if v, ok := toFloat64(value); ok {
+		l, lok := toFloat64(bounds[lo].Value)
+		h, hok := toFloat64(bounds[hi].Value)
+		if lok && hok && h > l {
+			within = (v - l) / (h - l)
+		}
+	}
+	return (float64(lo) + within) / float64(last)
+}
+
+// constantValue returns the value of a literal. Parameters and other
+// expressions are not known until execution.
+func constantValue(expr Expression) (any, bool) {
+	if lit, ok := expr.(*LiteralExpression); ok {
+		return lit.Value, true
+	}
+	return nil, false
+}
+
+// commuteOperator returns the operator for the comparison with its
+// operands swapped.
+func commuteOperator(op BinaryOperator) BinaryOperator {
+	switch op {
+	case OpLess:
+		return OpGreater
+	case OpLessEqual:
+		return OpGreaterEqual
+	case OpGreater:
+		return OpLess
+	case OpGreaterEqual:
+		return OpLessEqual
+	}
+	return op
+}
+
+func clampSelectivity(s float64) float64 {
+	return math.Min(math.Max(s, minSelectivity), 1)
+}
@@ -0,0 +1,642 @@
+package sql
+
+import (
+	"bytes"
+	"container/heap"
+	"encoding/binary"
+	"fmt"
+	"math"
+	"sort"
+	"time"
+)
+
+const (
+	// topKMaxRows bounds the ORDER BY ... LIMIT heap; larger limits use the
+	// regular external sort and let the limit operator cut the output.
+	topKMaxRows = 100000
+	// sortMaxFanIn is the number of runs merged at once. More runs are first
+	// merged into longer runs so the final merge keeps few files open.
+	sortMaxFanIn = 64
+	// sortEntryOverhead approximates the per-row bookkeeping of a sortEntry.
+	sortEntryOverhead = 48
+)
+
+// sortOperator is a blocking operator: it consumes its whole input on the
+// first NextBatch and then emits the sorted rows in batches.
+//
+// Every row's sort keys are encoded once into a normalized byte string whose
+// bytewise order is the ORDER BY order, so sorting and merging compare with
+// bytes.Compare instead of type-switching on every comparison. Rows are
+// buffered up to ExecutorConfig.WorkMem; past that each buffer is sorted and
+// written out as a run, and the runs are k-way merged on output. With a
+// LIMIT above it only the first topK rows are kept, in a bounded heap.
+type sortOperator struct {
+	child     Operator
+	keys      []SortKey
+	batchSize int
+	memLimit  int64
+	topK      int64 // -1 sorts the whole input
+	ctx       *ExecutionContext
+	enc       sortKeyEncoder
+
+	entries []sortEntry
+	arena   []byte // backing store for entry keys
+	scratch []byte
+	memUsed int64
+	seq     int64
+	runs    []*spillFile
+	merge   *runMerger
+	pos     int
+	sorted  bool
+	spillStats
+}
+
+// sortEntry is a buffered row with its normalized key. seq is the input
+// position, which breaks ties so the sort is stable.
+type sortEntry struct {
+	key []byte
+	seq int64
+	row Row
+}
+
+func (e *sortEntry) less(o *sortEntry) bool {
+	c := bytes.Compare(e.key, o.key)
+	return c < 0 || (c == 0 && e.seq < o.seq)
+}
+
+func newSortOperator(child Operator, keys []SortKey, batchSize int, memLimit int64) *sortOperator {
+	return &sortOperator{child: child, keys: keys, batchSize: batchSize, memLimit: memLimit, topK: -1}
+}
+
+// setTopK limits the output to the first n rows in sort order.
+func (s *sortOperator) setTopK(n int64) {
+	if n <= topKMaxRows {
+		s.topK = n
+	}
+}
+
+func (s *sortOperator) Open(ctx *ExecutionContext) error {
+	s.ctx = ctx
+	if err := s.child.Open(ctx); err != nil {
+		return err
+	}
+	enc, err := newSortKeyEncoder(s.keys, s.child, ctx.Parameters)
+	if err != nil {
+		s.child.Close()
+		return err
+	}
+	s.enc = enc
+	return nil
+}
+
+func (s *sortOperator) NextBatch() (*RowBatch, error) {
+	if !s.sorted {
+		if err := s.consume(); err != nil {
+			return nil, err
+		}
+	}
+
+	if s.merge != nil {
+		rows := make([]Row, 0, s.batchSize)
+		for len(rows) < s.batchSize {
+			row, ok, err := s.merge.next()
+			if err != nil {
+				return nil, err
+			}
+			if !ok {
+				break
+			}
+			rows = append(rows, row)
+		}
+		if len(rows) == 0 {
+			return nil, nil
+		}
+		return &RowBatch{Rows: rows}, nil
+	}
+
+	if s.pos >= len(s.entries) {
+		return nil, nil
+	}
+	end := s.pos + s.batchSize
+	if end > len(s.entries) {
+		end = len(s.entries)
+	}
+	rows := make([]Row, end-s.pos)
+	for i := range rows {
+		rows[i] = s.entries[s.pos+i].row
+	}
+	s.pos = end
+	return &RowBatch{Rows: rows}, nil
+}
+
+func (s *sortOperator) consume() error {
+	for {
+		if err := checkCancelled(s.ctx); err != nil {
+			return err
+		}
+		batch, err := s.child.NextBatch()
+		if err != nil {
+			return err
+		}
+		if batch == nil {
+			break
+		}
+		for _, row := range batch.Rows {
+			if s.topK >= 0 {
+				if err := s.offerTopK(row); err != nil {
+					return err
+				}
+				continue
+			}
+			s.scratch, err = s.enc.appendKey(s.scratch[:0], row)
+			if err != nil {
+				return err
+			}
+			s.entries = append(s.entries, sortEntry{key: s.storeKey(s.scratch), seq: s.seq, row: row})
+			s.seq++
+			s.memUsed += rowFootprint(row) + int64(len(s.scratch)) + sortEntryOverhead
+			s.noteMemory(s.memUsed)
+			if s.memUsed > s.memLimit {
+				if err := s.spillRun(); err != nil {
+					return err
+				}
+			}
+		}
+	}
+
+	if len(s.runs) > 0 {
+		if len(s.entries) > 0 {
+			if err := s.spillRun(); err != nil {
+				return err
+			}
+		}
+		merge, err := s.mergeRuns()
+		if err != nil {
+			return err
+		}
+		s.merge = merge
+	} else {
+		s.sortEntries()
+	}
+	s.sorted = true
+	s.ctx.Stats.SortsExecuted++
+	return nil
+}
+
+// offerTopK keeps row if it is among the topK smallest seen so far. The
+// buffer is a max-heap, so the row to evict is always at the root and most
+// rows are rejected after one key comparison.
+func (s *sortOperator) offerTopK(row Row) error {
+	seq := s.seq
+	s.seq++
+	if s.topK == 0 {
+		return nil
+	}
+	var err error
+	s.scratch, err = s.enc.appendKey(s.scratch[:0], row)
+	if err != nil {
+		return err
+	}
+	h := (*sortEntryMaxHeap)(&s.entries)
+	if int64(len(s.entries)) < s.topK {
+		heap.Push(h, sortEntry{key: append([]byte(nil), s.scratch...), seq: seq, row: row})
+		return nil
+	}
+	worst := &s.entries[0]
+	if bytes.Compare(s.scratch, worst.key) >= 0 {
+		return nil
+	}
+	worst.key = append(worst.key[:0], s.scratch...)
+	worst.seq = seq
+	worst.row = row
+	heap.Fix(h, 0)
+	return nil
+}
+
+// storeKey copies key into the arena so buffered keys share a few large
+// allocations.
+func (s *sortOperator) storeKey(key []byte) []byte {
+	if cap(s.arena)-len(s.arena) < len(key) {
+		size := 64 * 1024
+		if len(key) > size {
+			size = len(key)
+		}
+		s.arena = make([]byte, 0, size)
+	}
+	start := len(s.arena)
+	s.arena = append(s.arena, key...)
+	return s.arena[start:len(s.arena):len(s.arena)]
+}
+
+func (s *sortOperator) sortEntries() {
+	sort.Slice(s.entries, func(i, j int) bool {
+		return s.entries[i].less(&s.entries[j])
+	})
+}
+
+// spillRun sorts the buffered rows and writes them out as one run.
+func (s *sortOperator) spillRun() error {
+	s.sortEntries()
+	run, err := newSpillFile()
+	if err != nil {
+		return err
+	}
+	s.runs = append(s.runs, run)
+	s.spills++
+	for i := range s.entries {
+		if err := run.writeRow(s.entries[i].row); err != nil {
+			return err
+		}
+	}
+	s.entries, s.arena, s.memUsed = s.entries[:0], nil, 0
+	return nil
+}
+
+// mergeRuns reduces the runs to at most sortMaxFanIn and returns a merger
+// over them.
+func (s *sortOperator) mergeRuns() (*runMerger, error) {
+	for len(s.runs) > sortMaxFanIn {
+		batch := s.runs[:sortMaxFanIn]
+		s.runs = s.runs[sortMaxFanIn:]
+		m, err := newRunMerger(batch, &s.enc)
+		if err != nil {
+			return nil, err
+		}
+		merged, err := newSpillFile()
+		if err != nil {
+			m.close()
+			return nil, err
+		}
+		for {
+			row, ok, err := m.next()
+			if err == nil && ok {
+				err = merged.writeRow(row)
+			}
+			if err != nil {
+				m.close()
+				merged.close()
+				return nil, err
+			}
+			if !ok {
+				break
+			}
+		}
+		// The merged rows precede the remaining runs in input order, so the
+		// merged run goes first to keep ties stable.
+		s.runs = append([]*spillFile{merged}, s.runs...)
+	}
+	runs := s.runs
+	s.runs = nil
+	return newRunMerger(runs, &s.enc)
+}
+
+func (s *sortOperator) Close() error {
+	var firstErr error
+	for _, run := range s.runs {
+		if err := run.close(); err != nil && firstErr == nil {
+			firstErr = err
+		}
+	}
+	if s.merge != nil {
+		if err := s.merge.close(); err != nil && firstErr == nil {
+			firstErr = err
+		}
+	}
+	s.runs, s.merge, s.entries, s.arena = nil, nil, nil, nil
+	if err := s.child.Close(); err != nil && firstErr == nil {
+		firstErr = err
+	}
+	return firstErr
+}
+
+func (s *sortOperator) Columns() []ColumnInfo { return s.child.Columns() }
+
+// sortEntryMaxHeap orders entries largest first, for the top-k buffer.
+type sortEntryMaxHeap []sortEntry
+
+func (h sortEntryMaxHeap) Len() int           { return len(h) }
+func (h sortEntryMaxHeap) Less(i, j int) bool { return h[j].less(&h[i]) }
+func (h sortEntryMaxHeap) Swap(i, j int)      { h[i], h[j] = h[j], h[i] }
+func (h *sortEntryMaxHeap) Push(x any)        { *h = append(*h, x.(sortEntry)) }
+func (h *sortEntryMaxHeap) Pop() any {
+	old := *h
+	e := old[len(old)-1]
+	*h = old[:len(old)-1]
+	return e
+}
+
+// sortRun is the read cursor of one sorted run during a merge.
+type sortRun struct {
+	file *spillFile
+	row  Row
+	key  []byte
+	idx  int // run order, which breaks ties so the merge is stable
+}
+
+// runMerger k-way merges sorted runs through a min-heap of their cursors.
+type runMerger struct {
+	heap []*sortRun
+	enc  *sortKeyEncoder
+}
+
+func newRunMerger(files []*spillFile, enc *sortKeyEncoder) (*runMerger, error) {
+	m := &runMerger{enc: enc}
+	for i, f := range files {
+		r := &sortRun{file: f, idx: i}
+		if err := f.rewind(); err != nil {
+			m.close()
+			closeSpillFiles(files[i:])
+			return nil, err
+		}
+		ok, err := m.advance(r)
+		if err != nil {
+			m.close()
+			closeSpillFiles(files[i:])
+			return nil, err
+		}
+		if ok {
+			m.heap = append(m.heap, r)
+		} else {
+			f.close()
+		}
+	}
+	heap.Init(m)
+	return m, nil
+}
+
+func closeSpillFiles(files []*spillFile) {
+	for _, f := range files {
+		f.close()
+	}
+}
+
+func (m *runMerger) advance(r *sortRun) (bool, error) {
+	row, ok, err := r.file.readRow()
+	if err != nil || !ok {
+		return false, err
+	}
+	r.row = row
+	r.key, err = m.enc.appendKey(r.key[:0], row)
+	return err == nil, err
+}
+
+// next returns the smallest remaining row across all runs.
+func (m *runMerger) next() (Row, bool, error) {
+	if len(m.heap) == 0 {
+		return Row{}, false, nil
+	}
+	top := m.heap[0]
+	row := top.row
+	ok, err := m.advance(top)
+	if err != nil {
+		return Row{}, false, err
+	}
+	if ok {
+		heap.Fix(m, 0)
+	} else {
+		heap.Pop(m)
+		if err := top.file.close(); err != nil {
+			return Row{}, false, err
+		}
+	}
+	return row, true, nil
+}
+
+func (m *runMerger) close() error {
+	var firstErr error
+	for _, r := range m.heap {
+		if err := r.file.close(); err != nil && firstErr == nil {
+			firstErr = err
+		}
+	}
+	m.heap = nil
+	return firstErr
+}
+
+func (m *runMerger) Len() int { return len(m.heap) }
+func (m *runMerger) Less(i, j int) bool {
+	c := bytes.Compare(m.heap[i].key, m.heap[j].key)
+	return c < 0 || (c == 0 && m.heap[i].idx < m.heap[j].idx)
+}
+func (m *runMerger) Swap(i, j int) { m.heap[i], m.heap[j] = m.heap[j], m.heap[i] }
+func (m *runMerger) Push(x any)    { m.heap = append(m.heap, x.(*sortRun)) }
+func (m *runMerger) Pop() any {
+	r := m.heap[len(m.heap)-1]
+	m.heap = m.heap[:len(m.heap)-1]
+	return r
+}
+
+// sortKeyEncoder writes the normalized sort key of a row. Each key column
+// contributes a NULL marker placed according to NULLS FIRST/LAST, then a
+// kind tag and an order-preserving, prefix-free encoding of the value;
+// DESC columns have their value bytes inverted. Numbers of any Go type
+// share one encoding, so ints and floats interleave correctly. Values of
+// different kinds order by kind: bool, number, string, time, other.
+type sortKeyEncoder struct {
+	cols []sortKeyColumn
+	env  evalEnv
+	// aggregates maps the aggregate calls used by key expressions to the
+	// input columns holding their results.
+	aggregates map[string]int
+}
+
+// sortKeyColumn is an input column, or an expression evaluated per row
+// when expr is set.
+type sortKeyColumn struct {
+	idx        int
+	expr       Expression
+	desc       bool
+	nullsFirst bool
+}
+
+const (
+	sortNullFirst byte = 0x00
+	sortNotNull   byte = 0x01
+	sortNullLast  byte = 0x02
+)
+
+const (
+	sortKindBool byte = iota + 1
+	sortKindNumber
+	sortKindString
+	sortKindTime
+	sortKindOther
+)
+
+// newSortKeyEncoder resolves sort keys against the rows of input once: a
+// position, a column, or a select list expression an aggregate below
+// already computed becomes a column position, and any other expression is
+// evaluated per row. Keys referring to anything the input does not have
+// are an error.
+func newSortKeyEncoder(keys []SortKey, input Operator, params []any) (sortKeyEncoder, error) {
+	columns := input.Columns()
+	enc := sortKeyEncoder{env: evalEnv{columns: operatorColumnIndex(input), params: params}}
+	targets := outputTargets(input)
+
+	for _, key := range keys {
+		col := sortKeyColumn{idx: -1, desc: key.Direction == Descending, nullsFirst: key.NullsFirst}
+		expr := key.Expression
+		if expr == nil && key.Ordinal == 0 {
+			expr = NewIdentifier(key.Column)
+		}
+		if key.Ordinal > 0 {
+			if key.Ordinal > len(columns) {
+				return sortKeyEncoder{}, fmt.Errorf("ORDER BY position %d is not in select list", key.Ordinal)
+			}
+			col.idx = key.Ordinal - 1
+		} else if idx, ok := enc.resolveColumn(expr, targets); ok {
+			col.idx = idx
+		} else if err := enc.bind(expr, targets); err != nil {
+			return sortKeyEncoder{}, err
+		} else {
+			col.expr = expr
+		}
+		enc.cols = append(enc.cols, col)
+	}
+	if len(enc.aggregates) > 0 {
+		enc.env.aggregates = make(map[string]any, len(enc.aggregates))
+	}
+	return enc, nil
+}
+
+// resolveColumn finds the input column holding expr: a column of that name,
+// or the aggregate output for a matching select list entry.
+func (e *sortKeyEncoder) resolveColumn(expr Expression, targets []TargetEntry) (int, bool) {
+	if id, ok := expr.(*IdentifierExpression); ok {
+		if idx, ok := lookupColumn(e.env.columns, id); ok {
+			return idx, true
+		}
+	}
+	key := expressionKey(expr)
+	for i, target := range targets {
+		if expressionKey(target.Expression) == key {
+			return i, true
+		}
+	}
+	return -1, false
+}
+
+// bind checks that every column and aggregate expr references exists in
+// the input, and records where the aggregate results are.
+func (e *sortKeyEncoder) bind(expr Expression, targets []TargetEntry) error {
+	err := checkReferences(expr, e.env.columns, func(call *FunctionCall) error {
+		idx, ok := e.resolveColumn(call, targets)
+		if !ok {
+			return fmt.Errorf("aggregate %s must appear in the select list", expressionKey(call))
+		}
+		if e.aggregates == nil {
+			e.aggregates = make(map[string]int)
+		}
+		e.aggregates[expressionKey(call)] = idx
+		return nil
+	})
+	if err != nil {
+		return fmt.Errorf("ORDER BY: %w", err)
+	}
+	return nil
+}
+
+func (e *sortKeyEncoder) appendKey(buf []byte, row Row) ([]byte, error) {
+	if e.env.aggregates != nil {
+		for key, idx := range e.aggregates {
+			if idx < len(row.Values) {
+				e.env.aggregates[key] = row.Values[idx]
+			}
+		}
+	}
+	for _, col := range e.cols {
+		var v any
+		if col.expr != nil {
+			e.env.row = row
+			var err error
+			if v, err = evaluateExpression(col.expr, &e.env); err != nil {
+				return nil, err
+			}
+		} else if col.idx < len(row.Values) {
+			v = row.Values[col.idx]
+		}
+		if v == nil {
+			if col.nullsFirst {
+				buf = append(buf, sortNullFirst)
+			} else {
+				buf = append(buf, sortNullLast)
+			}
+			continue
+		}
+		buf = append(buf, sortNotNull)
+		start := len(buf)
+		buf = appendSortValue(buf, v)
+		if col.desc {
+			for i := start; i < len(buf); i++ {
+				buf[i] = ^buf[i]
+			}
+		}
+	}
+	return buf, nil
+}
+
+func appendSortValue(buf []byte, v any) []byte {
+	if i, ok := toInt64(v); ok {
+		buf = appendOrderedFloat(append(buf, sortKindNumber), float64(i))
+		return appendOrderedInt(buf, i)
+	}
+	if f, ok := toFloat64(v); ok {
+		// The float sorts the number; the integer part breaks ties between
+		// an int64 and the float it rounds to.
+		buf = appendOrderedFloat(append(buf, sortKindNumber), f)
+		tie := int64(math.MaxInt64)
+		if f >= math.MinInt64 && f < math.MaxInt64 {
+			tie = int64(f)
+		} else if f < 0 {
+			tie = math.MinInt64
+		}
+		return appendOrderedInt(buf, tie)
+	}
+	switch x := v.(type) {
+	case string:
+		return appendOrderedString(append(buf, sortKindString), x)
+	case []byte:
+		return appendOrderedString(append(buf, sortKindString), string(x))
+	case bool:
+		if x {
+			return append(buf, sortKindBool, 1)
+		}
+		return append(buf, sortKindBool, 0)
+	case time.Time:
+		buf = appendOrderedInt(append(buf, sortKindTime), x.Unix())
+		return binary.BigEndian.AppendUint32(buf, uint32(x.Nanosecond()))
+	}
+	buf = appendOrderedString(append(buf, sortKindOther), fmt.Sprintf("%T", v))
+	return appendOrderedString(buf, fmt.Sprint(v))
+}
+
+func appendOrderedInt(buf []byte, i int64) []byte {
+	return binary.BigEndian.AppendUint64(buf, uint64(i)^(1<<63))
+}
+
+func appendOrderedFloat(buf []byte, f float64) []byte {
+	if f == 0 {
+		f = 0 // fold -0 into +0
+	}
+	bits := math.Float64bits(f)
+	if bits&(1<<63) == 0 {
+		bits |= 1 << 63
+	} else {
+		bits = ^bits
+	}
+	return binary.BigEndian.AppendUint64(buf, bits)
+}
+
+// appendOrderedString escapes 0x00 as 0x00 0xFF and terminates with
+// 0x00 0x01, so shorter strings sort first and no encoding is a prefix of
+// another.
+func appendOrderedString(buf []byte, s string) []byte {
+	for i := 0; i < len(s); i++ {
+		if s[i] == 0 {
+			buf = append(buf, 0x00, 0xFF)
+		} else {
+			buf = append(buf, s[i])
+		}
+	}
+	return append(buf, 0x00, 0x01)
+}
@@ -0,0 +1,238 @@
+package sql
+
+import (
+	"bufio"
+	"encoding/binary"
+	"fmt"
+	"io"
+	"math"
+	"os"
+	"time"
+)
+
+// spillFile is a temporary run of rows written by an operator that went over
+// its memory budget. Rows are appended, the file is rewound once, and then
+// read back sequentially. The file is removed on close.
+type spillFile struct {
+	f    *os.File
+	w    *bufio.Writer
+	r    *bufio.Reader
+	buf  []byte
+	rows int64
+}
+
+// spillStats records the most memory a buffering operator held and how
+// many times it spilled, for query profiles. Operators embed it.
+type spillStats struct {
+	peakMemory int64
+	spills     int64
+}
+
+func (s *spillStats) noteMemory(used int64) {
+	if used > s.peakMemory {
+		s.peakMemory = used
+	}
+}
+
+func (s *spillStats) memoryStats() spillStats { return *s }
+
+func newSpillFile() (*spillFile, error) {
+	f, err := os.CreateTemp("", "mantisdb-spill-*")
+	if err != nil {
+		return nil, fmt.Errorf("failed to create spill file: %w", err)
+	}
+	return &spillFile{f: f, w: bufio.NewWriterSize(f, 64*1024)}, nil
+}
+
+// writeRow appends one length-prefixed row record.
+func (s *spillFile) writeRow(row Row) error {
+	s.buf = binary.AppendUvarint(s.buf[:0], uint64(len(row.Values)))
+	for _, v := range row.Values {
+		s.buf = appendSpillValue(s.buf, v)
+	}
+	var hdr [binary.MaxVarintLen64]byte
+	n := binary.PutUvarint(hdr[:], uint64(len(s.buf)))
+	if _, err := s.w.Write(hdr[:n]); err != nil {
+		return fmt.Errorf("failed to write spill file: %w", err)
+	}
+	if _, err := s.w.Write(s.buf); err != nil {
+		return fmt.Errorf("failed to write spill file: %w", err)
+	}
+	s.rows++
+	return nil
+}
+
+// rewind flushes pending writes and positions the file for reading.
+func (s *spillFile) rewind() error {
+	if err := s.w.Flush(); err != nil {
+		return fmt.Errorf("failed to flush spill file: %w", err)
+	}
+	if _, err := s.f.Seek(0, io.SeekStart); err != nil {
+		return fmt.Errorf("failed to rewind spill file: %w", err)
+	}
+	s.r = bufio.NewReaderSize(s.f, 64*1024)
+	return nil
+}
+
+// readRow returns the next row; ok is false at the end of the file.
+func (s *spillFile) readRow() (row Row, ok bool, err error) {
+	size, err := binary.ReadUvarint(s.r)
+	if err == io.EOF {
+		return Row{}, false, nil
+	}
+	if err != nil {
+		return Row{}, false, fmt.Errorf("failed to read spill record: %w", err)
+	}
+	if uint64(cap(s.buf)) < size {
+		s.buf = make([]byte, size)
+	}
+	rec := s.buf[:size]
+	if _, err := io.ReadFull(s.r, rec); err != nil {
+		return Row{}, false, fmt.Errorf("failed to read spill record: %w", err)
+	}
+
+	n, k := binary.Uvarint(rec)
+	if k <= 0 {
+		return Row{}, false, fmt.Errorf("corrupt spill record")
+	}
+	rec = rec[k:]
+	row = Row{Values: make([]any, n)}
+	for i := range row.Values {
+		row.Values[i], rec, err = decodeSpillValue(rec)
+		if err != nil {
+			return Row{}, false, err
+		}
+	}
+	return row, true, nil
+}
+
+func (s *spillFile) close() error {
+	name := s.f.Name()
+	err := s.f.Close()
+	if rmErr := os.Remove(name); err == nil {
+		err = rmErr
+	}
+	return err
+}
+
+// Spill value tags. Unlike appendValueKey this encoding must round-trip, so
+// strings and byte slices are kept apart. Integers of any width come back as
+// int64, which is how the rest of the executor treats them anyway.
+const (
+	spillNil byte = iota
+	spillInt
+	spillUint
+	spillFloat
+	spillString
+	spillBytes
+	spillFalse
+	spillTrue
+	spillTime
+	spillOther
+)
+
+func appendSpillValue(buf []byte, v any) []byte {
+	if v == nil {
+		return append(buf, spillNil)
+	}
+	if i, ok := toInt64(v); ok {
+		return binary.AppendVarint(append(buf, spillInt), i)
+	}
+	switch x := v.(type) {
+	case uint64:
+		return binary.AppendUvarint(append(buf, spillUint), x)
+	case float64:
+		return binary.LittleEndian.AppendUint64(append(buf, spillFloat), math.Float64bits(x))
+	case float32:
+		return binary.LittleEndian.AppendUint64(append(buf, spillFloat), math.Float64bits(float64(x)))
+	case string:
+		buf = binary.AppendUvarint(append(buf, spillString), uint64(len(x)))
+		return append(buf, x...)
+	case []byte:
+		buf = binary.AppendUvarint(append(buf, spillBytes), uint64(len(x)))
+		return append(buf, x...)
+	case bool:
+		if x {
+			return append(buf, spillTrue)
+		}
+		return append(buf, spillFalse)
+	case time.Time:
+		b, err := x.MarshalBinary()
+		if err == nil {
+			buf = binary.AppendUvarint(append(buf, spillTime), uint64(len(b)))
+			return append(buf, b...)
+		}
+	}
+	// Anything else (documents, arrays) is spilled in its printed form.
+	s := fmt.Sprint(v)
+	buf = binary.AppendUvarint(append(buf, spillOther), uint64(len(s)))
+	return append(buf, s...)
+}
+
+func decodeSpillValue(buf []byte) (any, []byte, error) {
+	corrupt := fmt.Errorf("corrupt spill value")
+	if len(buf) == 0 {
+		return nil, nil, corrupt
+	}
+	tag, buf := buf[0], buf[1:]
+	switch tag {
+	case spillNil:
+		return nil, buf, nil
+	case spillInt:
+		i, n := binary.Varint(buf)
+		if n <= 0 {
+			return nil, nil, corrupt
+		}
+		return i, buf[n:], nil
+	case spillUint:
+		u, n := binary.Uvarint(buf)
+		if n <= 0 {
+			return nil, nil, corrupt
+		}
+		return u, buf[n:], nil
+	case spillFloat:
+		if len(buf) < 8 {
+			return nil, nil, corrupt
+		}
+		return math.Float64frombits(binary.LittleEndian.Uint64(buf)), buf[8:], nil
+	case spillFalse:
+		return false, buf, nil
+	case spillTrue:
+		return true, buf, nil
+	case spillString, spillBytes, spillTime, spillOther:
+		size, n := binary.Uvarint(buf)
+		if n <= 0 || uint64(len(buf)-n) < size {
+			return nil, nil, corrupt
+		}
+		payload, rest := buf[n:n+int(size)], buf[n+int(size):]
+		switch tag {
+		case spillBytes:
+			return append([]byte(nil), payload...), rest, nil
+		case spillTime:
+			var t time.Time
+			if err := t.UnmarshalBinary(payload); err != nil {
+				return nil, nil, fmt.Errorf("corrupt spilled timestamp: %w", err)
+			}
+			return t, rest, nil
+		default:
+			return string(payload), rest, nil
+		}
+	default:
+		return nil, nil, corrupt
+	}
+}
+
+// rowFootprint estimates the memory a buffered row holds: the slice, one
+// interface per value, and the payload of variable-length values.
+func rowFootprint(row Row) int64 {
+	size := int64(24 + 16*len(row.Values))
+	for _, v := range row.Values {
+		switch x := v.(type) {
+		case string:
+			size += int64(len(x))
+		case []byte:
+			size += int64(len(x))
+		}
+	}
+	return size
+}
@@ -0,0 +1,190 @@
+package sql
+
+import (
+	"context"
+	"fmt"
+	"time"
+)
+
+// SQLStream is the result of ExecuteSQLStream. Queries hand their rows over
+// batch by batch as the executor produces them; other statements run to
+// completion first and their result, if any, is replayed through Next.
+// Callers must Close the stream.
+type SQLStream struct {
+	rows      *RowStream
+	result    *SQLResult
+	startTime time.Time
+	finish    func(err error) error
+	err       error
+	closed    bool
+}
+
+// ExecuteSQLStream executes a statement like ExecuteSQL but without
+// materializing the rows of a query. The stream holds its auto-commit
+// transaction open until Close, and cancelling ctx stops the pipeline at
+// its next batch.
+func (se *SQLEngine) ExecuteSQLStream(ctx context.Context, connectionID, sqlText string) (*SQLStream, error) {
+	conn, err := se.touchConnection(connectionID)
+	if err != nil {
+		return nil, err
+	}
+
+	startTime := time.Now()
+	ctx = se.sampleQuery(ctx, sqlText)
+	stmt, plan, params, err := se.compileSQL(sqlText)
+	if err != nil {
+		return nil, fmt.Errorf("parse error: %w", err)
+	}
+	return se.openStream(ctx, conn, stmt, plan, params, startTime, func() (*SQLResult, error) {
+		return se.ExecuteSQL(ctx, connectionID, sqlText)
+	})
+}
+
+// ExecutePreparedStream is ExecuteSQLStream for a statement registered by
+// Prepare.
+func (se *SQLEngine) ExecutePreparedStream(ctx context.Context, connectionID, id string, params []any) (*SQLStream, error) {
+	ps, exists := se.GetPrepared(id)
+	if !exists {
+		return nil, fmt.Errorf("%w: %s", ErrPreparedStatementNotFound, id)
+	}
+	conn, err := se.touchConnection(connectionID)
+	if err != nil {
+		return nil, err
+	}
+	if len(params) != ps.ParamCount {
+		return nil, fmt.Errorf("prepared statement takes %d parameters, got %d", ps.ParamCount, len(params))
+	}
+
+	startTime := time.Now()
+	ctx = se.sampleQuery(ctx, ps.SQL)
+	return se.openStream(ctx, conn, ps.Statement, se.preparedPlan(ps), params, startTime, func() (*SQLResult, error) {
+		return se.executePrepared(ctx, conn, ps, params, startTime)
+	})
+}
+
+// DescribePrepared returns the columns a prepared query produces without
+// running it, or nil for a statement that returns no rows.
+func (se *SQLEngine) DescribePrepared(id string) ([]ColumnInfo, error) {
+	ps, exists := se.GetPrepared(id)
+	if !exists {
+		return nil, fmt.Errorf("%w: %s", ErrPreparedStatementNotFound, id)
+	}
+	plan := se.preparedPlan(ps)
+	if _, ok := ps.Statement.(*SelectStatement); !ok || plan == nil {
+		return nil, nil
+	}
+	// Operators know their columns once built; nothing is opened.
+	root, err := se.executor.buildOperator(plan)
+	if err != nil {
+		return nil, err
+	}
+	return root.Columns(), nil
+}
+
+// openStream streams a planned single-engine SELECT, and hands any other
+// statement to run, whose result the stream then replays. Joins across
+// engines need the distributed coordinator, which returns whole result
+// sets, so they do not stream either.
+func (se *SQLEngine) openStream(ctx context.Context, conn *SQLConnection, stmt Statement, plan *QueryPlan, params []any, startTime time.Time, run func() (*SQLResult, error)) (*SQLStream, error) {
+	sel, ok := stmt.(*SelectStatement)
+	if !ok || plan == nil || se.requiresDistributedTransaction(se.extractTablesFromStatement(stmt)) {
+		result, err := run()
+		if err != nil {
+			return nil, err
+		}
+		return &SQLStream{result: result, startTime: startTime}, nil
+	}
+
+	txn, distTxn, autoCommit, err := se.statementTransaction(ctx, conn)
+	if err != nil {
+		return nil, err
+	}
+	if distTxn != nil {
+		result, err := se.executeDataStatement(ctx, conn, stmt, plan, params, startTime)
+		if err != nil {
+			return nil, err
+		}
+		return &SQLStream{result: result, startTime: startTime}, nil
+	}
+
+	finish := func(err error) error {
+		if !autoCommit {
+			return nil
+		}
+		if err != nil {
+			return se.txnManager.RollbackTransaction(context.Background(), txn.sqlID, &RollbackTransactionStatement{})
+		}
+		if err := se.txnManager.CommitTransaction(context.Background(), txn.sqlID, &CommitTransactionStatement{}); err != nil {
+			return fmt.Errorf("failed to commit auto-commit transaction: %w", err)
+		}
+		return nil
+	}
+
+	rows, err := se.txnManager.StreamSelectInTransaction(ctx, txn.sqlID, sel, plan, params, se.executor)
+	if err != nil {
+		finish(err)
+		return nil, err
+	}
+	return &SQLStream{rows: rows, startTime: startTime, finish: finish}, nil
+}
+
+// Columns describes the rows the stream returns.
+func (s *SQLStream) Columns() []ColumnInfo {
+	if s.rows != nil {
+		return s.rows.Columns()
+	}
+	if s.result != nil && s.result.ResultSet != nil {
+		return s.result.ResultSet.Columns
+	}
+	return nil
+}
+
+// Next returns the next batch of rows, or nil once there are no more.
+func (s *SQLStream) Next() (*RowBatch, error) {
+	if s.closed || s.err != nil {
+		return nil, s.err
+	}
+	if s.rows == nil {
+		if s.result == nil || s.result.ResultSet == nil || len(s.result.ResultSet.Rows) == 0 {
+			return nil, nil
+		}
+		batch := &RowBatch{Rows: s.result.ResultSet.Rows}
+		s.result.ResultSet = &ResultSet{Columns: s.result.ResultSet.Columns}
+		return batch, nil
+	}
+	batch, err := s.rows.Next()
+	if err != nil {
+		s.err = err
+	}
+	return batch, err
+}
+
+// RowsAffected is the row count of a statement that did not stream.
+func (s *SQLStream) RowsAffected() int64 {
+	if s.result == nil {
+		return 0
+	}
+	return s.result.RowsAffected
+}
+
+// Elapsed is the time since the statement started.
+func (s *SQLStream) Elapsed() time.Duration {
+	return time.Since(s.startTime)
+}
+
+// Close stops the query and ends its auto-commit transaction, rolling it
+// back if the stream failed.
+func (s *SQLStream) Close() error {
+	if s.closed {
+		return nil
+	}
+	s.closed = true
+	if s.rows == nil {
+		return nil
+	}
+	err := s.rows.Close()
+	if ferr := s.finish(s.err); err == nil {
+		err = ferr
+	}
+	return err
+}
@@ -0,0 +1,83 @@
+package sql
+
+import (
+	"context"
+	"errors"
+	"fmt"
+	"testing"
+
+	"mantisDB/transaction"
+)
+
+func TestExecuteSQLStreamReturnsBatches(t *testing.T) {
+	kv := newMemKVStore()
+	for i := 0; i < 4500; i++ {
+		kv.Put(context.Background(), []byte(fmt.Sprintf("kv_events/%05d", i)), []byte(fmt.Sprintf("e-%d", i%10)))
+	}
+	engine := NewSQLEngine(&StorageManager{kvStore: kv}, transaction.NewTransactionSystem(nil), nil)
+	conn, err := engine.CreateConnection("test", "test")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer engine.CloseConnection(conn.ID)
+
+	stream, err := engine.ExecuteSQLStream(context.Background(), conn.ID, "SELECT * FROM kv_events WHERE data <> 'e-3'")
+	if err != nil {
+		t.Fatal(err)
+	}
+	if cols := stream.Columns(); len(cols) != 2 || cols[0].Name != "id" {
+		t.Fatalf("columns %v", cols)
+	}
+	batches, rows := 0, 0
+	for {
+		batch, err := stream.Next()
+		if err != nil {
+			t.Fatal(err)
+		}
+		if batch == nil {
+			break
+		}
+		if len(batch.Rows) > engine.executor.config.BatchSize {
+			t.Fatalf("batch of %d rows exceeds the batch size", len(batch.Rows))
+		}
+		batches++
+		rows += len(batch.Rows)
+	}
+	if rows != 4050 || batches < 4 {
+		t.Errorf("streamed %d rows in %d batches, want 4050 in at least 4", rows, batches)
+	}
+	if err := stream.Close(); err != nil {
+		t.Fatal(err)
+	}
+	if n := len(engine.txnManager.activeTxns); n != 0 {
+		t.Errorf("%d transactions left open after Close", n)
+	}
+
+	// Cancelling the request stops the query and rolls its transaction back.
+	ctx, cancel := context.WithCancel(context.Background())
+	stream, err = engine.ExecuteSQLStream(ctx, conn.ID, "SELECT * FROM kv_events")
+	if err != nil {
+		t.Fatal(err)
+	}
+	if _, err := stream.Next(); err != nil {
+		t.Fatal(err)
+	}
+	cancel()
+	if _, err := stream.Next(); !errors.Is(err, context.Canceled) {
+		t.Errorf("Next after cancel returned %v", err)
+	}
+	stream.Close()
+	if n := len(engine.txnManager.activeTxns); n != 0 {
+		t.Errorf("%d transactions left open after cancel", n)
+	}
+
+	// Statements that do not stream replay their result.
+	stream, err = engine.ExecuteSQLStream(context.Background(), conn.ID, "ANALYZE kv_events")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer stream.Close()
+	if batch, err := stream.Next(); err != nil || batch != nil {
+		t.Errorf("ANALYZE streamed %v, %v", batch, err)
+	}
+}
@@ -282,30 +282,22 @@ func (stm *SQLTransactionManager) GetTransaction(sqlTxnID string) (*SQLTransacti
 
 // ExecuteInTransaction executes a statement within a transaction context
 func (stm *SQLTransactionManager) ExecuteInTransaction(ctx context.Context, sqlTxnID string, stmt Statement, executor *QueryExecutor) (*ResultSet, error) {
-	sqlTxn, err := stm.GetTransaction(sqlTxnID)
+	return stm.ExecutePlanInTransaction(ctx, sqlTxnID, stmt, nil, nil, executor)
+}
+
+// ExecutePlanInTransaction executes a statement whose plan was already
+// built, typically taken from the plan cache, binding params to its
+// parameters. A nil plan falls back to planning the statement directly.
+func (stm *SQLTransactionManager) ExecutePlanInTransaction(ctx context.Context, sqlTxnID string, stmt Statement, plan *QueryPlan, params []any, executor *QueryExecutor) (*ResultSet, error) {
+	execCtx, err := stm.statementContext(ctx, sqlTxnID, stmt)
 	if err != nil {
 		return nil, err
 	}
 
-	// Update last activity
-	sqlTxn.mutex.Lock()
-	sqlTxn.lastActivity = time.Now()
-	sqlTxn.statements = append(sqlTxn.statements, stmt)
-	sqlTxn.mutex.Unlock()
-
-	// Create execution context with transaction
-	execCtx := &ExecutionContext{
-		Context:        ctx,
-		SQLTransaction: sqlTxn,
-		IsolationLevel: IsolationLevel(sqlTxn.Transaction.Isolation),
-		ReadOnly:       sqlTxn.readOnly,
-		StartTime:      time.Now(),
-	}
-
 	// Execute based on statement type
 	switch s := stmt.(type) {
 	case *SelectStatement:
-		return stm.executeSelect(execCtx, s, executor)
+		return stm.executeSelect(execCtx, s, plan, params, executor)
 	case *InsertStatement:
 		return stm.executeInsert(execCtx, s, executor)
 	case *UpdateStatement:
@@ -317,15 +309,56 @@ func (stm *SQLTransactionManager) ExecuteInTransaction(ctx context.Context, sqlT
 	}
 }
 
+// StreamSelectInTransaction opens a planned SELECT within a transaction
+// as a row stream, taking the locks ExecutePlanInTransaction would. The
+// transaction must outlive the stream.
+func (stm *SQLTransactionManager) StreamSelectInTransaction(ctx context.Context, sqlTxnID string, stmt *SelectStatement, plan *QueryPlan, params []any, executor *QueryExecutor) (*RowStream, error) {
+	execCtx, err := stm.statementContext(ctx, sqlTxnID, stmt)
+	if err != nil {
+		return nil, err
+	}
+	if err := stm.enforceIsolationLevel(execCtx, stmt); err != nil {
+		return nil, err
+	}
+	return executor.ExecuteStream(ctx, plan, params)
+}
+
+// statementContext records stmt against a transaction and returns the
+// execution context it runs in.
+func (stm *SQLTransactionManager) statementContext(ctx context.Context, sqlTxnID string, stmt Statement) (*ExecutionContext, error) {
+	sqlTxn, err := stm.GetTransaction(sqlTxnID)
+	if err != nil {
+		return nil, err
+	}
+
+	// Update last activity
+	sqlTxn.mutex.Lock()
+	sqlTxn.lastActivity = time.Now()
+	sqlTxn.statements = append(sqlTxn.statements, stmt)
+	sqlTxn.mutex.Unlock()
+
+	return &ExecutionContext{
+		Context:        ctx,
+		SQLTransaction: sqlTxn,
+		IsolationLevel: IsolationLevel(sqlTxn.Transaction.Isolation),
+		ReadOnly:       sqlTxn.readOnly,
+		StartTime:      time.Now(),
+	}, nil
+}
+
 // executeSelect executes a SELECT statement within a transaction
-func (stm *SQLTransactionManager) executeSelect(ctx *ExecutionContext, stmt *SelectStatement, executor *QueryExecutor) (*ResultSet, error) {
+func (stm *SQLTransactionManager) executeSelect(ctx *ExecutionContext, stmt *SelectStatement, plan *QueryPlan, params []any, executor *QueryExecutor) (*ResultSet, error) {
 	// Ensure proper isolation level handling
 	if err := stm.enforceIsolationLevel(ctx, stmt); err != nil {
 		return nil, err
 	}
 
+	if plan != nil {
+		return executor.Execute(ctx.Context, plan, params)
+	}
+
 	// Create query plan (simplified - would use optimizer in real implementation)
-	plan := &QueryPlan{
+	plan = &QueryPlan{
 		Type:      PlanTypeSeqScan,
 		TableName: stm.extractTableName(stmt),
 		Qual:      stm.convertWhereClause(stmt.Where),
@@ -464,6 +497,11 @@ func (stm *SQLTransactionManager) extractTableNames(stmt *SelectStatement) []str
 			names = append(names, table.Name)
 		}
 	}
+	for _, join := range stmt.Joins {
+		if join.Table != nil && join.Table.Name != "" {
+			names = append(names, join.Table.Name)
+		}
+	}
 	return names
 }
 
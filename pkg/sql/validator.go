@@ -145,6 +145,9 @@ func (v *Validator) VisitSelectStatement(stmt *SelectStatement) interface{} {
 			v.validateTableReference(&table)
 		}
 	}
+	for _, join := range stmt.Joins {
+		v.validateJoinClause(join)
+	}
 
 	// Validate SELECT fields
 	for _, field := range stmt.Fields {
@@ -1035,6 +1038,55 @@ func (v *Validator) VisitReleaseSavepointStatement(stmt *ReleaseSavepointStateme
 	return nil
 }
 
+// Prepared statement visitor methods
+
+func (v *Validator) VisitPrepareStatement(stmt *PrepareStatement) interface{} {
+	if !isValidIdentifier(stmt.Name) {
+		v.addError("invalid prepared statement name", stmt)
+	}
+	if stmt.Query != nil {
+		stmt.Query.Accept(v)
+	}
+	return nil
+}
+
+func (v *Validator) VisitExecuteStatement(stmt *ExecuteStatement) interface{} {
+	if !isValidIdentifier(stmt.Name) {
+		v.addError("invalid prepared statement name", stmt)
+	}
+	for _, param := range stmt.Params {
+		param.Accept(v)
+	}
+	return nil
+}
+
+func (v *Validator) VisitDeallocateStatement(stmt *DeallocateStatement) interface{} {
+	if stmt.Name != "" && !isValidIdentifier(stmt.Name) {
+		v.addError("invalid prepared statement name", stmt)
+	}
+	return nil
+}
+
+func (v *Validator) VisitAnalyzeStatement(stmt *AnalyzeStatement) interface{} {
+	for _, table := range stmt.Tables {
+		if !isValidIdentifier(table) {
+			v.addError("invalid table name", stmt)
+		}
+	}
+	return nil
+}
+
+func (v *Validator) VisitExplainStatement(stmt *ExplainStatement) interface{} {
+	return stmt.Statement.Accept(v)
+}
+
+func (v *Validator) VisitParameterExpression(expr *ParameterExpression) interface{} {
+	if expr.Index < 1 {
+		v.addError("parameter numbers start at $1", expr)
+	}
+	return nil
+}
+
 // Helper function to validate identifiers
 func isValidIdentifier(name string) bool {
 	if name == "" {
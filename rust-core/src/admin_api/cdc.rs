@@ -0,0 +1,218 @@
+//! CDC handlers
+//!
+//! Streams are created, deleted and consumers registered over plain JSON
+//! endpoints. Changes are delivered either by long-polling
+//! `/api/cdc/:stream/poll` or pushed over SSE from `/api/ws/cdc/:stream`.
+//! Both send the stored event encoding as is. The admin server's own write
+//! path does not capture into the streams; events come from embedders
+//! calling `CDCStream::capture`.
+
+use axum::{
+    extract::{Path, Query, State},
+    http::StatusCode,
+    response::{IntoResponse, Json, Response, Sse},
+    response::sse::{Event, KeepAlive},
+};
+use serde::Deserialize;
+use std::convert::Infallible;
+use std::time::Duration;
+use tokio_stream::StreamExt as _;
+
+use super::AdminState;
+use super::rls_api::ApiResponse;
+use crate::cdc::{CDCConfig, ChangeFrame, SubscribeOptions};
+
+/// Longest a poll may wait
+const MAX_POLL_WAIT_MS: u64 = 30_000;
+
+#[derive(Debug, Deserialize)]
+pub struct CreateStreamRequest {
+    pub name: String,
+    pub max_buffer_size: Option<usize>,
+}
+
+#[derive(Debug, Deserialize)]
+pub struct ConsumerRequest {
+    pub consumer: String,
+}
+
+#[derive(Debug, Deserialize)]
+pub struct AckRequest {
+    pub consumer: String,
+    pub offset: u64,
+}
+
+#[derive(Debug, Deserialize)]
+pub struct PollQuery {
+    pub consumer: String,
+    pub limit: Option<usize>,
+    pub timeout_ms: Option<u64>,
+}
+
+#[derive(Debug, Deserialize)]
+pub struct SubscribeQuery {
+    pub consumer: String,
+    pub max_batch: Option<usize>,
+    pub max_wait_ms: Option<u64>,
+}
+
+/// A JSON array of frames, spliced from their stored encodings
+fn frames_json(frames: &[ChangeFrame]) -> String {
+    let mut json = String::with_capacity(2 + frames.iter().map(|f| f.data.len() + 1).sum::<usize>());
+    json.push('[');
+    for (i, frame) in frames.iter().enumerate() {
+        if i > 0 {
+            json.push(',');
+        }
+        json.push_str(&String::from_utf8_lossy(&frame.data));
+    }
+    json.push(']');
+    json
+}
+
+fn error_response(status: StatusCode, message: String) -> Response {
+    (status, Json(ApiResponse::<()>::error(message))).into_response()
+}
+
+pub async fn create_stream(
+    State(state): State<AdminState>,
+    Json(req): Json<CreateStreamRequest>,
+) -> impl IntoResponse {
+    let mut config = CDCConfig {
+        stream_name: req.name.clone(),
+        ..CDCConfig::default()
+    };
+    if let Some(max) = req.max_buffer_size {
+        config.max_buffer_size = max;
+    }
+
+    match state.cdc.create_stream(config) {
+        Ok(_) => (
+            StatusCode::OK,
+            Json(ApiResponse::<()>::success_with_message(
+                (),
+                format!("Stream '{}' created", req.name),
+            )),
+        ),
+        Err(e) => (
+            StatusCode::BAD_REQUEST,
+            Json(ApiResponse::<()>::error(format!("Failed to create stream: {}", e))),
+        ),
+    }
+}
+
+pub async fn delete_stream(
+    State(state): State<AdminState>,
+    Path(stream): Path<String>,
+) -> impl IntoResponse {
+    match state.cdc.delete_stream(&stream) {
+        Ok(_) => (
+            StatusCode::OK,
+            Json(ApiResponse::<()>::success_with_message(
+                (),
+                format!("Stream '{}' deleted", stream),
+            )),
+        ),
+        Err(e) => (
+            StatusCode::NOT_FOUND,
+            Json(ApiResponse::<()>::error(format!("Failed to delete stream: {}", e))),
+        ),
+    }
+}
+
+pub async fn register_consumer(
+    State(state): State<AdminState>,
+    Path(stream): Path<String>,
+    Json(req): Json<ConsumerRequest>,
+) -> impl IntoResponse {
+    match state.cdc.register_consumer(&stream, req.consumer.clone()) {
+        Ok(_) => (
+            StatusCode::OK,
+            Json(ApiResponse::<()>::success_with_message(
+                (),
+                format!("Consumer '{}' registered on '{}'", req.consumer, stream),
+            )),
+        ),
+        Err(e) => (
+            StatusCode::BAD_REQUEST,
+            Json(ApiResponse::<()>::error(format!("Failed to register consumer: {}", e))),
+        ),
+    }
+}
+
+pub async fn acknowledge(
+    State(state): State<AdminState>,
+    Path(stream): Path<String>,
+    Json(req): Json<AckRequest>,
+) -> impl IntoResponse {
+    match state.cdc.acknowledge(&stream, &req.consumer, req.offset) {
+        Ok(_) => (StatusCode::OK, Json(ApiResponse::success(req.offset))),
+        Err(e) => (
+            StatusCode::BAD_REQUEST,
+            Json(ApiResponse::<u64>::error(format!("Failed to acknowledge: {}", e))),
+        ),
+    }
+}
+
+pub async fn get_stream_stats(
+    State(state): State<AdminState>,
+    Path(stream): Path<String>,
+) -> impl IntoResponse {
+    match state.cdc.get_stats(&stream) {
+        Ok(stats) => (StatusCode::OK, Json(ApiResponse::success(stats))).into_response(),
+        Err(e) => error_response(StatusCode::NOT_FOUND, e.to_string()),
+    }
+}
+
+/// Long poll: returns as soon as there are changes past the consumer's
+/// acknowledged offset, or an empty array after `timeout_ms`
+pub async fn poll_changes(
+    State(state): State<AdminState>,
+    Path(stream): Path<String>,
+    Query(params): Query<PollQuery>,
+) -> Response {
+    let limit = params.limit.unwrap_or(1000).clamp(1, 10_000);
+    let timeout = Duration::from_millis(params.timeout_ms.unwrap_or(10_000).min(MAX_POLL_WAIT_MS));
+
+    match state.cdc.read_wait(&stream, &params.consumer, limit, timeout).await {
+        Ok(frames) => (
+            StatusCode::OK,
+            [("Content-Type", "application/json")],
+            frames_json(&frames),
+        )
+            .into_response(),
+        Err(e) => error_response(StatusCode::BAD_REQUEST, e.to_string()),
+    }
+}
+
+/// Push changes over SSE as `changes` events, one JSON array per batch,
+/// with the batch's last offset as the event id
+pub async fn subscribe_changes(
+    State(state): State<AdminState>,
+    Path(stream): Path<String>,
+    Query(params): Query<SubscribeQuery>,
+) -> Response {
+    let defaults = SubscribeOptions::default();
+    let options = SubscribeOptions {
+        max_batch: params.max_batch.unwrap_or(defaults.max_batch).clamp(1, 10_000),
+        max_wait: params.max_wait_ms.map_or(defaults.max_wait, Duration::from_millis),
+        ..defaults
+    };
+
+    let subscription = match state.cdc.subscribe(&stream, &params.consumer, options) {
+        Ok(subscription) => subscription,
+        Err(e) => return error_response(StatusCode::BAD_REQUEST, e.to_string()),
+    };
+
+    let events = subscription.map(|batch| {
+        Ok::<_, Infallible>(match batch {
+            Ok(frames) => {
+                let last = frames.last().map_or(0, |f| f.offset);
+                Event::default().event("changes").id(last.to_string()).data(frames_json(&frames))
+            }
+            Err(e) => Event::default().event("error").data(e.to_string()),
+        })
+    });
+
+    Sse::new(events).keep_alive(KeepAlive::default()).into_response()
+}
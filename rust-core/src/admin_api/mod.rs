@@ -16,6 +16,7 @@ pub mod security;
 pub mod keyvalue;
 pub mod document;
 pub mod columnar;
+pub mod cdc;
 
 use axum::{
     Router,
@@ -30,6 +31,7 @@ use tower_http::trace::TraceLayer;
 use tower_http::compression::CompressionLayer;
 use std::sync::Arc;
 
+use crate::cdc::CDCStream;
 use crate::rls::RlsEngine;
 use crate::storage::LockFreeStorage;
 use crate::persistent_storage::{PersistentStorage, PersistentStorageConfig};
@@ -45,6 +47,7 @@ pub struct AdminState {
     pub rls_engine: Arc<RlsEngine>,
     pub storage: Arc<LockFreeStorage>,
     pub persistent: Arc<Mutex<PersistentStorage>>,
+    pub cdc: CDCStream,
 }
 
 impl AdminState {
@@ -66,10 +69,14 @@ impl AdminState {
         
         println!("✅ Database initialized with {} entries", storage.len());
         
+        let cdc = CDCStream::open(std::path::Path::new(data_dir).join("cdc"))
+            .expect("Failed to open CDC streams");
+        
         let state = Self {
             rls_engine: Arc::new(RlsEngine::new()),
             storage,
             persistent: Arc::new(Mutex::new(persistent)),
+            cdc,
         };
         
         // Load users from storage and ensure demo user exists
@@ -88,6 +95,7 @@ impl AdminState {
             rls_engine: Arc::new(RlsEngine::new()),
             storage,
             persistent: Arc::new(Mutex::new(persistent)),
+            cdc: CDCStream::new(),
         }
     }
 }
@@ -294,10 +302,19 @@ pub fn build_admin_router(state: AdminState) -> Router {
         .route("/api/columnar/tables/:table/stats", get(columnar::get_table_stats))
         .route("/api/columnar/cql", post(columnar::execute_cql))
         
+        // Change data capture
+        .route("/api/cdc/streams", post(cdc::create_stream))
+        .route("/api/cdc/:stream", delete(cdc::delete_stream))
+        .route("/api/cdc/:stream/consumers", post(cdc::register_consumer))
+        .route("/api/cdc/:stream/ack", post(cdc::acknowledge))
+        .route("/api/cdc/:stream/stats", get(cdc::get_stream_stats))
+        .route("/api/cdc/:stream/poll", get(cdc::poll_changes))
+        
         // WebSocket-style endpoints (SSE)
         .route("/api/ws/metrics", get(monitoring::metrics_stream))
         .route("/api/ws/logs", get(logs::logs_stream))
         .route("/api/ws/events", get(monitoring::events_stream))
+        .route("/api/ws/cdc/:stream", get(cdc::subscribe_changes))
         
         // Static admin UI (embedded)
         .route("/", get(serve_index))
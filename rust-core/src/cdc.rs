@@ -1,30 +1,63 @@
 //! Change Data Capture (CDC)
 //!
 //! Real-time change streaming for replication and event sourcing
+//!
+//! Each stream is a log on disk laid out like the WAL: numbered segment
+//! files of length-prefixed frames, each frame one serialized change event
+//! tagged with its offset (the LSN for events captured from the WAL).
+//! Memory holds a sparse offset index per segment and a bounded cache of
+//! the newest frames, so retention costs disk rather than RAM. Consumers
+//! near the head share the cached frames; consumers further behind seek
+//! through the index and read the segment files.
 
 use crate::error::{Error, Result};
-use parking_lot::RwLock;
+use crate::wal::{WalEntry, WalEntryType};
+use parking_lot::{Mutex, RwLock};
 use std::collections::{HashMap, VecDeque};
+use std::fs::{self, File, OpenOptions};
+use std::io::{BufReader, BufWriter, Read, Seek, SeekFrom, Write};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, Ordering};
 use std::sync::Arc;
-use std::time::SystemTime;
+use std::time::{Duration, SystemTime};
 use serde::{Serialize, Deserialize};
+use tokio::sync::{mpsc, watch};
+use tokio::task::JoinHandle;
+
+/// Frame header: payload length (u32), offset (u64), timestamp in
+/// microseconds since the epoch (u64) and payload checksum (u32)
+const FRAME_HEADER_SIZE: usize = 24;
+
+/// A segment gets an index entry every this many bytes of frames
+const INDEX_INTERVAL_BYTES: u64 = 64 * 1024;
+
+/// Newest frames kept in memory per stream
+const TAIL_CACHE_BYTES: usize = 8 * 1024 * 1024;
+
+const STREAM_CONFIG_FILE: &str = "stream.json";
 
 /// CDC stream manager
 pub struct CDCStream {
-    inner: Arc<RwLock<CDCInner>>,
+    inner: Arc<CDCInner>,
 }
 
 struct CDCInner {
-    streams: HashMap<String, ChangeStream>,
-    global_offset: u64,
+    dir: PathBuf,
+    /// Remove `dir` on drop (streams created with `CDCStream::new`)
+    temporary: bool,
+    streams: RwLock<HashMap<String, Arc<ChangeStream>>>,
+    global_offset: AtomicU64,
 }
 
 /// Change stream for a specific consumer
 struct ChangeStream {
     name: String,
-    changes: VecDeque<ChangeEvent>,
-    consumers: HashMap<String, ConsumerState>,
-    max_size: usize,
+    log: Mutex<StreamLog>,
+    consumers: Mutex<HashMap<String, ConsumerState>>,
+    /// The offset after the newest event; waiters are woken when it moves
+    head: watch::Sender<u64>,
+    /// Set when the stream is deleted; ends its subscriptions and waits
+    closed: watch::Sender<bool>,
 }
 
 /// Consumer state tracking
@@ -55,12 +88,65 @@ pub enum Operation {
     Delete,
 }
 
-/// CDC configuration
+impl ChangeEvent {
+    /// The change a WAL data entry records, or None for control entries.
+    /// Row images that are not JSON are carried as JSON strings.
+    pub fn from_wal(entry: &WalEntry) -> Option<Self> {
+        let image = |bytes: &[u8]| {
+            serde_json::from_slice(bytes)
+                .unwrap_or_else(|_| serde_json::Value::String(String::from_utf8_lossy(bytes).into_owned()))
+        };
+        let (operation, table, key, before, after) = match &entry.entry_type {
+            WalEntryType::Insert { table, key, value } => (Operation::Insert, table, key, None, Some(image(value))),
+            WalEntryType::Update { table, key, old_value, new_value } => {
+                (Operation::Update, table, key, Some(image(old_value)), Some(image(new_value)))
+            }
+            WalEntryType::Delete { table, key, old_value } => {
+                (Operation::Delete, table, key, Some(image(old_value)), None)
+            }
+            _ => return None,
+        };
+
+        let mut metadata = HashMap::new();
+        metadata.insert("txn_id".to_string(), entry.txn_id.to_string());
+        Some(ChangeEvent {
+            offset: entry.lsn.as_u64(),
+            timestamp: SystemTime::UNIX_EPOCH + Duration::from_micros(entry.timestamp),
+            operation,
+            table: table.clone(),
+            key: String::from_utf8_lossy(key).into_owned(),
+            before,
+            after,
+            metadata,
+        })
+    }
+}
+
+/// A change event as stored: its JSON encoding, shared by every consumer
+/// that reads it while it is cached. Forward `data` as is to avoid
+/// re-encoding; `event` decodes it.
 #[derive(Debug, Clone)]
+pub struct ChangeFrame {
+    pub offset: u64,
+    pub data: Arc<[u8]>,
+}
+
+impl ChangeFrame {
+    pub fn event(&self) -> Result<ChangeEvent> {
+        serde_json::from_slice(&self.data)
+            .map_err(|e| Error::SerializationError(format!("Invalid CDC frame at offset {}: {}", self.offset, e)))
+    }
+}
+
+/// CDC configuration
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct CDCConfig {
     pub stream_name: String,
+    /// Events retained; older ones are dropped as new ones arrive
     pub max_buffer_size: usize,
     pub retention_period: std::time::Duration,
+    /// Size at which the stream starts a new segment file
+    pub segment_size: u64,
 }
 
 impl Default for CDCConfig {
@@ -69,82 +155,609 @@ impl Default for CDCConfig {
             stream_name: "default".to_string(),
             max_buffer_size: 10000,
             retention_period: std::time::Duration::from_secs(3600), // 1 hour
+            segment_size: 64 * 1024 * 1024,
+        }
+    }
+}
+
+/// Sparse index entry: the frame at byte `pos` of a segment has `offset`
+/// and is the stream's `ordinal`-th event
+#[derive(Debug, Clone, Copy)]
+struct IndexEntry {
+    offset: u64,
+    ordinal: u64,
+    pos: u64,
+}
+
+/// One segment file
+struct Segment {
+    path: PathBuf,
+    id: u64,
+    base_ordinal: u64,
+    count: u64,
+    last_offset: u64,
+    /// Newest event timestamp, in microseconds
+    newest: u64,
+    size: u64,
+    index: Vec<IndexEntry>,
+}
+
+impl Segment {
+    fn new(dir: &Path, id: u64, base_ordinal: u64) -> Self {
+        Segment {
+            path: dir.join(format!("{:016x}.log", id)),
+            id,
+            base_ordinal,
+            count: 0,
+            last_offset: 0,
+            newest: 0,
+            size: 0,
+            index: Vec::new(),
+        }
+    }
+
+    fn end_ordinal(&self) -> u64 {
+        self.base_ordinal + self.count
+    }
+
+    fn record(&mut self, offset: u64, timestamp: u64, frame_len: u64) {
+        let needs_entry = self
+            .index
+            .last()
+            .map_or(true, |e| self.size - e.pos >= INDEX_INTERVAL_BYTES);
+        if needs_entry {
+            self.index.push(IndexEntry {
+                offset,
+                ordinal: self.end_ordinal(),
+                pos: self.size,
+            });
+        }
+        self.count += 1;
+        self.last_offset = offset;
+        self.newest = self.newest.max(timestamp);
+        self.size += frame_len;
+    }
+
+    /// Index entry to start reading at to find `offset`
+    fn seek_offset(&self, offset: u64) -> IndexEntry {
+        self.index[self.index.partition_point(|e| e.offset <= offset).saturating_sub(1)]
+    }
+
+    /// Index entry to start reading at to find the `ordinal`-th event
+    fn seek_ordinal(&self, ordinal: u64) -> IndexEntry {
+        self.index[self.index.partition_point(|e| e.ordinal <= ordinal).saturating_sub(1)]
+    }
+}
+
+/// Frame header fields
+struct FrameHeader {
+    len: usize,
+    offset: u64,
+    timestamp: u64,
+    checksum: u32,
+}
+
+fn encode_header(payload: &[u8], offset: u64, timestamp: u64) -> [u8; FRAME_HEADER_SIZE] {
+    let mut header = [0u8; FRAME_HEADER_SIZE];
+    header[0..4].copy_from_slice(&(payload.len() as u32).to_le_bytes());
+    header[4..12].copy_from_slice(&offset.to_le_bytes());
+    header[12..20].copy_from_slice(&timestamp.to_le_bytes());
+    header[20..24].copy_from_slice(&checksum(payload).to_le_bytes());
+    header
+}
+
+fn checksum(payload: &[u8]) -> u32 {
+    xxhash_rust::xxh3::xxh3_64(payload) as u32
+}
+
+/// Read the next frame header, or None at a clean end of the data
+fn read_header(reader: &mut impl Read) -> Result<Option<FrameHeader>> {
+    let mut header = [0u8; FRAME_HEADER_SIZE];
+    match reader.read_exact(&mut header) {
+        Ok(()) => {}
+        Err(e) if e.kind() == std::io::ErrorKind::UnexpectedEof => return Ok(None),
+        Err(e) => return Err(e.into()),
+    }
+    Ok(Some(FrameHeader {
+        len: u32::from_le_bytes(header[0..4].try_into().unwrap()) as usize,
+        offset: u64::from_le_bytes(header[4..12].try_into().unwrap()),
+        timestamp: u64::from_le_bytes(header[12..20].try_into().unwrap()),
+        checksum: u32::from_le_bytes(header[20..24].try_into().unwrap()),
+    }))
+}
+
+fn read_payload(reader: &mut impl Read, header: &FrameHeader) -> Result<Arc<[u8]>> {
+    let mut payload = vec![0u8; header.len];
+    reader.read_exact(&mut payload)?;
+    if checksum(&payload) != header.checksum {
+        return Err(Error::General(format!("Corrupt CDC frame at offset {}", header.offset)));
+    }
+    Ok(payload.into())
+}
+
+fn micros(time: SystemTime) -> u64 {
+    time.duration_since(SystemTime::UNIX_EPOCH)
+        .map_or(0, |d| d.as_micros() as u64)
+}
+
+/// A cached frame with its position in the stream
+struct CachedFrame {
+    ordinal: u64,
+    frame: ChangeFrame,
+}
+
+/// The on-disk log of one stream. Events are numbered by ordinal, their
+/// position in the stream since it was opened; events before
+/// `first_ordinal` have been dropped by retention even if their segment is
+/// still on disk.
+struct StreamLog {
+    dir: PathBuf,
+    segments: Vec<Segment>,
+    writer: BufWriter<File>,
+    /// The writer holds frames not yet written to the file
+    dirty: bool,
+    first_ordinal: u64,
+    next_ordinal: u64,
+    last_offset: Option<u64>,
+    tail: VecDeque<CachedFrame>,
+    tail_bytes: usize,
+    max_events: u64,
+    segment_size: u64,
+}
+
+impl StreamLog {
+    /// Create an empty log in `dir`
+    fn create(dir: PathBuf, config: &CDCConfig) -> Result<Self> {
+        fs::create_dir_all(&dir)?;
+        fs::write(
+            dir.join(STREAM_CONFIG_FILE),
+            serde_json::to_vec(config).map_err(|e| Error::SerializationError(e.to_string()))?,
+        )?;
+        let segment = Segment::new(&dir, 0, 0);
+        let writer = Self::open_writer(&segment.path)?;
+        Ok(StreamLog {
+            dir,
+            segments: vec![segment],
+            writer,
+            dirty: false,
+            first_ordinal: 0,
+            next_ordinal: 0,
+            last_offset: None,
+            tail: VecDeque::new(),
+            tail_bytes: 0,
+            max_events: config.max_buffer_size as u64,
+            segment_size: config.segment_size,
+        })
+    }
+
+    /// Open the log in `dir`, rebuilding segment indexes by scanning the
+    /// files. A frame torn by a crash ends its segment and is cut off.
+    fn open(dir: PathBuf) -> Result<(CDCConfig, Self)> {
+        let config: CDCConfig = serde_json::from_slice(&fs::read(dir.join(STREAM_CONFIG_FILE))?)
+            .map_err(|e| Error::SerializationError(e.to_string()))?;
+
+        let mut ids: Vec<u64> = fs::read_dir(&dir)?
+            .flatten()
+            .filter_map(|entry| {
+                let name = entry.file_name().into_string().ok()?;
+                u64::from_str_radix(name.strip_suffix(".log")?, 16).ok()
+            })
+            .collect();
+        ids.sort_unstable();
+        if ids.is_empty() {
+            ids.push(0);
+        }
+
+        let mut segments = Vec::with_capacity(ids.len());
+        let mut next_ordinal = 0;
+        for id in ids {
+            let mut segment = Segment::new(&dir, id, next_ordinal);
+            if let Ok(file) = File::open(&segment.path) {
+                let mut reader = BufReader::new(file);
+                while let Some(header) = read_header(&mut reader)? {
+                    if read_payload(&mut reader, &header).is_err() {
+                        break;
+                    }
+                    segment.record(header.offset, header.timestamp, (FRAME_HEADER_SIZE + header.len) as u64);
+                }
+                OpenOptions::new().write(true).open(&segment.path)?.set_len(segment.size)?;
+            }
+            next_ordinal = segment.end_ordinal();
+            segments.push(segment);
+        }
+
+        let writer = Self::open_writer(&segments.last().unwrap().path)?;
+        let last_offset = segments.iter().rev().find(|s| s.count > 0).map(|s| s.last_offset);
+        let log = StreamLog {
+            dir,
+            segments,
+            writer,
+            dirty: false,
+            first_ordinal: next_ordinal.saturating_sub(config.max_buffer_size as u64),
+            next_ordinal,
+            last_offset,
+            tail: VecDeque::new(),
+            tail_bytes: 0,
+            max_events: config.max_buffer_size as u64,
+            segment_size: config.segment_size,
+        };
+        Ok((config, log))
+    }
+
+    fn open_writer(path: &Path) -> Result<BufWriter<File>> {
+        let file = OpenOptions::new().create(true).append(true).open(path)?;
+        Ok(BufWriter::new(file))
+    }
+
+    fn flush(&mut self) -> Result<()> {
+        if self.dirty {
+            self.writer.flush()?;
+            self.dirty = false;
+        }
+        Ok(())
+    }
+
+    /// Append a frame. Offsets must increase.
+    fn append(&mut self, offset: u64, timestamp: u64, payload: Arc<[u8]>) -> Result<()> {
+        let frame_len = (FRAME_HEADER_SIZE + payload.len()) as u64;
+        let active = self.segments.last().unwrap();
+        if active.count > 0 && active.size + frame_len > self.segment_size {
+            let id = active.id + 1;
+            self.flush()?;
+            let segment = Segment::new(&self.dir, id, self.next_ordinal);
+            self.writer = Self::open_writer(&segment.path)?;
+            self.segments.push(segment);
+        }
+
+        self.writer.write_all(&encode_header(&payload, offset, timestamp))?;
+        self.writer.write_all(&payload)?;
+        self.dirty = true;
+        self.segments.last_mut().unwrap().record(offset, timestamp, frame_len);
+
+        self.tail_bytes += payload.len();
+        self.tail.push_back(CachedFrame {
+            ordinal: self.next_ordinal,
+            frame: ChangeFrame { offset, data: payload },
+        });
+        while self.tail_bytes > TAIL_CACHE_BYTES && self.tail.len() > 1 {
+            let evicted = self.tail.pop_front().unwrap();
+            self.tail_bytes -= evicted.frame.data.len();
+        }
+
+        self.next_ordinal += 1;
+        self.last_offset = Some(offset);
+
+        // Enforce max size
+        if self.next_ordinal - self.first_ordinal > self.max_events {
+            self.trim(self.next_ordinal - self.max_events)?;
+        }
+        Ok(())
+    }
+
+    /// Drop the events before `ordinal`, deleting segments that hold only
+    /// dropped events. The active segment is kept.
+    fn trim(&mut self, ordinal: u64) -> Result<()> {
+        self.first_ordinal = self.first_ordinal.max(ordinal);
+        while self.segments.len() > 1 && self.segments[0].end_ordinal() <= self.first_ordinal {
+            let segment = self.segments.remove(0);
+            fs::remove_file(&segment.path)?;
+        }
+        while self.tail.front().map_or(false, |f| f.ordinal < self.first_ordinal) {
+            let evicted = self.tail.pop_front().unwrap();
+            self.tail_bytes -= evicted.frame.data.len();
+        }
+        Ok(())
+    }
+
+    fn len(&self) -> u64 {
+        self.next_ordinal - self.first_ordinal
+    }
+
+    /// Where to read the `ordinal`-th event from: its segment's file, the
+    /// position of an indexed frame at or before it, and that frame's
+    /// ordinal. Flushes the writer if the segment is the active one.
+    fn locate_ordinal(&mut self, ordinal: u64) -> Result<Option<(File, IndexEntry, u64)>> {
+        let i = self.segments.partition_point(|s| s.end_ordinal() <= ordinal);
+        if i == self.segments.len() {
+            return Ok(None);
         }
+        let entry = self.segments[i].seek_ordinal(ordinal);
+        self.open_segment(i, entry).map(Some)
+    }
+
+    fn open_segment(&mut self, i: usize, entry: IndexEntry) -> Result<(File, IndexEntry, u64)> {
+        if i == self.segments.len() - 1 {
+            self.flush()?;
+        }
+        let mut file = File::open(&self.segments[i].path)?;
+        file.seek(SeekFrom::Start(entry.pos))?;
+        Ok((file, entry, self.segments[i].size))
+    }
+}
+
+impl ChangeStream {
+    fn new(name: String, log: StreamLog) -> Self {
+        let head = log.last_offset.map_or(0, |last| last + 1);
+        ChangeStream {
+            name,
+            log: Mutex::new(log),
+            consumers: Mutex::new(HashMap::new()),
+            head: watch::channel(head).0,
+            closed: watch::channel(false).0,
+        }
+    }
+
+    /// Whether frames from `offset` on are served from the tail cache
+    fn is_cached(&self, offset: u64) -> bool {
+        let log = self.log.lock();
+        log.tail.front().map_or(true, |f| f.frame.offset <= offset)
+    }
+
+    /// Read up to `limit` frames with offsets from `from` on. Frames still
+    /// in the tail cache are shared; older ones are read from the segment
+    /// files without holding the log lock.
+    fn read_from(&self, from: u64, limit: usize) -> Result<Vec<ChangeFrame>> {
+        let mut frames = Vec::new();
+        let mut cursor = from;
+
+        while frames.len() < limit {
+            let (file, entry, end, first_ordinal, segment_last) = {
+                let mut log = self.log.lock();
+                match log.last_offset {
+                    Some(last) if cursor <= last => {}
+                    _ => break,
+                }
+
+                if log.tail.front().map_or(false, |f| f.frame.offset <= cursor) {
+                    let start = log.tail.partition_point(|f| f.frame.offset < cursor);
+                    frames.extend(
+                        log.tail
+                            .iter()
+                            .skip(start)
+                            .take(limit - frames.len())
+                            .map(|f| f.frame.clone()),
+                    );
+                    break;
+                }
+
+                let i = log.segments.partition_point(|s| s.count > 0 && s.last_offset < cursor);
+                if i == log.segments.len() || log.segments[i].count == 0 {
+                    break;
+                }
+                let entry = log.segments[i].seek_offset(cursor);
+                let segment_last = log.segments[i].last_offset;
+                let first_ordinal = log.first_ordinal;
+                let (file, entry, end) = log.open_segment(i, entry)?;
+                (file, entry, end, first_ordinal, segment_last)
+            };
+
+            let mut reader = BufReader::new(file.take(end - entry.pos));
+            let mut ordinal = entry.ordinal;
+            while frames.len() < limit {
+                let header = match read_header(&mut reader)? {
+                    Some(header) => header,
+                    None => break,
+                };
+                if header.offset < cursor || ordinal < first_ordinal {
+                    // Skip without reading the payload
+                    std::io::copy(&mut (&mut reader).take(header.len as u64), &mut std::io::sink())?;
+                } else {
+                    let data = read_payload(&mut reader, &header)?;
+                    frames.push(ChangeFrame { offset: header.offset, data });
+                }
+                ordinal += 1;
+            }
+            cursor = segment_last + 1;
+        }
+
+        Ok(frames)
+    }
+
+    /// Offset of the oldest retained event
+    fn oldest_offset(&self) -> Result<Option<u64>> {
+        let (file, entry, end, first_ordinal) = {
+            let mut log = self.log.lock();
+            if log.len() == 0 {
+                return Ok(None);
+            }
+            let first_ordinal = log.first_ordinal;
+            if let Some(front) = log.tail.front() {
+                if front.ordinal <= first_ordinal {
+                    return Ok(Some(front.frame.offset));
+                }
+            }
+            match log.locate_ordinal(first_ordinal)? {
+                Some((file, entry, end)) => (file, entry, end, first_ordinal),
+                None => return Ok(None),
+            }
+        };
+
+        let mut reader = BufReader::new(file.take(end - entry.pos));
+        let mut ordinal = entry.ordinal;
+        while let Some(header) = read_header(&mut reader)? {
+            if ordinal == first_ordinal {
+                return Ok(Some(header.offset));
+            }
+            std::io::copy(&mut (&mut reader).take(header.len as u64), &mut std::io::sink())?;
+            ordinal += 1;
+        }
+        Ok(None)
+    }
+
+    /// Drop events older than `cutoff` (microseconds). Whole segments are
+    /// judged by their newest event; only the first segment with newer
+    /// events is scanned.
+    fn drop_before(&self, cutoff: u64) -> Result<usize> {
+        let mut log = self.log.lock();
+        let before = log.first_ordinal;
+
+        let mut new_first = log.first_ordinal;
+        let mut partial = None;
+        for (i, segment) in log.segments.iter().enumerate() {
+            if segment.end_ordinal() <= new_first {
+                continue;
+            }
+            if segment.count > 0 && segment.newest < cutoff {
+                new_first = segment.end_ordinal();
+            } else {
+                partial = Some(i);
+                break;
+            }
+        }
+
+        if let Some(i) = partial.filter(|&i| log.segments[i].count > 0) {
+            let entry = log.segments[i].seek_ordinal(new_first);
+            let (file, entry, end) = log.open_segment(i, entry)?;
+            let mut reader = BufReader::new(file.take(end - entry.pos));
+            let mut ordinal = entry.ordinal;
+            while let Some(header) = read_header(&mut reader)? {
+                if ordinal >= new_first {
+                    if header.timestamp >= cutoff {
+                        break;
+                    }
+                    new_first = ordinal + 1;
+                }
+                std::io::copy(&mut (&mut reader).take(header.len as u64), &mut std::io::sink())?;
+                ordinal += 1;
+            }
+        }
+
+        log.trim(new_first)?;
+        Ok((log.first_ordinal - before) as usize)
     }
 }
 
 impl CDCStream {
-    /// Create a new CDC stream manager
+    /// Create a CDC stream manager whose streams live in a private temporary
+    /// directory, removed when the last handle is dropped
     pub fn new() -> Self {
+        let dir = std::env::temp_dir().join(format!("mantisdb-cdc-{}", uuid::Uuid::new_v4()));
         Self {
-            inner: Arc::new(RwLock::new(CDCInner {
-                streams: HashMap::new(),
-                global_offset: 0,
-            })),
+            inner: Arc::new(CDCInner {
+                dir,
+                temporary: true,
+                streams: RwLock::new(HashMap::new()),
+                global_offset: AtomicU64::new(0),
+            }),
+        }
+    }
+
+    /// Open a CDC stream manager on `dir`, recovering the streams stored
+    /// there. Consumers register again after a restart.
+    pub fn open(dir: impl AsRef<Path>) -> Result<Self> {
+        let dir = dir.as_ref().to_path_buf();
+        fs::create_dir_all(&dir)?;
+
+        let mut streams = HashMap::new();
+        let mut next_offset = 0;
+        for entry in fs::read_dir(&dir)?.flatten() {
+            if !entry.path().join(STREAM_CONFIG_FILE).exists() {
+                continue;
+            }
+            let (config, log) = StreamLog::open(entry.path())?;
+            if let Some(last) = log.last_offset {
+                next_offset = next_offset.max(last + 1);
+            }
+            streams.insert(config.stream_name.clone(), Arc::new(ChangeStream::new(config.stream_name, log)));
         }
+
+        Ok(Self {
+            inner: Arc::new(CDCInner {
+                dir,
+                temporary: false,
+                streams: RwLock::new(streams),
+                global_offset: AtomicU64::new(next_offset),
+            }),
+        })
     }
-    
+
     /// Create a stream
     pub fn create_stream(&self, config: CDCConfig) -> Result<()> {
-        let mut inner = self.inner.write();
-        
-        if inner.streams.contains_key(&config.stream_name) {
+        let mut streams = self.inner.streams.write();
+
+        if streams.contains_key(&config.stream_name) {
             return Err(Error::General(format!(
                 "Stream '{}' already exists",
                 config.stream_name
             )));
         }
-        
-        inner.streams.insert(
-            config.stream_name.clone(),
-            ChangeStream {
-                name: config.stream_name,
-                changes: VecDeque::new(),
-                consumers: HashMap::new(),
-                max_size: config.max_buffer_size,
-            },
-        );
-        
+
+        let dir = self.inner.dir.join(hex_name(&config.stream_name));
+        let log = StreamLog::create(dir, &config)?;
+        streams.insert(config.stream_name.clone(), Arc::new(ChangeStream::new(config.stream_name, log)));
+
+        Ok(())
+    }
+
+    /// Delete a stream and its log. Its subscriptions end: each subscriber
+    /// receives the batches already queued for it and then None.
+    pub fn delete_stream(&self, stream_name: &str) -> Result<()> {
+        let stream = self.inner.streams.write().remove(stream_name)
+            .ok_or_else(|| Error::General(format!("Stream '{}' not found", stream_name)))?;
+        stream.closed.send_replace(true);
+        let dir = stream.log.lock().dir.clone();
+        fs::remove_dir_all(dir)?;
         Ok(())
     }
-    
+
+    fn stream(&self, stream_name: &str) -> Result<Arc<ChangeStream>> {
+        self.inner.streams.read().get(stream_name).cloned()
+            .ok_or_else(|| Error::General(format!("Stream '{}' not found", stream_name)))
+    }
+
     /// Capture a change event
     pub fn capture(&self, stream_name: &str, mut event: ChangeEvent) -> Result<u64> {
-        let mut inner = self.inner.write();
-        
-        let stream = inner.streams.get_mut(stream_name)
-            .ok_or_else(|| Error::General(format!("Stream '{}' not found", stream_name)))?;
-        
-        // Assign global offset
-        event.offset = inner.global_offset;
-        inner.global_offset += 1;
-        
-        // Add to stream
-        stream.changes.push_back(event);
-        
-        // Enforce max size
-        while stream.changes.len() > stream.max_size {
-            stream.changes.pop_front();
+        let stream = self.stream(stream_name)?;
+        let mut log = stream.log.lock();
+
+        // Assign global offset; taken under the log lock so the stream's
+        // offsets increase
+        event.offset = self.inner.global_offset.fetch_add(1, Ordering::SeqCst);
+        Self::append(&stream, &mut log, &event)?;
+        Ok(event.offset)
+    }
+
+    /// Capture the change a WAL entry records, keeping its LSN as the
+    /// offset. Control entries and LSNs the stream has already seen are
+    /// skipped, so replaying the WAL from a checkpoint is harmless.
+    /// Returns the offset when the entry was captured.
+    pub fn capture_wal(&self, stream_name: &str, entry: &WalEntry) -> Result<Option<u64>> {
+        let event = match ChangeEvent::from_wal(entry) {
+            Some(event) => event,
+            None => return Ok(None),
+        };
+        let stream = self.stream(stream_name)?;
+        let mut log = stream.log.lock();
+        if log.last_offset.map_or(false, |last| event.offset <= last) {
+            return Ok(None);
         }
-        
-        Ok(inner.global_offset - 1)
+
+        self.inner.global_offset.fetch_max(event.offset + 1, Ordering::SeqCst);
+        Self::append(&stream, &mut log, &event)?;
+        Ok(Some(event.offset))
+    }
+
+    fn append(stream: &ChangeStream, log: &mut StreamLog, event: &ChangeEvent) -> Result<()> {
+        let payload = serde_json::to_vec(event)
+            .map_err(|e| Error::SerializationError(format!("Failed to encode change event: {}", e)))?;
+        log.append(event.offset, micros(event.timestamp), payload.into())?;
+        stream.head.send_replace(event.offset + 1);
+        Ok(())
     }
-    
+
     /// Register a consumer
     pub fn register_consumer(&self, stream_name: &str, consumer_id: String) -> Result<()> {
-        let mut inner = self.inner.write();
-        
-        let stream = inner.streams.get_mut(stream_name)
-            .ok_or_else(|| Error::General(format!("Stream '{}' not found", stream_name)))?;
-        
-        if stream.consumers.contains_key(&consumer_id) {
+        let stream = self.stream(stream_name)?;
+        let mut consumers = stream.consumers.lock();
+
+        if consumers.contains_key(&consumer_id) {
             return Err(Error::General(format!(
                 "Consumer '{}' already registered",
                 consumer_id
             )));
         }
-        
-        stream.consumers.insert(
+
+        consumers.insert(
             consumer_id.clone(),
             ConsumerState {
                 consumer_id,
@@ -152,10 +765,19 @@ impl CDCStream {
                 last_ack_time: SystemTime::now(),
             },
         );
-        
+
         Ok(())
     }
-    
+
+    fn consumer_offset(stream: &ChangeStream, consumer_id: &str) -> Result<u64> {
+        stream.consumers.lock().get(consumer_id)
+            .map(|c| c.offset)
+            .ok_or_else(|| Error::General(format!(
+                "Consumer '{}' not registered",
+                consumer_id
+            )))
+    }
+
     /// Read changes from stream
     pub fn read(
         &self,
@@ -163,27 +785,78 @@ impl CDCStream {
         consumer_id: &str,
         limit: usize,
     ) -> Result<Vec<ChangeEvent>> {
-        let inner = self.inner.read();
-        
-        let stream = inner.streams.get(stream_name)
-            .ok_or_else(|| Error::General(format!("Stream '{}' not found", stream_name)))?;
-        
-        let consumer = stream.consumers.get(consumer_id)
-            .ok_or_else(|| Error::General(format!(
-                "Consumer '{}' not registered",
-                consumer_id
-            )))?;
-        
-        // Find changes after consumer's offset
-        let changes: Vec<_> = stream.changes.iter()
-            .filter(|event| event.offset >= consumer.offset)
-            .take(limit)
-            .cloned()
-            .collect();
-        
-        Ok(changes)
+        self.read_frames(stream_name, consumer_id, limit)?
+            .iter()
+            .map(ChangeFrame::event)
+            .collect()
     }
-    
+
+    /// Read changes from stream in their stored encoding
+    pub fn read_frames(
+        &self,
+        stream_name: &str,
+        consumer_id: &str,
+        limit: usize,
+    ) -> Result<Vec<ChangeFrame>> {
+        let stream = self.stream(stream_name)?;
+        let offset = Self::consumer_offset(&stream, consumer_id)?;
+        stream.read_from(offset, limit)
+    }
+
+    /// Long-poll variant of `read_frames`: when nothing is pending, wait up
+    /// to `timeout` for the next event instead of returning empty
+    pub async fn read_wait(
+        &self,
+        stream_name: &str,
+        consumer_id: &str,
+        limit: usize,
+        timeout: Duration,
+    ) -> Result<Vec<ChangeFrame>> {
+        let stream = self.stream(stream_name)?;
+        let offset = Self::consumer_offset(&stream, consumer_id)?;
+        let mut head = stream.head.subscribe();
+        let mut closed = stream.closed.subscribe();
+        let deadline = tokio::time::Instant::now() + timeout;
+        loop {
+            // Mark the current head seen before reading, so an event
+            // captured after the read wakes the wait below
+            head.borrow_and_update();
+            let frames = read_blocking(&stream, offset, limit).await?;
+            if !frames.is_empty() {
+                return Ok(frames);
+            }
+            tokio::select! {
+                changed = tokio::time::timeout_at(deadline, head.changed()) => {
+                    if !matches!(changed, Ok(Ok(()))) {
+                        return Ok(frames);
+                    }
+                }
+                _ = closed.wait_for(|closed| *closed) => return Ok(frames),
+            }
+        }
+    }
+
+    /// Push the stream's changes to a consumer as they are captured,
+    /// starting after its last acknowledged offset. Must be called within
+    /// a tokio runtime. Acknowledging stays with the consumer.
+    pub fn subscribe(
+        &self,
+        stream_name: &str,
+        consumer_id: &str,
+        options: SubscribeOptions,
+    ) -> Result<Subscription> {
+        let stream = self.stream(stream_name)?;
+        let offset = Self::consumer_offset(&stream, consumer_id)?;
+        let (sender, receiver) = mpsc::channel(options.buffer.max(1));
+        let catching_up = Arc::new(std::sync::atomic::AtomicBool::new(false));
+        let task = tokio::spawn(deliver(stream, offset, options, sender, Arc::clone(&catching_up)));
+        Ok(Subscription {
+            receiver,
+            catching_up,
+            task,
+        })
+    }
+
     /// Acknowledge processed events
     pub fn acknowledge(
         &self,
@@ -191,66 +864,217 @@ impl CDCStream {
         consumer_id: &str,
         offset: u64,
     ) -> Result<()> {
-        let mut inner = self.inner.write();
-        
-        let stream = inner.streams.get_mut(stream_name)
-            .ok_or_else(|| Error::General(format!("Stream '{}' not found", stream_name)))?;
-        
-        let consumer = stream.consumers.get_mut(consumer_id)
+        let stream = self.stream(stream_name)?;
+        let mut consumers = stream.consumers.lock();
+
+        let consumer = consumers.get_mut(consumer_id)
             .ok_or_else(|| Error::General(format!(
                 "Consumer '{}' not registered",
                 consumer_id
             )))?;
-        
-        if offset > consumer.offset {
+
+        if offset >= consumer.offset {
             consumer.offset = offset + 1; // Next offset to read
             consumer.last_ack_time = SystemTime::now();
         }
-        
+
         Ok(())
     }
-    
+
+    /// Write buffered frames to disk and sync every stream
+    pub fn sync(&self) -> Result<()> {
+        let streams: Vec<_> = self.inner.streams.read().values().cloned().collect();
+        for stream in streams {
+            let mut log = stream.log.lock();
+            log.flush()?;
+            log.writer.get_ref().sync_data()?;
+        }
+        Ok(())
+    }
+
     /// Get stream statistics
     pub fn get_stats(&self, stream_name: &str) -> Result<StreamStats> {
-        let inner = self.inner.read();
-        
-        let stream = inner.streams.get(stream_name)
-            .ok_or_else(|| Error::General(format!("Stream '{}' not found", stream_name)))?;
-        
-        let oldest_offset = stream.changes.front().map(|e| e.offset);
-        let newest_offset = stream.changes.back().map(|e| e.offset);
-        
+        let stream = self.stream(stream_name)?;
+        let oldest_offset = stream.oldest_offset()?;
+        let consumers = stream.consumers.lock().len();
+        let log = stream.log.lock();
+
         Ok(StreamStats {
-            total_events: stream.changes.len(),
-            consumers: stream.consumers.len(),
+            total_events: log.len() as usize,
+            consumers,
             oldest_offset,
-            newest_offset,
+            newest_offset: if log.len() > 0 { log.last_offset } else { None },
+            segments: log.segments.len(),
+            disk_bytes: log.segments.iter().map(|s| s.size).sum(),
+            cached_bytes: log.tail_bytes,
         })
     }
-    
+
     /// Apply retention policy
     pub fn apply_retention(&self, stream_name: &str, retention: std::time::Duration) -> Result<usize> {
-        let mut inner = self.inner.write();
-        
-        let stream = inner.streams.get_mut(stream_name)
-            .ok_or_else(|| Error::General(format!("Stream '{}' not found", stream_name)))?;
-        
-        let cutoff = SystemTime::now() - retention;
-        let mut removed = 0;
-        
-        while let Some(event) = stream.changes.front() {
-            if event.timestamp < cutoff {
-                stream.changes.pop_front();
-                removed += 1;
-            } else {
-                break;
+        let stream = self.stream(stream_name)?;
+        let cutoff = micros(SystemTime::now() - retention);
+        stream.drop_before(cutoff)
+    }
+}
+
+/// Options for `CDCStream::subscribe`
+#[derive(Debug, Clone)]
+pub struct SubscribeOptions {
+    /// Most events delivered in one batch
+    pub max_batch: usize,
+    /// How long a partial batch waits for more events before it is sent
+    pub max_wait: Duration,
+    /// Batches queued for the subscriber before delivery pauses
+    pub buffer: usize,
+}
+
+impl Default for SubscribeOptions {
+    fn default() -> Self {
+        Self {
+            max_batch: 256,
+            max_wait: Duration::from_millis(5),
+            buffer: 16,
+        }
+    }
+}
+
+/// A push subscription to a stream. Batches arrive in offset order. A
+/// subscriber that stops receiving is not dropped: once its buffer is full
+/// delivery pauses, and when it resumes it catches up from the segment
+/// files if the stream has moved past the in-memory tail.
+pub struct Subscription {
+    receiver: mpsc::Receiver<Result<Vec<ChangeFrame>>>,
+    catching_up: Arc<std::sync::atomic::AtomicBool>,
+    task: JoinHandle<()>,
+}
+
+impl Subscription {
+    /// The next batch, or None once the stream is deleted. An error ends
+    /// the subscription.
+    pub async fn next_batch(&mut self) -> Option<Result<Vec<ChangeFrame>>> {
+        self.receiver.recv().await
+    }
+
+    /// Whether the last batch was read from disk because the subscriber
+    /// had fallen behind the in-memory tail
+    pub fn is_catching_up(&self) -> bool {
+        self.catching_up.load(Ordering::Relaxed)
+    }
+}
+
+impl tokio_stream::Stream for Subscription {
+    type Item = Result<Vec<ChangeFrame>>;
+
+    fn poll_next(
+        mut self: std::pin::Pin<&mut Self>,
+        cx: &mut std::task::Context<'_>,
+    ) -> std::task::Poll<Option<Self::Item>> {
+        self.receiver.poll_recv(cx)
+    }
+}
+
+impl Drop for Subscription {
+    fn drop(&mut self) {
+        self.task.abort();
+    }
+}
+
+/// Read frames, off the async runtime when they come from disk
+async fn read_blocking(stream: &Arc<ChangeStream>, offset: u64, limit: usize) -> Result<Vec<ChangeFrame>> {
+    if stream.is_cached(offset) {
+        return stream.read_from(offset, limit);
+    }
+    let stream = Arc::clone(stream);
+    tokio::task::spawn_blocking(move || stream.read_from(offset, limit))
+        .await
+        .map_err(|e| Error::General(format!("CDC read task failed: {}", e)))?
+}
+
+/// Subscription delivery loop: wait for events past the cursor, gather up
+/// to `max_batch` of them for at most `max_wait`, and hand the batch over,
+/// waiting while the subscriber's buffer is full. Returns, closing the
+/// channel, when the stream is deleted.
+async fn deliver(
+    stream: Arc<ChangeStream>,
+    mut cursor: u64,
+    options: SubscribeOptions,
+    sender: mpsc::Sender<Result<Vec<ChangeFrame>>>,
+    catching_up: Arc<std::sync::atomic::AtomicBool>,
+) {
+    let max_batch = options.max_batch.max(1);
+    let mut head = stream.head.subscribe();
+    let mut closed = stream.closed.subscribe();
+
+    loop {
+        while *head.borrow_and_update() <= cursor {
+            tokio::select! {
+                changed = head.changed() => {
+                    if changed.is_err() {
+                        return;
+                    }
+                }
+                _ = closed.wait_for(|closed| *closed) => return,
+            }
+        }
+        if *closed.borrow() {
+            return;
+        }
+
+        let behind = !stream.is_cached(cursor);
+        catching_up.store(behind, Ordering::Relaxed);
+        let mut batch = match read_blocking(&stream, cursor, max_batch).await {
+            Ok(batch) => batch,
+            Err(e) => {
+                let _ = sender.send(Err(e)).await;
+                return;
+            }
+        };
+
+        // A caught-up subscriber lingers so events arriving together are
+        // delivered together; one catching up has a full batch waiting
+        if !behind && batch.len() < max_batch && !options.max_wait.is_zero() {
+            let deadline = tokio::time::Instant::now() + options.max_wait;
+            while batch.len() < max_batch {
+                match tokio::time::timeout_at(deadline, head.changed()).await {
+                    Ok(Ok(())) => {}
+                    _ => break,
+                }
+                let from = batch.last().map_or(cursor, |f| f.offset + 1);
+                match stream.read_from(from, max_batch - batch.len()) {
+                    Ok(more) => batch.extend(more),
+                    Err(e) => {
+                        let _ = sender.send(Err(e)).await;
+                        return;
+                    }
+                }
+            }
+        }
+
+        match batch.last() {
+            Some(last) => cursor = last.offset + 1,
+            // Everything up to the head was dropped by retention
+            None => {
+                cursor = cursor.max(*head.borrow());
+                continue;
+            }
+        }
+        tokio::select! {
+            sent = sender.send(Ok(batch)) => {
+                if sent.is_err() {
+                    return;
+                }
             }
+            _ = closed.wait_for(|closed| *closed) => return,
         }
-        
-        Ok(removed)
     }
 }
 
+/// Stream directory name; stream names are free-form
+fn hex_name(name: &str) -> String {
+    name.bytes().map(|b| format!("{:02x}", b)).collect()
+}
+
 impl Clone for CDCStream {
     fn clone(&self) -> Self {
         Self {
@@ -259,30 +1083,42 @@ impl Clone for CDCStream {
     }
 }
 
+impl Drop for CDCInner {
+    fn drop(&mut self) {
+        if self.temporary {
+            self.streams.get_mut().clear();
+            let _ = fs::remove_dir_all(&self.dir);
+        }
+    }
+}
+
 #[derive(Debug, Serialize)]
 pub struct StreamStats {
     pub total_events: usize,
     pub consumers: usize,
     pub oldest_offset: Option<u64>,
     pub newest_offset: Option<u64>,
+    pub segments: usize,
+    pub disk_bytes: u64,
+    pub cached_bytes: usize,
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
-    
+
     #[test]
     fn test_create_stream() {
         let cdc = CDCStream::new();
         let result = cdc.create_stream(CDCConfig::default());
         assert!(result.is_ok());
     }
-    
+
     #[test]
     fn test_capture_event() {
         let cdc = CDCStream::new();
         cdc.create_stream(CDCConfig::default()).unwrap();
-        
+
         let event = ChangeEvent {
             offset: 0,
             timestamp: SystemTime::now(),
@@ -293,17 +1129,17 @@ mod tests {
             after: Some(serde_json::json!({"name": "Alice"})),
             metadata: HashMap::new(),
         };
-        
+
         let offset = cdc.capture("default", event).unwrap();
         assert_eq!(offset, 0);
     }
-    
+
     #[test]
     fn test_consumer_flow() {
         let cdc = CDCStream::new();
         cdc.create_stream(CDCConfig::default()).unwrap();
         cdc.register_consumer("default", "consumer1".to_string()).unwrap();
-        
+
         // Capture some events
         for i in 0..5 {
             let event = ChangeEvent {
@@ -318,26 +1154,26 @@ mod tests {
             };
             cdc.capture("default", event).unwrap();
         }
-        
+
         // Read events
         let events = cdc.read("default", "consumer1", 10).unwrap();
         assert_eq!(events.len(), 5);
-        
+
         // Acknowledge
         cdc.acknowledge("default", "consumer1", 4).unwrap();
-        
+
         // Read again (should be empty)
         let events = cdc.read("default", "consumer1", 10).unwrap();
         assert_eq!(events.len(), 0);
     }
-    
+
     #[test]
     fn test_multiple_consumers() {
         let cdc = CDCStream::new();
         cdc.create_stream(CDCConfig::default()).unwrap();
         cdc.register_consumer("default", "consumer1".to_string()).unwrap();
         cdc.register_consumer("default", "consumer2".to_string()).unwrap();
-        
+
         // Capture event
         let event = ChangeEvent {
             offset: 0,
@@ -350,23 +1186,229 @@ mod tests {
             metadata: HashMap::new(),
         };
         cdc.capture("default", event).unwrap();
-        
+
         // Both consumers should see the event
         let events1 = cdc.read("default", "consumer1", 10).unwrap();
         let events2 = cdc.read("default", "consumer2", 10).unwrap();
-        
+
         assert_eq!(events1.len(), 1);
         assert_eq!(events2.len(), 1);
+
+        // ...and share its encoding
+        let frames1 = cdc.read_frames("default", "consumer1", 10).unwrap();
+        let frames2 = cdc.read_frames("default", "consumer2", 10).unwrap();
+        assert!(Arc::ptr_eq(&frames1[0].data, &frames2[0].data));
     }
-    
+
     #[test]
     fn test_stats() {
         let cdc = CDCStream::new();
         cdc.create_stream(CDCConfig::default()).unwrap();
         cdc.register_consumer("default", "consumer1".to_string()).unwrap();
-        
+
         let stats = cdc.get_stats("default").unwrap();
         assert_eq!(stats.total_events, 0);
         assert_eq!(stats.consumers, 1);
     }
+
+    #[test]
+    fn test_segments_retention_and_reopen() {
+        let dir = tempfile::TempDir::new().unwrap();
+        let config = CDCConfig {
+            max_buffer_size: 1500,
+            segment_size: 16 * 1024,
+            ..CDCConfig::default()
+        };
+
+        {
+            let cdc = CDCStream::open(dir.path()).unwrap();
+            cdc.create_stream(config).unwrap();
+            for i in 0..2000u64 {
+                let event = ChangeEvent {
+                    offset: 0,
+                    timestamp: SystemTime::now(),
+                    operation: Operation::Update,
+                    table: "users".to_string(),
+                    key: i.to_string(),
+                    before: Some(serde_json::json!({"id": i, "v": 0})),
+                    after: Some(serde_json::json!({"id": i, "v": 1})),
+                    metadata: HashMap::new(),
+                };
+                cdc.capture("default", event).unwrap();
+            }
+
+            let stats = cdc.get_stats("default").unwrap();
+            assert_eq!(stats.total_events, 1500);
+            assert_eq!(stats.oldest_offset, Some(500));
+            assert_eq!(stats.newest_offset, Some(1999));
+            assert!(stats.segments > 1);
+            cdc.sync().unwrap();
+        }
+
+        // Offsets are found through the segment indexes after a restart
+        let cdc = CDCStream::open(dir.path()).unwrap();
+        cdc.register_consumer("default", "c".to_string()).unwrap();
+        cdc.acknowledge("default", "c", 1233).unwrap();
+        let events = cdc.read("default", "c", 100).unwrap();
+        assert_eq!(events.len(), 100);
+        assert_eq!(events[0].offset, 1234);
+        assert_eq!(events[0].key, "1234");
+        assert_eq!(events[99].offset, 1333);
+
+        // Reading from before the retained range starts at the oldest event
+        cdc.register_consumer("default", "late".to_string()).unwrap();
+        let events = cdc.read("default", "late", 3).unwrap();
+        assert_eq!(events.iter().map(|e| e.offset).collect::<Vec<_>>(), vec![500, 501, 502]);
+
+        let event = ChangeEvent {
+            offset: 0,
+            timestamp: SystemTime::now(),
+            operation: Operation::Delete,
+            table: "users".to_string(),
+            key: "x".to_string(),
+            before: None,
+            after: None,
+            metadata: HashMap::new(),
+        };
+        assert_eq!(cdc.capture("default", event).unwrap(), 2000);
+
+        std::thread::sleep(Duration::from_millis(2));
+        assert_eq!(cdc.apply_retention("default", Duration::ZERO).unwrap(), 1500);
+        assert_eq!(cdc.get_stats("default").unwrap().total_events, 0);
+    }
+
+    #[test]
+    fn test_capture_wal() {
+        use crate::wal::LogSequenceNumber;
+
+        let cdc = CDCStream::new();
+        cdc.create_stream(CDCConfig::default()).unwrap();
+        cdc.register_consumer("default", "c".to_string()).unwrap();
+
+        let insert = WalEntry::new(
+            7,
+            LogSequenceNumber::new(42),
+            WalEntryType::Insert {
+                table: "users".to_string(),
+                key: b"u1".to_vec(),
+                value: br#"{"name":"Ada"}"#.to_vec(),
+            },
+        );
+        let commit = WalEntry::new(7, LogSequenceNumber::new(43), WalEntryType::CommitTransaction);
+
+        assert_eq!(cdc.capture_wal("default", &insert).unwrap(), Some(42));
+        assert_eq!(cdc.capture_wal("default", &commit).unwrap(), None);
+        // Replayed entries are skipped
+        assert_eq!(cdc.capture_wal("default", &insert).unwrap(), None);
+
+        let events = cdc.read("default", "c", 10).unwrap();
+        assert_eq!(events.len(), 1);
+        assert_eq!(events[0].offset, 42);
+        assert_eq!(events[0].after, Some(serde_json::json!({"name": "Ada"})));
+        assert_eq!(events[0].metadata["txn_id"], "7");
+    }
+
+    fn user_event(i: u64) -> ChangeEvent {
+        ChangeEvent {
+            offset: 0,
+            timestamp: SystemTime::now(),
+            operation: Operation::Insert,
+            table: "users".to_string(),
+            key: i.to_string(),
+            before: None,
+            after: Some(serde_json::json!({"id": i})),
+            metadata: HashMap::new(),
+        }
+    }
+
+    #[tokio::test(flavor = "multi_thread", worker_threads = 2)]
+    async fn test_subscribe_batches() {
+        let cdc = CDCStream::new();
+        cdc.create_stream(CDCConfig::default()).unwrap();
+        cdc.register_consumer("default", "c".to_string()).unwrap();
+        cdc.capture("default", user_event(0)).unwrap();
+        cdc.acknowledge("default", "c", 0).unwrap();
+
+        let options = SubscribeOptions {
+            max_batch: 10,
+            max_wait: Duration::from_millis(20),
+            buffer: 2,
+        };
+        let mut subscription = cdc.subscribe("default", "c", options).unwrap();
+
+        let producer = cdc.clone();
+        tokio::spawn(async move {
+            for i in 1..=25 {
+                producer.capture("default", user_event(i)).unwrap();
+            }
+        });
+
+        let mut offsets = Vec::new();
+        while offsets.len() < 25 {
+            let batch = tokio::time::timeout(Duration::from_secs(5), subscription.next_batch())
+                .await
+                .expect("no batch delivered")
+                .unwrap()
+                .unwrap();
+            assert!(!batch.is_empty() && batch.len() <= 10);
+            offsets.extend(batch.iter().map(|f| f.offset));
+        }
+        assert_eq!(offsets, (1..=25).collect::<Vec<u64>>());
+        assert!(!subscription.is_catching_up());
+    }
+
+    #[tokio::test(flavor = "multi_thread", worker_threads = 2)]
+    async fn test_delete_stream_ends_subscriptions() {
+        let cdc = CDCStream::new();
+        cdc.create_stream(CDCConfig::default()).unwrap();
+        cdc.register_consumer("default", "c".to_string()).unwrap();
+        let options = SubscribeOptions {
+            max_wait: Duration::ZERO,
+            ..SubscribeOptions::default()
+        };
+        let mut subscription = cdc.subscribe("default", "c", options).unwrap();
+
+        cdc.capture("default", user_event(1)).unwrap();
+        let batch = tokio::time::timeout(Duration::from_secs(5), subscription.next_batch())
+            .await
+            .expect("no batch delivered")
+            .unwrap()
+            .unwrap();
+        assert_eq!(batch.len(), 1);
+
+        // The live subscriber is waiting for more when the stream goes
+        cdc.delete_stream("default").unwrap();
+        let next = tokio::time::timeout(Duration::from_secs(5), subscription.next_batch())
+            .await
+            .expect("subscription outlived its stream");
+        assert!(next.is_none());
+
+        assert!(cdc.get_stats("default").is_err());
+        assert!(cdc.delete_stream("default").is_err());
+        assert!(!cdc.inner.dir.join(hex_name("default")).exists());
+
+        // The name can be used again
+        cdc.create_stream(CDCConfig::default()).unwrap();
+    }
+
+    #[tokio::test(flavor = "multi_thread", worker_threads = 2)]
+    async fn test_read_wait() {
+        let cdc = CDCStream::new();
+        cdc.create_stream(CDCConfig::default()).unwrap();
+        cdc.register_consumer("default", "c".to_string()).unwrap();
+
+        // Nothing arrives: the poll times out empty
+        let frames = cdc.read_wait("default", "c", 10, Duration::from_millis(10)).await.unwrap();
+        assert!(frames.is_empty());
+
+        let producer = cdc.clone();
+        tokio::spawn(async move {
+            tokio::time::sleep(Duration::from_millis(20)).await;
+            producer.capture("default", user_event(1)).unwrap();
+        });
+        let started = std::time::Instant::now();
+        let frames = cdc.read_wait("default", "c", 10, Duration::from_secs(5)).await.unwrap();
+        assert_eq!(frames.len(), 1);
+        assert!(started.elapsed() < Duration::from_secs(1));
+    }
 }
@@ -209,8 +209,8 @@ impl ColumnData {
         while i < self.row_count {
             if let Ok(Some(value)) = self.get_i64(i) {
                 let mut count = 1u32;
-                while i + count < self.row_count {
-                    if let Ok(Some(next)) = self.get_i64(i + count) {
+                while i + (count as usize) < self.row_count {
+                    if let Ok(Some(next)) = self.get_i64(i + count as usize) {
                         if next == value {
                             count += 1;
                         } else {
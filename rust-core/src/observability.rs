@@ -2,47 +2,95 @@
 //!
 //! Comprehensive observability with metrics collection, alerting, and analysis
 
-use crate::error::{Error, Result};
+use crate::error::Result;
 use crate::query_analyzer::{QueryAnalyzer, QueryRecord, IndexSuggestion};
-use parking_lot::RwLock;
-use std::collections::{HashMap, VecDeque};
-use std::sync::Arc;
+use parking_lot::{Mutex, RwLock};
+use std::cell::RefCell;
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicBool, AtomicU32, AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, OnceLock};
 use std::time::{Duration, Instant, SystemTime};
 use serde::{Serialize, Deserialize};
+use tokio::time::MissedTickBehavior;
+use xxhash_rust::xxh3::xxh3_64;
+
+/// Number of stripes in a striped counter
+const COUNTER_STRIPES: usize = 16;
+
+/// Number of shards in the latency histogram registry
+const LATENCY_SHARDS: usize = 16;
+
+/// Slots in each thread's cache of table histograms
+const TABLE_CACHE_SLOTS: usize = 8;
+
+/// Histogram precision: each power of two is split into 2^SUB_BUCKET_BITS /
+/// 2 linear buckets, so a bucket spans at most 1/32 of its value
+const SUB_BUCKET_BITS: u32 = 6;
+const SUB_BUCKETS: u64 = 1 << SUB_BUCKET_BITS;
+const HALF_SUB_BUCKETS: u64 = SUB_BUCKETS / 2;
+
+/// Largest latency tracked, in microseconds (about 12.7 days); longer
+/// samples land in the last bucket
+const MAX_TRACKABLE_BITS: u32 = 40;
+const MAX_TRACKABLE_US: u64 = (1 << MAX_TRACKABLE_BITS) - 1;
+const HISTOGRAM_BUCKETS: usize =
+    ((MAX_TRACKABLE_BITS - SUB_BUCKET_BITS + 2) as usize) * HALF_SUB_BUCKETS as usize;
 
 /// Complete observability system
+///
+/// Recording takes no exclusive lock: counters are striped atomics and
+/// latencies go into per operation and table HDR histograms. Alert rules are
+/// evaluated by `evaluate_alerts`, normally from `start_alert_ticker`, never
+/// on the recording path.
 pub struct ObservabilitySystem {
-    inner: Arc<RwLock<ObservabilityInner>>,
+    shared: Arc<ObservabilityShared>,
     query_analyzer: QueryAnalyzer,
 }
 
-struct ObservabilityInner {
+struct ObservabilityShared {
     metrics: MetricsCollector,
-    alerts: AlertManager,
-    enabled: bool,
+    alerts: RwLock<AlertManager>,
+    enabled: AtomicBool,
 }
 
-/// Real-time metrics collector
-#[derive(Debug, Clone)]
-pub struct MetricsCollector {
-    pub query_count: u64,
-    pub query_latencies: VecDeque<Duration>,
-    pub error_count: u64,
-    pub cache_hits: u64,
-    pub cache_misses: u64,
-    pub active_connections: u32,
-    pub throughput_history: VecDeque<ThroughputSample>,
-    pub resource_usage: ResourceUsage,
-    pub start_time: Instant,
-    max_latency_samples: usize,
-    max_throughput_samples: usize,
+/// Kind of operation a latency sample belongs to
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash, Serialize, Deserialize)]
+#[serde(rename_all = "lowercase")]
+pub enum QueryKind {
+    Select,
+    Insert,
+    Update,
+    Delete,
+    Other,
 }
 
-#[derive(Debug, Clone, Serialize)]
-pub struct ThroughputSample {
-    pub timestamp: SystemTime,
-    pub queries_per_second: f64,
-    pub bytes_per_second: u64,
+impl QueryKind {
+    const COUNT: usize = 5;
+    const ALL: [QueryKind; QueryKind::COUNT] = [
+        QueryKind::Select,
+        QueryKind::Insert,
+        QueryKind::Update,
+        QueryKind::Delete,
+        QueryKind::Other,
+    ];
+
+    fn index(self) -> usize {
+        self as usize
+    }
+}
+
+/// Real-time metrics collector
+pub struct MetricsCollector {
+    latencies: LatencyRegistry,
+    errors: StripedCounter,
+    cache_hits: StripedCounter,
+    cache_misses: StripedCounter,
+    active_connections: AtomicU32,
+    resource_usage: Mutex<ResourceUsage>,
+    /// Longest query and slow query count since the last alert evaluation
+    window_max_us: AtomicU64,
+    window_slow_queries: AtomicU64,
+    start_time: Instant,
 }
 
 #[derive(Debug, Clone, Serialize)]
@@ -54,6 +102,72 @@ pub struct ResourceUsage {
     pub network_tx_bytes: u64,
 }
 
+/// A counter split across cache lines; each thread adds to its own stripe
+struct StripedCounter {
+    stripes: [PaddedCounter; COUNTER_STRIPES],
+}
+
+#[derive(Default)]
+#[repr(align(64))]
+struct PaddedCounter(AtomicU64);
+
+/// Latency histogram with logarithmic buckets and linear sub-buckets
+///
+/// Values are microseconds. Recording is a relaxed add to one bucket, and
+/// histograms merge by adding buckets, so per table histograms roll up into
+/// an overall one without losing precision.
+pub struct LatencyHistogram {
+    buckets: Box<[AtomicU64]>,
+    sum_us: AtomicU64,
+    max_us: AtomicU64,
+}
+
+/// A point-in-time copy of one or more merged histograms
+#[derive(Debug, Clone)]
+pub struct HistogramSnapshot {
+    counts: Vec<u64>,
+    count: u64,
+    sum_us: u64,
+    max_us: u64,
+}
+
+/// Latency percentiles of a histogram
+#[derive(Debug, Clone, Default, Serialize)]
+pub struct LatencySummary {
+    pub count: u64,
+    pub avg_ms: f64,
+    pub p50_ms: f64,
+    pub p95_ms: f64,
+    pub p99_ms: f64,
+    pub p999_ms: f64,
+    pub max_ms: f64,
+}
+
+/// Histograms for one table, one per operation kind, created on first use
+struct TableLatency {
+    kinds: [OnceLock<LatencyHistogram>; QueryKind::COUNT],
+}
+
+/// Per table latency histograms, sharded by table name
+///
+/// Recording threads keep a small direct-mapped cache of the tables they
+/// recently recorded, so the shard locks are only taken on a cache miss.
+struct LatencyRegistry {
+    id: u64,
+    shards: Box<[RwLock<HashMap<Box<str>, Arc<TableLatency>>>]>,
+}
+
+struct CachedTable {
+    registry: u64,
+    hash: u64,
+    table: Box<str>,
+    latency: Arc<TableLatency>,
+}
+
+thread_local! {
+    static TABLE_CACHE: RefCell<[Option<CachedTable>; TABLE_CACHE_SLOTS]> = RefCell::new(Default::default());
+}
+
 /// Alert management system
 #[derive(Debug, Clone)]
 pub struct AlertManager {
@@ -92,11 +206,14 @@ pub struct AlertRule {
 
 #[derive(Debug, Clone)]
 pub enum AlertCondition {
+    /// Longest query since the last evaluation, in ms
     HighLatency,
     HighErrorRate,
     LowCacheHitRatio,
+    /// Memory usage in GB
     HighMemoryUsage,
     HighConnectionCount,
+    /// Queries over the slow query threshold since the last evaluation
     SlowQueryDetected,
 }
 
@@ -126,8 +243,19 @@ pub struct PerformanceMetrics {
     pub p50_latency_ms: f64,
     pub p95_latency_ms: f64,
     pub p99_latency_ms: f64,
+    pub p999_latency_ms: f64,
     pub cache_hit_ratio: f64,
     pub throughput_qps: f64,
+    /// Latency by operation kind and table, busiest first
+    pub operations: Vec<OperationLatency>,
+}
+
+#[derive(Debug, Serialize)]
+pub struct OperationLatency {
+    pub kind: QueryKind,
+    pub table: String,
+    #[serde(flatten)]
+    pub latency: LatencySummary,
 }
 
 #[derive(Debug, Serialize)]
@@ -142,274 +270,225 @@ pub struct ResourceMetrics {
 impl ObservabilitySystem {
     /// Create a new observability system
     pub fn new() -> Self {
-        let query_analyzer = QueryAnalyzer::new(100); // 100ms threshold
-        
-        let inner = ObservabilityInner {
+        let query_analyzer = QueryAnalyzer::new(SLOW_QUERY_THRESHOLD.as_millis() as u64);
+
+        let shared = ObservabilityShared {
             metrics: MetricsCollector::new(),
-            alerts: AlertManager::new(),
-            enabled: true,
+            alerts: RwLock::new(AlertManager::new()),
+            enabled: AtomicBool::new(true),
         };
-        
-        let mut sys = Self {
-            inner: Arc::new(RwLock::new(inner)),
+
+        let sys = Self {
+            shared: Arc::new(shared),
             query_analyzer,
         };
-        
+
         // Add default alert rules
         sys.add_default_rules();
-        
+
         sys
     }
-    
+
     /// Enable observability
     pub fn enable(&self) {
-        let mut inner = self.inner.write();
-        inner.enabled = true;
+        self.shared.enabled.store(true, Ordering::Relaxed);
         self.query_analyzer.enable();
     }
-    
+
     /// Disable observability
     pub fn disable(&self) {
-        let mut inner = self.inner.write();
-        inner.enabled = false;
+        self.shared.enabled.store(false, Ordering::Relaxed);
         self.query_analyzer.disable();
     }
-    
+
+    fn enabled(&self) -> bool {
+        self.shared.enabled.load(Ordering::Relaxed)
+    }
+
     /// Record a query execution
+    ///
+    /// Queries are recorded as selects. Only slow queries are handed to the
+    /// query analyzer, since only those feed index suggestions.
     pub fn record_query(&self, duration: Duration, table: String, columns: QueryColumns) {
-        let mut inner = self.inner.write();
-        
-        if !inner.enabled {
+        if !self.enabled() {
             return;
         }
-        
-        inner.metrics.record_query(duration);
-        
-        // Also record in query analyzer
-        drop(inner);
-        self.query_analyzer.record_query(QueryRecord {
-            query: format!("SELECT ... FROM {}", table),
-            duration,
-            timestamp: Instant::now(),
-            table,
-            where_columns: columns.where_cols,
-            order_by_columns: columns.order_cols,
-        });
-        
-        // Check alerts
-        self.check_alerts();
+
+        self.shared.metrics.record_operation(QueryKind::Select, &table, duration);
+
+        if duration >= SLOW_QUERY_THRESHOLD {
+            self.query_analyzer.record_query(QueryRecord {
+                query: format!("SELECT ... FROM {}", table),
+                duration,
+                timestamp: Instant::now(),
+                table,
+                where_columns: columns.where_cols,
+                order_by_columns: columns.order_cols,
+            });
+        }
     }
-    
+
+    /// Record an operation's latency. This is the hot path: it allocates
+    /// nothing once the table has been seen.
+    pub fn record_operation(&self, kind: QueryKind, table: &str, duration: Duration) {
+        if self.enabled() {
+            self.shared.metrics.record_operation(kind, table, duration);
+        }
+    }
+
     /// Record a query error
     pub fn record_error(&self) {
-        let mut inner = self.inner.write();
-        
-        if inner.enabled {
-            inner.metrics.record_error();
+        if self.enabled() {
+            self.shared.metrics.errors.incr();
         }
     }
-    
+
     /// Record cache hit
     pub fn record_cache_hit(&self) {
-        let mut inner = self.inner.write();
-        
-        if inner.enabled {
-            inner.metrics.record_cache_hit();
+        if self.enabled() {
+            self.shared.metrics.cache_hits.incr();
         }
     }
-    
+
     /// Record cache miss
     pub fn record_cache_miss(&self) {
-        let mut inner = self.inner.write();
-        
-        if inner.enabled {
-            inner.metrics.record_cache_miss();
+        if self.enabled() {
+            self.shared.metrics.cache_misses.incr();
         }
     }
-    
+
     /// Update connection count
     pub fn update_connections(&self, count: u32) {
-        let mut inner = self.inner.write();
-        
-        if inner.enabled {
-            inner.metrics.active_connections = count;
+        if self.enabled() {
+            self.shared.metrics.active_connections.store(count, Ordering::Relaxed);
         }
     }
-    
+
     /// Update resource usage
     pub fn update_resources(&self, usage: ResourceUsage) {
-        let mut inner = self.inner.write();
-        
-        if inner.enabled {
-            inner.metrics.resource_usage = usage;
+        if self.enabled() {
+            *self.shared.metrics.resource_usage.lock() = usage;
         }
     }
-    
+
+    /// Latency percentiles for one operation kind on one table
+    pub fn latency_summary(&self, kind: QueryKind, table: &str) -> Option<LatencySummary> {
+        self.shared.metrics.latencies.snapshot(kind, table).map(|s| s.summary())
+    }
+
     /// Get dashboard metrics
     pub fn get_dashboard_metrics(&self) -> Result<DashboardMetrics> {
-        let inner = self.inner.read();
-        let metrics = &inner.metrics;
-        let alerts = &inner.alerts;
-        
-        // Calculate percentiles
-        let mut latencies: Vec<_> = metrics.query_latencies.iter()
-            .map(|d| d.as_millis() as f64)
-            .collect();
-        latencies.sort_by(|a, b| a.partial_cmp(b).unwrap());
-        
-        let p50 = percentile(&latencies, 0.50);
-        let p95 = percentile(&latencies, 0.95);
-        let p99 = percentile(&latencies, 0.99);
-        let avg = if !latencies.is_empty() {
-            latencies.iter().sum::<f64>() / latencies.len() as f64
-        } else {
-            0.0
-        };
-        
-        // Calculate cache hit ratio
-        let total_cache_ops = metrics.cache_hits + metrics.cache_misses;
-        let cache_hit_ratio = if total_cache_ops > 0 {
-            metrics.cache_hits as f64 / total_cache_ops as f64
-        } else {
-            0.0
-        };
-        
+        let metrics = &self.shared.metrics;
+
+        // Merge the per table histograms into the overall latency
+        let mut overall = HistogramSnapshot::empty();
+        let mut operations = Vec::new();
+        for (kind, table, snapshot) in metrics.latencies.snapshot_all() {
+            overall.merge(&snapshot);
+            operations.push(OperationLatency {
+                kind,
+                table,
+                latency: snapshot.summary(),
+            });
+        }
+        operations.sort_by(|a, b| b.latency.count.cmp(&a.latency.count));
+        let latency = overall.summary();
+
+        let cache_hit_ratio = metrics.cache_hit_ratio().unwrap_or(0.0);
+
         // Calculate QPS
         let uptime = metrics.start_time.elapsed().as_secs();
         let qps = if uptime > 0 {
-            metrics.query_count as f64 / uptime as f64
-        } else {
-            0.0
-        };
-        
-        // Calculate error rate
-        let error_rate = if metrics.query_count > 0 {
-            metrics.error_count as f64 / metrics.query_count as f64
+            latency.count as f64 / uptime as f64
         } else {
             0.0
         };
-        
-        // Get index suggestions
-        drop(inner);
+
+        let error_rate = metrics.error_rate(latency.count);
+        let resources = metrics.resource_usage.lock().clone();
         let index_suggestions = self.query_analyzer.analyze()?;
-        let inner = self.inner.read();
-        
+
         Ok(DashboardMetrics {
             overview: OverviewMetrics {
                 uptime_seconds: uptime,
-                total_queries: metrics.query_count,
+                total_queries: latency.count,
                 queries_per_second: qps,
                 error_rate,
-                active_connections: metrics.active_connections,
+                active_connections: metrics.active_connections.load(Ordering::Relaxed),
             },
             performance: PerformanceMetrics {
-                avg_latency_ms: avg,
-                p50_latency_ms: p50,
-                p95_latency_ms: p95,
-                p99_latency_ms: p99,
+                avg_latency_ms: latency.avg_ms,
+                p50_latency_ms: latency.p50_ms,
+                p95_latency_ms: latency.p95_ms,
+                p99_latency_ms: latency.p99_ms,
+                p999_latency_ms: latency.p999_ms,
                 cache_hit_ratio,
                 throughput_qps: qps,
+                operations,
             },
             resources: ResourceMetrics {
-                cpu_percent: metrics.resource_usage.cpu_percent,
-                memory_bytes: metrics.resource_usage.memory_bytes,
-                disk_bytes: metrics.resource_usage.disk_bytes,
-                network_rx_bytes: metrics.resource_usage.network_rx_bytes,
-                network_tx_bytes: metrics.resource_usage.network_tx_bytes,
+                cpu_percent: resources.cpu_percent,
+                memory_bytes: resources.memory_bytes,
+                disk_bytes: resources.disk_bytes,
+                network_rx_bytes: resources.network_rx_bytes,
+                network_tx_bytes: resources.network_tx_bytes,
             },
-            recent_alerts: alerts.get_recent_alerts(10),
+            recent_alerts: self.shared.alerts.read().get_recent_alerts(10),
             index_suggestions: index_suggestions.into_iter().take(5).collect(),
             timestamp: SystemTime::now(),
         })
     }
-    
+
     /// Add a custom alert rule
     pub fn add_alert_rule(&self, rule: AlertRule) {
-        let mut inner = self.inner.write();
-        inner.alerts.add_rule(rule);
+        self.shared.alerts.write().add_rule(rule);
     }
-    
+
     /// Get all alerts
     pub fn get_alerts(&self) -> Vec<Alert> {
-        let inner = self.inner.read();
-        inner.alerts.get_all_alerts()
+        self.shared.alerts.read().get_all_alerts()
     }
-    
+
     /// Get all active alerts
     pub fn get_active_alerts(&self) -> Vec<Alert> {
-        let inner = self.inner.read();
-        inner.alerts.get_active_alerts()
+        self.shared.alerts.read().get_active_alerts()
     }
-    
+
     /// Resolve an alert
     pub fn resolve_alert(&self, alert_id: &str) {
-        let mut inner = self.inner.write();
-        inner.alerts.resolve_alert(alert_id);
+        self.shared.alerts.write().resolve_alert(alert_id);
     }
-    
+
     /// Clear all resolved alerts
     pub fn clear_resolved_alerts(&self) {
-        let mut inner = self.inner.write();
-        inner.alerts.clear_resolved();
+        self.shared.alerts.write().clear_resolved();
     }
-    
-    /// Check alert conditions
-    fn check_alerts(&self) {
-        let mut inner = self.inner.write();
-        let metrics = &inner.metrics;
-        
-        // Check each rule
-        for rule in inner.alerts.rules.clone() {
-            if !rule.enabled {
-                continue;
-            }
-            
-            let triggered = match rule.condition {
-                AlertCondition::HighLatency => {
-                    if let Some(latest) = metrics.query_latencies.back() {
-                        latest.as_millis() as f64 > rule.threshold
-                    } else {
-                        false
-                    }
-                },
-                AlertCondition::HighErrorRate => {
-                    let error_rate = if metrics.query_count > 0 {
-                        metrics.error_count as f64 / metrics.query_count as f64
-                    } else {
-                        0.0
-                    };
-                    error_rate > rule.threshold
-                },
-                AlertCondition::LowCacheHitRatio => {
-                    let total = metrics.cache_hits + metrics.cache_misses;
-                    let ratio = if total > 0 {
-                        metrics.cache_hits as f64 / total as f64
-                    } else {
-                        1.0
-                    };
-                    ratio < rule.threshold
-                },
-                AlertCondition::HighMemoryUsage => {
-                    let usage_gb = metrics.resource_usage.memory_bytes as f64 / 1_073_741_824.0;
-                    usage_gb > rule.threshold
-                },
-                AlertCondition::HighConnectionCount => {
-                    metrics.active_connections as f64 > rule.threshold
-                },
-                AlertCondition::SlowQueryDetected => {
-                    // Checked by query analyzer
-                    false
-                },
-            };
-            
-            if triggered {
-                inner.alerts.trigger_alert(&rule, metrics);
+
+    /// Evaluate the alert rules against the metrics recorded since the
+    /// previous evaluation
+    pub fn evaluate_alerts(&self) {
+        self.shared.evaluate_alerts();
+    }
+
+    /// Start evaluating alert rules every `period` in the background. The
+    /// task ends once every handle to this system has been dropped.
+    pub fn start_alert_ticker(&self, period: Duration) -> tokio::task::JoinHandle<()> {
+        let shared = Arc::downgrade(&self.shared);
+        tokio::spawn(async move {
+            let mut ticker = tokio::time::interval(period);
+            ticker.set_missed_tick_behavior(MissedTickBehavior::Delay);
+            loop {
+                ticker.tick().await;
+                match shared.upgrade() {
+                    Some(shared) => shared.evaluate_alerts(),
+                    None => break,
+                }
             }
-        }
+        })
     }
-    
+
     /// Add default alert rules
-    fn add_default_rules(&mut self) {
+    fn add_default_rules(&self) {
         let rules = vec![
             AlertRule {
                 id: "high_latency".to_string(),
@@ -444,10 +523,53 @@ impl ObservabilitySystem {
                 enabled: true,
             },
         ];
-        
-        let mut inner = self.inner.write();
+
+        let mut alerts = self.shared.alerts.write();
         for rule in rules {
-            inner.alerts.add_rule(rule);
+            alerts.add_rule(rule);
+        }
+    }
+}
+
+impl ObservabilityShared {
+    fn evaluate_alerts(&self) {
+        let metrics = &self.metrics;
+
+        // Take the windowed values even when no rule reads them, so the next
+        // window starts empty
+        let window_max_ms = metrics.window_max_us.swap(0, Ordering::Relaxed) as f64 / 1000.0;
+        let window_slow = metrics.window_slow_queries.swap(0, Ordering::Relaxed) as f64;
+
+        let mut alerts = self.alerts.write();
+        for rule in alerts.rules.clone() {
+            if !rule.enabled {
+                continue;
+            }
+
+            let (value, triggered) = match rule.condition {
+                AlertCondition::HighLatency => (window_max_ms, window_max_ms > rule.threshold),
+                AlertCondition::HighErrorRate => {
+                    let error_rate = metrics.error_rate(metrics.latencies.count());
+                    (error_rate, error_rate > rule.threshold)
+                },
+                AlertCondition::LowCacheHitRatio => {
+                    let ratio = metrics.cache_hit_ratio().unwrap_or(1.0);
+                    (ratio, ratio < rule.threshold)
+                },
+                AlertCondition::HighMemoryUsage => {
+                    let usage_gb = metrics.resource_usage.lock().memory_bytes as f64 / 1_073_741_824.0;
+                    (usage_gb, usage_gb > rule.threshold)
+                },
+                AlertCondition::HighConnectionCount => {
+                    let connections = metrics.active_connections.load(Ordering::Relaxed) as f64;
+                    (connections, connections > rule.threshold)
+                },
+                AlertCondition::SlowQueryDetected => (window_slow, window_slow > rule.threshold),
+            };
+
+            if triggered {
+                alerts.trigger_alert(&rule, value);
+            }
         }
     }
 }
@@ -455,7 +577,7 @@ impl ObservabilitySystem {
 impl Clone for ObservabilitySystem {
     fn clone(&self) -> Self {
         Self {
-            inner: Arc::clone(&self.inner),
+            shared: Arc::clone(&self.shared),
             query_analyzer: self.query_analyzer.clone(),
         }
     }
@@ -467,48 +589,314 @@ pub struct QueryColumns {
     pub order_cols: Vec<String>,
 }
 
+/// Queries at least this slow go to the query analyzer
+const SLOW_QUERY_THRESHOLD: Duration = Duration::from_millis(100);
+
 impl MetricsCollector {
     fn new() -> Self {
         Self {
-            query_count: 0,
-            query_latencies: VecDeque::new(),
-            error_count: 0,
-            cache_hits: 0,
-            cache_misses: 0,
-            active_connections: 0,
-            throughput_history: VecDeque::new(),
-            resource_usage: ResourceUsage {
+            latencies: LatencyRegistry::new(),
+            errors: StripedCounter::new(),
+            cache_hits: StripedCounter::new(),
+            cache_misses: StripedCounter::new(),
+            active_connections: AtomicU32::new(0),
+            resource_usage: Mutex::new(ResourceUsage {
                 cpu_percent: 0.0,
                 memory_bytes: 0,
                 disk_bytes: 0,
                 network_rx_bytes: 0,
                 network_tx_bytes: 0,
-            },
+            }),
+            window_max_us: AtomicU64::new(0),
+            window_slow_queries: AtomicU64::new(0),
             start_time: Instant::now(),
-            max_latency_samples: 10000,
-            max_throughput_samples: 1000,
         }
     }
-    
-    fn record_query(&mut self, duration: Duration) {
-        self.query_count += 1;
-        self.query_latencies.push_back(duration);
-        
-        if self.query_latencies.len() > self.max_latency_samples {
-            self.query_latencies.pop_front();
+
+    #[inline]
+    fn record_operation(&self, kind: QueryKind, table: &str, duration: Duration) {
+        let us = duration.as_secs().saturating_mul(1_000_000) + u64::from(duration.subsec_micros());
+        self.latencies.record(kind, table, us);
+
+        // Plain loads first: the window maximum only rises a few times per
+        // window, so most queries never write the shared line
+        if us > self.window_max_us.load(Ordering::Relaxed) {
+            self.window_max_us.fetch_max(us, Ordering::Relaxed);
+        }
+        if duration >= SLOW_QUERY_THRESHOLD {
+            self.window_slow_queries.fetch_add(1, Ordering::Relaxed);
         }
     }
-    
-    fn record_error(&mut self) {
-        self.error_count += 1;
+
+    fn error_rate(&self, queries: u64) -> f64 {
+        if queries > 0 {
+            self.errors.sum() as f64 / queries as f64
+        } else {
+            0.0
+        }
     }
-    
-    fn record_cache_hit(&mut self) {
-        self.cache_hits += 1;
+
+    fn cache_hit_ratio(&self) -> Option<f64> {
+        let hits = self.cache_hits.sum();
+        let total = hits + self.cache_misses.sum();
+        if total > 0 {
+            Some(hits as f64 / total as f64)
+        } else {
+            None
+        }
     }
-    
-    fn record_cache_miss(&mut self) {
-        self.cache_misses += 1;
+}
+
+impl StripedCounter {
+    fn new() -> Self {
+        Self {
+            stripes: std::array::from_fn(|_| PaddedCounter::default()),
+        }
+    }
+
+    #[inline]
+    fn incr(&self) {
+        self.stripes[stripe()].0.fetch_add(1, Ordering::Relaxed);
+    }
+
+    fn sum(&self) -> u64 {
+        self.stripes.iter().map(|s| s.0.load(Ordering::Relaxed)).sum()
+    }
+}
+
+/// The calling thread's counter stripe, assigned round robin
+#[inline]
+fn stripe() -> usize {
+    static NEXT_STRIPE: AtomicUsize = AtomicUsize::new(0);
+    thread_local! {
+        static STRIPE: usize = NEXT_STRIPE.fetch_add(1, Ordering::Relaxed) % COUNTER_STRIPES;
+    }
+    STRIPE.with(|s| *s)
+}
+
+impl LatencyHistogram {
+    pub fn new() -> Self {
+        Self {
+            buckets: (0..HISTOGRAM_BUCKETS).map(|_| AtomicU64::new(0)).collect(),
+            sum_us: AtomicU64::new(0),
+            max_us: AtomicU64::new(0),
+        }
+    }
+
+    /// Record a latency in microseconds
+    #[inline]
+    pub fn record(&self, us: u64) {
+        self.buckets[bucket_index(us)].fetch_add(1, Ordering::Relaxed);
+        self.sum_us.fetch_add(us, Ordering::Relaxed);
+        if us > self.max_us.load(Ordering::Relaxed) {
+            self.max_us.fetch_max(us, Ordering::Relaxed);
+        }
+    }
+
+    pub fn snapshot(&self) -> HistogramSnapshot {
+        let mut snapshot = HistogramSnapshot::empty();
+        self.merge_into(&mut snapshot);
+        snapshot
+    }
+
+    /// Add this histogram's counts to a snapshot
+    pub fn merge_into(&self, snapshot: &mut HistogramSnapshot) {
+        for (total, bucket) in snapshot.counts.iter_mut().zip(self.buckets.iter()) {
+            let n = bucket.load(Ordering::Relaxed);
+            *total += n;
+            snapshot.count += n;
+        }
+        snapshot.sum_us += self.sum_us.load(Ordering::Relaxed);
+        snapshot.max_us = snapshot.max_us.max(self.max_us.load(Ordering::Relaxed));
+    }
+
+    fn count(&self) -> u64 {
+        self.buckets.iter().map(|b| b.load(Ordering::Relaxed)).sum()
+    }
+}
+
+impl Default for LatencyHistogram {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Bucket of a value: exact below SUB_BUCKETS, then HALF_SUB_BUCKETS linear
+/// buckets per power of two
+#[inline]
+fn bucket_index(us: u64) -> usize {
+    let v = us.min(MAX_TRACKABLE_US);
+    if v < SUB_BUCKETS {
+        return v as usize;
+    }
+    let shift = 64 - v.leading_zeros() - SUB_BUCKET_BITS;
+    (shift as u64 * HALF_SUB_BUCKETS + (v >> shift)) as usize
+}
+
+/// Midpoint of the values that fall into a bucket
+fn bucket_value(index: usize) -> u64 {
+    let index = index as u64;
+    if index < SUB_BUCKETS {
+        return index;
+    }
+    let shift = index / HALF_SUB_BUCKETS - 1;
+    let low = (index - shift * HALF_SUB_BUCKETS) << shift;
+    low + ((1 << shift) >> 1)
+}
+
+impl HistogramSnapshot {
+    pub fn empty() -> Self {
+        Self {
+            counts: vec![0; HISTOGRAM_BUCKETS],
+            count: 0,
+            sum_us: 0,
+            max_us: 0,
+        }
+    }
+
+    pub fn merge(&mut self, other: &HistogramSnapshot) {
+        for (total, n) in self.counts.iter_mut().zip(&other.counts) {
+            *total += n;
+        }
+        self.count += other.count;
+        self.sum_us += other.sum_us;
+        self.max_us = self.max_us.max(other.max_us);
+    }
+
+    pub fn count(&self) -> u64 {
+        self.count
+    }
+
+    /// Latency at quantile `q` (0.0 to 1.0), in microseconds
+    pub fn value_at_quantile(&self, q: f64) -> u64 {
+        if self.count == 0 {
+            return 0;
+        }
+        let rank = ((q * self.count as f64).ceil() as u64).clamp(1, self.count);
+        if rank == self.count {
+            return self.max_us;
+        }
+        let mut seen = 0;
+        for (index, n) in self.counts.iter().enumerate() {
+            seen += n;
+            if seen >= rank {
+                return bucket_value(index).min(self.max_us);
+            }
+        }
+        self.max_us
+    }
+
+    pub fn summary(&self) -> LatencySummary {
+        let ms = |us: u64| us as f64 / 1000.0;
+        LatencySummary {
+            count: self.count,
+            avg_ms: if self.count > 0 { ms(self.sum_us) / self.count as f64 } else { 0.0 },
+            p50_ms: ms(self.value_at_quantile(0.50)),
+            p95_ms: ms(self.value_at_quantile(0.95)),
+            p99_ms: ms(self.value_at_quantile(0.99)),
+            p999_ms: ms(self.value_at_quantile(0.999)),
+            max_ms: ms(self.max_us),
+        }
+    }
+}
+
+impl TableLatency {
+    fn new() -> Self {
+        Self {
+            kinds: std::array::from_fn(|_| OnceLock::new()),
+        }
+    }
+
+    #[inline]
+    fn histogram(&self, kind: QueryKind) -> &LatencyHistogram {
+        self.kinds[kind.index()].get_or_init(LatencyHistogram::new)
+    }
+}
+
+impl LatencyRegistry {
+    fn new() -> Self {
+        static NEXT_REGISTRY: AtomicU64 = AtomicU64::new(1);
+        Self {
+            id: NEXT_REGISTRY.fetch_add(1, Ordering::Relaxed),
+            shards: (0..LATENCY_SHARDS).map(|_| RwLock::new(HashMap::new())).collect(),
+        }
+    }
+
+    fn shard(&self, hash: u64) -> &RwLock<HashMap<Box<str>, Arc<TableLatency>>> {
+        &self.shards[(hash >> 32) as usize % LATENCY_SHARDS]
+    }
+
+    /// Record a latency
+    #[inline]
+    fn record(&self, kind: QueryKind, table: &str, us: u64) {
+        let hash = xxh3_64(table.as_bytes());
+        let slot = hash as usize % TABLE_CACHE_SLOTS;
+        let cached = TABLE_CACHE.try_with(|cache| {
+            let mut cache = cache.borrow_mut();
+            match &cache[slot] {
+                Some(entry) if entry.registry == self.id && entry.hash == hash && &*entry.table == table => {
+                    entry.latency.histogram(kind).record(us);
+                }
+                _ => {
+                    let latency = self.table(hash, table);
+                    latency.histogram(kind).record(us);
+                    cache[slot] = Some(CachedTable {
+                        registry: self.id,
+                        hash,
+                        table: table.into(),
+                        latency,
+                    });
+                }
+            }
+        });
+        // The thread is exiting and its cache is gone
+        if cached.is_err() {
+            self.table(hash, table).histogram(kind).record(us);
+        }
+    }
+
+    /// A table's histograms, inserting them on first use
+    fn table(&self, hash: u64, table: &str) -> Arc<TableLatency> {
+        let shard = self.shard(hash);
+        if let Some(latency) = shard.read().get(table) {
+            return Arc::clone(latency);
+        }
+        let mut tables = shard.write();
+        Arc::clone(tables.entry(table.into()).or_insert_with(|| Arc::new(TableLatency::new())))
+    }
+
+    fn snapshot(&self, kind: QueryKind, table: &str) -> Option<HistogramSnapshot> {
+        let tables = self.shard(xxh3_64(table.as_bytes())).read();
+        tables.get(table)?.kinds[kind.index()].get().map(LatencyHistogram::snapshot)
+    }
+
+    fn snapshot_all(&self) -> Vec<(QueryKind, String, HistogramSnapshot)> {
+        let mut snapshots = Vec::new();
+        for shard in self.shards.iter() {
+            for (table, latency) in shard.read().iter() {
+                for kind in QueryKind::ALL {
+                    if let Some(histogram) = latency.kinds[kind.index()].get() {
+                        snapshots.push((kind, table.to_string(), histogram.snapshot()));
+                    }
+                }
+            }
+        }
+        snapshots
+    }
+
+    /// Total samples across all histograms
+    fn count(&self) -> u64 {
+        self.shards
+            .iter()
+            .map(|shard| {
+                shard
+                    .read()
+                    .values()
+                    .flat_map(|latency| latency.kinds.iter().filter_map(OnceLock::get))
+                    .map(LatencyHistogram::count)
+                    .sum::<u64>()
+            })
+            .sum()
     }
 }
 
@@ -525,7 +913,7 @@ impl AlertManager {
         self.rules.push(rule);
     }
     
-    fn trigger_alert(&mut self, rule: &AlertRule, metrics: &MetricsCollector) {
+    fn trigger_alert(&mut self, rule: &AlertRule, value: f64) {
         // Check if alert already exists for this rule
         let existing = self.alerts.iter()
             .any(|a| a.rule_id == rule.id && !a.resolved);
@@ -540,7 +928,10 @@ impl AlertManager {
             severity: rule.severity.clone(),
             message: format!("{} triggered", rule.name),
             timestamp: SystemTime::now(),
-            metadata: HashMap::new(),
+            metadata: HashMap::from([
+                ("value".to_string(), value.to_string()),
+                ("threshold".to_string(), rule.threshold.to_string()),
+            ]),
             resolved: false,
         };
         
@@ -581,17 +972,6 @@ impl AlertManager {
     }
 }
 
-/// Calculate percentile from sorted data
-fn percentile(sorted_data: &[f64], p: f64) -> f64 {
-    if sorted_data.is_empty() {
-        return 0.0;
-    }
-    
-    let idx = ((sorted_data.len() as f64) * p) as usize;
-    let idx = idx.min(sorted_data.len() - 1);
-    sorted_data[idx]
-}
-
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -639,7 +1019,76 @@ mod tests {
             },
         );
         
+        // Alerts are evaluated by the ticker, not while recording
+        assert!(obs.get_active_alerts().is_empty());
+        obs.evaluate_alerts();
         let alerts = obs.get_active_alerts();
-        assert!(!alerts.is_empty());
+        assert!(alerts.iter().any(|a| a.rule_id == "high_latency"));
+
+        // The latency window restarts after each evaluation
+        obs.resolve_alert(&alerts[0].id);
+        obs.evaluate_alerts();
+        assert!(obs.get_active_alerts().iter().all(|a| a.rule_id != "high_latency"));
+    }
+
+    #[test]
+    fn test_histogram_accuracy() {
+        let histogram = LatencyHistogram::new();
+        for us in 1..=100_000u64 {
+            histogram.record(us);
+        }
+        let snapshot = histogram.snapshot();
+        assert_eq!(snapshot.count(), 100_000);
+
+        for (q, expected) in [(0.5, 50_000.0), (0.99, 99_000.0), (0.999, 99_900.0)] {
+            let value = snapshot.value_at_quantile(q) as f64;
+            assert!((value - expected).abs() / expected < 0.02, "p{} = {}", q, value);
+        }
+        assert_eq!(snapshot.value_at_quantile(1.0), 100_000);
+
+        // Every value maps to a bucket whose midpoint is within 1/64 of it
+        for us in (0..MAX_TRACKABLE_US).step_by(7_919_333).chain([63, 64, 65, 127, 128]) {
+            let mid = bucket_value(bucket_index(us));
+            assert!(mid.abs_diff(us) as f64 <= us as f64 / 64.0, "{} -> {}", us, mid);
+        }
+    }
+
+    #[test]
+    fn test_operation_latency_by_table() {
+        let obs = ObservabilitySystem::new();
+
+        for ms in 1..=100 {
+            obs.record_operation(QueryKind::Select, "users", Duration::from_millis(ms));
+        }
+        obs.record_operation(QueryKind::Insert, "orders", Duration::from_millis(5));
+
+        let users = obs.latency_summary(QueryKind::Select, "users").unwrap();
+        assert_eq!(users.count, 100);
+        assert!((users.p50_ms - 50.0).abs() < 1.0);
+        assert_eq!(users.max_ms, 100.0);
+        assert!(obs.latency_summary(QueryKind::Insert, "users").is_none());
+
+        let metrics = obs.get_dashboard_metrics().unwrap();
+        assert_eq!(metrics.overview.total_queries, 101);
+        assert_eq!(metrics.performance.operations.len(), 2);
+        assert_eq!(metrics.performance.operations[0].table, "users");
+
+        // Counters recorded from many threads add up
+        let threads: Vec<_> = (0..4)
+            .map(|_| {
+                let obs = obs.clone();
+                std::thread::spawn(move || {
+                    for _ in 0..1000 {
+                        obs.record_error();
+                        obs.record_operation(QueryKind::Update, "orders", Duration::from_micros(20));
+                    }
+                })
+            })
+            .collect();
+        for t in threads {
+            t.join().unwrap();
+        }
+        assert_eq!(obs.latency_summary(QueryKind::Update, "orders").unwrap().count, 4000);
+        assert_eq!(obs.shared.metrics.errors.sum(), 4000);
     }
 }
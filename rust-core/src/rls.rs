@@ -3,7 +3,11 @@
 //! Implements PostgreSQL-compatible Row Level Security with high performance.
 //! Policies are compiled into fast evaluation functions with minimal overhead.
 
-use crate::error::{Error, Result};
+use crate::error::{Error, MantisError, Result};
+use crate::sql::ast::{BinaryOperator, Expression, JoinType, SelectStatement};
+use crate::sql::parser::Parser;
+use crate::sql::types::SqlValue;
+use crate::sql::vectorized::{self, ColumnBatch};
 use serde::{Deserialize, Serialize};
 use std::collections::HashMap;
 use std::sync::{Arc, RwLock};
@@ -155,95 +159,414 @@ pub enum ExpressionType {
     AlwaysTrue,
     /// Always false
     AlwaysFalse,
-    /// User ID check: user_id = current_user_id
+    /// User ID check: column = auth.uid()
     UserIdCheck { column: String },
-    /// Role check: role = current_role
+    /// Role check: auth.role() = 'role' or auth.role() IN (...)
     RoleCheck { allowed_roles: Vec<String> },
-    /// Custom expression
-    Custom { expression: String },
+    /// Any other SQL condition over the row's columns. Context functions in
+    /// it are replaced by their values when the policy is bound.
+    Predicate { expr: Expression },
     /// Composite AND expression
     And { expressions: Vec<ExpressionType> },
     /// Composite OR expression
     Or { expressions: Vec<ExpressionType> },
 }
 
-impl PolicyEvaluator {
-    pub fn new() -> Self {
-        Self {
-            expressions: HashMap::new(),
+/// A policy condition bound to one request's context: what is left to
+/// check against each row, with everything row-independent resolved
+#[derive(Debug, Clone, PartialEq)]
+pub enum RowFilter {
+    /// Every row passes
+    AllowAll,
+    /// No row passes
+    DenyAll,
+    /// Rows pass when this expression over their columns is true
+    Rows(Expression),
+}
+
+impl RowFilter {
+    /// Conjunction of filters
+    pub fn all(filters: impl IntoIterator<Item = RowFilter>) -> RowFilter {
+        let mut exprs = Vec::new();
+        for filter in filters {
+            match filter {
+                RowFilter::AllowAll => {}
+                RowFilter::DenyAll => return RowFilter::DenyAll,
+                RowFilter::Rows(e) => exprs.push(e),
+            }
         }
+        combine(exprs, BinaryOperator::And).map_or(RowFilter::AllowAll, RowFilter::Rows)
     }
 
-    /// Compile an expression for fast evaluation
-    pub fn compile(&mut self, expression: &str) -> Result<CompiledExpression> {
-        // Simple expression parser
-        let expr_type = self.parse_expression(expression)?;
-        
-        Ok(CompiledExpression {
-            original: expression.to_string(),
-            expr_type,
-        })
+    /// Disjunction of filters
+    pub fn any(filters: impl IntoIterator<Item = RowFilter>) -> RowFilter {
+        let mut exprs = Vec::new();
+        for filter in filters {
+            match filter {
+                RowFilter::AllowAll => return RowFilter::AllowAll,
+                RowFilter::DenyAll => {}
+                RowFilter::Rows(e) => exprs.push(e),
+            }
+        }
+        combine(exprs, BinaryOperator::Or).map_or(RowFilter::DenyAll, RowFilter::Rows)
     }
 
-    /// Parse expression into optimized form
-    fn parse_expression(&self, expr: &str) -> Result<ExpressionType> {
-        let expr = expr.trim();
+    /// Check one row given as a JSON object. Columns the row lacks read as NULL.
+    pub fn matches(&self, row: &serde_json::Value) -> Result<bool> {
+        let expr = match self {
+            RowFilter::AllowAll => return Ok(true),
+            RowFilter::DenyAll => return Ok(false),
+            RowFilter::Rows(expr) => expr,
+        };
+        let mut columns = Vec::new();
+        referenced_columns(expr, &mut columns);
+        let compiled = vectorized::compile(expr, &columns).map_err(policy_error)?;
+        let values: Vec<SqlValue> = columns
+            .iter()
+            .map(|c| row.get(c).cloned().map_or(SqlValue::Null, vectorized::json_to_sql))
+            .collect();
+        Ok(compiled.matches_row(&values))
+    }
 
-        // Check for boolean literals
-        if expr == "true" || expr == "1" {
-            return Ok(ExpressionType::AlwaysTrue);
-        }
-        if expr == "false" || expr == "0" {
-            return Ok(ExpressionType::AlwaysFalse);
+    /// Positions of the rows in `batch` that pass, evaluated a column
+    /// vector at a time. This is how columnar scans apply policies.
+    pub fn select(&self, batch: &ColumnBatch) -> Result<Vec<u32>> {
+        match self {
+            RowFilter::AllowAll => Ok((0..batch.num_rows() as u32).collect()),
+            RowFilter::DenyAll => Ok(Vec::new()),
+            RowFilter::Rows(expr) => {
+                let compiled = vectorized::compile(expr, batch.columns()).map_err(policy_error)?;
+                Ok(compiled.select(batch))
+            }
         }
+    }
+}
 
-        // Check for user_id comparisons
-        if expr.contains("user_id") && expr.contains("auth.uid()") {
-            if let Some(column) = self.extract_column_name(expr, "user_id") {
-                return Ok(ExpressionType::UserIdCheck { column });
+fn combine(mut exprs: Vec<Expression>, op: BinaryOperator) -> Option<Expression> {
+    let last = exprs.pop()?;
+    Some(exprs.into_iter().rev().fold(last, |acc, e| Expression::BinaryOp {
+        left: Box::new(e),
+        op: op.clone(),
+        right: Box::new(acc),
+    }))
+}
+
+fn policy_error(e: MantisError) -> Error {
+    Error::ValidationError(format!("invalid policy expression: {}", e))
+}
+
+/// Columns an expression reads, in first-use order
+fn referenced_columns(expr: &Expression, out: &mut Vec<String>) {
+    let mut add = |name: &String| {
+        if !out.contains(name) {
+            out.push(name.clone());
+        }
+    };
+    match expr {
+        Expression::Identifier(name) => add(name),
+        Expression::QualifiedIdentifier { column, .. } => add(column),
+        Expression::Literal(_) | Expression::Subquery(_) => {}
+        Expression::BinaryOp { left, right, .. } => {
+            referenced_columns(left, out);
+            referenced_columns(right, out);
+        }
+        Expression::UnaryOp { expr, .. } | Expression::IsNull { expr, .. } => referenced_columns(expr, out),
+        Expression::FunctionCall { args, .. } => args.iter().for_each(|a| referenced_columns(a, out)),
+        Expression::Case { conditions, else_expr } => {
+            for (c, r) in conditions {
+                referenced_columns(c, out);
+                referenced_columns(r, out);
+            }
+            if let Some(e) = else_expr {
+                referenced_columns(e, out);
             }
         }
+        Expression::InList { expr, list, .. } => {
+            referenced_columns(expr, out);
+            list.iter().for_each(|e| referenced_columns(e, out));
+        }
+        Expression::Between { expr, low, high, .. } => {
+            referenced_columns(expr, out);
+            referenced_columns(low, out);
+            referenced_columns(high, out);
+        }
+        Expression::Like { expr, pattern, .. } => {
+            referenced_columns(expr, out);
+            referenced_columns(pattern, out);
+        }
+    }
+}
+
+/// Context a policy can read instead of row data
+enum ContextRef {
+    UserId,
+    Role,
+    Setting(String),
+}
 
-        // Check for role comparisons
-        if expr.contains("role") && expr.contains("auth.role()") {
-            if let Some(roles) = self.extract_roles(expr) {
-                return Ok(ExpressionType::RoleCheck { allowed_roles: roles });
+/// Recognise auth.uid(), current_user, auth.role(), current_role and
+/// current_setting('name')
+fn context_ref(expr: &Expression) -> Option<ContextRef> {
+    match expr {
+        Expression::FunctionCall { name, args } => match (name.to_ascii_lowercase().as_str(), args.as_slice()) {
+            ("auth.uid", []) => Some(ContextRef::UserId),
+            ("auth.role", []) => Some(ContextRef::Role),
+            ("current_setting", [Expression::Literal(SqlValue::Text(key))]) => {
+                Some(ContextRef::Setting(key.clone()))
             }
+            _ => None,
+        },
+        Expression::Identifier(name) => match name.to_ascii_lowercase().as_str() {
+            "current_user" => Some(ContextRef::UserId),
+            "current_role" => Some(ContextRef::Role),
+            _ => None,
+        },
+        _ => None,
+    }
+}
+
+impl ContextRef {
+    fn value(&self, context: &PolicyContext) -> SqlValue {
+        match self {
+            ContextRef::UserId => context.user_id.clone().map_or(SqlValue::Null, SqlValue::Text),
+            ContextRef::Role => SqlValue::Text(context.role.clone()),
+            ContextRef::Setting(key) => context
+                .session_vars
+                .get(key)
+                .cloned()
+                .map_or(SqlValue::Null, vectorized::json_to_sql),
         }
+    }
+}
 
-        // Handle AND/OR expressions
-        if expr.contains(" AND ") || expr.contains(" and ") {
-            let parts: Vec<&str> = expr.split(" AND ").collect();
-            let sub_exprs: Result<Vec<_>> = parts
+/// Replace context references with their values
+fn bind_context(expr: &Expression, context: &PolicyContext) -> Expression {
+    if let Some(r) = context_ref(expr) {
+        return Expression::Literal(r.value(context));
+    }
+    let bind = |e: &Expression| Box::new(bind_context(e, context));
+    match expr {
+        Expression::Literal(_) | Expression::Identifier(_) | Expression::QualifiedIdentifier { .. } | Expression::Subquery(_) => {
+            expr.clone()
+        }
+        Expression::BinaryOp { left, op, right } => Expression::BinaryOp {
+            left: bind(left),
+            op: op.clone(),
+            right: bind(right),
+        },
+        Expression::UnaryOp { op, expr } => Expression::UnaryOp {
+            op: op.clone(),
+            expr: bind(expr),
+        },
+        Expression::FunctionCall { name, args } => Expression::FunctionCall {
+            name: name.clone(),
+            args: args.iter().map(|a| bind_context(a, context)).collect(),
+        },
+        Expression::Case { conditions, else_expr } => Expression::Case {
+            conditions: conditions
                 .iter()
-                .map(|p| self.parse_expression(p.trim()))
-                .collect();
-            return Ok(ExpressionType::And { expressions: sub_exprs? });
+                .map(|(c, r)| (bind_context(c, context), bind_context(r, context)))
+                .collect(),
+            else_expr: else_expr.as_ref().map(|e| bind(e)),
+        },
+        Expression::InList { expr, list, negated } => Expression::InList {
+            expr: bind(expr),
+            list: list.iter().map(|e| bind_context(e, context)).collect(),
+            negated: *negated,
+        },
+        Expression::Between { expr, low, high, negated } => Expression::Between {
+            expr: bind(expr),
+            low: bind(low),
+            high: bind(high),
+            negated: *negated,
+        },
+        Expression::Like { expr, pattern, negated } => Expression::Like {
+            expr: bind(expr),
+            pattern: bind(pattern),
+            negated: *negated,
+        },
+        Expression::IsNull { expr, negated } => Expression::IsNull {
+            expr: bind(expr),
+            negated: *negated,
+        },
+    }
+}
+
+impl PolicyEvaluator {
+    pub fn new() -> Self {
+        Self {
+            expressions: HashMap::new(),
         }
+    }
 
-        if expr.contains(" OR ") || expr.contains(" or ") {
-            let parts: Vec<&str> = expr.split(" OR ").collect();
-            let sub_exprs: Result<Vec<_>> = parts
-                .iter()
-                .map(|p| self.parse_expression(p.trim()))
-                .collect();
-            return Ok(ExpressionType::Or { expressions: sub_exprs? });
+    /// Compile an expression for fast evaluation
+    pub fn compile(&mut self, expression: &str) -> Result<CompiledExpression> {
+        if let Some(compiled) = self.expressions.get(expression) {
+            return Ok(compiled.clone());
         }
 
-        // Default to custom expression
-        Ok(ExpressionType::Custom {
-            expression: expr.to_string(),
-        })
+        let expr_type = self.parse_expression(expression)?;
+        // Bind against an empty context once so unknown functions and
+        // other mistakes surface when the policy is created
+        Self::bind(&expr_type, &PolicyContext::default())?;
+
+        let compiled = CompiledExpression {
+            original: expression.to_string(),
+            expr_type,
+        };
+        self.expressions.insert(expression.to_string(), compiled.clone());
+        Ok(compiled)
     }
 
-    fn extract_column_name(&self, _expr: &str, default: &str) -> Option<String> {
-        // Simple extraction - in production, use a proper parser
-        Some(default.to_string())
+    /// Parse expression into optimized form
+    fn parse_expression(&self, expr: &str) -> Result<ExpressionType> {
+        let ast = Parser::new(expr)
+            .and_then(|mut p| p.parse_standalone_expression())
+            .map_err(policy_error)?;
+        Ok(Self::classify(ast))
     }
 
-    fn extract_roles(&self, _expr: &str) -> Option<Vec<String>> {
-        // Simple extraction - in production, use a proper parser
-        Some(vec!["authenticated".to_string()])
+    /// Recognise the common policy shapes so they bind without evaluating
+    /// anything; the rest stay general predicates
+    fn classify(expr: Expression) -> ExpressionType {
+        let is_user = |e: &Expression| matches!(context_ref(e), Some(ContextRef::UserId));
+        let is_role = |e: &Expression| matches!(context_ref(e), Some(ContextRef::Role));
+
+        match expr {
+            Expression::Literal(SqlValue::Boolean(true)) | Expression::Literal(SqlValue::Integer(1)) => {
+                ExpressionType::AlwaysTrue
+            }
+            Expression::Literal(SqlValue::Boolean(false)) | Expression::Literal(SqlValue::Integer(0)) => {
+                ExpressionType::AlwaysFalse
+            }
+            Expression::BinaryOp {
+                left,
+                op: BinaryOperator::And,
+                right,
+            } => {
+                let mut expressions = Vec::new();
+                for side in [*left, *right] {
+                    match Self::classify(side) {
+                        ExpressionType::And { expressions: inner } => expressions.extend(inner),
+                        other => expressions.push(other),
+                    }
+                }
+                ExpressionType::And { expressions }
+            }
+            Expression::BinaryOp {
+                left,
+                op: BinaryOperator::Or,
+                right,
+            } => {
+                let mut expressions = Vec::new();
+                for side in [*left, *right] {
+                    match Self::classify(side) {
+                        ExpressionType::Or { expressions: inner } => expressions.extend(inner),
+                        other => expressions.push(other),
+                    }
+                }
+                ExpressionType::Or { expressions }
+            }
+            Expression::BinaryOp {
+                left,
+                op: BinaryOperator::Equal,
+                right,
+            } => match (left.as_ref(), right.as_ref()) {
+                (Expression::Identifier(column), other) | (other, Expression::Identifier(column))
+                    if is_user(other) && context_ref(&Expression::Identifier(column.clone())).is_none() =>
+                {
+                    ExpressionType::UserIdCheck { column: column.clone() }
+                }
+                (role, Expression::Literal(SqlValue::Text(r))) | (Expression::Literal(SqlValue::Text(r)), role)
+                    if is_role(role) =>
+                {
+                    ExpressionType::RoleCheck {
+                        allowed_roles: vec![r.clone()],
+                    }
+                }
+                _ => ExpressionType::Predicate {
+                    expr: Expression::BinaryOp {
+                        left,
+                        op: BinaryOperator::Equal,
+                        right,
+                    },
+                },
+            },
+            Expression::InList {
+                expr,
+                list,
+                negated: false,
+            } if is_role(&expr)
+                && list
+                    .iter()
+                    .all(|e| matches!(e, Expression::Literal(SqlValue::Text(_)))) =>
+            {
+                ExpressionType::RoleCheck {
+                    allowed_roles: list
+                        .into_iter()
+                        .filter_map(|e| match e {
+                            Expression::Literal(SqlValue::Text(r)) => Some(r),
+                            _ => None,
+                        })
+                        .collect(),
+                }
+            }
+            other => ExpressionType::Predicate { expr: other },
+        }
+    }
+
+    /// Resolve an expression for one request. Everything that does not
+    /// depend on the row is decided here, so RoleCheck and the like never
+    /// reach a row.
+    pub fn bind(expr_type: &ExpressionType, context: &PolicyContext) -> Result<RowFilter> {
+        Ok(match expr_type {
+            ExpressionType::AlwaysTrue => RowFilter::AllowAll,
+            ExpressionType::AlwaysFalse => RowFilter::DenyAll,
+            ExpressionType::UserIdCheck { column } => match &context.user_id {
+                Some(user_id) => RowFilter::Rows(Expression::BinaryOp {
+                    left: Box::new(Expression::Identifier(column.clone())),
+                    op: BinaryOperator::Equal,
+                    right: Box::new(Expression::Literal(SqlValue::Text(user_id.clone()))),
+                }),
+                None => RowFilter::DenyAll,
+            },
+            ExpressionType::RoleCheck { allowed_roles } => {
+                if allowed_roles.contains(&context.role) {
+                    RowFilter::AllowAll
+                } else {
+                    RowFilter::DenyAll
+                }
+            }
+            ExpressionType::Predicate { expr } => {
+                let bound = bind_context(expr, context);
+                let mut columns = Vec::new();
+                referenced_columns(&bound, &mut columns);
+                // Compiling checks the expression even when it reads the row
+                let compiled = vectorized::compile(&bound, &columns).map_err(policy_error)?;
+                if columns.is_empty() {
+                    let empty: &[SqlValue] = &[];
+                    if compiled.matches_row(empty) {
+                        RowFilter::AllowAll
+                    } else {
+                        RowFilter::DenyAll
+                    }
+                } else {
+                    RowFilter::Rows(bound)
+                }
+            }
+            ExpressionType::And { expressions } => RowFilter::all(
+                expressions
+                    .iter()
+                    .map(|e| Self::bind(e, context))
+                    .collect::<Result<Vec<_>>>()?,
+            ),
+            ExpressionType::Or { expressions } => RowFilter::any(
+                expressions
+                    .iter()
+                    .map(|e| Self::bind(e, context))
+                    .collect::<Result<Vec<_>>>()?,
+            ),
+        })
     }
 
     /// Evaluate an expression against a context and row data
@@ -253,70 +576,183 @@ impl PolicyEvaluator {
         context: &PolicyContext,
         row_data: &serde_json::Value,
     ) -> Result<bool> {
-        self.evaluate_type(&expr.expr_type, context, row_data)
+        Self::bind(&expr.expr_type, context)?.matches(row_data)
     }
+}
 
-    fn evaluate_type(
-        &self,
-        expr_type: &ExpressionType,
-        context: &PolicyContext,
-        row_data: &serde_json::Value,
-    ) -> Result<bool> {
-        match expr_type {
-            ExpressionType::AlwaysTrue => Ok(true),
-            ExpressionType::AlwaysFalse => Ok(false),
-            
-            ExpressionType::UserIdCheck { column } => {
-                if let Some(user_id) = &context.user_id {
-                    if let Some(row_user_id) = row_data.get(column) {
-                        Ok(row_user_id.as_str() == Some(user_id.as_str()))
-                    } else {
-                        Ok(false)
-                    }
-                } else {
-                    Ok(false)
-                }
-            }
+/// A policy with its expressions compiled
+#[derive(Clone)]
+struct CompiledPolicy {
+    policy: Policy,
+    using: Option<ExpressionType>,
+    with_check: Option<ExpressionType>,
+}
 
-            ExpressionType::RoleCheck { allowed_roles } => {
-                Ok(allowed_roles.contains(&context.role))
-            }
+/// What a table's policies decide for one (role, command): the applicable
+/// policies' conditions combined into one expression each, with role checks
+/// already resolved. A program that is AlwaysTrue or AlwaysFalse decides
+/// without looking at the request's user or the row.
+#[derive(Debug, Clone, PartialEq)]
+pub struct DecisionProgram {
+    /// Combined USING conditions
+    pub using: ExpressionType,
+    /// Combined WITH CHECK conditions
+    pub with_check: ExpressionType,
+}
 
-            ExpressionType::And { expressions } => {
-                for expr in expressions {
-                    if !self.evaluate_type(expr, context, row_data)? {
-                        return Ok(false);
-                    }
+impl DecisionProgram {
+    const ALLOW: DecisionProgram = DecisionProgram {
+        using: ExpressionType::AlwaysTrue,
+        with_check: ExpressionType::AlwaysTrue,
+    };
+
+    /// Build the program for one role and command. Restrictive policies must
+    /// all pass and, if there are permissive policies, at least one of them
+    /// must too. A policy without the expression passes; no applicable
+    /// policy at all denies.
+    fn build(policies: &[CompiledPolicy], role: &str, command: &PolicyCommand) -> DecisionProgram {
+        let applicable: Vec<_> = policies
+            .iter()
+            .filter(|p| p.policy.enabled && p.policy.applies_to_role(role) && p.policy.applies_to_command(command))
+            .collect();
+        if applicable.is_empty() {
+            return DecisionProgram {
+                using: ExpressionType::AlwaysFalse,
+                with_check: ExpressionType::AlwaysFalse,
+            };
+        }
+
+        let combine = |expr_of: fn(&CompiledPolicy) -> &Option<ExpressionType>| {
+            let mut restrictive = Vec::new();
+            let mut permissive = Vec::new();
+            for p in &applicable {
+                let expr = expr_of(p).clone().map_or(ExpressionType::AlwaysTrue, |e| fold_role(e, role));
+                match p.policy.permission {
+                    PolicyPermission::Restrictive => restrictive.push(expr),
+                    PolicyPermission::Permissive => permissive.push(expr),
                 }
-                Ok(true)
             }
+            if !permissive.is_empty() {
+                restrictive.push(fold(ExpressionType::Or { expressions: permissive }));
+            }
+            fold(ExpressionType::And { expressions: restrictive })
+        };
 
-            ExpressionType::Or { expressions } => {
-                for expr in expressions {
-                    if self.evaluate_type(expr, context, row_data)? {
-                        return Ok(true);
-                    }
-                }
-                Ok(false)
+        DecisionProgram {
+            using: combine(|p| &p.using),
+            with_check: combine(|p| &p.with_check),
+        }
+    }
+}
+
+/// Resolve role checks for a known role
+fn fold_role(expr: ExpressionType, role: &str) -> ExpressionType {
+    match expr {
+        ExpressionType::RoleCheck { allowed_roles } => {
+            if allowed_roles.iter().any(|r| r == role) {
+                ExpressionType::AlwaysTrue
+            } else {
+                ExpressionType::AlwaysFalse
             }
+        }
+        ExpressionType::And { expressions } => fold(ExpressionType::And {
+            expressions: expressions.into_iter().map(|e| fold_role(e, role)).collect(),
+        }),
+        ExpressionType::Or { expressions } => fold(ExpressionType::Or {
+            expressions: expressions.into_iter().map(|e| fold_role(e, role)).collect(),
+        }),
+        other => other,
+    }
+}
 
-            ExpressionType::Custom { expression: _ } => {
-                // For custom expressions, would need a full SQL/expression evaluator
-                // For now, default to true (unsafe - implement proper evaluation)
-                Ok(true)
+/// Drop constants from a conjunction or disjunction, collapsing it to a
+/// constant or to its only member where possible
+fn fold(expr: ExpressionType) -> ExpressionType {
+    let (expressions, is_and) = match expr {
+        ExpressionType::And { expressions } => (expressions, true),
+        ExpressionType::Or { expressions } => (expressions, false),
+        other => return other,
+    };
+    let (identity, absorbing) = if is_and {
+        (ExpressionType::AlwaysTrue, ExpressionType::AlwaysFalse)
+    } else {
+        (ExpressionType::AlwaysFalse, ExpressionType::AlwaysTrue)
+    };
+
+    let mut kept = Vec::with_capacity(expressions.len());
+    for e in expressions {
+        if e == absorbing {
+            return absorbing;
+        }
+        if e != identity {
+            kept.push(e);
+        }
+    }
+    match kept.len() {
+        0 => identity,
+        1 => kept.pop().unwrap(),
+        _ if is_and => ExpressionType::And { expressions: kept },
+        _ => ExpressionType::Or { expressions: kept },
+    }
+}
+
+/// Index of a command in a per-role program array
+fn command_slot(command: &PolicyCommand) -> usize {
+    match command {
+        PolicyCommand::Select => 0,
+        PolicyCommand::Insert => 1,
+        PolicyCommand::Update => 2,
+        PolicyCommand::Delete => 3,
+        PolicyCommand::All => 4,
+    }
+}
+
+type RolePrograms = [Option<Arc<DecisionProgram>>; 5];
+
+/// A table's policies, compiled when they change, and the decision
+/// programs built from them so far
+struct TablePolicies {
+    policies: Vec<CompiledPolicy>,
+    programs: RwLock<HashMap<String, RolePrograms>>,
+}
+
+impl TablePolicies {
+    fn new(policies: Vec<CompiledPolicy>) -> Self {
+        Self {
+            policies,
+            programs: RwLock::new(HashMap::new()),
+        }
+    }
+
+    fn program(&self, role: &str, command: &PolicyCommand) -> Result<Arc<DecisionProgram>> {
+        let slot = command_slot(command);
+        {
+            let programs = self.programs.read()
+                .map_err(|_| Error::Io("Lock poisoned".to_string()))?;
+            if let Some(program) = programs.get(role).and_then(|p| p[slot].as_ref()) {
+                return Ok(Arc::clone(program));
             }
         }
+
+        let program = Arc::new(DecisionProgram::build(&self.policies, role, command));
+        let mut programs = self.programs.write()
+            .map_err(|_| Error::Io("Lock poisoned".to_string()))?;
+        programs.entry(role.to_string()).or_default()[slot] = Some(Arc::clone(&program));
+        Ok(program)
     }
 }
 
 /// RLS Engine manages policies and enforces security
 pub struct RlsEngine {
-    /// Policies by table
-    policies: Arc<RwLock<HashMap<String, Vec<Policy>>>>,
+    /// Policies by table. A table's entry is replaced whenever its policies
+    /// change, which drops the decision programs built from the old ones.
+    policies: Arc<RwLock<HashMap<String, Arc<TablePolicies>>>>,
     /// RLS enabled tables
     enabled_tables: Arc<RwLock<HashMap<String, bool>>>,
     /// Policy evaluator
     evaluator: Arc<RwLock<PolicyEvaluator>>,
+    /// Program for tables without RLS
+    allow_all: Arc<DecisionProgram>,
 }
 
 impl RlsEngine {
@@ -325,6 +761,7 @@ impl RlsEngine {
             policies: Arc::new(RwLock::new(HashMap::new())),
             enabled_tables: Arc::new(RwLock::new(HashMap::new())),
             evaluator: Arc::new(RwLock::new(PolicyEvaluator::new())),
+            allow_all: Arc::new(DecisionProgram::ALLOW),
         }
     }
 
@@ -350,38 +787,76 @@ impl RlsEngine {
         enabled.get(table).copied().unwrap_or(false)
     }
 
-    /// Add a policy to a table
+    /// Add a policy to a table. Its expressions are compiled here, so an
+    /// invalid one is rejected instead of failing every later check.
     pub fn add_policy(&self, policy: Policy) -> Result<()> {
-        let mut policies = self.policies.write()
-            .map_err(|_| Error::Io("Lock poisoned".to_string()))?;
-        
-        let table_policies = policies.entry(policy.table.clone()).or_insert_with(Vec::new);
-        
-        // Remove existing policy with same name
-        table_policies.retain(|p| p.name != policy.name);
-        
-        // Add new policy
-        table_policies.push(policy);
-        
-        Ok(())
+        let compiled = {
+            let mut evaluator = self.evaluator.write()
+                .map_err(|_| Error::Io("Lock poisoned".to_string()))?;
+            let mut compile = |expr: &Option<String>| -> Result<Option<ExpressionType>> {
+                expr.as_deref()
+                    .map(|e| evaluator.compile(e).map(|c| c.expr_type))
+                    .transpose()
+            };
+            CompiledPolicy {
+                using: compile(&policy.using_expr)?,
+                with_check: compile(&policy.with_check_expr)?,
+                policy,
+            }
+        };
+
+        let table = compiled.policy.table.clone();
+        let name = compiled.policy.name.clone();
+        self.update_table(&table, |policies| {
+            // Remove existing policy with same name
+            policies.retain(|p| p.policy.name != name);
+            policies.push(compiled);
+        })
     }
 
     /// Remove a policy
     pub fn remove_policy(&self, table: &str, policy_name: &str) -> Result<()> {
+        self.update_table(table, |policies| policies.retain(|p| p.policy.name != policy_name))
+    }
+
+    /// Replace a table's policy set with an edited copy
+    fn update_table(&self, table: &str, edit: impl FnOnce(&mut Vec<CompiledPolicy>)) -> Result<()> {
         let mut policies = self.policies.write()
             .map_err(|_| Error::Io("Lock poisoned".to_string()))?;
-        
-        if let Some(table_policies) = policies.get_mut(table) {
-            table_policies.retain(|p| p.name != policy_name);
-        }
-        
+
+        let mut table_policies = policies.get(table).map(|t| t.policies.clone()).unwrap_or_default();
+        edit(&mut table_policies);
+        policies.insert(table.to_string(), Arc::new(TablePolicies::new(table_policies)));
         Ok(())
     }
 
     /// Get all policies for a table
     pub fn get_policies(&self, table: &str) -> Vec<Policy> {
         let policies = self.policies.read().unwrap();
-        policies.get(table).cloned().unwrap_or_default()
+        policies
+            .get(table)
+            .map(|t| t.policies.iter().map(|p| p.policy.clone()).collect())
+            .unwrap_or_default()
+    }
+
+    /// The decision program for a table, role and command, built on first
+    /// use and cached until the table's policies change
+    pub fn decision(&self, table: &str, role: &str, command: &PolicyCommand) -> Result<Arc<DecisionProgram>> {
+        // If RLS is not enabled, allow all operations
+        if !self.is_rls_enabled(table) {
+            return Ok(Arc::clone(&self.allow_all));
+        }
+
+        let table_policies = {
+            let policies = self.policies.read()
+                .map_err(|_| Error::Io("Lock poisoned".to_string()))?;
+            match policies.get(table) {
+                Some(t) => Arc::clone(t),
+                // No policies = deny by default when RLS enabled
+                None => return Ok(Arc::new(DecisionProgram::build(&[], role, command))),
+            }
+        };
+        table_policies.program(role, command)
     }
 
     /// Check if a SELECT operation is allowed for a row
@@ -434,86 +909,144 @@ impl RlsEngine {
         row_data: &serde_json::Value,
         new_row_data: Option<&serde_json::Value>,
     ) -> Result<bool> {
-        // If RLS is not enabled, allow all operations
-        if !self.is_rls_enabled(table) {
-            return Ok(true);
+        let program = self.decision(table, &context.role, command)?;
+        if !PolicyEvaluator::bind(&program.using, context)?.matches(row_data)? {
+            return Ok(false);
         }
 
-        let policies = self.policies.read().unwrap();
-        let table_policies = match policies.get(table) {
-            Some(p) => p,
-            None => return Ok(false), // No policies = deny by default when RLS enabled
-        };
-
-        // Filter policies that apply to this operation and role
-        let applicable_policies: Vec<_> = table_policies
-            .iter()
-            .filter(|p| p.enabled && p.applies_to_role(&context.role) && p.applies_to_command(command))
-            .collect();
-
-        if applicable_policies.is_empty() {
-            return Ok(false); // No applicable policies = deny
+        // WITH CHECK constrains the rows an INSERT or UPDATE writes
+        if matches!(command, PolicyCommand::Insert | PolicyCommand::Update) {
+            let check = PolicyEvaluator::bind(&program.with_check, context)?;
+            return check.matches(new_row_data.unwrap_or(row_data));
         }
 
-        // Separate permissive and restrictive policies
-        let (permissive, restrictive): (Vec<_>, Vec<_>) = applicable_policies
-            .into_iter()
-            .partition(|p| p.permission == PolicyPermission::Permissive);
+        Ok(true)
+    }
 
-        // Evaluate restrictive policies (all must pass)
-        for policy in restrictive {
-            let result = self.evaluate_policy(policy, context, row_data, new_row_data)?;
-            if !result {
-                return Ok(false); // Any restrictive policy failure = deny
+    /// The USING conditions of a table's policies for one command, bound to
+    /// `context`. Scans apply the result to whole batches (`RowFilter::select`)
+    /// or push it into a query (`secure_select`) instead of checking rows
+    /// one at a time.
+    pub fn row_filter(
+        &self,
+        table: &str,
+        command: &PolicyCommand,
+        context: &PolicyContext,
+    ) -> Result<RowFilter> {
+        let program = self.decision(table, &context.role, command)?;
+        PolicyEvaluator::bind(&program.using, context)
+    }
+
+    /// Rewrite a SELECT so that it only sees rows the context may read.
+    /// The FROM table's policies are ANDed into WHERE, ahead of the user's
+    /// own condition, so the planner pushes them into the table scan; a
+    /// joined table's policies go into its ON condition.
+    pub fn secure_select(&self, stmt: &SelectStatement, context: &PolicyContext) -> Result<SelectStatement> {
+        let mut secured = stmt.clone();
+
+        if let Some(from) = &stmt.from {
+            match self.row_filter(&from.name, &PolicyCommand::Select, context)? {
+                RowFilter::AllowAll => {}
+                filter => {
+                    let qualifier = if stmt.joins.is_empty() {
+                        None
+                    } else {
+                        Some(from.alias.as_deref().unwrap_or(&from.name))
+                    };
+                    secured.where_clause = conjoin(filter_expression(filter, qualifier), stmt.where_clause.clone());
+                }
             }
         }
 
-        // Evaluate permissive policies (at least one must pass)
-        if !permissive.is_empty() {
-            let mut any_passed = false;
-            for policy in permissive {
-                let result = self.evaluate_policy(policy, context, row_data, new_row_data)?;
-                if result {
-                    any_passed = true;
-                    break;
-                }
+        for join in &mut secured.joins {
+            let filter = self.row_filter(&join.table.name, &PolicyCommand::Select, context)?;
+            if filter == RowFilter::AllowAll {
+                continue;
             }
-            if !any_passed {
-                return Ok(false); // No permissive policy passed = deny
+            // The ON condition only hides the right-hand table's rows for
+            // inner and left joins
+            if matches!(join.join_type, JoinType::Right | JoinType::Full) {
+                return Err(Error::ValidationError(format!(
+                    "row level security on {} is not supported in a {:?} join",
+                    join.table.name, join.join_type
+                )));
             }
+            let qualifier = join.table.alias.clone().unwrap_or_else(|| join.table.name.clone());
+            let filter = filter_expression(filter, Some(&qualifier));
+            join.condition = if join.join_type == JoinType::Cross {
+                join.join_type = JoinType::Inner;
+                filter
+            } else {
+                conjoin(filter, Some(join.condition.clone())).unwrap()
+            };
         }
 
-        Ok(true)
+        Ok(secured)
     }
+}
 
-    fn evaluate_policy(
-        &self,
-        policy: &Policy,
-        context: &PolicyContext,
-        row_data: &serde_json::Value,
-        new_row_data: Option<&serde_json::Value>,
-    ) -> Result<bool> {
-        let mut evaluator = self.evaluator.write()
-            .map_err(|_| Error::Io("Lock poisoned".to_string()))?;
-        
-        // Evaluate USING expression
-        if let Some(using_expr) = &policy.using_expr {
-            let compiled = evaluator.compile(using_expr)?;
-            if !evaluator.evaluate(&compiled, context, row_data)? {
-                return Ok(false);
-            }
-        }
+/// The expression form of a filter, with its columns qualified by `table`
+fn filter_expression(filter: RowFilter, table: Option<&str>) -> Expression {
+    match filter {
+        RowFilter::AllowAll => Expression::Literal(SqlValue::Boolean(true)),
+        RowFilter::DenyAll => Expression::Literal(SqlValue::Boolean(false)),
+        RowFilter::Rows(expr) => match table {
+            Some(table) => qualify(expr, table),
+            None => expr,
+        },
+    }
+}
 
-        // Evaluate WITH CHECK expression (for INSERT/UPDATE)
-        if let Some(with_check_expr) = &policy.with_check_expr {
-            let check_row = new_row_data.unwrap_or(row_data);
-            let compiled = evaluator.compile(with_check_expr)?;
-            if !evaluator.evaluate(&compiled, context, check_row)? {
-                return Ok(false);
-            }
-        }
+fn conjoin(policy: Expression, condition: Option<Expression>) -> Option<Expression> {
+    Some(match condition {
+        Some(condition) => Expression::BinaryOp {
+            left: Box::new(policy),
+            op: BinaryOperator::And,
+            right: Box::new(condition),
+        },
+        None => policy,
+    })
+}
 
-        Ok(true)
+/// Qualify the bare column names in a bound policy expression
+fn qualify(expr: Expression, table: &str) -> Expression {
+    let q = |e: Box<Expression>| Box::new(qualify(*e, table));
+    match expr {
+        Expression::Identifier(column) => Expression::QualifiedIdentifier {
+            table: table.to_string(),
+            column,
+        },
+        Expression::Literal(_) | Expression::QualifiedIdentifier { .. } | Expression::Subquery(_) => expr,
+        Expression::BinaryOp { left, op, right } => Expression::BinaryOp { left: q(left), op, right: q(right) },
+        Expression::UnaryOp { op, expr } => Expression::UnaryOp { op, expr: q(expr) },
+        Expression::FunctionCall { name, args } => Expression::FunctionCall {
+            name,
+            args: args.into_iter().map(|a| qualify(a, table)).collect(),
+        },
+        Expression::Case { conditions, else_expr } => Expression::Case {
+            conditions: conditions
+                .into_iter()
+                .map(|(c, r)| (qualify(c, table), qualify(r, table)))
+                .collect(),
+            else_expr: else_expr.map(q),
+        },
+        Expression::InList { expr, list, negated } => Expression::InList {
+            expr: q(expr),
+            list: list.into_iter().map(|e| qualify(e, table)).collect(),
+            negated,
+        },
+        Expression::Between { expr, low, high, negated } => Expression::Between {
+            expr: q(expr),
+            low: q(low),
+            high: q(high),
+            negated,
+        },
+        Expression::Like { expr, pattern, negated } => Expression::Like {
+            expr: q(expr),
+            pattern: q(pattern),
+            negated,
+        },
+        Expression::IsNull { expr, negated } => Expression::IsNull { expr: q(expr), negated },
     }
 }
 
@@ -596,4 +1129,135 @@ mod tests {
         let result = engine.check_select("users", &context, &row).unwrap();
         assert!(result);
     }
+
+    fn policy(name: &str, using_expr: &str) -> Policy {
+        Policy {
+            name: name.to_string(),
+            table: "docs".to_string(),
+            command: PolicyCommand::Select,
+            permission: PolicyPermission::Permissive,
+            roles: vec![],
+            using_expr: Some(using_expr.to_string()),
+            with_check_expr: None,
+            enabled: true,
+        }
+    }
+
+    #[test]
+    fn test_policy_classification() {
+        let mut evaluator = PolicyEvaluator::new();
+        let compiled = evaluator.compile("auth.uid() = owner_id AND auth.role() IN ('admin', 'editor')").unwrap();
+        assert_eq!(
+            compiled.expr_type,
+            ExpressionType::And {
+                expressions: vec![
+                    ExpressionType::UserIdCheck { column: "owner_id".to_string() },
+                    ExpressionType::RoleCheck {
+                        allowed_roles: vec!["admin".to_string(), "editor".to_string()],
+                    },
+                ],
+            }
+        );
+
+        // Role checks are decided when the policy is bound, not per row
+        let admin = PolicyContext::new("admin".to_string()).with_user_id("u1".to_string());
+        let filter = PolicyEvaluator::bind(&compiled.expr_type, &admin).unwrap();
+        assert!(matches!(filter, RowFilter::Rows(_)));
+        let guest = PolicyContext::new("guest".to_string()).with_user_id("u1".to_string());
+        assert_eq!(PolicyEvaluator::bind(&compiled.expr_type, &guest).unwrap(), RowFilter::DenyAll);
+
+        assert!(evaluator.compile("owner_id = no_such_function()").is_err());
+        assert!(evaluator.compile("owner_id =").is_err());
+    }
+
+    #[test]
+    fn test_custom_predicate() {
+        let engine = RlsEngine::new();
+        engine.enable_rls("docs").unwrap();
+        engine
+            .add_policy(policy("published", "status = 'published' OR (owner = auth.uid() AND NOT archived)"))
+            .unwrap();
+
+        let context = PolicyContext::new("authenticated".to_string()).with_user_id("u1".to_string());
+        let check = |row: serde_json::Value| engine.check_select("docs", &context, &row).unwrap();
+        assert!(check(serde_json::json!({"status": "published", "owner": "u2"})));
+        assert!(check(serde_json::json!({"status": "draft", "owner": "u1", "archived": false})));
+        assert!(!check(serde_json::json!({"status": "draft", "owner": "u1", "archived": true})));
+        assert!(!check(serde_json::json!({"status": "draft", "owner": "u2", "archived": false})));
+        // A missing column is NULL, which never passes
+        assert!(!check(serde_json::json!({"owner": "u2"})));
+    }
+
+    #[test]
+    fn test_secure_select_pushdown() {
+        use crate::sql::ast::Statement;
+        use crate::sql::executor::QueryExecutor;
+        use crate::sql::optimizer::QueryOptimizer;
+        use crate::sql::vectorized::KvTableSource;
+        use crate::storage::LockFreeStorage;
+
+        let storage = LockFreeStorage::new(1024).unwrap();
+        storage.put(b"docs/a", br#"{"owner":"u1","title":"one"}"#).unwrap();
+        storage.put(b"docs/b", br#"{"owner":"u2","title":"two"}"#).unwrap();
+        storage.put(b"docs/c", br#"{"owner":"u1","title":"three"}"#).unwrap();
+        let executor = QueryExecutor::with_source(Arc::new(KvTableSource::new(storage)));
+
+        let engine = RlsEngine::new();
+        engine.enable_rls("docs").unwrap();
+        engine.add_policy(policy("owner", "owner = auth.uid()")).unwrap();
+
+        let run = |sql: &str, context: &PolicyContext| {
+            let stmt = match Parser::new(sql).unwrap().parse().unwrap() {
+                Statement::Select(stmt) => stmt,
+                other => panic!("not a select: {:?}", other),
+            };
+            let secured = engine.secure_select(&stmt, context).unwrap();
+            let plan = QueryOptimizer::new().optimize(&secured).unwrap();
+            let result = executor.execute(&plan).unwrap();
+            let title = result.columns.iter().position(|c| c == "title").unwrap();
+            let mut titles: Vec<SqlValue> = result.rows.iter().map(|r| r[title].clone()).collect();
+            titles.sort_by_key(|v| format!("{:?}", v));
+            titles
+        };
+
+        let u1 = PolicyContext::new("authenticated".to_string()).with_user_id("u1".to_string());
+        assert_eq!(
+            run("SELECT title FROM docs", &u1),
+            vec![SqlValue::Text("one".to_string()), SqlValue::Text("three".to_string())]
+        );
+        // The user's condition narrows the policy but cannot widen it
+        assert_eq!(run("SELECT title FROM docs WHERE key = 'b' OR key = 'c'", &u1), vec![SqlValue::Text("three".to_string())]);
+        assert_eq!(run("SELECT title FROM docs WHERE key = 'b'", &u1), Vec::<SqlValue>::new());
+        // No user, no rows
+        assert!(run("SELECT title FROM docs", &PolicyContext::default()).is_empty());
+    }
+
+    #[test]
+    fn test_decision_cache() {
+        let engine = RlsEngine::new();
+        engine.enable_rls("docs").unwrap();
+        engine.add_policy(policy("service", "auth.role() = 'service_role'")).unwrap();
+        engine.add_policy(policy("owner", "owner = auth.uid()")).unwrap();
+
+        // The service role passes on its role alone, before any row is read
+        let service = engine.decision("docs", "service_role", &PolicyCommand::Select).unwrap();
+        assert_eq!(service.using, ExpressionType::AlwaysTrue);
+        assert!(Arc::ptr_eq(&service, &engine.decision("docs", "service_role", &PolicyCommand::Select).unwrap()));
+
+        // Other roles are left with the row condition
+        let user = engine.decision("docs", "authenticated", &PolicyCommand::Select).unwrap();
+        assert_eq!(user.using, ExpressionType::UserIdCheck { column: "owner".to_string() });
+        assert_eq!(engine.decision("docs", "authenticated", &PolicyCommand::Delete).unwrap().using, ExpressionType::AlwaysFalse);
+
+        // Changing the policies drops the cached programs
+        engine.remove_policy("docs", "owner").unwrap();
+        let user = engine.decision("docs", "authenticated", &PolicyCommand::Select).unwrap();
+        assert_eq!(user.using, ExpressionType::AlwaysFalse);
+        let row = serde_json::json!({"owner": "u1"});
+        let context = PolicyContext::new("authenticated".to_string()).with_user_id("u1".to_string());
+        assert!(!engine.check_select("docs", &context, &row).unwrap());
+
+        assert!(engine.add_policy(policy("broken", "owner = nope(")).is_err());
+        assert_eq!(engine.get_policies("docs").len(), 1);
+    }
 }
@@ -1,15 +1,34 @@
 // Query Executor - Execute optimized query plans
 use super::optimizer::*;
 use super::types::*;
+use super::vectorized::{self, BatchSource, ColumnBatch, CompiledExpr, DEFAULT_BATCH_SIZE};
 use crate::error::MantisError;
+use std::sync::Arc;
 
 pub struct QueryExecutor {
-    // Storage engine interface would go here
+    source: Option<Arc<dyn BatchSource>>,
+    batch_size: usize,
 }
 
 impl QueryExecutor {
     pub fn new() -> Self {
-        QueryExecutor {}
+        QueryExecutor {
+            source: None,
+            batch_size: DEFAULT_BATCH_SIZE,
+        }
+    }
+
+    /// Executor whose table scans read from `source`
+    pub fn with_source(source: Arc<dyn BatchSource>) -> Self {
+        QueryExecutor {
+            source: Some(source),
+            batch_size: DEFAULT_BATCH_SIZE,
+        }
+    }
+
+    pub fn with_batch_size(mut self, batch_size: usize) -> Self {
+        self.batch_size = batch_size.max(1);
+        self
     }
     
     pub fn execute(&self, plan: &QueryPlan) -> Result<QueryResult, MantisError> {
@@ -31,7 +50,7 @@ impl QueryExecutor {
                 self.execute_hash_join(left, right, condition)
             }
             PlanNode::Sort { input, order_by } => {
-                self.execute_sort(input, order_by)
+                self.execute_sort(input, order_by, None)
             }
             PlanNode::Limit { input, limit, offset } => {
                 self.execute_limit(input, *limit, *offset)
@@ -39,31 +58,81 @@ impl QueryExecutor {
         }
     }
     
+    /// Scan `table` batch by batch, keeping only the rows `filter` selects.
+    /// When the filter pins a column to literal values and the source can
+    /// look those up directly, only the matching rows are read.
+    pub fn scan_batches(
+        &self,
+        table: &str,
+        filter: Option<&super::ast::Expression>,
+    ) -> Result<(Vec<String>, Vec<ColumnBatch>), MantisError> {
+        let source = self.source.as_ref().ok_or_else(|| {
+            MantisError::ExecutorError("no storage attached to executor".to_string())
+        })?;
+        let looked_up = filter.and_then(|f| {
+            point_lookups(f)
+                .into_iter()
+                .find_map(|(column, values)| source.lookup(table, column, &values, self.batch_size))
+        });
+        let (columns, batches) = match looked_up {
+            Some(result) => {
+                let (columns, batches) = result?;
+                // No rows: the lookup's column layout may lack filter columns
+                if batches.is_empty() {
+                    return Ok((columns.to_vec(), batches));
+                }
+                (columns, batches)
+            }
+            None => source.scan(table, self.batch_size)?,
+        };
+        let predicate = match filter {
+            Some(expr) => Some(vectorized::compile(expr, &columns)?),
+            None => None,
+        };
+
+        let mut out = Vec::with_capacity(batches.len());
+        for batch in batches {
+            match &predicate {
+                Some(predicate) => {
+                    let selection = predicate.select(&batch);
+                    if selection.len() == batch.num_rows() {
+                        out.push(batch);
+                    } else if !selection.is_empty() {
+                        out.push(batch.take(&selection));
+                    }
+                }
+                None => out.push(batch),
+            }
+        }
+        Ok((columns.to_vec(), out))
+    }
+
     fn execute_table_scan(
         &self,
-        _table: &str,
-        _filter: Option<&super::ast::Expression>,
+        table: &str,
+        filter: Option<&super::ast::Expression>,
     ) -> Result<QueryResult, MantisError> {
-        // TODO: Implement table scan
+        let (columns, batches) = self.scan_batches(table, filter)?;
+        let mut rows = Vec::new();
+        for batch in &batches {
+            batch.append_rows(&mut rows);
+        }
         Ok(QueryResult {
-            columns: vec!["id".to_string(), "name".to_string()],
-            rows: vec![],
+            columns,
+            rows,
             rows_affected: 0,
         })
     }
     
     fn execute_index_scan(
         &self,
-        _table: &str,
+        table: &str,
         _index: &str,
-        _filter: Option<&super::ast::Expression>,
+        filter: Option<&super::ast::Expression>,
     ) -> Result<QueryResult, MantisError> {
-        // TODO: Implement index scan
-        Ok(QueryResult {
-            columns: vec![],
-            rows: vec![],
-            rows_affected: 0,
-        })
+        // No secondary indexes behind BatchSource yet; a filtered scan gives
+        // the same rows.
+        self.execute_table_scan(table, filter)
     }
     
     fn execute_nested_loop_join(
@@ -77,8 +146,9 @@ impl QueryExecutor {
         let right_result = self.execute_node(right)?;
         
         // Combine column names
-        let mut columns = left_result.columns.clone();
-        columns.extend(right_result.columns.clone());
+        let mut columns = join_columns(left, &left_result);
+        columns.extend(join_columns(right, &right_result));
+        let predicate = vectorized::compile(condition, &columns)?;
         
         let mut joined_rows = Vec::new();
         
@@ -90,7 +160,7 @@ impl QueryExecutor {
                 combined_row.extend(right_row.clone());
                 
                 // Evaluate join condition
-                if self.evaluate_join_condition(condition, &combined_row, &columns)? {
+                if self.evaluate_join_condition(&predicate, &combined_row) {
                     joined_rows.push(combined_row);
                 }
             }
@@ -110,61 +180,130 @@ impl QueryExecutor {
         condition: &super::ast::Expression,
     ) -> Result<QueryResult, MantisError> {
         use std::collections::HashMap;
-        
-        // Execute left and right sides
+
         let left_result = self.execute_node(left)?;
         let right_result = self.execute_node(right)?;
-        
-        // Combine column names
-        let mut columns = left_result.columns.clone();
-        columns.extend(right_result.columns.clone());
-        
-        // Build phase: create hash table from smaller table (left)
-        let mut hash_table: HashMap<String, Vec<Vec<SqlValue>>> = HashMap::new();
-        
-        for row in &left_result.rows {
-            // Use first column as hash key (simplified)
-            if let Some(key_value) = row.first() {
-                let key = format!("{:?}", key_value);
-                hash_table.entry(key).or_insert_with(Vec::new).push(row.clone());
+
+        let left_columns = join_columns(left, &left_result);
+        let right_columns = join_columns(right, &right_result);
+        let mut columns = left_columns.clone();
+        columns.extend(right_columns.iter().cloned());
+        let predicate = vectorized::compile(condition, &columns)?;
+
+        // Equality conjuncts become the hash key; with none the join is keyed
+        // on the empty tuple and degenerates into a nested loop.
+        let mut left_keys = Vec::new();
+        let mut right_keys = Vec::new();
+        let mut residual = false;
+        for conjunct in split_conjuncts(condition) {
+            match equi_join_key(conjunct, &left_columns, &right_columns) {
+                Some((l, r)) => {
+                    left_keys.push(l);
+                    right_keys.push(r);
+                }
+                None => residual = true,
             }
         }
-        
-        // Probe phase: match right table rows
+
+        // Build on whichever input turned out smaller.
+        let build_left = left_result.rows.len() <= right_result.rows.len();
+        let (build_rows, build_keys, probe_rows, probe_keys) = if build_left {
+            (&left_result.rows, &left_keys, &right_result.rows, &right_keys)
+        } else {
+            (&right_result.rows, &right_keys, &left_result.rows, &left_keys)
+        };
+
+        let mut table: HashMap<Vec<JoinKey>, Vec<usize>> = HashMap::with_capacity(build_rows.len());
+        for (i, row) in build_rows.iter().enumerate() {
+            if let Some(key) = join_key(build_keys, row) {
+                table.entry(key).or_default().push(i);
+            }
+        }
+
         let mut joined_rows = Vec::new();
-        
-        for right_row in &right_result.rows {
-            if let Some(key_value) = right_row.first() {
-                let key = format!("{:?}", key_value);
-                
-                if let Some(matching_left_rows) = hash_table.get(&key) {
-                    for left_row in matching_left_rows {
-                        let mut combined_row = left_row.clone();
-                        combined_row.extend(right_row.clone());
-                        
-                        // Evaluate join condition
-                        if self.evaluate_join_condition(condition, &combined_row, &columns)? {
-                            joined_rows.push(combined_row);
-                        }
-                    }
+        for probe_row in probe_rows {
+            let matches = match join_key(probe_keys, probe_row).and_then(|key| table.get(&key)) {
+                Some(matches) => matches,
+                None => continue,
+            };
+            for &i in matches {
+                let build_row = &build_rows[i];
+                let (l, r) = if build_left {
+                    (build_row, probe_row)
+                } else {
+                    (probe_row, build_row)
+                };
+                let mut combined_row = Vec::with_capacity(l.len() + r.len());
+                combined_row.extend_from_slice(l);
+                combined_row.extend_from_slice(r);
+                if !residual || self.evaluate_join_condition(&predicate, &combined_row) {
+                    joined_rows.push(combined_row);
                 }
             }
         }
-        
+
         Ok(QueryResult {
             columns,
             rows: joined_rows,
             rows_affected: 0,
         })
     }
-    
+
     fn execute_sort(
         &self,
         input: &PlanNode,
-        _order_by: &[super::ast::OrderByItem],
+        order_by: &[super::ast::OrderByItem],
+        top_k: Option<usize>,
     ) -> Result<QueryResult, MantisError> {
-        let result = self.execute_node(input)?;
-        // TODO: Implement sorting
+        let mut result = self.execute_node(input)?;
+        if order_by.is_empty() || result.rows.len() < 2 {
+            return Ok(result);
+        }
+
+        // Evaluate each sort key once into a typed vector, then sort a
+        // permutation instead of comparing boxed values.
+        let batch = ColumnBatch::from_rows(Arc::new(result.columns.clone()), &result.rows)?;
+        let keys = order_by
+            .iter()
+            .map(|item| {
+                let expr = vectorized::compile(&item.expr, &result.columns)?;
+                Ok((expr.evaluate(&batch), item.ascending))
+            })
+            .collect::<Result<Vec<_>, MantisError>>()?;
+
+        let compare = |a: &usize, b: &usize| {
+            for (key, ascending) in &keys {
+                // NULLs sort last ascending and first descending, as in PostgreSQL
+                let ord = key.compare_rows(*a, *b);
+                if ord != std::cmp::Ordering::Equal {
+                    return if *ascending { ord } else { ord.reverse() };
+                }
+            }
+            // Input position breaks ties, keeping the unstable sorts stable
+            a.cmp(b)
+        };
+
+        let mut order: Vec<usize> = (0..result.rows.len()).collect();
+        match top_k {
+            // Under a LIMIT only the first k rows matter: partition them to
+            // the front in linear time and sort just those.
+            Some(k) if k < order.len() => {
+                if k == 0 {
+                    order.clear();
+                } else {
+                    order.select_nth_unstable_by(k - 1, compare);
+                    order.truncate(k);
+                }
+                order.sort_unstable_by(compare);
+            }
+            _ => order.sort_unstable_by(compare),
+        }
+
+        let mut rows: Vec<Option<Vec<SqlValue>>> = result.rows.drain(..).map(Some).collect();
+        result.rows = order
+            .into_iter()
+            .filter_map(|i| rows[i].take())
+            .collect();
         Ok(result)
     }
     
@@ -174,37 +313,357 @@ impl QueryExecutor {
         limit: u64,
         offset: u64,
     ) -> Result<QueryResult, MantisError> {
-        let mut result = self.execute_node(input)?;
-        
         let start = offset as usize;
-        let end = (offset + limit) as usize;
-        
+        let end = offset.saturating_add(limit) as usize;
+        let mut result = match input {
+            PlanNode::Sort { input, order_by } => self.execute_sort(input, order_by, Some(end))?,
+            _ => self.execute_node(input)?,
+        };
+
+        result.rows.truncate(end);
         if start < result.rows.len() {
-            result.rows = result.rows[start..end.min(result.rows.len())].to_vec();
+            result.rows.drain(..start);
         } else {
             result.rows.clear();
         }
-        
+
         Ok(result)
     }
+
+    /// Evaluate join condition on a combined row; NULL counts as no match
+    fn evaluate_join_condition(&self, predicate: &CompiledExpr, row: &[SqlValue]) -> bool {
+        predicate.matches_row(row)
+    }
 }
 
-    /// Evaluate join condition on a combined row
-    fn evaluate_join_condition(
-        &self,
-        _condition: &super::ast::Expression,
-        _row: &[SqlValue],
-        _columns: &[String],
-    ) -> Result<bool, MantisError> {
-        // Simplified: always return true
-        // In production, this would evaluate the expression against the row
-        // TODO: Implement full expression evaluation with column lookups
-        Ok(true)
+/// Output columns of a join input, qualified with the table name when the
+/// input is a scan so that `a.id = b.id` binds to the right side.
+fn join_columns(node: &PlanNode, result: &QueryResult) -> Vec<String> {
+    match node {
+        PlanNode::TableScan { table, .. } | PlanNode::IndexScan { table, .. } => result
+            .columns
+            .iter()
+            .map(|c| format!("{}.{}", table, c))
+            .collect(),
+        _ => result.columns.clone(),
     }
 }
 
+/// Hashable form of a join key value. Values that compare equal in SQL map
+/// to the same key, so integer widths collapse and integral floats become
+/// integers.
+#[derive(Debug, Clone, PartialEq, Eq, Hash)]
+enum JoinKey {
+    Int(i64),
+    Float(u64),
+    Str(String),
+    Bytes(Vec<u8>),
+    Bool(bool),
+}
+
+impl JoinKey {
+    /// None for NULL, which never joins
+    fn from_value(value: &SqlValue) -> Option<Self> {
+        Some(match value {
+            SqlValue::Null => return None,
+            SqlValue::Integer(i) => JoinKey::Int(*i as i64),
+            SqlValue::BigInt(i) => JoinKey::Int(*i),
+            SqlValue::SmallInt(i) => JoinKey::Int(*i as i64),
+            SqlValue::Date(d) => JoinKey::Int(*d as i64),
+            SqlValue::Time(t) | SqlValue::Timestamp(t) => JoinKey::Int(*t),
+            SqlValue::Real(f) => JoinKey::from_float(*f as f64),
+            SqlValue::Double(f) => JoinKey::from_float(*f),
+            SqlValue::Decimal(d) => match d.parse::<f64>() {
+                Ok(f) => JoinKey::from_float(f),
+                Err(_) => JoinKey::Str(d.clone()),
+            },
+            SqlValue::Char(s) | SqlValue::Varchar(s) | SqlValue::Text(s) => JoinKey::Str(s.clone()),
+            SqlValue::Binary(b) | SqlValue::Blob(b) | SqlValue::Jsonb(b) => JoinKey::Bytes(b.clone()),
+            SqlValue::Boolean(b) => JoinKey::Bool(*b),
+            SqlValue::Json(j) => JoinKey::Str(j.to_string()),
+            SqlValue::Array(_) => JoinKey::Str(format!("{:?}", value)),
+        })
+    }
+
+    fn from_float(f: f64) -> Self {
+        if f.fract() == 0.0 && f >= i64::MIN as f64 && f < i64::MAX as f64 {
+            JoinKey::Int(f as i64)
+        } else {
+            JoinKey::Float(f.to_bits())
+        }
+    }
+}
+
+/// Evaluate the key expressions for `row`; None if any part is NULL
+fn join_key(keys: &[CompiledExpr], row: &[SqlValue]) -> Option<Vec<JoinKey>> {
+    keys.iter()
+        .map(|key| JoinKey::from_value(&key.eval_row(row)))
+        .collect()
+}
+
+fn split_conjuncts(expr: &super::ast::Expression) -> Vec<&super::ast::Expression> {
+    use super::ast::{BinaryOperator, Expression};
+    match expr {
+        Expression::BinaryOp {
+            left,
+            op: BinaryOperator::And,
+            right,
+        } => {
+            let mut out = split_conjuncts(left);
+            out.extend(split_conjuncts(right));
+            out
+        }
+        _ => vec![expr],
+    }
+}
+
+/// Conjuncts of `filter` that pin a column to literals, as `column = v` or
+/// `column IN (v, ...)`, in the order they appear
+fn point_lookups(filter: &super::ast::Expression) -> Vec<(&str, Vec<SqlValue>)> {
+    use super::ast::{BinaryOperator, Expression};
+    let mut out = Vec::new();
+    for conjunct in split_conjuncts(filter) {
+        match conjunct {
+            Expression::BinaryOp {
+                left,
+                op: BinaryOperator::Equal,
+                right,
+            } => match (left.as_ref(), right.as_ref()) {
+                (Expression::Identifier(column), Expression::Literal(v))
+                | (Expression::Literal(v), Expression::Identifier(column)) => {
+                    out.push((column.as_str(), vec![v.clone()]));
+                }
+                _ => {}
+            },
+            Expression::InList {
+                expr,
+                list,
+                negated: false,
+            } => {
+                if let Expression::Identifier(column) = expr.as_ref() {
+                    let values: Option<Vec<SqlValue>> = list
+                        .iter()
+                        .map(|e| match e {
+                            Expression::Literal(v) => Some(v.clone()),
+                            _ => None,
+                        })
+                        .collect();
+                    if let Some(values) = values {
+                        out.push((column.as_str(), values));
+                    }
+                }
+            }
+            _ => {}
+        }
+    }
+    out
+}
+
+/// Recognise `x = y` where one operand binds only to the left input and the
+/// other only to the right, returning them compiled as (left key, right key).
+fn equi_join_key(
+    expr: &super::ast::Expression,
+    left_columns: &[String],
+    right_columns: &[String],
+) -> Option<(CompiledExpr, CompiledExpr)> {
+    use super::ast::{BinaryOperator, Expression};
+    let (a, b) = match expr {
+        Expression::BinaryOp {
+            left,
+            op: BinaryOperator::Equal,
+            right,
+        } => (left.as_ref(), right.as_ref()),
+        _ => return None,
+    };
+    let only = |e: &Expression, columns: &[String], other: &[String]| {
+        if vectorized::compile(e, other).is_ok() {
+            return None;
+        }
+        vectorized::compile(e, columns).ok()
+    };
+    if let (Some(l), Some(r)) = (only(a, left_columns, right_columns), only(b, right_columns, left_columns)) {
+        return Some((l, r));
+    }
+    if let (Some(l), Some(r)) = (only(b, left_columns, right_columns), only(a, right_columns, left_columns)) {
+        return Some((l, r));
+    }
+    None
+}
+
 impl Default for QueryExecutor {
     fn default() -> Self {
         Self::new()
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::columnar_engine::{ColumnStore, ColumnType, ColumnValue};
+    use crate::sql::ast::{BinaryOperator, Expression, OrderByItem};
+    use crate::sql::vectorized::ColumnStoreSource;
+    use std::collections::HashMap;
+
+    fn executor() -> QueryExecutor {
+        let store = Arc::new(ColumnStore::new());
+        for (table, offset) in [("a", 0i64), ("b", 2)] {
+            store.create_table(table.to_string()).unwrap();
+            store
+                .get_table_mut(table, |t| {
+                    t.add_column("id".to_string(), ColumnType::Int64);
+                    t.add_column("name".to_string(), ColumnType::String);
+                    for i in 0..5i64 {
+                        let mut row = HashMap::new();
+                        row.insert("id".to_string(), ColumnValue::Int64(Some(i + offset)));
+                        row.insert("name".to_string(), ColumnValue::String(Some(format!("{}{}", table, i))));
+                        t.append_row(row).unwrap();
+                    }
+                })
+                .unwrap();
+        }
+        QueryExecutor::with_source(Arc::new(ColumnStoreSource::new(store))).with_batch_size(2)
+    }
+
+    #[test]
+    fn test_scan_filter_sort_limit() {
+        let plan = QueryPlan {
+            root: PlanNode::Limit {
+                input: Box::new(PlanNode::Sort {
+                    input: Box::new(PlanNode::TableScan {
+                        table: "a".to_string(),
+                        filter: Some(Expression::BinaryOp {
+                            left: Box::new(Expression::Identifier("id".to_string())),
+                            op: BinaryOperator::GreaterEqual,
+                            right: Box::new(Expression::Literal(SqlValue::Integer(1))),
+                        }),
+                    }),
+                    order_by: vec![OrderByItem {
+                        expr: Expression::Identifier("id".to_string()),
+                        ascending: false,
+                    }],
+                }),
+                limit: 2,
+                offset: 0,
+            },
+            estimated_cost: 0.0,
+            estimated_rows: 0,
+        };
+
+        let result = executor().execute(&plan).unwrap();
+        assert_eq!(result.columns, vec!["id".to_string(), "name".to_string()]);
+        let ids: Vec<SqlValue> = result.rows.iter().map(|r| r[0].clone()).collect();
+        assert_eq!(ids, vec![SqlValue::BigInt(4), SqlValue::BigInt(3)]);
+    }
+
+    #[test]
+    fn test_join_condition_is_evaluated() {
+        let scan = |table: &str| {
+            Box::new(PlanNode::TableScan {
+                table: table.to_string(),
+                filter: None,
+            })
+        };
+        let plan = QueryPlan {
+            root: PlanNode::NestedLoopJoin {
+                left: scan("a"),
+                right: scan("b"),
+                condition: Expression::BinaryOp {
+                    left: Box::new(Expression::QualifiedIdentifier {
+                        table: "a".to_string(),
+                        column: "id".to_string(),
+                    }),
+                    op: BinaryOperator::Equal,
+                    right: Box::new(Expression::QualifiedIdentifier {
+                        table: "b".to_string(),
+                        column: "id".to_string(),
+                    }),
+                },
+            },
+            estimated_cost: 0.0,
+            estimated_rows: 0,
+        };
+
+        let result = executor().execute(&plan).unwrap();
+        // a.id in 0..5 and b.id in 2..7 overlap on 2, 3, 4
+        assert_eq!(result.rows.len(), 3);
+        assert_eq!(result.columns[0], "a.id");
+        assert!(result.rows.iter().all(|r| r[0] == r[2]));
+    }
+
+    #[test]
+    fn test_hash_join_typed_keys_and_residual() {
+        let scan = |table: &str| {
+            Box::new(PlanNode::TableScan {
+                table: table.to_string(),
+                filter: None,
+            })
+        };
+        let column = |table: &str, column: &str| {
+            Box::new(Expression::QualifiedIdentifier {
+                table: table.to_string(),
+                column: column.to_string(),
+            })
+        };
+        // a.id = b.id AND b.id > 2: the equality is hashed, the range is residual
+        let plan = QueryPlan {
+            root: PlanNode::HashJoin {
+                left: scan("a"),
+                right: scan("b"),
+                condition: Expression::BinaryOp {
+                    left: Box::new(Expression::BinaryOp {
+                        left: column("b", "id"),
+                        op: BinaryOperator::Equal,
+                        right: column("a", "id"),
+                    }),
+                    op: BinaryOperator::And,
+                    right: Box::new(Expression::BinaryOp {
+                        left: column("b", "id"),
+                        op: BinaryOperator::Greater,
+                        right: Box::new(Expression::Literal(SqlValue::Integer(2))),
+                    }),
+                },
+            },
+            estimated_cost: 0.0,
+            estimated_rows: 0,
+        };
+
+        let result = executor().execute(&plan).unwrap();
+        let mut ids: Vec<SqlValue> = result.rows.iter().map(|r| r[0].clone()).collect();
+        ids.sort_by(|a, b| vectorized::compare_values(a, b).unwrap());
+        assert_eq!(ids, vec![SqlValue::BigInt(3), SqlValue::BigInt(4)]);
+        assert!(result.rows.iter().all(|r| r[0] == r[2]));
+
+        assert_eq!(JoinKey::from_value(&SqlValue::Double(3.0)), JoinKey::from_value(&SqlValue::Integer(3)));
+        assert_eq!(JoinKey::from_value(&SqlValue::Null), None);
+    }
+
+    #[test]
+    fn test_top_k_matches_full_sort() {
+        let sort = || PlanNode::Sort {
+            input: Box::new(PlanNode::TableScan {
+                table: "b".to_string(),
+                filter: None,
+            }),
+            order_by: vec![OrderByItem {
+                expr: Expression::Identifier("name".to_string()),
+                ascending: false,
+            }],
+        };
+        let plan = |root| QueryPlan {
+            root,
+            estimated_cost: 0.0,
+            estimated_rows: 0,
+        };
+
+        let full = executor().execute(&plan(sort())).unwrap();
+        let top = executor()
+            .execute(&plan(PlanNode::Limit {
+                input: Box::new(sort()),
+                limit: 3,
+                offset: 1,
+            }))
+            .unwrap();
+        assert_eq!(top.rows, full.rows[1..4].to_vec());
+        assert_eq!(top.rows[0][1], SqlValue::Text("b3".to_string()));
+    }
+}
@@ -7,6 +7,7 @@ pub mod lexer;
 pub mod optimizer;
 pub mod parser;
 pub mod types;
+pub mod vectorized;
 
 pub use ast::*;
 pub use executor::*;
@@ -14,3 +15,4 @@ pub use lexer::*;
 pub use optimizer::*;
 pub use parser::*;
 pub use types::*;
+pub use vectorized::{BatchSource, ColumnBatch, ColumnStoreSource, ColumnVector, KvTableSource};
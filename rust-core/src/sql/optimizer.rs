@@ -1,17 +1,51 @@
 // Query Optimizer - Cost-based optimization
 use super::ast::*;
+use super::types::SqlValue;
+use super::vectorized::{as_f64, compare_values, BatchSource};
 use crate::error::MantisError;
+use std::cmp::Ordering;
+use std::collections::hash_map::DefaultHasher;
+use std::collections::HashMap;
+use std::hash::{Hash, Hasher};
+
+/// Rows kept by the ANALYZE reservoir when the caller does not choose
+pub const DEFAULT_SAMPLE_SIZE: usize = 30_000;
+
+/// Histogram buckets and most-common values kept per column
+const STATISTICS_TARGET: usize = 100;
+
+/// Selectivity assumed when statistics cannot answer
+const DEFAULT_SELECTIVITY: f64 = 0.1;
+
+/// Estimates used for tables that have not been analyzed
+const DEFAULT_ROWS: u64 = 1000;
+const DEFAULT_COST: f64 = 100.0;
+
+/// Cost units charged per row scanned and per row sorted
+const CPU_TUPLE_COST: f64 = 0.01;
+const CPU_OPERATOR_COST: f64 = 0.0025;
 
 pub struct QueryOptimizer {
     // Statistics for cost estimation
-    table_stats: std::collections::HashMap<String, TableStatistics>,
+    table_stats: HashMap<String, TableStatistics>,
 }
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Default)]
 pub struct TableStatistics {
     pub row_count: u64,
     pub avg_row_size: u64,
     pub index_count: usize,
+    pub columns: HashMap<String, ColumnStatistics>,
+}
+
+#[derive(Debug, Clone, Default)]
+pub struct ColumnStatistics {
+    pub null_fraction: f64,
+    pub n_distinct: f64,
+    /// Most common values with the fraction of all rows holding each
+    pub most_common: Vec<(SqlValue, f64)>,
+    /// Equi-depth bucket bounds over the values that are not most common
+    pub histogram: Vec<SqlValue>,
 }
 
 #[derive(Debug, Clone)]
@@ -56,42 +90,120 @@ pub enum PlanNode {
 impl QueryOptimizer {
     pub fn new() -> Self {
         QueryOptimizer {
-            table_stats: std::collections::HashMap::new(),
+            table_stats: HashMap::new(),
         }
     }
-    
+
+    /// Install statistics gathered elsewhere, such as by the Go ANALYZE
+    pub fn set_table_stats(&mut self, table: &str, stats: TableStatistics) {
+        self.table_stats.insert(table.to_string(), stats);
+    }
+
+    pub fn table_stats(&self, table: &str) -> Option<&TableStatistics> {
+        self.table_stats.get(table)
+    }
+
+    /// Gather statistics for `table` from one pass over `source`. Row and
+    /// null counts and distinct estimates cover every row; most-common
+    /// values and histograms come from a reservoir of `sample_size` rows.
+    pub fn analyze(
+        &mut self,
+        table: &str,
+        source: &dyn BatchSource,
+        sample_size: usize,
+    ) -> Result<&TableStatistics, MantisError> {
+        let (columns, batches) = source.scan(table, 4096)?;
+        let mut accs: Vec<ColumnAccumulator> = columns.iter().map(|_| ColumnAccumulator::new()).collect();
+        let mut sample: Vec<Vec<SqlValue>> = Vec::with_capacity(sample_size.min(1 << 16));
+        let mut rows: u64 = 0;
+
+        for batch in &batches {
+            for row in 0..batch.num_rows() {
+                let values: Vec<SqlValue> = (0..columns.len()).map(|c| batch.column(c).value(row)).collect();
+                for (acc, value) in accs.iter_mut().zip(&values) {
+                    acc.add(value);
+                }
+                // Algorithm R: row n replaces a sampled row with probability k/n
+                rows += 1;
+                if sample.len() < sample_size {
+                    sample.push(values);
+                } else if sample_size > 0 {
+                    let slot = (rand::random::<f64>() * rows as f64) as u64;
+                    if (slot as usize) < sample_size {
+                        sample[slot as usize] = values;
+                    }
+                }
+            }
+        }
+
+        let mut stats = TableStatistics {
+            row_count: rows,
+            index_count: self.table_stats.get(table).map_or(0, |s| s.index_count),
+            ..TableStatistics::default()
+        };
+        let mut row_width = 0.0;
+        for (c, name) in columns.iter().enumerate() {
+            let acc = &accs[c];
+            row_width += acc.avg_width(rows);
+            stats
+                .columns
+                .insert(name.clone(), acc.finish(c, &sample, rows));
+        }
+        stats.avg_row_size = row_width.round() as u64;
+        self.table_stats.insert(table.to_string(), stats);
+        Ok(&self.table_stats[table])
+    }
+
     pub fn optimize(&self, stmt: &SelectStatement) -> Result<QueryPlan, MantisError> {
-        // TODO: Implement cost-based optimization
-        // For now, create a simple plan
-        
         let table_name = stmt.from.as_ref()
             .ok_or_else(|| MantisError::OptimizerError("No FROM clause".to_string()))?
             .name.clone();
-        
+
+        // Without statistics the estimates stay at their historical defaults
+        let (mut rows, mut cost) = match self.table_stats.get(&table_name) {
+            Some(stats) => {
+                let selectivity = stmt
+                    .where_clause
+                    .as_ref()
+                    .map_or(1.0, |w| clause_selectivity(w, stats));
+                let scanned = stats.row_count as f64;
+                let mut cost = scanned * CPU_TUPLE_COST;
+                if stmt.where_clause.is_some() {
+                    cost += scanned * CPU_OPERATOR_COST;
+                }
+                ((scanned * selectivity).ceil() as u64, cost)
+            }
+            None => (DEFAULT_ROWS, DEFAULT_COST),
+        };
+
         let mut plan = PlanNode::TableScan {
             table: table_name,
             filter: stmt.where_clause.clone(),
         };
-        
+
         if !stmt.order_by.is_empty() {
+            let n = rows.max(2) as f64;
+            cost += CPU_OPERATOR_COST * n * n.log2();
             plan = PlanNode::Sort {
                 input: Box::new(plan),
                 order_by: stmt.order_by.clone(),
             };
         }
-        
+
         if let Some(limit) = stmt.limit {
+            let offset = stmt.offset.unwrap_or(0);
+            rows = rows.saturating_sub(offset).min(limit);
             plan = PlanNode::Limit {
                 input: Box::new(plan),
                 limit,
-                offset: stmt.offset.unwrap_or(0),
+                offset,
             };
         }
-        
+
         Ok(QueryPlan {
             root: plan,
-            estimated_cost: 100.0,
-            estimated_rows: 1000,
+            estimated_cost: cost,
+            estimated_rows: rows,
         })
     }
 }
@@ -101,3 +213,401 @@ impl Default for QueryOptimizer {
         Self::new()
     }
 }
+
+/// Per-column counters kept over the full ANALYZE pass
+struct ColumnAccumulator {
+    nulls: u64,
+    width: u64,
+    distinct: HyperLogLog,
+}
+
+impl ColumnAccumulator {
+    fn new() -> Self {
+        ColumnAccumulator {
+            nulls: 0,
+            width: 0,
+            distinct: HyperLogLog::new(),
+        }
+    }
+
+    fn add(&mut self, value: &SqlValue) {
+        if matches!(value, SqlValue::Null) {
+            self.nulls += 1;
+            return;
+        }
+        self.width += value_width(value);
+        self.distinct.add(hash_value(value));
+    }
+
+    fn avg_width(&self, rows: u64) -> f64 {
+        let non_null = rows - self.nulls;
+        if non_null == 0 {
+            0.0
+        } else {
+            self.width as f64 / non_null as f64
+        }
+    }
+
+    fn finish(&self, column: usize, sample: &[Vec<SqlValue>], rows: u64) -> ColumnStatistics {
+        let mut stats = ColumnStatistics::default();
+        if rows == 0 {
+            return stats;
+        }
+        let non_null = rows - self.nulls;
+        stats.null_fraction = self.nulls as f64 / rows as f64;
+        stats.n_distinct = self.distinct.estimate().min(non_null as f64);
+
+        let mut values: Vec<&SqlValue> = sample
+            .iter()
+            .map(|row| &row[column])
+            .filter(|v| !matches!(v, SqlValue::Null))
+            .collect();
+        if values.is_empty() {
+            return stats;
+        }
+        values.sort_by(|a, b| stats_compare(a, b));
+
+        // Runs of equal values; long runs become most-common values
+        let mut runs: Vec<(usize, usize)> = Vec::new();
+        for (i, v) in values.iter().enumerate() {
+            match runs.last_mut() {
+                Some((start, end)) if stats_compare(values[*start], v) == Ordering::Equal => *end = i + 1,
+                _ => runs.push((i, i + 1)),
+            }
+        }
+        let sample_rows = sample.len() as f64;
+        let avg = values.len() as f64 / runs.len() as f64;
+        let mut common: Vec<(usize, usize)> = runs
+            .iter()
+            .copied()
+            .filter(|(s, e)| e - s >= 2 && (e - s) as f64 > 1.25 * avg)
+            .collect();
+        common.sort_by(|a, b| (b.1 - b.0).cmp(&(a.1 - a.0)));
+        common.truncate(STATISTICS_TARGET);
+        for &(s, e) in &common {
+            stats.most_common.push((values[s].clone(), (e - s) as f64 / sample_rows));
+        }
+
+        let rest: Vec<&SqlValue> = runs
+            .iter()
+            .filter(|run| !common.contains(run))
+            .flat_map(|&(s, e)| values[s..e].iter().copied())
+            .collect();
+        let rest_runs = runs.len() - common.len();
+        if rest_runs >= 2 {
+            let buckets = STATISTICS_TARGET.min(rest_runs - 1);
+            for i in 0..=buckets {
+                stats.histogram.push(rest[i * (rest.len() - 1) / buckets].clone());
+            }
+        }
+        stats
+    }
+}
+
+/// Fraction of a table's rows satisfying `expr`
+fn clause_selectivity(expr: &Expression, stats: &TableStatistics) -> f64 {
+    let s = match expr {
+        Expression::BinaryOp { left, op: BinaryOperator::And, right } => {
+            clause_selectivity(left, stats) * clause_selectivity(right, stats)
+        }
+        Expression::BinaryOp { left, op: BinaryOperator::Or, right } => {
+            let (l, r) = (clause_selectivity(left, stats), clause_selectivity(right, stats));
+            l + r - l * r
+        }
+        Expression::UnaryOp { op: UnaryOperator::Not, expr } => 1.0 - clause_selectivity(expr, stats),
+        Expression::BinaryOp { left, op, right } => match (column_stats(left, stats), right.as_ref()) {
+            (Some(col), Expression::Literal(v)) => comparison_selectivity(col, op, v),
+            _ => match (column_stats(right, stats), left.as_ref()) {
+                (Some(col), Expression::Literal(v)) => comparison_selectivity(col, &commute(op), v),
+                _ => DEFAULT_SELECTIVITY,
+            },
+        },
+        Expression::IsNull { expr, negated } => match column_stats(expr, stats) {
+            Some(col) if *negated => 1.0 - col.null_fraction,
+            Some(col) => col.null_fraction,
+            None => DEFAULT_SELECTIVITY,
+        },
+        Expression::InList { expr, list, negated } => match column_stats(expr, stats) {
+            Some(col) => {
+                let s: f64 = list
+                    .iter()
+                    .map(|e| match e {
+                        Expression::Literal(v) => equality_selectivity(col, v),
+                        _ => DEFAULT_SELECTIVITY,
+                    })
+                    .sum::<f64>()
+                    .min(1.0 - col.null_fraction);
+                if *negated {
+                    1.0 - col.null_fraction - s
+                } else {
+                    s
+                }
+            }
+            None => DEFAULT_SELECTIVITY,
+        },
+        Expression::Between { expr, low, high, negated } => {
+            match (column_stats(expr, stats), low.as_ref(), high.as_ref()) {
+                (Some(col), Expression::Literal(lo), Expression::Literal(hi)) => {
+                    let s = (comparison_selectivity(col, &BinaryOperator::LessEqual, hi)
+                        - comparison_selectivity(col, &BinaryOperator::Less, lo))
+                        .max(0.0);
+                    if *negated {
+                        1.0 - col.null_fraction - s
+                    } else {
+                        s
+                    }
+                }
+                _ => DEFAULT_SELECTIVITY,
+            }
+        }
+        _ => DEFAULT_SELECTIVITY,
+    };
+    s.clamp(0.0, 1.0)
+}
+
+fn column_stats<'a>(expr: &Expression, stats: &'a TableStatistics) -> Option<&'a ColumnStatistics> {
+    match expr {
+        Expression::Identifier(name) => stats.columns.get(name),
+        Expression::QualifiedIdentifier { column, .. } => stats.columns.get(column),
+        _ => None,
+    }
+}
+
+fn comparison_selectivity(col: &ColumnStatistics, op: &BinaryOperator, value: &SqlValue) -> f64 {
+    if matches!(value, SqlValue::Null) {
+        // Comparisons with NULL are never true
+        return 0.0;
+    }
+    match op {
+        BinaryOperator::Equal => equality_selectivity(col, value),
+        BinaryOperator::NotEqual => 1.0 - col.null_fraction - equality_selectivity(col, value),
+        BinaryOperator::Less | BinaryOperator::LessEqual | BinaryOperator::Greater | BinaryOperator::GreaterEqual => {
+            range_selectivity(col, op, value)
+        }
+        _ => DEFAULT_SELECTIVITY,
+    }
+}
+
+fn equality_selectivity(col: &ColumnStatistics, value: &SqlValue) -> f64 {
+    if let Some((_, freq)) = col
+        .most_common
+        .iter()
+        .find(|(v, _)| stats_compare(v, value) == Ordering::Equal)
+    {
+        return *freq;
+    }
+    let others = col.n_distinct - col.most_common.len() as f64;
+    if others < 1.0 {
+        return if col.n_distinct == 0.0 { DEFAULT_SELECTIVITY } else { 0.0 };
+    }
+    remaining_fraction(col) / others
+}
+
+fn range_selectivity(col: &ColumnStatistics, op: &BinaryOperator, value: &SqlValue) -> f64 {
+    let satisfies = |ord: Ordering| match op {
+        BinaryOperator::Less => ord == Ordering::Less,
+        BinaryOperator::LessEqual => ord != Ordering::Greater,
+        BinaryOperator::Greater => ord == Ordering::Greater,
+        _ => ord != Ordering::Less,
+    };
+    let mut s: f64 = col
+        .most_common
+        .iter()
+        .filter(|(v, _)| satisfies(stats_compare(v, value)))
+        .map(|(_, freq)| freq)
+        .sum();
+    if col.histogram.len() >= 2 {
+        let mut below = histogram_fraction(&col.histogram, value);
+        if matches!(op, BinaryOperator::Greater | BinaryOperator::GreaterEqual) {
+            below = 1.0 - below;
+        }
+        s += below * remaining_fraction(col);
+    } else if col.most_common.is_empty() {
+        return 1.0 / 3.0;
+    }
+    s
+}
+
+fn remaining_fraction(col: &ColumnStatistics) -> f64 {
+    let mcv: f64 = col.most_common.iter().map(|(_, f)| f).sum();
+    (1.0 - col.null_fraction - mcv).max(0.0)
+}
+
+/// Fraction of the histogram population below `value`, interpolating
+/// linearly inside a numeric bucket
+fn histogram_fraction(bounds: &[SqlValue], value: &SqlValue) -> f64 {
+    let last = bounds.len() - 1;
+    if stats_compare(value, &bounds[0]) != Ordering::Greater {
+        return 0.0;
+    }
+    if stats_compare(value, &bounds[last]) != Ordering::Less {
+        return 1.0;
+    }
+    // First bound above value; the bucket is the one ending there
+    let hi = bounds.partition_point(|b| stats_compare(b, value) != Ordering::Greater);
+    let lo = hi - 1;
+    let within = match (as_f64(value), as_f64(&bounds[lo]), as_f64(&bounds[hi])) {
+        (Some(v), Some(l), Some(h)) if h > l => (v - l) / (h - l),
+        _ => 0.5,
+    };
+    (lo as f64 + within) / last as f64
+}
+
+fn commute(op: &BinaryOperator) -> BinaryOperator {
+    match op {
+        BinaryOperator::Less => BinaryOperator::Greater,
+        BinaryOperator::LessEqual => BinaryOperator::GreaterEqual,
+        BinaryOperator::Greater => BinaryOperator::Less,
+        BinaryOperator::GreaterEqual => BinaryOperator::LessEqual,
+        other => other.clone(),
+    }
+}
+
+/// Total order for sorting samples; incomparable values fall back to
+/// their debug form so sorting stays consistent
+fn stats_compare(a: &SqlValue, b: &SqlValue) -> Ordering {
+    compare_values(a, b).unwrap_or_else(|| format!("{:?}", a).cmp(&format!("{:?}", b)))
+}
+
+/// Hash that agrees for equal values of different integer widths
+fn hash_value(value: &SqlValue) -> u64 {
+    let mut h = DefaultHasher::new();
+    match value {
+        SqlValue::Integer(v) => (*v as i64).hash(&mut h),
+        SqlValue::BigInt(v) => v.hash(&mut h),
+        SqlValue::SmallInt(v) => (*v as i64).hash(&mut h),
+        SqlValue::Real(v) => (*v as f64).to_bits().hash(&mut h),
+        SqlValue::Double(v) => v.to_bits().hash(&mut h),
+        SqlValue::Char(s) | SqlValue::Varchar(s) | SqlValue::Text(s) => s.hash(&mut h),
+        other => format!("{:?}", other).hash(&mut h),
+    }
+    h.finish()
+}
+
+fn value_width(value: &SqlValue) -> u64 {
+    match value {
+        SqlValue::SmallInt(_) => 2,
+        SqlValue::Integer(_) | SqlValue::Real(_) | SqlValue::Date(_) => 4,
+        SqlValue::BigInt(_) | SqlValue::Double(_) | SqlValue::Time(_) | SqlValue::Timestamp(_) => 8,
+        SqlValue::Boolean(_) => 1,
+        SqlValue::Char(s) | SqlValue::Varchar(s) | SqlValue::Text(s) | SqlValue::Decimal(s) => s.len() as u64,
+        SqlValue::Binary(b) | SqlValue::Blob(b) | SqlValue::Jsonb(b) => b.len() as u64,
+        other => format!("{}", other).len() as u64,
+    }
+}
+
+/// Distinct-value estimate in fixed memory: 4096 one-byte registers give
+/// about 1.6% standard error
+struct HyperLogLog {
+    registers: Vec<u8>,
+}
+
+const HLL_PRECISION: u32 = 12;
+
+impl HyperLogLog {
+    fn new() -> Self {
+        HyperLogLog {
+            registers: vec![0; 1 << HLL_PRECISION],
+        }
+    }
+
+    fn add(&mut self, hash: u64) {
+        let idx = (hash >> (64 - HLL_PRECISION)) as usize;
+        // The sentinel bit caps the rank when the remaining bits are zero
+        let rank = ((hash << HLL_PRECISION) | (1 << (HLL_PRECISION - 1))).leading_zeros() as u8 + 1;
+        if rank > self.registers[idx] {
+            self.registers[idx] = rank;
+        }
+    }
+
+    fn estimate(&self) -> f64 {
+        let m = self.registers.len() as f64;
+        let sum: f64 = self.registers.iter().map(|&r| 1.0 / (1u64 << r) as f64).sum();
+        let zeros = self.registers.iter().filter(|&&r| r == 0).count();
+        let alpha = 0.7213 / (1.0 + 1.079 / m);
+        let est = alpha * m * m / sum;
+        // Linear counting is more accurate while many registers are empty
+        if est <= 2.5 * m && zeros > 0 {
+            m * (m / zeros as f64).ln()
+        } else {
+            est
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::sql::vectorized::ColumnBatch;
+    use std::sync::Arc;
+
+    struct RowsSource(Vec<Vec<SqlValue>>);
+
+    impl BatchSource for RowsSource {
+        fn scan(&self, _table: &str, _batch_size: usize) -> Result<(Arc<Vec<String>>, Vec<ColumnBatch>), MantisError> {
+            let columns = Arc::new(vec!["id".to_string(), "kind".to_string()]);
+            let batch = ColumnBatch::from_rows(Arc::clone(&columns), &self.0)?;
+            Ok((columns, vec![batch]))
+        }
+    }
+
+    fn select(where_clause: Option<Expression>) -> SelectStatement {
+        SelectStatement {
+            distinct: false,
+            columns: vec![SelectItem::Wildcard],
+            from: Some(TableReference { name: "t".to_string(), alias: None }),
+            joins: vec![],
+            where_clause,
+            group_by: vec![],
+            having: None,
+            order_by: vec![],
+            limit: None,
+            offset: None,
+        }
+    }
+
+    fn cmp(column: &str, op: BinaryOperator, value: SqlValue) -> Expression {
+        Expression::BinaryOp {
+            left: Box::new(Expression::Identifier(column.to_string())),
+            op,
+            right: Box::new(Expression::Literal(value)),
+        }
+    }
+
+    #[test]
+    fn analyze_feeds_row_estimates() {
+        // Unique ids; kind is "a" for 80% of rows, NULL for 10%
+        let rows = (0..10_000i64)
+            .map(|i| {
+                let kind = match i % 10 {
+                    0 => SqlValue::Null,
+                    9 => SqlValue::Text(format!("k{}", i % 1000)),
+                    _ => SqlValue::Text("a".to_string()),
+                };
+                vec![SqlValue::BigInt(i), kind]
+            })
+            .collect();
+        let mut opt = QueryOptimizer::new();
+        assert_eq!(opt.optimize(&select(None)).unwrap().estimated_rows, DEFAULT_ROWS);
+
+        let stats = opt.analyze("t", &RowsSource(rows), 2000).unwrap();
+        assert_eq!(stats.row_count, 10_000);
+        let id = &stats.columns["id"];
+        assert!((id.n_distinct - 10_000.0).abs() < 500.0, "n_distinct {}", id.n_distinct);
+        let kind = &stats.columns["kind"];
+        assert!((kind.null_fraction - 0.1).abs() < 1e-9);
+        assert!(matches!(&kind.most_common[0].0, SqlValue::Text(s) if s == "a"));
+
+        let estimate = |w| opt.optimize(&select(Some(w))).unwrap().estimated_rows as f64;
+        let near = |got: f64, want: f64| (got - want).abs() <= want * 0.15;
+        let got = estimate(cmp("id", BinaryOperator::Less, SqlValue::BigInt(2500)));
+        assert!(near(got, 2500.0), "id < 2500 estimated {}", got);
+        let got = estimate(cmp("kind", BinaryOperator::Equal, SqlValue::Text("a".to_string())));
+        assert!(near(got, 8000.0), "kind = 'a' estimated {}", got);
+        let got = estimate(Expression::IsNull {
+            expr: Box::new(Expression::Identifier("kind".to_string())),
+            negated: false,
+        });
+        assert!(near(got, 1000.0), "kind IS NULL estimated {}", got);
+    }
+}
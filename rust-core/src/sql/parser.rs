@@ -221,6 +221,19 @@ impl Parser {
     fn parse_expression(&mut self) -> Result<Expression, MantisError> {
         self.parse_or_expression()
     }
+
+    /// Parse a standalone expression, such as a policy condition, that must
+    /// make up the whole input
+    pub fn parse_standalone_expression(&mut self) -> Result<Expression, MantisError> {
+        let expr = self.parse_expression()?;
+        match self.current_token() {
+            Token::Eof | Token::Semicolon => Ok(expr),
+            other => Err(MantisError::ParseError(format!(
+                "Unexpected token after expression: {:?}",
+                other
+            ))),
+        }
+    }
     
     fn parse_or_expression(&mut self) -> Result<Expression, MantisError> {
         let mut left = self.parse_and_expression()?;
@@ -239,11 +252,11 @@ impl Parser {
     }
     
     fn parse_and_expression(&mut self) -> Result<Expression, MantisError> {
-        let mut left = self.parse_comparison_expression()?;
+        let mut left = self.parse_not_expression()?;
         
         while self.current_token() == &Token::And {
             self.advance();
-            let right = self.parse_comparison_expression()?;
+            let right = self.parse_not_expression()?;
             left = Expression::BinaryOp {
                 left: Box::new(left),
                 op: BinaryOperator::And,
@@ -254,8 +267,74 @@ impl Parser {
         Ok(left)
     }
     
+    fn parse_not_expression(&mut self) -> Result<Expression, MantisError> {
+        if self.current_token() == &Token::Not {
+            self.advance();
+            let expr = self.parse_not_expression()?;
+            return Ok(Expression::UnaryOp {
+                op: UnaryOperator::Not,
+                expr: Box::new(expr),
+            });
+        }
+        self.parse_comparison_expression()
+    }
+
     fn parse_comparison_expression(&mut self) -> Result<Expression, MantisError> {
         let left = self.parse_additive_expression()?;
+
+        if self.current_token() == &Token::Is {
+            self.advance();
+            let negated = self.current_token() == &Token::Not;
+            if negated {
+                self.advance();
+            }
+            self.expect(Token::Null)?;
+            return Ok(Expression::IsNull {
+                expr: Box::new(left),
+                negated,
+            });
+        }
+
+        let negated = self.current_token() == &Token::Not
+            && matches!(self.peek_token(1), Token::In | Token::Like | Token::Between);
+        if negated {
+            self.advance();
+        }
+        match self.current_token() {
+            Token::In => {
+                self.advance();
+                self.expect(Token::LeftParen)?;
+                let list = self.parse_expression_list()?;
+                self.expect(Token::RightParen)?;
+                return Ok(Expression::InList {
+                    expr: Box::new(left),
+                    list,
+                    negated,
+                });
+            }
+            Token::Like => {
+                self.advance();
+                let pattern = self.parse_additive_expression()?;
+                return Ok(Expression::Like {
+                    expr: Box::new(left),
+                    pattern: Box::new(pattern),
+                    negated,
+                });
+            }
+            Token::Between => {
+                self.advance();
+                let low = self.parse_additive_expression()?;
+                self.expect(Token::And)?;
+                let high = self.parse_additive_expression()?;
+                return Ok(Expression::Between {
+                    expr: Box::new(left),
+                    low: Box::new(low),
+                    high: Box::new(high),
+                    negated,
+                });
+            }
+            _ => {}
+        }
         
         let op = match self.current_token() {
             Token::Equal => BinaryOperator::Equal,
@@ -348,8 +427,31 @@ impl Parser {
                 self.advance();
                 Ok(Expression::Literal(SqlValue::Null))
             }
-            Token::Identifier(name) => {
+            Token::Minus => {
+                self.advance();
+                let expr = self.parse_primary_expression()?;
+                Ok(Expression::UnaryOp {
+                    op: UnaryOperator::Minus,
+                    expr: Box::new(expr),
+                })
+            }
+            Token::Identifier(mut name) => {
                 self.advance();
+
+                // table.column, or a schema-qualified function such as auth.uid()
+                if self.current_token() == &Token::Dot {
+                    if let Token::Identifier(member) = self.peek_token(1).clone() {
+                        self.advance();
+                        self.advance();
+                        if self.current_token() != &Token::LeftParen {
+                            return Ok(Expression::QualifiedIdentifier {
+                                table: name,
+                                column: member,
+                            });
+                        }
+                        name = format!("{}.{}", name, member);
+                    }
+                }
                 
                 // Check for function call
                 if self.current_token() == &Token::LeftParen {
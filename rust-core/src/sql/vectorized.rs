@@ -0,0 +1,1682 @@
+// Vectorized execution over typed column batches
+//
+// Scans produce `ColumnBatch`es: one typed vector per column plus a validity
+// bitmap. Filters and projections are compiled once per query and then run
+// as tight loops over primitive buffers; expressions without a dedicated
+// kernel fall back to per-row evaluation over the same batch.
+use super::ast::{BinaryOperator, Expression, UnaryOperator};
+use super::types::SqlValue;
+use crate::columnar_engine::{ColumnData, ColumnStore, ColumnType, CompressionType};
+use crate::error::MantisError;
+use crate::storage::LockFreeStorage;
+use std::borrow::Cow;
+use std::cmp::Ordering;
+use std::sync::Arc;
+
+pub const DEFAULT_BATCH_SIZE: usize = 1024;
+
+/// Validity bitmap: a set bit means the slot holds a value, a clear bit NULL
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct Bitmap {
+    words: Vec<u64>,
+    len: usize,
+}
+
+impl Bitmap {
+    /// Bitmap of `len` valid slots
+    pub fn all_valid(len: usize) -> Self {
+        let mut words = vec![u64::MAX; (len + 63) / 64];
+        if len % 64 != 0 {
+            if let Some(last) = words.last_mut() {
+                *last = (1u64 << (len % 64)) - 1;
+            }
+        }
+        Self { words, len }
+    }
+
+    pub fn with_capacity(capacity: usize) -> Self {
+        Self {
+            words: Vec::with_capacity((capacity + 63) / 64),
+            len: 0,
+        }
+    }
+
+    pub fn push(&mut self, valid: bool) {
+        if self.len % 64 == 0 {
+            self.words.push(0);
+        }
+        if valid {
+            self.words[self.len / 64] |= 1u64 << (self.len % 64);
+        }
+        self.len += 1;
+    }
+
+    #[inline]
+    pub fn is_valid(&self, index: usize) -> bool {
+        (self.words[index / 64] >> (index % 64)) & 1 == 1
+    }
+
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    pub fn null_count(&self) -> usize {
+        let set: usize = self.words.iter().map(|w| w.count_ones() as usize).sum();
+        self.len - set
+    }
+
+    /// Slots valid in both bitmaps; used when a kernel combines two inputs
+    pub fn and(&self, other: &Bitmap) -> Bitmap {
+        Bitmap {
+            words: self
+                .words
+                .iter()
+                .zip(other.words.iter())
+                .map(|(a, b)| a & b)
+                .collect(),
+            len: self.len.min(other.len),
+        }
+    }
+
+    fn take(&self, selection: &[u32]) -> Bitmap {
+        let mut out = Bitmap::with_capacity(selection.len());
+        for &i in selection {
+            out.push(self.is_valid(i as usize));
+        }
+        out
+    }
+}
+
+/// A single column of a batch
+#[derive(Debug, Clone, PartialEq)]
+pub enum ColumnVector {
+    Int64 { values: Vec<i64>, validity: Bitmap },
+    Float64 { values: Vec<f64>, validity: Bitmap },
+    Boolean { values: Vec<bool>, validity: Bitmap },
+    /// Strings packed into one buffer; row i spans offsets[i]..offsets[i + 1]
+    Utf8 {
+        offsets: Vec<u32>,
+        data: Vec<u8>,
+        validity: Bitmap,
+    },
+    /// Types without a dedicated kernel (dates, JSON, binary, arrays)
+    Values(Vec<SqlValue>),
+}
+
+impl ColumnVector {
+    pub fn len(&self) -> usize {
+        match self {
+            ColumnVector::Int64 { values, .. } => values.len(),
+            ColumnVector::Float64 { values, .. } => values.len(),
+            ColumnVector::Boolean { values, .. } => values.len(),
+            ColumnVector::Utf8 { offsets, .. } => offsets.len() - 1,
+            ColumnVector::Values(values) => values.len(),
+        }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    #[inline]
+    pub fn is_valid(&self, index: usize) -> bool {
+        match self {
+            ColumnVector::Int64 { validity, .. }
+            | ColumnVector::Float64 { validity, .. }
+            | ColumnVector::Boolean { validity, .. }
+            | ColumnVector::Utf8 { validity, .. } => validity.is_valid(index),
+            ColumnVector::Values(values) => !matches!(values[index], SqlValue::Null),
+        }
+    }
+
+    /// String at `index` of a Utf8 vector
+    #[inline]
+    fn str_at<'a>(offsets: &[u32], data: &'a [u8], index: usize) -> &'a str {
+        let bytes = &data[offsets[index] as usize..offsets[index + 1] as usize];
+        // Buffers are only ever filled from &str, so this cannot fail
+        std::str::from_utf8(bytes).unwrap_or_default()
+    }
+
+    /// Boxed value at `index`, for row-oriented consumers
+    pub fn value(&self, index: usize) -> SqlValue {
+        if !self.is_valid(index) {
+            return SqlValue::Null;
+        }
+        match self {
+            ColumnVector::Int64 { values, .. } => SqlValue::BigInt(values[index]),
+            ColumnVector::Float64 { values, .. } => SqlValue::Double(values[index]),
+            ColumnVector::Boolean { values, .. } => SqlValue::Boolean(values[index]),
+            ColumnVector::Utf8 { offsets, data, .. } => {
+                SqlValue::Text(Self::str_at(offsets, data, index).to_string())
+            }
+            ColumnVector::Values(values) => values[index].clone(),
+        }
+    }
+
+    /// Build a vector from boxed values, picking the narrowest typed layout
+    /// that holds every non-NULL value
+    pub fn from_values(values: &[SqlValue]) -> Self {
+        #[derive(Clone, Copy, PartialEq)]
+        enum Kind {
+            Unknown,
+            Int,
+            Float,
+            Bool,
+            Str,
+            Other,
+        }
+        let mut kind = Kind::Unknown;
+        for v in values {
+            let k = match v {
+                SqlValue::Null => continue,
+                SqlValue::Integer(_) | SqlValue::BigInt(_) | SqlValue::SmallInt(_) => Kind::Int,
+                SqlValue::Real(_) | SqlValue::Double(_) => Kind::Float,
+                SqlValue::Boolean(_) => Kind::Bool,
+                SqlValue::Char(_) | SqlValue::Varchar(_) | SqlValue::Text(_) => Kind::Str,
+                _ => Kind::Other,
+            };
+            kind = match (kind, k) {
+                (Kind::Unknown, k) => k,
+                (a, b) if a == b => a,
+                (Kind::Int, Kind::Float) | (Kind::Float, Kind::Int) => Kind::Float,
+                _ => Kind::Other,
+            };
+            if kind == Kind::Other {
+                break;
+            }
+        }
+
+        let mut validity = Bitmap::with_capacity(values.len());
+        match kind {
+            Kind::Int => {
+                let mut out = Vec::with_capacity(values.len());
+                for v in values {
+                    validity.push(!matches!(v, SqlValue::Null));
+                    out.push(as_i64(v).unwrap_or(0));
+                }
+                ColumnVector::Int64 { values: out, validity }
+            }
+            Kind::Float => {
+                let mut out = Vec::with_capacity(values.len());
+                for v in values {
+                    validity.push(!matches!(v, SqlValue::Null));
+                    out.push(as_f64(v).unwrap_or(0.0));
+                }
+                ColumnVector::Float64 { values: out, validity }
+            }
+            Kind::Bool => {
+                let mut out = Vec::with_capacity(values.len());
+                for v in values {
+                    validity.push(!matches!(v, SqlValue::Null));
+                    out.push(matches!(v, SqlValue::Boolean(true)));
+                }
+                ColumnVector::Boolean { values: out, validity }
+            }
+            Kind::Str => {
+                let mut offsets = Vec::with_capacity(values.len() + 1);
+                let mut data = Vec::new();
+                offsets.push(0u32);
+                for v in values {
+                    validity.push(!matches!(v, SqlValue::Null));
+                    if let Some(s) = as_str(v) {
+                        data.extend_from_slice(s.as_bytes());
+                    }
+                    offsets.push(data.len() as u32);
+                }
+                ColumnVector::Utf8 { offsets, data, validity }
+            }
+            Kind::Unknown | Kind::Other => ColumnVector::Values(values.to_vec()),
+        }
+    }
+
+    /// Gather the rows named by a selection vector
+    pub fn take(&self, selection: &[u32]) -> Self {
+        match self {
+            ColumnVector::Int64 { values, validity } => ColumnVector::Int64 {
+                values: selection.iter().map(|&i| values[i as usize]).collect(),
+                validity: validity.take(selection),
+            },
+            ColumnVector::Float64 { values, validity } => ColumnVector::Float64 {
+                values: selection.iter().map(|&i| values[i as usize]).collect(),
+                validity: validity.take(selection),
+            },
+            ColumnVector::Boolean { values, validity } => ColumnVector::Boolean {
+                values: selection.iter().map(|&i| values[i as usize]).collect(),
+                validity: validity.take(selection),
+            },
+            ColumnVector::Utf8 {
+                offsets,
+                data,
+                validity,
+            } => {
+                let mut new_offsets = Vec::with_capacity(selection.len() + 1);
+                let mut new_data = Vec::new();
+                new_offsets.push(0u32);
+                for &i in selection {
+                    let i = i as usize;
+                    new_data.extend_from_slice(&data[offsets[i] as usize..offsets[i + 1] as usize]);
+                    new_offsets.push(new_data.len() as u32);
+                }
+                ColumnVector::Utf8 {
+                    offsets: new_offsets,
+                    data: new_data,
+                    validity: validity.take(selection),
+                }
+            }
+            ColumnVector::Values(values) => {
+                ColumnVector::Values(selection.iter().map(|&i| values[i as usize].clone()).collect())
+            }
+        }
+    }
+
+    fn slice(&self, start: usize, end: usize) -> Self {
+        let selection: Vec<u32> = (start as u32..end as u32).collect();
+        self.take(&selection)
+    }
+
+    /// Compare two rows of this vector; NULLs sort after every value
+    pub fn compare_rows(&self, a: usize, b: usize) -> Ordering {
+        match (self.is_valid(a), self.is_valid(b)) {
+            (false, false) => return Ordering::Equal,
+            (false, true) => return Ordering::Greater,
+            (true, false) => return Ordering::Less,
+            (true, true) => {}
+        }
+        match self {
+            ColumnVector::Int64 { values, .. } => values[a].cmp(&values[b]),
+            ColumnVector::Float64 { values, .. } => values[a].total_cmp(&values[b]),
+            ColumnVector::Boolean { values, .. } => values[a].cmp(&values[b]),
+            ColumnVector::Utf8 { offsets, data, .. } => {
+                Self::str_at(offsets, data, a).cmp(Self::str_at(offsets, data, b))
+            }
+            ColumnVector::Values(values) => {
+                compare_values(&values[a], &values[b]).unwrap_or(Ordering::Equal)
+            }
+        }
+    }
+}
+
+/// A horizontal slice of a table in columnar form
+#[derive(Debug, Clone)]
+pub struct ColumnBatch {
+    columns: Arc<Vec<String>>,
+    vectors: Vec<ColumnVector>,
+    num_rows: usize,
+}
+
+impl ColumnBatch {
+    pub fn new(columns: Arc<Vec<String>>, vectors: Vec<ColumnVector>) -> Result<Self, MantisError> {
+        if columns.len() != vectors.len() {
+            return Err(MantisError::ExecutorError(format!(
+                "batch has {} column names but {} vectors",
+                columns.len(),
+                vectors.len()
+            )));
+        }
+        let num_rows = vectors.first().map(|v| v.len()).unwrap_or(0);
+        if vectors.iter().any(|v| v.len() != num_rows) {
+            return Err(MantisError::ExecutorError(
+                "batch vectors have different lengths".to_string(),
+            ));
+        }
+        Ok(Self {
+            columns,
+            vectors,
+            num_rows,
+        })
+    }
+
+    /// Transpose row-oriented values into a batch
+    pub fn from_rows(columns: Arc<Vec<String>>, rows: &[Vec<SqlValue>]) -> Result<Self, MantisError> {
+        let mut vectors = Vec::with_capacity(columns.len());
+        let mut scratch = Vec::with_capacity(rows.len());
+        for c in 0..columns.len() {
+            scratch.clear();
+            scratch.extend(rows.iter().map(|r| r.get(c).cloned().unwrap_or(SqlValue::Null)));
+            vectors.push(ColumnVector::from_values(&scratch));
+        }
+        let mut batch = Self::new(columns, vectors)?;
+        batch.num_rows = rows.len();
+        Ok(batch)
+    }
+
+    pub fn columns(&self) -> &[String] {
+        &self.columns
+    }
+
+    pub fn column(&self, index: usize) -> &ColumnVector {
+        &self.vectors[index]
+    }
+
+    pub fn num_rows(&self) -> usize {
+        self.num_rows
+    }
+
+    /// Keep only the selected rows
+    pub fn take(&self, selection: &[u32]) -> Self {
+        Self {
+            columns: Arc::clone(&self.columns),
+            vectors: self.vectors.iter().map(|v| v.take(selection)).collect(),
+            num_rows: selection.len(),
+        }
+    }
+
+    /// Evaluate a projection list into a new batch
+    pub fn project(&self, names: Arc<Vec<String>>, exprs: &[CompiledExpr]) -> Result<Self, MantisError> {
+        let vectors = exprs.iter().map(|e| e.evaluate(self)).collect();
+        let mut batch = Self::new(names, vectors)?;
+        batch.num_rows = self.num_rows;
+        Ok(batch)
+    }
+
+    /// Append the batch to a row-oriented result
+    pub fn append_rows(&self, out: &mut Vec<Vec<SqlValue>>) {
+        out.reserve(self.num_rows);
+        for row in 0..self.num_rows {
+            out.push(self.vectors.iter().map(|v| v.value(row)).collect());
+        }
+    }
+}
+
+/// Scalar functions understood by the evaluator
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum ScalarFunction {
+    Lower,
+    Upper,
+    Length,
+    Abs,
+    Coalesce,
+}
+
+/// An expression bound to column positions, ready to run over batches
+#[derive(Debug, Clone, PartialEq)]
+pub enum CompiledExpr {
+    Column(usize),
+    Literal(SqlValue),
+    Binary {
+        op: BinaryOperator,
+        left: Box<CompiledExpr>,
+        right: Box<CompiledExpr>,
+    },
+    Not(Box<CompiledExpr>),
+    Negate(Box<CompiledExpr>),
+    IsNull {
+        expr: Box<CompiledExpr>,
+        negated: bool,
+    },
+    InList {
+        expr: Box<CompiledExpr>,
+        list: Vec<CompiledExpr>,
+        negated: bool,
+    },
+    Like {
+        expr: Box<CompiledExpr>,
+        pattern: Box<CompiledExpr>,
+        negated: bool,
+    },
+    Case {
+        conditions: Vec<(CompiledExpr, CompiledExpr)>,
+        else_expr: Option<Box<CompiledExpr>>,
+    },
+    Function {
+        function: ScalarFunction,
+        args: Vec<CompiledExpr>,
+    },
+}
+
+/// Bind an AST expression to the given column layout
+pub fn compile(expr: &Expression, columns: &[String]) -> Result<CompiledExpr, MantisError> {
+    let compiled = match expr {
+        Expression::Literal(v) => CompiledExpr::Literal(v.clone()),
+        Expression::Identifier(name) => CompiledExpr::Column(resolve_column(columns, None, name)?),
+        Expression::QualifiedIdentifier { table, column } => {
+            CompiledExpr::Column(resolve_column(columns, Some(table.as_str()), column)?)
+        }
+        Expression::BinaryOp { left, op, right } => CompiledExpr::Binary {
+            op: op.clone(),
+            left: Box::new(compile(left, columns)?),
+            right: Box::new(compile(right, columns)?),
+        },
+        Expression::UnaryOp { op, expr } => {
+            let inner = compile(expr, columns)?;
+            match op {
+                UnaryOperator::Not => CompiledExpr::Not(Box::new(inner)),
+                UnaryOperator::Minus => CompiledExpr::Negate(Box::new(inner)),
+                UnaryOperator::Plus => inner,
+            }
+        }
+        Expression::FunctionCall { name, args } => {
+            let function = match name.to_ascii_uppercase().as_str() {
+                "LOWER" => ScalarFunction::Lower,
+                "UPPER" => ScalarFunction::Upper,
+                "LENGTH" => ScalarFunction::Length,
+                "ABS" => ScalarFunction::Abs,
+                "COALESCE" => ScalarFunction::Coalesce,
+                _ => {
+                    return Err(MantisError::ExecutorError(format!(
+                        "unsupported function: {}",
+                        name
+                    )))
+                }
+            };
+            CompiledExpr::Function {
+                function,
+                args: args
+                    .iter()
+                    .map(|a| compile(a, columns))
+                    .collect::<Result<_, _>>()?,
+            }
+        }
+        Expression::Case {
+            conditions,
+            else_expr,
+        } => CompiledExpr::Case {
+            conditions: conditions
+                .iter()
+                .map(|(c, r)| Ok((compile(c, columns)?, compile(r, columns)?)))
+                .collect::<Result<_, MantisError>>()?,
+            else_expr: match else_expr {
+                Some(e) => Some(Box::new(compile(e, columns)?)),
+                None => None,
+            },
+        },
+        Expression::InList {
+            expr,
+            list,
+            negated,
+        } => CompiledExpr::InList {
+            expr: Box::new(compile(expr, columns)?),
+            list: list
+                .iter()
+                .map(|e| compile(e, columns))
+                .collect::<Result<_, _>>()?,
+            negated: *negated,
+        },
+        Expression::Between {
+            expr,
+            low,
+            high,
+            negated,
+        } => {
+            let value = compile(expr, columns)?;
+            let range = CompiledExpr::Binary {
+                op: BinaryOperator::And,
+                left: Box::new(CompiledExpr::Binary {
+                    op: BinaryOperator::GreaterEqual,
+                    left: Box::new(value.clone()),
+                    right: Box::new(compile(low, columns)?),
+                }),
+                right: Box::new(CompiledExpr::Binary {
+                    op: BinaryOperator::LessEqual,
+                    left: Box::new(value),
+                    right: Box::new(compile(high, columns)?),
+                }),
+            };
+            if *negated {
+                CompiledExpr::Not(Box::new(range))
+            } else {
+                range
+            }
+        }
+        Expression::Like {
+            expr,
+            pattern,
+            negated,
+        } => CompiledExpr::Like {
+            expr: Box::new(compile(expr, columns)?),
+            pattern: Box::new(compile(pattern, columns)?),
+            negated: *negated,
+        },
+        Expression::IsNull { expr, negated } => CompiledExpr::IsNull {
+            expr: Box::new(compile(expr, columns)?),
+            negated: *negated,
+        },
+        Expression::Subquery(_) => {
+            return Err(MantisError::ExecutorError(
+                "subqueries are not supported by the vectorized executor".to_string(),
+            ))
+        }
+    };
+    Ok(fold_constants(compiled))
+}
+
+/// Collapse operators whose inputs are all literals
+fn fold_constants(expr: CompiledExpr) -> CompiledExpr {
+    let constant = match &expr {
+        CompiledExpr::Binary { left, right, .. } => {
+            matches!(**left, CompiledExpr::Literal(_)) && matches!(**right, CompiledExpr::Literal(_))
+        }
+        CompiledExpr::Not(inner) | CompiledExpr::Negate(inner) => {
+            matches!(**inner, CompiledExpr::Literal(_))
+        }
+        _ => false,
+    };
+    if constant {
+        let empty: &[SqlValue] = &[];
+        CompiledExpr::Literal(expr.eval_row(empty))
+    } else {
+        expr
+    }
+}
+
+fn resolve_column(columns: &[String], table: Option<&str>, name: &str) -> Result<usize, MantisError> {
+    if let Some(table) = table {
+        let qualified = format!("{}.{}", table, name);
+        if let Some(i) = columns.iter().position(|c| c.eq_ignore_ascii_case(&qualified)) {
+            return Ok(i);
+        }
+    }
+    if let Some(i) = columns.iter().position(|c| c.eq_ignore_ascii_case(name)) {
+        return Ok(i);
+    }
+    // A bare name may refer to a table-qualified join column, but a qualified
+    // name must not silently bind to another table's column.
+    if table.is_none() {
+        let suffix = format!(".{}", name.to_ascii_lowercase());
+        if let Some(i) = columns
+            .iter()
+            .position(|c| c.to_ascii_lowercase().ends_with(&suffix))
+        {
+            return Ok(i);
+        }
+    }
+    Err(MantisError::ExecutorError(format!("unknown column: {}", name)))
+}
+
+/// Row access used by the per-row evaluation path
+trait RowAccess {
+    fn value_at(&self, column: usize) -> SqlValue;
+}
+
+impl RowAccess for [SqlValue] {
+    fn value_at(&self, column: usize) -> SqlValue {
+        self.get(column).cloned().unwrap_or(SqlValue::Null)
+    }
+}
+
+struct BatchRow<'a> {
+    batch: &'a ColumnBatch,
+    row: usize,
+}
+
+impl RowAccess for BatchRow<'_> {
+    fn value_at(&self, column: usize) -> SqlValue {
+        self.batch.column(column).value(self.row)
+    }
+}
+
+enum Operand<'a> {
+    Vector(Cow<'a, ColumnVector>),
+    Scalar(&'a SqlValue),
+}
+
+impl CompiledExpr {
+    /// Evaluate against one row-oriented tuple
+    pub fn eval_row(&self, row: &[SqlValue]) -> SqlValue {
+        self.eval_scalar(row)
+    }
+
+    /// True if the expression evaluates to TRUE (not FALSE or NULL) for `row`
+    pub fn matches_row(&self, row: &[SqlValue]) -> bool {
+        matches!(self.eval_row(row), SqlValue::Boolean(true))
+    }
+
+    /// Evaluate over a whole batch, producing one output vector
+    pub fn evaluate(&self, batch: &ColumnBatch) -> ColumnVector {
+        match self {
+            CompiledExpr::Column(i) => batch.column(*i).clone(),
+            CompiledExpr::Binary { op, left, right } => {
+                match binary_kernel(op, left, right, batch) {
+                    Some(v) => v,
+                    None => self.evaluate_rows(batch),
+                }
+            }
+            CompiledExpr::Not(inner) => match inner.evaluate(batch) {
+                ColumnVector::Boolean { values, validity } => ColumnVector::Boolean {
+                    values: values.into_iter().map(|b| !b).collect(),
+                    validity,
+                },
+                _ => self.evaluate_rows(batch),
+            },
+            CompiledExpr::IsNull { expr, negated } => {
+                let input = operand(expr, batch);
+                let n = batch.num_rows();
+                let values = match &input {
+                    Operand::Vector(v) => (0..n).map(|i| v.is_valid(i) == *negated).collect(),
+                    Operand::Scalar(s) => vec![matches!(s, SqlValue::Null) != *negated; n],
+                };
+                ColumnVector::Boolean {
+                    values,
+                    validity: Bitmap::all_valid(n),
+                }
+            }
+            _ => self.evaluate_rows(batch),
+        }
+    }
+
+    /// Row indices of `batch` for which the predicate is TRUE. Conjunctions
+    /// evaluate their right side only over rows the left side kept.
+    pub fn select(&self, batch: &ColumnBatch) -> Vec<u32> {
+        if let CompiledExpr::Binary {
+            op: BinaryOperator::And,
+            left,
+            right,
+        } = self
+        {
+            let first = left.select(batch);
+            if first.is_empty() {
+                return first;
+            }
+            if first.len() == batch.num_rows() {
+                return right.select(batch);
+            }
+            let narrowed = batch.take(&first);
+            return right
+                .select(&narrowed)
+                .into_iter()
+                .map(|i| first[i as usize])
+                .collect();
+        }
+
+        match self.evaluate(batch) {
+            ColumnVector::Boolean { values, validity } => values
+                .iter()
+                .enumerate()
+                .filter(|(i, v)| **v && validity.is_valid(*i))
+                .map(|(i, _)| i as u32)
+                .collect(),
+            other => (0..other.len())
+                .filter(|&i| matches!(other.value(i), SqlValue::Boolean(true)))
+                .map(|i| i as u32)
+                .collect(),
+        }
+    }
+
+    fn evaluate_rows(&self, batch: &ColumnBatch) -> ColumnVector {
+        let values: Vec<SqlValue> = (0..batch.num_rows())
+            .map(|row| self.eval_scalar(&BatchRow { batch, row }))
+            .collect();
+        ColumnVector::from_values(&values)
+    }
+
+    fn eval_scalar<R: RowAccess + ?Sized>(&self, row: &R) -> SqlValue {
+        match self {
+            CompiledExpr::Column(i) => row.value_at(*i),
+            CompiledExpr::Literal(v) => v.clone(),
+            CompiledExpr::Binary { op, left, right } => match op {
+                BinaryOperator::And => {
+                    let l = truth(&left.eval_scalar(row));
+                    if l == Some(false) {
+                        return SqlValue::Boolean(false);
+                    }
+                    match (l, truth(&right.eval_scalar(row))) {
+                        (_, Some(false)) => SqlValue::Boolean(false),
+                        (Some(true), Some(true)) => SqlValue::Boolean(true),
+                        _ => SqlValue::Null,
+                    }
+                }
+                BinaryOperator::Or => {
+                    let l = truth(&left.eval_scalar(row));
+                    if l == Some(true) {
+                        return SqlValue::Boolean(true);
+                    }
+                    match (l, truth(&right.eval_scalar(row))) {
+                        (_, Some(true)) => SqlValue::Boolean(true),
+                        (Some(false), Some(false)) => SqlValue::Boolean(false),
+                        _ => SqlValue::Null,
+                    }
+                }
+                _ => binary_scalar(op, &left.eval_scalar(row), &right.eval_scalar(row)),
+            },
+            CompiledExpr::Not(inner) => match truth(&inner.eval_scalar(row)) {
+                Some(b) => SqlValue::Boolean(!b),
+                None => SqlValue::Null,
+            },
+            CompiledExpr::Negate(inner) => match inner.eval_scalar(row) {
+                SqlValue::Integer(v) => SqlValue::Integer(v.wrapping_neg()),
+                SqlValue::BigInt(v) => SqlValue::BigInt(v.wrapping_neg()),
+                SqlValue::SmallInt(v) => SqlValue::SmallInt(v.wrapping_neg()),
+                SqlValue::Real(v) => SqlValue::Real(-v),
+                SqlValue::Double(v) => SqlValue::Double(-v),
+                _ => SqlValue::Null,
+            },
+            CompiledExpr::IsNull { expr, negated } => {
+                SqlValue::Boolean(matches!(expr.eval_scalar(row), SqlValue::Null) != *negated)
+            }
+            CompiledExpr::InList {
+                expr,
+                list,
+                negated,
+            } => {
+                let value = expr.eval_scalar(row);
+                if matches!(value, SqlValue::Null) {
+                    return SqlValue::Null;
+                }
+                let mut saw_null = false;
+                for item in list {
+                    let item = item.eval_scalar(row);
+                    match compare_values(&value, &item) {
+                        Some(Ordering::Equal) => return SqlValue::Boolean(!*negated),
+                        None if matches!(item, SqlValue::Null) => saw_null = true,
+                        _ => {}
+                    }
+                }
+                if saw_null {
+                    SqlValue::Null
+                } else {
+                    SqlValue::Boolean(*negated)
+                }
+            }
+            CompiledExpr::Like {
+                expr,
+                pattern,
+                negated,
+            } => {
+                let value = expr.eval_scalar(row);
+                let pattern = pattern.eval_scalar(row);
+                match (as_str(&value), as_str(&pattern)) {
+                    (Some(v), Some(p)) => SqlValue::Boolean(like_match(v, p) != *negated),
+                    _ => SqlValue::Null,
+                }
+            }
+            CompiledExpr::Case {
+                conditions,
+                else_expr,
+            } => {
+                for (condition, result) in conditions {
+                    if truth(&condition.eval_scalar(row)) == Some(true) {
+                        return result.eval_scalar(row);
+                    }
+                }
+                match else_expr {
+                    Some(e) => e.eval_scalar(row),
+                    None => SqlValue::Null,
+                }
+            }
+            CompiledExpr::Function { function, args } => {
+                let mut values = args.iter().map(|a| a.eval_scalar(row));
+                match function {
+                    ScalarFunction::Coalesce => values
+                        .find(|v| !matches!(v, SqlValue::Null))
+                        .unwrap_or(SqlValue::Null),
+                    ScalarFunction::Lower | ScalarFunction::Upper | ScalarFunction::Length => {
+                        let value = values.next().unwrap_or(SqlValue::Null);
+                        match (function, as_str(&value)) {
+                            (ScalarFunction::Lower, Some(s)) => SqlValue::Text(s.to_lowercase()),
+                            (ScalarFunction::Upper, Some(s)) => SqlValue::Text(s.to_uppercase()),
+                            (_, Some(s)) => SqlValue::BigInt(s.chars().count() as i64),
+                            _ => SqlValue::Null,
+                        }
+                    }
+                    ScalarFunction::Abs => match values.next().unwrap_or(SqlValue::Null) {
+                        SqlValue::Integer(v) => SqlValue::Integer(v.wrapping_abs()),
+                        SqlValue::BigInt(v) => SqlValue::BigInt(v.wrapping_abs()),
+                        SqlValue::SmallInt(v) => SqlValue::SmallInt(v.wrapping_abs()),
+                        SqlValue::Real(v) => SqlValue::Real(v.abs()),
+                        SqlValue::Double(v) => SqlValue::Double(v.abs()),
+                        _ => SqlValue::Null,
+                    },
+                }
+            }
+        }
+    }
+}
+
+fn operand<'a>(expr: &'a CompiledExpr, batch: &'a ColumnBatch) -> Operand<'a> {
+    match expr {
+        CompiledExpr::Literal(v) => Operand::Scalar(v),
+        CompiledExpr::Column(i) => Operand::Vector(Cow::Borrowed(batch.column(*i))),
+        other => Operand::Vector(Cow::Owned(other.evaluate(batch))),
+    }
+}
+
+fn ordering_predicate(op: &BinaryOperator) -> Option<fn(Ordering) -> bool> {
+    let pred: fn(Ordering) -> bool = match op {
+        BinaryOperator::Equal => |o| o == Ordering::Equal,
+        BinaryOperator::NotEqual => |o| o != Ordering::Equal,
+        BinaryOperator::Less => |o| o == Ordering::Less,
+        BinaryOperator::LessEqual => |o| o != Ordering::Greater,
+        BinaryOperator::Greater => |o| o == Ordering::Greater,
+        BinaryOperator::GreaterEqual => |o| o != Ordering::Less,
+        _ => return None,
+    };
+    Some(pred)
+}
+
+fn reverse_comparison(op: &BinaryOperator) -> BinaryOperator {
+    match op {
+        BinaryOperator::Less => BinaryOperator::Greater,
+        BinaryOperator::LessEqual => BinaryOperator::GreaterEqual,
+        BinaryOperator::Greater => BinaryOperator::Less,
+        BinaryOperator::GreaterEqual => BinaryOperator::LessEqual,
+        other => other.clone(),
+    }
+}
+
+fn all_null_bool(n: usize) -> ColumnVector {
+    let mut validity = Bitmap::with_capacity(n);
+    for _ in 0..n {
+        validity.push(false);
+    }
+    ColumnVector::Boolean {
+        values: vec![false; n],
+        validity,
+    }
+}
+
+/// Typed kernels for the common shapes: comparisons and arithmetic between
+/// numeric or string vectors and literals, and three-valued AND/OR between
+/// boolean vectors. Returns None when no kernel applies.
+fn binary_kernel(
+    op: &BinaryOperator,
+    left: &CompiledExpr,
+    right: &CompiledExpr,
+    batch: &ColumnBatch,
+) -> Option<ColumnVector> {
+    let n = batch.num_rows();
+    let l = operand(left, batch);
+    let r = operand(right, batch);
+
+    if matches!(op, BinaryOperator::And | BinaryOperator::Or) {
+        let (Operand::Vector(lv), Operand::Vector(rv)) = (&l, &r) else {
+            return None;
+        };
+        let (
+            ColumnVector::Boolean {
+                values: lvals,
+                validity: lvalid,
+            },
+            ColumnVector::Boolean {
+                values: rvals,
+                validity: rvalid,
+            },
+        ) = (&**lv, &**rv)
+        else {
+            return None;
+        };
+        // The dominant value (FALSE for AND, TRUE for OR) wins even over NULL
+        let dominant = matches!(op, BinaryOperator::Or);
+        let mut values = Vec::with_capacity(n);
+        let mut validity = Bitmap::with_capacity(n);
+        for i in 0..n {
+            let (la, ra) = (lvalid.is_valid(i), rvalid.is_valid(i));
+            if (la && lvals[i] == dominant) || (ra && rvals[i] == dominant) {
+                values.push(dominant);
+                validity.push(true);
+            } else if la && ra {
+                values.push(!dominant);
+                validity.push(true);
+            } else {
+                values.push(false);
+                validity.push(false);
+            }
+        }
+        return Some(ColumnVector::Boolean { values, validity });
+    }
+
+    if let Some(pred) = ordering_predicate(op) {
+        // Normalise `literal op column` to `column op' literal`
+        let (vector, scalar, pred) = match (&l, &r) {
+            (Operand::Vector(v), Operand::Scalar(s)) => (&**v, *s, pred),
+            (Operand::Scalar(s), Operand::Vector(v)) => {
+                (&**v, *s, ordering_predicate(&reverse_comparison(op))?)
+            }
+            (Operand::Vector(a), Operand::Vector(b)) => return compare_vectors(a, b, pred),
+            _ => return None,
+        };
+        if matches!(scalar, SqlValue::Null) {
+            return Some(all_null_bool(n));
+        }
+        let values: Vec<bool> = match vector {
+            ColumnVector::Int64 { values, .. } => match scalar {
+                SqlValue::Integer(_) | SqlValue::BigInt(_) | SqlValue::SmallInt(_) => {
+                    let rhs = as_i64(scalar)?;
+                    values.iter().map(|v| pred(v.cmp(&rhs))).collect()
+                }
+                _ => {
+                    let rhs = as_f64(scalar)?;
+                    values
+                        .iter()
+                        .map(|&v| (v as f64).partial_cmp(&rhs).map_or(false, pred))
+                        .collect()
+                }
+            },
+            ColumnVector::Float64 { values, .. } => {
+                let rhs = as_f64(scalar)?;
+                values
+                    .iter()
+                    .map(|v| v.partial_cmp(&rhs).map_or(false, pred))
+                    .collect()
+            }
+            ColumnVector::Utf8 { offsets, data, .. } => {
+                let rhs = as_str(scalar)?;
+                (0..n)
+                    .map(|i| pred(ColumnVector::str_at(offsets, data, i).cmp(rhs)))
+                    .collect()
+            }
+            ColumnVector::Boolean { values, .. } => {
+                let SqlValue::Boolean(rhs) = scalar else {
+                    return None;
+                };
+                values.iter().map(|v| pred(v.cmp(rhs))).collect()
+            }
+            ColumnVector::Values(_) => return None,
+        };
+        let validity = match vector {
+            ColumnVector::Int64 { validity, .. }
+            | ColumnVector::Float64 { validity, .. }
+            | ColumnVector::Utf8 { validity, .. }
+            | ColumnVector::Boolean { validity, .. } => validity.clone(),
+            ColumnVector::Values(_) => unreachable!(),
+        };
+        return Some(ColumnVector::Boolean { values, validity });
+    }
+
+    arithmetic_kernel(op, &l, &r, n)
+}
+
+fn compare_vectors(
+    a: &ColumnVector,
+    b: &ColumnVector,
+    pred: fn(Ordering) -> bool,
+) -> Option<ColumnVector> {
+    let (values, validity): (Vec<bool>, Bitmap) = match (a, b) {
+        (
+            ColumnVector::Int64 { values: x, validity: xv },
+            ColumnVector::Int64 { values: y, validity: yv },
+        ) => (
+            x.iter().zip(y).map(|(p, q)| pred(p.cmp(q))).collect(),
+            xv.and(yv),
+        ),
+        (
+            ColumnVector::Float64 { values: x, validity: xv },
+            ColumnVector::Float64 { values: y, validity: yv },
+        ) => (
+            x.iter()
+                .zip(y)
+                .map(|(p, q)| p.partial_cmp(q).map_or(false, pred))
+                .collect(),
+            xv.and(yv),
+        ),
+        (
+            ColumnVector::Int64 { values: x, validity: xv },
+            ColumnVector::Float64 { values: y, validity: yv },
+        ) => (
+            x.iter()
+                .zip(y)
+                .map(|(&p, q)| (p as f64).partial_cmp(q).map_or(false, pred))
+                .collect(),
+            xv.and(yv),
+        ),
+        (
+            ColumnVector::Float64 { values: x, validity: xv },
+            ColumnVector::Int64 { values: y, validity: yv },
+        ) => (
+            x.iter()
+                .zip(y)
+                .map(|(p, &q)| p.partial_cmp(&(q as f64)).map_or(false, pred))
+                .collect(),
+            xv.and(yv),
+        ),
+        (
+            ColumnVector::Utf8 {
+                offsets: xo,
+                data: xd,
+                validity: xv,
+            },
+            ColumnVector::Utf8 {
+                offsets: yo,
+                data: yd,
+                validity: yv,
+            },
+        ) => (
+            (0..a.len())
+                .map(|i| {
+                    pred(ColumnVector::str_at(xo, xd, i).cmp(ColumnVector::str_at(yo, yd, i)))
+                })
+                .collect(),
+            xv.and(yv),
+        ),
+        _ => return None,
+    };
+    Some(ColumnVector::Boolean { values, validity })
+}
+
+/// Numeric view of an arithmetic operand: a vector or a broadcast literal
+enum NumericInput<'a> {
+    Ints(&'a [i64], Option<&'a Bitmap>),
+    Floats(Cow<'a, [f64]>, Option<&'a Bitmap>),
+}
+
+fn numeric_input<'a>(operand: &'a Operand<'a>, n: usize) -> Option<NumericInput<'a>> {
+    match operand {
+        Operand::Vector(v) => match &**v {
+            ColumnVector::Int64 { values, validity } => Some(NumericInput::Ints(values, Some(validity))),
+            ColumnVector::Float64 { values, validity } => {
+                Some(NumericInput::Floats(Cow::Borrowed(values), Some(validity)))
+            }
+            _ => None,
+        },
+        Operand::Scalar(s) => match s {
+            SqlValue::Real(_) | SqlValue::Double(_) => {
+                Some(NumericInput::Floats(Cow::Owned(vec![as_f64(s)?; n]), None))
+            }
+            _ => None,
+        },
+    }
+}
+
+fn arithmetic_kernel(op: &BinaryOperator, l: &Operand, r: &Operand, n: usize) -> Option<ColumnVector> {
+    if !matches!(
+        op,
+        BinaryOperator::Add | BinaryOperator::Subtract | BinaryOperator::Multiply | BinaryOperator::Divide
+    ) {
+        return None;
+    }
+
+    // Integer literals are broadcast here so both sides borrow as slices
+    let int_scalar = |o: &Operand| match o {
+        Operand::Scalar(s) => as_i64(s),
+        _ => None,
+    };
+    let left_ints = int_scalar(l).map(|v| vec![v; n]);
+    let right_ints = int_scalar(r).map(|v| vec![v; n]);
+    let left = match &left_ints {
+        Some(v) => NumericInput::Ints(v, None),
+        None => numeric_input(l, n)?,
+    };
+    let right = match &right_ints {
+        Some(v) => NumericInput::Ints(v, None),
+        None => numeric_input(r, n)?,
+    };
+
+    let validity = match (validity_of(&left), validity_of(&right)) {
+        (Some(a), Some(b)) => a.and(b),
+        (Some(a), None) | (None, Some(a)) => a.clone(),
+        (None, None) => Bitmap::all_valid(n),
+    };
+
+    match (&left, &right) {
+        // Integer division needs NULL-on-zero handling; leave it to the row path
+        (NumericInput::Ints(x, _), NumericInput::Ints(y, _)) => {
+            let f: fn(i64, i64) -> Option<i64> = match op {
+                BinaryOperator::Add => i64::checked_add,
+                BinaryOperator::Subtract => i64::checked_sub,
+                BinaryOperator::Multiply => i64::checked_mul,
+                _ => return None,
+            };
+            // On overflow fall back to the row path, which widens to DOUBLE
+            let values = x
+                .iter()
+                .zip(y.iter())
+                .map(|(&a, &b)| f(a, b))
+                .collect::<Option<Vec<i64>>>()?;
+            Some(ColumnVector::Int64 { values, validity })
+        }
+        _ => {
+            let x = as_floats(&left);
+            let y = as_floats(&right);
+            let f: fn(f64, f64) -> f64 = match op {
+                BinaryOperator::Add => |a, b| a + b,
+                BinaryOperator::Subtract => |a, b| a - b,
+                BinaryOperator::Multiply => |a, b| a * b,
+                _ => |a, b| a / b,
+            };
+            let values = x.iter().zip(y.iter()).map(|(&a, &b)| f(a, b)).collect();
+            Some(ColumnVector::Float64 { values, validity })
+        }
+    }
+}
+
+fn validity_of<'a>(input: &NumericInput<'a>) -> Option<&'a Bitmap> {
+    match input {
+        NumericInput::Ints(_, v) | NumericInput::Floats(_, v) => *v,
+    }
+}
+
+fn as_floats<'a>(input: &'a NumericInput<'a>) -> Cow<'a, [f64]> {
+    match input {
+        NumericInput::Ints(v, _) => Cow::Owned(v.iter().map(|&x| x as f64).collect()),
+        NumericInput::Floats(v, _) => Cow::Borrowed(&**v),
+    }
+}
+
+fn truth(value: &SqlValue) -> Option<bool> {
+    match value {
+        SqlValue::Boolean(b) => Some(*b),
+        _ => None,
+    }
+}
+
+fn as_i64(value: &SqlValue) -> Option<i64> {
+    match value {
+        SqlValue::Integer(v) => Some(*v as i64),
+        SqlValue::BigInt(v) => Some(*v),
+        SqlValue::SmallInt(v) => Some(*v as i64),
+        _ => None,
+    }
+}
+
+pub(crate) fn as_f64(value: &SqlValue) -> Option<f64> {
+    match value {
+        SqlValue::Real(v) => Some(*v as f64),
+        SqlValue::Double(v) => Some(*v),
+        SqlValue::Decimal(s) => s.parse().ok(),
+        other => as_i64(other).map(|v| v as f64),
+    }
+}
+
+fn as_str(value: &SqlValue) -> Option<&str> {
+    match value {
+        SqlValue::Char(s) | SqlValue::Varchar(s) | SqlValue::Text(s) => Some(s),
+        _ => None,
+    }
+}
+
+/// SQL comparison; None when either side is NULL or the types are incomparable
+pub fn compare_values(a: &SqlValue, b: &SqlValue) -> Option<Ordering> {
+    if let (Some(x), Some(y)) = (as_i64(a), as_i64(b)) {
+        return Some(x.cmp(&y));
+    }
+    if let (Some(x), Some(y)) = (as_f64(a), as_f64(b)) {
+        return x.partial_cmp(&y);
+    }
+    if let (Some(x), Some(y)) = (as_str(a), as_str(b)) {
+        return Some(x.cmp(y));
+    }
+    match (a, b) {
+        (SqlValue::Boolean(x), SqlValue::Boolean(y)) => Some(x.cmp(y)),
+        (SqlValue::Date(x), SqlValue::Date(y)) => Some(x.cmp(y)),
+        (SqlValue::Time(x), SqlValue::Time(y)) => Some(x.cmp(y)),
+        (SqlValue::Timestamp(x), SqlValue::Timestamp(y)) => Some(x.cmp(y)),
+        (SqlValue::Binary(x) | SqlValue::Blob(x), SqlValue::Binary(y) | SqlValue::Blob(y)) => {
+            Some(x.cmp(y))
+        }
+        _ => None,
+    }
+}
+
+fn binary_scalar(op: &BinaryOperator, a: &SqlValue, b: &SqlValue) -> SqlValue {
+    if matches!(a, SqlValue::Null) || matches!(b, SqlValue::Null) {
+        return SqlValue::Null;
+    }
+    if let Some(pred) = ordering_predicate(op) {
+        return match compare_values(a, b) {
+            Some(o) => SqlValue::Boolean(pred(o)),
+            None => SqlValue::Null,
+        };
+    }
+    match op {
+        BinaryOperator::Concat => SqlValue::Text(format!("{}{}", a, b)),
+        BinaryOperator::Add
+        | BinaryOperator::Subtract
+        | BinaryOperator::Multiply
+        | BinaryOperator::Divide
+        | BinaryOperator::Modulo => {
+            if let (Some(x), Some(y)) = (as_i64(a), as_i64(b)) {
+                let result = match op {
+                    BinaryOperator::Add => x.checked_add(y),
+                    BinaryOperator::Subtract => x.checked_sub(y),
+                    BinaryOperator::Multiply => x.checked_mul(y),
+                    BinaryOperator::Divide if y == 0 => return SqlValue::Null,
+                    BinaryOperator::Divide => x.checked_div(y),
+                    _ if y == 0 => return SqlValue::Null,
+                    _ => x.checked_rem(y),
+                };
+                if let Some(v) = result {
+                    return SqlValue::BigInt(v);
+                }
+            }
+            match (as_f64(a), as_f64(b)) {
+                (Some(x), Some(y)) => match op {
+                    BinaryOperator::Add => SqlValue::Double(x + y),
+                    BinaryOperator::Subtract => SqlValue::Double(x - y),
+                    BinaryOperator::Multiply => SqlValue::Double(x * y),
+                    _ if y == 0.0 => SqlValue::Null,
+                    BinaryOperator::Divide => SqlValue::Double(x / y),
+                    _ => SqlValue::Double(x % y),
+                },
+                _ => SqlValue::Null,
+            }
+        }
+        _ => SqlValue::Null,
+    }
+}
+
+/// SQL LIKE with `%` (any run) and `_` (any single character)
+fn like_match(value: &str, pattern: &str) -> bool {
+    let v: Vec<char> = value.chars().collect();
+    let p: Vec<char> = pattern.chars().collect();
+    let (mut vi, mut pi) = (0, 0);
+    let mut backtrack: Option<(usize, usize)> = None;
+    while vi < v.len() {
+        if pi < p.len() && (p[pi] == '_' || p[pi] == v[vi]) {
+            vi += 1;
+            pi += 1;
+        } else if pi < p.len() && p[pi] == '%' {
+            backtrack = Some((pi, vi));
+            pi += 1;
+        } else if let Some((bp, bv)) = backtrack {
+            pi = bp + 1;
+            vi = bv + 1;
+            backtrack = Some((bp, bv + 1));
+        } else {
+            return false;
+        }
+    }
+    p[pi..].iter().all(|&c| c == '%')
+}
+
+/// Source of column batches for table scans
+pub trait BatchSource: Send + Sync {
+    /// Scan `table` as batches of at most `batch_size` rows. All batches share
+    /// one column layout.
+    fn scan(&self, table: &str, batch_size: usize) -> Result<(Arc<Vec<String>>, Vec<ColumnBatch>), MantisError>;
+
+    /// Read only the rows of `table` whose `column` equals one of `values`,
+    /// when the source can find them without a scan, as with a primary key.
+    /// None means it cannot and the caller should scan.
+    fn lookup(
+        &self,
+        _table: &str,
+        _column: &str,
+        _values: &[SqlValue],
+        _batch_size: usize,
+    ) -> Option<Result<(Arc<Vec<String>>, Vec<ColumnBatch>), MantisError>> {
+        None
+    }
+}
+
+fn split_into_batches(
+    columns: Arc<Vec<String>>,
+    vectors: Vec<ColumnVector>,
+    batch_size: usize,
+) -> Result<Vec<ColumnBatch>, MantisError> {
+    let whole = ColumnBatch::new(Arc::clone(&columns), vectors)?;
+    let rows = whole.num_rows();
+    if rows <= batch_size {
+        return Ok(if rows == 0 { Vec::new() } else { vec![whole] });
+    }
+    let mut batches = Vec::with_capacity((rows + batch_size - 1) / batch_size);
+    let mut start = 0;
+    while start < rows {
+        let end = (start + batch_size).min(rows);
+        batches.push(ColumnBatch {
+            columns: Arc::clone(&columns),
+            vectors: whole.vectors.iter().map(|v| v.slice(start, end)).collect(),
+            num_rows: end - start,
+        });
+        start = end;
+    }
+    Ok(batches)
+}
+
+/// Scans tables held by the columnar engine
+pub struct ColumnStoreSource {
+    store: Arc<ColumnStore>,
+}
+
+impl ColumnStoreSource {
+    pub fn new(store: Arc<ColumnStore>) -> Self {
+        Self { store }
+    }
+}
+
+impl BatchSource for ColumnStoreSource {
+    fn scan(&self, table: &str, batch_size: usize) -> Result<(Arc<Vec<String>>, Vec<ColumnBatch>), MantisError> {
+        let (names, vectors) = self
+            .store
+            .get_table(table, |t| {
+                // ColumnarTable keeps columns in a HashMap, so order by name to
+                // give scans a stable layout.
+                let mut names: Vec<String> = t.columns.keys().cloned().collect();
+                names.sort();
+                let vectors = names
+                    .iter()
+                    .map(|name| decode_column(&t.columns[name]))
+                    .collect::<Result<Vec<_>, _>>()?;
+                Ok::<_, MantisError>((names, vectors))
+            })
+            .map_err(|e| MantisError::StorageError(e.to_string()))??;
+        let columns = Arc::new(names);
+        let batches = split_into_batches(Arc::clone(&columns), vectors, batch_size.max(1))?;
+        Ok((columns, batches))
+    }
+}
+
+/// Decode a stored column straight into a typed vector. Strings are walked
+/// once rather than through `get_string`, which rescans from the start.
+fn decode_column(column: &ColumnData) -> Result<ColumnVector, MantisError> {
+    let column: Cow<ColumnData> = if column.compression == CompressionType::None {
+        Cow::Borrowed(column)
+    } else {
+        let mut owned = column.clone();
+        owned
+            .decompress()
+            .map_err(|e| MantisError::StorageError(e.to_string()))?;
+        Cow::Owned(owned)
+    };
+    let rows = column.row_count;
+    let corrupt = || MantisError::StorageError(format!("corrupt column data: {}", column.name));
+
+    let mut validity = Bitmap::with_capacity(rows);
+    for i in 0..rows {
+        validity.push(!column.is_null(i));
+    }
+
+    match column.data_type {
+        ColumnType::Int64 => {
+            if column.values.len() < rows * 8 {
+                return Err(corrupt());
+            }
+            let values = column.values[..rows * 8]
+                .chunks_exact(8)
+                .map(|c| i64::from_le_bytes(c.try_into().unwrap_or([0; 8])))
+                .collect();
+            Ok(ColumnVector::Int64 { values, validity })
+        }
+        ColumnType::String => {
+            let mut offsets = Vec::with_capacity(rows + 1);
+            let mut data = Vec::with_capacity(column.values.len());
+            offsets.push(0u32);
+            let mut pos = 0;
+            for _ in 0..rows {
+                let len_bytes = column.values.get(pos..pos + 4).ok_or_else(corrupt)?;
+                let len = u32::from_le_bytes(len_bytes.try_into().map_err(|_| corrupt())?) as usize;
+                pos += 4;
+                let bytes = column.values.get(pos..pos + len).ok_or_else(corrupt)?;
+                std::str::from_utf8(bytes).map_err(|_| corrupt())?;
+                data.extend_from_slice(bytes);
+                offsets.push(data.len() as u32);
+                pos += len;
+            }
+            Ok(ColumnVector::Utf8 {
+                offsets,
+                data,
+                validity,
+            })
+        }
+        other => Err(MantisError::ExecutorError(format!(
+            "column {} has unsupported type {:?}",
+            column.name, other
+        ))),
+    }
+}
+
+/// Scans rows stored in the KV engine as `<table>/<key>` entries whose values
+/// are JSON objects. Non-object values surface as a single `value` column.
+pub struct KvTableSource {
+    storage: LockFreeStorage,
+}
+
+impl KvTableSource {
+    pub fn new(storage: LockFreeStorage) -> Self {
+        Self { storage }
+    }
+}
+
+pub(crate) fn json_to_sql(value: serde_json::Value) -> SqlValue {
+    match value {
+        serde_json::Value::Null => SqlValue::Null,
+        serde_json::Value::Bool(b) => SqlValue::Boolean(b),
+        serde_json::Value::Number(n) => match n.as_i64() {
+            Some(i) => SqlValue::BigInt(i),
+            None => n.as_f64().map(SqlValue::Double).unwrap_or(SqlValue::Null),
+        },
+        serde_json::Value::String(s) => SqlValue::Text(s),
+        other => SqlValue::Json(other),
+    }
+}
+
+impl KvTableSource {
+    /// Decode `(key, value)` entries whose keys start with `prefix` into
+    /// batches. Columns are the union of fields in first-seen order, after
+    /// `key`.
+    fn entries_to_batches(
+        prefix: &str,
+        entries: Vec<(String, Vec<u8>)>,
+        batch_size: usize,
+    ) -> Result<(Arc<Vec<String>>, Vec<ColumnBatch>), MantisError> {
+        let mut names = vec!["key".to_string()];
+        let mut rows: Vec<Vec<(usize, SqlValue)>> = Vec::with_capacity(entries.len());
+        for (key, value) in entries {
+            let mut row = vec![(0, SqlValue::Text(key[prefix.len()..].to_string()))];
+            let fields = match serde_json::from_slice::<serde_json::Value>(&value) {
+                Ok(serde_json::Value::Object(map)) => map
+                    .into_iter()
+                    .map(|(k, v)| (k, json_to_sql(v)))
+                    .collect::<Vec<_>>(),
+                _ => vec![(
+                    "value".to_string(),
+                    match String::from_utf8(value) {
+                        Ok(s) => SqlValue::Text(s),
+                        Err(e) => SqlValue::Binary(e.into_bytes()),
+                    },
+                )],
+            };
+            for (field, v) in fields {
+                let idx = match names.iter().position(|n| *n == field) {
+                    Some(i) => i,
+                    None => {
+                        names.push(field);
+                        names.len() - 1
+                    }
+                };
+                row.push((idx, v));
+            }
+            rows.push(row);
+        }
+
+        let columns = Arc::new(names);
+        let mut batches = Vec::new();
+        for chunk in rows.chunks(batch_size.max(1)) {
+            let mut dense = vec![vec![SqlValue::Null; columns.len()]; chunk.len()];
+            for (dst, src) in dense.iter_mut().zip(chunk) {
+                for (idx, v) in src {
+                    dst[*idx] = v.clone();
+                }
+            }
+            batches.push(ColumnBatch::from_rows(Arc::clone(&columns), &dense)?);
+        }
+        Ok((columns, batches))
+    }
+}
+
+impl BatchSource for KvTableSource {
+    fn scan(&self, table: &str, batch_size: usize) -> Result<(Arc<Vec<String>>, Vec<ColumnBatch>), MantisError> {
+        let prefix = format!("{}/", table);
+        let entries = self.storage.scan_prefix(&prefix);
+        Self::entries_to_batches(&prefix, entries, batch_size)
+    }
+
+    /// Rows are stored under their key, so `key = ...` is a point read
+    fn lookup(
+        &self,
+        table: &str,
+        column: &str,
+        values: &[SqlValue],
+        batch_size: usize,
+    ) -> Option<Result<(Arc<Vec<String>>, Vec<ColumnBatch>), MantisError>> {
+        if !column.eq_ignore_ascii_case("key") {
+            return None;
+        }
+        let prefix = format!("{}/", table);
+        let mut entries = Vec::with_capacity(values.len());
+        for value in values {
+            let key = match value {
+                SqlValue::Text(s) | SqlValue::Varchar(s) | SqlValue::Char(s) => s.clone(),
+                SqlValue::Integer(n) => n.to_string(),
+                SqlValue::BigInt(n) => n.to_string(),
+                SqlValue::SmallInt(n) => n.to_string(),
+                // Keys are text, so nothing else can match
+                _ => continue,
+            };
+            let full = format!("{}{}", prefix, key);
+            if entries.iter().any(|(k, _): &(String, Vec<u8>)| *k == full) {
+                continue;
+            }
+            if let Ok(value) = self.storage.get_string(&full) {
+                entries.push((full, value));
+            }
+        }
+        Some(Self::entries_to_batches(&prefix, entries, batch_size))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::columnar_engine::ColumnValue;
+    use std::collections::HashMap;
+
+    fn ident(name: &str) -> Box<Expression> {
+        Box::new(Expression::Identifier(name.to_string()))
+    }
+
+    fn lit(v: SqlValue) -> Box<Expression> {
+        Box::new(Expression::Literal(v))
+    }
+
+    fn test_store() -> Arc<ColumnStore> {
+        let store = Arc::new(ColumnStore::new());
+        store.create_table("events".to_string()).unwrap();
+        store
+            .get_table_mut("events", |t| {
+                t.add_column("id".to_string(), ColumnType::Int64);
+                t.add_column("kind".to_string(), ColumnType::String);
+                for i in 0..100i64 {
+                    let mut row = HashMap::new();
+                    row.insert("id".to_string(), ColumnValue::Int64(if i == 7 { None } else { Some(i) }));
+                    let kind = if i % 2 == 0 { "even" } else { "odd" };
+                    row.insert("kind".to_string(), ColumnValue::String(Some(kind.to_string())));
+                    t.append_row(row).unwrap();
+                }
+            })
+            .unwrap();
+        store
+    }
+
+    #[test]
+    fn test_column_store_scan_batches() {
+        let source = ColumnStoreSource::new(test_store());
+        let (columns, batches) = source.scan("events", 32).unwrap();
+
+        assert_eq!(*columns, vec!["id".to_string(), "kind".to_string()]);
+        assert_eq!(batches.iter().map(|b| b.num_rows()).collect::<Vec<_>>(), vec![32, 32, 32, 4]);
+        assert_eq!(batches[0].column(0).value(7), SqlValue::Null);
+        assert_eq!(batches[1].column(1).value(0), SqlValue::Text("even".to_string()));
+    }
+
+    #[test]
+    fn test_filter_selection() {
+        let source = ColumnStoreSource::new(test_store());
+        let (columns, batches) = source.scan("events", 1000).unwrap();
+
+        // id >= 10 AND id < 20 AND kind = 'odd'
+        let expr = Expression::BinaryOp {
+            left: Box::new(Expression::Between {
+                expr: ident("id"),
+                low: lit(SqlValue::Integer(10)),
+                high: lit(SqlValue::Integer(19)),
+                negated: false,
+            }),
+            op: BinaryOperator::And,
+            right: Box::new(Expression::BinaryOp {
+                left: ident("kind"),
+                op: BinaryOperator::Equal,
+                right: lit(SqlValue::Text("odd".to_string())),
+            }),
+        };
+        let predicate = compile(&expr, &columns).unwrap();
+        let selected = predicate.select(&batches[0]);
+        assert_eq!(selected, vec![11, 13, 15, 17, 19]);
+
+        // NULL ids never satisfy a comparison
+        let lt = compile(
+            &Expression::BinaryOp {
+                left: ident("id"),
+                op: BinaryOperator::Less,
+                right: lit(SqlValue::BigInt(10)),
+            },
+            &columns,
+        )
+        .unwrap();
+        assert_eq!(lt.select(&batches[0]).len(), 9);
+    }
+
+    #[test]
+    fn test_projection_kernels() {
+        let columns = Arc::new(vec!["a".to_string(), "b".to_string()]);
+        let rows = vec![
+            vec![SqlValue::BigInt(1), SqlValue::Double(0.5)],
+            vec![SqlValue::Null, SqlValue::Double(1.5)],
+            vec![SqlValue::BigInt(3), SqlValue::Null],
+        ];
+        let batch = ColumnBatch::from_rows(Arc::clone(&columns), &rows).unwrap();
+        let sum = compile(
+            &Expression::BinaryOp {
+                left: ident("a"),
+                op: BinaryOperator::Add,
+                right: ident("b"),
+            },
+            &columns,
+        )
+        .unwrap();
+        let doubled = compile(
+            &Expression::BinaryOp {
+                left: ident("a"),
+                op: BinaryOperator::Multiply,
+                right: lit(SqlValue::Integer(2)),
+            },
+            &columns,
+        )
+        .unwrap();
+
+        let out = batch
+            .project(Arc::new(vec!["sum".to_string(), "doubled".to_string()]), &[sum, doubled])
+            .unwrap();
+        let mut result = Vec::new();
+        out.append_rows(&mut result);
+        assert_eq!(
+            result,
+            vec![
+                vec![SqlValue::Double(1.5), SqlValue::BigInt(2)],
+                vec![SqlValue::Null, SqlValue::Null],
+                vec![SqlValue::Null, SqlValue::BigInt(6)],
+            ]
+        );
+    }
+
+    #[test]
+    fn test_kv_source_and_row_fallback() {
+        let storage = LockFreeStorage::new(1024).unwrap();
+        storage.put(b"users/1", br#"{"name":"ada","age":36}"#).unwrap();
+        storage.put(b"users/2", br#"{"name":"bob"}"#).unwrap();
+        storage.put(b"other/1", br#"{"name":"x"}"#).unwrap();
+
+        let source = KvTableSource::new(storage);
+        let (columns, batches) = source.scan("users", 10).unwrap();
+        assert_eq!(columns.len(), 3);
+        assert_eq!(columns[0], "key");
+        assert_eq!(batches[0].num_rows(), 2);
+
+        let like = compile(
+            &Expression::Like {
+                expr: Box::new(Expression::FunctionCall {
+                    name: "upper".to_string(),
+                    args: vec![Expression::Identifier("name".to_string())],
+                }),
+                pattern: lit(SqlValue::Text("A_%".to_string())),
+                negated: false,
+            },
+            &columns,
+        )
+        .unwrap();
+        assert_eq!(like.select(&batches[0]), vec![0]);
+        assert!(compile(&Expression::Identifier("missing".to_string()), &columns).is_err());
+    }
+}
@@ -164,6 +164,189 @@ func (kvs *KeyValueStore) Exists(ctx context.Context, key string) (bool, error)
 	return true, nil
 }
 
+// KVOp is one operation of a key-value batch
+type KVOp struct {
+	Type  string // "get", "set" or "delete"
+	Key   string
+	Value []byte
+	TTL   time.Duration
+}
+
+// KVOpResult is the outcome of one batch operation; Value is set for gets
+type KVOpResult struct {
+	Value []byte
+	Err   error
+}
+
+// encodeKV serializes a value the way Set stores it
+func encodeKV(key string, value []byte, ttl time.Duration) (string, error) {
+	var kv *models.KeyValue
+	if ttl > 0 {
+		kv = models.NewKeyValueWithTTL(key, value, int64(ttl.Seconds()))
+	} else {
+		kv = models.NewKeyValue(key, value)
+	}
+	data, err := kv.ToJSON()
+	if err != nil {
+		return "", fmt.Errorf("failed to serialize key-value: %v", err)
+	}
+	return string(data), nil
+}
+
+// BatchGet reads keys with one storage batch read, returning a result per
+// key in order. Unlike Get it does not fill the cache, so bulk reads do not
+// evict the hot set.
+func (kvs *KeyValueStore) BatchGet(ctx context.Context, keys []string) ([]KVOpResult, error) {
+	results := make([]KVOpResult, len(keys))
+	misses := make([]string, 0, len(keys))
+	for i, key := range keys {
+		if cached, found := kvs.cache.Get(ctx, fmt.Sprintf("cache:kv:%s", key)); found {
+			if data, ok := cached.([]byte); ok {
+				results[i].Value = data
+				continue
+			}
+		}
+		misses = append(misses, fmt.Sprintf("kv:%s", key))
+	}
+	if len(misses) == 0 {
+		return results, nil
+	}
+
+	values, err := kvs.storage.BatchGet(ctx, misses)
+	if err != nil {
+		return nil, fmt.Errorf("failed to read keys: %v", err)
+	}
+
+	var expired []string
+	for i, key := range keys {
+		if results[i].Value != nil {
+			continue
+		}
+		data, ok := values[fmt.Sprintf("kv:%s", key)]
+		if !ok {
+			results[i].Err = fmt.Errorf("key not found: %s", key)
+			continue
+		}
+		kv, err := models.KVFromJSON([]byte(data))
+		if err != nil {
+			results[i].Err = fmt.Errorf("failed to deserialize key-value: %v", err)
+			continue
+		}
+		if kv.IsExpired() {
+			expired = append(expired, key)
+			results[i].Err = fmt.Errorf("key expired: %s", key)
+			continue
+		}
+		results[i].Value = kv.Value
+	}
+	if len(expired) > 0 {
+		kvs.BatchDelete(ctx, expired)
+	}
+	return results, nil
+}
+
+// BatchSet stores ops, all of type "set", with one storage batch write.
+// A key set twice keeps the later value.
+func (kvs *KeyValueStore) BatchSet(ctx context.Context, ops []KVOp) error {
+	pairs := make(map[string]string, len(ops))
+	for _, op := range ops {
+		data, err := encodeKV(op.Key, op.Value, op.TTL)
+		if err != nil {
+			return err
+		}
+		pairs[fmt.Sprintf("kv:%s", op.Key)] = data
+	}
+	if err := kvs.storage.BatchPut(ctx, pairs); err != nil {
+		return fmt.Errorf("failed to store key-values: %v", err)
+	}
+	for _, op := range ops {
+		kvs.cache.Delete(ctx, fmt.Sprintf("cache:kv:%s", op.Key))
+	}
+	return nil
+}
+
+// BatchDelete removes keys with one storage batch delete
+func (kvs *KeyValueStore) BatchDelete(ctx context.Context, keys []string) error {
+	storageKeys := make([]string, len(keys))
+	for i, key := range keys {
+		storageKeys[i] = fmt.Sprintf("kv:%s", key)
+	}
+	if err := kvs.storage.BatchDelete(ctx, storageKeys); err != nil {
+		return fmt.Errorf("failed to delete keys: %v", err)
+	}
+	for _, key := range keys {
+		kvs.cache.Delete(ctx, fmt.Sprintf("cache:kv:%s", key))
+	}
+	return nil
+}
+
+// ApplyAtomic runs ops in order inside one storage transaction, so the
+// writes become visible together when it commits. Reads see the writes
+// queued before them. If any operation fails nothing is written, and the
+// returned error is the first failure.
+func (kvs *KeyValueStore) ApplyAtomic(ctx context.Context, ops []KVOp) ([]KVOpResult, error) {
+	tx, err := kvs.storage.BeginTransaction(ctx)
+	if err != nil {
+		return nil, fmt.Errorf("failed to begin transaction: %v", err)
+	}
+
+	results := make([]KVOpResult, len(ops))
+	var firstErr error
+	for i, op := range ops {
+		storageKey := fmt.Sprintf("kv:%s", op.Key)
+		switch op.Type {
+		case "get":
+			data, err := tx.Get(storageKey)
+			if err != nil {
+				results[i].Err = fmt.Errorf("key not found: %s", op.Key)
+				break
+			}
+			kv, err := models.KVFromJSON([]byte(data))
+			if err != nil {
+				results[i].Err = fmt.Errorf("failed to deserialize key-value: %v", err)
+				break
+			}
+			if kv.IsExpired() {
+				tx.Delete(storageKey)
+				results[i].Err = fmt.Errorf("key expired: %s", op.Key)
+				break
+			}
+			results[i].Value = kv.Value
+		case "set":
+			data, err := encodeKV(op.Key, op.Value, op.TTL)
+			if err == nil {
+				err = tx.Put(storageKey, data)
+			}
+			if err != nil {
+				results[i].Err = fmt.Errorf("failed to set key: %v", err)
+			}
+		case "delete":
+			if err := tx.Delete(storageKey); err != nil {
+				results[i].Err = fmt.Errorf("failed to delete key: %v", err)
+			}
+		default:
+			results[i].Err = fmt.Errorf("unsupported operation type: %s", op.Type)
+		}
+		if results[i].Err != nil && firstErr == nil {
+			firstErr = results[i].Err
+		}
+	}
+
+	if firstErr != nil {
+		tx.Rollback()
+		return results, firstErr
+	}
+	if err := tx.Commit(); err != nil {
+		return results, fmt.Errorf("failed to commit transaction: %v", err)
+	}
+	for _, op := range ops {
+		if op.Type != "get" {
+			kvs.cache.Delete(ctx, fmt.Sprintf("cache:kv:%s", op.Key))
+		}
+	}
+	return results, nil
+}
+
 // BeginTransaction starts a new transaction for atomic operations
 func (kvs *KeyValueStore) BeginTransaction(ctx context.Context) (TransactionWrapper, error) {
 	tx, err := kvs.storage.BeginTransaction(ctx)
@@ -0,0 +1,114 @@
+package store
+
+import (
+	"context"
+	"testing"
+	"time"
+
+	"mantisDB/cache"
+	"mantisDB/storage"
+)
+
+func newTestKV(t *testing.T) (*KeyValueStore, *storage.PureGoStorageEngine) {
+	t.Helper()
+	engine := storage.NewPureGoStorageEngine(storage.StorageConfig{})
+	cacheManager := cache.NewCacheManager(cache.CacheConfig{
+		MaxSize:         1 << 20,
+		DefaultTTL:      time.Hour,
+		CleanupInterval: time.Minute,
+		EvictionPolicy:  "lru",
+	})
+	return NewMantisStore(engine, cacheManager).KV(), engine
+}
+
+func TestBatchSetKeepsLastValue(t *testing.T) {
+	ctx := context.Background()
+	kv, _ := newTestKV(t)
+
+	// Cache the old value so the batch has to invalidate it
+	if err := kv.Set(ctx, "a", []byte("old"), 0); err != nil {
+		t.Fatal(err)
+	}
+	if _, err := kv.Get(ctx, "a"); err != nil {
+		t.Fatal(err)
+	}
+
+	err := kv.BatchSet(ctx, []KVOp{
+		{Type: "set", Key: "a", Value: []byte("first")},
+		{Type: "set", Key: "b", Value: []byte("b")},
+		{Type: "set", Key: "a", Value: []byte("second")},
+	})
+	if err != nil {
+		t.Fatal(err)
+	}
+	if value, err := kv.Get(ctx, "a"); err != nil || string(value) != "second" {
+		t.Errorf("a = %q, %v; want the later value", value, err)
+	}
+
+	results, err := kv.BatchGet(ctx, []string{"a", "b", "missing"})
+	if err != nil {
+		t.Fatal(err)
+	}
+	if string(results[0].Value) != "second" || string(results[1].Value) != "b" || results[2].Err == nil {
+		t.Errorf("BatchGet = %+v", results)
+	}
+}
+
+func TestApplyAtomicRollsBackOnFailure(t *testing.T) {
+	ctx := context.Background()
+	kv, engine := newTestKV(t)
+	if err := kv.Set(ctx, "keep", []byte("v"), 0); err != nil {
+		t.Fatal(err)
+	}
+
+	results, err := kv.ApplyAtomic(ctx, []KVOp{
+		{Type: "set", Key: "a", Value: []byte("1")},
+		{Type: "delete", Key: "keep"},
+		{Type: "get", Key: "a"},
+		{Type: "get", Key: "missing"},
+		{Type: "set", Key: "b", Value: []byte("2")},
+	})
+	if err == nil {
+		t.Fatal("ApplyAtomic succeeded despite a failed get")
+	}
+	// The read inside the transaction saw the write queued before it
+	if string(results[2].Value) != "1" || results[3].Err == nil {
+		t.Errorf("results %+v", results)
+	}
+
+	for _, key := range []string{"kv:a", "kv:b"} {
+		if _, err := engine.Get(ctx, key); err == nil {
+			t.Errorf("%s was written by a rolled back batch", key)
+		}
+	}
+	if value, err := kv.Get(ctx, "keep"); err != nil || string(value) != "v" {
+		t.Errorf("keep = %q, %v; the rolled back delete was applied", value, err)
+	}
+}
+
+func TestApplyAtomicInvalidatesCacheOnCommit(t *testing.T) {
+	ctx := context.Background()
+	kv, _ := newTestKV(t)
+	for _, key := range []string{"a", "gone"} {
+		if err := kv.Set(ctx, key, []byte("old"), 0); err != nil {
+			t.Fatal(err)
+		}
+		if _, err := kv.Get(ctx, key); err != nil {
+			t.Fatal(err)
+		}
+	}
+
+	_, err := kv.ApplyAtomic(ctx, []KVOp{
+		{Type: "set", Key: "a", Value: []byte("new")},
+		{Type: "delete", Key: "gone"},
+	})
+	if err != nil {
+		t.Fatal(err)
+	}
+	if value, err := kv.Get(ctx, "a"); err != nil || string(value) != "new" {
+		t.Errorf("a = %q, %v; want the committed value", value, err)
+	}
+	if value, err := kv.Get(ctx, "gone"); err == nil {
+		t.Errorf("gone = %q after a committed delete", value)
+	}
+}
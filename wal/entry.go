@@ -1,10 +1,10 @@
 package wal
 
 import (
-	"bytes"
 	"encoding/binary"
 	"fmt"
 	"hash/crc32"
+	"slices"
 	"time"
 )
 
@@ -54,7 +54,39 @@ type WALEntry struct {
 	Checksum  uint32 // Entry integrity checksum
 }
 
-// WALEntryHeader represents the fixed-size header of a WAL entry
+// The WAL record format. Version 2 records are laid out as
+//
+//	0   checksum     uint32  CRC32C of bytes 4 to the end of the record
+//	4   format       uint32  walFormatV2
+//	8   LSN          uint64
+//	16  TxnID        uint64
+//	24  Timestamp    int64   Unix nanoseconds, 0 for the zero time
+//	32  OpType       uint32
+//	36  key length   uint32
+//	40  value length uint32
+//	44  old length   uint32
+//	48  key, value, old value
+//
+// all little endian. Version 1 records (WALEntryHeader followed by the
+// length-prefixed key, value and old value) start with an LSN instead; the
+// format word sits where a version 1 LSN keeps its high 32 bits, which no
+// real LSN reaches, so both versions can be read from the same segment.
+const (
+	WALFormatVersion = 2
+
+	walFormatV2        uint32 = 0x024C4157 // "WAL\x02"
+	walRecordHeaderLen        = 48
+
+	// MinWALRecordSize is the size of the smallest record of any version.
+	// Its first MinWALRecordSize bytes are enough for WALRecordSize.
+	MinWALRecordSize = 48
+)
+
+// castagnoli selects CRC32C, which the hash/crc32 package computes with
+// the SSE4.2 CRC32 instruction on amd64 and the CRC extension on arm64.
+var castagnoli = crc32.MakeTable(crc32.Castagnoli)
+
+// WALEntryHeader is the fixed-size header of a version 1 WAL entry
 type WALEntryHeader struct {
 	LSN        uint64 // 8 bytes
 	TxnID      uint64 // 8 bytes
@@ -70,166 +102,162 @@ const (
 
 // Serialize converts a WAL entry to binary format
 func (entry *WALEntry) Serialize() ([]byte, error) {
-	var buf bytes.Buffer
+	return entry.AppendTo(nil), nil
+}
 
-	// Serialize operation payload first to calculate length
-	payload, err := entry.serializePayload()
-	if err != nil {
-		return nil, err
-	}
+// AppendTo appends the entry's record to dst and returns the extended
+// slice. It does not allocate when dst has room for the record.
+func (entry *WALEntry) AppendTo(dst []byte) []byte {
+	op := &entry.Operation
+	start := len(dst)
+	dst = slices.Grow(dst, walRecordHeaderLen+len(op.Key)+len(op.Value)+len(op.OldValue))
+
+	le := binary.LittleEndian
+	dst = le.AppendUint32(dst, 0) // checksum, filled in below
+	dst = le.AppendUint32(dst, walFormatV2)
+	dst = le.AppendUint64(dst, entry.LSN)
+	dst = le.AppendUint64(dst, entry.TxnID)
+	dst = le.AppendUint64(dst, uint64(timestampNanos(entry.Timestamp)))
+	dst = le.AppendUint32(dst, uint32(op.Type))
+	dst = le.AppendUint32(dst, uint32(len(op.Key)))
+	dst = le.AppendUint32(dst, uint32(len(op.Value)))
+	dst = le.AppendUint32(dst, uint32(len(op.OldValue)))
+	dst = append(dst, op.Key...)
+	dst = append(dst, op.Value...)
+	dst = append(dst, op.OldValue...)
+
+	record := dst[start:]
+	le.PutUint32(record, crc32.Checksum(record[4:], castagnoli))
+	return dst
+}
 
-	// Create header
-	header := WALEntryHeader{
-		LSN:        entry.LSN,
-		TxnID:      entry.TxnID,
-		OpType:     uint32(entry.Operation.Type),
-		Timestamp:  entry.Timestamp.Unix(),
-		PayloadLen: uint32(len(payload)),
-		Checksum:   0, // Will be calculated after serialization
+// WALRecordSize returns the total size of the record that prefix starts,
+// given at least MinWALRecordSize bytes of it.
+func WALRecordSize(prefix []byte) (int, error) {
+	if len(prefix) < MinWALRecordSize {
+		return 0, ErrInvalidWALEntry
 	}
-
-	// Write header
-	if err := binary.Write(&buf, binary.LittleEndian, header); err != nil {
-		return nil, err
+	le := binary.LittleEndian
+	if le.Uint32(prefix[4:]) == walFormatV2 {
+		return walRecordHeaderLen + int(le.Uint32(prefix[36:])) + int(le.Uint32(prefix[40:])) + int(le.Uint32(prefix[44:])), nil
 	}
-
-	// Write payload
-	buf.Write(payload)
-
-	// Calculate and update checksum
-	data := buf.Bytes()
-	// Calculate checksum on all data except the checksum field itself (bytes 32-35 in header)
-	checksumData := make([]byte, 0, len(data))
-	checksumData = append(checksumData, data[:32]...) // Header before checksum
-	checksumData = append(checksumData, data[36:]...) // Header after checksum + payload
-	checksum := crc32.ChecksumIEEE(checksumData)
-	binary.LittleEndian.PutUint32(data[32:36], checksum) // Update checksum in header
-
-	return data, nil
+	return WALEntryHeaderSize + int(le.Uint32(prefix[28:])), nil
 }
 
-// serializePayload serializes the operation payload
-func (entry *WALEntry) serializePayload() ([]byte, error) {
-	var buf bytes.Buffer
+// DeserializeWALEntry decodes the record at the start of data. The entry's
+// Value and OldValue are slices of data, not copies, so data must not be
+// reused while the entry is in use.
+func DeserializeWALEntry(data []byte) (*WALEntry, error) {
+	if len(data) >= 8 && binary.LittleEndian.Uint32(data[4:]) == walFormatV2 {
+		return deserializeV2(data)
+	}
+	return deserializeV1(data)
+}
 
-	// Write key length and key
-	keyBytes := []byte(entry.Operation.Key)
-	if err := binary.Write(&buf, binary.LittleEndian, uint32(len(keyBytes))); err != nil {
-		return nil, err
+func deserializeV2(data []byte) (*WALEntry, error) {
+	size, err := WALRecordSize(data)
+	if err != nil || len(data) < size {
+		return nil, ErrInvalidWALEntry
 	}
-	buf.Write(keyBytes)
+	record := data[:size]
 
-	// Write value length and value
-	if err := binary.Write(&buf, binary.LittleEndian, uint32(len(entry.Operation.Value))); err != nil {
-		return nil, err
+	le := binary.LittleEndian
+	checksum := le.Uint32(record)
+	if crc32.Checksum(record[4:], castagnoli) != checksum {
+		return nil, ErrChecksumMismatch
 	}
-	buf.Write(entry.Operation.Value)
 
-	// Write old value length and old value (for rollback)
-	if err := binary.Write(&buf, binary.LittleEndian, uint32(len(entry.Operation.OldValue))); err != nil {
-		return nil, err
+	keyEnd := walRecordHeaderLen + int(le.Uint32(record[36:]))
+	valueEnd := keyEnd + int(le.Uint32(record[40:]))
+	return &WALEntry{
+		LSN:   le.Uint64(record[8:]),
+		TxnID: le.Uint64(record[16:]),
+		Operation: Operation{
+			Type:     OperationType(le.Uint32(record[32:])),
+			Key:      string(record[walRecordHeaderLen:keyEnd]),
+			Value:    record[keyEnd:valueEnd:valueEnd],
+			OldValue: record[valueEnd:size:size],
+		},
+		Timestamp: timestampFromNanos(int64(le.Uint64(record[24:]))),
+		Checksum:  checksum,
+	}, nil
+}
+
+// timestampNanos returns t in Unix nanoseconds. The zero time lies outside
+// the range UnixNano can represent, so it is stored as 0.
+func timestampNanos(t time.Time) int64 {
+	if t.IsZero() {
+		return 0
 	}
-	buf.Write(entry.Operation.OldValue)
+	return t.UnixNano()
+}
 
-	return buf.Bytes(), nil
+// timestampFromNanos reverses timestampNanos.
+func timestampFromNanos(nanos int64) time.Time {
+	if nanos == 0 {
+		return time.Time{}
+	}
+	return time.Unix(0, nanos)
 }
 
-// Deserialize converts binary data back to a WAL entry
-func DeserializeWALEntry(data []byte) (*WALEntry, error) {
+// deserializeV1 decodes a version 1 record: a WALEntryHeader whose CRC32
+// (IEEE) covers everything but the checksum field itself
+func deserializeV1(data []byte) (*WALEntry, error) {
 	if len(data) < WALEntryHeaderSize {
 		return nil, ErrInvalidWALEntry
 	}
 
-	// Read header
-	var header WALEntryHeader
-	buf := bytes.NewReader(data[:WALEntryHeaderSize])
-	if err := binary.Read(buf, binary.LittleEndian, &header); err != nil {
-		return nil, err
-	}
-
-	// Verify payload length
-	expectedTotalLen := WALEntryHeaderSize + int(header.PayloadLen)
-	if len(data) < expectedTotalLen {
+	le := binary.LittleEndian
+	payloadLen := le.Uint32(data[28:])
+	size := WALEntryHeaderSize + int(payloadLen)
+	if len(data) < size {
 		return nil, ErrInvalidWALEntry
 	}
 
-	// Verify checksum only on the expected data length
-	expectedChecksum := header.Checksum
-	// Calculate checksum on all data except the checksum field itself (bytes 32-35 in header)
-	checksumData := make([]byte, 0, expectedTotalLen)
-	checksumData = append(checksumData, data[:32]...)                 // Header before checksum
-	checksumData = append(checksumData, data[36:expectedTotalLen]...) // Header after checksum + payload
-	actualChecksum := crc32.ChecksumIEEE(checksumData)
-	if expectedChecksum != actualChecksum {
+	checksum := le.Uint32(data[32:])
+	actual := crc32.ChecksumIEEE(data[:32])
+	actual = crc32.Update(actual, crc32.IEEETable, data[WALEntryHeaderSize:size])
+	if checksum != actual {
 		return nil, ErrChecksumMismatch
 	}
 
-	// Deserialize payload
-	payload := data[WALEntryHeaderSize : WALEntryHeaderSize+header.PayloadLen]
-	operation, err := deserializePayload(payload, OperationType(header.OpType))
+	operation, err := deserializePayload(data[WALEntryHeaderSize:size], OperationType(le.Uint32(data[16:])))
 	if err != nil {
 		return nil, err
 	}
 
-	entry := &WALEntry{
-		LSN:       header.LSN,
-		TxnID:     header.TxnID,
+	return &WALEntry{
+		LSN:       le.Uint64(data[0:]),
+		TxnID:     le.Uint64(data[8:]),
 		Operation: *operation,
-		Timestamp: time.Unix(header.Timestamp, 0),
-		Checksum:  header.Checksum,
-	}
-
-	return entry, nil
+		Timestamp: time.Unix(int64(le.Uint64(data[20:])), 0),
+		Checksum:  checksum,
+	}, nil
 }
 
-// deserializePayload deserializes the operation payload
+// deserializePayload slices the length-prefixed key, value and old value
+// out of a version 1 payload
 func deserializePayload(data []byte, opType OperationType) (*Operation, error) {
-	buf := bytes.NewReader(data)
-
-	// Read key
-	var keyLen uint32
-	if err := binary.Read(buf, binary.LittleEndian, &keyLen); err != nil {
-		return nil, err
-	}
-	keyBytes := make([]byte, keyLen)
-	if keyLen > 0 {
-		if _, err := buf.Read(keyBytes); err != nil {
-			return nil, err
-		}
-	}
-
-	// Read value
-	var valueLen uint32
-	if err := binary.Read(buf, binary.LittleEndian, &valueLen); err != nil {
-		return nil, err
-	}
-	value := make([]byte, valueLen)
-	if valueLen > 0 {
-		if _, err := buf.Read(value); err != nil {
-			return nil, err
+	fields := [3][]byte{}
+	for i := range fields {
+		if len(data) < 4 {
+			return nil, ErrInvalidWALEntry
 		}
-	}
-
-	// Read old value
-	var oldValueLen uint32
-	if err := binary.Read(buf, binary.LittleEndian, &oldValueLen); err != nil {
-		return nil, err
-	}
-	oldValue := make([]byte, oldValueLen)
-	if oldValueLen > 0 {
-		if _, err := buf.Read(oldValue); err != nil {
-			return nil, err
+		n := binary.LittleEndian.Uint32(data)
+		data = data[4:]
+		if uint64(len(data)) < uint64(n) {
+			return nil, ErrInvalidWALEntry
 		}
+		fields[i] = data[:n:n]
+		data = data[n:]
 	}
 
-	operation := &Operation{
+	return &Operation{
 		Type:     opType,
-		Key:      string(keyBytes),
-		Value:    value,
-		OldValue: oldValue,
-	}
-
-	return operation, nil
+		Key:      string(fields[0]),
+		Value:    fields[1],
+		OldValue: fields[2],
+	}, nil
 }
 
 // CalculateChecksum calculates CRC32 checksum for data integrity
@@ -1,6 +1,11 @@
 package wal
 
 import (
+	"bytes"
+	"encoding/binary"
+	"hash/crc32"
+	"os"
+	"path/filepath"
 	"testing"
 	"time"
 )
@@ -279,3 +284,158 @@ func TestInvalidWALEntryDeserialization(t *testing.T) {
 		t.Errorf("Expected ErrInvalidWALEntry for truncated data, got: %v", err)
 	}
 }
+
+// serializeV1 encodes an entry in the version 1 format, as older releases
+// wrote it
+func serializeV1(entry *WALEntry) []byte {
+	var payload bytes.Buffer
+	for _, field := range [][]byte{[]byte(entry.Operation.Key), entry.Operation.Value, entry.Operation.OldValue} {
+		binary.Write(&payload, binary.LittleEndian, uint32(len(field)))
+		payload.Write(field)
+	}
+
+	var buf bytes.Buffer
+	binary.Write(&buf, binary.LittleEndian, WALEntryHeader{
+		LSN:        entry.LSN,
+		TxnID:      entry.TxnID,
+		OpType:     uint32(entry.Operation.Type),
+		Timestamp:  entry.Timestamp.Unix(),
+		PayloadLen: uint32(payload.Len()),
+	})
+	buf.Write(payload.Bytes())
+
+	data := buf.Bytes()
+	checksum := crc32.ChecksumIEEE(append(append([]byte{}, data[:32]...), data[36:]...))
+	binary.LittleEndian.PutUint32(data[32:], checksum)
+	return data
+}
+
+func TestWALEntryVersion1Compatibility(t *testing.T) {
+	entry := &WALEntry{
+		LSN:       7,
+		TxnID:     3,
+		Operation: Operation{Type: OpUpdate, Key: "key", Value: []byte("new"), OldValue: []byte("old")},
+		Timestamp: time.Unix(1700000000, 0),
+	}
+
+	v1 := serializeV1(entry)
+	decoded, err := DeserializeWALEntry(v1)
+	if err != nil {
+		t.Fatalf("Failed to decode version 1 entry: %v", err)
+	}
+	if decoded.LSN != 7 || decoded.TxnID != 3 || decoded.Operation.Key != "key" ||
+		string(decoded.Operation.Value) != "new" || string(decoded.Operation.OldValue) != "old" ||
+		!decoded.Timestamp.Equal(entry.Timestamp) {
+		t.Errorf("Version 1 entry decoded as %+v", decoded)
+	}
+	if size, err := WALRecordSize(v1); err != nil || size != len(v1) {
+		t.Errorf("WALRecordSize of version 1 entry = %d, %v; want %d", size, err, len(v1))
+	}
+
+	v1[len(v1)-1] ^= 0xFF
+	if _, err := DeserializeWALEntry(v1); err != ErrChecksumMismatch {
+		t.Errorf("Expected checksum mismatch for corrupted version 1 entry, got: %v", err)
+	}
+
+	// A segment written before the upgrade and appended to after it reads
+	// back whole
+	tempDir, err := os.MkdirTemp("", "wal_v1_test")
+	if err != nil {
+		t.Fatalf("Failed to create temp dir: %v", err)
+	}
+	defer os.RemoveAll(tempDir)
+
+	v1[len(v1)-1] ^= 0xFF
+	entry.LSN = 8
+	v2, _ := entry.Serialize()
+	segment := append(append([]byte{}, v1...), v2...)
+	if err := os.WriteFile(filepath.Join(tempDir, "wal-1.log"), segment, 0644); err != nil {
+		t.Fatalf("Failed to write segment: %v", err)
+	}
+	reader, err := NewWALReader(tempDir)
+	if err != nil {
+		t.Fatalf("Failed to create WAL reader: %v", err)
+	}
+	entries, err := reader.ReadFromLSN(1)
+	if err != nil {
+		t.Fatalf("Failed to read mixed segment: %v", err)
+	}
+	if len(entries) != 2 || entries[0].LSN != 7 || entries[1].LSN != 8 {
+		t.Errorf("Mixed segment read as %d entries", len(entries))
+	}
+}
+
+func TestWALEntryAppendToDoesNotAllocate(t *testing.T) {
+	entry := &WALEntry{
+		LSN:       1,
+		TxnID:     1,
+		Operation: Operation{Type: OpInsert, Key: "key", Value: make([]byte, 256)},
+		Timestamp: time.Now(),
+	}
+	buf := make([]byte, 0, 4096)
+	allocs := testing.AllocsPerRun(100, func() {
+		buf = entry.AppendTo(buf[:0])
+	})
+	if allocs != 0 {
+		t.Errorf("AppendTo allocated %v times per entry", allocs)
+	}
+
+	// Decoding slices the values out of the record
+	decoded, err := DeserializeWALEntry(buf)
+	if err != nil {
+		t.Fatalf("Failed to decode entry: %v", err)
+	}
+	if &decoded.Operation.Value[0] != &buf[walRecordHeaderLen+len("key")] {
+		t.Error("Decoded value was copied")
+	}
+}
+
+func TestWALEntryZeroTimestamp(t *testing.T) {
+	entry := &WALEntry{
+		LSN:       1,
+		TxnID:     1,
+		Operation: Operation{Type: OpInsert, Key: "key", Value: []byte("value")},
+	}
+
+	data, err := entry.Serialize()
+	if err != nil {
+		t.Fatalf("Failed to serialize WAL entry: %v", err)
+	}
+	if ts := binary.LittleEndian.Uint64(data[24:]); ts != 0 {
+		t.Errorf("Zero timestamp encoded as %d, want 0", ts)
+	}
+
+	deserializedEntry, err := DeserializeWALEntry(data)
+	if err != nil {
+		t.Fatalf("Failed to deserialize WAL entry: %v", err)
+	}
+	if !deserializedEntry.Timestamp.IsZero() {
+		t.Errorf("Zero timestamp decoded as %v", deserializedEntry.Timestamp)
+	}
+
+	// Other timestamps keep their nanoseconds
+	entry.Timestamp = time.Unix(1609459200, 123456789)
+	data, _ = entry.Serialize()
+	deserializedEntry, err = DeserializeWALEntry(data)
+	if err != nil {
+		t.Fatalf("Failed to deserialize WAL entry: %v", err)
+	}
+	if !deserializedEntry.Timestamp.Equal(entry.Timestamp) {
+		t.Errorf("Timestamp mismatch: expected %v, got %v", entry.Timestamp, deserializedEntry.Timestamp)
+	}
+}
+
+func BenchmarkWALEntryAppendTo(b *testing.B) {
+	entry := &WALEntry{
+		LSN:       1,
+		TxnID:     1,
+		Operation: Operation{Type: OpInsert, Key: "user:12345", Value: make([]byte, 256)},
+		Timestamp: time.Now(),
+	}
+	buf := make([]byte, 0, 4096)
+	b.ReportAllocs()
+	for i := 0; i < b.N; i++ {
+		buf = entry.AppendTo(buf[:0])
+	}
+	b.SetBytes(int64(len(buf)))
+}
@@ -14,4 +14,7 @@ var (
 	ErrWALRotationFailed = errors.New("WAL file rotation failed")
 	ErrWALCleanupFailed  = errors.New("WAL cleanup failed")
 	ErrInvalidLSN        = errors.New("invalid log sequence number")
+	ErrWALClosed         = errors.New("WAL file manager is closed")
+
+	errReplayStopped = errors.New("WAL replay stopped")
 )
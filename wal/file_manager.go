@@ -11,9 +11,11 @@ import (
 	"time"
 )
 
-// WALFileManager manages WAL files including writing, rotation, and cleanup
+// WALFileManager manages WAL files including writing, rotation, and cleanup.
+// Writes go through a commit queue drained by a single flusher goroutine,
+// which writes whatever has queued up as one group and syncs it once.
 type WALFileManager struct {
-	mu sync.RWMutex
+	mu sync.RWMutex // guards the files; held by the flusher while it writes
 
 	// Configuration
 	walDir          string        // Directory for WAL files
@@ -27,13 +29,22 @@ type WALFileManager struct {
 	// Current state
 	currentFile    *WALFile      // Current active WAL file
 	currentFileNum uint64        // Current file number
-	nextLSN        uint64        // Next LSN to assign
 	lastSyncTime   time.Time     // Last time we synced to disk
 	syncInterval   time.Duration // How often to sync in async mode
 
 	// File tracking
 	activeFiles   map[uint64]*WALFile // Active WAL files by file number
 	archivedFiles []string            // List of archived file paths
+
+	// Commit queue
+	commitMu     sync.Mutex
+	commitCond   *sync.Cond
+	commitQueue  []*commitRequest // in LSN order; guarded by commitMu
+	commitClosed bool             // guarded by commitMu
+	nextLSN      uint64           // Next LSN to assign; guarded by commitMu
+	flusherDone  chan struct{}
+	stopSync     chan struct{}
+	commitStats  commitStats
 }
 
 // WALFile represents a single WAL file
@@ -118,13 +129,18 @@ func NewWALFileManager(config *WALFileManagerConfig) (*WALFileManager, error) {
 		syncInterval:    config.SyncInterval,
 		activeFiles:     make(map[uint64]*WALFile),
 		nextLSN:         1, // Start from LSN 1
+		flusherDone:     make(chan struct{}),
+		stopSync:        make(chan struct{}),
 	}
+	manager.commitCond = sync.NewCond(&manager.commitMu)
 
 	// Initialize by scanning existing files
 	if err := manager.initialize(); err != nil {
 		return nil, fmt.Errorf("failed to initialize WAL file manager: %w", err)
 	}
 
+	go manager.flusher()
+
 	// Start background sync routine for async mode
 	if config.SyncMode == SyncModeAsync {
 		go manager.backgroundSync()
@@ -215,99 +231,37 @@ func (wfm *WALFileManager) openExistingFile(filePath string, fileNum uint64) (*W
 	return walFile, nil
 }
 
-// createWriter creates the appropriate writer based on sync mode
+// createWriter creates the writer for a WAL file. Writes are buffered in
+// every sync mode; the flusher flushes and syncs at the end of each group
+// that needs it.
 func (wfm *WALFileManager) createWriter(file *os.File) io.Writer {
-	switch wfm.syncMode {
-	case SyncModeSync:
-		return &syncWriter{file: file}
-	case SyncModeAsync, SyncModeBatch:
-		return &bufferedWriter{
-			file:       file,
-			bufferSize: wfm.bufferSize,
-		}
-	default:
-		return file
+	return &bufferedWriter{
+		file:       file,
+		bufferSize: wfm.bufferSize,
 	}
 }
 
-// WriteEntry writes a WAL entry to the current file
+// WriteEntry writes a WAL entry to the current file. It returns once the
+// entry is written, and in SyncModeSync once it is on disk.
 func (wfm *WALFileManager) WriteEntry(entry *WALEntry) error {
-	wfm.mu.Lock()
-	defer wfm.mu.Unlock()
-
-	// Assign LSN if not set
-	if entry.LSN == 0 {
-		entry.LSN = wfm.nextLSN
-		wfm.nextLSN++
-	}
-
-	// Check if we need to rotate the file
-	if wfm.shouldRotate() {
-		if err := wfm.rotateFile(); err != nil {
-			return fmt.Errorf("failed to rotate WAL file: %w", err)
-		}
-	}
-
-	// Serialize the entry
-	data, err := entry.Serialize()
-	if err != nil {
-		return fmt.Errorf("failed to serialize WAL entry: %w", err)
+	if entry == nil {
+		return ErrInvalidWALEntry
 	}
-
-	// Write to current file
-	if err := wfm.currentFile.writeEntry(data, entry.LSN); err != nil {
-		return fmt.Errorf("failed to write WAL entry: %w", err)
-	}
-
-	// Sync if in sync mode
-	if wfm.syncMode == SyncModeSync {
-		if err := wfm.currentFile.sync(); err != nil {
-			return fmt.Errorf("failed to sync WAL file: %w", err)
-		}
-	}
-
-	return nil
+	return wfm.commit([]*WALEntry{entry}, wfm.syncMode == SyncModeSync)
 }
 
-// WriteBatch writes multiple WAL entries as a batch
+// WriteBatch writes multiple WAL entries as a batch. The entries are
+// written contiguously to one file.
 func (wfm *WALFileManager) WriteBatch(entries []*WALEntry) error {
-	wfm.mu.Lock()
-	defer wfm.mu.Unlock()
-
-	for _, entry := range entries {
-		// Assign LSN if not set
-		if entry.LSN == 0 {
-			entry.LSN = wfm.nextLSN
-			wfm.nextLSN++
-		}
-
-		// Check if we need to rotate the file
-		if wfm.shouldRotate() {
-			if err := wfm.rotateFile(); err != nil {
-				return fmt.Errorf("failed to rotate WAL file: %w", err)
-			}
-		}
-
-		// Serialize the entry
-		data, err := entry.Serialize()
-		if err != nil {
-			return fmt.Errorf("failed to serialize WAL entry: %w", err)
-		}
-
-		// Write to current file
-		if err := wfm.currentFile.writeEntry(data, entry.LSN); err != nil {
-			return fmt.Errorf("failed to write WAL entry: %w", err)
-		}
+	if len(entries) == 0 {
+		return fmt.Errorf("%w: empty batch", ErrInvalidWALEntry)
 	}
-
-	// Sync if in batch sync mode
-	if wfm.syncMode == SyncModeBatch {
-		if err := wfm.currentFile.sync(); err != nil {
-			return fmt.Errorf("failed to sync WAL file: %w", err)
+	for _, entry := range entries {
+		if entry == nil {
+			return ErrInvalidWALEntry
 		}
 	}
-
-	return nil
+	return wfm.commit(entries, wfm.syncMode != SyncModeAsync)
 }
 
 // shouldRotate determines if the current file should be rotated
@@ -358,8 +312,7 @@ func (wfm *WALFileManager) rotateFile() error {
 		size:      0,
 		createdAt: time.Now(),
 		lastWrite: time.Now(),
-		minLSN:    wfm.nextLSN,
-		maxLSN:    wfm.nextLSN - 1, // Will be updated on first write
+		// minLSN and maxLSN are set by the first write
 	}
 
 	wfm.currentFile = walFile
@@ -380,17 +333,17 @@ func (wfm *WALFileManager) Sync() error {
 	return wfm.currentFile.sync()
 }
 
-// GetCurrentLSN returns the current LSN
+// GetCurrentLSN returns the last LSN assigned
 func (wfm *WALFileManager) GetCurrentLSN() uint64 {
-	wfm.mu.RLock()
-	defer wfm.mu.RUnlock()
+	wfm.commitMu.Lock()
+	defer wfm.commitMu.Unlock()
 	return wfm.nextLSN - 1
 }
 
 // GetNextLSN returns the next LSN that will be assigned
 func (wfm *WALFileManager) GetNextLSN() uint64 {
-	wfm.mu.RLock()
-	defer wfm.mu.RUnlock()
+	wfm.commitMu.Lock()
+	defer wfm.commitMu.Unlock()
 	return wfm.nextLSN
 }
 
@@ -521,7 +474,13 @@ func (wfm *WALFileManager) backgroundSync() {
 	ticker := time.NewTicker(wfm.syncInterval)
 	defer ticker.Stop()
 
-	for range ticker.C {
+	for {
+		select {
+		case <-ticker.C:
+		case <-wfm.stopSync:
+			return
+		}
+
 		wfm.mu.RLock()
 		currentFile := wfm.currentFile
 		wfm.mu.RUnlock()
@@ -532,8 +491,11 @@ func (wfm *WALFileManager) backgroundSync() {
 	}
 }
 
-// Close closes the WAL file manager and all open files
+// Close writes the queued entries, then closes the WAL file manager and all
+// open files
 func (wfm *WALFileManager) Close() error {
+	wfm.closeCommitQueue()
+
 	wfm.mu.Lock()
 	defer wfm.mu.Unlock()
 
@@ -566,8 +528,9 @@ type WALFileInfo struct {
 	IsCurrent  bool
 }
 
-// writeEntry writes entry data to the WAL file
-func (wf *WALFile) writeEntry(data []byte, lsn uint64) error {
+// writeRecords writes count serialized entries with LSNs minLSN..maxLSN to
+// the WAL file
+func (wf *WALFile) writeRecords(data []byte, minLSN, maxLSN uint64, count int64) error {
 	wf.mu.Lock()
 	defer wf.mu.Unlock()
 
@@ -584,14 +547,14 @@ func (wf *WALFile) writeEntry(data []byte, lsn uint64) error {
 	// Update file metadata
 	wf.size += int64(n)
 	wf.lastWrite = time.Now()
-	wf.entryCount++
+	wf.entryCount += count
 
 	// Update LSN range
-	if wf.minLSN == 0 || lsn < wf.minLSN {
-		wf.minLSN = lsn
+	if wf.minLSN == 0 || minLSN < wf.minLSN {
+		wf.minLSN = minLSN
 	}
-	if lsn > wf.maxLSN {
-		wf.maxLSN = lsn
+	if maxLSN > wf.maxLSN {
+		wf.maxLSN = maxLSN
 	}
 
 	return nil
@@ -607,7 +570,7 @@ func (wf *WALFile) sync() error {
 	}
 
 	// If we have a buffered writer, flush it first
-	if bw, ok := wf.writer.(*bufferedWriter); ok {
+	if bw, ok := wf.writer.(walBuffer); ok {
 		if err := bw.flush(); err != nil {
 			return err
 		}
@@ -627,7 +590,7 @@ func (wf *WALFile) close() error {
 	}
 
 	// Flush any buffered data
-	if bw, ok := wf.writer.(*bufferedWriter); ok {
+	if bw, ok := wf.writer.(walBuffer); ok {
 		if err := bw.flush(); err != nil {
 			return err
 		}
@@ -643,38 +606,34 @@ func (wf *WALFile) close() error {
 	return err
 }
 
-// syncWriter is a writer that syncs after every write
-type syncWriter struct {
-	file *os.File
+// walBuffer is a WAL file writer that holds writes back until flushed
+type walBuffer interface {
+	flush() error
 }
 
-func (sw *syncWriter) Write(data []byte) (int, error) {
-	n, err := sw.file.Write(data)
-	if err != nil {
-		return n, err
-	}
-
-	// Sync after every write
-	if err := sw.file.Sync(); err != nil {
-		return n, err
-	}
-
-	return n, nil
-}
-
-// bufferedWriter is a writer that buffers writes
+// bufferedWriter is a writer that buffers writes. Each Write is one
+// commit's records. A Write that fails before any of its data reaches the
+// file leaves the buffer as it was, so the commits before it can still be
+// flushed; one that fails partway leaves a torn record in the file, and
+// the writer refuses everything after it.
 type bufferedWriter struct {
 	file       *os.File
 	buffer     []byte
 	bufferSize int
 	pos        int
+	flushed    int64 // bytes handed to the file
+	err        error // set once the file holds a torn record
 }
 
 func (bw *bufferedWriter) Write(data []byte) (int, error) {
+	if bw.err != nil {
+		return 0, bw.err
+	}
 	if bw.buffer == nil {
 		bw.buffer = make([]byte, bw.bufferSize)
 	}
 
+	start := bw.flushed + int64(bw.pos)
 	totalWritten := 0
 	remaining := data
 
@@ -695,6 +654,11 @@ func (bw *bufferedWriter) Write(data []byte) (int, error) {
 		// If buffer is full, flush it
 		if bw.pos >= bw.bufferSize {
 			if err := bw.flush(); err != nil {
+				if start >= bw.flushed {
+					bw.pos = int(start - bw.flushed)
+					return 0, err
+				}
+				bw.err = err
 				return totalWritten, err
 			}
 		}
@@ -703,12 +667,18 @@ func (bw *bufferedWriter) Write(data []byte) (int, error) {
 	return totalWritten, nil
 }
 
+// flush writes the buffer to the file. Whatever the file did not take
+// stays buffered for the next flush.
 func (bw *bufferedWriter) flush() error {
+	if bw.err != nil {
+		return bw.err
+	}
 	if bw.pos == 0 {
 		return nil
 	}
 
-	_, err := bw.file.Write(bw.buffer[:bw.pos])
-	bw.pos = 0
+	n, err := bw.file.Write(bw.buffer[:bw.pos])
+	bw.flushed += int64(n)
+	bw.pos = copy(bw.buffer, bw.buffer[n:bw.pos])
 	return err
 }
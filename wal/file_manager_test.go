@@ -1,8 +1,12 @@
 package wal
 
 import (
+	"errors"
+	"fmt"
 	"os"
 	"path/filepath"
+	"strings"
+	"sync"
 	"testing"
 	"time"
 )
@@ -302,6 +306,218 @@ func TestWALFileManager_SyncModes(t *testing.T) {
 	}
 }
 
+func TestWALFileManager_GroupCommit(t *testing.T) {
+	tempDir, err := os.MkdirTemp("", "wal_group_commit_test")
+	if err != nil {
+		t.Fatalf("Failed to create temp dir: %v", err)
+	}
+	defer os.RemoveAll(tempDir)
+
+	config := DefaultWALFileManagerConfig()
+	config.WALDir = tempDir
+	config.SyncMode = SyncModeSync
+
+	manager, err := NewWALFileManager(config)
+	if err != nil {
+		t.Fatalf("Failed to create WAL file manager: %v", err)
+	}
+
+	const writers = 8
+	const entriesPerWriter = 50
+	var wg sync.WaitGroup
+	for w := 0; w < writers; w++ {
+		wg.Add(1)
+		go func(w int) {
+			defer wg.Done()
+			for i := 0; i < entriesPerWriter; i++ {
+				entry := &WALEntry{
+					TxnID:     uint64(w),
+					Operation: Operation{Type: OpInsert, Key: fmt.Sprintf("key-%d-%d", w, i), Value: []byte("value")},
+					Timestamp: time.Now(),
+				}
+				if err := manager.WriteEntry(entry); err != nil {
+					t.Errorf("Writer %d failed to write entry %d: %v", w, i, err)
+					return
+				}
+			}
+		}(w)
+	}
+	wg.Wait()
+
+	stats := manager.CommitStats()
+	if stats.Commits != writers*entriesPerWriter {
+		t.Errorf("Expected %d commits, got %d", writers*entriesPerWriter, stats.Commits)
+	}
+	if stats.Syncs != stats.Groups || stats.Groups == 0 || stats.Groups > stats.Commits {
+		t.Errorf("Unexpected group counts: %+v", stats)
+	}
+	if stats.CommitLatency.Count != stats.Commits || stats.GroupSize.Count != stats.Groups {
+		t.Errorf("Histograms disagree with counters: %+v", stats)
+	}
+
+	if err := manager.Close(); err != nil {
+		t.Fatalf("Failed to close: %v", err)
+	}
+	if err := manager.WriteEntry(&WALEntry{Operation: Operation{Type: OpCommit}}); err != ErrWALClosed {
+		t.Errorf("Expected ErrWALClosed after close, got %v", err)
+	}
+
+	// Every entry is on disk, in LSN order
+	reader, err := NewWALReader(tempDir)
+	if err != nil {
+		t.Fatalf("Failed to create WAL reader: %v", err)
+	}
+	entries, err := reader.ReadFromLSN(1)
+	if err != nil {
+		t.Fatalf("Failed to read entries: %v", err)
+	}
+	if len(entries) != writers*entriesPerWriter {
+		t.Fatalf("Expected %d entries on disk, got %d", writers*entriesPerWriter, len(entries))
+	}
+	for i, entry := range entries {
+		if entry.LSN != uint64(i+1) {
+			t.Fatalf("Entry %d has LSN %d", i, entry.LSN)
+		}
+	}
+}
+
+// failingWriter fails the failAt'th write, counting from 1, without
+// writing anything
+type failingWriter struct {
+	*bufferedWriter
+	writes int
+	failAt int
+}
+
+func (w *failingWriter) Write(data []byte) (int, error) {
+	w.writes++
+	if w.writes == w.failAt {
+		return 0, errors.New("injected write failure")
+	}
+	return w.bufferedWriter.Write(data)
+}
+
+func TestWALFileManager_GroupCommitPartialFailure(t *testing.T) {
+	tempDir, err := os.MkdirTemp("", "wal_group_failure_test")
+	if err != nil {
+		t.Fatalf("Failed to create temp dir: %v", err)
+	}
+	defer os.RemoveAll(tempDir)
+
+	config := DefaultWALFileManagerConfig()
+	config.WALDir = tempDir
+	config.SyncMode = SyncModeSync
+	manager, err := NewWALFileManager(config)
+	if err != nil {
+		t.Fatalf("Failed to create WAL file manager: %v", err)
+	}
+
+	// The second of three requests fails to write
+	group := make([]*commitRequest, 3)
+	for i := range group {
+		entry := &WALEntry{LSN: uint64(i + 1), TxnID: 1, Operation: Operation{Type: OpInsert, Key: fmt.Sprintf("key-%d", i), Value: []byte("value")}, Timestamp: time.Now()}
+		group[i] = &commitRequest{entries: []*WALEntry{entry}, buf: entry.AppendTo(nil), sync: true}
+	}
+	file := manager.currentFile
+	file.writer = &failingWriter{bufferedWriter: file.writer.(*bufferedWriter), failAt: 2}
+
+	written, err := manager.writeGroup(group)
+	if written != 1 || err == nil || !strings.Contains(err.Error(), "injected write failure") {
+		t.Fatalf("writeGroup committed %d requests with %v, want the first one and the injected error", written, err)
+	}
+	if stats := manager.CommitStats(); stats.Commits != 1 || stats.Syncs != 1 {
+		t.Errorf("Unexpected stats after a partial group: %+v", stats)
+	}
+	if err := manager.Close(); err != nil {
+		t.Fatalf("Failed to close: %v", err)
+	}
+
+	// The request before the failure is durable, and nothing after it
+	reader, err := NewWALReader(tempDir)
+	if err != nil {
+		t.Fatalf("Failed to create WAL reader: %v", err)
+	}
+	entries, err := reader.ReadFromLSN(1)
+	if err != nil {
+		t.Fatalf("Failed to read entries: %v", err)
+	}
+	if len(entries) != 1 || entries[0].Operation.Key != "key-0" {
+		t.Errorf("Read %d entries after a partial group, want key-0 alone", len(entries))
+	}
+}
+
+func TestBufferedWriterKeepsDataOnFailedFlush(t *testing.T) {
+	dir := t.TempDir()
+	path := filepath.Join(dir, "wal-1.log")
+	if err := os.WriteFile(path, nil, 0644); err != nil {
+		t.Fatal(err)
+	}
+	readOnly, err := os.Open(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer readOnly.Close()
+
+	bw := &bufferedWriter{file: readOnly, bufferSize: 16}
+	if _, err := bw.Write([]byte("committed!")); err != nil {
+		t.Fatalf("Buffered write failed: %v", err)
+	}
+	// This write fills the buffer, and the flush fails before any of it
+	// reaches the file: it is dropped, the earlier write is kept
+	if n, err := bw.Write([]byte("failed write, 20 b")); err == nil || n != 0 {
+		t.Fatalf("Write over a failing file returned %d, %v", n, err)
+	}
+
+	writable, err := os.OpenFile(path, os.O_WRONLY|os.O_APPEND, 0644)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer writable.Close()
+	bw.file = writable
+	if err := bw.flush(); err != nil {
+		t.Fatalf("Flush failed: %v", err)
+	}
+	if data, _ := os.ReadFile(path); string(data) != "committed!" {
+		t.Errorf("File holds %q after the failed write", data)
+	}
+}
+
+func BenchmarkWALFileManager_SyncWrites(b *testing.B) {
+	for _, writers := range []int{1, 4, 16, 64} {
+		b.Run(fmt.Sprintf("writers=%d", writers), func(b *testing.B) {
+			manager, err := NewWALFileManager(&WALFileManagerConfig{
+				WALDir:          b.TempDir(),
+				MaxFileSize:     64 * 1024 * 1024,
+				MaxFileAge:      time.Hour,
+				BufferSize:      64 * 1024,
+				SyncMode:        SyncModeSync,
+				RetentionPeriod: time.Hour,
+			})
+			if err != nil {
+				b.Fatal(err)
+			}
+			defer manager.Close()
+
+			b.SetParallelism(writers)
+			b.RunParallel(func(pb *testing.PB) {
+				for pb.Next() {
+					entry := &WALEntry{
+						TxnID:     1,
+						Operation: Operation{Type: OpInsert, Key: "key", Value: make([]byte, 100)},
+						Timestamp: time.Now(),
+					}
+					if err := manager.WriteEntry(entry); err != nil {
+						b.Error(err)
+						return
+					}
+				}
+			})
+			stats := manager.CommitStats()
+			b.ReportMetric(stats.GroupSize.Mean(), "commits/sync")
+		})
+	}
+}
+
 // String method for SyncMode for testing
 func (sm SyncMode) String() string {
 	switch sm {
@@ -0,0 +1,292 @@
+package wal
+
+import (
+	"fmt"
+	"math/bits"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+// commitRequest is one WriteEntry or WriteBatch call waiting in the commit
+// queue. The caller reserves its place in the queue, serializes into buf
+// outside any lock, then marks it ready; the flusher writes ready requests
+// in queue order, so records reach the file in LSN order.
+type commitRequest struct {
+	entries []*WALEntry
+	buf     []byte
+	sync    bool       // fsync before completing
+	ready   bool       // buf is filled; guarded by commitMu
+	done    chan error // the commit future, completed by the flusher
+}
+
+var commitRequestPool = sync.Pool{
+	New: func() any {
+		return &commitRequest{done: make(chan error, 1)}
+	},
+}
+
+// maxPooledBuffer keeps the occasional huge batch from pinning its buffer.
+const maxPooledBuffer = 1 << 20
+
+func (req *commitRequest) release() {
+	req.entries = nil
+	req.ready = false
+	if cap(req.buf) > maxPooledBuffer {
+		req.buf = nil
+	}
+	req.buf = req.buf[:0]
+	commitRequestPool.Put(req)
+}
+
+// commit writes entries through the commit queue and waits until they are
+// written, and synced if sync is set.
+func (wfm *WALFileManager) commit(entries []*WALEntry, sync bool) error {
+	start := time.Now()
+	req := commitRequestPool.Get().(*commitRequest)
+	req.entries, req.sync = entries, sync
+
+	if err := wfm.reserve(req); err != nil {
+		req.release()
+		return err
+	}
+
+	for _, entry := range entries {
+		req.buf = entry.AppendTo(req.buf)
+	}
+
+	wfm.commitMu.Lock()
+	req.ready = true
+	wfm.commitCond.Signal()
+	wfm.commitMu.Unlock()
+
+	err := <-req.done
+	req.release()
+	if err == nil {
+		wfm.commitStats.latency.record(uint64(time.Since(start).Microseconds()))
+	}
+	return err
+}
+
+// reserve assigns LSNs to the request's entries and queues it. LSNs are
+// handed out in queue order, which is the order the flusher writes in.
+func (wfm *WALFileManager) reserve(req *commitRequest) error {
+	wfm.commitMu.Lock()
+	defer wfm.commitMu.Unlock()
+
+	if wfm.commitClosed {
+		return ErrWALClosed
+	}
+	for _, entry := range req.entries {
+		if entry.LSN == 0 {
+			entry.LSN = wfm.nextLSN
+			wfm.nextLSN++
+		}
+	}
+	wfm.commitQueue = append(wfm.commitQueue, req)
+	return nil
+}
+
+// flusher writes the commit queue. Requests that arrive while a group is
+// being written and synced form the next group, so concurrent writers
+// share one fsync instead of each paying for their own.
+func (wfm *WALFileManager) flusher() {
+	defer close(wfm.flusherDone)
+
+	var group []*commitRequest
+	wfm.commitMu.Lock()
+	for {
+		for (len(wfm.commitQueue) == 0 || !wfm.commitQueue[0].ready) &&
+			!(wfm.commitClosed && len(wfm.commitQueue) == 0) {
+			wfm.commitCond.Wait()
+		}
+		if len(wfm.commitQueue) == 0 {
+			wfm.commitMu.Unlock()
+			return
+		}
+
+		n := 1
+		for n < len(wfm.commitQueue) && wfm.commitQueue[n].ready {
+			n++
+		}
+		group = append(group[:0], wfm.commitQueue[:n]...)
+		rest := copy(wfm.commitQueue, wfm.commitQueue[n:])
+		clear(wfm.commitQueue[rest:])
+		wfm.commitQueue = wfm.commitQueue[:rest]
+		wfm.commitMu.Unlock()
+
+		written, err := wfm.writeGroup(group)
+		for i, req := range group {
+			if i < written {
+				req.done <- nil
+			} else {
+				req.done <- err
+			}
+		}
+		clear(group)
+
+		wfm.commitMu.Lock()
+	}
+}
+
+// writeGroup writes a group of requests and, if any of them asks for it,
+// syncs the file once for all of them. It returns how many requests, from
+// the start of the group, were committed. A request that fails to write or
+// rotate fails with the ones after it, but those written before it still
+// commit once the sync succeeds.
+func (wfm *WALFileManager) writeGroup(group []*commitRequest) (int, error) {
+	wfm.mu.Lock()
+	defer wfm.mu.Unlock()
+
+	sync := false
+	written := 0
+	var err error
+	for _, req := range group {
+		// Rotate between requests, so a batch never spans two files
+		if wfm.shouldRotate() {
+			if rerr := wfm.rotateFile(); rerr != nil {
+				err = fmt.Errorf("failed to rotate WAL file: %w", rerr)
+				break
+			}
+		}
+		minLSN, maxLSN := req.entries[0].LSN, req.entries[0].LSN
+		for _, entry := range req.entries[1:] {
+			minLSN, maxLSN = min(minLSN, entry.LSN), max(maxLSN, entry.LSN)
+		}
+		if werr := wfm.currentFile.writeRecords(req.buf, minLSN, maxLSN, int64(len(req.entries))); werr != nil {
+			err = fmt.Errorf("failed to write WAL entry: %w", werr)
+			break
+		}
+		sync = sync || req.sync
+		written++
+	}
+
+	if sync {
+		if serr := wfm.currentFile.sync(); serr != nil {
+			return 0, fmt.Errorf("failed to sync WAL file: %w", serr)
+		}
+		wfm.commitStats.syncs.Add(1)
+	}
+	if written > 0 {
+		wfm.commitStats.groups.Add(1)
+		wfm.commitStats.commits.Add(uint64(written))
+		wfm.commitStats.groupSize.record(uint64(written))
+	}
+	return written, err
+}
+
+// closeCommitQueue stops new commits and waits for the queued ones to be
+// written.
+func (wfm *WALFileManager) closeCommitQueue() {
+	wfm.commitMu.Lock()
+	alreadyClosed := wfm.commitClosed
+	wfm.commitClosed = true
+	wfm.commitCond.Signal()
+	wfm.commitMu.Unlock()
+
+	<-wfm.flusherDone
+	if !alreadyClosed {
+		close(wfm.stopSync)
+	}
+}
+
+// GroupCommitStats describes how commits were grouped.
+type GroupCommitStats struct {
+	Groups        uint64            // groups written
+	Commits       uint64            // WriteEntry and WriteBatch calls written
+	Syncs         uint64            // fsyncs issued for groups
+	CommitLatency HistogramSnapshot // microseconds from call to completion
+	GroupSize     HistogramSnapshot // commits per group
+}
+
+type commitStats struct {
+	groups    atomic.Uint64
+	commits   atomic.Uint64
+	syncs     atomic.Uint64
+	latency   histogram
+	groupSize histogram
+}
+
+// CommitStats returns group commit counters and histograms.
+func (wfm *WALFileManager) CommitStats() GroupCommitStats {
+	return GroupCommitStats{
+		Groups:        wfm.commitStats.groups.Load(),
+		Commits:       wfm.commitStats.commits.Load(),
+		Syncs:         wfm.commitStats.syncs.Load(),
+		CommitLatency: wfm.commitStats.latency.snapshot(),
+		GroupSize:     wfm.commitStats.groupSize.snapshot(),
+	}
+}
+
+// histogram counts values in power-of-two buckets: bucket i holds values
+// below 2^i. It is lock-free, so recording costs two atomic adds.
+type histogram struct {
+	buckets [65]atomic.Uint64
+	sum     atomic.Uint64
+}
+
+func (h *histogram) record(v uint64) {
+	h.buckets[bits.Len64(v)].Add(1)
+	h.sum.Add(v)
+}
+
+func (h *histogram) snapshot() HistogramSnapshot {
+	var s HistogramSnapshot
+	for i := range h.buckets {
+		n := h.buckets[i].Load()
+		if n == 0 {
+			continue
+		}
+		upper := uint64(1)<<i - 1
+		if i == 64 {
+			upper = ^uint64(0)
+		}
+		s.Buckets = append(s.Buckets, HistogramBucket{UpperBound: upper, Count: n})
+		s.Count += n
+	}
+	s.Sum = h.sum.Load()
+	return s
+}
+
+// HistogramSnapshot is a point-in-time copy of a histogram. Only
+// non-empty buckets are listed.
+type HistogramSnapshot struct {
+	Count   uint64
+	Sum     uint64
+	Buckets []HistogramBucket
+}
+
+// HistogramBucket counts the values at most UpperBound and above the
+// previous bucket's bound.
+type HistogramBucket struct {
+	UpperBound uint64
+	Count      uint64
+}
+
+// Mean returns the average recorded value.
+func (s HistogramSnapshot) Mean() float64 {
+	if s.Count == 0 {
+		return 0
+	}
+	return float64(s.Sum) / float64(s.Count)
+}
+
+// Quantile returns the upper bound of the bucket holding the q-quantile,
+// which overstates the true value by less than a factor of two.
+func (s HistogramSnapshot) Quantile(q float64) uint64 {
+	if s.Count == 0 {
+		return 0
+	}
+	rank := uint64(q * float64(s.Count))
+	if rank >= s.Count {
+		rank = s.Count - 1
+	}
+	var seen uint64
+	for _, b := range s.Buckets {
+		seen += b.Count
+		if seen > rank {
+			return b.UpperBound
+		}
+	}
+	return s.Buckets[len(s.Buckets)-1].UpperBound
+}
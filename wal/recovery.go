@@ -2,13 +2,17 @@
 package wal
 
 import (
+	"errors"
 	"fmt"
 	"io"
 	"os"
 	"path/filepath"
+	"runtime"
 	"sort"
 	"strconv"
 	"strings"
+	"sync"
+	"sync/atomic"
 	"time"
 )
 
@@ -139,10 +143,12 @@ type RecoveryConfig struct {
 	// We default to false (relaxed) because corrupted tail entries after
 	// crash are expected - only the committed prefix matters.
 	StrictValidation bool
-	// ParallelRecovery replays independent transactions concurrently.
-	// Disabled by default - correctness over speed during recovery.
+	// ParallelRecovery replays operations on different keys concurrently.
+	// Each key's operations still apply in commit order on one worker.
+	// Off by default: only enable it when the replay function is safe to
+	// call concurrently for different keys.
 	ParallelRecovery   bool
-	MaxParallelWorkers int
+	MaxParallelWorkers int // 0 means GOMAXPROCS
 	// SafeModeOnFailure starts in read-only mode if recovery fails.
 	// Better to serve stale data than corrupt or lose data.
 	SafeModeOnFailure   bool
@@ -381,101 +387,235 @@ func (wr *WALReader) scanWALFiles() error {
 	return nil
 }
 
-// ReadFromLSN reads WAL entries starting from the specified LSN
+// ReadFromLSN reads WAL entries starting from the specified LSN. It holds
+// the whole log in memory; recovery streams it with Scan instead.
 func (wr *WALReader) ReadFromLSN(startLSN uint64) ([]*WALEntry, error) {
 	var entries []*WALEntry
-
-	for _, filePath := range wr.files {
-		fileEntries, err := wr.readEntriesFromFile(filePath, startLSN)
-		if err != nil {
-			return nil, fmt.Errorf("failed to read entries from file %s: %w", filePath, err)
-		}
-		entries = append(entries, fileEntries...)
+	err := wr.Scan(startLSN, func(entry *WALEntry) error {
+		entries = append(entries, entry)
+		return nil
+	})
+	if err != nil {
+		return nil, err
 	}
-
 	return entries, nil
 }
 
 // ReadRange reads WAL entries within the specified LSN range
 func (wr *WALReader) ReadRange(startLSN, endLSN uint64) ([]*WALEntry, error) {
 	var entries []*WALEntry
+	err := wr.Scan(startLSN, func(entry *WALEntry) error {
+		if entry.LSN <= endLSN {
+			entries = append(entries, entry)
+		}
+		return nil
+	})
+	if err != nil {
+		return nil, err
+	}
+	return entries, nil
+}
+
+// walScanChunkSize is the size of the sequential reads Scan issues. A
+// variable so tests can make records straddle chunks.
+var walScanChunkSize = 1 << 20
+
+// maxWALRecordSize bounds the size read for one record, so a corrupted
+// length cannot make the reader allocate without limit.
+const maxWALRecordSize = 1 << 30
+
+// walChunk is a run of whole records read from one segment
+type walChunk struct {
+	filePath string
+	offset   int64 // file offset of data[0]
+	data     []byte
+	records  []int // start of each record in data
+	result   chan walChunkResult
+}
+
+type walChunkResult struct {
+	entries []*WALEntry
+	err     error
+}
+
+// Scan streams the entries with LSN >= startLSN to fn in log order.
+// Segments are read in large sequential chunks. While the next chunk is
+// read, a pool of workers decodes and checksums the records of earlier
+// ones, and the chunks are handed to fn in order. Memory use is a few
+// chunks whatever the size of the log. Entries alias the chunk they were
+// decoded from. An error from fn stops the scan and is returned.
+func (wr *WALReader) Scan(startLSN uint64, fn func(*WALEntry) error) error {
+	return wr.scanChunks(wr.files, startLSN, func(entries []*WALEntry, _ int) error {
+		for _, entry := range entries {
+			if err := fn(entry); err != nil {
+				return err
+			}
+		}
+		return nil
+	})
+}
 
+// TotalSize returns the combined size of the WAL segments in bytes
+func (wr *WALReader) TotalSize() int64 {
+	var total int64
 	for _, filePath := range wr.files {
-		fileEntries, err := wr.readEntriesFromFile(filePath, startLSN)
-		if err != nil {
-			return nil, fmt.Errorf("failed to read entries from file %s: %w", filePath, err)
+		if stat, err := os.Stat(filePath); err == nil {
+			total += stat.Size()
 		}
+	}
+	return total
+}
 
-		// Filter entries within range
-		for _, entry := range fileEntries {
-			if entry.LSN >= startLSN && entry.LSN <= endLSN {
-				entries = append(entries, entry)
+// scanChunks runs the scan pipeline over files, calling fn with the
+// decoded entries of each chunk and the number of bytes it covered.
+func (wr *WALReader) scanChunks(files []string, startLSN uint64, fn func([]*WALEntry, int) error) error {
+	workers := runtime.GOMAXPROCS(0)
+	work := make(chan *walChunk, workers)
+	ordered := make(chan *walChunk, 2*workers)
+	stop := make(chan struct{})
+
+	var wg sync.WaitGroup
+	for i := 0; i < workers; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for chunk := range work {
+				chunk.result <- chunk.decode(startLSN)
+			}
+		}()
+	}
+
+	readErr := make(chan error, 1)
+	go func() {
+		defer close(work)
+		defer close(ordered)
+		emit := func(chunk *walChunk) bool {
+			// Queue the chunk for delivery before decoding, so results
+			// come out in file order
+			select {
+			case ordered <- chunk:
+			case <-stop:
+				return false
+			}
+			select {
+			case work <- chunk:
+				return true
+			case <-stop:
+				// Already queued, and the consumer waits for its result
+				chunk.result <- walChunkResult{}
+				return false
 			}
 		}
-	}
+		for _, filePath := range files {
+			err := readSegmentChunks(filePath, emit)
+			if err == errScanStopped {
+				break
+			}
+			if err != nil {
+				readErr <- fmt.Errorf("failed to read entries from file %s: %w", filePath, err)
+				return
+			}
+		}
+		readErr <- nil
+	}()
 
-	return entries, nil
+	var err error
+	for chunk := range ordered {
+		result := <-chunk.result
+		if err != nil {
+			continue // draining after a failure
+		}
+		if err = result.err; err == nil {
+			err = fn(result.entries, len(chunk.data))
+		}
+		if err != nil {
+			close(stop)
+		}
+	}
+	wg.Wait()
+	if rerr := <-readErr; err == nil {
+		err = rerr
+	}
+	return err
 }
 
-// readEntriesFromFile reads all entries from a single WAL file
-func (wr *WALReader) readEntriesFromFile(filePath string, minLSN uint64) ([]*WALEntry, error) {
+// errScanStopped is returned by readSegmentChunks when emit asks it to stop
+var errScanStopped = errors.New("scan stopped")
+
+// readSegmentChunks reads a segment in chunks of whole records and passes
+// them to emit until it returns false, and then returns errScanStopped. A
+// record cut short by the end of the file is an error, but a cut short
+// header is taken as the end of the log, as a crash mid-append leaves it.
+func readSegmentChunks(filePath string, emit func(*walChunk) bool) error {
 	file, err := os.Open(filePath)
 	if err != nil {
-		return nil, fmt.Errorf("failed to open WAL file: %w", err)
+		return fmt.Errorf("failed to open WAL file: %w", err)
 	}
 	defer file.Close()
 
-	var entries []*WALEntry
-	offset := int64(0)
-
+	var pending []byte // start of a record the last read cut off
+	offset := int64(0) // file offset of pending[0]
 	for {
-		// Read entry header first
-		headerBuf := make([]byte, WALEntryHeaderSize)
-		n, err := file.ReadAt(headerBuf, offset)
-		if err == io.EOF {
-			break
+		buf := make([]byte, max(walScanChunkSize, 2*len(pending)))
+		copy(buf, pending)
+		n, err := io.ReadFull(file, buf[len(pending):])
+		eof := err == io.EOF || err == io.ErrUnexpectedEOF
+		if err != nil && !eof {
+			return fmt.Errorf("failed to read at offset %d: %w", offset+int64(len(pending)), err)
 		}
-		if err != nil {
-			return nil, fmt.Errorf("failed to read entry header at offset %d: %w", offset, err)
-		}
-		if n < WALEntryHeaderSize {
-			break // Incomplete header, end of file
+		buf = buf[:len(pending)+n]
+
+		chunk := &walChunk{filePath: filePath, offset: offset, result: make(chan walChunkResult, 1)}
+		pos := 0
+		for len(buf)-pos >= MinWALRecordSize {
+			size, err := WALRecordSize(buf[pos:])
+			if err != nil {
+				return fmt.Errorf("failed to parse header at offset %d: %w", offset+int64(pos), err)
+			}
+			if size > maxWALRecordSize {
+				return fmt.Errorf("%w: %d byte entry at offset %d", ErrWALFileCorrupted, size, offset+int64(pos))
+			}
+			if pos+size > len(buf) {
+				break // the rest comes with the next read
+			}
+			chunk.records = append(chunk.records, pos)
+			pos += size
 		}
+		chunk.data = buf[:pos]
+		pending = buf[pos:]
 
-		// Parse header to get payload length
-		var header WALEntryHeader
-		if err := parseHeader(headerBuf, &header); err != nil {
-			return nil, fmt.Errorf("failed to parse header at offset %d: %w", offset, err)
+		if len(chunk.records) > 0 && !emit(chunk) {
+			return errScanStopped
 		}
+		offset += int64(pos)
 
-		// Skip entries with LSN less than minLSN
-		if header.LSN < minLSN {
-			offset += int64(WALEntryHeaderSize + header.PayloadLen)
-			continue
+		if eof {
+			if len(pending) >= MinWALRecordSize {
+				return fmt.Errorf("incomplete entry at offset %d", offset)
+			}
+			return nil
 		}
+	}
+}
 
-		// Read complete entry (header + payload)
-		entrySize := WALEntryHeaderSize + int(header.PayloadLen)
-		entryBuf := make([]byte, entrySize)
-		n, err = file.ReadAt(entryBuf, offset)
-		if err != nil {
-			return nil, fmt.Errorf("failed to read complete entry at offset %d: %w", offset, err)
-		}
-		if n < entrySize {
-			return nil, fmt.Errorf("incomplete entry at offset %d: expected %d bytes, got %d", offset, entrySize, n)
+// decode decodes and checksums the chunk's records
+func (c *walChunk) decode(startLSN uint64) walChunkResult {
+	entries := make([]*WALEntry, 0, len(c.records))
+	for i, start := range c.records {
+		end := len(c.data)
+		if i+1 < len(c.records) {
+			end = c.records[i+1]
 		}
-
-		// Deserialize entry
-		entry, err := DeserializeWALEntry(entryBuf)
+		entry, err := DeserializeWALEntry(c.data[start:end])
 		if err != nil {
-			return nil, fmt.Errorf("failed to deserialize entry at offset %d: %w", offset, err)
+			return walChunkResult{err: fmt.Errorf("failed to deserialize entry at offset %d in %s: %w",
+				c.offset+int64(start), c.filePath, err)}
+		}
+		if entry.LSN >= startLSN {
+			entries = append(entries, entry)
 		}
-
-		entries = append(entries, entry)
-		offset += int64(entrySize)
 	}
-
-	return entries, nil
+	return walChunkResult{entries: entries}
 }
 
 // NewRecoveryEngine creates a new recovery engine
@@ -521,7 +661,7 @@ func DefaultRecoveryConfig() *RecoveryConfig {
 		ProgressReporting:   true,
 		StrictValidation:    true,
 		ParallelRecovery:    false,
-		MaxParallelWorkers:  4,
+		MaxParallelWorkers:  0, // GOMAXPROCS
 		SafeModeOnFailure:   true,
 		ConsistencyChecks:   true,
 		DataIntegrityChecks: true,
@@ -597,16 +737,17 @@ func (re *RecoveryEngine) Recover() error {
 		return nil
 	}
 
-	// Analyze WAL to create recovery plan
-	plan, err := re.AnalyzeWAL()
+	// Stream the WAL, replaying committed transactions as their commit
+	// records are read
+	summary, err := re.ReplayCommitted(re.validateReplayedEntry)
 	if err != nil {
 		re.recoveryState.Status = RecoveryStatusFailed
 		re.recoveryState.LastError = err
-		return fmt.Errorf("failed to analyze WAL: %w", err)
+		return fmt.Errorf("recovery failed: %w", err)
 	}
 
-	// Check if recovery is actually needed
-	if len(plan.Operations) == 0 {
+	// Check if recovery was actually needed
+	if summary.Operations == 0 {
 		re.recoveryState.Status = RecoveryStatusCompleted
 		re.recoveryState.EndTime = time.Now()
 		if re.config.ProgressReporting {
@@ -616,17 +757,9 @@ func (re *RecoveryEngine) Recover() error {
 	}
 
 	re.recoveryState.RecoveryRequired = true
-	re.recoveryState.TotalOperations = len(plan.Operations)
-
-	// Perform recovery
-	if err := re.performRecovery(plan); err != nil {
-		re.recoveryState.Status = RecoveryStatusFailed
-		re.recoveryState.LastError = err
-		return fmt.Errorf("recovery failed: %w", err)
-	}
 
 	// Validate recovery
-	if err := re.validateRecovery(); err != nil {
+	if err := re.validateRecovery(summary); err != nil {
 		re.recoveryState.Status = RecoveryStatusFailed
 		re.recoveryState.LastError = err
 		return fmt.Errorf("recovery validation failed: %w", err)
@@ -668,7 +801,7 @@ func (re *RecoveryEngine) reportProgress(message string) {
 		percentComplete = float64(re.recoveryState.ProcessedOps) / float64(re.recoveryState.TotalOperations) * 100
 	}
 
-	progress := RecoveryProgress{
+	re.sendProgress(RecoveryProgress{
 		Status:          re.recoveryState.Status,
 		CurrentLSN:      re.recoveryState.CurrentLSN,
 		TotalOps:        re.recoveryState.TotalOperations,
@@ -677,8 +810,14 @@ func (re *RecoveryEngine) reportProgress(message string) {
 		PercentComplete: percentComplete,
 		Message:         message,
 		Error:           re.recoveryState.LastError,
-	}
+	})
+}
 
+// sendProgress publishes a progress update without waiting for a reader
+func (re *RecoveryEngine) sendProgress(progress RecoveryProgress) {
+	if re.progressChan == nil {
+		return
+	}
 	select {
 	case re.progressChan <- progress:
 	default:
@@ -779,70 +918,209 @@ func (re *RecoveryEngine) ReplayOperations(plan *RecoveryPlan, replayFunc func(*
 	return nil
 }
 
-// performRecovery performs the actual recovery process
-func (re *RecoveryEngine) performRecovery(plan *RecoveryPlan) error {
-	re.recoveryState.Status = RecoveryStatusReplaying
+// ReplaySummary describes a streaming replay
+type ReplaySummary struct {
+	Operations             int              // operations replayed
+	CommittedTransactions  int              // transactions whose operations were replayed
+	AbortedTransactions    int              // transactions discarded by an abort record
+	IncompleteTransactions []uint64         // transactions with no commit or abort record
+	CorruptedEntries       []CorruptedEntry // entries the validator rejected, skipped
+	LastLSN                uint64           // last LSN read
+	BytesRead              int64
+}
 
+// replayBatchSize is how many operations the dispatcher hands a replay
+// worker at once
+const replayBatchSize = 256
+
+// ReplayCommitted streams the WAL once and replays the operations of
+// committed transactions with replayFunc. A transaction's operations are
+// held until its commit record is read and then dispatched in log order,
+// so memory grows with the write sets of open transactions, not with the
+// log. Aborted transactions are dropped when their abort record is read
+// and incomplete ones at the end. Entries the validator rejects are
+// skipped, as AnalyzeWAL skips them.
+//
+// With ParallelRecovery, operations are partitioned by key across
+// MaxParallelWorkers workers (GOMAXPROCS if zero). Each key's operations
+// are applied by one worker in commit order, so replayFunc must be safe to
+// call concurrently for different keys.
+func (re *RecoveryEngine) ReplayCommitted(replayFunc func(*WALEntry) error) (*ReplaySummary, error) {
+	if replayFunc == nil {
+		return nil, fmt.Errorf("replay function cannot be nil")
+	}
+	re.recoveryState.Status = RecoveryStatusReplaying
 	if re.config.ProgressReporting {
-		go re.reportProgress(fmt.Sprintf("Starting replay of %d operations", len(plan.Operations)))
+		re.reportProgress("Starting WAL replay")
 	}
 
-	// Create a default replay function that would be provided by the storage layer
-	replayFunc := func(entry *WALEntry) error {
-		re.recoveryState.CurrentLSN = entry.LSN
-		re.recoveryState.ProcessedOps++
-
-		// Report progress periodically
-		if re.config.ProgressReporting && re.recoveryState.ProcessedOps%100 == 0 {
-			go re.reportProgress(fmt.Sprintf("Processed %d/%d operations",
-				re.recoveryState.ProcessedOps, re.recoveryState.TotalOperations))
+	workers := 1
+	if re.config.ParallelRecovery {
+		workers = re.config.MaxParallelWorkers
+		if workers <= 0 {
+			workers = runtime.GOMAXPROCS(0)
 		}
-
-		// This would normally call into the storage layer to apply the operation
-		// For now, we'll just validate that the operation is well-formed
-		if err := re.validator.ValidateEntry(entry); err != nil {
-			re.recoveryState.FailedOps++
-			return fmt.Errorf("invalid operation during replay: %w", err)
-		}
-
-		return nil
 	}
 
-	// Replay operations with retry logic
-	for _, entry := range plan.Operations {
-		var lastErr error
-		success := false
-
-		for attempt := 0; attempt <= re.config.MaxRetries; attempt++ {
-			if attempt > 0 {
-				time.Sleep(re.config.RetryDelay)
-				if re.config.ProgressReporting {
-					go re.reportProgress(fmt.Sprintf("Retrying operation LSN %d (attempt %d/%d)",
-						entry.LSN, attempt, re.config.MaxRetries))
+	var (
+		processed atomic.Int64
+		failed    atomic.Bool
+		errOnce   sync.Once
+		replayErr error
+		wg        sync.WaitGroup
+	)
+	queues := make([]chan []*WALEntry, workers)
+	for i := range queues {
+		queues[i] = make(chan []*WALEntry, 4)
+		wg.Add(1)
+		go func(queue <-chan []*WALEntry) {
+			defer wg.Done()
+			for batch := range queue {
+				for _, entry := range batch {
+					if failed.Load() {
+						break
+					}
+					if err := re.replayWithRetry(entry, replayFunc); err != nil {
+						errOnce.Do(func() { replayErr = err })
+						failed.Store(true)
+						break
+					}
+					processed.Add(1)
 				}
 			}
+		}(queues[i])
+	}
+
+	summary := &ReplaySummary{}
+	totalBytes := re.reader.TotalSize()
+	pending := make(map[uint64][]*WALEntry)
+	batches := make([][]*WALEntry, workers)
+	dispatch := func(entry *WALEntry) {
+		w := keyPartition(entry.Operation.Key, workers)
+		batches[w] = append(batches[w], entry)
+		if len(batches[w]) == replayBatchSize {
+			queues[w] <- batches[w]
+			batches[w] = nil
+		}
+	}
 
-			if err := replayFunc(entry); err != nil {
-				lastErr = err
+	scanErr := re.reader.scanChunks(re.reader.files, 1, func(entries []*WALEntry, n int) error {
+		corrupted := re.validator.ValidateEntries(entries)
+		summary.CorruptedEntries = append(summary.CorruptedEntries, corrupted...)
+		for _, entry := range entries {
+			summary.LastLSN = entry.LSN
+			if len(corrupted) > 0 && re.isCorrupted(entry, corrupted) {
 				continue
 			}
+			switch entry.Operation.Type {
+			case OpCommit:
+				for _, op := range pending[entry.TxnID] {
+					dispatch(op)
+				}
+				summary.Operations += len(pending[entry.TxnID])
+				summary.CommittedTransactions++
+				delete(pending, entry.TxnID)
+			case OpAbort:
+				summary.AbortedTransactions++
+				delete(pending, entry.TxnID)
+			default:
+				pending[entry.TxnID] = append(pending[entry.TxnID], entry)
+			}
+		}
+		if failed.Load() {
+			return errReplayStopped
+		}
 
-			success = true
-			break
+		summary.BytesRead += int64(n)
+		re.recoveryState.CurrentLSN = summary.LastLSN
+		re.recoveryState.TotalOperations = summary.Operations
+		if re.config.ProgressReporting {
+			done := processed.Load()
+			re.sendProgress(RecoveryProgress{
+				Status:          RecoveryStatusReplaying,
+				CurrentLSN:      summary.LastLSN,
+				TotalOps:        summary.Operations,
+				ProcessedOps:    int(done),
+				PercentComplete: percentOf(summary.BytesRead, totalBytes),
+				Message:         fmt.Sprintf("Replayed %d/%d operations", done, summary.Operations),
+			})
 		}
+		return nil
+	})
 
-		if !success {
-			re.recoveryState.FailedOps++
-			return fmt.Errorf("failed to replay operation LSN %d after %d attempts: %w",
-				entry.LSN, re.config.MaxRetries, lastErr)
+	for w, batch := range batches {
+		if len(batch) > 0 {
+			queues[w] <- batch
 		}
+		close(queues[w])
 	}
+	wg.Wait()
+
+	for txnID := range pending {
+		summary.IncompleteTransactions = append(summary.IncompleteTransactions, txnID)
+	}
+	sort.Slice(summary.IncompleteTransactions, func(i, j int) bool {
+		return summary.IncompleteTransactions[i] < summary.IncompleteTransactions[j]
+	})
+
+	re.recoveryState.ProcessedOps = int(processed.Load())
+	re.recoveryState.TotalOperations = summary.Operations
+	if replayErr != nil {
+		re.recoveryState.FailedOps++
+		return summary, replayErr
+	}
+	if scanErr != nil {
+		return summary, fmt.Errorf("failed to read WAL entries: %w", scanErr)
+	}
+	return summary, nil
+}
+
+// replayWithRetry applies one operation, retrying up to MaxRetries times
+func (re *RecoveryEngine) replayWithRetry(entry *WALEntry, replayFunc func(*WALEntry) error) error {
+	var lastErr error
+	for attempt := 0; attempt <= re.config.MaxRetries; attempt++ {
+		if attempt > 0 {
+			time.Sleep(re.config.RetryDelay)
+		}
+		if lastErr = replayFunc(entry); lastErr == nil {
+			return nil
+		}
+	}
+	return fmt.Errorf("failed to replay operation LSN %d after %d attempts: %w",
+		entry.LSN, re.config.MaxRetries, lastErr)
+}
 
+// validateReplayedEntry is the replay function Recover uses. Applying the
+// operation is up to the storage layer; recovery checks it is well-formed.
+func (re *RecoveryEngine) validateReplayedEntry(entry *WALEntry) error {
+	if err := re.validator.ValidateEntry(entry); err != nil {
+		return fmt.Errorf("invalid operation during replay: %w", err)
+	}
 	return nil
 }
 
+// keyPartition hashes a key (FNV-1a) to one of n replay workers
+func keyPartition(key string, n int) int {
+	if n == 1 {
+		return 0
+	}
+	h := uint32(2166136261)
+	for i := 0; i < len(key); i++ {
+		h ^= uint32(key[i])
+		h *= 16777619
+	}
+	return int(h % uint32(n))
+}
+
+func percentOf(part, total int64) float64 {
+	if total <= 0 {
+		return 100
+	}
+	return min(float64(part)/float64(total)*100, 100)
+}
+
 // validateRecovery validates that recovery was successful
-func (re *RecoveryEngine) validateRecovery() error {
+func (re *RecoveryEngine) validateRecovery(summary *ReplaySummary) error {
 	re.recoveryState.Status = RecoveryStatusValidating
 
 	if re.config.ProgressReporting {
@@ -866,20 +1144,8 @@ func (re *RecoveryEngine) validateRecovery() error {
 			return fmt.Errorf("WAL integrity validation failed: %w", err)
 		}
 
-		// Verify that all committed transactions were properly recovered
-		plan, err := re.AnalyzeWAL()
-		if err != nil {
-			return fmt.Errorf("failed to re-analyze WAL for validation: %w", err)
-		}
-
 		// Check for any remaining uncommitted transactions
-		var incompleteTransactions []uint64
-		for txnID, txnState := range plan.Transactions {
-			if txnState.Status == TxnStatusActive {
-				incompleteTransactions = append(incompleteTransactions, txnID)
-			}
-		}
-
+		incompleteTransactions := summary.IncompleteTransactions
 		if len(incompleteTransactions) > 0 {
 			return fmt.Errorf("validation failed: found %d incomplete transactions: %v",
 				len(incompleteTransactions), incompleteTransactions)
@@ -891,12 +1157,17 @@ func (re *RecoveryEngine) validateRecovery() error {
 
 // ValidateWALIntegrity validates the integrity of all WAL files
 func (re *RecoveryEngine) ValidateWALIntegrity() error {
-	entries, err := re.reader.ReadFromLSN(1)
+	var corruptedEntries []CorruptedEntry
+	err := re.reader.Scan(1, func(entry *WALEntry) error {
+		if err := re.validator.ValidateEntry(entry); err != nil {
+			corruptedEntries = append(corruptedEntries, CorruptedEntry{LSN: entry.LSN, Error: err})
+		}
+		return nil
+	})
 	if err != nil {
 		return fmt.Errorf("failed to read WAL entries for validation: %w", err)
 	}
 
-	corruptedEntries := re.validator.ValidateEntries(entries)
 	if len(corruptedEntries) > 0 {
 		var errorMessages []string
 		for _, corrupted := range corruptedEntries {
@@ -1402,19 +1673,22 @@ func (re *RecoveryEngine) performIntegrityChecks(result *ValidationResult) error
 		}
 
 		// Verify file integrity by reading and validating all entries
-		entries, err := re.reader.readEntriesFromFile(filePath, 1)
-		if err != nil {
-			check.Passed = false
-			check.Message = fmt.Sprintf("Failed to read WAL file: %v", err)
-		} else {
-			// Validate each entry's checksum
+		var entryErr error
+		err := re.reader.scanChunks([]string{filePath}, 1, func(entries []*WALEntry, _ int) error {
 			for _, entry := range entries {
-				if err := re.validator.ValidateEntry(entry); err != nil {
-					check.Passed = false
-					check.Message = fmt.Sprintf("Entry validation failed: %v", err)
-					break
+				if entryErr = re.validator.ValidateEntry(entry); entryErr != nil {
+					return entryErr
 				}
 			}
+			return nil
+		})
+		switch {
+		case entryErr != nil:
+			check.Passed = false
+			check.Message = fmt.Sprintf("Entry validation failed: %v", entryErr)
+		case err != nil:
+			check.Passed = false
+			check.Message = fmt.Sprintf("Failed to read WAL file: %v", err)
 		}
 
 		result.IntegrityChecks = append(result.IntegrityChecks, check)
@@ -1630,28 +1904,3 @@ func (re *RecoveryEngine) GetSafeModeInfo() (*SafeMode, error) {
 
 	return safeMode, nil
 }
-
-// Helper function to parse WAL entry header
-func parseHeader(data []byte, header *WALEntryHeader) error {
-	if len(data) < WALEntryHeaderSize {
-		return fmt.Errorf("insufficient data for header: got %d bytes, need %d", len(data), WALEntryHeaderSize)
-	}
-
-	// Parse header fields manually to avoid binary.Read overhead
-	header.LSN = uint64(data[0]) | uint64(data[1])<<8 | uint64(data[2])<<16 | uint64(data[3])<<24 |
-		uint64(data[4])<<32 | uint64(data[5])<<40 | uint64(data[6])<<48 | uint64(data[7])<<56
-
-	header.TxnID = uint64(data[8]) | uint64(data[9])<<8 | uint64(data[10])<<16 | uint64(data[11])<<24 |
-		uint64(data[12])<<32 | uint64(data[13])<<40 | uint64(data[14])<<48 | uint64(data[15])<<56
-
-	header.OpType = uint32(data[16]) | uint32(data[17])<<8 | uint32(data[18])<<16 | uint32(data[19])<<24
-
-	header.Timestamp = int64(data[20]) | int64(data[21])<<8 | int64(data[22])<<16 | int64(data[23])<<24 |
-		int64(data[24])<<32 | int64(data[25])<<40 | int64(data[26])<<48 | int64(data[27])<<56
-
-	header.PayloadLen = uint32(data[28]) | uint32(data[29])<<8 | uint32(data[30])<<16 | uint32(data[31])<<24
-
-	header.Checksum = uint32(data[32]) | uint32(data[33])<<8 | uint32(data[34])<<16 | uint32(data[35])<<24
-
-	return nil
-}
@@ -1,8 +1,10 @@
 package wal
 
 import (
+	"errors"
 	"fmt"
 	"os"
+	"sync"
 	"testing"
 	"time"
 )
@@ -301,6 +303,194 @@ func TestRecoveryEngine_ReplayOperations(t *testing.T) {
 	}
 }
 
+func TestRecoveryEngine_ReplayCommittedStreaming(t *testing.T) {
+	tempDir, err := os.MkdirTemp("", "recovery_streaming_test")
+	if err != nil {
+		t.Fatalf("Failed to create temp dir: %v", err)
+	}
+	defer os.RemoveAll(tempDir)
+
+	// Small segments and scan chunks, so records straddle chunk reads and
+	// the log spans several files
+	defer func(size int) { walScanChunkSize = size }(walScanChunkSize)
+	walScanChunkSize = 1000
+
+	config := DefaultWALFileManagerConfig()
+	config.WALDir = tempDir
+	config.MaxFileSize = 16 * 1024
+	manager, err := NewWALFileManager(config)
+	if err != nil {
+		t.Fatalf("Failed to create WAL manager: %v", err)
+	}
+
+	// Transactions interleave; every third aborts and the last never ends.
+	// expected holds each key's final value in commit order.
+	expected := make(map[string]string)
+	const txns = 60
+	var open []uint64
+	for txn := uint64(1); txn <= txns; txn++ {
+		for i := 0; i < 5; i++ {
+			key := fmt.Sprintf("key-%d", (int(txn)*7+i)%23)
+			value := fmt.Sprintf("txn-%d-%d", txn, i)
+			entry := &WALEntry{TxnID: txn, Operation: Operation{Type: OpUpdate, Key: key, Value: []byte(value)}, Timestamp: time.Now()}
+			if err := manager.WriteEntry(entry); err != nil {
+				t.Fatalf("Failed to write entry: %v", err)
+			}
+		}
+		open = append(open, txn)
+		// End the older of two open transactions
+		if len(open) == 2 || txn == txns {
+			end := open[0]
+			open = open[1:]
+			opType := OpCommit
+			if end%3 == 0 {
+				opType = OpAbort
+			}
+			if err := manager.WriteEntry(&WALEntry{TxnID: end, Operation: Operation{Type: opType}, Timestamp: time.Now()}); err != nil {
+				t.Fatalf("Failed to write entry: %v", err)
+			}
+			if opType == OpCommit {
+				for i := 0; i < 5; i++ {
+					expected[fmt.Sprintf("key-%d", (int(end)*7+i)%23)] = fmt.Sprintf("txn-%d-%d", end, i)
+				}
+			}
+		}
+	}
+	// A record the validator rejects is skipped, not taken for the first
+	// operation of transaction 0
+	if err := manager.WriteEntry(&WALEntry{TxnID: 0, Operation: Operation{Type: OpUpdate, Key: "stray", Value: []byte("x")}, Timestamp: time.Now()}); err != nil {
+		t.Fatalf("Failed to write entry: %v", err)
+	}
+	manager.Close()
+
+	recoveryConfig := DefaultRecoveryConfig()
+	recoveryConfig.ParallelRecovery = true
+	recoveryConfig.MaxParallelWorkers = 4
+	engine, err := NewRecoveryEngineWithConfig(tempDir, recoveryConfig)
+	if err != nil {
+		t.Fatalf("Failed to create recovery engine: %v", err)
+	}
+	if len(engine.reader.files) < 2 {
+		t.Fatalf("Expected several WAL segments, got %d", len(engine.reader.files))
+	}
+
+	var mu sync.Mutex
+	state := make(map[string]string)
+	lastLSN := make(map[string]uint64)
+	summary, err := engine.ReplayCommitted(func(entry *WALEntry) error {
+		mu.Lock()
+		defer mu.Unlock()
+		if entry.LSN < lastLSN[entry.Operation.Key] {
+			t.Errorf("Key %s replayed out of order", entry.Operation.Key)
+		}
+		lastLSN[entry.Operation.Key] = entry.LSN
+		state[entry.Operation.Key] = string(entry.Operation.Value)
+		return nil
+	})
+	if err != nil {
+		t.Fatalf("Failed to replay: %v", err)
+	}
+
+	if len(summary.IncompleteTransactions) != 1 || summary.IncompleteTransactions[0] != txns {
+		t.Errorf("Expected transaction %d to be incomplete, got %v", txns, summary.IncompleteTransactions)
+	}
+	if len(summary.CorruptedEntries) != 1 || summary.CorruptedEntries[0].LSN != summary.LastLSN {
+		t.Errorf("Expected the stray record to be flagged, got %v", summary.CorruptedEntries)
+	}
+	if summary.AbortedTransactions != 19 || summary.CommittedTransactions != 40 || summary.Operations != 200 {
+		t.Errorf("Unexpected summary %+v", summary)
+	}
+	for key, value := range expected {
+		if state[key] != value {
+			t.Errorf("Key %s recovered as %q, want %q", key, state[key], value)
+		}
+	}
+	if len(state) != len(expected) {
+		t.Errorf("Recovered %d keys, want %d", len(state), len(expected))
+	}
+
+	// Progress went out while replaying
+	var last RecoveryProgress
+	for len(engine.GetProgressChannel()) > 0 {
+		last = <-engine.GetProgressChannel()
+	}
+	if last.PercentComplete != 100 {
+		t.Errorf("Last progress update at %.1f%%, want 100%%", last.PercentComplete)
+	}
+
+	// The streaming reader sees the same log as ReadFromLSN always did
+	entries, err := engine.reader.ReadFromLSN(1)
+	if err != nil {
+		t.Fatalf("Failed to read entries: %v", err)
+	}
+	if len(entries) != txns*5+txns {
+		t.Errorf("Read %d entries, want %d", len(entries), txns*5+txns)
+	}
+	for i, entry := range entries {
+		if entry.LSN != uint64(i+1) {
+			t.Fatalf("Entry %d has LSN %d", i, entry.LSN)
+		}
+	}
+}
+
+func TestWALReader_ScanStopsOnError(t *testing.T) {
+	tempDir, err := os.MkdirTemp("", "wal_scan_stop_test")
+	if err != nil {
+		t.Fatalf("Failed to create temp dir: %v", err)
+	}
+	defer os.RemoveAll(tempDir)
+
+	defer func(size int) { walScanChunkSize = size }(walScanChunkSize)
+	walScanChunkSize = 1000
+
+	config := DefaultWALFileManagerConfig()
+	config.WALDir = tempDir
+	config.MaxFileSize = 16 * 1024
+	manager, err := NewWALFileManager(config)
+	if err != nil {
+		t.Fatalf("Failed to create WAL manager: %v", err)
+	}
+	for i := 0; i < 1000; i++ {
+		entry := &WALEntry{TxnID: 1, Operation: Operation{Type: OpInsert, Key: fmt.Sprintf("key-%d", i), Value: []byte("value")}, Timestamp: time.Now()}
+		if err := manager.WriteEntry(entry); err != nil {
+			t.Fatalf("Failed to write entry: %v", err)
+		}
+	}
+	manager.Close()
+
+	reader, err := NewWALReader(tempDir)
+	if err != nil {
+		t.Fatalf("Failed to create WAL reader: %v", err)
+	}
+	if len(reader.files) < 2 {
+		t.Fatalf("Expected several WAL segments, got %d", len(reader.files))
+	}
+
+	// A segment stops being read at the first chunk emit refuses
+	var emitted int
+	err = readSegmentChunks(reader.files[0], func(chunk *walChunk) bool {
+		emitted++
+		return false
+	})
+	if err != errScanStopped || emitted != 1 {
+		t.Errorf("Stopped segment read returned %v after %d chunks", err, emitted)
+	}
+
+	// An error from fn ends the scan with that error and no further calls
+	failure := errors.New("apply failed")
+	var calls int
+	err = reader.Scan(1, func(entry *WALEntry) error {
+		calls++
+		if entry.LSN == 10 {
+			return failure
+		}
+		return nil
+	})
+	if err != failure || calls != 10 {
+		t.Errorf("Scan returned %v after %d calls, want the callback's error after 10", err, calls)
+	}
+}
+
 func TestWALValidator_ValidateEntry(t *testing.T) {
 	validator := NewWALValidator(true) // Strict mode
 